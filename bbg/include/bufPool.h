@@ -0,0 +1,93 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 17, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bufPool.h
+ * @brief fixed pool of reference counted receive buffers
+ *
+ * The remote server receives each connection's bytes into a buffer from
+ * here and hands the log packets in it to the logging thread by pointer,
+ * each holding a reference, rather than copying them on through the log
+ * msg queue. A buffer goes back to the pool when the connection has moved
+ * on to another and the last packet in it has been written.
+ *
+ * Taking and dropping a reference is an atomic add; the free list has a
+ * mutex, taken once per buffer rather than per packet. Buffers are sized
+ * for a FrameReader_t.
+ *
+ ************************************************************************************
+ */
+
+#ifndef BUF_POOL_H_
+#define BUF_POOL_H_
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "remoteFrame.h"
+
+#define BUF_POOL_BUF_SIZE       (FRAME_READER_SIZE)
+
+typedef struct PoolBuf {
+    uint32_t data[BUF_POOL_BUF_SIZE / sizeof(uint32_t)];    /* 4 byte aligned for the frames in it */
+    uint32_t refs;
+    struct PoolBuf *pNext;              /* free list */
+    struct BufPool *pPool;
+} PoolBuf_t;
+
+typedef struct BufPool {
+    pthread_mutex_t lock;
+    PoolBuf_t *pFree;
+    uint32_t count;                     /* buffers, 0 until buf_pool_init() */
+    uint32_t inUse;
+    uint32_t maxInUse;
+    uint32_t allocFails;
+} BufPool_t;
+
+/**
+ * @brief put every buffer on the free list; not while any are in use
+ *
+ * @param pPool pool
+ * @param pBufs its buffers
+ * @param count number of them
+ * @return int8_t EXIT_SUCCESS or EXIT_FAILURE
+ */
+int8_t buf_pool_init(BufPool_t *pPool, PoolBuf_t *pBufs, uint32_t count);
+
+/**
+ * @brief a free buffer, with the caller's reference
+ *
+ * @param pPool pool
+ * @return PoolBuf_t* buffer, NULL if none are free
+ */
+PoolBuf_t *buf_pool_alloc(BufPool_t *pPool);
+
+/**
+ * @brief another reference to a buffer the caller holds one to
+ *
+ * @param pBuf buffer
+ */
+void buf_pool_ref(PoolBuf_t *pBuf);
+
+/**
+ * @brief drop a reference; the last one returns the buffer to its pool
+ *
+ * @param pBuf buffer
+ */
+void buf_pool_release(PoolBuf_t *pBuf);
+
+/**
+ * @brief whether anyone but the caller holds a reference
+ *
+ * @param pBuf buffer the caller holds a reference to
+ * @return uint8_t 1 if shared
+ */
+uint8_t buf_pool_shared(const PoolBuf_t *pBuf);
+
+#endif /* BUF_POOL_H_ */
@@ -0,0 +1,68 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 4, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file crc.h
+ * @brief CRC-32C (Castagnoli, reflected polynomial 0x82F63B78), shared by
+ * BBG and TIVA. Software version is table driven, slicing-by-8; on CPUs
+ * with a CRC-32C instruction (x86 SSE4.2, ARMv8 built with +crc) that is
+ * used instead, picked at runtime on x86.
+ *
+ * crc32c(p, n) == crc32c_finish(crc32c_update(CRC32C_INIT, p, n)); a
+ * record can be checksummed in pieces by calling crc32c_update for each.
+ *
+ ************************************************************************************
+ */
+
+#ifndef CRC_H
+#define	CRC_H
+
+#include <stdint.h>
+
+#define CRC32C_INIT                 (0xFFFFFFFFUL)
+#define crc32c_finish(crc)          ((uint32_t)((crc) ^ 0xFFFFFFFFUL))
+
+/**
+ * @brief continue a CRC-32C over more data, fastest available version
+ *
+ * @param crc running value, CRC32C_INIT to start
+ * @param pData data
+ * @param len bytes of data
+ * @return uint32_t running value, finish with crc32c_finish()
+ */
+uint32_t crc32c_update(uint32_t crc, const uint8_t *pData, uint32_t len);
+
+/**
+ * @brief CRC-32C of a buffer
+ *
+ * @param pData data
+ * @param len bytes of data
+ * @return uint32_t crc
+ */
+uint32_t crc32c(const uint8_t *pData, uint32_t len);
+
+/**
+ * @brief software slicing-by-8 crc32c_update, whatever the CPU supports
+ */
+uint32_t crc32c_update_sw(uint32_t crc, const uint8_t *pData, uint32_t len);
+
+/**
+ * @brief one table lookup per byte crc32c_update; reference for tests
+ * and benchmarks
+ */
+uint32_t crc32c_update_bytewise(uint32_t crc, const uint8_t *pData, uint32_t len);
+
+/**
+ * @brief name of the version crc32c_update uses
+ *
+ * @return const char* "sse4.2", "armv8" or "slice8"
+ */
+const char *crc32c_impl(void);
+
+#endif	/* CRC_H */
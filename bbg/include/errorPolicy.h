@@ -0,0 +1,71 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 9, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file errorPolicy.h
+ * @brief course of action for each thread's error codes, by table lookup
+ *
+ * Every (ProcessId_e, error code) pair has an entry giving the MainAction_e
+ * the health monitor takes and the course of action it prints. The defaults
+ * are built at compile time and match what the per thread arbitors decided;
+ * a config file read at startup can change any of them:
+ *
+ *   # thread       codes       action
+ *   PID_MOISTURE   136         RESTARTTHREAD
+ *   *              144-151     NOTIFY
+ *
+ * thread is a name as getPidString() prints it or * for all, codes a number,
+ * lo-hi range or * for all, and action one of NONE, NOTIFY, RESTARTTHREAD,
+ * TERMTHREAD or TERMALL. Later lines override earlier ones.
+ *
+ ************************************************************************************
+ */
+
+#ifndef ERRORPOLICY_H_
+#define ERRORPOLICY_H_
+
+#include <stdint.h>
+#include "packet.h"
+
+#define ERROR_POLICY_DEFAULT_FILE   "/usr/bin/errorPolicy.conf"
+#define ERROR_POLICY_CODES          (ERROR_CODE_END + 1)
+
+/**
+ * @brief put back the compiled in defaults
+ */
+void error_policy_reset(void);
+
+/**
+ * @brief apply a policy config file on top of the current table; lines that
+ * don't parse are reported and skipped
+ *
+ * @param pFile config file path
+ * @return int8_t EXIT_FAILURE if the file couldn't be read or any line was bad
+ */
+int8_t error_policy_load(const char *pFile);
+
+/**
+ * @brief action to take for an error
+ *
+ * @param Id thread that sent it
+ * @param errorCode ErrorCode_e
+ * @return MainAction_e action, MAIN_ACTION_NONE for an unknown thread
+ */
+MainAction_e error_policy_action(ProcessId_e Id, uint8_t errorCode);
+
+/**
+ * @brief printable course of action for an error
+ *
+ * @param Id thread that sent it
+ * @param errorCode ErrorCode_e
+ * @return const char* e.g. "NOTIFY", "NONE" for codes that aren't printed
+ */
+const char *error_policy_desc(ProcessId_e Id, uint8_t errorCode);
+
+#endif /* ERRORPOLICY_H_ */
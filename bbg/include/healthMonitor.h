@@ -24,7 +24,12 @@
 #ifdef __linux__
 #include <mqueue.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <syscall.h>
+#include "heartbeat.h"
+#include "histogram.h"
+#include "errorPolicy.h"
+#include "cmn_timer.h"
 #else
 #include "FreeRTOS.h"
 #include "queue.h"
@@ -38,7 +43,9 @@
 
 #ifdef __linux__
 /**
- * @brief check thread status / state and take appropriate course of action
+ * @brief check thread status / state and take appropriate course of action;
+ * heartbeats are read from the heartbeat table when there is one, and the
+ * queue only when a status msg was sent to it
  * 
  * @param pQueue pointer to status message queue
  * @param pExit indication to main that its time to terminate loop
@@ -52,8 +59,89 @@ int8_t monitorHealth(mqd_t * pQueue, uint8_t *pExit, uint8_t *newError);
  */
 void set_sig_handlers(void);
 
+#define THREAD_MISSING_COUNT        (3)
+
+/* heartbeat deadline of the event driven monitor, the same number of missed
+ * main loops the polling monitor tolerates */
+#define HEALTH_DEADLINE_USEC        ((uint32_t)((THREAD_MISSING_COUNT * MAIN_LOOP_TIME_NSEC) / 1e3))
+
+#define HEALTH_STATS_LOG_SEC        (60)
+
+typedef void (*healthMissedFunc_t)(ProcessId_e Id, void *pArg);
+
+/* event driven health monitor: one timerfd per monitored thread, armed for
+ * its last heartbeat plus the deadline, and the status msg queue, in one
+ * epoll set; a thread is reported the moment its deadline passes */
+typedef struct {
+    mqd_t queue;                    /* status msg queue, errors to act on */
+    uint8_t *pExit;                 /* cleared when all threads must exit */
+    uint32_t deadlineUsec;          /* thread is unresponsive this long after its last heartbeat */
+    healthMissedFunc_t missedFunc;  /* optional, called on each missed deadline */
+    void *pArg;                     /* passed to missedFunc */
+    int epollFd;
+    int stopFd;                     /* eventfd, written by healthMonitorStop() */
+    int statsFd;                    /* timerfd, log histograms every HEALTH_STATS_LOG_SEC */
+    int timerFds[PID_END];          /* -1 if thread isn't monitored */
+    uint32_t lastSeq[PID_END];      /* heartbeat seq when timer was last armed */
+} HealthMonitor_t;
+
+/**
+ * @brief set up the event driven monitor; needs the heartbeat table
+ * (heartbeat_init), every monitored thread's deadline starts now
+ *
+ * @param pMon monitor to initialize
+ * @param queue status msg queue, opened O_NONBLOCK
+ * @param pExit indication to main that its time to terminate loop
+ * @param deadlineUsec heartbeat deadline, HEALTH_DEADLINE_USEC normally
+ * @return int8_t EXIT_SUCCESS / EXIT_FAILURE
+ */
+int8_t healthMonitorInit(HealthMonitor_t *pMon, mqd_t queue, uint8_t *pExit, uint32_t deadlineUsec);
+
+/**
+ * @brief run the event driven monitor until healthMonitorStop(), then
+ * close its descriptors
+ *
+ * @param pArg pointer to HealthMonitor_t from healthMonitorInit()
+ * @return void* NULL
+ */
+void *healthMonitorThreadHandler(void *pArg);
+
+/**
+ * @brief tell the monitor thread to exit
+ *
+ * @param pMon running monitor
+ */
+void healthMonitorStop(HealthMonitor_t *pMon);
+
+/**
+ * @brief copies of a thread's histograms, usec: time between its heartbeats
+ * (scheduling jitter) and from sending a status msg to the monitor reading
+ * it (queue backlog). With the heartbeat table only queued errors have a
+ * delivery delay; without it every heartbeat does.
+ *
+ * @param Id thread
+ * @param pInterval set to heartbeat interval histogram
+ * @param pDelivery set to status msg delivery delay histogram
+ */
+void healthMonitorStats(ProcessId_e Id, Histogram_t *pInterval, Histogram_t *pDelivery);
+
+/**
+ * @brief print every thread's histograms since start to the console
+ */
+void healthMonitorPrintStats(void);
+
+/**
+ * @brief log every thread's histograms since the last call; the monitor
+ * calls this every HEALTH_STATS_LOG_SEC
+ */
+void healthMonitorLogStats(void);
 
+
+/* heartbeats go to the shared memory table; errors (or everything, if
+ * there is no table) are also queued for the monitor to act on */
 #define SEND_STATUS_MSG(queue, Id, taskStat, errCode)({\
+    if((heartbeat_publish((Id), (taskStat), (errCode)) != EXIT_SUCCESS) ||\
+       ((taskStat) == STATUS_ERROR)) {\
 	TaskStatusPacket status;\
 	status.timestamp = log_get_time();\
 	status.header = ((pid_t)syscall(SYS_gettid));\
@@ -63,6 +151,9 @@ void set_sig_handlers(void);
     status.taskState = STATE_RUNNING;\
     if(mq_send(queue, (char *)&status, sizeof(TaskStatusPacket), 7) < 0)\
 	{ ERRNO_PRINT("SEND_STATUS_MSG fail"); }\
+    else\
+	{ heartbeat_event_sent(); }\
+    }\
 })
 #else
 #define SEND_STATUS_MSG(queue, Id, taskStat, errCode)({\
@@ -128,29 +219,14 @@ __attribute__((always_inline)) inline const char *getPidString(ProcessId_e procI
 __attribute__((always_inline)) inline void PRINT_STATUS_MSG_HEADER(TaskStatusPacket *pStatus)
 {
 #ifdef __linux__
-    if((pStatus->errorCode >= ERROR_CODE_USER_NOTIFY0) && (pStatus->errorCode <= ERROR_CODE_USER_NOTIFY7))
-        printf("recvd error(%d) w/ CoA = NOTIFY from %s at %d usec\n\r", pStatus->errorCode,
-        getPidString(pStatus->processId), pStatus->timestamp);
-    else if((pStatus->errorCode >= ERROR_CODE_USER_TERMTHREAD0) && (pStatus->errorCode <= ERROR_CODE_USER_TERMTHREAD7))
-        printf("recvd error(%d) w/ CoA = TERMTHREAD from %s at %d usec\n\r", pStatus->errorCode,
-        getPidString(pStatus->processId), pStatus->timestamp);
-    else if((pStatus->errorCode >= ERROR_CODE_USER_TERMALL0) && (pStatus->errorCode <= ERROR_CODE_USER_TERMALL7))
-        printf("recvd error(%d) w/ CoA = TERMALL from %s at %d usec\n\r", pStatus->errorCode,
-        getPidString(pStatus->processId), pStatus->timestamp);
-    else if((pStatus->errorCode >= ERROR_CODE_USER_RESTARTTHREAD0) && (pStatus->errorCode <= ERROR_CODE_USER_RESTARTTHREAD7))
-        printf("recvd error(%d) w/ CoA = RESTARTTHREAD from %s at %d usec\n\r", pStatus->errorCode,
-        getPidString(pStatus->processId), pStatus->timestamp);
-    else if((pStatus->errorCode >= ERROR_CODE_USER_NONE0) && (pStatus->errorCode <= ERROR_CODE_USER_NONE7))
-    #ifdef PRINT_NONE_ALSO
-        printf("recvd error(%d) w/ CoA = NONE from %s at %d usec\n\r", pStatus->errorCode,
-        getPidString(pStatus->processId), pStatus->timestamp);
-    #else
-        ;
+    /* course of action comes from the error policy table */
+    #ifndef PRINT_NONE_ALSO
+    if(error_policy_action(pStatus->processId, pStatus->errorCode) == MAIN_ACTION_NONE)
+        return;
     #endif
-    else if (pStatus->errorCode == ERROR_CODE_TIMEOUT)
-        printf("recvd TIMEOUT error(%d) from %s at %d usec\n\r", pStatus->errorCode, getPidString(pStatus->processId), pStatus->timestamp);
-    else
-        printf("recvd error(%d) w/ CoA = OTHER from %s at %d usec\n\r", pStatus->errorCode, getPidString(pStatus->processId), pStatus->timestamp);
+    printf("recvd error(%d) w/ CoA = %s from %s at %d usec\n\r", pStatus->errorCode,
+    error_policy_desc(pStatus->processId, pStatus->errorCode),
+    getPidString(pStatus->processId), pStatus->timestamp);
 #else
     if((pStatus->errorCode >= ERROR_CODE_USER_NOTIFY0) && (pStatus->errorCode <= ERROR_CODE_USER_NOTIFY7))
         UARTprintf("recvd error(%d) w/ CoA = NOTIFY from %s at %d usec\n\r", pStatus->errorCode,
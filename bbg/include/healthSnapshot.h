@@ -0,0 +1,139 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 10, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file healthSnapshot.h
+ * @brief read only view of system health over a local UNIX socket
+ *
+ * Main publishes a HealthSnapshot_t (control loop and system state, sensor
+ * values, queue depths) once a loop into whichever of two buffers readers
+ * weren't last told to use, then switches them over. Each buffer has a
+ * seq that is odd while it is written; a reader copies the current buffer
+ * and retries if its seq moved, so main never waits on a reader.
+ *
+ * The server thread answers each request byte on a connection with the
+ * latest snapshot, heartbeat ages filled in from the heartbeat table at
+ * that moment: HEALTH_SNAPSHOT_REQ_BINARY gets the HealthSnapshot_t as is,
+ * HEALTH_SNAPSHOT_REQ_JSON a newline terminated JSON object. Anything
+ * else sent is ignored. Clients that don't read their replies are dropped.
+ *
+ ************************************************************************************
+ */
+
+#ifndef HEALTHSNAPSHOT_H_
+#define HEALTHSNAPSHOT_H_
+
+#include <stdint.h>
+#include "packet.h"
+
+#define HEALTH_SNAPSHOT_SOCKET      "/tmp/bbg_health.sock"
+#define HEALTH_SNAPSHOT_MAGIC       (0x31534842UL)      /* "BHS1" */
+#define HEALTH_SNAPSHOT_REQ_BINARY  ('b')
+#define HEALTH_SNAPSHOT_REQ_JSON    ('j')
+#define HEALTH_SNAPSHOT_JSON_SIZE   (2048)
+#define HEALTH_SNAPSHOT_NO_BEAT     (UINT32_MAX)        /* heartbeat age of a thread yet to beat */
+#define HEALTH_SNAPSHOT_MAX_CLIENTS (128)
+
+typedef enum {
+    SNAPSHOT_QUEUE_LOG = 0,
+    SNAPSHOT_QUEUE_HEARTBEAT,
+    SNAPSHOT_QUEUE_DATA,
+    SNAPSHOT_QUEUE_CMD,
+    SNAPSHOT_QUEUE_END
+} SnapshotQueue_e;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;                               /* publish count */
+    uint32_t timestamp;                         /* heartbeat_now() at publish */
+    uint32_t ageUsec;                           /* since publish, set when served */
+    uint8_t controlLoopState;                   /* ControlLoopState_e */
+    uint8_t systemState;                        /* SystemState_e */
+    uint8_t reserved[2];
+    float luxData;
+    float moistureData;
+    int32_t queueDepth[SNAPSHOT_QUEUE_END];     /* mq_curmsgs, -1 if unknown */
+    uint32_t heartbeatAgeUsec[PID_END];         /* set when served */
+    uint8_t taskStatus[PID_END];                /* TaskStatus_e of last heartbeat */
+} HealthSnapshot_t;
+
+typedef struct {
+    const char *pPath;                          /* socket path */
+    int epollFd;
+    int listenFd;
+    int stopFd;                                 /* eventfd, written by health_snapshot_server_stop() */
+    int clientFds[HEALTH_SNAPSHOT_MAX_CLIENTS]; /* -1 if slot free */
+    uint32_t clients;                           /* connections open */
+    uint32_t served;                            /* replies sent */
+} HealthSnapshotServer_t;
+
+/**
+ * @brief make pSnap the snapshot readers get; one publisher only
+ *
+ * @param pSnap snapshot, magic, seq and timestamp are filled in
+ */
+void health_snapshot_publish(HealthSnapshot_t *pSnap);
+
+/**
+ * @brief consistent copy of the latest snapshot
+ *
+ * @param pSnap set to snapshot
+ * @return uint32_t times the copy was retried, a publish overtook it
+ */
+uint32_t health_snapshot_read(HealthSnapshot_t *pSnap);
+
+/**
+ * @brief latest snapshot with heartbeat ages and snapshot age as of now
+ *
+ * @param pSnap set to snapshot
+ */
+void health_snapshot_current(HealthSnapshot_t *pSnap);
+
+/**
+ * @brief format a snapshot as one line of JSON
+ *
+ * @param pSnap snapshot
+ * @param pBuf output, HEALTH_SNAPSHOT_JSON_SIZE is always enough
+ * @param size size of pBuf
+ * @return int characters written, as snprintf
+ */
+int health_snapshot_json(const HealthSnapshot_t *pSnap, char *pBuf, uint32_t size);
+
+/**
+ * @brief name of a ControlLoopState_e / SystemState_e
+ */
+const char *health_snapshot_loop_string(uint8_t state);
+const char *health_snapshot_system_string(uint8_t state);
+
+/**
+ * @brief create the listening socket, replacing one left by an earlier run
+ *
+ * @param pSrv server to initialize
+ * @param pPath socket path, HEALTH_SNAPSHOT_SOCKET normally
+ * @return int8_t EXIT_SUCCESS / EXIT_FAILURE
+ */
+int8_t health_snapshot_server_init(HealthSnapshotServer_t *pSrv, const char *pPath);
+
+/**
+ * @brief serve snapshots until health_snapshot_server_stop(), then close
+ * all connections and remove the socket
+ *
+ * @param pArg pointer to HealthSnapshotServer_t from health_snapshot_server_init()
+ * @return void* NULL
+ */
+void *healthSnapshotThreadHandler(void *pArg);
+
+/**
+ * @brief tell the server thread to exit
+ *
+ * @param pSrv running server
+ */
+void health_snapshot_server_stop(HealthSnapshotServer_t *pSrv);
+
+#endif /* HEALTHSNAPSHOT_H_ */
@@ -0,0 +1,136 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 6, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file heartbeat.h
+ * @brief shared memory table of thread heartbeats, one slot per ProcessId_e
+ *
+ * Threads publish their latest status into their slot with plain atomic
+ * stores (no syscall), and the health monitor scans the table once per loop.
+ * Each slot has its own cache line so threads beating at the same time don't
+ * contend. A slot's seq is odd while it is being written and goes up by 2
+ * per publish, so a change in seq since the last scan means the thread is
+ * alive and a reader retries rather than see a half written slot.
+ *
+ * Publishing also records the time since the slot's previous publish in the
+ * slot's interval histogram, so scheduling jitter of each thread's loop is
+ * there for the health monitor (or anything else mapping the table) to read.
+ *
+ * Errors needing an action still go through the status msg queue; the table
+ * counts them (events) so the monitor only reads the queue when one was sent.
+ * Until heartbeat_init() is called (unit tests) publishing fails and
+ * SEND_STATUS_MSG sends every status through the queue as before.
+ *
+ ************************************************************************************
+ */
+
+#ifndef HEARTBEAT_H_
+#define HEARTBEAT_H_
+
+#include <stdint.h>
+#include "packet.h"
+#include "histogram.h"
+
+#define HEARTBEAT_SHM_NAME      "/heartbeat_shm"
+#define HEARTBEAT_MAGIC         (0x32544248UL)      /* "HBT2" */
+#define HEARTBEAT_CACHE_LINE    (64)
+
+typedef struct {
+    uint32_t seq;               /* odd while being written */
+    uint32_t timestamp;         /* heartbeat_now() of last publish */
+    uint32_t tid;               /* publishing thread */
+    uint8_t taskStatus;         /* TaskStatus_e */
+    uint8_t taskState;          /* TaskState_e */
+    uint8_t errorCode;
+} __attribute__((aligned(HEARTBEAT_CACHE_LINE))) HeartbeatSlot_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t numSlots;
+    uint32_t events;            /* status msgs sent to the queue */
+    HeartbeatSlot_t slots[PID_END];
+    Histogram_t intervals[PID_END]; /* usec between publishes, written by publisher */
+} HeartbeatTable_t;
+
+/**
+ * @brief create and map the heartbeat table; replaces any left by an
+ * earlier run
+ *
+ * @param pName shared memory object name
+ * @return int8_t EXIT_SUCCESS / EXIT_FAILURE
+ */
+int8_t heartbeat_init(const char *pName);
+
+/**
+ * @brief unmap and remove the heartbeat table
+ *
+ * @param pName shared memory object name
+ */
+void heartbeat_destroy(const char *pName);
+
+/**
+ * @brief nonzero if heartbeat_init() has mapped the table
+ */
+uint8_t heartbeat_active(void);
+
+/**
+ * @brief publish a thread's status to its slot
+ *
+ * @param Id slot to write
+ * @param taskStatus TaskStatus_e of thread
+ * @param errorCode ErrorCode_e of thread
+ * @return int8_t EXIT_FAILURE if there is no table or Id is out of range
+ */
+int8_t heartbeat_publish(ProcessId_e Id, TaskStatus_e taskStatus, uint8_t errorCode);
+
+/**
+ * @brief consistent copy of a slot
+ *
+ * @param Id slot to read
+ * @param pSlot set to slot contents
+ * @return int8_t EXIT_FAILURE if there is no table or Id is out of range
+ */
+int8_t heartbeat_read(ProcessId_e Id, HeartbeatSlot_t *pSlot);
+
+/**
+ * @brief copy of a slot's interval histogram
+ *
+ * @param Id slot to read
+ * @param pHist set to histogram
+ * @return int8_t EXIT_FAILURE if there is no table or Id is out of range
+ */
+int8_t heartbeat_intervals(ProcessId_e Id, Histogram_t *pHist);
+
+/**
+ * @brief slots not published to within deadlineUsec, or never
+ *
+ * @param mask slots to check, bit (1 << ProcessId_e) each
+ * @param deadlineUsec longest time since a publish that is still fresh
+ * @return uint32_t bits of mask that are stale, all of mask if there is no table
+ */
+uint32_t heartbeat_stale(uint32_t mask, uint32_t deadlineUsec);
+
+/**
+ * @brief CLOCK_MONOTONIC in usec, the clock of slot timestamps; wraps, so
+ * only differences are meaningful
+ */
+uint32_t heartbeat_now(void);
+
+/**
+ * @brief count a status msg sent on the queue; call after it is sent
+ */
+void heartbeat_event_sent(void);
+
+/**
+ * @brief status msgs sent on the queue so far, compare with a previous
+ * count to see if the queue needs reading
+ */
+uint32_t heartbeat_events(void);
+
+#endif /* HEARTBEAT_H_ */
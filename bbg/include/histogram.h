@@ -0,0 +1,96 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 7, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file histogram.h
+ * @brief fixed size log-linear (HDR style) histogram of uint32 values
+ *
+ * Values below 2 * HIST_SUB_COUNT get a bucket each; above that every power
+ * of two is split into HIST_SUB_COUNT buckets, so any value is recorded to
+ * within 1 / HIST_SUB_COUNT (6%) of itself, from 0 up to 2^32 - 1 with no
+ * configuration. Recording is a handful of instructions and no allocation,
+ * so it can be done from a thread's loop or in shared memory. Each
+ * histogram expects a single writer; readers take a copy with
+ * hist_copy(), which may be a record or two behind but never garbage.
+ *
+ ************************************************************************************
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stdint.h>
+
+#define HIST_SUB_BITS           (4)
+#define HIST_SUB_COUNT          (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS            ((2 * HIST_SUB_COUNT) + ((32 - HIST_SUB_BITS - 1) * HIST_SUB_COUNT))
+#define HIST_FORMAT_SIZE        (96)    /* hist_format() output, with null */
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;                   /* exact, 0 if count is 0 */
+    uint32_t max;                   /* exact */
+    uint64_t sum;
+    uint32_t buckets[HIST_BUCKETS];
+} Histogram_t;
+
+/**
+ * @brief empty a histogram
+ */
+void hist_reset(Histogram_t *pHist);
+
+/**
+ * @brief add a value; one writer per histogram
+ */
+void hist_record(Histogram_t *pHist, uint32_t value);
+
+/**
+ * @brief copy a histogram that may be being written
+ */
+void hist_copy(Histogram_t *pDst, const Histogram_t *pSrc);
+
+/**
+ * @brief what was recorded in pNow since pPrev was copied from it; min/max
+ * of the result come from its buckets
+ *
+ * @param pDst set to pNow - pPrev
+ * @param pNow later copy
+ * @param pPrev earlier copy of the same histogram
+ */
+void hist_subtract(Histogram_t *pDst, const Histogram_t *pNow, const Histogram_t *pPrev);
+
+/**
+ * @brief merge one histogram into another, e.g. per thread ones
+ *
+ * @param pDst histogram added to
+ * @param pSrc histogram to add, not being written
+ */
+void hist_add(Histogram_t *pDst, const Histogram_t *pSrc);
+
+/**
+ * @brief value at or below which pct percent of values were recorded, to
+ * within the bucket width (reports the bucket's highest value)
+ *
+ * @param pHist histogram
+ * @param pct 0 to 100
+ * @return uint32_t value, 0 if empty
+ */
+uint32_t hist_percentile(const Histogram_t *pHist, double pct);
+
+/**
+ * @brief one line summary: "n=.. min=.. p50=.. p90=.. p99=.. max=.."
+ *
+ * @param pHist histogram
+ * @param pBuf output, at least HIST_FORMAT_SIZE bytes
+ * @param size size of pBuf
+ * @return int characters written, as snprintf
+ */
+int hist_format(const Histogram_t *pHist, char *pBuf, uint32_t size);
+
+#endif /* HISTOGRAM_H_ */
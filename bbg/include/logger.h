@@ -21,12 +21,17 @@
 #include <stddef.h>
 #include "logger_types.h"
 #include "logger_helper.h"
+#include "logger_files.h"
 #include "logger_queue.h"
+#include "logger_ring.h"
 #include "conversion.h"
 #include "packet.h"
 
 #ifdef __linux__
     #include <stdio.h>
+    #include "logger_sink.h"
+    #include "logger_segment.h"
+    #include "logger_filter.h"
 #else
     #include "FreeRTOS.h"
     #include "task.h"
@@ -37,7 +42,12 @@
 #define SHORT_CIRCUIT_FOR_DEBUG (1)
 #define DEBUG_TEST_ALL_MSG_TYPES (0)
 
-#define LOG_MSG_QUEUE
+/* backend selected at build time (make LOG_BACKEND=RING); per-thread
+ * rings are only available on linux, TIVA always uses the FreeRTOS queue */
+#if !defined(LOG_RING_BUFFER) || !defined(__linux__)
+    #undef LOG_RING_BUFFER
+    #define LOG_MSG_QUEUE
+#endif
 #define LOG
 
 #ifndef LOG
@@ -45,7 +55,7 @@
     #define LOG_INIT(threadArgs)			(LOG_STATUS_OK)
     #define LOG_ITEM(pLogItem)              (LOG_STATUS_OK)
     #define LOG_DEQUEUE_ITEM(pLogItem)		(LOG_STATUS_OK)
-    #define LOG_WRITE_ITEM(pLogItem, fd)	(LOG_STATUS_OK)
+    #define LOG_WRITE_ITEM(pLogItem, pSink)	(LOG_STATUS_OK)
     #define LOG_LOGGER_INITIALIZED()		/* implemented */
     #define LOG_SYSTEM_INITIALIZED()		/* implemented */
     #define LOG_SYSTEM_HALTED()				/* implemented */
@@ -69,144 +79,192 @@
     #define LOG_OBSERVER_EVENT(event_e)
     #define LOG_MOISTURE_EVENT(event_e)
 #else /* LOGging enabled */
+#ifdef LOG_RING_BUFFER
+    #define LOG_ITEM(pLogItem)              (log_ring_item(pLogItem))
+    #define LOG_DEQUEUE_ITEM(pLogItem)      (log_ring_dequeue_item(pLogItem))
+    #define LOG_INIT(pArg)                  (init_ring_logger(pArg))
+    #define LOG_FLUSH()                     (log_ring_flush())
+#else
     #define LOG_ITEM(pLogItem)              (log_queue_item(pLogItem))
     #define LOG_DEQUEUE_ITEM(pLogItem)      (log_dequeue_item(pLogItem))
     #define LOG_INIT(pArg)                  (init_queue_logger(pArg))
     #define LOG_FLUSH()                     (log_queue_flush())
-    #define LOG_WRITE_ITEM(pLogItem, fd)    (log_write_item(pLogItem, fd))
+#endif
+    #define LOG_WRITE_ITEM(pLogItem, pSink) (log_sink_write_item(pSink, pLogItem))
 
+    /* logFileId comes from the file's LOG_REGISTER_FILE(); a msg filtered
+     * out at runtime returns before anything is built. Producers only
+     * capture raw arguments, string lengths, event text and checksums are
+     * left to the logging thread (log_pack_item, log_render_item) */
     #ifdef __linux__
         #include <sys/syscall.h>
         #define LOG_GET_SRC_ID()				((pid_t)syscall(SYS_gettid))
     #else  // not LINUX
             #define LOG_GET_SRC_ID()            (getTaskNum())
+            #define LOG_FILTER_PASS(msgId)      (1)     /* filtered on the BBG when received */
     #endif
 
     #define LOG_LOGGER_INITIALIZED()({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_LOGGER_INITIALIZED;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.pPayload = NULL;\
-        logItem.payloadLength = 0;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_LOGGER_INITIALIZED)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_LOGGER_INITIALIZED;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_TEXT;\
+            logItem.pPayload = NULL;\
+            logItem.payloadLength = 0;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_GPIO_INITIALIZED()({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_GPIO_INITIALIZED;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.pPayload = NULL;\
-        logItem.payloadLength = 0;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_GPIO_INITIALIZED)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_GPIO_INITIALIZED;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_TEXT;\
+            logItem.pPayload = NULL;\
+            logItem.payloadLength = 0;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_SYSTEM_INITIALIZED()({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_SYSTEM_INITIALIZED;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.pPayload = NULL;\
-        logItem.payloadLength = 0;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_SYSTEM_INITIALIZED)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_SYSTEM_INITIALIZED;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_TEXT;\
+            logItem.pPayload = NULL;\
+            logItem.payloadLength = 0;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_SYSTEM_HALTED()({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_SYSTEM_HALTED;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.pPayload = NULL;\
-        logItem.payloadLength = 0;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_SYSTEM_HALTED)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_SYSTEM_HALTED;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_TEXT;\
+            logItem.pPayload = NULL;\
+            logItem.payloadLength = 0;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_INFO(pStr)({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_INFO;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.payloadLength = log_strlen((uint8_t *)pStr);\
-        logItem.pPayload = (uint8_t *)pStr;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_INFO)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_INFO;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_STRING;\
+            logItem.payloadLength = 0;\
+            logItem.pPayload = (uint8_t *)pStr;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_WARNING(pStr)({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_WARNING;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.payloadLength = log_strlen((uint8_t *)pStr);\
-        logItem.pPayload = (uint8_t *)pStr;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_WARNING)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_WARNING;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_STRING;\
+            logItem.payloadLength = 0;\
+            logItem.pPayload = (uint8_t *)pStr;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_ERROR(pStr)({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_ERROR;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.payloadLength = log_strlen((uint8_t *)pStr);\
-        logItem.pPayload = (uint8_t *)pStr;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_ERROR)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_ERROR;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_STRING;\
+            logItem.payloadLength = 0;\
+            logItem.pPayload = (uint8_t *)pStr;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_HEARTBEAT()({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        logItem.logMsgId = LOG_MSG_HEARTBEAT;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.pPayload = NULL;\
-        logItem.payloadLength = 0;\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(LOG_MSG_HEARTBEAT)) {\
+            logItem_t logItem;\
+            logItem.logMsgId = LOG_MSG_HEARTBEAT;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_TEXT;\
+            logItem.pPayload = NULL;\
+            logItem.payloadLength = 0;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_THREAD_EVENT(event_e, eventId)({\
-        logItem_t logItem;\
-        uint8_t fileStr[sizeof(__FILE__)] = __FILE__;\
-        uint8_t numStr[32];\
-        logItem.logMsgId = eventId;\
-        logItem.pFilename = &fileStr[0];\
-        logItem.lineNum = __LINE__;\
-        logItem.time = log_get_time();\
-        logItem.payloadLength = my_itoa((uint8_t)event_e, &numStr[0], HEX_BASE);\
-        logItem.pPayload = &numStr[0];\
-        logItem.sourceId = LOG_GET_SRC_ID();\
-        log_set_checksum(&logItem);\
-        LOG_ITEM(&logItem);\
+        uint8_t logStatus = LOG_STATUS_OK;\
+        if(LOG_FILTER_PASS(eventId)) {\
+            logItem_t logItem;\
+            uint32_t eventArg = (uint8_t)event_e;\
+            logItem.logMsgId = eventId;\
+            logItem.fileId = logFileId;\
+            logItem.pFilename = NULL;\
+            logItem.lineNum = __LINE__;\
+            logItem.time = log_get_time();\
+            logItem.payloadFormat = LOG_PAYLOAD_EVENT;\
+            logItem.payloadLength = sizeof(eventArg);\
+            logItem.pPayload = (uint8_t *)&eventArg;\
+            logItem.sourceId = LOG_GET_SRC_ID();\
+            logStatus = LOG_ITEM(&logItem);\
+        }\
+        logStatus;\
     })
 
     #define LOG_TEMP_SENSOR_EVENT(event_e)		    (LOG_THREAD_EVENT(event_e, LOG_MSG_TEMP_SENSOR_EVENT))
@@ -0,0 +1,85 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 1, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_files.h
+ * @brief source file IDs carried by log msgs in place of __FILE__ strings;
+ * shared by BBG and TIVA so IDs in remote log packets resolve the same on
+ * both nodes. Append new files to the end of the table (IDs are on the wire
+ * and in log packets), then register the file once with LOG_REGISTER_FILE()
+ * after its includes.
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_FILES_H
+#define	LOGGER_FILES_H
+
+#include <stdint.h>
+
+/* ID, name written to log file, ProcessId_e of the thread that owns the
+ * file for log filtering (PID_END: main and shared code, not a thread) */
+#define LOG_FILE_TABLE(X) \
+    X(LOG_FILE_UNKNOWN,                     "unknown",                            PID_END) \
+    X(LOG_FILE_BBG_MAIN,                    "bbg/src/main.c",                     PID_END) \
+    X(LOG_FILE_BBG_HEALTH_MONITOR,          "bbg/src/healthMonitor.c",            PID_END) \
+    X(LOG_FILE_BBG_LIGHT_THREAD,            "bbg/src/lightThread.c",              PID_LIGHT) \
+    X(LOG_FILE_BBG_LOGGING_THREAD,          "bbg/src/loggingThread.c",            PID_LOGGING) \
+    X(LOG_FILE_BBG_REMOTE_CMD_THREAD,       "bbg/src/remoteCmdThread.c",          PID_REMOTE_CMD) \
+    X(LOG_FILE_BBG_REMOTE_DATA_THREAD,      "bbg/src/remoteDataThread.c",         PID_REMOTE_DATA) \
+    X(LOG_FILE_BBG_REMOTE_LOG_THREAD,       "bbg/src/remoteLogThread.c",          PID_REMOTE_LOG) \
+    X(LOG_FILE_BBG_REMOTE_STATUS_THREAD,    "bbg/src/remoteStatusThread.c",       PID_REMOTE_STATUS) \
+    X(LOG_FILE_BBG_REMOTE_THREAD,           "bbg/src/remoteThread.c",             PID_END) \
+    X(LOG_FILE_BBG_TEMP_THREAD,             "bbg/src/tempThread.c",               PID_TEMP) \
+    X(LOG_FILE_BBG_TEST_LOGGER,             "bbg/unittest/test_logger.c",         PID_END) \
+    X(LOG_FILE_BBG_BENCH_LOGGER,            "bbg/unittest/bench_logger.c",        PID_END) \
+    X(LOG_FILE_BBG_TEST_LOG_SINK,           "bbg/unittest/test_logSink.c",        PID_END) \
+    X(LOG_FILE_TIVA_MAIN,                   "tiva/src/main.c",                    PID_END) \
+    X(LOG_FILE_TIVA_LIGHT_THREAD,           "tiva/src/lightThread.c",             PID_LIGHT) \
+    X(LOG_FILE_TIVA_MOISTURE_THREAD,        "tiva/src/moistureThread.c",          PID_MOISTURE) \
+    X(LOG_FILE_TIVA_OBSERVER_THREAD,        "tiva/src/observerThread.c",          PID_OBSERVER) \
+    X(LOG_FILE_TIVA_REMOTE_THREAD,          "tiva/src/remoteThread.c",            PID_REMOTE_CLIENT) \
+    X(LOG_FILE_TIVA_SOLENOID_THREAD,        "tiva/src/solenoidThread.c",          PID_SOLENOID) \
+    X(LOG_FILE_BBG_TEST_LOG_SEGMENT,        "bbg/unittest/test_logSegment.c",     PID_END) \
+    X(LOG_FILE_BBG_TEST_CRC,                "bbg/unittest/test_crc.c",            PID_END) \
+    X(LOG_FILE_BBG_SUPERVISOR,              "bbg/src/supervisor.c",               PID_END) \
+    X(LOG_FILE_BBG_REMOTE_SERVER,           "bbg/src/remoteServer.c",             PID_END)
+
+#define LOG_FILE_ENUM_ENTRY(id, name, pid)  id,
+typedef enum {
+    LOG_FILE_TABLE(LOG_FILE_ENUM_ENTRY)
+    LOG_FILE_END
+} LogFileId_e;
+#undef LOG_FILE_ENUM_ENTRY
+
+/**
+ * @brief give this translation unit's log msgs a file ID; LOG_* macros
+ * won't compile in a file that hasn't registered
+ */
+#define LOG_REGISTER_FILE(id) \
+    static const uint16_t logFileId __attribute__((unused)) = (id)
+
+/**
+ * @brief name of a source file ID
+ *
+ * @param fileId LogFileId_e value
+ * @return const char* file name, "unknown" for an out of range ID
+ */
+const char *log_file_name(uint16_t fileId);
+
+/**
+ * @brief running (unfinished) CRC-32C of a file ID's name, the start of a
+ * log msg checksum; computed once per file then cached
+ *
+ * @param fileId LogFileId_e value
+ * @return uint32_t crc32c_update() value after the name's characters
+ */
+uint32_t log_file_name_crc(uint16_t fileId);
+
+#endif	/* LOGGER_FILES_H */
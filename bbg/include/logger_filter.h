@@ -0,0 +1,98 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 3, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_filter.h
+ * @brief runtime log filtering by msg type, owning process and severity
+ *
+ * The three settings are folded into one msg bitmask per source file
+ * (bit n set = logMsg_e n is logged from that file). LOG_* macros test
+ * their file's mask with LOG_FILTER_PASS before building an item; file
+ * and msg IDs are compile time constants, so a filtered call costs one
+ * load and a branch. Masks are rebuilt whenever a setting changes.
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_FILTER_H
+#define	LOGGER_FILTER_H
+
+#include <stdint.h>
+#include "logger_types.h"
+#include "logger_files.h"
+#include "packet.h"
+
+#define LOG_FILTER_ALL_MSGS     (0xFFFFFFFFUL)
+
+/* per file masks, read by every LOG_* call */
+extern uint32_t logFilterMask[LOG_FILE_END];
+
+/**
+ * @brief nonzero if msgId from this translation unit (its logFileId)
+ * should be logged
+ */
+#define LOG_FILTER_PASS(msgId) \
+    (__atomic_load_n(&logFilterMask[logFileId], __ATOMIC_RELAXED) & (1UL << (msgId)))
+
+/**
+ * @brief runtime version of LOG_FILTER_PASS, for items from other nodes
+ *
+ * @param fileId LogFileId_e of the item
+ * @param msgId msg type of the item
+ * @return uint8_t 1 if the item should be logged
+ */
+uint8_t log_filter_pass(uint16_t fileId, logMsg_e msgId);
+
+/**
+ * @brief severity of a msg type; ERROR and WARNING msgs are their own
+ * level, everything else is LOGLVL_INFO
+ *
+ * @param msgId msg type
+ * @return LogLevel_e severity
+ */
+LogLevel_e log_filter_msg_level(logMsg_e msgId);
+
+/**
+ * @brief log only msgs at or above a severity
+ *
+ * @param level minimum LogLevel_e
+ * @return uint8_t success of operation
+ */
+uint8_t log_filter_set_level(LogLevel_e level);
+
+/**
+ * @brief enable or disable one msg type from every file
+ *
+ * @param msgId msg type
+ * @param enable 0 to filter out
+ * @return uint8_t success of operation
+ */
+uint8_t log_filter_set_msg(logMsg_e msgId, uint8_t enable);
+
+/**
+ * @brief enable or disable all msgs from files owned by a process;
+ * PID_END selects main and the shared files
+ *
+ * @param procId process
+ * @param enable 0 to filter out
+ * @return uint8_t success of operation
+ */
+uint8_t log_filter_set_process(ProcessId_e procId, uint8_t enable);
+
+/**
+ * @brief log everything again
+ */
+void log_filter_reset(void);
+
+/**
+ * @brief print current filter settings
+ */
+void log_filter_print(void);
+
+#endif	/* LOGGER_FILTER_H */
@@ -0,0 +1,103 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 30, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_format.h
+ * @brief on-disk log file formats
+ *
+ * LOG_FORMAT_LEGACY:
+ *  '<' msgId filename lineNum time payloadLength payload sourceId checksum '>'
+ *  integers are NUL terminated hex ascii, filename is NUL terminated
+ *
+ * Record checksums in both formats are log_calc_checksum() (CRC-32C, see
+ * logger_helper.h); compact version 1 sessions, and legacy files written
+ * before that, carry a byte sum instead.
+ *
+ * LOG_FORMAT_COMPACT (all fields little-endian):
+ *  file header, written once per logging session:
+ *      [0..3]  magic "BLOG"
+ *      [4..5]  format version
+ *      [6..7]  file header size
+ *      [8..9]  record header size
+ *      [10..15] reserved
+ *  followed by entries, each starting with a tag byte:
+ *  string table entry (filename interned to an ID), emitted before first use:
+ *      [0] 'S'  [1] reserved  [2..3] string ID  [4..5] length  [6..] chars (no NUL)
+ *  record, fixed size header followed by payloadLength payload bytes:
+ *      [0] 'R'  [1] msgId  [2..3] file ID  [4..5] lineNum  [6..7] sourceId
+ *      [8..11] time  [12..15] checksum  [16..17] payloadLength  [18..19] reserved
+ *
+ * Compressed log files (either format above) are a series of blocks, each
+ * holding a run of whole records; the blocks' decompressed contents
+ * concatenated are the legacy or compact stream:
+ *      [0..3]  magic "BLZB"
+ *      [4..7]  rawLen, decompressed size (at most LOG_BLOCK_MAX_RAW)
+ *      [8..11] compLen, compressed bytes that follow (logger_lz.h format);
+ *              0 if the rawLen bytes that follow are stored as is
+ *      [12..15] reserved
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_FORMAT_H
+#define	LOGGER_FORMAT_H
+
+#include <stdint.h>
+
+typedef enum {
+    LOG_FORMAT_LEGACY = 0,
+    LOG_FORMAT_COMPACT,
+    LOG_FORMAT_END
+} LogFormat_e;
+
+#define LOG_COMPACT_MAGIC           "BLOG"
+#define LOG_COMPACT_MAGIC_SIZE      (4)
+#define LOG_COMPACT_VERSION         (2)     /* 2: CRC-32C record checksums */
+#define LOG_COMPACT_VERSION_CRC     (2)
+#define LOG_COMPACT_FILE_HDR_SIZE   (16)
+#define LOG_COMPACT_REC_HDR_SIZE    (20)
+#define LOG_COMPACT_STR_HDR_SIZE    (6)
+
+#define LOG_COMPACT_TAG_HEADER      ('B')   /* first byte of magic */
+#define LOG_COMPACT_TAG_STRING      ('S')
+#define LOG_COMPACT_TAG_RECORD      ('R')
+
+#define LOG_BLOCK_MAGIC             "BLZB"
+#define LOG_BLOCK_MAGIC_SIZE        (4)
+#define LOG_BLOCK_HDR_SIZE          (16)
+#define LOG_BLOCK_MAX_RAW           (0xFFFF)    /* LZ offsets are 16 bit */
+
+/*---------------------------------------------------------------------------------*/
+/* little-endian field helpers, byte at a time so alignment doesn't matter */
+static inline void log_put_le16(uint8_t *pBuf, uint16_t value)
+{
+    pBuf[0] = (uint8_t)value;
+    pBuf[1] = (uint8_t)(value >> 8);
+}
+
+static inline void log_put_le32(uint8_t *pBuf, uint32_t value)
+{
+    pBuf[0] = (uint8_t)value;
+    pBuf[1] = (uint8_t)(value >> 8);
+    pBuf[2] = (uint8_t)(value >> 16);
+    pBuf[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint16_t log_get_le16(const uint8_t *pBuf)
+{
+    return (uint16_t)(pBuf[0] | (pBuf[1] << 8));
+}
+
+static inline uint32_t log_get_le32(const uint8_t *pBuf)
+{
+    return (uint32_t)pBuf[0] | ((uint32_t)pBuf[1] << 8) |
+           ((uint32_t)pBuf[2] << 16) | ((uint32_t)pBuf[3] << 24);
+}
+
+#endif	/* LOGGER_FORMAT_H */
@@ -20,6 +20,8 @@
 #define	LOGGER_HELPER_H
 
 #include <stdint.h>
+#include "logger_types.h"
+#include "logger_files.h"
 
 /**
  * @brief return microseconds since first call
@@ -27,7 +29,87 @@
  * @return uint32_t 
  */
 uint32_t log_get_time(void);
-void log_set_checksum(logItem_t *pLogItem);
 uint32_t log_strlen(uint8_t *pStr);
 
+/* msgId, lineNum, sourceId, time and payloadLength as checksummed */
+#define LOG_CHECKSUM_FIELDS_SIZE    (11)
+
+/**
+ * @brief checksum of an item as written to the log: CRC-32C (crc.h) over
+ * its file name (no NUL), then msgId (1 byte), lineNum (2), sourceId (2),
+ * time (4) and payloadLength (2) little-endian, then the payload
+ *
+ * @param pLogItem item
+ * @return uint32_t checksum
+ */
+uint32_t log_calc_checksum(logItem_t *pLogItem);
+
+/**
+ * @brief checksum legacy files written before CRC-32C carry: the sum of
+ * msgId, lineNum, time, payloadLength and sourceId, then of each file name
+ * and payload byte
+ *
+ * @param pLogItem item, its pFilename set
+ * @return uint32_t checksum
+ */
+uint32_t log_calc_byte_sum(logItem_t *pLogItem);
+
+/**
+ * @brief set an item's checksum field, see log_calc_checksum
+ *
+ * @param pLogItem item
+ */
+void log_set_checksum(logItem_t *pLogItem);
+
+/**
+ * @brief name to write for an item, its pFilename if set otherwise
+ * the name of its fileId
+ *
+ * @param pLogItem item
+ * @return uint8_t* null terminated file name
+ */
+uint8_t *log_item_filename(logItem_t *pLogItem);
+
+/**
+ * @brief turn a dequeued item's raw payload into the text written to the
+ * log (LOG_PAYLOAD_EVENT becomes its hex string) and set its checksum;
+ * called by the logging thread so producers never format
+ *
+ * @param pLogItem item, an EVENT payload buffer must hold MAX_INT_STRING_SIZE
+ * @return uint8_t success of operation
+ */
+uint8_t log_render_item(logItem_t *pLogItem);
+
+#ifdef __linux__
+/* sources whose last item is kept; more than this and they share slots */
+#define LOG_LAST_SLOTS				(32)
+
+typedef struct {
+	uint16_t sourceId;		/* low 16 bits of the producer's tid */
+	uint16_t fileId;
+	uint16_t lineNum;
+	uint8_t logMsgId;
+	uint32_t time;			/* log_get_time() of the item */
+} logLastItem_t;
+
+/**
+ * @brief remember an item as its source's latest, so a stall report can
+ * say where each thread last logged from; called as items are queued
+ *
+ * @param pLogItem item being queued
+ */
+void log_note_item(const logItem_t *pLogItem);
+
+/**
+ * @brief copy out the latest item of each source seen; safe to call while
+ * producers are logging, a slot mid-update for too long is skipped
+ *
+ * @param pItems output
+ * @param max size of pItems
+ * @return uint8_t items copied
+ */
+uint8_t log_last_items(logLastItem_t *pItems, uint8_t max);
+#endif
+
+
 #endif	/* LOGGER_HELPER_H */
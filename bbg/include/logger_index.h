@@ -0,0 +1,186 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 5, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_index.h
+ * @brief sidecar index of a log file, so queries by time, msg type, process
+ * or source can seek straight to the records that may match
+ *
+ * The index is <logfile>.idx, built by the log sink as it writes. The log
+ * is cut into chunks of about LOG_INDEX_CHUNK_RECORDS consecutive records
+ * and each chunk gets one entry summarizing what is in it: its file offset
+ * range, min/max time and bitmasks of the msg types, owning processes and
+ * (hashed) source IDs of its records. A query reads only the chunks whose
+ * summary can match; parts of the log with no entry (written without an
+ * index, or after the last entry) are scanned. Times restart each session
+ * and wrap, so no ordering is assumed between entries.
+ *
+ * In a compact file the sink restarts the string table at each chunk, so
+ * every chunk can be read without what came before it.
+ *
+ * File layout (little-endian):
+ *  header: [0..3] magic "BIDX"  [4..5] version  [6..7] header size
+ *          [8..9] entry size  [10..15] reserved
+ *  entry:  [0..7] start offset  [8..15] end offset  [16..19] records
+ *          [20..23] min time  [24..27] max time  [28..31] msg mask
+ *          [32..35] process mask  [36..43] source mask
+ *          [44..47] CRC-32C of bytes 0..43
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_INDEX_H
+#define	LOGGER_INDEX_H
+
+#include <stdint.h>
+#include "logger_types.h"
+#include "logger_reader.h"
+#include "packet.h"
+
+#define LOG_INDEX_MAGIC             "BIDX"
+#define LOG_INDEX_MAGIC_SIZE        (4)
+#define LOG_INDEX_VERSION           (1)
+#define LOG_INDEX_HDR_SIZE          (16)
+#define LOG_INDEX_ENTRY_SIZE        (48)
+#define LOG_INDEX_CHUNK_RECORDS     (256)   /* chunk closes at first flush past this */
+#define LOG_INDEX_SUFFIX            ".idx"
+#define LOG_INDEX_PATH_SIZE         (80)    /* <logfile>.idx */
+
+#define LOG_INDEX_ALL               (0xFFFFFFFFUL)
+#define LOG_INDEX_SOURCE_BIT(id)    (1ULL << ((id) % 64))
+
+/* one chunk of the log */
+typedef struct {
+    uint64_t start;                 /* file offset of chunk, previous chunk's end */
+    uint64_t end;                   /* file offset just past the chunk */
+    uint32_t records;
+    uint32_t minTime;
+    uint32_t maxTime;
+    uint32_t msgMask;               /* bit per logMsg_e */
+    uint32_t pidMask;               /* bit per ProcessId_e owning the record's file */
+    uint64_t sourceMask;            /* LOG_INDEX_SOURCE_BIT of each sourceId */
+} LogIndexEntry_t;
+
+/* writer side, owned by the logging thread */
+typedef struct {
+    int fd;
+    char path[LOG_INDEX_PATH_SIZE];
+    uint64_t flushedEnd;            /* log offset written through */
+    uint32_t entries;               /* entries written this session */
+    LogIndexEntry_t chunk;          /* open chunk, records == 0 if none */
+} LogIndex_t;
+
+/* what to look for; records must match every field */
+typedef struct {
+    uint32_t minTime;
+    uint32_t maxTime;
+    uint32_t msgMask;               /* LOG_INDEX_ALL for any */
+    uint32_t pidMask;               /* LOG_INDEX_ALL for any */
+    uint8_t anySource;              /* 0 to match sourceId only */
+    uint16_t sourceId;
+} LogIndexQuery_t;
+
+typedef struct {
+    uint32_t matched;               /* records passed to the callback */
+    uint32_t scanned;               /* records read */
+    uint32_t chunksRead;            /* index chunks read */
+    uint32_t chunksSkipped;         /* index chunks ruled out by their entry */
+    uint64_t bytesUnindexed;        /* bytes scanned with no index entry */
+} LogIndexStats_t;
+
+typedef void (*logQueryFunc_t)(logItem_t *pLogItem, void *pArg);
+
+/**
+ * @brief open (creating if needed) a log file's index for appending;
+ * entries that don't fit the log as it is now (stale or cut short by a
+ * crash) are dropped
+ *
+ * @param pIndex index to initialize
+ * @param pLogPath log file the index is for
+ * @param logEnd current size of the log file; the first chunk starts here
+ * @return uint8_t success of operation
+ */
+uint8_t log_index_open(LogIndex_t *pIndex, const char *pLogPath, uint64_t logEnd);
+
+/**
+ * @brief add a record to the open chunk, starting one if needed; call
+ * before the record is serialized. A chunk starts where the last one
+ * ended, so chunks cover everything written (session headers included).
+ *
+ * @param pIndex open index
+ * @param pLogItem record
+ * @return uint8_t 1 if the record starts a new chunk
+ */
+uint8_t log_index_add(LogIndex_t *pIndex, logItem_t *pLogItem);
+
+/**
+ * @brief the log has been written up to logEnd; closes the open chunk once
+ * it holds LOG_INDEX_CHUNK_RECORDS, so no entry points past written data
+ *
+ * @param pIndex open index
+ * @param logEnd log offset written through
+ * @return uint8_t success of operation
+ */
+uint8_t log_index_flushed(LogIndex_t *pIndex, uint64_t logEnd);
+
+/**
+ * @brief write the open chunk's entry (call after the final log flush) and
+ * close the index
+ *
+ * @param pIndex open index
+ */
+void log_index_close(LogIndex_t *pIndex);
+
+/**
+ * @brief read a log file's index; entries failing their CRC are left out
+ * (their records are scanned instead)
+ *
+ * @param pLogPath log file
+ * @param ppEntries set to a malloc'd array, caller frees; NULL if none
+ * @param pNum set to entries in array
+ * @return uint8_t LOG_STATUS_OK, LOG_STATUS_NOTOK if there is no usable index
+ */
+uint8_t log_index_load(const char *pLogPath, LogIndexEntry_t **ppEntries, uint32_t *pNum);
+
+/**
+ * @brief match all records, then narrow with the query's fields
+ *
+ * @param pQuery query to initialize
+ */
+void log_index_query_init(LogIndexQuery_t *pQuery);
+
+/**
+ * @brief nonzero if a record matches a query
+ */
+uint8_t log_index_match_item(const LogIndexQuery_t *pQuery, logItem_t *pLogItem);
+
+/**
+ * @brief nonzero if a chunk may hold records matching a query
+ */
+uint8_t log_index_match_entry(const LogIndexQuery_t *pQuery, const LogIndexEntry_t *pEntry);
+
+/**
+ * @brief call func for each record matching a query, in file order, reading
+ * only chunks whose entry may match and whatever the index doesn't cover;
+ * with no entries this is a full scan
+ *
+ * @param pReader reader opened on the log file
+ * @param pEntries index entries, from log_index_load()
+ * @param numEntries entries in pEntries, 0 to scan the whole file
+ * @param pQuery what to match
+ * @param func called with each matching record
+ * @param pArg passed to func
+ * @param pStats filled with query statistics, may be NULL
+ * @return uint8_t success of operation
+ */
+uint8_t log_index_query(LogReader_t *pReader, const LogIndexEntry_t *pEntries, uint32_t numEntries,
+                        const LogIndexQuery_t *pQuery, logQueryFunc_t func, void *pArg,
+                        LogIndexStats_t *pStats);
+
+#endif	/* LOGGER_INDEX_H */
@@ -0,0 +1,59 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 3, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_lz.h
+ * @brief small LZ77 codec for compressed log blocks, no external libraries
+ *
+ * Compressed data is a series of sequences:
+ *      token       high nibble literal count, low nibble match length - 4;
+ *                  a nibble of 15 is followed by extra length bytes, each
+ *                  added to it, ending at the first byte below 255
+ *      literals    copied as is
+ *      offset      2 bytes little-endian, distance back to the match (1..65535)
+ * The data may end after any sequence's literals (the last one has no
+ * match). Matches may overlap the bytes they produce.
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_LZ_H
+#define	LOGGER_LZ_H
+
+#include <stdint.h>
+
+#define LOG_LZ_MAX_INPUT            (0xFFFF)    /* offsets are 16 bit */
+#define LOG_LZ_MIN_MATCH            (4)
+
+/* worst case compressed size of n bytes (all literals) */
+#define LOG_LZ_BOUND(n)             ((n) + ((n) / 255) + 16)
+
+/**
+ * @brief compress a buffer
+ *
+ * @param pSrc data to compress
+ * @param srcLen bytes of data, at most LOG_LZ_MAX_INPUT
+ * @param pDst destination
+ * @param dstMax size of destination, LOG_LZ_BOUND(srcLen) always fits
+ * @return uint32_t compressed size, 0 on error or if it doesn't fit
+ */
+uint32_t log_lz_compress(const uint8_t *pSrc, uint32_t srcLen, uint8_t *pDst, uint32_t dstMax);
+
+/**
+ * @brief decompress a buffer
+ *
+ * @param pSrc compressed data
+ * @param srcLen bytes of compressed data
+ * @param pDst destination
+ * @param dstMax size of destination
+ * @return uint32_t decompressed size, 0 if the data is corrupt or doesn't fit
+ */
+uint32_t log_lz_decompress(const uint8_t *pSrc, uint32_t srcLen, uint8_t *pDst, uint32_t dstMax);
+
+#endif	/* LOGGER_LZ_H */
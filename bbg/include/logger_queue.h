@@ -20,6 +20,7 @@
 #define	LOGGER_QUEUE_H
 
 #include "logger_types.h"
+#include "packet.h"
 
 #ifndef __linux__
 #include "task.h"
@@ -58,6 +59,37 @@ uint8_t log_queue_item(logItem_t *pLogItem);
  */
 uint8_t log_dequeue_item(logItem_t *pLogItem);
 
+/**
+ * @brief copy log item (and the data it points to) into queue packet;
+ * a LOG_PAYLOAD_STRING payload is measured as it's copied (truncated to
+ * fit) and packed as LOG_PAYLOAD_TEXT. Checksum is left 0.
+ * 
+ * @param pLogItem item to copy
+ * @param pPacket packet to fill
+ * @return uint8_t success of operation
+ */
+uint8_t log_pack_item(logItem_t *pLogItem, LogMsgPacket *pPacket);
+
+/**
+ * @brief copy queue packet into log item; item's filename and
+ * payload pointers must reference caller provided storage
+ * 
+ * @param pPacket packet to copy
+ * @param pLogItem item to fill
+ * @return uint8_t success of operation
+ */
+uint8_t log_unpack_item(LogMsgPacket *pPacket, logItem_t *pLogItem);
+
+/**
+ * @brief log_calc_checksum of a packet's item as it stands (an EVENT
+ * payload is still its raw value); the sending node sets the packet's
+ * checksum with this and the receiver checks it
+ *
+ * @param pPacket packet, payloadLength at most LOG_MSG_PAYLOAD_SIZE
+ * @return uint32_t checksum
+ */
+uint32_t log_packet_checksum(LogMsgPacket *pPacket);
+
 /**
  * @brief write item to file
  * 
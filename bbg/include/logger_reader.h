@@ -0,0 +1,126 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 30, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_reader.h
+ * @brief read records back out of a log file, legacy or compact format
+ * (format is detected from the start of the file); a log segment file
+ * (logger_segment.h) is read up to its commit point, a compressed file
+ * is decompressed a block at a time
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_READER_H
+#define	LOGGER_READER_H
+
+#include <stdint.h>
+#include "logger_types.h"
+#include "logger_format.h"
+#include "logger_lz.h"
+#include "packet.h"
+
+#define LOG_READER_BUF_SIZE         (64 * 1024)     /* file read chunk */
+#define LOG_READER_MAX_STRINGS      (256)           /* string table entries */
+#define LOG_READER_MAX_NAME         (64)            /* filename incl. NUL */
+#define LOG_READER_MAX_PAYLOAD      (0xFFFF)        /* compact length field max */
+
+typedef struct {
+    int fd;
+    LogFormat_e format;
+    uint64_t bufOffset;             /* file offset of buf[0] */
+    uint32_t pos;                   /* next unread byte in buf */
+    uint32_t len;                   /* valid bytes in buf */
+    uint32_t records;               /* records returned */
+    uint32_t badRecords;            /* corrupt entries skipped */
+    uint32_t badChecksums;          /* of those, records failing their checksum */
+    uint8_t verify;                 /* check record checksums; clear to read
+                                     * legacy files from before CRC checksums */
+    uint8_t sessionCrc;             /* current compact session has CRC checksums;
+                                     * set when seeking past a header known to */
+    uint64_t dataEnd;               /* segment commit point, 0 if not a segment */
+    uint32_t segmentSeq;            /* segment sequence number */
+    uint8_t segmentClosed;          /* writer has moved on from this segment */
+    uint8_t blocks;                 /* compressed file, buf holds decompressed data */
+    uint64_t blockFileOffset;       /* file offset of next block header */
+    uint32_t blockPos;              /* next unread byte in block */
+    uint32_t blockLen;              /* decompressed bytes in block */
+    uint32_t badBlocks;             /* corrupt blocks skipped */
+    uint8_t filename[LOG_READER_MAX_NAME];
+    uint8_t payload[LOG_READER_MAX_PAYLOAD];
+    uint8_t strings[LOG_READER_MAX_STRINGS][LOG_READER_MAX_NAME];
+    uint8_t buf[LOG_READER_BUF_SIZE];
+    uint8_t block[LOG_BLOCK_MAX_RAW];
+    uint8_t zblock[LOG_LZ_BOUND(LOG_BLOCK_MAX_RAW)];
+} LogReader_t;
+
+/**
+ * @brief open log file and detect its format
+ *
+ * @param pReader reader to initialize (large, don't put on a small stack)
+ * @param pPath log file path
+ * @return uint8_t success of operation
+ */
+uint8_t log_reader_open(LogReader_t *pReader, const char *pPath);
+
+/**
+ * @brief read next record; the item's filename and payload point into
+ * the reader and are only valid until the next call
+ *
+ * @param pReader open reader
+ * @param pLogItem item to fill
+ * @return uint8_t LOG_STATUS_OK, LOG_STATUS_EOF at end of file, or
+ *  LOG_STATUS_NOTOK if a corrupt entry (or one failing its checksum) was
+ *  skipped (keep reading)
+ */
+uint8_t log_reader_next(LogReader_t *pReader, logItem_t *pLogItem);
+
+/**
+ * @brief file offset of the next entry log_reader_next() will read; for
+ * a compressed file, the offset into its decompressed contents
+ *
+ * @param pReader open reader
+ * @return uint64_t file offset
+ */
+uint64_t log_reader_tell(LogReader_t *pReader);
+
+/**
+ * @brief move to a file offset previously returned by log_reader_tell();
+ * in a compressed file seeking backwards decompresses again from the start
+ *
+ * @param pReader open reader
+ * @param offset file offset of an entry
+ * @return uint8_t success of operation
+ */
+uint8_t log_reader_seek(LogReader_t *pReader, uint64_t offset);
+
+/**
+ * @brief re-read a segment's commit point so records written since it
+ * was opened (or last refreshed) can be read; no-op for other files
+ *
+ * @param pReader open reader
+ * @return uint8_t success of operation
+ */
+uint8_t log_reader_refresh(LogReader_t *pReader);
+
+/**
+ * @brief print a record on one line, same layout as scripts/log_parser.py
+ *
+ * @param pLogItem record from log_reader_next()
+ */
+void log_reader_print_item(logItem_t *pLogItem);
+
+/**
+ * @brief close the log file
+ *
+ * @param pReader open reader
+ */
+void log_reader_close(LogReader_t *pReader);
+
+#endif	/* LOGGER_READER_H */
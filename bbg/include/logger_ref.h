@@ -0,0 +1,73 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 17, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_ref.h
+ * @brief remote nodes' log packets to the logging thread by reference
+ *
+ * The remote server used to rebuild each received LogMsgPacket as a
+ * logItem_t and LOG_ITEM() it, which packed it into another LogMsgPacket
+ * for mq_send(); the logging thread mq_receive()d it and unpacked the
+ * payload into its own buffer: four copies and two syscalls a record.
+ * Instead the server queues a pointer to the packet where it was received,
+ * holding a reference to its bufPool buffer, on a single-producer/single-
+ * consumer ring like logger_ring's; the logging thread writes it from
+ * there and drops the reference.
+ *
+ * The ring only takes packets while the logging thread has it open. When
+ * it's closed or full the server falls back to LOG_ITEM(), so nothing is
+ * lost that the msg queue would have kept.
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_REF_H
+#define	LOGGER_REF_H
+
+#include <stdint.h>
+#include "logger_types.h"
+#include "packet.h"
+#include "bufPool.h"
+
+#define LOG_REF_DEPTH               (512)   /* packets, must be power of 2; a 25 ms logging loop at 20k rec/s */
+
+/**
+ * @brief start taking packets; the logging thread, as it starts
+ *
+ * @return uint8_t LOG_STATUS_OK
+ */
+uint8_t log_ref_open(void);
+
+/**
+ * @brief stop taking packets and drop the one last dequeued; the logging
+ * thread, as it exits. Packets left on the ring wait for the next open.
+ */
+void log_ref_close(void);
+
+/**
+ * @brief queue a received packet by reference; the remote server only
+ *
+ * @param pPacket packet, checksum and payloadLength already checked
+ * @param pBuf buffer it's in; a reference is taken if queued
+ * @return uint8_t LOG_STATUS_OK, LOG_STATUS_BUF_FULL, or LOG_STATUS_NOTOK
+ * if the logging thread doesn't have the ring open or it's a string payload
+ */
+uint8_t log_ref_item(LogMsgPacket *pPacket, PoolBuf_t *pBuf);
+
+/**
+ * @brief oldest queued packet as an item whose payload points into its
+ * receive buffer; valid until the next call, which drops its reference.
+ * The logging thread only.
+ *
+ * @param pLogItem item to fill; pPayload is overwritten
+ * @return uint8_t LOG_STATUS_OK, or LOG_STATUS_TIMEOUT if none queued
+ */
+uint8_t log_ref_dequeue_item(logItem_t *pLogItem);
+
+#endif	/* LOGGER_REF_H */
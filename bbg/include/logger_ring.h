@@ -0,0 +1,79 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 28, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_ring.h
+ * @brief lock-free per-thread ring buffer logger backend (alternative to
+ * the posix msg queue backend in logger_queue.c)
+ *
+ * Each producer thread claims its own single-producer/single-consumer ring
+ * the first time it logs; the logging thread is the only consumer and merges
+ * the rings by timestamp. Producers never block and only make a syscall when
+ * their ring is full (a few sched_yield()s); if it stays full the item is
+ * dropped and counted. A thread's ring is released as it exits, and handed
+ * to the next thread to claim one once the logging thread has drained it,
+ * so restarted threads don't use up the rings.
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_RING_H
+#define	LOGGER_RING_H
+
+#include <stdint.h>
+#include "logger_types.h"
+
+#define LOG_RING_MAX_PRODUCERS      (16)    /* rings, one per live logging thread */
+#define LOG_RING_DEPTH              (128)   /* items per ring, must be power of 2 */
+#define LOG_RING_CACHE_LINE         (64)    /* bytes */
+#define LOG_RING_FULL_RETRIES       (4)     /* yields before dropping */
+
+/**
+ * @brief initialize the ring logger; rings are static so the
+ * argument (LogThreadInfo) is only accepted for symmetry with
+ * init_queue_logger
+ *
+ * @param pArg thread info, unused
+ * @return uint8_t success of operation
+ */
+uint8_t init_ring_logger(void *pArg);
+
+/**
+ * @brief add item to calling thread's ring, claims a ring on first call
+ *
+ * @param pLogItem item to add
+ * @return uint8_t LOG_STATUS_OK, LOG_STATUS_BUF_FULL if item dropped, or
+ * LOG_STATUS_NOTOK if every ring is in use
+ */
+uint8_t log_ring_item(logItem_t *pLogItem);
+
+/**
+ * @brief remove oldest (by timestamp) item across all rings; only
+ * the logging thread may call this
+ *
+ * @param pLogItem pointer to container to store removed item
+ * @return uint8_t LOG_STATUS_OK, or LOG_STATUS_TIMEOUT if all rings empty
+ */
+uint8_t log_ring_dequeue_item(logItem_t *pLogItem);
+
+/**
+ * @brief flush the rings (no-op, kept for LOG_FLUSH symmetry)
+ *
+ * @return uint8_t success of operation
+ */
+uint8_t log_ring_flush(void);
+
+/**
+ * @brief get count of items dropped because a ring was full
+ *
+ * @return uint32_t total dropped items
+ */
+uint32_t log_ring_get_drops(void);
+
+#endif	/* LOGGER_RING_H */
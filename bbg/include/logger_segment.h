@@ -0,0 +1,149 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 2, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_segment.h
+ * @brief log storage in fixed size, memory mapped segment files
+ *
+ * Segments are named <logfile>.<seq>, seq counting up from 1 across runs.
+ * Records are serialized directly into the mapping (legacy or compact
+ * format, a compact segment starts with its own file header) and the
+ * header's used offset is advanced once a record is complete, so readers
+ * and crash recovery never see a partial record. When a record won't fit,
+ * the segment is closed and the next one created; only the newest
+ * segmentsKept segments are retained. Mapped pages are msync'd every
+ * LOG_SEGMENT_SYNC_USEC and after every LOG_MSG_ERROR record.
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_SEGMENT_H
+#define	LOGGER_SEGMENT_H
+
+#include <stdint.h>
+#include "logger_types.h"
+#include "logger_format.h"
+#include "logger_sink.h"
+
+#define LOG_SEGMENT_MAGIC           "BSEG"
+#define LOG_SEGMENT_MAGIC_SIZE      (4)
+#define LOG_SEGMENT_VERSION         (1)
+#define LOG_SEGMENT_HDR_SIZE        (64)            /* data starts here */
+#define LOG_SEGMENT_MIN_SIZE        (64 * 1024)     /* bytes */
+#define LOG_SEGMENT_MAX_SIZE        (256 * 1024 * 1024) /* bytes; one mapping, well inside a 32-bit address space */
+#define LOG_SEGMENT_DEFAULT_SIZE    (1024 * 1024)   /* bytes */
+#define LOG_SEGMENT_DEFAULT_KEEP    (8)             /* segments retained */
+#define LOG_SEGMENT_MAX_KEEP        (UINT8_MAX)     /* segmentsKept is a uint8_t */
+#define LOG_SEGMENT_SYNC_USEC       (1000000)       /* max age of unsynced records */
+#define LOG_SEGMENT_PATH_SIZE       (80)            /* <logfile>.<seq> */
+#define LOG_SEGMENT_SEQ_DIGITS      (6)             /* at least, zero padded */
+
+/* first LOG_SEGMENT_HDR_SIZE bytes of a segment file, host byte order */
+typedef struct {
+    uint8_t magic[LOG_SEGMENT_MAGIC_SIZE];
+    uint16_t version;
+    uint16_t hdrSize;
+    uint32_t seq;                   /* segment sequence number */
+    uint32_t size;                  /* segment file size */
+    uint32_t used;                  /* file offset just past last complete record */
+    uint8_t format;                 /* LogFormat_e of the data */
+    uint8_t closed;                 /* set once no more records will be added */
+    uint8_t reserved[LOG_SEGMENT_HDR_SIZE - 22];
+} LogSegmentHdr_t;
+
+typedef struct {
+    char basePath[64];              /* log file name segments are named after */
+    char path[LOG_SEGMENT_PATH_SIZE];   /* current segment */
+    LogFormat_e format;
+    int fd;
+    uint8_t *pMap;                  /* current segment mapping */
+    uint32_t size;                  /* bytes per segment */
+    uint32_t used;                  /* write offset in current segment */
+    uint32_t syncedLen;             /* used offset at last msync */
+    uint32_t lastSyncTime;          /* log_get_time() of last msync */
+    uint32_t seq;                   /* current segment */
+    uint32_t oldestSeq;             /* oldest segment not yet deleted */
+    uint8_t segmentsKept;
+    uint32_t records;               /* records written */
+    uint32_t syncs;                 /* msync calls */
+    uint32_t rotations;             /* segments filled */
+    LogStrings_t strings;           /* compact format only */
+} LogSegment_t;
+
+/**
+ * @brief create the first segment for this run, after any segments left
+ * by previous runs, and apply retention
+ *
+ * @param pSegment segment writer to initialize
+ * @param pBasePath log file name, segments are <pBasePath>.<seq>
+ * @param size bytes per segment, LOG_SEGMENT_MIN_SIZE to
+ *  LOG_SEGMENT_MAX_SIZE (rounded down to a multiple of the min)
+ * @param segmentsKept number of newest segments to retain, 1 to
+ *  LOG_SEGMENT_MAX_KEEP
+ * @param format on-disk format of records
+ * @return uint8_t success of operation
+ */
+uint8_t log_segment_open(LogSegment_t *pSegment, const char *pBasePath, uint32_t size,
+                         uint8_t segmentsKept, LogFormat_e format);
+
+/**
+ * @brief serialize item into the current segment, rotating first if it
+ * won't fit; ERROR msgs are msync'd before returning
+ *
+ * @param pSegment open segment writer
+ * @param pLogItem item to write
+ * @return uint8_t success of operation
+ */
+uint8_t log_segment_write_item(LogSegment_t *pSegment, logItem_t *pLogItem);
+
+/**
+ * @brief msync if records older than LOG_SEGMENT_SYNC_USEC are unsynced;
+ * call periodically from the logging thread's loop
+ *
+ * @param pSegment open segment writer
+ * @return uint8_t success of operation
+ */
+uint8_t log_segment_poll(LogSegment_t *pSegment);
+
+/**
+ * @brief msync all records written to the current segment
+ *
+ * @param pSegment open segment writer
+ * @return uint8_t success of operation
+ */
+uint8_t log_segment_sync(LogSegment_t *pSegment);
+
+/**
+ * @brief sync, mark closed and unmap the current segment
+ *
+ * @param pSegment open segment writer
+ */
+void log_segment_close(LogSegment_t *pSegment);
+
+/**
+ * @brief name of a segment file
+ *
+ * @param pPath destination, LOG_SEGMENT_PATH_SIZE bytes
+ * @param pBasePath log file name
+ * @param seq segment sequence number
+ * @return uint8_t LOG_STATUS_NOTOK if the name doesn't fit
+ */
+uint8_t log_segment_path(char *pPath, const char *pBasePath, uint32_t seq);
+
+/**
+ * @brief find the oldest and newest segments of a log file on disk
+ *
+ * @param pBasePath log file name
+ * @param pOldest oldest sequence number found
+ * @param pNewest newest sequence number found
+ * @return uint8_t LOG_STATUS_OK if any were found
+ */
+uint8_t log_segment_find(const char *pBasePath, uint32_t *pOldest, uint32_t *pNewest);
+
+#endif	/* LOGGER_SEGMENT_H */
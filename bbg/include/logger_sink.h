@@ -0,0 +1,151 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 29, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_sink.h
+ * @brief buffered log file writer; records are serialized (legacy or compact
+ * format, see logger_format.h) into a staging buffer and written to the log
+ * file with one write() per batch; optionally each batch is written as a
+ * compressed block, or the file is indexed as it is written (logger_index.h)
+ *
+ ************************************************************************************
+ */
+
+#ifndef LOGGER_SINK_H
+#define	LOGGER_SINK_H
+
+#include <stdint.h>
+#include "logger_types.h"
+#include "logger_format.h"
+#include "logger_lz.h"
+#include "logger_index.h"
+#include "packet.h"
+
+#define LOG_SINK_BUF_SIZE           (4096)      /* staging buffer, bytes */
+#define LOG_SINK_FLUSH_USEC         (100000)    /* max age of buffered data */
+
+/* compressed blocks are batched longer; bigger blocks find more repeats */
+#define LOG_SINK_BLOCK_SIZE         (16 * 1024)
+#define LOG_SINK_BLOCK_FLUSH_USEC   (1000000)
+#define LOG_SINK_MAX_STRINGS        (64)        /* interned filenames (compact format) */
+
+/* worst case serialized record: frame bytes, six hex integers,
+ * filename and payload */
+#define LOG_SINK_MAX_RECORD_SIZE    (2 + (6 * MAX_INT_STRING_SIZE) + LOG_MSG_FILENAME_SIZE + LOG_MSG_PAYLOAD_SIZE)
+
+/* compact format string table, filenames interned to IDs */
+typedef struct {
+    uint16_t num;                   /* entries in use, index is ID */
+    uint8_t names[LOG_SINK_MAX_STRINGS][LOG_MSG_FILENAME_SIZE];
+} LogStrings_t;
+
+typedef struct {
+    int fd;                         /* log file */
+    LogFormat_e format;             /* on-disk format */
+    uint8_t compress;               /* write batches as compressed blocks */
+    uint32_t len;                   /* bytes staged in buf */
+    uint32_t bufLimit;              /* flush size, LOG_SINK_BUF_SIZE or LOG_SINK_BLOCK_SIZE */
+    uint32_t flushUsec;             /* max age of buffered data */
+    uint32_t lastFlushTime;         /* log_get_time() of last flush */
+    uint32_t writeCalls;            /* write() syscalls made */
+    uint32_t records;               /* records serialized */
+    uint64_t rawBytes;              /* bytes flushed, before compression */
+    uint64_t storedBytes;           /* bytes written to file */
+    LogStrings_t strings;           /* compact format only */
+    LogIndex_t *pIndex;             /* sidecar index, NULL if none */
+    uint64_t indexBase;             /* file offset of first byte this sink wrote */
+    uint8_t buf[LOG_SINK_BLOCK_SIZE];
+    uint8_t zbuf[LOG_BLOCK_HDR_SIZE + LOG_LZ_BOUND(LOG_SINK_BLOCK_SIZE)];    /* compress only */
+} LogSink_t;
+
+/**
+ * @brief initialize sink for an open log file; for the compact format a
+ * file header is staged. Appending to a non-empty file written in another
+ * format (legacy or compact, compressed or not) is refused, the format
+ * found printed.
+ *
+ * @param pSink sink to initialize
+ * @param fd open file to write batches to
+ * @param format on-disk format to write
+ * @param compress nonzero to write batches as compressed blocks
+ * @return uint8_t success of operation
+ */
+uint8_t log_sink_init(LogSink_t *pSink, int fd, LogFormat_e format, uint8_t compress);
+
+/**
+ * @brief keep a sidecar index of records from here on (not supported for
+ * compressed files); close it with log_index_close() after the last flush
+ *
+ * @param pSink initialized sink
+ * @param pIndex index to open and update
+ * @param pLogPath path of the sink's log file
+ * @return uint8_t success of operation
+ */
+uint8_t log_sink_set_index(LogSink_t *pSink, LogIndex_t *pIndex, const char *pLogPath);
+
+/**
+ * @brief serialize item into sink's buffer, flushing first if it won't fit
+ *
+ * @param pSink sink to write to
+ * @param pLogItem item to write
+ * @return uint8_t success of operation
+ */
+uint8_t log_sink_write_item(LogSink_t *pSink, logItem_t *pLogItem);
+
+/**
+ * @brief flush buffered data if it is older than the sink's flush age;
+ * call periodically from the logging thread's loop
+ *
+ * @param pSink sink to check
+ * @return uint8_t success of operation
+ */
+uint8_t log_sink_poll(LogSink_t *pSink);
+
+/**
+ * @brief write all buffered data to file, as one block when compressing;
+ * a block that doesn't shrink is stored uncompressed
+ *
+ * @param pSink sink to flush
+ * @return uint8_t success of operation
+ */
+uint8_t log_sink_flush(LogSink_t *pSink);
+
+/**
+ * @brief serialize item using the legacy log file framing (same bytes as log_write_item)
+ *
+ * @param pLogItem item to serialize
+ * @param pBuf destination
+ * @param maxLen size of destination
+ * @return uint32_t bytes written to pBuf, 0 on error
+ */
+uint32_t log_serialize_item(logItem_t *pLogItem, uint8_t *pBuf, uint32_t maxLen);
+
+/**
+ * @brief serialize item as a compact record, preceded by a string table
+ * entry the first time its filename is seen
+ *
+ * @param pStrings string table of the file being written
+ * @param pLogItem item to serialize
+ * @param pBuf destination
+ * @param maxLen size of destination
+ * @return uint32_t bytes written to pBuf, 0 on error
+ */
+uint32_t log_serialize_compact(LogStrings_t *pStrings, logItem_t *pLogItem, uint8_t *pBuf, uint32_t maxLen);
+
+/**
+ * @brief write a compact file header and reset the string table; IDs are
+ * only valid until the next header
+ *
+ * @param pStrings string table of the file being written
+ * @param pBuf destination, at least LOG_COMPACT_FILE_HDR_SIZE bytes
+ * @return uint32_t bytes written to pBuf
+ */
+uint32_t log_compact_header(LogStrings_t *pStrings, uint8_t *pBuf);
+
+#endif	/* LOGGER_SINK_H */
@@ -26,6 +26,7 @@ typedef enum {
     LOG_STATUS_UNINITIALIZED,
     LOG_STATUS_BUF_FULL,
 	LOG_STATUS_TIMEOUT,
+    LOG_STATUS_EOF,
     LOG_STATUS_END
 } LogStatus_e;
 
@@ -62,15 +63,26 @@ typedef enum  __attribute__ ((__packed__)) {
 	LOG_MSG_END = 24
 } logMsg_e;
 
+/* how a msg's payload is encoded; producers enqueue raw arguments and
+ * the logging thread renders them (log_render_item) before writing */
+typedef enum  __attribute__ ((__packed__)) {
+	LOG_PAYLOAD_TEXT = 0,		/* payloadLength bytes, written as is */
+	LOG_PAYLOAD_STRING,			/* null terminated, measured when packed (producers only) */
+	LOG_PAYLOAD_EVENT,			/* raw uint32_t event value, rendered as hex text */
+	LOG_PAYLOAD_END
+} logPayload_e;
+
 typedef struct {
 	logMsg_e logMsgId;
-	uint8_t *pFilename;
+	logPayload_e payloadFormat;
+	uint16_t fileId;		/* LogFileId_e, set by producers */
+	uint8_t *pFilename;		/* NULL, or a name overriding fileId (log file readers) */
 	uint16_t lineNum;
 	uint32_t time;
 	uint32_t payloadLength;
 	uint8_t *pPayload;
 	uint16_t sourceId;
-	uint32_t checksum;
+	uint32_t checksum;		/* set by log_render_item, not producers */
 } logItem_t;
 
 #endif	/* LOGGER_TYPES_H */
@@ -20,6 +20,13 @@
 #include <stdint.h>
 #include <signal.h>
 
+#include "platform.h"
+#include "logger_ref.h"
+
+/* most records written per loop before the heartbeat and a flush get a turn;
+ * room for the msg queue's share and a full ring of remote records */
+#define LOG_LOOP_MAX_MSGS           (((NUM_THREADS + NUM_REMOTE_REPORTING_THREADS) * 20) + LOG_REF_DEPTH)
+
 typedef enum {
     LOG_EVENT_STARTED = 0,
     LOG_EVENT_FILE_OPEN,
@@ -0,0 +1,134 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 13, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file nodeTable.h
+ * @brief remote nodes known to the control node, keyed by node ID
+ *
+ * A remote node names itself with a RemoteHelloPacket as the first thing
+ * sent on each of its connections. The remote server adds the node the
+ * first time it is heard from, marks which of its ports are connected, and
+ * stores its latest sensor data; main reads the data and keeps each node's
+ * control loop state and thresholds here. Nodes stay in the table when they
+ * disconnect, so a node that reconnects picks up its schedule and thresholds
+ * where it left off.
+ *
+ * A node in telemetry mode sends its data as UDP datagrams instead; they
+ * are only taken from nodes in the table, which is to say ones that have
+ * said hello over TCP, and late or repeated ones are counted, not stored.
+ *
+ * One mutex guards the table; every call copies in or out under it, the
+ * remote server's store of a data packet is a hash lookup and a memcpy.
+ *
+ ************************************************************************************
+ */
+
+#ifndef NODE_TABLE_H_
+#define NODE_TABLE_H_
+
+#include <stdint.h>
+#include "packet.h"
+#include "telemetrySeq.h"
+
+#define NODE_TABLE_MAX_NODES    (128)       /* power of 2 */
+#define NODE_ID_NONE            (0)         /* not a valid node ID, as isn't REMOTE_NODE_ALL */
+
+/* owned by main */
+typedef struct {
+    ControlLoopState_e state;
+    SystemState_e systemState;
+    float moistureLow;
+    float moistureHigh;
+    uint32_t wateringCount;             /* control loops spent watering */
+    uint8_t checkingMoisture;
+    uint32_t waterPeriodSec;            /* periodic schedule, 0 if none */
+    uint64_t nextWaterSec;              /* CLOCK_MONOTONIC sec of next watering, 0 if none */
+} NodeControl_t;
+
+typedef struct {
+    uint16_t nodeId;
+    uint8_t ports;                      /* bit per connected remote port */
+    uint32_t dataCount;                 /* data packets stored */
+    uint64_t dataUsec;                  /* CLOCK_MONOTONIC usec of latest data, 0 if none */
+    RemoteDataPacket data;              /* latest */
+    uint16_t telemetryHz;               /* rate of its latest telemetry, 0 if none */
+    TelemetrySeq_t telemetry;
+    NodeControl_t control;
+} RemoteNode_t;
+
+/**
+ * @brief empty the table
+ */
+void node_table_init(void);
+
+/**
+ * @brief mark ports of a node connected, adding the node if new with
+ * default thresholds and an idle control loop
+ *
+ * @param nodeId node named in its hello
+ * @param portMask bits of the ports connected
+ * @return int8_t EXIT_FAILURE if the ID is invalid or the table is full
+ */
+int8_t node_table_connect(uint16_t nodeId, uint8_t portMask);
+
+/**
+ * @brief mark ports of a node disconnected
+ *
+ * @param nodeId node
+ * @param portMask bits of the ports lost
+ */
+void node_table_disconnect(uint16_t nodeId, uint8_t portMask);
+
+/**
+ * @brief store a node's latest sensor data
+ *
+ * @param nodeId node the data came from
+ * @param pData data packet
+ * @return int8_t EXIT_FAILURE if the node isn't in the table
+ */
+int8_t node_table_data(uint16_t nodeId, const RemoteDataPacket *pData);
+
+/**
+ * @brief account for a node's telemetry datagram, storing its data if
+ * it's the newest
+ *
+ * @param pPacket datagram's packet
+ * @param pResult set to how it was accounted for
+ * @return int8_t EXIT_FAILURE if the node isn't in the table
+ */
+int8_t node_table_telemetry(const RemoteTelemetryPacket *pPacket, TelemetrySeq_e *pResult);
+
+/**
+ * @brief copy of a node's entry
+ *
+ * @param nodeId node
+ * @param pNode copy
+ * @return int8_t EXIT_FAILURE if the node isn't in the table
+ */
+int8_t node_table_get(uint16_t nodeId, RemoteNode_t *pNode);
+
+/**
+ * @brief replace a node's control loop state and thresholds
+ *
+ * @param nodeId node
+ * @param pControl new control state
+ * @return int8_t EXIT_FAILURE if the node isn't in the table
+ */
+int8_t node_table_set_control(uint16_t nodeId, const NodeControl_t *pControl);
+
+/**
+ * @brief IDs of the nodes in the table, lowest first
+ *
+ * @param pIds filled with up to max IDs
+ * @param max size of pIds
+ * @return uint16_t number of nodes written
+ */
+uint16_t node_table_list(uint16_t *pIds, uint16_t max);
+
+#endif /* NODE_TABLE_H_ */
@@ -18,6 +18,7 @@
 #define PACKET_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __linux__
 #include <pthread.h>
@@ -33,6 +34,12 @@
 #include "platform.h"
 
 #define STATUS_MSG_QUEUE_MSG_SIZE   (sizeof(TaskStatusPacket)) // bytes
+#define STATUS_SUMMARY_HEADER       (0x5AA5)  // StatusSummaryPacket on the status link
+#define STATUS_SUMMARY_MAX_TASKS    (8)
+#define STATUS_SUMMARY_PERIOD_MS    (1000)    // well inside the BBG heartbeat deadline
+#define REMOTE_HELLO_HEADER         (0x4E44)  // RemoteHelloPacket, first on every remote connection
+#define REMOTE_NODE_ALL             (0xFFFF)  // RemoteCmdPacket header on the cmd queue: every node
+#define REMOTE_TELEMETRY_MAX_HZ     (100)     // RemoteTelemetryPacket rate a node may be set to
 
 /* since main runs at half speed of other threads, 
  * each time main awakes there should be two msgs per thread under
@@ -45,7 +52,7 @@
 #define CMD_MSG_QUEUE_MSG_SIZE      (sizeof(RemoteCmdPacket)) // bytes
 #define DATA_MSG_QUEUE_MSG_SIZE     (sizeof(RemoteDataPacket)) // bytes
 #define LOG_MSG_QUEUE_DEPTH         ((NUM_THREADS + NUM_REMOTE_REPORTING_THREADS) * 15) // total messages
-#define LOG_MSG_FILENAME_SIZE       (32) // bytes
+#define LOG_MSG_FILENAME_SIZE       (32) // bytes, longest file name written to log
 #define LOG_MSG_PAYLOAD_SIZE        (128) // bytes
 #define IPC_NAME_SIZE               (30)
 
@@ -200,6 +207,10 @@ typedef enum ConsoleCmd_e
   CMD_SETMOISTURE_LOWTHRES,
   CMD_SETMOISTURE_HIGHTHRES,
   CMD_SCHED_CANCEL,
+  CMD_LOG_FILTER, /* Show / change runtime log filter */
+  CMD_HEALTH_STATS, /* Show heartbeat interval / delivery histograms */
+  CMD_SELECT_NODE, /* List remote nodes, choose the one cmds act on */
+  CMD_SET_TELEMETRY_HZ, /* Set a UDP telemetry node's data rate */
   CMD_MAX_CMDS
 } ConsoleCmd_e;
 
@@ -220,6 +231,7 @@ typedef enum __attribute__ ((__packed__)) {
   REMOTE_DSDEV2,
   REMOTE_SETMOISTURE_LOWTHRES,
   REMOTE_SETMOISTURE_HIGHTHRES,
+  REMOTE_SET_TELEMETRY_HZ,   /* data 1 to REMOTE_TELEMETRY_MAX_HZ */
   MAX_CMDS,
   REMOTE_CMD_END
 } RemoteCmd_e;
@@ -248,10 +260,35 @@ typedef struct TaskStatusPacket {
   uint8_t errorCode;
 } TaskStatusPacket;
 
+/* STATUS_OK msgs of one task merged over a summary period */
+typedef struct TaskStatusSummary {
+  uint32_t firstTimestamp;
+  uint32_t lastTimestamp;
+  uint16_t count;             /* 0: nothing pending */
+  uint8_t processId;          /* ProcessId_e */
+  uint8_t errorCode;          /* of the last msg merged */
+} TaskStatusSummary;
+
+/* Sent on the status link in place of the STATUS_OK msgs it summarizes;
+ * header is where TaskStatusPacket has its header, so the receiver can
+ * tell them apart from the first sizeof(TaskStatusPacket) bytes. Only
+ * numTasks entries are sent, never less than a TaskStatusPacket. */
+typedef struct StatusSummaryPacket {
+  uint16_t header;            /* STATUS_SUMMARY_HEADER */
+  uint8_t numTasks;
+  uint8_t reserved;
+  TaskStatusSummary tasks[STATUS_SUMMARY_MAX_TASKS];
+} StatusSummaryPacket;
+
+#define STATUS_SUMMARY_SIZE(numTasks) \
+  (((offsetof(StatusSummaryPacket, tasks) + ((numTasks) * sizeof(TaskStatusSummary))) > sizeof(TaskStatusPacket)) ?\
+   (offsetof(StatusSummaryPacket, tasks) + ((numTasks) * sizeof(TaskStatusSummary))) : sizeof(TaskStatusPacket))
+
 typedef struct
 {
     logMsg_e logMsgId;
-    uint8_t filename[LOG_MSG_FILENAME_SIZE];
+    logPayload_e payloadFormat; /* TEXT or EVENT, rendered by the BBG logging thread */
+    uint16_t fileId;      /* LogFileId_e, see logger_files.h */
     uint16_t lineNum;
     uint32_t timestamp;
     uint32_t payloadLength;
@@ -260,6 +297,15 @@ typedef struct
 	  uint32_t checksum;
 } LogMsgPacket;
 
+/* A remote node sends this first on each connection to the control node,
+ * naming itself; node IDs are 1 to REMOTE_NODE_ALL - 1 */
+typedef struct RemoteHelloPacket
+{
+  uint16_t header;            /* REMOTE_HELLO_HEADER */
+  uint16_t nodeId;
+} RemoteHelloPacket;
+
+/* header is the node to send to while on the BBG's cmd queue */
 typedef struct RemoteCmdPacket
 {
   uint16_t header;
@@ -274,6 +320,18 @@ typedef struct RemoteDataPacket
   float moistureData;
 } RemoteDataPacket;
 
+/* Sensor data in telemetry mode, one per UDP datagram as a whole frame;
+ * seq counts up from 0 when the node starts, so the control node can tell
+ * lost, late and repeated datagrams apart */
+typedef struct RemoteTelemetryPacket
+{
+  uint16_t nodeId;
+  uint16_t rateHz;            /* node's send rate when sent */
+  uint32_t seq;
+  uint32_t timestamp;         /* node's ms clock when the data was read */
+  RemoteDataPacket data;
+} RemoteTelemetryPacket;
+
 /* This struct will be used within shared memory to define data structure to read/write btw threads */
 typedef struct TempDataStruct
 {
@@ -360,6 +418,10 @@ typedef struct LogThreadInfo
   char heartbeatMsgQueueName[IPC_NAME_SIZE];
   char logMsgQueueName[IPC_NAME_SIZE];
   char logFileName[64];
+  uint8_t logFormat;    /* LogFormat_e, on-disk format */
+  uint32_t segmentSize; /* bytes per mmap'd log segment, 0 for a single log file */
+  uint8_t segmentsKept; /* log segments retained */
+  uint8_t compress;     /* write single log file as compressed blocks */
 } LogThreadInfo;
 
 #endif // PACKET_H_
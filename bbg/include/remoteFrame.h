@@ -0,0 +1,220 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 14, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file remoteFrame.h
+ * @brief frames for the TCP links between the remote and control nodes
+ *
+ * TCP is a byte stream: one send() may arrive split over several recv()s,
+ * or several together in one. Every packet on the remote links is sent as a
+ * FrameHeader_t and then its payload, so the receiver can find the packets
+ * again whatever the segmentation. A FrameReader_t takes bytes as they come
+ * and gives back each whole frame. A frame whose header or CRC doesn't check
+ * is dropped, the reader stepping one byte past its start to look for the
+ * next magic; nothing it returns is damaged. The reader receives into a
+ * buffer its owner provides, and frames it returns stay put until it has
+ * to move the rest down for room, so the owner can hand packets on by
+ * pointer and, if they're still in use then, give it another buffer.
+ *
+ * A UDP datagram carries exactly one frame; frame_check() takes it whole.
+ *
+ * A FRAME_TYPE_BATCH frame carries many small packets, each a FrameRecord_t
+ * and the packet padded to 4 bytes, so a busy link sends one frame (and one
+ * TCP segment) where it would have sent dozens. A FrameBatch_t fills one up
+ * to FRAME_LINK_MSS; frame_batch_next() takes them apart again.
+ *
+ * Same byte order and alignment at both ends (both little endian ARM), as
+ * for the packets themselves. No OS calls, built on both the BBG and the TIVA.
+ *
+ ************************************************************************************
+ */
+
+#ifndef REMOTEFRAME_H_
+#define REMOTEFRAME_H_
+
+#include <stdint.h>
+#include "packet.h"
+
+#define FRAME_MAGIC             (0xA5C3)
+#define FRAME_VERSION           (1)
+#define FRAME_LINK_MSS          (1434)      /* TIVA ipconfigTCP_MSS; MTU 1500 less Ethernet, IPv4, TCP and 12 option bytes */
+#define FRAME_MAX_PAYLOAD       (FRAME_LINK_MSS - sizeof(FrameHeader_t))    /* a whole frame is one segment */
+#define FRAME_MAX_SIZE          (sizeof(FrameHeader_t) + FRAME_MAX_PAYLOAD)
+#define FRAME_READER_SIZE       (2 * FRAME_MAX_SIZE)
+#define FRAME_RECORD_SIZE(len)  (sizeof(FrameRecord_t) + (((len) + 3) & ~3u))   /* batch bytes a packet takes */
+
+typedef enum {
+    FRAME_TYPE_HELLO = 1,               /* RemoteHelloPacket, first on every connection */
+    FRAME_TYPE_LOG,                     /* LogMsgPacket */
+    FRAME_TYPE_STATUS,                  /* TaskStatusPacket */
+    FRAME_TYPE_STATUS_SUMMARY,          /* StatusSummaryPacket, STATUS_SUMMARY_SIZE() bytes */
+    FRAME_TYPE_CMD,                     /* RemoteCmdPacket */
+    FRAME_TYPE_DATA,                    /* RemoteDataPacket */
+    FRAME_TYPE_BATCH,                   /* FrameRecord_t and packet, padded, repeated */
+    FRAME_TYPE_TELEMETRY,               /* RemoteTelemetryPacket, alone in a UDP datagram */
+    FRAME_TYPE_END
+} FrameType_e;
+
+typedef struct {
+    uint16_t magic;                     /* FRAME_MAGIC */
+    uint8_t version;                    /* FRAME_VERSION */
+    uint8_t type;                       /* FrameType_e */
+    uint32_t length;                    /* payload bytes that follow */
+    uint32_t crc;                       /* CRC-32C of the header up to here, then the payload */
+} FrameHeader_t;
+
+typedef struct {
+    uint8_t type;                       /* FrameType_e of the packet, not HELLO or BATCH */
+    uint8_t reserved;
+    uint16_t length;                    /* packet bytes that follow, before padding */
+} FrameRecord_t;
+
+typedef struct {
+    FrameHeader_t hdr;                  /* set by frame_batch_finish() */
+    uint8_t payload[FRAME_MAX_PAYLOAD]; /* records, right after hdr to send as one */
+    uint32_t records;                   /* packets in payload */
+} FrameBatch_t;
+
+typedef struct {
+    uint8_t *pBuf;                      /* FRAME_READER_SIZE bytes, 4 byte aligned */
+    uint32_t start;                     /* first byte not yet returned or dropped */
+    uint32_t end;                       /* one past the last byte received */
+    uint32_t skipped;                   /* bytes dropped finding frames */
+    uint32_t crcErrors;                 /* frames dropped for their CRC */
+    uint32_t moved;                     /* bytes copied within or between buffers */
+} FrameReader_t;
+
+/**
+ * @brief header for a payload; send the header, then the payload
+ *
+ * @param pHdr set to the header
+ * @param type FrameType_e of the payload
+ * @param pPayload payload
+ * @param len bytes of payload, at most FRAME_MAX_PAYLOAD
+ */
+void frame_header(FrameHeader_t *pHdr, FrameType_e type, const void *pPayload, uint32_t len);
+
+/**
+ * @brief whether a datagram is exactly one good frame
+ *
+ * @param pFrame datagram, header first
+ * @param len datagram bytes
+ * @param pHdr set to the frame's header
+ * @return uint8_t 1 if it is; its payload follows the header
+ */
+uint8_t frame_check(const uint8_t *pFrame, uint32_t len, FrameHeader_t *pHdr);
+
+/**
+ * @brief empty a reader, as for a new connection
+ *
+ * @param pRd reader
+ * @param pBuf FRAME_READER_SIZE bytes to receive into, 4 byte aligned
+ */
+void frame_reader_init(FrameReader_t *pRd, uint8_t *pBuf);
+
+/**
+ * @brief whether frame_reader_space() will move the bytes not yet
+ * returned down over the frames that were
+ *
+ * @param pRd reader
+ * @return uint8_t 1 if it will; frame_reader_move() first to keep them
+ */
+uint8_t frame_reader_compacts(const FrameReader_t *pRd);
+
+/**
+ * @brief carry on in another buffer, taking the bytes not yet returned;
+ * frames already returned stay where they are in the old one
+ *
+ * @param pRd reader
+ * @param pBuf FRAME_READER_SIZE bytes, 4 byte aligned
+ */
+void frame_reader_move(FrameReader_t *pRd, uint8_t *pBuf);
+
+/**
+ * @brief where to receive the next bytes into; moves the bytes not yet
+ * returned to the start of the buffer if there's less than a frame's room
+ * after them
+ *
+ * @param pRd reader
+ * @param pFree set to bytes free there, never 0
+ * @return uint8_t* receive into here, then frame_reader_commit()
+ */
+uint8_t *frame_reader_space(FrameReader_t *pRd, uint32_t *pFree);
+
+/**
+ * @brief add bytes received into frame_reader_space()
+ *
+ * @param pRd reader
+ * @param len bytes received
+ */
+void frame_reader_commit(FrameReader_t *pRd, uint32_t len);
+
+/**
+ * @brief next whole frame received; call until it returns 0 before
+ * receiving more
+ *
+ * @param pRd reader
+ * @param pHdr set to the frame's header
+ * @param ppPayload set to its payload, 4 byte aligned, in the reader's
+ * buffer until frame_reader_space() compacts it
+ * @return uint8_t 1 if a frame was returned, 0 if more bytes are needed
+ */
+uint8_t frame_reader_next(FrameReader_t *pRd, FrameHeader_t *pHdr, uint8_t **ppPayload);
+
+/**
+ * @brief empty a batch
+ *
+ * @param pBatch batch
+ */
+void frame_batch_init(FrameBatch_t *pBatch);
+
+/**
+ * @brief bytes a batch still has room for, FRAME_RECORD_SIZE() per packet
+ *
+ * @param pBatch batch
+ * @return uint32_t bytes free
+ */
+uint32_t frame_batch_free(const FrameBatch_t *pBatch);
+
+/**
+ * @brief copy a packet into a batch
+ *
+ * @param pBatch batch
+ * @param type FrameType_e of the packet, not HELLO or BATCH
+ * @param pPacket packet
+ * @param len bytes of packet
+ * @return uint8_t 0 if it doesn't fit; send the batch and add it to the next
+ */
+uint8_t frame_batch_add(FrameBatch_t *pBatch, FrameType_e type, const void *pPacket, uint32_t len);
+
+/**
+ * @brief set a batch's header for what it holds; send the bytes from
+ * &pBatch->hdr, then frame_batch_init() it again
+ *
+ * @param pBatch batch
+ * @return uint32_t bytes to send, 0 if the batch is empty
+ */
+uint32_t frame_batch_finish(FrameBatch_t *pBatch);
+
+/**
+ * @brief next packet in a FRAME_TYPE_BATCH frame's payload
+ *
+ * @param pPayload frame's payload, as from frame_reader_next()
+ * @param len frame's payload bytes
+ * @param pOffset 0 for the first packet, advanced past each one returned
+ * @param pType set to the packet's FrameType_e
+ * @param ppPacket set to the packet, 4 byte aligned
+ * @param pPacketLen set to its bytes
+ * @return uint8_t 1 if a packet was returned, 0 at the end of the batch or
+ * at a record that doesn't fit in it or can't be batched
+ */
+uint8_t frame_batch_next(uint8_t *pPayload, uint32_t len, uint32_t *pOffset,
+                         FrameType_e *pType, uint8_t **ppPacket, uint32_t *pPacketLen);
+
+#endif /* REMOTEFRAME_H_ */
@@ -0,0 +1,115 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 12, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file remoteServer.h
+ * @brief one thread serving the remote node's log, status, cmd, data and mux ports
+ * and telemetry
+ *
+ * Replaces the four per-port remote threads, which each slept on their own
+ * timer and polled accept()/recv() once a tick, so anything the remote node
+ * sent waited up to a REMOTE_LOOP_TIME for the next tick. Here one epoll
+ * set holds every listening socket, every connection, the cmd msg queue and
+ * a REMOTE_LOOP_TIME timerfd. Sockets are non-blocking and edge triggered:
+ * on each wakeup a connection is read until EAGAIN into its own FrameReader_t
+ * (remoteFrame.h), and every whole frame is handed to its port's handler, so
+ * a packet split across segments or several arriving in one are both fine.
+ * A batch frame's packets are handed over one by one, the same as if each
+ * had come in its own frame.
+ *
+ * Up to NODE_TABLE_MAX_NODES remote nodes may connect. Each connection must
+ * start with the node's RemoteHelloPacket frame; the node is added to the node
+ * table and its data packets are stored there. A cmd queued by main goes to
+ * the cmd connection of the node in the cmd's header, or to every node.
+ * Status from all nodes goes to the same heartbeat slots, so the health
+ * monitor sees a remote task alive while any node's is.
+ *
+ * A node may instead send everything over one MUX_PORT connection, and is
+ * sent its cmds there; each frame goes to the handler of the port its type
+ * belongs to. Cmds queued by main are sent before any connection is read,
+ * and a connection is read for no more than REMOTE_SERVER_READ_BUDGET bytes
+ * at a time before the others and the cmd queue get a turn, so cmds are not
+ * held up behind a node's log flood.
+ *
+ * Each connection receives into a bufPool buffer. Log packets are handed to
+ * the logging thread by pointer where they were received (logger_ref.h);
+ * when the reader needs room while some are still unwritten it carries on
+ * in a fresh buffer, copying only the partial frame at the end.
+ *
+ * Nodes in telemetry mode send their data as UDP datagrams to TELEMETRY_PORT,
+ * each one whole frame; the node table stores the newest and counts those
+ * lost, late and repeated (telemetrySeq.h). A node is only heard from there
+ * once it has said hello over TCP, where its cmds still go.
+ *
+ * Commands queued by main are sent as soon as they are queued. The timer
+ * publishes heartbeats for PID_REMOTE_LOG, _STATUS, _DATA and _CMD; the
+ * thread is supervised as PID_REMOTE_DATA, the others aliases of it.
+ *
+ ************************************************************************************
+ */
+
+#ifndef REMOTE_SERVER_H_
+#define REMOTE_SERVER_H_
+
+#include <stdint.h>
+#include <signal.h>
+
+#include "remoteThread.h"
+#include "nodeTable.h"
+#include "remoteFrame.h"
+#include "bufPool.h"
+#include "logger_ref.h"
+
+#define REMOTE_SERVER_PID           (PID_REMOTE_DATA)   /* supervised as, and killed by SIGRTMIN + */
+#define REMOTE_SERVER_MAX_CONNS     (4 * NODE_TABLE_MAX_NODES)  /* every port of every node */
+#define REMOTE_SERVER_LINK_STATS_SEC (60)
+#define REMOTE_SERVER_READ_BUDGET   (16 * FRAME_MAX_SIZE)   /* bytes per connection per turn */
+#define REMOTE_SERVER_RX_BUFS       (REMOTE_SERVER_MAX_CONNS + LOG_REF_DEPTH + 1)  /* one per connection, per queued log packet, and the one being written */
+
+typedef struct {
+    uint64_t rxBytes;                   /* received from nodes */
+    uint64_t movedBytes;                /* copied within or between receive buffers */
+    uint32_t logRecords;                /* log packets past the filter */
+    uint32_t logRefs;                   /* of them, handed to the logging thread by reference */
+    uint32_t telemetry;                 /* UDP telemetry datagrams */
+    uint32_t telemetryDropped;          /* of them, damaged or from nodes not in the table */
+} RemoteRxStats_t;
+
+/*---------------------------------------------------------------------------------*/
+
+/**
+ * @brief serve all remote ports until killed with SIGRTMIN + REMOTE_SERVER_PID
+ *
+ * @param threadInfo - SensorThreadInfo with the queue names, from main()
+ *
+ * @return void*
+ */
+void* remoteServerThreadHandler(void* threadInfo);
+
+/**
+ * @brief tell the server thread to exit
+ *
+ * @param signo - Signal number
+ * @param info - Struct used to pass data through to Signal Handler.
+ * @param extra - Additional params if needed by sigAction struct when setting sa_sigaction
+ * @return void
+ */
+void remoteServerSigHandler(int signo, siginfo_t *info, void *extra);
+
+/**
+ * @brief receive path totals since the server thread started, for
+ * benchmarks; read while it runs
+ *
+ * @param pStats set to the totals
+ * @return void
+ */
+void remoteServerRxStats(RemoteRxStats_t *pStats);
+
+/*---------------------------------------------------------------------------------*/
+#endif /* REMOTE_SERVER_H_ */
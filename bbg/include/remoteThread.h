@@ -44,7 +44,25 @@ extern uint8_t g_cmdSocketLost;
 #define STATUS_PORT             (5002)
 #define CMD_PORT                (5003)
 #define DATA_PORT               (5004)
+#define MUX_PORT                (5005)  /* log, status, data and cmds on one connection */
+#define TELEMETRY_PORT          (5006)  /* UDP, sensor data in telemetry mode */
 #define SERVER_IP_ADDRESS_STR   ("10.0.0.87")
+#define REMOTE_BATCH_DEADLINE_MS (50)   /* longest a TIVA log record waits for more to batch with */
+#define REMOTE_MUX_POLL_MS      (10)    /* longest the TIVA mux task waits on cmds before its queues */
+
+/* TIVA: 1 for one task and one MUX_PORT connection in place of the four;
+ * the BBG serves both */
+#ifndef REMOTE_LINK_MUX
+#define REMOTE_LINK_MUX         (0)
+#endif
+
+/* TIVA: 1 to send sensor data as UDP datagrams to TELEMETRY_PORT at
+ * REMOTE_TELEMETRY_HZ, changed by REMOTE_SET_TELEMETRY_HZ, in place of once
+ * a second over TCP; cmds, logs and status stay on TCP. The BBG serves both */
+#ifndef REMOTE_TELEMETRY_UDP
+#define REMOTE_TELEMETRY_UDP    (0)
+#endif
+#define REMOTE_TELEMETRY_HZ     (10)
 
 
 
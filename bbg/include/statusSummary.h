@@ -0,0 +1,70 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 9, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file statusSummary.h
+ * @brief coalesce STATUS_OK task status msgs on the status link
+ *
+ * The TIVA's tasks each send a STATUS_OK heartbeat every loop; one packet
+ * apiece on the status link. The remote status task instead merges them per
+ * task and sends one StatusSummaryPacket every STATUS_SUMMARY_PERIOD_MS,
+ * while anything other than STATUS_OK is still sent the moment it arrives.
+ * The BBG expands a summary back into one heartbeat per task.
+ *
+ * No OS calls, built on both the BBG and the TIVA; the caller does timing.
+ *
+ ************************************************************************************
+ */
+
+#ifndef STATUSSUMMARY_H_
+#define STATUSSUMMARY_H_
+
+#include <stdint.h>
+#include "packet.h"
+
+typedef struct {
+    TaskStatusSummary tasks[PID_END];   /* by ProcessId_e, count 0 if nothing pending */
+} StatusCoalescer_t;
+
+/**
+ * @brief clear pending summaries
+ *
+ * @param pCo coalescer
+ */
+void status_summary_init(StatusCoalescer_t *pCo);
+
+/**
+ * @brief merge a STATUS_OK msg into its task's summary
+ *
+ * @param pCo coalescer
+ * @param pStatus msg from a task
+ * @return uint8_t 1 if the msg wasn't merged and must be sent now
+ */
+uint8_t status_summary_add(StatusCoalescer_t *pCo, const TaskStatusPacket *pStatus);
+
+/**
+ * @brief move pending summaries into a packet; if more than
+ * STATUS_SUMMARY_MAX_TASKS are pending the rest stay for the next one
+ *
+ * @param pCo coalescer
+ * @param pPacket set to summary packet
+ * @return uint32_t bytes of pPacket to send, 0 if nothing was pending
+ */
+uint32_t status_summary_flush(StatusCoalescer_t *pCo, StatusSummaryPacket *pPacket);
+
+/**
+ * @brief check a received summary packet
+ *
+ * @param pPacket received packet
+ * @param len bytes received
+ * @return uint8_t 1 if it is a well formed summary of len bytes
+ */
+uint8_t status_summary_valid(const StatusSummaryPacket *pPacket, uint32_t len);
+
+#endif /* STATUSSUMMARY_H_ */
@@ -0,0 +1,130 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 8, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file supervisor.h
+ * @brief re-create failed threads with restart rate limiting and backoff
+ *
+ * Threads started with supervisor_start() run their handler from a wrapper
+ * that tells the supervisor thread when the handler returns. A thread that
+ * exits on its own, or is told to by supervisor_restart(), is joined and
+ * its handler re-run with the same thread info after a backoff that doubles
+ * with every restart (reset once it has run SUPERVISOR_STABLE_USEC). More
+ * than SUPERVISOR_MAX_RESTARTS in SUPERVISOR_WINDOW_USEC and the thread is
+ * left down, so a crash looping thread can't take the system with it.
+ *
+ * Queues are owned by main so they survive a restart; threads re-open them
+ * by name from their thread info.
+ *
+ * One thread can do the work of several ProcessId_e (the remote server
+ * serves all four remote ports); the others are made aliases of the Id it
+ * was started as, so restarting, terminating or asking about any of them
+ * acts on that thread.
+ *
+ ************************************************************************************
+ */
+
+#ifndef SUPERVISOR_H_
+#define SUPERVISOR_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include "packet.h"
+
+#define SUPERVISOR_BACKOFF_MIN_USEC     (100000)
+#define SUPERVISOR_BACKOFF_MAX_USEC     (30000000)
+#define SUPERVISOR_STABLE_USEC          (10000000)     /* run this long and backoff resets */
+#define SUPERVISOR_MAX_RESTARTS         (5)
+#define SUPERVISOR_WINDOW_USEC          (60000000)
+
+typedef void *(*supervisedFunc_t)(void *pInfo);
+
+typedef enum {
+    SUPERVISOR_NONE = 0,        /* not supervised */
+    SUPERVISOR_RUNNING,
+    SUPERVISOR_STOPPING,        /* told to exit, restarts once it has */
+    SUPERVISOR_BACKOFF,         /* exited, waiting to be re-created */
+    SUPERVISOR_TERMINATED,      /* exited and stays down */
+    SUPERVISOR_GAVE_UP          /* restarted too often, stays down */
+} SupervisorState_e;
+
+typedef struct {
+    SupervisorState_e state;
+    uint32_t restarts;          /* since supervisor_start() */
+    uint32_t backoffUsec;       /* wait before the next restart */
+    uint32_t lastRecoveryUsec;  /* last exit to re-created */
+} SupervisorInfo_t;
+
+/**
+ * @brief start the supervisor thread
+ *
+ * @param pExit cleared when the application is exiting; no restarts after
+ * @return int8_t EXIT_SUCCESS / EXIT_FAILURE
+ */
+int8_t supervisor_init(uint8_t *pExit);
+
+/**
+ * @brief create a supervised thread
+ *
+ * @param Id thread's ProcessId_e, SIGRTMIN + Id tells it to exit
+ * @param handler thread function, re-run on restart
+ * @param pInfo passed to handler, must stay valid while supervised
+ * @param pThread updated with the thread's handle on every restart
+ * @return int8_t EXIT_SUCCESS / EXIT_FAILURE
+ */
+int8_t supervisor_start(ProcessId_e Id, supervisedFunc_t handler, void *pInfo, pthread_t *pThread);
+
+/**
+ * @brief tell a supervised thread to exit and re-create it after its backoff
+ *
+ * @param Id thread to restart
+ * @return int8_t EXIT_FAILURE if it isn't supervised or was given up on
+ */
+int8_t supervisor_restart(ProcessId_e Id);
+
+/**
+ * @brief tell a supervised thread to exit for good
+ *
+ * @param Id thread to terminate
+ * @return int8_t EXIT_FAILURE if it isn't supervised
+ */
+int8_t supervisor_terminate(ProcessId_e Id);
+
+/**
+ * @brief current state and restart history of a thread
+ *
+ * @param Id thread
+ * @param pInfo set to thread's supervisor info
+ */
+void supervisor_info(ProcessId_e Id, SupervisorInfo_t *pInfo);
+
+/**
+ * @brief make restart, terminate and info requests for alias act on the
+ * thread supervised as Id; join Id itself, not its aliases
+ *
+ * @param alias ProcessId_e with no thread of its own
+ * @param Id ProcessId_e the thread was started as
+ * @return int8_t EXIT_FAILURE if either is out of range or alias is Id
+ */
+int8_t supervisor_alias(ProcessId_e alias, ProcessId_e Id);
+
+/**
+ * @brief stop the supervisor thread; threads still running are left for
+ * supervisor_join()
+ */
+void supervisor_stop(void);
+
+/**
+ * @brief join a supervised thread after supervisor_stop(), if it is running
+ *
+ * @param Id thread to join
+ */
+void supervisor_join(ProcessId_e Id);
+
+#endif /* SUPERVISOR_H_ */
@@ -0,0 +1,68 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 18, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file telemetrySeq.h
+ * @brief loss, reorder and duplicate accounting of a node's UDP telemetry
+ *
+ * Telemetry datagrams carry a sequence number counting up from 0 when the
+ * node starts. The newest seen so far is the node's latest data; anything
+ * older that turns up is late and only counted, so a reading never goes
+ * backwards. Numbers skipped over are counted lost, and taken off again if
+ * they turn up within TELEMETRY_SEQ_WINDOW of the newest; a repeat of one
+ * already seen in the window is a duplicate. A number further back than
+ * the window is the node having restarted, and accounting starts over from
+ * it, counts kept.
+ *
+ * No locking; the node table keeps one per node under its mutex.
+ *
+ ************************************************************************************
+ */
+
+#ifndef TELEMETRY_SEQ_H_
+#define TELEMETRY_SEQ_H_
+
+#include <stdint.h>
+
+#define TELEMETRY_SEQ_WINDOW    (64)        /* bits in window */
+
+typedef enum {
+    TELEMETRY_SEQ_NEW = 0,                  /* newest yet, store it */
+    TELEMETRY_SEQ_LATE,                     /* older than the newest, first time seen */
+    TELEMETRY_SEQ_DUPLICATE,                /* seen before */
+    TELEMETRY_SEQ_END
+} TelemetrySeq_e;
+
+typedef struct {
+    uint32_t received;                      /* datagrams, any kind */
+    uint32_t lost;                          /* skipped and not turned up since */
+    uint32_t late;                          /* turned up after a newer one */
+    uint32_t duplicates;
+    uint32_t restarts;                      /* node started counting again */
+    uint32_t newest;                        /* seq of the latest data */
+    uint64_t window;                        /* bit n: newest - n seen */
+} TelemetrySeq_t;
+
+/**
+ * @brief no datagrams yet
+ *
+ * @param pSeq accounting
+ */
+void telemetry_seq_init(TelemetrySeq_t *pSeq);
+
+/**
+ * @brief account for a datagram
+ *
+ * @param pSeq accounting
+ * @param seq datagram's sequence number
+ * @return TelemetrySeq_e whether its data is the latest
+ */
+TelemetrySeq_e telemetry_seq_update(TelemetrySeq_t *pSeq, uint32_t seq);
+
+#endif /* TELEMETRY_SEQ_H_ */
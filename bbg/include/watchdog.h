@@ -0,0 +1,120 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 11, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file watchdog.h
+ * @brief feed a Linux watchdog device only while the system is making progress,
+ * and write down why when it isn't
+ *
+ * The watchdog thread wakes every feedUsec and feeds the device if main has
+ * called watchdog_checkin() and every required thread has published a
+ * heartbeat within stallUsec (the health monitor's deadline). A required
+ * thread the supervisor is restarting or has terminated on purpose doesn't
+ * hold feeding off; one it gave up on does.
+ *
+ * The first check that finds a stall writes a report to the forensics file:
+ * what stalled, every heartbeat slot, queue depths, the last item each thread
+ * logged and a backtrace of main and each stalled thread. Backtraces are taken
+ * by signalling the thread (WATCHDOG_SIGNAL), its handler filling a
+ * preallocated buffer; where libc has no backtrace() (uClibc) only the
+ * interrupted pc/lr are recorded. The report is built in a static buffer and
+ * written to a file opened at init, so a stall caused by a full heap or a
+ * hung filesystem open still gets one. With stallUsec + feedUsec less than
+ * WATCHDOG_TIMEOUT_SEC it is on disk before the device resets the board. If
+ * the stall clears feeding resumes and the next stall writes a new report.
+ *
+ * Any file can stand in for the device: feeds are a 'k' written to it and a
+ * clean stop writes the magic 'V' so a real device is disarmed. The timeout
+ * ioctl failing on something that isn't a watchdog is only a warning.
+ *
+ ************************************************************************************
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include <stdint.h>
+#include <signal.h>
+#include <mqueue.h>
+#include "packet.h"
+#include "healthSnapshot.h"
+
+#define WATCHDOG_DEVICE             "/dev/watchdog"
+#define WATCHDOG_FORENSICS_FILE     "/usr/bin/stall.txt"
+#define WATCHDOG_TIMEOUT_SEC        (10)
+#define WATCHDOG_FEED_USEC          (1000000)
+#define WATCHDOG_SIGNAL             (SIGRTMAX - 1)      /* above the SIGRTMIN + ProcessId_e kill signals */
+#define WATCHDOG_FORENSICS_SIZE     (16384)
+#define WATCHDOG_TRACE_DEPTH        (24)
+#define WATCHDOG_TRACE_WAIT_USEC    (200000)            /* for a signalled thread to record its trace */
+#define WATCHDOG_MAIN_STALLED       (1UL << 31)         /* in a stalled mask, main didn't check in */
+
+typedef struct {
+    int deviceFd;                       /* -1 if not feeding a device */
+    int forensicsFd;                    /* -1 if reports are only printed */
+    int epollFd;
+    int timerFd;                        /* timerfd, every feedUsec */
+    int stopFd;                         /* eventfd, written by watchdog_stop() */
+    uint32_t requiredMask;              /* bit (1 << ProcessId_e) per thread that must stay fresh */
+    uint32_t stallUsec;                 /* longest wait for main or a required thread */
+    uint32_t feedUsec;
+    uint8_t numQueues;                  /* queues reported, indexed by SnapshotQueue_e */
+    mqd_t queues[SNAPSHOT_QUEUE_END];
+    uint32_t stalled;                   /* stalled mask of the current stall, 0 if none */
+    uint32_t feeds;
+    uint32_t stalls;                    /* reports written */
+} Watchdog_t;
+
+/**
+ * @brief open the device and forensics file and install the backtrace signal
+ * handler; main's checkin clock starts now
+ *
+ * @param pDog watchdog to initialize
+ * @param pDevice watchdog device (arms it), NULL to only detect and report stalls
+ * @param pForensics report file, NULL to only print reports
+ * @param requiredMask threads that must keep publishing heartbeats
+ * @param stallUsec HEALTH_DEADLINE_USEC normally
+ * @param pQueues queues whose depths are reported, SNAPSHOT_QUEUE_END of them; may be NULL
+ * @return int8_t EXIT_SUCCESS / EXIT_FAILURE
+ */
+int8_t watchdog_init(Watchdog_t *pDog, const char *pDevice, const char *pForensics,
+                     uint32_t requiredMask, uint32_t stallUsec, mqd_t *pQueues);
+
+/**
+ * @brief main's loop is alive; call once a loop from the thread to backtrace
+ * if it stops
+ */
+void watchdog_checkin(void);
+
+/**
+ * @brief what is stalled right now
+ *
+ * @param pDog watchdog
+ * @return uint32_t stalled required thread bits, WATCHDOG_MAIN_STALLED if main; 0 if none
+ */
+uint32_t watchdog_check(Watchdog_t *pDog);
+
+/**
+ * @brief feed or report every feedUsec until watchdog_stop(), then disarm
+ * the device
+ *
+ * @param pArg pointer to Watchdog_t from watchdog_init()
+ * @return void* NULL
+ */
+void *watchdogThreadHandler(void *pArg);
+
+/**
+ * @brief tell the watchdog thread to exit; call before shutting threads
+ * down so their going quiet isn't reported as a stall
+ *
+ * @param pDog running watchdog
+ */
+void watchdog_stop(Watchdog_t *pDog);
+
+#endif /* WATCHDOG_H_ */
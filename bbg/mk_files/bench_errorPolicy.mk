@@ -0,0 +1,17 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 9, 2019
+#*****************************************************************************
+# @file bench_errorPolicy.mk
+# @brief error arbitration cost, arbitor switch chains vs policy table
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/bench_errorPolicy.c \
+        src/errorPolicy.c
+
+PLATFORM = LINUX
@@ -0,0 +1,28 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 6, 2019
+#*****************************************************************************
+# @file bench_health.mk
+# @brief health monitor benchmarks (heartbeat queue vs shared memory table)
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/bench_health.c \
+        src/healthMonitor.c \
+        src/errorPolicy.c \
+        src/heartbeat.c \
+        src/histogram.c \
+        src/supervisor.c \
+        src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
@@ -0,0 +1,28 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date April 28, 2019
+#*****************************************************************************
+# @file bench_logger.mk
+# @brief logger benchmarks (queue backends, writer, formats)
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/bench_logger.c \
+        src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_lz.c \
+        src/logger_reader.c \
+        src/logger_segment.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
@@ -0,0 +1,34 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 16, 2019
+#*****************************************************************************
+# @file bench_mux.mk
+# @brief cmd latency under a log flood, a connection per port vs one mux connection
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/bench_mux.c \
+        unittest/bench_server.c \
+        src/remoteServer.c \
+        src/nodeTable.c \
+        src/telemetrySeq.c \
+        src/remoteFrame.c \
+        src/bufPool.c \
+        src/logger_ref.c \
+        src/statusSummary.c \
+        src/cmn_timer.c \
+        src/heartbeat.c \
+        src/histogram.c \
+        src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
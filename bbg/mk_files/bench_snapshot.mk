@@ -0,0 +1,19 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 10, 2019
+#*****************************************************************************
+# @file bench_snapshot.mk
+# @brief load test of the health snapshot socket
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/bench_snapshot.c \
+        src/healthSnapshot.c \
+        src/heartbeat.c \
+        src/histogram.c
+
+PLATFORM = LINUX
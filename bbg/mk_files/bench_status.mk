@@ -0,0 +1,21 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 9, 2019
+#*****************************************************************************
+# @file bench_status.mk
+# @brief status link load with and without heartbeat coalescing
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/bench_status.c \
+        src/statusSummary.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
@@ -11,5 +11,7 @@
 #*****************************************************************************
 
 # source files
-SRCS += src/remoteCmdClient.c
+SRCS += src/remoteCmdClient.c \
+        src/remoteFrame.c \
+        src/crc.c
 PLATFORM=LINUX
@@ -11,5 +11,7 @@
 #*****************************************************************************
 
 # source files
-SRCS += src/remoteDataClient.c
+SRCS += src/remoteDataClient.c \
+        src/remoteFrame.c \
+        src/crc.c
 PLATFORM=LINUX
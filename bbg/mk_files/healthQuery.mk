@@ -0,0 +1,19 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 10, 2019
+#*****************************************************************************
+# @file healthQuery.mk
+# @brief print health snapshots from a running main
+#
+#*****************************************************************************
+
+# source files
+SRCS += src/healthQuery.c \
+        src/healthSnapshot.c \
+        src/heartbeat.c \
+        src/histogram.c
+
+PLATFORM = LINUX
@@ -0,0 +1,23 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 5, 2019
+#*****************************************************************************
+# @file logQuery.mk
+# @brief query a log file by time, msg type, process or source via its index
+#
+#*****************************************************************************
+
+# source files
+SRCS += src/logQuery.c \
+        src/logger_segment.c \
+        src/logger_reader.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_lz.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/conversion.c \
+        src/memory.c
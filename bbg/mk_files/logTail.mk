@@ -0,0 +1,23 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 2, 2019
+#*****************************************************************************
+# @file logTail.mk
+# @brief print / follow the newest log segment while the logger runs
+#
+#*****************************************************************************
+
+# source files
+SRCS += src/logTail.c \
+        src/logger_segment.c \
+        src/logger_reader.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_lz.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/conversion.c \
+        src/memory.c
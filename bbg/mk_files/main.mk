@@ -16,16 +16,37 @@ SRCS += src/tempSensor.c \
         src/loggingThread.c \
         src/remoteLogThread.c \
         src/remoteStatusThread.c \
+        src/statusSummary.c \
         src/remoteDataThread.c \
         src/remoteCmdThread.c \
+        src/remoteServer.c \
+        src/nodeTable.c \
+        src/telemetrySeq.c \
+        src/remoteFrame.c \
+        src/bufPool.c \
+        src/logger_ref.c \
         src/lu_iic.c \
         src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_reader.c \
+        src/logger_lz.c \
+        src/logger_segment.c \
         src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
         src/memory.c \
         src/conversion.c \
         src/bbgLeds.c \
         src/cmn_timer.c \
         src/main.c \
-        src/healthMonitor.c
+        src/healthMonitor.c \
+        src/healthSnapshot.c \
+        src/watchdog.c \
+        src/errorPolicy.c \
+        src/heartbeat.c \
+        src/histogram.c \
+        src/supervisor.c
 
 PLATFORM = BBG
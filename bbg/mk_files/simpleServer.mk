@@ -11,5 +11,6 @@
 #*****************************************************************************
 
 # source files
-SRCS += src/simpleServer.c
+SRCS += src/simpleServer.c \
+        src/errorPolicy.c
 PLATFORM=LINUX
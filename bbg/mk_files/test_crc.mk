@@ -0,0 +1,25 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 4, 2019
+#*****************************************************************************
+# @file test_crc.mk
+# @brief unit tests for CRC-32C and log record checksums
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_crc.c \
+        src/crc.c \
+        src/logger_reader.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_lz.c \
+        src/logger_segment.c \
+        src/logger_helper.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
@@ -0,0 +1,17 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 9, 2019
+#*****************************************************************************
+# @file test_errorPolicy.mk
+# @brief error policy config tests
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_errorPolicy.c \
+        src/errorPolicy.c
+
+PLATFORM = LINUX
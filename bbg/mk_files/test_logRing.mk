@@ -0,0 +1,22 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 18, 2019
+#*****************************************************************************
+# @file test_logRing.mk
+# @brief unit tests for ring logger rings reused across producer threads
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_logRing.c \
+        src/logger_ring.c \
+        src/logger_queue.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
@@ -0,0 +1,26 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 2, 2019
+#*****************************************************************************
+# @file test_logSegment.mk
+# @brief unit tests for mmap'd log segments: kill mid-write, rotation, retention
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_logSegment.c \
+        src/logger_segment.c \
+        src/logger_reader.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_lz.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
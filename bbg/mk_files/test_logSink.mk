@@ -0,0 +1,24 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 18, 2019
+#*****************************************************************************
+# @file test_logSink.mk
+# @brief unit tests for log sink appends to existing files
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_logSink.c \
+        src/crc.c \
+        src/logger_reader.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_lz.c \
+        src/logger_helper.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
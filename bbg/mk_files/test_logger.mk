@@ -13,8 +13,20 @@
 # source files
 SRCS += unittest/test_logger.c \
         src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_reader.c \
+        src/logger_lz.c \
+        src/logger_segment.c \
         src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
         src/loggingThread.c \
+        src/logger_ref.c \
+        src/bufPool.c \
+        src/heartbeat.c \
+        src/histogram.c \
         src/memory.c \
         src/conversion.c \
         src/cmn_timer.c
@@ -0,0 +1,18 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 14, 2019
+#*****************************************************************************
+# @file test_remoteFrame.mk
+# @brief unit tests for remote link framing and reassembly
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_remoteFrame.c \
+        src/remoteFrame.c \
+        src/crc.c
+
+PLATFORM = LINUX
@@ -0,0 +1,28 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 8, 2019
+#*****************************************************************************
+# @file test_supervisor.mk
+# @brief fault injection tests for the thread supervisor
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_supervisor.c \
+        src/supervisor.c \
+        src/remoteDataThread.c \
+        src/cmn_timer.c \
+        src/heartbeat.c \
+        src/histogram.c \
+        src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
@@ -17,7 +17,15 @@ SRCS += unittest/test_tempThread.c \
         src/tempThread.c \
         src/cmn_timer.c \
         src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_sink.c \
+        src/logger_index.c \
+        src/logger_reader.c \
+        src/logger_lz.c \
+        src/logger_segment.c \
         src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
         src/memory.c \
         src/conversion.c \
         src/remoteThread.c \
@@ -26,4 +34,10 @@ SRCS += unittest/test_tempThread.c \
         src/tempSensor.c \
         src/lightSensor.c \
         src/loggingThread.c \
-        src/healthMonitor.c
+        src/logger_ref.c \
+        src/bufPool.c \
+        src/healthMonitor.c \
+        src/errorPolicy.c \
+        src/heartbeat.c \
+        src/histogram.c \
+        src/supervisor.c
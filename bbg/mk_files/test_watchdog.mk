@@ -0,0 +1,27 @@
+#*****************************************************************************
+# @author Joshua Malburg
+# joshua.malburg@colorado.edu
+# Advanced Embedded Software Development
+# ECEN5013-002 - Rick Heidebrecht
+# @date May 11, 2019
+#*****************************************************************************
+# @file test_watchdog.mk
+# @brief watchdog feeding and stall reports against a simulated device
+#
+#*****************************************************************************
+
+# source files
+SRCS += unittest/test_watchdog.c \
+        src/watchdog.c \
+        src/supervisor.c \
+        src/heartbeat.c \
+        src/histogram.c \
+        src/logger_queue.c \
+        src/logger_ring.c \
+        src/logger_helper.c \
+        src/crc.c \
+        src/logger_filter.c \
+        src/conversion.c \
+        src/memory.c
+
+PLATFORM = LINUX
@@ -11,10 +11,17 @@
 # @file log_parser.py
 # @brief parse binary log file from projet #1; use python3
 #
+# usage: log_parser.py [logfile]   (default log.bin); legacy and compact
+# (logger_format.h) files, compressed files of either and log segments
+# (logger_segment.h) are all accepted, format is detected from the first
+# bytes of the file
+#
 #*****************************************************************************
 
 from enum import IntEnum
+import io
 import struct
+import sys
 
 DEBUG = False
 
@@ -30,6 +37,36 @@ FIELD_SZ_MAX_PAYLOAD = 12
 FIELD_SZ_MAX_PAYLOAD = 0
 FIELD_SZ_MAX_CHECKSUM = 12
 
+# compact format, see logger_format.h
+COMPACT_MAGIC = b'BLOG'
+COMPACT_TAG_STRING = b'S'
+COMPACT_TAG_RECORD = b'R'
+COMPACT_STR_HDR = struct.Struct("<cxHH")
+COMPACT_REC_HDR = struct.Struct("<cBHHHIIHxx")
+
+# log segment header, see logger_segment.h; only the committed bytes
+# between header and used offset are records
+SEGMENT_MAGIC = b'BSEG'
+SEGMENT_HDR = struct.Struct("<4sHHIII")
+
+# compressed log blocks, see logger_format.h and logger_lz.h
+BLOCK_MAGIC = b'BLZB'
+BLOCK_HDR = struct.Struct("<4sIII")
+LZ_MIN_MATCH = 4
+
+# record checksum is CRC-32C, see crc.h and log_calc_checksum(); compact
+# sessions before version 2 carry the old byte sum and aren't checked, legacy
+# files written before then can't say so and either is taken
+COMPACT_VERSION_CRC = 2
+CHECKSUM_FIELDS = struct.Struct("<BHHIH")
+CRC32C_POLY = 0x82F63B78
+CRC32C_TABLE = []
+for _byte in range(256):
+    _crc = _byte
+    for _ in range(8):
+        _crc = (_crc >> 1) ^ CRC32C_POLY if _crc & 1 else _crc >> 1
+    CRC32C_TABLE.append(_crc)
+
 
 class parseState_e(IntEnum):
     FIND_START_FRAME_BYTE = 0
@@ -97,8 +134,11 @@ class LogItem:
     time = 0
     payloadLength = 0
     payload = "TBD"
+    rawPayload = b''
     sourceId = 0
     checksum = 0
+    verify = True
+    legacy = False
 
 class LogEvent_e(IntEnum):
     LOG_EVENT_STARTED = 0
@@ -243,6 +283,7 @@ def clear_log_item(my_log_item):
     my_log_item.time = 0
     my_log_item.payloadLength = 0
     my_log_item.payload = "TBD"
+    my_log_item.rawPayload = b''
     my_log_item.checksum = 0
 
 
@@ -260,18 +301,32 @@ def print_state(state):
     print(state)
 
 
-def verify_checksum(item):
-
-    chksum = item.eventId + item.lineNum \
-        + item.payloadLength + item.time
-
-    for char in item.filename:
-        chksum += ord(char)
+def crc32c(data, crc=0):
+    crc ^= 0xFFFFFFFF
+    for byte in data:
+        crc = CRC32C_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8)
+    return crc ^ 0xFFFFFFFF
 
-    for i in range(0, item.payloadLength):
-        chksum += ord(item.payload([i]))
 
-    return chksum == item.checksum
+def verify_checksum(item):
+    if not item.verify:
+        return True
+    # same field order and widths as log_calc_checksum()
+    data = item.filename.encode('ASCII')
+    data += CHECKSUM_FIELDS.pack(item.eventId, item.lineNum & 0xFFFF,
+                                 item.sourceId & 0xFFFF, item.time & 0xFFFFFFFF,
+                                 item.payloadLength)
+    data += item.rawPayload
+    if crc32c(data) == item.checksum:
+        return True
+    return item.legacy and byte_sum(item) == item.checksum
+
+
+def byte_sum(item):
+    # same as log_calc_byte_sum()
+    total = item.eventId + item.lineNum + item.time + item.payloadLength + item.sourceId
+    total += sum(item.filename.encode('ASCII')) + sum(item.rawPayload)
+    return total & 0xFFFFFFFF
 
 
 def print_source(item):
@@ -325,9 +380,9 @@ def print_message(item):
 
 def print_log_item(item):
 
-#    if not verify_checksum(item):
-#        print("ERROR - checksum invalid")
-#    else:
+    if not verify_checksum(item):
+        print("ERROR - checksum invalid")
+    else:
         print_file_location(item)
         print_tid(item)
         print_time(item)
@@ -335,13 +390,127 @@ def print_log_item(item):
         print_message(item)
 
 
+def lz_length(data, pos, length):
+    # nibble of 15 continues in extra bytes, until one below 255
+    if length == 15:
+        while True:
+            extra = data[pos]
+            pos += 1
+            length += extra
+            if extra != 255:
+                break
+    return length, pos
+
+
+def lz_decompress(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        token = data[pos]
+        pos += 1
+        length, pos = lz_length(data, pos, token >> 4)
+        out += data[pos:pos + length]
+        pos += length
+        if pos >= len(data):
+            break
+        (offset,) = struct.unpack_from("<H", data, pos)
+        pos += 2
+        length, pos = lz_length(data, pos, token & 15)
+        # byte at a time, a match may overlap what it produces
+        start = len(out) - offset
+        for i in range(length + LZ_MIN_MATCH):
+            out.append(out[start + i])
+    return bytes(out)
+
+
+def decompress_blocks(data):
+    out = bytearray()
+    pos = 0
+    while pos + BLOCK_HDR.size <= len(data):
+        (magic, rawLen, compLen, _) = BLOCK_HDR.unpack_from(data, pos)
+        storedLen = compLen if compLen != 0 else rawLen
+        body = data[pos + BLOCK_HDR.size:pos + BLOCK_HDR.size + storedLen]
+        if magic != BLOCK_MAGIC or len(body) < storedLen:
+            # corrupt or cut short, resync on the next block
+            nextBlock = data.find(BLOCK_MAGIC, pos + 1)
+            if nextBlock < 0:
+                break
+            pos = nextBlock
+            continue
+        try:
+            out += lz_decompress(body) if compLen != 0 else body
+        except IndexError:
+            pass
+        pos += BLOCK_HDR.size + storedLen
+    return bytes(out)
+
+
+def parse_compact(log_file):
+    strings = {}
+    verify = False
+    data = log_file.read()
+    pos = 0
+    while pos < len(data):
+        tag = data[pos:pos + 1]
+        if tag == COMPACT_MAGIC[0:1] and data[pos:pos + 4] == COMPACT_MAGIC:
+            # new session, string IDs start over
+            (version, hdrSize) = struct.unpack_from("<HH", data, pos + 4)
+            strings = {}
+            verify = version >= COMPACT_VERSION_CRC
+            pos += hdrSize
+        elif tag == COMPACT_TAG_STRING:
+            (_, strId, strLen) = COMPACT_STR_HDR.unpack_from(data, pos)
+            pos += COMPACT_STR_HDR.size
+            strings[strId] = data[pos:pos + strLen].decode('ASCII')
+            pos += strLen
+        elif tag == COMPACT_TAG_RECORD:
+            (_, eventId, fileId, lineNum, sourceId, time, checksum,
+             payloadLength) = COMPACT_REC_HDR.unpack_from(data, pos)
+            pos += COMPACT_REC_HDR.size
+            item = LogItem()
+            item.eventId = logMsg_e(eventId)
+            item.filename = strings.get(fileId, "?")
+            item.lineNum = lineNum
+            item.time = time
+            item.payloadLength = payloadLength
+            item.rawPayload = data[pos:pos + payloadLength]
+            item.payload = item.rawPayload.split(b'\0')[0].decode('ASCII')
+            item.sourceId = sourceId
+            item.checksum = checksum
+            item.verify = verify
+            pos += payloadLength
+            print_log_item(item)
+        else:
+            # corrupt entry, resync on next tag byte
+            pos += 1
+
+
 print("Parsing log file...\n.\n.\n.")
 
-log_file = open("log.bin", "rb")
+log_file = open(sys.argv[1] if len(sys.argv) > 1 else "log.bin", "rb")
+
+if log_file.read(len(SEGMENT_MAGIC)) == SEGMENT_MAGIC:
+    log_file.seek(0)
+    (_, _, hdrSize, seq, _, used) = SEGMENT_HDR.unpack(log_file.read(SEGMENT_HDR.size))
+    log_file.seek(hdrSize)
+    log_file = io.BytesIO(log_file.read(used - hdrSize))
+log_file.seek(0)
+
+if log_file.read(len(BLOCK_MAGIC)) == BLOCK_MAGIC:
+    log_file.seek(0)
+    log_file = io.BytesIO(decompress_blocks(log_file.read()))
+log_file.seek(0)
 
 parseState = parseState_e.FIND_START_FRAME_BYTE
+if log_file.read(len(COMPACT_MAGIC)) == COMPACT_MAGIC:
+    log_file.seek(0)
+    parse_compact(log_file)
+    parseState = parseState_e.PARSE_DONE
+log_file.seek(0)
+
 myStr = ""
 myLogItem = LogItem()
+myLogItem.legacy = True
 while parseState != parseState_e.PARSE_DONE:
 
     if parseState == parseState_e.FIND_START_FRAME_BYTE:
@@ -450,7 +619,9 @@ while parseState != parseState_e.PARSE_DONE:
                 myLogItem.payload = payLoadStr
 
             else:
-                myStr = read_string(log_file)
+                # exactly the bytes written, the checksum covers all of them
+                myLogItem.rawPayload = log_file.read(myLogItem.payloadLength)
+                myStr = myLogItem.rawPayload.split(b'\0')[0].decode('ASCII')
 
                 if DEBUG:
                     print_state(parseState)
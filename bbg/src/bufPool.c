@@ -0,0 +1,95 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 17, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bufPool.c
+ * @brief fixed pool of reference counted receive buffers
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bufPool.h"
+
+/*---------------------------------------------------------------------------------*/
+int8_t buf_pool_init(BufPool_t *pPool, PoolBuf_t *pBufs, uint32_t count)
+{
+    uint32_t ind;
+
+    if((pPool == NULL) || (pBufs == NULL) || (count == 0))
+        return EXIT_FAILURE;
+
+    memset(pPool, 0, sizeof(BufPool_t));
+    if(pthread_mutex_init(&pPool->lock, NULL) != 0)
+        return EXIT_FAILURE;
+    for(ind = 0; ind < count; ++ind)
+    {
+        pBufs[ind].refs = 0;
+        pBufs[ind].pPool = pPool;
+        pBufs[ind].pNext = (ind + 1 < count) ? &pBufs[ind + 1] : NULL;
+    }
+    pPool->pFree = pBufs;
+    pPool->count = count;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+PoolBuf_t *buf_pool_alloc(BufPool_t *pPool)
+{
+    PoolBuf_t *pBuf;
+
+    pthread_mutex_lock(&pPool->lock);
+    pBuf = pPool->pFree;
+    if(pBuf != NULL) {
+        pPool->pFree = pBuf->pNext;
+        if(++pPool->inUse > pPool->maxInUse)
+            pPool->maxInUse = pPool->inUse;
+    }
+    else {
+        ++pPool->allocFails;
+    }
+    pthread_mutex_unlock(&pPool->lock);
+
+    if(pBuf != NULL)
+        __atomic_store_n(&pBuf->refs, 1, __ATOMIC_RELAXED);
+    return pBuf;
+}
+
+/*---------------------------------------------------------------------------------*/
+void buf_pool_ref(PoolBuf_t *pBuf)
+{
+    __atomic_add_fetch(&pBuf->refs, 1, __ATOMIC_RELAXED);
+}
+
+/*---------------------------------------------------------------------------------*/
+void buf_pool_release(PoolBuf_t *pBuf)
+{
+    BufPool_t *pPool = pBuf->pPool;
+
+    /* whoever drops the last reference has seen every write to it */
+    if(__atomic_sub_fetch(&pBuf->refs, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+
+    pthread_mutex_lock(&pPool->lock);
+    pBuf->pNext = pPool->pFree;
+    pPool->pFree = pBuf;
+    --pPool->inUse;
+    pthread_mutex_unlock(&pPool->lock);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t buf_pool_shared(const PoolBuf_t *pBuf)
+{
+    return __atomic_load_n(&pBuf->refs, __ATOMIC_ACQUIRE) > 1;
+}
+
+/*---------------------------------------------------------------------------------*/
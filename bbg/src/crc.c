@@ -0,0 +1,236 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 4, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file crc.c
+ * @brief CRC-32C, slicing-by-8 with hardware instruction paths
+ *
+ ************************************************************************************
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "crc.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    #include <nmmintrin.h>
+    #define CRC_HW_X86
+#elif defined(__ARM_FEATURE_CRC32)
+    #include <arm_acle.h>
+    #define CRC_HW_ARM
+#endif
+
+#define CRC32C_POLY             (0x82F63B78UL)  /* reflected */
+
+#ifdef __linux__
+    #define CRC_LOAD(var)           __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+    #define CRC_STORE(var, value)   __atomic_store_n(&(var), (value), __ATOMIC_RELEASE)
+#else
+    /* TIVA only checksums from the remote task */
+    #define CRC_LOAD(var)           (var)
+    #define CRC_STORE(var, value)   ((var) = (value))
+#endif
+
+typedef uint32_t (*crcUpdateFunc_t)(uint32_t crc, const uint8_t *pData, uint32_t len);
+
+/*---------------------------------------------------------------------------------*/
+/* crcTables[k][b] is the crc of byte b followed by k zero bytes; built on
+ * first use and published by tablesReady */
+static uint32_t crcTables[8][256];
+static uint8_t tablesReady;
+static crcUpdateFunc_t crcUpdateFunc;
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static void crc_init_tables(void);
+static uint32_t crc32c_update_first(uint32_t crc, const uint8_t *pData, uint32_t len);
+#ifdef CRC_HW_X86
+static uint32_t crc32c_update_x86(uint32_t crc, const uint8_t *pData, uint32_t len);
+#endif
+#ifdef CRC_HW_ARM
+static uint32_t crc32c_update_arm(uint32_t crc, const uint8_t *pData, uint32_t len);
+#endif
+
+/*---------------------------------------------------------------------------------*/
+uint32_t crc32c_update(uint32_t crc, const uint8_t *pData, uint32_t len)
+{
+    crcUpdateFunc_t func = CRC_LOAD(crcUpdateFunc);
+
+    if(func == NULL)
+        func = crc32c_update_first;
+    return func(crc, pData, len);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t crc32c(const uint8_t *pData, uint32_t len)
+{
+    return crc32c_finish(crc32c_update(CRC32C_INIT, pData, len));
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t crc32c_update_sw(uint32_t crc, const uint8_t *pData, uint32_t len)
+{
+    uint32_t lo, hi;
+
+    if(CRC_LOAD(tablesReady) == 0)
+        crc_init_tables();
+
+    /* byte at a time up to 4 byte alignment */
+    while((len > 0) && (((uintptr_t)pData & 3) != 0)) {
+        crc = crcTables[0][(crc ^ *pData++) & 0xFF] ^ (crc >> 8);
+        --len;
+    }
+
+    /* 8 bytes per step, one lookup per byte from independent tables
+     * (little-endian loads, the tables assume LSB first) */
+    while(len >= 8) {
+        memcpy(&lo, pData, sizeof(lo));
+        memcpy(&hi, pData + 4, sizeof(hi));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc = crcTables[7][lo & 0xFF] ^ crcTables[6][(lo >> 8) & 0xFF] ^
+              crcTables[5][(lo >> 16) & 0xFF] ^ crcTables[4][lo >> 24] ^
+              crcTables[3][hi & 0xFF] ^ crcTables[2][(hi >> 8) & 0xFF] ^
+              crcTables[1][(hi >> 16) & 0xFF] ^ crcTables[0][hi >> 24];
+        pData += 8;
+        len -= 8;
+    }
+
+    while(len > 0) {
+        crc = crcTables[0][(crc ^ *pData++) & 0xFF] ^ (crc >> 8);
+        --len;
+    }
+    return crc;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t crc32c_update_bytewise(uint32_t crc, const uint8_t *pData, uint32_t len)
+{
+    if(CRC_LOAD(tablesReady) == 0)
+        crc_init_tables();
+
+    while(len > 0) {
+        crc = crcTables[0][(crc ^ *pData++) & 0xFF] ^ (crc >> 8);
+        --len;
+    }
+    return crc;
+}
+
+/*---------------------------------------------------------------------------------*/
+const char *crc32c_impl(void)
+{
+    crc32c_update(CRC32C_INIT, NULL, 0);
+#ifdef CRC_HW_X86
+    if(crcUpdateFunc == crc32c_update_x86)
+        return "sse4.2";
+#endif
+#ifdef CRC_HW_ARM
+    if(crcUpdateFunc == crc32c_update_arm)
+        return "armv8";
+#endif
+    return "slice8";
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief slicing tables; racing threads compute and store the same values
+ */
+static void crc_init_tables(void)
+{
+    uint32_t crc, ind, bit, k;
+
+    for(ind = 0; ind < 256; ++ind) {
+        crc = ind;
+        for(bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? ((crc >> 1) ^ CRC32C_POLY) : (crc >> 1);
+        crcTables[0][ind] = crc;
+    }
+    for(ind = 0; ind < 256; ++ind) {
+        crc = crcTables[0][ind];
+        for(k = 1; k < 8; ++k) {
+            crc = crcTables[0][crc & 0xFF] ^ (crc >> 8);
+            crcTables[k][ind] = crc;
+        }
+    }
+    CRC_STORE(tablesReady, 1);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief pick an implementation on the first call, then run it
+ */
+static uint32_t crc32c_update_first(uint32_t crc, const uint8_t *pData, uint32_t len)
+{
+    crcUpdateFunc_t func = crc32c_update_sw;
+
+#ifdef CRC_HW_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.2"))
+        func = crc32c_update_x86;
+#endif
+#ifdef CRC_HW_ARM
+    func = crc32c_update_arm;
+#endif
+    CRC_STORE(crcUpdateFunc, func);
+    return func(crc, pData, len);
+}
+
+/*---------------------------------------------------------------------------------*/
+#ifdef CRC_HW_X86
+/**
+ * @brief SSE4.2 crc32 instruction, 8 bytes at a time
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_update_x86(uint32_t crc, const uint8_t *pData, uint32_t len)
+{
+    uint64_t crc64 = crc, value;
+
+    while(len >= 8) {
+        memcpy(&value, pData, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+        pData += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)crc64;
+    while(len > 0) {
+        crc = _mm_crc32_u8(crc, *pData++);
+        --len;
+    }
+    return crc;
+}
+#endif
+
+/*---------------------------------------------------------------------------------*/
+#ifdef CRC_HW_ARM
+/**
+ * @brief ARMv8 crc32c instructions, only built when the target has them
+ */
+static uint32_t crc32c_update_arm(uint32_t crc, const uint8_t *pData, uint32_t len)
+{
+    uint32_t value;
+
+    while(len >= 4) {
+        memcpy(&value, pData, sizeof(value));
+        crc = __crc32cw(crc, value);
+        pData += 4;
+        len -= 4;
+    }
+    while(len > 0) {
+        crc = __crc32cb(crc, *pData++);
+        --len;
+    }
+    return crc;
+}
+#endif
+
+/*---------------------------------------------------------------------------------*/
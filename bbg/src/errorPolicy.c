@@ -0,0 +1,233 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 9, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file errorPolicy.c
+ * @brief course of action for each thread's error codes, by table lookup
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "errorPolicy.h"
+#include "healthMonitor.h"
+#include "my_debug.h"
+
+#define POLICY_LINE_LEN     (128)
+
+typedef enum {
+    DESC_NONE = 0,
+    DESC_NOTIFY,
+    DESC_TIMEOUT,
+    DESC_RESTARTTHREAD,
+    DESC_TERMTHREAD,
+    DESC_TERMALL,
+    DESC_OTHER,
+    DESC_END
+} PolicyDesc_e;
+
+/* 2 bytes an entry, the whole table is under 8 KB */
+typedef struct {
+    uint8_t action;     /* MainAction_e */
+    uint8_t desc;       /* PolicyDesc_e */
+} ErrorPolicy_t;
+
+static const char * const descStrings[DESC_END] = {
+    "NONE", "NOTIFY", "TIMEOUT", "RESTARTTHREAD", "TERMTHREAD", "TERMALL", "OTHER"
+};
+
+/* indexed by MainAction_e, for actions set from the config file */
+static const struct {
+    const char *pName;
+    PolicyDesc_e desc;
+} actionNames[MAIN_ACTION_END] = {
+    [MAIN_ACTION_NONE]              = {"NONE", DESC_NONE},
+    [MAIN_ACTION_NOTIFY_USER_ONLY]  = {"NOTIFY", DESC_NOTIFY},
+    [MAIN_ACTION_RESTART_THREAD]    = {"RESTARTTHREAD", DESC_RESTARTTHREAD},
+    [MAIN_ACTION_TERMINATE_THREAD]  = {"TERMTHREAD", DESC_TERMTHREAD},
+    [MAIN_ACTION_TERMINATE_ALL]     = {"TERMALL", DESC_TERMALL},
+};
+
+#define POLICY(act, dsc)    {(uint8_t)(act), (uint8_t)(dsc)}
+
+/* anything not listed, including codes below the user range, terminates all */
+#define ARBITRATED_ROW {\
+    [0 ... ERROR_CODE_END] = POLICY(MAIN_ACTION_TERMINATE_ALL, DESC_OTHER),\
+    [ERROR_CODE_TIMEOUT] = POLICY(MAIN_ACTION_NOTIFY_USER_ONLY, DESC_TIMEOUT),\
+    [ERROR_CODE_USER_NONE0 ... ERROR_CODE_USER_NONE7] = POLICY(MAIN_ACTION_NONE, DESC_NONE),\
+    [ERROR_CODE_USER_NOTIFY0 ... ERROR_CODE_USER_NOTIFY7] = POLICY(MAIN_ACTION_NOTIFY_USER_ONLY, DESC_NOTIFY),\
+    [ERROR_CODE_USER_TERMTHREAD0 ... ERROR_CODE_USER_TERMTHREAD7] = POLICY(MAIN_ACTION_TERMINATE_THREAD, DESC_TERMTHREAD),\
+    [ERROR_CODE_USER_TERMALL0 ... ERROR_CODE_USER_TERMALL7] = POLICY(MAIN_ACTION_TERMINATE_ALL, DESC_TERMALL),\
+    [ERROR_CODE_USER_RESTARTTHREAD0 ... ERROR_CODE_USER_RESTARTTHREAD7] = POLICY(MAIN_ACTION_RESTART_THREAD, DESC_RESTARTTHREAD),\
+}
+
+/* client threads aren't arbitrated; their rows are all zero, MAIN_ACTION_NONE */
+#define DEFAULT_POLICY_TABLE {\
+    [PID_LOGGING] = ARBITRATED_ROW,\
+    [PID_REMOTE_CMD] = ARBITRATED_ROW,\
+    [PID_REMOTE_LOG] = ARBITRATED_ROW,\
+    [PID_REMOTE_STATUS] = ARBITRATED_ROW,\
+    [PID_REMOTE_DATA] = ARBITRATED_ROW,\
+    [PID_LIGHT] = ARBITRATED_ROW,\
+    [PID_MOISTURE] = ARBITRATED_ROW,\
+    [PID_OBSERVER] = ARBITRATED_ROW,\
+    [PID_SOLENOID] = ARBITRATED_ROW,\
+    [PID_TEMP] = ARBITRATED_ROW,\
+}
+
+static const ErrorPolicy_t defaultPolicy[PID_END][ERROR_POLICY_CODES] = DEFAULT_POLICY_TABLE;
+static ErrorPolicy_t policy[PID_END][ERROR_POLICY_CODES] = DEFAULT_POLICY_TABLE;
+
+static int8_t parseLine(char *pLine, uint32_t lineNum, const char *pFile);
+static int8_t parseRange(const char *pStr, uint32_t max, uint32_t *pLo, uint32_t *pHi);
+static int8_t parsePid(const char *pStr, uint32_t *pLo, uint32_t *pHi);
+
+/*---------------------------------------------------------------------------------*/
+void error_policy_reset(void)
+{
+    memcpy(policy, defaultPolicy, sizeof(policy));
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t error_policy_load(const char *pFile)
+{
+    char line[POLICY_LINE_LEN];
+    uint32_t lineNum = 0, applied = 0, bad = 0;
+    FILE *pConf;
+
+    pConf = fopen(pFile, "r");
+    if(pConf == NULL) {
+        ERRNO_PRINT("error_policy_load couldn't open config");
+        return EXIT_FAILURE;
+    }
+
+    while(fgets(line, sizeof(line), pConf) != NULL)
+    {
+        ++lineNum;
+        switch(parseLine(line, lineNum, pFile)) {
+            case 1:
+                ++applied;
+                break;
+            case -1:
+                ++bad;
+                break;
+            default:
+                break;
+        }
+    }
+    fclose(pConf);
+
+    INFO_PRINT("error policy: %u overrides from %s\n", applied, pFile);
+    return (bad == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+MainAction_e error_policy_action(ProcessId_e Id, uint8_t errorCode)
+{
+    if(Id >= PID_END)
+        return MAIN_ACTION_NONE;
+    return (MainAction_e)policy[Id][errorCode].action;
+}
+
+/*---------------------------------------------------------------------------------*/
+const char *error_policy_desc(ProcessId_e Id, uint8_t errorCode)
+{
+    if(Id >= PID_END)
+        return descStrings[DESC_NONE];
+    return descStrings[policy[Id][errorCode].desc];
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief apply one config line
+ *
+ * @return int8_t 1 if applied, 0 for a blank or comment line, -1 if bad
+ */
+static int8_t parseLine(char *pLine, uint32_t lineNum, const char *pFile)
+{
+    char *pSave, *pThread, *pCodes, *pAction;
+    uint32_t pidLo, pidHi, codeLo, codeHi, pid, code;
+    uint8_t action;
+
+    pThread = strtok_r(pLine, " \t\r\n", &pSave);
+    if((pThread == NULL) || (pThread[0] == '#'))
+        return 0;
+    pCodes = strtok_r(NULL, " \t\r\n", &pSave);
+    pAction = strtok_r(NULL, " \t\r\n", &pSave);
+
+    for(action = 0; (pAction != NULL) && (action < MAIN_ACTION_END); ++action)
+    {
+        if(strcmp(pAction, actionNames[action].pName) == 0)
+            break;
+    }
+
+    if((pCodes == NULL) || (pAction == NULL) || (action == MAIN_ACTION_END) ||
+       (parsePid(pThread, &pidLo, &pidHi) != EXIT_SUCCESS) ||
+       (parseRange(pCodes, ERROR_CODE_END, &codeLo, &codeHi) != EXIT_SUCCESS)) {
+        WARN_PRINT("%s:%u: expected <thread> <codes> <action>, line skipped\n", pFile, lineNum);
+        return -1;
+    }
+
+    for(pid = pidLo; pid <= pidHi; ++pid)
+    {
+        for(code = codeLo; code <= codeHi; ++code)
+        {
+            policy[pid][code].action = action;
+            policy[pid][code].desc = (uint8_t)actionNames[action].desc;
+        }
+    }
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int8_t parseRange(const char *pStr, uint32_t max, uint32_t *pLo, uint32_t *pHi)
+{
+    char *pEnd;
+
+    if(strcmp(pStr, "*") == 0) {
+        *pLo = 0;
+        *pHi = max;
+        return EXIT_SUCCESS;
+    }
+
+    *pLo = (uint32_t)strtoul(pStr, &pEnd, 0);
+    *pHi = *pLo;
+    if(*pEnd == '-')
+        *pHi = (uint32_t)strtoul(pEnd + 1, &pEnd, 0);
+    if((pEnd == pStr) || (*pEnd != '\0') || (*pLo > *pHi) || (*pHi > max))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int8_t parsePid(const char *pStr, uint32_t *pLo, uint32_t *pHi)
+{
+    uint32_t ind;
+
+    if(strcmp(pStr, "*") == 0) {
+        *pLo = 0;
+        *pHi = PID_END - 1;
+        return EXIT_SUCCESS;
+    }
+
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(strcmp(pStr, getPidString((ProcessId_e)ind)) == 0) {
+            *pLo = ind;
+            *pHi = ind;
+            return EXIT_SUCCESS;
+        }
+    }
+    return EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
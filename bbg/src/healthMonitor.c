@@ -20,6 +20,10 @@
 #include <signal.h>
 #include <unistd.h>
 #include <syscall.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 
 #include "my_debug.h"
 #include "packet.h"
@@ -30,19 +34,35 @@
 #include "lightThread.h"
 #include "remoteThread.h"
 #include "healthMonitor.h"
+#include "supervisor.h"
 #include "logger.h"
 
-#define THREAD_MISSING_COUNT        (3)
+LOG_REGISTER_FILE(LOG_FILE_BBG_HEALTH_MONITOR);
+
 #define STATUS_MSG_PROCESS_LIMIT    (NUM_THREADS * 20 + 1)   /* 2 is because main is 1/2 as fast as other loops */
+#define HEALTH_EPOLL_QUEUE          (PID_END)                /* epoll data of non timer fds */
+#define HEALTH_EPOLL_STOP           (PID_END + 1)
+#define HEALTH_EPOLL_STATS          (PID_END + 2)
+#define HEALTH_STATS_LOG_LOOPS      ((uint32_t)((HEALTH_STATS_LOG_SEC * 1e9) / MAIN_LOOP_TIME_NSEC))
+#define HEALTH_MAX_EVENTS           (8)
 
 /* private functions */
 int8_t getStatusMsg(mqd_t *pQueue, TaskStatusPacket *pPacket);
 MainAction_e callArbitor(TaskStatusPacket *pStatus);
-MainAction_e sensorErrorArbitor(TaskStatusPacket *pStatus);
-MainAction_e remoteErrorArbitor(TaskStatusPacket *pStatus);
-MainAction_e loggingErrorArbitor(TaskStatusPacket *pStatus);
 void processAction(ProcessId_e processId, MainAction_e action, uint8_t *pExit);
 int8_t threadKiller(ProcessId_e Id);
+static uint8_t isMonitored(uint8_t ind);
+static int8_t armDeadline(int timerFd, uint32_t usec);
+static void checkDeadline(HealthMonitor_t *pMon, ProcessId_e Id);
+static void readStatusEvents(HealthMonitor_t *pMon);
+static void closeMonitor(HealthMonitor_t *pMon);
+static void recordStatusMsg(TaskStatusPacket *pStatus);
+
+/* monitor side histograms, usec; heartbeat intervals come from the heartbeat
+ * table when there is one */
+static Histogram_t intervalHist[PID_END];
+static Histogram_t deliveryHist[PID_END];
+static uint32_t lastStatusTime[PID_END];
 
 void set_sig_handlers(void)
 {
@@ -80,28 +100,25 @@ void set_sig_handlers(void)
 int8_t monitorHealth(mqd_t * pQueue, uint8_t *pExit, uint8_t *newError)
 {
     TaskStatusPacket status;
+    HeartbeatSlot_t slot;
     MainAction_e action;
     static uint8_t threadMissingCount[PID_END + 1];     /* 1 is to provide slot for PID_END enum value */
+    static uint32_t lastSeq[PID_END];                   /* heartbeat seq seen last scan */
+    static uint32_t lastEvents = 0;
     uint8_t missingFlag[PID_END + 1];                   /* 1 is to provide slot for PID_END enum value */
     uint8_t ind, msgCount;
+    uint32_t events;
+    uint8_t readQueue = 1;
     struct mq_attr Attr;
     static uint8_t errorCount = 0;
     static uint8_t prevErrorCount;
+    static uint32_t statsLoops = 0;
     prevErrorCount = errorCount;
 
     if((pQueue == NULL) || (pExit == NULL) || (newError == NULL)) {
         return EXIT_FAILURE;
     }
-
-    /* check queue length diagonistics */
-    mq_getattr(*pQueue, &Attr);
-    MUTED_PRINT("hBQueue count:%ld\n", Attr.mq_curmsgs);
-    if(Attr.mq_curmsgs > ((STATUS_MSG_QUEUE_DEPTH * 3) / 4)) {
-      if(Attr.mq_curmsgs >= STATUS_MSG_QUEUE_DEPTH - 1) {
-        ERROR_PRINT("hBQueue full\n");
-      }
-      WARN_PRINT("hBQueue have 3/4 full \n");
-    }
+    memset(&status, 0, sizeof(struct TaskStatusPacket));
 
     /* set missing flags before looping on status queue;
      * there should be at least one message from each thread.
@@ -111,51 +128,84 @@ int8_t monitorHealth(mqd_t * pQueue, uint8_t *pExit, uint8_t *newError)
         missingFlag[ind] = 1;
     }
 
-    /* cycle through status messages */
-    msgCount = 0;
-    do
-    {
-        memset(&status, 0, sizeof(struct TaskStatusPacket));
-        
-        if(getStatusMsg(pQueue, &status) == EXIT_SUCCESS)
-        {
-            /* clear recvFlag so missing count doesn't increment */
-            missingFlag[status.processId] = 0;             
-            threadMissingCount[status.processId] = 0;
-
-            
-            /* skip threads not reporting status */
-            if((ind == PID_TEMP) || (ind == PID_REMOTE_CLIENT) ||
-            (ind == PID_REMOTE_CLIENT_CMD) || (ind == PID_REMOTE_CLIENT_LOG) || 
-            (ind == PID_REMOTE_CLIENT_STATUS) || (ind == PID_REMOTE_CLIENT_DATA)) {
+    /* threads publishing since last scan are alive */
+    if(heartbeat_active()) {
+        for(ind = 0; ind < PID_END; ++ind) {
+            if(heartbeat_read((ProcessId_e)ind, &slot) != EXIT_SUCCESS)
                 continue;
+            if(slot.seq != lastSeq[ind]) {
+                lastSeq[ind] = slot.seq;
+                missingFlag[ind] = 0;
+                threadMissingCount[ind] = 0;
             }
+        }
 
-            /* determine error course of action */
-            else if(status.processId != PID_END)
+        /* no status msgs queued since last time, nothing to act on */
+        events = heartbeat_events();
+        readQueue = (events != lastEvents);
+        lastEvents = events;
+    }
+
+    if(readQueue) {
+        /* check queue length diagonistics */
+        mq_getattr(*pQueue, &Attr);
+        MUTED_PRINT("hBQueue count:%ld\n", Attr.mq_curmsgs);
+        if(Attr.mq_curmsgs > ((STATUS_MSG_QUEUE_DEPTH * 3) / 4)) {
+          if(Attr.mq_curmsgs >= STATUS_MSG_QUEUE_DEPTH - 1) {
+            ERROR_PRINT("hBQueue full\n");
+          }
+          WARN_PRINT("hBQueue have 3/4 full \n");
+        }
+
+        /* cycle through status messages */
+        msgCount = 0;
+        do
+        {
+            memset(&status, 0, sizeof(struct TaskStatusPacket));
+        
+            if(getStatusMsg(pQueue, &status) == EXIT_SUCCESS)
             {
-                ++msgCount;
-                if(status.taskStatus == STATUS_ERROR)
+                recordStatusMsg(&status);
+
+                /* clear recvFlag so missing count doesn't increment */
+                missingFlag[status.processId] = 0;             
+                threadMissingCount[status.processId] = 0;
+
+            
+                /* skip threads not reporting status */
+                if((ind == PID_TEMP) || (ind == PID_REMOTE_CLIENT) ||
+                (ind == PID_REMOTE_CLIENT_CMD) || (ind == PID_REMOTE_CLIENT_LOG) || 
+                (ind == PID_REMOTE_CLIENT_STATUS) || (ind == PID_REMOTE_CLIENT_DATA)) {
+                    continue;
+                }
+
+                /* determine error course of action */
+                else if(status.processId != PID_END)
                 {
-                    action = callArbitor(&status);
-                    processAction(status.processId, action, pExit);
-                    ++errorCount;
+                    ++msgCount;
+                    if(status.taskStatus == STATUS_ERROR)
+                    {
+                        action = callArbitor(&status);
+                        processAction(status.processId, action, pExit);
+                        ++errorCount;
+                    }
                 }
+                if(msgCount > STATUS_MSG_PROCESS_LIMIT)
+                {
+                    ERROR_PRINT("Stopped processing status msgs, some how health monitor got behind\n");
+                    --lastEvents;       /* read the rest next time */
+                    break;
+                }                
             }
-            if(msgCount > STATUS_MSG_PROCESS_LIMIT)
-            {
-                ERROR_PRINT("Stopped processing status msgs, some how health monitor got behind\n");
-                break;
-            }                
-        }
-        if(*pExit == 0) {
-            INFO_PRINT("health monitor exiting, pExit: %d\n", *pExit);
-            if(prevErrorCount != errorCount) {
-                *newError = 1;
+            if(*pExit == 0) {
+                INFO_PRINT("health monitor exiting, pExit: %d\n", *pExit);
+                if(prevErrorCount != errorCount) {
+                    *newError = 1;
+                }
+                return EXIT_SUCCESS;
             }
-            return EXIT_SUCCESS;
-        }
-    } while (status.processId != PID_END);
+        } while (status.processId != PID_END);
+    }
 
     /* after we've processed all status messages, let's check the missing
      * count to see if we need to to set timeout error */
@@ -189,8 +239,330 @@ int8_t monitorHealth(mqd_t * pQueue, uint8_t *pExit, uint8_t *newError)
         *newError = 1;
         MUTED_PRINT("prevErrorCount: %d, errorCount: %d\n", prevErrorCount, errorCount);
     }
+
+    if(++statsLoops >= HEALTH_STATS_LOG_LOOPS) {
+        statsLoops = 0;
+        healthMonitorLogStats();
+    }
+    return EXIT_SUCCESS;
+}
+int8_t healthMonitorInit(HealthMonitor_t *pMon, mqd_t queue, uint8_t *pExit, uint32_t deadlineUsec)
+{
+    struct epoll_event event;
+    struct itimerspec statsSpec;
+    HeartbeatSlot_t slot;
+    uint8_t ind;
+
+    if((pMon == NULL) || (pExit == NULL) || !heartbeat_active()) {
+        return EXIT_FAILURE;
+    }
+    memset(pMon, 0, sizeof(HealthMonitor_t));
+    pMon->queue = queue;
+    pMon->pExit = pExit;
+    pMon->deadlineUsec = deadlineUsec;
+    pMon->stopFd = -1;
+    pMon->statsFd = -1;
+    for(ind = 0; ind < PID_END; ++ind) {
+        pMon->timerFds[ind] = -1;
+    }
+
+    pMon->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    pMon->stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    pMon->statsFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if((pMon->epollFd < 0) || (pMon->stopFd < 0) || (pMon->statsFd < 0)) {
+        ERRNO_PRINT("healthMonitorInit couldn't create epoll/eventfd/timerfd");
+        closeMonitor(pMon);
+        return EXIT_FAILURE;
+    }
+
+    /* status msg queue and stop request */
+    event.events = EPOLLIN;
+    event.data.u32 = HEALTH_EPOLL_QUEUE;
+    if(epoll_ctl(pMon->epollFd, EPOLL_CTL_ADD, (int)queue, &event) < 0) {
+        ERRNO_PRINT("healthMonitorInit couldn't watch status queue");
+        closeMonitor(pMon);
+        return EXIT_FAILURE;
+    }
+    event.data.u32 = HEALTH_EPOLL_STOP;
+    if(epoll_ctl(pMon->epollFd, EPOLL_CTL_ADD, pMon->stopFd, &event) < 0) {
+        ERRNO_PRINT("healthMonitorInit couldn't watch stop eventfd");
+        closeMonitor(pMon);
+        return EXIT_FAILURE;
+    }
+
+    /* periodic histogram dump to the log */
+    memset(&statsSpec, 0, sizeof(struct itimerspec));
+    statsSpec.it_value.tv_sec = HEALTH_STATS_LOG_SEC;
+    statsSpec.it_interval.tv_sec = HEALTH_STATS_LOG_SEC;
+    event.data.u32 = HEALTH_EPOLL_STATS;
+    if((epoll_ctl(pMon->epollFd, EPOLL_CTL_ADD, pMon->statsFd, &event) < 0) ||
+       (timerfd_settime(pMon->statsFd, 0, &statsSpec, NULL) < 0)) {
+        ERRNO_PRINT("healthMonitorInit couldn't set up stats timer");
+        closeMonitor(pMon);
+        return EXIT_FAILURE;
+    }
+
+    /* a deadline timer per monitored thread, first one from now */
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(!isMonitored(ind))
+            continue;
+        heartbeat_read((ProcessId_e)ind, &slot);
+        pMon->lastSeq[ind] = slot.seq;
+        pMon->timerFds[ind] = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        event.data.u32 = ind;
+        if((pMon->timerFds[ind] < 0) ||
+           (epoll_ctl(pMon->epollFd, EPOLL_CTL_ADD, pMon->timerFds[ind], &event) < 0) ||
+           (armDeadline(pMon->timerFds[ind], deadlineUsec) != EXIT_SUCCESS)) {
+            ERRNO_PRINT("healthMonitorInit couldn't set up deadline timer");
+            closeMonitor(pMon);
+            return EXIT_FAILURE;
+        }
+    }
     return EXIT_SUCCESS;
 }
+
+void *healthMonitorThreadHandler(void *pArg)
+{
+    HealthMonitor_t *pMon = (HealthMonitor_t *)pArg;
+    struct epoll_event events[HEALTH_MAX_EVENTS];
+    uint64_t expirations;
+    uint8_t running = 1;
+    int num, ind;
+
+    while(running)
+    {
+        num = epoll_wait(pMon->epollFd, events, HEALTH_MAX_EVENTS, -1);
+        if(num < 0) {
+            if(errno == EINTR)
+                continue;
+            ERRNO_PRINT("health monitor epoll_wait failed");
+            break;
+        }
+
+        for(ind = 0; ind < num; ++ind)
+        {
+            if(events[ind].data.u32 == HEALTH_EPOLL_STOP)
+                running = 0;
+            else if(events[ind].data.u32 == HEALTH_EPOLL_QUEUE)
+                readStatusEvents(pMon);
+            else if(events[ind].data.u32 == HEALTH_EPOLL_STATS) {
+                if(read(pMon->statsFd, &expirations, sizeof(expirations)) == sizeof(expirations))
+                    healthMonitorLogStats();
+            }
+            else
+                checkDeadline(pMon, (ProcessId_e)events[ind].data.u32);
+        }
+    }
+    INFO_PRINT("health monitor exiting\n");
+    closeMonitor(pMon);
+    return NULL;
+}
+
+void healthMonitorStop(HealthMonitor_t *pMon)
+{
+    uint64_t one = 1;
+
+    if(write(pMon->stopFd, &one, sizeof(one)) != sizeof(one))
+        ERRNO_PRINT("healthMonitorStop couldn't signal monitor");
+}
+
+/**
+ * @brief a thread's deadline timer fired; if it has beat since the timer was
+ * armed, move the deadline to its latest beat, else report it
+ *
+ * @param pMon running monitor
+ * @param Id thread whose timer fired
+ */
+static void checkDeadline(HealthMonitor_t *pMon, ProcessId_e Id)
+{
+    TaskStatusPacket status;
+    HeartbeatSlot_t slot;
+    MainAction_e action;
+    uint64_t expirations;
+    uint32_t age;
+
+    if(read(pMon->timerFds[Id], &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+    if(heartbeat_read(Id, &slot) != EXIT_SUCCESS)
+        return;
+
+    if(slot.seq != pMon->lastSeq[Id]) {
+        pMon->lastSeq[Id] = slot.seq;
+        age = heartbeat_now() - slot.timestamp;
+        armDeadline(pMon->timerFds[Id], (age < pMon->deadlineUsec) ? (pMon->deadlineUsec - age) : 1);
+        return;
+    }
+
+    /* nothing for a whole deadline, same course of action as the polling
+     * monitor's timeout; keep reporting each deadline until it beats */
+    memset(&status, 0, sizeof(struct TaskStatusPacket));
+    status.processId = Id;
+    status.errorCode = (uint8_t)ERROR_CODE_TIMEOUT;
+    status.timestamp = log_get_time();
+    action = callArbitor(&status);
+    processAction(status.processId, action, pMon->pExit);
+    LOG_MAIN_EVENT((MainEvent_e)(MAIN_EVENT_LIGHT_THREAD_UNRESPONSIVE + Id));
+    if(pMon->missedFunc != NULL)
+        pMon->missedFunc(Id, pMon->pArg);
+    armDeadline(pMon->timerFds[Id], pMon->deadlineUsec);
+}
+
+/**
+ * @brief act on the status msgs in the queue; stops at the process limit and
+ * leaves the rest for the next epoll wake up
+ *
+ * @param pMon running monitor
+ */
+static void readStatusEvents(HealthMonitor_t *pMon)
+{
+    TaskStatusPacket status;
+    MainAction_e action;
+    uint32_t msgCount;
+
+    for(msgCount = 0; msgCount < STATUS_MSG_PROCESS_LIMIT; ++msgCount)
+    {
+        memset(&status, 0, sizeof(struct TaskStatusPacket));
+        if((getStatusMsg(&pMon->queue, &status) != EXIT_SUCCESS) || (status.processId == PID_END))
+            break;
+        recordStatusMsg(&status);
+        if(status.taskStatus == STATUS_ERROR) {
+            action = callArbitor(&status);
+            processAction(status.processId, action, pMon->pExit);
+        }
+    }
+}
+
+void healthMonitorStats(ProcessId_e Id, Histogram_t *pInterval, Histogram_t *pDelivery)
+{
+    if(Id >= PID_END) {
+        hist_reset(pInterval);
+        hist_reset(pDelivery);
+        return;
+    }
+    if(heartbeat_intervals(Id, pInterval) != EXIT_SUCCESS)
+        hist_copy(pInterval, &intervalHist[Id]);
+    hist_copy(pDelivery, &deliveryHist[Id]);
+}
+
+void healthMonitorPrintStats(void)
+{
+    Histogram_t interval, delivery;
+    char line[HIST_FORMAT_SIZE];
+    uint8_t ind;
+
+    INFO_PRINT("thread heartbeat interval / status msg delivery delay, usec since start\n");
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        healthMonitorStats((ProcessId_e)ind, &interval, &delivery);
+        if((interval.count == 0) && (delivery.count == 0))
+            continue;
+        hist_format(&interval, line, sizeof(line));
+        INFO_PRINT("  %-24s interval %s\n", getPidString((ProcessId_e)ind), line);
+        hist_format(&delivery, line, sizeof(line));
+        INFO_PRINT("  %-24s delivery %s\n", "", line);
+    }
+}
+
+void healthMonitorLogStats(void)
+{
+    static Histogram_t loggedInterval[PID_END], loggedDelivery[PID_END];
+    Histogram_t now, window;
+    char line[HIST_FORMAT_SIZE], msg[LOG_MSG_PAYLOAD_SIZE];
+    uint8_t ind;
+
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        healthMonitorStats((ProcessId_e)ind, &now, &window);
+
+        /* delivery delays */
+        hist_subtract(&window, &window, &loggedDelivery[ind]);
+        hist_copy(&loggedDelivery[ind], &deliveryHist[ind]);
+        if(window.count != 0) {
+            hist_format(&window, line, sizeof(line));
+            snprintf(msg, sizeof(msg), "%s dly %s", getPidString((ProcessId_e)ind), line);
+            LOG_INFO(msg);
+        }
+
+        /* heartbeat intervals */
+        hist_subtract(&window, &now, &loggedInterval[ind]);
+        hist_copy(&loggedInterval[ind], &now);
+        if(window.count != 0) {
+            hist_format(&window, line, sizeof(line));
+            snprintf(msg, sizeof(msg), "%s int %s", getPidString((ProcessId_e)ind), line);
+            LOG_INFO(msg);
+        }
+    }
+}
+
+/**
+ * @brief add a status msg read from the queue to its thread's histograms;
+ * without the heartbeat table the queue carries the heartbeats too, so
+ * intervals are measured here
+ */
+static void recordStatusMsg(TaskStatusPacket *pStatus)
+{
+    uint32_t now = log_get_time();
+    ProcessId_e Id = pStatus->processId;
+
+    if(Id >= PID_END)
+        return;
+    hist_record(&deliveryHist[Id], ((int32_t)(now - pStatus->timestamp) > 0) ? (now - pStatus->timestamp) : 0);
+    if(!heartbeat_active()) {
+        if(lastStatusTime[Id] != 0)
+            hist_record(&intervalHist[Id], pStatus->timestamp - lastStatusTime[Id]);
+        lastStatusTime[Id] = pStatus->timestamp;
+    }
+}
+
+/**
+ * @brief nonzero for threads expected to report status
+ */
+static uint8_t isMonitored(uint8_t ind)
+{
+    return !((ind == PID_TEMP) || (ind == PID_REMOTE_CLIENT) ||
+             (ind == PID_REMOTE_CLIENT_CMD) || (ind == PID_REMOTE_CLIENT_LOG) ||
+             (ind == PID_REMOTE_CLIENT_STATUS) || (ind == PID_REMOTE_CLIENT_DATA) ||
+             (ind >= PID_END));
+}
+
+/**
+ * @brief one shot timer expiring usec from now
+ */
+static int8_t armDeadline(int timerFd, uint32_t usec)
+{
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(struct itimerspec));
+    spec.it_value.tv_sec = usec / 1000000;
+    spec.it_value.tv_nsec = (usec % 1000000) * 1000;
+    if(timerfd_settime(timerFd, 0, &spec, NULL) < 0) {
+        ERRNO_PRINT("health monitor couldn't arm deadline");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static void closeMonitor(HealthMonitor_t *pMon)
+{
+    uint8_t ind;
+
+    for(ind = 0; ind < PID_END; ++ind) {
+        if(pMon->timerFds[ind] >= 0)
+            close(pMon->timerFds[ind]);
+        pMon->timerFds[ind] = -1;
+    }
+    if(pMon->stopFd >= 0)
+        close(pMon->stopFd);
+    if(pMon->statsFd >= 0)
+        close(pMon->statsFd);
+    if(pMon->epollFd >= 0)
+        close(pMon->epollFd);
+    pMon->stopFd = -1;
+    pMon->statsFd = -1;
+    pMon->epollFd = -1;
+}
+
 /**
  * @brief perform action on process, clear exit flag if necessary
  * 
@@ -206,10 +578,16 @@ void processAction(ProcessId_e processId, MainAction_e action, uint8_t *pExit)
         threadKiller(PID_END);
         break;
         case MAIN_ACTION_TERMINATE_THREAD:
-        threadKiller(processId);
+        /* supervised threads are told directly, so their exit isn't taken
+         * for a failure and restarted */
+        if(supervisor_terminate(processId) != EXIT_SUCCESS)
+            threadKiller(processId);
         break;
         case MAIN_ACTION_RESTART_THREAD:
-        /* place holder, could do something here */
+        if(supervisor_restart(processId) != EXIT_SUCCESS) {
+            WARN_PRINT("can't restart %s, not supervised or given up on\n", getPidString(processId));
+        }
+        break;
         default:
         break;
     }
@@ -290,227 +668,13 @@ int8_t getStatusMsg(mqd_t *pQueue, TaskStatusPacket *pPacket)
     return EXIT_SUCCESS;
 }
 /**
- * @brief call the appropriate arbitor based on status
+ * @brief look up the course of action for an error in the error policy table
  * 
- * @param processId thread Id
- * @param errorCode error of thread Id
+ * @param pStatus status msg with the error
  * @return MainAction_e action to perform
  */
 MainAction_e callArbitor(TaskStatusPacket *pStatus)
 {
-    MainAction_e action;
     PRINT_STATUS_MSG(pStatus);
-
-    switch(pStatus->processId){
-        case PID_LIGHT:
-        case PID_TEMP:
-        case PID_MOISTURE:
-        case PID_OBSERVER:
-        case PID_SOLENOID:
-            action = sensorErrorArbitor(pStatus);
-        break;
-        case PID_REMOTE_LOG:
-        case PID_REMOTE_STATUS:
-        case PID_REMOTE_DATA:
-        case PID_REMOTE_CMD:
-            action = remoteErrorArbitor(pStatus);
-        break;
-        case PID_LOGGING:
-            action = loggingErrorArbitor(pStatus);
-        break;
-        default:
-            action = MAIN_ACTION_NONE;
-        break;
-    }
-
-    return action;
-}
-/**
- * @brief determine course of action of error for sensor threads
- * 
- * @param errorCode 
- * @return MainAction_e 
- */
-MainAction_e sensorErrorArbitor(TaskStatusPacket *pStatus)
-{
-    MainAction_e action;
-
-    switch(pStatus->errorCode){
-        /* do nothing */
-        case ERROR_CODE_USER_NONE0:
-        case ERROR_CODE_USER_NONE1:
-        case ERROR_CODE_USER_NONE2:
-        case ERROR_CODE_USER_NONE3:
-        case ERROR_CODE_USER_NONE4:
-        case ERROR_CODE_USER_NONE5:
-        case ERROR_CODE_USER_NONE6:
-        case ERROR_CODE_USER_NONE7:
-            action = MAIN_ACTION_NONE;
-            break;
-
-        /* just notify */
-        case ERROR_CODE_TIMEOUT:
-        case ERROR_CODE_USER_NOTIFY0:
-        case ERROR_CODE_USER_NOTIFY1:
-        case ERROR_CODE_USER_NOTIFY2:
-        case ERROR_CODE_USER_NOTIFY3:
-        case ERROR_CODE_USER_NOTIFY4:
-        case ERROR_CODE_USER_NOTIFY5:
-        case ERROR_CODE_USER_NOTIFY6:
-        case ERROR_CODE_USER_NOTIFY7:
-            action = MAIN_ACTION_NOTIFY_USER_ONLY;
-            break;       
-
-        /* kill thread */
-        case ERROR_CODE_USER_TERMTHREAD0:
-        case ERROR_CODE_USER_TERMTHREAD1:
-        case ERROR_CODE_USER_TERMTHREAD2:
-        case ERROR_CODE_USER_TERMTHREAD3:
-        case ERROR_CODE_USER_TERMTHREAD4:
-        case ERROR_CODE_USER_TERMTHREAD5:
-        case ERROR_CODE_USER_TERMTHREAD6:
-        case ERROR_CODE_USER_TERMTHREAD7:
-            action = MAIN_ACTION_TERMINATE_THREAD;
-            break;
-
-        /* kill all */
-        case ERROR_CODE_USER_TERMALL0:
-        case ERROR_CODE_USER_TERMALL1:
-        case ERROR_CODE_USER_TERMALL2:
-        case ERROR_CODE_USER_TERMALL3:
-        case ERROR_CODE_USER_TERMALL4:
-        case ERROR_CODE_USER_TERMALL5:
-        case ERROR_CODE_USER_TERMALL6:
-        case ERROR_CODE_USER_TERMALL7:
-        default:
-            action = MAIN_ACTION_TERMINATE_ALL;
-            break;
-    }
-    return action;
-}
-/**
- * @brief determine course of action of error for remote thread
- * 
- * @param errorCode 
- * @return MainAction_e 
- */
-MainAction_e remoteErrorArbitor(TaskStatusPacket *pStatus)
-{
-    MainAction_e action;
-
-    switch(pStatus->errorCode){
-        /* do nothing */
-        case ERROR_CODE_USER_NONE0:
-        case ERROR_CODE_USER_NONE1:
-        case ERROR_CODE_USER_NONE2:
-        case ERROR_CODE_USER_NONE3:
-        case ERROR_CODE_USER_NONE4:
-        case ERROR_CODE_USER_NONE5:
-        case ERROR_CODE_USER_NONE6:
-        case ERROR_CODE_USER_NONE7:
-            action = MAIN_ACTION_NONE;
-            break;
-
-        /* just notify */
-        case ERROR_CODE_TIMEOUT:
-        case ERROR_CODE_USER_NOTIFY0:
-        case ERROR_CODE_USER_NOTIFY1:
-        case ERROR_CODE_USER_NOTIFY2:
-        case ERROR_CODE_USER_NOTIFY3:
-        case ERROR_CODE_USER_NOTIFY4:
-        case ERROR_CODE_USER_NOTIFY5:
-        case ERROR_CODE_USER_NOTIFY6:
-        case ERROR_CODE_USER_NOTIFY7:
-            action = MAIN_ACTION_NOTIFY_USER_ONLY;
-            break;       
-
-        /* kill thread */
-        case ERROR_CODE_USER_TERMTHREAD0:
-        case ERROR_CODE_USER_TERMTHREAD1:
-        case ERROR_CODE_USER_TERMTHREAD2:
-        case ERROR_CODE_USER_TERMTHREAD3:
-        case ERROR_CODE_USER_TERMTHREAD4:
-        case ERROR_CODE_USER_TERMTHREAD5:
-        case ERROR_CODE_USER_TERMTHREAD6:
-        case ERROR_CODE_USER_TERMTHREAD7:
-            action = MAIN_ACTION_TERMINATE_THREAD;
-            break;
-
-        /* kill all */
-        case ERROR_CODE_USER_TERMALL0:
-        case ERROR_CODE_USER_TERMALL1:
-        case ERROR_CODE_USER_TERMALL2:
-        case ERROR_CODE_USER_TERMALL3:
-        case ERROR_CODE_USER_TERMALL4:
-        case ERROR_CODE_USER_TERMALL5:
-        case ERROR_CODE_USER_TERMALL6:
-        case ERROR_CODE_USER_TERMALL7:
-        default:
-            action = MAIN_ACTION_TERMINATE_ALL;
-            break;
-    }
-    return action;
-}
-/**
- * @brief determine course of action of error for logging thread
- * 
- * @param errorCode 
- * @return MainAction_e 
- */
-MainAction_e loggingErrorArbitor(TaskStatusPacket *pStatus)
-{
-    MainAction_e action;
-
-    switch(pStatus->errorCode){
-        /* do nothing */
-        case ERROR_CODE_USER_NONE0:
-        case ERROR_CODE_USER_NONE1:
-        case ERROR_CODE_USER_NONE2:
-        case ERROR_CODE_USER_NONE3:
-        case ERROR_CODE_USER_NONE4:
-        case ERROR_CODE_USER_NONE5:
-        case ERROR_CODE_USER_NONE6:
-        case ERROR_CODE_USER_NONE7:
-            action = MAIN_ACTION_NONE;
-            break;
-
-        /* just notify */
-        case ERROR_CODE_TIMEOUT:
-        case ERROR_CODE_USER_NOTIFY0:
-        case ERROR_CODE_USER_NOTIFY1:
-        case ERROR_CODE_USER_NOTIFY2:
-        case ERROR_CODE_USER_NOTIFY3:
-        case ERROR_CODE_USER_NOTIFY4:
-        case ERROR_CODE_USER_NOTIFY5:
-        case ERROR_CODE_USER_NOTIFY6:
-        case ERROR_CODE_USER_NOTIFY7:
-            action = MAIN_ACTION_NOTIFY_USER_ONLY;
-            break;       
-
-        /* kill thread */
-        case ERROR_CODE_USER_TERMTHREAD0:
-        case ERROR_CODE_USER_TERMTHREAD1:
-        case ERROR_CODE_USER_TERMTHREAD2:
-        case ERROR_CODE_USER_TERMTHREAD3:
-        case ERROR_CODE_USER_TERMTHREAD4:
-        case ERROR_CODE_USER_TERMTHREAD5:
-        case ERROR_CODE_USER_TERMTHREAD6:
-        case ERROR_CODE_USER_TERMTHREAD7:
-            action = MAIN_ACTION_TERMINATE_THREAD;
-            break;
-
-        /* kill all */
-        case ERROR_CODE_USER_TERMALL0:
-        case ERROR_CODE_USER_TERMALL1:
-        case ERROR_CODE_USER_TERMALL2:
-        case ERROR_CODE_USER_TERMALL3:
-        case ERROR_CODE_USER_TERMALL4:
-        case ERROR_CODE_USER_TERMALL5:
-        case ERROR_CODE_USER_TERMALL6:
-        case ERROR_CODE_USER_TERMALL7:
-        default:
-            action = MAIN_ACTION_TERMINATE_ALL;
-            break;
-    }
-    return action;
+    return error_policy_action(pStatus->processId, pStatus->errorCode);
 }
@@ -0,0 +1,136 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 10, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file healthQuery.c
+ * @brief print health snapshots from a running main's snapshot socket
+ *
+ * usage: healthQuery [-j] [-n count] [-i intervalMs] [socket]
+ *                    (default /tmp/bbg_health.sock)
+ *  -j  print the JSON the server formats instead of a table
+ *  -n  snapshots to print, 0 for until killed (default 1)
+ *  -i  time between snapshots (default 1000 ms)
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "my_debug.h"
+#include "healthSnapshot.h"
+#include "healthMonitor.h"
+
+#define DEFAULT_INTERVAL_MS     (1000)
+
+static void printSnapshot(const HealthSnapshot_t *pSnap);
+
+/*---------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *pPath = HEALTH_SNAPSHOT_SOCKET;
+    struct sockaddr_un addr;
+    HealthSnapshot_t snap;
+    char json[HEALTH_SNAPSHOT_JSON_SIZE];
+    uint32_t count = 1, intervalMs = DEFAULT_INTERVAL_MS, num;
+    uint8_t asJson = 0;
+    char req;
+    ssize_t len;
+    int opt, fd;
+
+    while((opt = getopt(argc, argv, "jn:i:")) != -1) {
+        switch(opt) {
+            case 'j':
+                asJson = 1;
+                break;
+            case 'n':
+                count = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'i':
+                intervalMs = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                ERROR_PRINT("usage: %s [-j] [-n count] [-i intervalMs] [socket]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(optind < argc)
+        pPath = argv[optind];
+
+    memset(&addr, 0, sizeof(struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, pPath, sizeof(addr.sun_path) - 1);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if((fd < 0) || (connect(fd, (struct sockaddr *)&addr, sizeof(struct sockaddr_un)) < 0)) {
+        ERRNO_PRINT("healthQuery couldn't connect, is main running");
+        return EXIT_FAILURE;
+    }
+
+    req = asJson ? HEALTH_SNAPSHOT_REQ_JSON : HEALTH_SNAPSHOT_REQ_BINARY;
+    for(num = 0; (count == 0) || (num < count); ++num)
+    {
+        if(num != 0)
+            usleep(intervalMs * 1000);
+        if(send(fd, &req, 1, MSG_NOSIGNAL) != 1) {
+            ERRNO_PRINT("healthQuery request");
+            break;
+        }
+
+        if(asJson) {
+            /* one line per reply */
+            len = 0;
+            do {
+                if(recv(fd, &json[len], 1, 0) != 1) {
+                    ERRNO_PRINT("healthQuery reply");
+                    close(fd);
+                    return EXIT_FAILURE;
+                }
+            } while((json[len++] != '\n') && (len < (ssize_t)sizeof(json) - 1));
+            json[len] = '\0';
+            fputs(json, stdout);
+        }
+        else {
+            if((recv(fd, &snap, sizeof(HealthSnapshot_t), MSG_WAITALL) != sizeof(HealthSnapshot_t)) ||
+               (snap.magic != HEALTH_SNAPSHOT_MAGIC)) {
+                ERROR_PRINT("healthQuery bad reply\n");
+                close(fd);
+                return EXIT_FAILURE;
+            }
+            printSnapshot(&snap);
+        }
+        fflush(stdout);
+    }
+    close(fd);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printSnapshot(const HealthSnapshot_t *pSnap)
+{
+    uint8_t ind;
+
+    printf("snapshot %u, published %u usec ago\n", pSnap->seq, pSnap->ageUsec);
+    printf("  control loop %s, system %s, lux %.2f, moisture %.2f\n",
+           health_snapshot_loop_string(pSnap->controlLoopState),
+           health_snapshot_system_string(pSnap->systemState), pSnap->luxData, pSnap->moistureData);
+    printf("  queue depths: log %d, heartbeat %d, data %d, cmd %d\n", pSnap->queueDepth[SNAPSHOT_QUEUE_LOG],
+           pSnap->queueDepth[SNAPSHOT_QUEUE_HEARTBEAT], pSnap->queueDepth[SNAPSHOT_QUEUE_DATA],
+           pSnap->queueDepth[SNAPSHOT_QUEUE_CMD]);
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(pSnap->heartbeatAgeUsec[ind] == HEALTH_SNAPSHOT_NO_BEAT)
+            continue;
+        printf("  %-26s last heartbeat %8u usec ago, status %u\n", getPidString((ProcessId_e)ind),
+               pSnap->heartbeatAgeUsec[ind], pSnap->taskStatus[ind]);
+    }
+}
@@ -0,0 +1,370 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 10, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file healthSnapshot.c
+ * @brief read only view of system health over a local UNIX socket
+ *
+ ************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "my_debug.h"
+#include "healthSnapshot.h"
+#include "healthMonitor.h"
+#include "heartbeat.h"
+
+#define SNAPSHOT_EPOLL_LISTEN   (HEALTH_SNAPSHOT_MAX_CLIENTS)   /* epoll data of non client fds */
+#define SNAPSHOT_EPOLL_STOP     (HEALTH_SNAPSHOT_MAX_CLIENTS + 1)
+#define SNAPSHOT_MAX_EVENTS     (16)
+#define SNAPSHOT_REQ_SIZE       (64)
+
+typedef struct {
+    uint32_t seq;               /* odd while being written */
+    HealthSnapshot_t snap;
+} SnapshotBuffer_t;
+
+static SnapshotBuffer_t buffers[2];
+static uint32_t current = 0;    /* buffer readers copy */
+static uint32_t publishCount = 0;
+
+static const char * const loopStateStrings[] = {"IDLE", "WATER_PERIODIC_SCHED", "WATER_ONESHOT_SCHED", "WATERING_PLANT"};
+static const char * const systemStateStrings[] = {"DEGRADED", "FAULT", "NOMINAL"};
+static const char * const queueStrings[SNAPSHOT_QUEUE_END] = {"log", "heartbeat", "data", "cmd"};
+
+static void acceptClients(HealthSnapshotServer_t *pSrv);
+static void serveClient(HealthSnapshotServer_t *pSrv, uint32_t slot);
+static void closeClient(HealthSnapshotServer_t *pSrv, uint32_t slot);
+static void closeServer(HealthSnapshotServer_t *pSrv);
+
+/*---------------------------------------------------------------------------------*/
+void health_snapshot_publish(HealthSnapshot_t *pSnap)
+{
+    SnapshotBuffer_t *pBuf;
+    uint32_t next, seq;
+
+    pSnap->magic = HEALTH_SNAPSHOT_MAGIC;
+    pSnap->seq = ++publishCount;
+    pSnap->timestamp = heartbeat_now();
+
+    /* write the buffer readers aren't pointed at; one still copying it from
+     * two publishes ago sees its seq change and retries */
+    next = __atomic_load_n(&current, __ATOMIC_RELAXED) ^ 1;
+    pBuf = &buffers[next];
+    seq = __atomic_load_n(&pBuf->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&pBuf->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&pBuf->snap, pSnap, sizeof(HealthSnapshot_t));
+    __atomic_store_n(&pBuf->seq, seq + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&current, next, __ATOMIC_RELEASE);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t health_snapshot_read(HealthSnapshot_t *pSnap)
+{
+    SnapshotBuffer_t *pBuf;
+    uint32_t seq, retries = 0;
+
+    for(;;)
+    {
+        pBuf = &buffers[__atomic_load_n(&current, __ATOMIC_ACQUIRE)];
+        seq = __atomic_load_n(&pBuf->seq, __ATOMIC_ACQUIRE);
+        if(!(seq & 1)) {
+            memcpy(pSnap, &pBuf->snap, sizeof(HealthSnapshot_t));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if(__atomic_load_n(&pBuf->seq, __ATOMIC_RELAXED) == seq)
+                return retries;
+        }
+        ++retries;
+        sched_yield();
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+void health_snapshot_current(HealthSnapshot_t *pSnap)
+{
+    HeartbeatSlot_t slot;
+    uint32_t now;
+    uint8_t ind;
+
+    health_snapshot_read(pSnap);
+    now = heartbeat_now();
+    pSnap->ageUsec = (pSnap->seq != 0) ? (now - pSnap->timestamp) : HEALTH_SNAPSHOT_NO_BEAT;
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        pSnap->heartbeatAgeUsec[ind] = HEALTH_SNAPSHOT_NO_BEAT;
+        pSnap->taskStatus[ind] = STATUS_OK;
+        if((heartbeat_read((ProcessId_e)ind, &slot) == EXIT_SUCCESS) && (slot.seq != 0)) {
+            pSnap->heartbeatAgeUsec[ind] = now - slot.timestamp;
+            pSnap->taskStatus[ind] = slot.taskStatus;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+int health_snapshot_json(const HealthSnapshot_t *pSnap, char *pBuf, uint32_t size)
+{
+    uint32_t used;
+    uint8_t ind, first = 1;
+
+#define JSON_APPEND(...) \
+    used += snprintf(pBuf + used, (used < size) ? (size - used) : 0, __VA_ARGS__)
+
+    used = 0;
+    JSON_APPEND("{\"seq\":%u,\"ageUsec\":%u,\"controlLoopState\":\"%s\",\"systemState\":\"%s\","
+                "\"luxData\":%.2f,\"moistureData\":%.2f,\"queues\":{",
+                pSnap->seq, pSnap->ageUsec,
+                health_snapshot_loop_string(pSnap->controlLoopState),
+                health_snapshot_system_string(pSnap->systemState),
+                pSnap->luxData, pSnap->moistureData);
+    for(ind = 0; ind < SNAPSHOT_QUEUE_END; ++ind)
+        JSON_APPEND("%s\"%s\":%d", (ind == 0) ? "" : ",", queueStrings[ind], pSnap->queueDepth[ind]);
+    JSON_APPEND("},\"threads\":{");
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(pSnap->heartbeatAgeUsec[ind] == HEALTH_SNAPSHOT_NO_BEAT)
+            continue;
+        JSON_APPEND("%s\"%s\":{\"heartbeatAgeUsec\":%u,\"taskStatus\":%u}", first ? "" : ",",
+                    getPidString((ProcessId_e)ind), pSnap->heartbeatAgeUsec[ind], pSnap->taskStatus[ind]);
+        first = 0;
+    }
+    JSON_APPEND("}}\n");
+
+#undef JSON_APPEND
+    return (int)used;
+}
+
+/*---------------------------------------------------------------------------------*/
+const char *health_snapshot_loop_string(uint8_t state)
+{
+    return (state < (sizeof(loopStateStrings) / sizeof(loopStateStrings[0]))) ? loopStateStrings[state] : "UNKNOWN";
+}
+
+/*---------------------------------------------------------------------------------*/
+const char *health_snapshot_system_string(uint8_t state)
+{
+    return (state < (sizeof(systemStateStrings) / sizeof(systemStateStrings[0]))) ? systemStateStrings[state] : "UNKNOWN";
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t health_snapshot_server_init(HealthSnapshotServer_t *pSrv, const char *pPath)
+{
+    struct sockaddr_un addr;
+    struct epoll_event event;
+    uint32_t ind;
+
+    if((pSrv == NULL) || (pPath == NULL) || (strlen(pPath) >= sizeof(addr.sun_path)))
+        return EXIT_FAILURE;
+    memset(pSrv, 0, sizeof(HealthSnapshotServer_t));
+    pSrv->pPath = pPath;
+    pSrv->listenFd = -1;
+    pSrv->stopFd = -1;
+    for(ind = 0; ind < HEALTH_SNAPSHOT_MAX_CLIENTS; ++ind)
+        pSrv->clientFds[ind] = -1;
+
+    pSrv->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    pSrv->stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    pSrv->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if((pSrv->epollFd < 0) || (pSrv->stopFd < 0) || (pSrv->listenFd < 0)) {
+        ERRNO_PRINT("health_snapshot_server_init couldn't create epoll/eventfd/socket");
+        closeServer(pSrv);
+        return EXIT_FAILURE;
+    }
+
+    memset(&addr, 0, sizeof(struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, pPath);
+    unlink(pPath);
+    if((bind(pSrv->listenFd, (struct sockaddr *)&addr, sizeof(struct sockaddr_un)) < 0) ||
+       (listen(pSrv->listenFd, HEALTH_SNAPSHOT_MAX_CLIENTS) < 0)) {
+        ERRNO_PRINT("health_snapshot_server_init couldn't bind/listen");
+        closeServer(pSrv);
+        return EXIT_FAILURE;
+    }
+
+    event.events = EPOLLIN;
+    event.data.u32 = SNAPSHOT_EPOLL_LISTEN;
+    if(epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, pSrv->listenFd, &event) < 0) {
+        ERRNO_PRINT("health_snapshot_server_init couldn't watch socket");
+        closeServer(pSrv);
+        return EXIT_FAILURE;
+    }
+    event.data.u32 = SNAPSHOT_EPOLL_STOP;
+    if(epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, pSrv->stopFd, &event) < 0) {
+        ERRNO_PRINT("health_snapshot_server_init couldn't watch stop eventfd");
+        closeServer(pSrv);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+void *healthSnapshotThreadHandler(void *pArg)
+{
+    HealthSnapshotServer_t *pSrv = (HealthSnapshotServer_t *)pArg;
+    struct epoll_event events[SNAPSHOT_MAX_EVENTS];
+    uint8_t running = 1;
+    int num, ind;
+
+    INFO_PRINT("health snapshots served on %s\n", pSrv->pPath);
+    while(running)
+    {
+        num = epoll_wait(pSrv->epollFd, events, SNAPSHOT_MAX_EVENTS, -1);
+        if(num < 0) {
+            if(errno == EINTR)
+                continue;
+            ERRNO_PRINT("health snapshot server epoll_wait");
+            break;
+        }
+
+        for(ind = 0; ind < num; ++ind)
+        {
+            if(events[ind].data.u32 == SNAPSHOT_EPOLL_STOP)
+                running = 0;
+            else if(events[ind].data.u32 == SNAPSHOT_EPOLL_LISTEN)
+                acceptClients(pSrv);
+            else if(events[ind].events & EPOLLIN)
+                serveClient(pSrv, events[ind].data.u32);
+            else
+                closeClient(pSrv, events[ind].data.u32);
+        }
+    }
+
+    closeServer(pSrv);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+void health_snapshot_server_stop(HealthSnapshotServer_t *pSrv)
+{
+    uint64_t one = 1;
+
+    if(write(pSrv->stopFd, &one, sizeof(one)) != sizeof(one))
+        ERRNO_PRINT("health_snapshot_server_stop couldn't signal server");
+}
+
+/*---------------------------------------------------------------------------------*/
+static void acceptClients(HealthSnapshotServer_t *pSrv)
+{
+    struct epoll_event event;
+    uint32_t slot;
+    int fd;
+
+    /* client sockets are only read when epoll says so and written with
+     * MSG_DONTWAIT, they can stay blocking */
+    while((fd = accept(pSrv->listenFd, NULL, NULL)) >= 0)
+    {
+        for(slot = 0; (slot < HEALTH_SNAPSHOT_MAX_CLIENTS) && (pSrv->clientFds[slot] >= 0); ++slot);
+
+        event.events = EPOLLIN;
+        event.data.u32 = slot;
+        if((slot == HEALTH_SNAPSHOT_MAX_CLIENTS) || (epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, fd, &event) < 0)) {
+            WARN_PRINT("health snapshot server full, connection refused\n");
+            close(fd);
+            continue;
+        }
+        pSrv->clientFds[slot] = fd;
+        ++pSrv->clients;
+    }
+    if((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        ERRNO_PRINT("health snapshot server accept");
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief answer every request byte read; replies are small enough to fit
+ * the socket buffer of a client that keeps up, others are dropped rather
+ * than waited for
+ */
+static void serveClient(HealthSnapshotServer_t *pSrv, uint32_t slot)
+{
+    HealthSnapshot_t snap;
+    char req[SNAPSHOT_REQ_SIZE];
+    char json[HEALTH_SNAPSHOT_JSON_SIZE];
+    ssize_t num, ind, sent;
+    int len = 0;
+    uint8_t haveSnap = 0;
+
+    if(slot >= HEALTH_SNAPSHOT_MAX_CLIENTS)
+        return;
+    num = recv(pSrv->clientFds[slot], req, sizeof(req), 0);
+    if(num <= 0) {
+        if((num == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)))
+            closeClient(pSrv, slot);
+        return;
+    }
+
+    for(ind = 0; ind < num; ++ind)
+    {
+        if((req[ind] != HEALTH_SNAPSHOT_REQ_BINARY) && (req[ind] != HEALTH_SNAPSHOT_REQ_JSON))
+            continue;
+        if(!haveSnap) {
+            health_snapshot_current(&snap);
+            haveSnap = 1;
+        }
+
+        if(req[ind] == HEALTH_SNAPSHOT_REQ_BINARY) {
+            sent = send(pSrv->clientFds[slot], &snap, sizeof(HealthSnapshot_t), MSG_NOSIGNAL | MSG_DONTWAIT);
+            len = sizeof(HealthSnapshot_t);
+        }
+        else {
+            len = health_snapshot_json(&snap, json, sizeof(json));
+            sent = send(pSrv->clientFds[slot], json, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+        if(sent != len) {
+            closeClient(pSrv, slot);
+            return;
+        }
+        ++pSrv->served;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static void closeClient(HealthSnapshotServer_t *pSrv, uint32_t slot)
+{
+    if((slot >= HEALTH_SNAPSHOT_MAX_CLIENTS) || (pSrv->clientFds[slot] < 0))
+        return;
+    epoll_ctl(pSrv->epollFd, EPOLL_CTL_DEL, pSrv->clientFds[slot], NULL);
+    close(pSrv->clientFds[slot]);
+    pSrv->clientFds[slot] = -1;
+    --pSrv->clients;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void closeServer(HealthSnapshotServer_t *pSrv)
+{
+    uint32_t ind;
+
+    for(ind = 0; ind < HEALTH_SNAPSHOT_MAX_CLIENTS; ++ind)
+        closeClient(pSrv, ind);
+    if(pSrv->listenFd >= 0) {
+        close(pSrv->listenFd);
+        unlink(pSrv->pPath);
+    }
+    if(pSrv->stopFd >= 0)
+        close(pSrv->stopFd);
+    if(pSrv->epollFd >= 0)
+        close(pSrv->epollFd);
+    pSrv->listenFd = -1;
+    pSrv->stopFd = -1;
+    pSrv->epollFd = -1;
+}
+
+/*---------------------------------------------------------------------------------*/
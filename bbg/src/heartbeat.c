@@ -0,0 +1,203 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 6, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file heartbeat.c
+ * @brief shared memory table of thread heartbeats
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "my_debug.h"
+#include "heartbeat.h"
+
+static HeartbeatTable_t *pTable = NULL;
+static __thread uint32_t threadId = 0;      /* cached so publishing makes no syscall */
+
+/*---------------------------------------------------------------------------------*/
+int8_t heartbeat_init(const char *pName)
+{
+    void *pMap;
+    int fd;
+
+    shm_unlink(pName);
+    fd = shm_open(pName, O_CREAT | O_RDWR, 0666);
+    if(fd < 0) {
+        ERRNO_PRINT("heartbeat_init couldn't create shared memory");
+        return EXIT_FAILURE;
+    }
+    if(ftruncate(fd, sizeof(HeartbeatTable_t)) < 0) {
+        ERRNO_PRINT("heartbeat_init couldn't size shared memory");
+        close(fd);
+        shm_unlink(pName);
+        return EXIT_FAILURE;
+    }
+    pMap = mmap(NULL, sizeof(HeartbeatTable_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(pMap == MAP_FAILED) {
+        ERRNO_PRINT("heartbeat_init couldn't map shared memory");
+        shm_unlink(pName);
+        return EXIT_FAILURE;
+    }
+
+    memset(pMap, 0, sizeof(HeartbeatTable_t));
+    ((HeartbeatTable_t *)pMap)->magic = HEARTBEAT_MAGIC;
+    ((HeartbeatTable_t *)pMap)->numSlots = PID_END;
+    __atomic_store_n(&pTable, (HeartbeatTable_t *)pMap, __ATOMIC_RELEASE);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+void heartbeat_destroy(const char *pName)
+{
+    HeartbeatTable_t *pOld = __atomic_exchange_n(&pTable, NULL, __ATOMIC_ACQ_REL);
+
+    if(pOld != NULL)
+        munmap(pOld, sizeof(HeartbeatTable_t));
+    shm_unlink(pName);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t heartbeat_active(void)
+{
+    return (__atomic_load_n(&pTable, __ATOMIC_ACQUIRE) != NULL);
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t heartbeat_publish(ProcessId_e Id, TaskStatus_e taskStatus, uint8_t errorCode)
+{
+    HeartbeatTable_t *pTab = __atomic_load_n(&pTable, __ATOMIC_ACQUIRE);
+    HeartbeatSlot_t *pSlot;
+    uint32_t seq, now;
+
+    if((pTab == NULL) || (Id >= PID_END))
+        return EXIT_FAILURE;
+    if(threadId == 0)
+        threadId = (uint32_t)syscall(SYS_gettid);
+    pSlot = &pTab->slots[Id];
+
+    /* normally one writer per slot, but remote status forwards the TIVA's
+     * threads' status too; claim the slot by making seq odd */
+    seq = __atomic_load_n(&pSlot->seq, __ATOMIC_RELAXED);
+    do {
+        while(seq & 1) {
+            sched_yield();
+            seq = __atomic_load_n(&pSlot->seq, __ATOMIC_RELAXED);
+        }
+    } while(!__atomic_compare_exchange_n(&pSlot->seq, &seq, seq + 1, 1,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    now = heartbeat_now();
+    if(seq != 0)
+        hist_record(&pTab->intervals[Id], now - pSlot->timestamp);
+    __atomic_store_n(&pSlot->timestamp, now, __ATOMIC_RELAXED);
+    __atomic_store_n(&pSlot->tid, threadId, __ATOMIC_RELAXED);
+    __atomic_store_n(&pSlot->taskStatus, (uint8_t)taskStatus, __ATOMIC_RELAXED);
+    __atomic_store_n(&pSlot->taskState, (uint8_t)STATE_RUNNING, __ATOMIC_RELAXED);
+    __atomic_store_n(&pSlot->errorCode, errorCode, __ATOMIC_RELAXED);
+    __atomic_store_n(&pSlot->seq, seq + 2, __ATOMIC_RELEASE);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t heartbeat_read(ProcessId_e Id, HeartbeatSlot_t *pSlot)
+{
+    HeartbeatTable_t *pTab = __atomic_load_n(&pTable, __ATOMIC_ACQUIRE);
+    HeartbeatSlot_t *pSrc;
+    uint32_t seq;
+
+    if((pTab == NULL) || (Id >= PID_END))
+        return EXIT_FAILURE;
+    pSrc = &pTab->slots[Id];
+
+    do {
+        seq = __atomic_load_n(&pSrc->seq, __ATOMIC_ACQUIRE);
+        if(seq & 1) {
+            sched_yield();
+            continue;
+        }
+        pSlot->timestamp = __atomic_load_n(&pSrc->timestamp, __ATOMIC_RELAXED);
+        pSlot->tid = __atomic_load_n(&pSrc->tid, __ATOMIC_RELAXED);
+        pSlot->taskStatus = __atomic_load_n(&pSrc->taskStatus, __ATOMIC_RELAXED);
+        pSlot->taskState = __atomic_load_n(&pSrc->taskState, __ATOMIC_RELAXED);
+        pSlot->errorCode = __atomic_load_n(&pSrc->errorCode, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while((seq & 1) || (__atomic_load_n(&pSrc->seq, __ATOMIC_RELAXED) != seq));
+
+    pSlot->seq = seq;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t heartbeat_intervals(ProcessId_e Id, Histogram_t *pHist)
+{
+    HeartbeatTable_t *pTab = __atomic_load_n(&pTable, __ATOMIC_ACQUIRE);
+
+    if((pTab == NULL) || (Id >= PID_END))
+        return EXIT_FAILURE;
+    hist_copy(pHist, &pTab->intervals[Id]);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t heartbeat_stale(uint32_t mask, uint32_t deadlineUsec)
+{
+    HeartbeatSlot_t slot;
+    uint32_t stale = 0, now = heartbeat_now();
+    uint8_t ind;
+
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(!(mask & (1UL << ind)))
+            continue;
+        if((heartbeat_read((ProcessId_e)ind, &slot) != EXIT_SUCCESS) || (slot.seq == 0) ||
+           ((now - slot.timestamp) > deadlineUsec))
+            stale |= (1UL << ind);
+    }
+    return stale;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t heartbeat_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(((uint64_t)now.tv_sec * 1000000ULL) + (now.tv_nsec / 1000));
+}
+
+/*---------------------------------------------------------------------------------*/
+void heartbeat_event_sent(void)
+{
+    HeartbeatTable_t *pTab = __atomic_load_n(&pTable, __ATOMIC_ACQUIRE);
+
+    if(pTab != NULL)
+        __atomic_fetch_add(&pTab->events, 1, __ATOMIC_RELEASE);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t heartbeat_events(void)
+{
+    HeartbeatTable_t *pTab = __atomic_load_n(&pTable, __ATOMIC_ACQUIRE);
+
+    if(pTab == NULL)
+        return 0;
+    return __atomic_load_n(&pTab->events, __ATOMIC_ACQUIRE);
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,169 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 7, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file histogram.c
+ * @brief fixed size log-linear (HDR style) histogram of uint32 values
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "histogram.h"
+
+static uint32_t bucketIndex(uint32_t value);
+static uint32_t bucketLow(uint32_t index);
+static uint32_t bucketHigh(uint32_t index);
+
+/*---------------------------------------------------------------------------------*/
+void hist_reset(Histogram_t *pHist)
+{
+    memset(pHist, 0, sizeof(Histogram_t));
+}
+
+/*---------------------------------------------------------------------------------*/
+void hist_record(Histogram_t *pHist, uint32_t value)
+{
+    uint32_t count = __atomic_load_n(&pHist->count, __ATOMIC_RELAXED);
+
+    if((count == 0) || (value < __atomic_load_n(&pHist->min, __ATOMIC_RELAXED)))
+        __atomic_store_n(&pHist->min, value, __ATOMIC_RELAXED);
+    if(value > __atomic_load_n(&pHist->max, __ATOMIC_RELAXED))
+        __atomic_store_n(&pHist->max, value, __ATOMIC_RELAXED);
+    __atomic_store_n(&pHist->sum, __atomic_load_n(&pHist->sum, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+    __atomic_store_n(&pHist->buckets[bucketIndex(value)],
+                     __atomic_load_n(&pHist->buckets[bucketIndex(value)], __ATOMIC_RELAXED) + 1,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&pHist->count, count + 1, __ATOMIC_RELEASE);
+}
+
+/*---------------------------------------------------------------------------------*/
+void hist_copy(Histogram_t *pDst, const Histogram_t *pSrc)
+{
+    uint32_t ind;
+
+    pDst->count = __atomic_load_n(&pSrc->count, __ATOMIC_ACQUIRE);
+    pDst->min = __atomic_load_n(&pSrc->min, __ATOMIC_RELAXED);
+    pDst->max = __atomic_load_n(&pSrc->max, __ATOMIC_RELAXED);
+    pDst->sum = __atomic_load_n(&pSrc->sum, __ATOMIC_RELAXED);
+    for(ind = 0; ind < HIST_BUCKETS; ++ind)
+        pDst->buckets[ind] = __atomic_load_n(&pSrc->buckets[ind], __ATOMIC_RELAXED);
+}
+
+/*---------------------------------------------------------------------------------*/
+void hist_subtract(Histogram_t *pDst, const Histogram_t *pNow, const Histogram_t *pPrev)
+{
+    uint32_t ind, first = HIST_BUCKETS, last = 0;
+
+    pDst->count = 0;
+    pDst->sum = pNow->sum - pPrev->sum;
+    for(ind = 0; ind < HIST_BUCKETS; ++ind)
+    {
+        pDst->buckets[ind] = pNow->buckets[ind] - pPrev->buckets[ind];
+        if(pDst->buckets[ind] != 0) {
+            if(first == HIST_BUCKETS)
+                first = ind;
+            last = ind;
+            pDst->count += pDst->buckets[ind];
+        }
+    }
+    pDst->min = (pDst->count != 0) ? bucketLow(first) : 0;
+    pDst->max = (pDst->count != 0) ? bucketHigh(last) : 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+void hist_add(Histogram_t *pDst, const Histogram_t *pSrc)
+{
+    uint32_t ind;
+
+    if(pSrc->count == 0)
+        return;
+    if((pDst->count == 0) || (pSrc->min < pDst->min))
+        pDst->min = pSrc->min;
+    if(pSrc->max > pDst->max)
+        pDst->max = pSrc->max;
+    pDst->count += pSrc->count;
+    pDst->sum += pSrc->sum;
+    for(ind = 0; ind < HIST_BUCKETS; ++ind)
+        pDst->buckets[ind] += pSrc->buckets[ind];
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t hist_percentile(const Histogram_t *pHist, double pct)
+{
+    uint64_t target, seen = 0;
+    uint32_t ind;
+
+    if(pHist->count == 0)
+        return 0;
+    target = (uint64_t)(((pct * pHist->count) / 100.0) + 0.5);
+    if(target == 0)
+        target = 1;
+
+    for(ind = 0; ind < HIST_BUCKETS; ++ind)
+    {
+        seen += pHist->buckets[ind];
+        if(seen >= target)
+            break;
+    }
+    if(ind == HIST_BUCKETS)
+        return pHist->max;
+
+    /* no further than the largest value actually seen */
+    return (bucketHigh(ind) < pHist->max) ? bucketHigh(ind) : pHist->max;
+}
+
+/*---------------------------------------------------------------------------------*/
+int hist_format(const Histogram_t *pHist, char *pBuf, uint32_t size)
+{
+    return snprintf(pBuf, size, "n=%u min=%u p50=%u p90=%u p99=%u max=%u",
+                    pHist->count, pHist->min, hist_percentile(pHist, 50.0),
+                    hist_percentile(pHist, 90.0), hist_percentile(pHist, 99.0), pHist->max);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief exact below 2 * HIST_SUB_COUNT, then HIST_SUB_COUNT per power of two
+ * keyed by the bits below the most significant one
+ */
+static uint32_t bucketIndex(uint32_t value)
+{
+    uint32_t shift;
+
+    if(value < (2 * HIST_SUB_COUNT))
+        return value;
+    shift = (31 - __builtin_clz(value)) - HIST_SUB_BITS;
+    return (2 * HIST_SUB_COUNT) + ((shift - 1) * HIST_SUB_COUNT) + ((value >> shift) - HIST_SUB_COUNT);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint32_t bucketLow(uint32_t index)
+{
+    uint32_t shift;
+
+    if(index < (2 * HIST_SUB_COUNT))
+        return index;
+    shift = ((index - (2 * HIST_SUB_COUNT)) / HIST_SUB_COUNT) + 1;
+    return (HIST_SUB_COUNT + ((index - (2 * HIST_SUB_COUNT)) % HIST_SUB_COUNT)) << shift;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint32_t bucketHigh(uint32_t index)
+{
+    uint32_t shift;
+
+    if(index < (2 * HIST_SUB_COUNT))
+        return index;
+    shift = ((index - (2 * HIST_SUB_COUNT)) / HIST_SUB_COUNT) + 1;
+    return bucketLow(index) + ((1UL << shift) - 1);
+}
+
+/*---------------------------------------------------------------------------------*/
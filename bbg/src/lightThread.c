@@ -36,6 +36,8 @@
 #include "platform.h"
 #include "healthMonitor.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_LIGHT_THREAD);
+
 #define DEFAULT_POWER_STATE         (APDS9301_CTRL_POWERUP)
 #define DEFAULT_TIMING_GAIN         (APDS9301_TIMING_GAIN_LOW)
 #define DEFAULT_TIMING_INTEGRATION  (APDS9301_TIMING_INT_101)
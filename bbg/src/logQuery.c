@@ -0,0 +1,190 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 5, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logQuery.c
+ * @brief print the records of a log file matching a time range, msg types,
+ * process and/or source, using the log's sidecar index (logger_index.h) to
+ * read only the chunks that can match
+ *
+ * usage: logQuery [-t from:to] [-m msgId]... [-p process]... [-s sourceId]
+ *                 [-c] [-S] [logfile]      (default /usr/bin/log.bin)
+ *  -t  time range in usec, either end may be left empty
+ *  -m  logMsg_e value, repeat for more than one
+ *  -p  ProcessId_e value or name (PID_REMOTE_DATA), repeat for more than one;
+ *      PID_END selects main and shared files
+ *  -s  sourceId (thread ID on the BBG, task number on the TIVA)
+ *  -c  count matches instead of printing them
+ *  -S  ignore the index, scan the whole file
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_reader.h"
+#include "logger_index.h"
+#include "healthMonitor.h"
+
+#define DEFAULT_LOG_FILE        "/usr/bin/log.bin"
+
+static LogReader_t reader;
+
+static void printMatch(logItem_t *pLogItem, void *pArg);
+static void countMatch(logItem_t *pLogItem, void *pArg);
+static uint8_t parseTimeRange(const char *pArg, LogIndexQuery_t *pQuery);
+static uint8_t parsePid(const char *pArg, uint32_t *pPid);
+
+/*---------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *pLogFile = DEFAULT_LOG_FILE;
+    LogIndexEntry_t *pEntries = NULL;
+    uint32_t numEntries = 0, value;
+    LogIndexQuery_t query;
+    LogIndexStats_t stats;
+    struct timespec start, end;
+    uint8_t countOnly = 0, fullScan = 0;
+    int opt;
+
+    log_index_query_init(&query);
+    while((opt = getopt(argc, argv, "t:m:p:s:cS")) != -1) {
+        switch(opt) {
+            case 't':
+                if(parseTimeRange(optarg, &query) != LOG_STATUS_OK) {
+                    ERROR_PRINT("bad time range %s, expected from:to\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm':
+                value = (uint32_t)strtoul(optarg, NULL, 0);
+                if(value >= LOG_MSG_END) {
+                    ERROR_PRINT("bad msgId %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                query.msgMask = ((query.msgMask == LOG_INDEX_ALL) ? 0 : query.msgMask) | (1UL << value);
+                break;
+            case 'p':
+                if(parsePid(optarg, &value) != LOG_STATUS_OK) {
+                    ERROR_PRINT("bad process %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                query.pidMask = ((query.pidMask == LOG_INDEX_ALL) ? 0 : query.pidMask) | (1UL << value);
+                break;
+            case 's':
+                query.anySource = 0;
+                query.sourceId = (uint16_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                countOnly = 1;
+                break;
+            case 'S':
+                fullScan = 1;
+                break;
+            default:
+                ERROR_PRINT("usage: %s [-t from:to] [-m msgId]... [-p process]... [-s sourceId] [-c] [-S] [logfile]\n",
+                            argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(optind < argc) {
+        pLogFile = argv[optind];
+    }
+
+    if(log_reader_open(&reader, pLogFile) != LOG_STATUS_OK)
+        return EXIT_FAILURE;
+    if(!fullScan && (log_index_load(pLogFile, &pEntries, &numEntries) != LOG_STATUS_OK)) {
+        WARN_PRINT("no index for %s, scanning whole file\n", pLogFile);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    log_index_query(&reader, pEntries, numEntries, &query, countOnly ? countMatch : printMatch, NULL, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if(countOnly)
+        printf("%u\n", stats.matched);
+    fprintf(stderr, "%u matched, %u records read, %u of %u chunks read, %llu bytes unindexed, %.3f ms\n",
+            stats.matched, stats.scanned, stats.chunksRead, numEntries, (unsigned long long)stats.bytesUnindexed,
+            ((end.tv_sec - start.tv_sec) * 1e3) + ((end.tv_nsec - start.tv_nsec) * 1e-6));
+
+    free(pEntries);
+    log_reader_close(&reader);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printMatch(logItem_t *pLogItem, void *pArg)
+{
+    log_reader_print_item(pLogItem);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void countMatch(logItem_t *pLogItem, void *pArg)
+{
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief "from:to", "from:" or ":to", usec
+ */
+static uint8_t parseTimeRange(const char *pArg, LogIndexQuery_t *pQuery)
+{
+    const char *pColon = strchr(pArg, ':');
+    char *pEnd;
+
+    if(pColon == NULL)
+        return LOG_STATUS_NOTOK;
+    if(pColon != pArg) {
+        pQuery->minTime = (uint32_t)strtoul(pArg, &pEnd, 0);
+        if(pEnd != pColon)
+            return LOG_STATUS_NOTOK;
+    }
+    if(pColon[1] != '\0') {
+        pQuery->maxTime = (uint32_t)strtoul(&pColon[1], &pEnd, 0);
+        if(*pEnd != '\0')
+            return LOG_STATUS_NOTOK;
+    }
+    return (pQuery->minTime <= pQuery->maxTime) ? LOG_STATUS_OK : LOG_STATUS_NOTOK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief ProcessId_e by number or getPidString() name
+ */
+static uint8_t parsePid(const char *pArg, uint32_t *pPid)
+{
+    char *pEnd;
+    uint32_t ind;
+
+    *pPid = (uint32_t)strtoul(pArg, &pEnd, 0);
+    if((pEnd != pArg) && (*pEnd == '\0'))
+        return (*pPid <= PID_END) ? LOG_STATUS_OK : LOG_STATUS_NOTOK;
+
+    /* processes without a name of their own also come back as "PID_END" */
+    if(strcmp(pArg, getPidString(PID_END)) == 0) {
+        *pPid = PID_END;
+        return LOG_STATUS_OK;
+    }
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(strcmp(pArg, getPidString((ProcessId_e)ind)) == 0) {
+            *pPid = ind;
+            return LOG_STATUS_OK;
+        }
+    }
+    return LOG_STATUS_NOTOK;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,133 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 2, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logTail.c
+ * @brief print records from the newest log segment and, with -f, keep
+ * following new records (and new segments) while the logger is running
+ *
+ * usage: logTail [-f] [logfile]    (default /usr/bin/log.bin)
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_segment.h"
+#include "logger_reader.h"
+
+#define DEFAULT_LOG_FILE        "/usr/bin/log.bin"
+#define TAIL_POLL_USEC          (100000)
+
+static volatile sig_atomic_t aliveFlag = 1;
+static LogReader_t reader;
+
+static void tailSigHandler(int signo);
+static uint8_t openSegment(const char *pBasePath, uint32_t seq);
+
+/*---------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *pLogFile = DEFAULT_LOG_FILE;
+    uint32_t oldest, newest, seq;
+    uint8_t follow = 0;
+    logItem_t logItem;
+    uint8_t ret;
+    int opt;
+
+    while((opt = getopt(argc, argv, "f")) != -1) {
+        switch(opt) {
+            case 'f':
+                follow = 1;
+                break;
+            default:
+                ERROR_PRINT("usage: %s [-f] [logfile]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(optind < argc) {
+        pLogFile = argv[optind];
+    }
+    signal(SIGINT, tailSigHandler);
+    signal(SIGTERM, tailSigHandler);
+
+    /* not segmented, just dump the file */
+    if(log_segment_find(pLogFile, &oldest, &newest) != LOG_STATUS_OK)
+    {
+        if(log_reader_open(&reader, pLogFile) != LOG_STATUS_OK)
+            return EXIT_FAILURE;
+        while(aliveFlag && ((ret = log_reader_next(&reader, &logItem)) != LOG_STATUS_EOF)) {
+            if(ret == LOG_STATUS_OK)
+                log_reader_print_item(&logItem);
+        }
+        log_reader_close(&reader);
+        return EXIT_SUCCESS;
+    }
+
+    seq = newest;
+    if(openSegment(pLogFile, seq) != LOG_STATUS_OK)
+        return EXIT_FAILURE;
+
+    while(aliveFlag)
+    {
+        ret = log_reader_next(&reader, &logItem);
+        if(ret == LOG_STATUS_OK) {
+            log_reader_print_item(&logItem);
+            continue;
+        }
+        if(ret != LOG_STATUS_EOF)
+            continue;
+
+        /* caught up */
+        if(follow == 0)
+            break;
+        fflush(stdout);
+
+        /* writer moved to the next segment; finish this one first, a
+         * record may have been committed just before it was closed */
+        if(reader.segmentClosed) {
+            if((log_segment_find(pLogFile, &oldest, &newest) == LOG_STATUS_OK) && (newest > seq)) {
+                log_reader_close(&reader);
+                if(openSegment(pLogFile, ++seq) != LOG_STATUS_OK)
+                    return EXIT_FAILURE;
+                continue;
+            }
+        }
+        usleep(TAIL_POLL_USEC);
+        if(log_reader_refresh(&reader) != LOG_STATUS_OK)
+            break;
+    }
+
+    log_reader_close(&reader);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t openSegment(const char *pBasePath, uint32_t seq)
+{
+    char path[LOG_SEGMENT_PATH_SIZE];
+
+    if(log_segment_path(path, pBasePath, seq) != LOG_STATUS_OK)
+        return LOG_STATUS_NOTOK;
+    return log_reader_open(&reader, path);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void tailSigHandler(int signo)
+{
+    aliveFlag = 0;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,170 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 3, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_filter.c
+ * @brief runtime log filter settings and the per file masks built from them
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_files.h"
+#include "logger_filter.h"
+#include "healthMonitor.h"
+
+_Static_assert(LOG_MSG_END <= 32, "logger filter masks hold one bit per logMsg_e");
+_Static_assert(PID_END < 32, "logger filter holds one bit per ProcessId_e");
+
+/*---------------------------------------------------------------------------------*/
+/* everything logged until a setting changes */
+uint32_t logFilterMask[LOG_FILE_END] = { [0 ... (LOG_FILE_END - 1)] = LOG_FILTER_ALL_MSGS };
+
+#define LOG_FILE_PID_ENTRY(id, name, pid)   pid,
+static const ProcessId_e logFilePids[LOG_FILE_END] = {
+    LOG_FILE_TABLE(LOG_FILE_PID_ENTRY)
+};
+#undef LOG_FILE_PID_ENTRY
+
+static pthread_mutex_t filterLock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t msgsEnabled = LOG_FILTER_ALL_MSGS;     /* bit per logMsg_e */
+static uint32_t pidsEnabled = LOG_FILTER_ALL_MSGS;     /* bit per ProcessId_e, PID_END included */
+static LogLevel_e minLevel = LOGLVL_INFO;
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static void filter_rebuild(void);
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_filter_pass(uint16_t fileId, logMsg_e msgId)
+{
+    if((fileId >= LOG_FILE_END) || (msgId >= LOG_MSG_END))
+        return 1;
+    return (__atomic_load_n(&logFilterMask[fileId], __ATOMIC_RELAXED) & (1UL << msgId)) ? 1 : 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+LogLevel_e log_filter_msg_level(logMsg_e msgId)
+{
+    if(msgId == LOG_MSG_ERROR)
+        return LOGLVL_ERROR;
+    if(msgId == LOG_MSG_WARNING)
+        return LOGLVL_WARNING;
+    return LOGLVL_INFO;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_filter_set_level(LogLevel_e level)
+{
+    if(level > LOGLVL_ERROR)
+        return LOG_STATUS_NOTOK;
+
+    pthread_mutex_lock(&filterLock);
+    minLevel = level;
+    filter_rebuild();
+    pthread_mutex_unlock(&filterLock);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_filter_set_msg(logMsg_e msgId, uint8_t enable)
+{
+    if(msgId >= LOG_MSG_END)
+        return LOG_STATUS_NOTOK;
+
+    pthread_mutex_lock(&filterLock);
+    if(enable)
+        msgsEnabled |= (1UL << msgId);
+    else
+        msgsEnabled &= ~(1UL << msgId);
+    filter_rebuild();
+    pthread_mutex_unlock(&filterLock);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_filter_set_process(ProcessId_e procId, uint8_t enable)
+{
+    if(procId > PID_END)
+        return LOG_STATUS_NOTOK;
+
+    pthread_mutex_lock(&filterLock);
+    if(enable)
+        pidsEnabled |= (1UL << procId);
+    else
+        pidsEnabled &= ~(1UL << procId);
+    filter_rebuild();
+    pthread_mutex_unlock(&filterLock);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_filter_reset(void)
+{
+    pthread_mutex_lock(&filterLock);
+    msgsEnabled = LOG_FILTER_ALL_MSGS;
+    pidsEnabled = LOG_FILTER_ALL_MSGS;
+    minLevel = LOGLVL_INFO;
+    filter_rebuild();
+    pthread_mutex_unlock(&filterLock);
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_filter_print(void)
+{
+    uint32_t ind;
+
+    pthread_mutex_lock(&filterLock);
+    printf("log filter: level %s\n", (minLevel == LOGLVL_ERROR) ? "ERROR" :
+           ((minLevel == LOGLVL_WARNING) ? "WARNING" : "INFO"));
+    printf("  msgs disabled:");
+    for(ind = 1; ind < LOG_MSG_END; ++ind)
+    {
+        if((msgsEnabled & (1UL << ind)) == 0)
+            printf(" %u", ind);
+    }
+    printf("\n  processes disabled:");
+    for(ind = 0; ind <= PID_END; ++ind)
+    {
+        if((pidsEnabled & (1UL << ind)) == 0)
+            printf(" %u(%s)", ind, (ind == PID_END) ? "main/shared" : getPidString((ProcessId_e)ind));
+    }
+    printf("\n");
+    pthread_mutex_unlock(&filterLock);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief fold settings into the per file masks; filterLock held
+ */
+static void filter_rebuild(void)
+{
+    uint32_t levelMask = 0, mask;
+    uint32_t ind;
+
+    for(ind = 0; ind < LOG_MSG_END; ++ind)
+    {
+        if(log_filter_msg_level((logMsg_e)ind) >= minLevel)
+            levelMask |= (1UL << ind);
+    }
+
+    for(ind = 0; ind < LOG_FILE_END; ++ind)
+    {
+        mask = 0;
+        if(pidsEnabled & (1UL << logFilePids[ind]))
+            mask = msgsEnabled & levelMask;
+        __atomic_store_n(&logFilterMask[ind], mask, __ATOMIC_RELAXED);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
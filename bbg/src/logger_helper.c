@@ -17,8 +17,13 @@
 
 
 #include "logger_types.h"
+#include "logger_files.h"
+#include "logger_helper.h"
+#include "conversion.h"
+#include "crc.h"
 #include "my_debug.h"
 #include <stddef.h>
+#include <string.h>
 
 /*---------------------------------------------------------------------------------*/
 #ifdef __linux__
@@ -34,6 +39,29 @@
 /*---------------------------------------------------------------------------------*/
 uint8_t firstCall = 1;
 
+#define LOG_FILE_NAME_ENTRY(id, name, pid)  name,
+static const char * const logFileNames[LOG_FILE_END] = {
+	LOG_FILE_TABLE(LOG_FILE_NAME_ENTRY)
+};
+#undef LOG_FILE_NAME_ENTRY
+
+/* running crc of each name, 0 until computed; racing threads compute
+ * and store the same value */
+static uint32_t logFileNameCrcs[LOG_FILE_END];
+
+#ifdef __linux__
+	#include <sched.h>
+	#define LOG_LAST_READ_TRIES		(100)
+
+	/* latest item per source; seq is odd while written, key is sourceId + 1
+	 * and 0 while the slot is free */
+	static struct {
+		uint32_t seq;
+		uint32_t key;
+		logLastItem_t item;
+	} lastItems[LOG_LAST_SLOTS];
+#endif
+
 /*---------------------------------------------------------------------------------*/
 uint32_t log_get_time(void)
 {
@@ -65,31 +93,56 @@ static struct timespec start_time, log_time;
 
 /*---------------------------------------------------------------------------------*/
 void log_set_checksum(logItem_t *pLogItem)
+{
+	pLogItem->checksum = log_calc_checksum(pLogItem);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_calc_checksum(logItem_t *pLogItem)
+{
+	uint8_t fields[LOG_CHECKSUM_FIELDS_SIZE];
+	uint32_t crc;
+
+	/* name first so its part of the crc can be cached per file ID */
+	if(pLogItem->pFilename != NULL)
+		crc = crc32c_update(CRC32C_INIT, pLogItem->pFilename, log_strlen(pLogItem->pFilename) - 1);
+	else
+		crc = log_file_name_crc(pLogItem->fileId);
+
+	fields[0] = (uint8_t)pLogItem->logMsgId;
+	fields[1] = (uint8_t)pLogItem->lineNum;
+	fields[2] = (uint8_t)(pLogItem->lineNum >> 8);
+	fields[3] = (uint8_t)pLogItem->sourceId;
+	fields[4] = (uint8_t)(pLogItem->sourceId >> 8);
+	fields[5] = (uint8_t)pLogItem->time;
+	fields[6] = (uint8_t)(pLogItem->time >> 8);
+	fields[7] = (uint8_t)(pLogItem->time >> 16);
+	fields[8] = (uint8_t)(pLogItem->time >> 24);
+	fields[9] = (uint8_t)pLogItem->payloadLength;
+	fields[10] = (uint8_t)(pLogItem->payloadLength >> 8);
+	crc = crc32c_update(crc, fields, sizeof(fields));
+
+	if((pLogItem->payloadLength > 0) && (pLogItem->pPayload != NULL))
+		crc = crc32c_update(crc, pLogItem->pPayload, pLogItem->payloadLength);
+	return crc32c_finish(crc);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_calc_byte_sum(logItem_t *pLogItem)
 {
 	uint32_t sum = pLogItem->logMsgId + pLogItem->lineNum
 			+ pLogItem->time + pLogItem->payloadLength + pLogItem->sourceId;
-
 	uint8_t *ptr = pLogItem->pFilename;
-	if (ptr == NULL)
-		return;
+	uint32_t ind;
 
-	while(*ptr != '\0')
-	{
-		sum += *ptr;
-		++ptr;
-	}
+	while((ptr != NULL) && (*ptr != '\0'))
+		sum += *ptr++;
 
-	uint32_t ind = 0;
 	ptr = pLogItem->pPayload;
-	for(;ind < pLogItem->payloadLength; ++ind)
-	{
-		sum += *ptr;
-		++ptr;
-	}
+	for(ind = 0; (ptr != NULL) && (ind < pLogItem->payloadLength); ++ind)
+		sum += ptr[ind];
 
-	pLogItem->checksum = sum;
-
-	return;
+	return sum;
 }
 
 /*---------------------------------------------------------------------------------*/
@@ -106,3 +159,140 @@ uint32_t log_strlen(uint8_t *pStr)
 }
 
 /*---------------------------------------------------------------------------------*/
+const char *log_file_name(uint16_t fileId)
+{
+	if(fileId >= LOG_FILE_END)
+		fileId = LOG_FILE_UNKNOWN;
+	return logFileNames[fileId];
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_file_name_crc(uint16_t fileId)
+{
+	const char *pName;
+	uint32_t crc;
+
+	if(fileId >= LOG_FILE_END)
+		fileId = LOG_FILE_UNKNOWN;
+	if(logFileNameCrcs[fileId] != 0)
+		return logFileNameCrcs[fileId];
+
+	pName = logFileNames[fileId];
+	crc = crc32c_update(CRC32C_INIT, (const uint8_t *)pName, strlen(pName));
+	logFileNameCrcs[fileId] = crc;
+	return crc;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t *log_item_filename(logItem_t *pLogItem)
+{
+	if(pLogItem->pFilename != NULL)
+		return pLogItem->pFilename;
+	return (uint8_t *)log_file_name(pLogItem->fileId);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_render_item(logItem_t *pLogItem)
+{
+	uint32_t value;
+
+	switch(pLogItem->payloadFormat)
+	{
+		case LOG_PAYLOAD_EVENT:
+			if((pLogItem->pPayload == NULL) || (pLogItem->payloadLength != sizeof(value)))
+				return LOG_STATUS_NOTOK;
+			memcpy(&value, pLogItem->pPayload, sizeof(value));
+			pLogItem->payloadLength = my_itoa((int32_t)value, pLogItem->pPayload, HEX_BASE);
+			break;
+		case LOG_PAYLOAD_STRING:
+			/* not packed, written straight from the producer's string */
+			pLogItem->payloadLength = log_strlen(pLogItem->pPayload);
+			break;
+		case LOG_PAYLOAD_TEXT:
+			break;
+		default:
+			return LOG_STATUS_NOTOK;
+	}
+	pLogItem->payloadFormat = LOG_PAYLOAD_TEXT;
+	log_set_checksum(pLogItem);
+	return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+#ifdef __linux__
+void log_note_item(const logItem_t *pLogItem)
+{
+	uint32_t key = (uint32_t)pLogItem->sourceId + 1;
+	uint32_t home = pLogItem->sourceId % LOG_LAST_SLOTS;
+	uint32_t ind, slot = home, found, seq;
+
+	/* open addressing from the source's home slot; sources are only added,
+	 * so once the table is full newcomers overwrite their home slot */
+	for(ind = 0; ind < LOG_LAST_SLOTS; ++ind)
+	{
+		slot = (home + ind) % LOG_LAST_SLOTS;
+		found = __atomic_load_n(&lastItems[slot].key, __ATOMIC_RELAXED);
+		/* a failed claim leaves found set to whoever beat us to it */
+		if(found == 0)
+			__atomic_compare_exchange_n(&lastItems[slot].key, &found, key, 0,
+			                            __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+		if((found == 0) || (found == key))
+			break;
+	}
+	if(ind == LOG_LAST_SLOTS)
+		slot = home;
+
+	/* a shared slot can have two writers, claim it by making seq odd */
+	seq = __atomic_load_n(&lastItems[slot].seq, __ATOMIC_RELAXED);
+	do {
+		while(seq & 1) {
+			sched_yield();
+			seq = __atomic_load_n(&lastItems[slot].seq, __ATOMIC_RELAXED);
+		}
+	} while(!__atomic_compare_exchange_n(&lastItems[slot].seq, &seq, seq + 1, 1,
+	                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	__atomic_store_n(&lastItems[slot].key, key, __ATOMIC_RELAXED);
+	__atomic_store_n(&lastItems[slot].item.sourceId, pLogItem->sourceId, __ATOMIC_RELAXED);
+	__atomic_store_n(&lastItems[slot].item.fileId, pLogItem->fileId, __ATOMIC_RELAXED);
+	__atomic_store_n(&lastItems[slot].item.lineNum, pLogItem->lineNum, __ATOMIC_RELAXED);
+	__atomic_store_n(&lastItems[slot].item.logMsgId, (uint8_t)pLogItem->logMsgId, __ATOMIC_RELAXED);
+	__atomic_store_n(&lastItems[slot].item.time, pLogItem->time, __ATOMIC_RELAXED);
+	__atomic_store_n(&lastItems[slot].seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_last_items(logLastItem_t *pItems, uint8_t max)
+{
+	uint32_t slot, seq, tries;
+	uint8_t count = 0;
+
+	for(slot = 0; (slot < LOG_LAST_SLOTS) && (count < max); ++slot)
+	{
+		if(__atomic_load_n(&lastItems[slot].key, __ATOMIC_ACQUIRE) == 0)
+			continue;
+
+		/* bounded, the reader may be reporting on a writer that is stuck */
+		tries = 0;
+		do {
+			seq = __atomic_load_n(&lastItems[slot].seq, __ATOMIC_ACQUIRE);
+			if(seq & 1)
+				continue;
+			pItems[count].sourceId = __atomic_load_n(&lastItems[slot].item.sourceId, __ATOMIC_RELAXED);
+			pItems[count].fileId = __atomic_load_n(&lastItems[slot].item.fileId, __ATOMIC_RELAXED);
+			pItems[count].lineNum = __atomic_load_n(&lastItems[slot].item.lineNum, __ATOMIC_RELAXED);
+			pItems[count].logMsgId = __atomic_load_n(&lastItems[slot].item.logMsgId, __ATOMIC_RELAXED);
+			pItems[count].time = __atomic_load_n(&lastItems[slot].item.time, __ATOMIC_RELAXED);
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if(__atomic_load_n(&lastItems[slot].seq, __ATOMIC_RELAXED) == seq)
+				break;
+		} while(++tries < LOG_LAST_READ_TRIES);
+
+		if((tries < LOG_LAST_READ_TRIES) && (seq != 0))
+			++count;
+	}
+	return count;
+}
+#endif
+
+/*---------------------------------------------------------------------------------*/
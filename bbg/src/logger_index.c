@@ -0,0 +1,460 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 5, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_index.c
+ * @brief sidecar log index, written by the log sink and read by queries
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_files.h"
+#include "logger_format.h"
+#include "logger_helper.h"
+#include "logger_index.h"
+#include "crc.h"
+
+_Static_assert(LOG_MSG_END <= 32, "index msg mask holds one bit per logMsg_e");
+_Static_assert(PID_END < 32, "index process mask holds one bit per ProcessId_e");
+
+#define LOG_INDEX_ENTRY_CRC_OFFSET  (LOG_INDEX_ENTRY_SIZE - 4)
+#define LOG_INDEX_ALL_SOURCES       (0xFFFFFFFFFFFFFFFFULL)
+
+#define LOG_FILE_PID_ENTRY(id, name, pid)   pid,
+static const ProcessId_e logIndexPids[LOG_FILE_END] = {
+    LOG_FILE_TABLE(LOG_FILE_PID_ENTRY)
+};
+#undef LOG_FILE_PID_ENTRY
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static uint8_t log_index_path(char *pPath, const char *pLogPath);
+static uint8_t log_index_write_entry(LogIndex_t *pIndex);
+static void log_index_encode(const LogIndexEntry_t *pEntry, uint8_t *pBuf);
+static uint8_t log_index_decode(const uint8_t *pBuf, LogIndexEntry_t *pEntry);
+static ProcessId_e log_index_item_pid(logItem_t *pLogItem);
+static uint8_t log_index_scan(LogReader_t *pReader, uint64_t start, uint64_t end, const LogIndexQuery_t *pQuery,
+                              logQueryFunc_t func, void *pArg, LogIndexStats_t *pStats);
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_index_open(LogIndex_t *pIndex, const char *pLogPath, uint64_t logEnd)
+{
+    uint8_t hdr[LOG_INDEX_HDR_SIZE];
+    uint8_t buf[LOG_INDEX_ENTRY_SIZE];
+    LogIndexEntry_t entry;
+    struct stat fileStat;
+    uint64_t keep;
+
+    if((pIndex == NULL) || (pLogPath == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+    memset(pIndex, 0, sizeof(*pIndex));
+    pIndex->fd = -1;
+    if(log_index_path(pIndex->path, pLogPath) != LOG_STATUS_OK) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    pIndex->fd = open(pIndex->path, O_CREAT | O_RDWR, 0644);
+    if((pIndex->fd < 0) || (fstat(pIndex->fd, &fileStat) != 0)) {
+        ERRNO_PRINT("log_index_open failed");
+        if(pIndex->fd >= 0)
+            close(pIndex->fd);
+        pIndex->fd = -1;
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* keep whole entries, up to the first one that doesn't describe the
+     * log as it is (torn by a crash, or left from a log since replaced) */
+    keep = 0;
+    if((fileStat.st_size >= LOG_INDEX_HDR_SIZE) &&
+       (pread(pIndex->fd, hdr, sizeof(hdr), 0) == sizeof(hdr)) &&
+       (memcmp(hdr, LOG_INDEX_MAGIC, LOG_INDEX_MAGIC_SIZE) == 0) &&
+       (log_get_le16(&hdr[4]) == LOG_INDEX_VERSION) &&
+       (log_get_le16(&hdr[8]) == LOG_INDEX_ENTRY_SIZE)) {
+        keep = LOG_INDEX_HDR_SIZE;
+        while(((keep + LOG_INDEX_ENTRY_SIZE) <= (uint64_t)fileStat.st_size) &&
+              (pread(pIndex->fd, buf, sizeof(buf), (off_t)keep) == sizeof(buf)) &&
+              (log_index_decode(buf, &entry) == LOG_STATUS_OK) && (entry.end <= logEnd)) {
+            keep += LOG_INDEX_ENTRY_SIZE;
+        }
+    }
+    if(keep == 0)
+    {
+        memset(hdr, 0, sizeof(hdr));
+        memcpy(&hdr[0], LOG_INDEX_MAGIC, LOG_INDEX_MAGIC_SIZE);
+        log_put_le16(&hdr[4], LOG_INDEX_VERSION);
+        log_put_le16(&hdr[6], LOG_INDEX_HDR_SIZE);
+        log_put_le16(&hdr[8], LOG_INDEX_ENTRY_SIZE);
+        if(pwrite(pIndex->fd, hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+            ERRNO_PRINT("log_index_open header write failed");
+            close(pIndex->fd);
+            pIndex->fd = -1;
+            return LOG_STATUS_NOTOK;
+        }
+        keep = LOG_INDEX_HDR_SIZE;
+    }
+    if((ftruncate(pIndex->fd, (off_t)keep) != 0) || (lseek(pIndex->fd, 0, SEEK_END) < 0)) {
+        ERRNO_PRINT("log_index_open truncate failed");
+        close(pIndex->fd);
+        pIndex->fd = -1;
+        return LOG_STATUS_NOTOK;
+    }
+
+    pIndex->flushedEnd = logEnd;
+    pIndex->chunk.start = logEnd;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_index_add(LogIndex_t *pIndex, logItem_t *pLogItem)
+{
+    LogIndexEntry_t *pChunk = &pIndex->chunk;
+    uint8_t newChunk = (pChunk->records == 0);
+    uint64_t start = pChunk->start;
+
+    if(newChunk)
+    {
+        memset(pChunk, 0, sizeof(*pChunk));
+        pChunk->start = start;
+        pChunk->minTime = pLogItem->time;
+        pChunk->maxTime = pLogItem->time;
+    }
+    ++pChunk->records;
+    if(pLogItem->time < pChunk->minTime)
+        pChunk->minTime = pLogItem->time;
+    if(pLogItem->time > pChunk->maxTime)
+        pChunk->maxTime = pLogItem->time;
+    if((uint32_t)pLogItem->logMsgId < 32)
+        pChunk->msgMask |= (1UL << pLogItem->logMsgId);
+    pChunk->pidMask |= (1UL << log_index_item_pid(pLogItem));
+    pChunk->sourceMask |= LOG_INDEX_SOURCE_BIT(pLogItem->sourceId);
+    return newChunk;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_index_flushed(LogIndex_t *pIndex, uint64_t logEnd)
+{
+    pIndex->flushedEnd = logEnd;
+    if(pIndex->chunk.records < LOG_INDEX_CHUNK_RECORDS)
+        return LOG_STATUS_OK;
+    return log_index_write_entry(pIndex);
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_index_close(LogIndex_t *pIndex)
+{
+    if((pIndex == NULL) || (pIndex->fd < 0)) {
+        return;
+    }
+    if(pIndex->chunk.records > 0)
+        log_index_write_entry(pIndex);
+    close(pIndex->fd);
+    pIndex->fd = -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_index_load(const char *pLogPath, LogIndexEntry_t **ppEntries, uint32_t *pNum)
+{
+    char path[LOG_INDEX_PATH_SIZE];
+    uint8_t *pData = NULL;
+    LogIndexEntry_t *pEntries;
+    struct stat fileStat;
+    uint32_t num, ind;
+    ssize_t ret;
+    size_t got = 0;
+    int fd;
+
+    if((pLogPath == NULL) || (ppEntries == NULL) || (pNum == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+    *ppEntries = NULL;
+    *pNum = 0;
+    if(log_index_path(path, pLogPath) != LOG_STATUS_OK) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return LOG_STATUS_NOTOK;
+    }
+    if((fstat(fd, &fileStat) != 0) || (fileStat.st_size < LOG_INDEX_HDR_SIZE) ||
+       ((pData = malloc(fileStat.st_size)) == NULL)) {
+        close(fd);
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* one read; the writer only ever appends whole entries */
+    while(got < (size_t)fileStat.st_size)
+    {
+        ret = read(fd, &pData[got], fileStat.st_size - got);
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            break;
+        }
+        if(ret == 0)
+            break;
+        got += ret;
+    }
+    close(fd);
+    if((got < LOG_INDEX_HDR_SIZE) || (memcmp(pData, LOG_INDEX_MAGIC, LOG_INDEX_MAGIC_SIZE) != 0) ||
+       (log_get_le16(&pData[4]) != LOG_INDEX_VERSION) ||
+       (log_get_le16(&pData[8]) != LOG_INDEX_ENTRY_SIZE)) {
+        free(pData);
+        return LOG_STATUS_NOTOK;
+    }
+
+    num = (got - LOG_INDEX_HDR_SIZE) / LOG_INDEX_ENTRY_SIZE;
+    pEntries = malloc(((num > 0) ? num : 1) * sizeof(LogIndexEntry_t));
+    if(pEntries == NULL) {
+        free(pData);
+        return LOG_STATUS_NOTOK;
+    }
+    *pNum = 0;
+    for(ind = 0; ind < num; ++ind)
+    {
+        if(log_index_decode(&pData[LOG_INDEX_HDR_SIZE + (ind * LOG_INDEX_ENTRY_SIZE)],
+                            &pEntries[*pNum]) != LOG_STATUS_OK)
+            continue;
+
+        /* chunks are appended in file order; anything else isn't trusted */
+        if((*pNum > 0) && (pEntries[*pNum].start < pEntries[*pNum - 1].end))
+            continue;
+        ++(*pNum);
+    }
+    free(pData);
+    *ppEntries = pEntries;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_index_query_init(LogIndexQuery_t *pQuery)
+{
+    pQuery->minTime = 0;
+    pQuery->maxTime = 0xFFFFFFFFUL;
+    pQuery->msgMask = LOG_INDEX_ALL;
+    pQuery->pidMask = LOG_INDEX_ALL;
+    pQuery->anySource = 1;
+    pQuery->sourceId = 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_index_match_item(const LogIndexQuery_t *pQuery, logItem_t *pLogItem)
+{
+    if((pLogItem->time < pQuery->minTime) || (pLogItem->time > pQuery->maxTime))
+        return 0;
+    if(((uint32_t)pLogItem->logMsgId >= 32) || ((pQuery->msgMask & (1UL << pLogItem->logMsgId)) == 0))
+        return 0;
+    if(!pQuery->anySource && (pLogItem->sourceId != pQuery->sourceId))
+        return 0;
+
+    /* name lookup only when asked for */
+    if((pQuery->pidMask != LOG_INDEX_ALL) &&
+       ((pQuery->pidMask & (1UL << log_index_item_pid(pLogItem))) == 0))
+        return 0;
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_index_match_entry(const LogIndexQuery_t *pQuery, const LogIndexEntry_t *pEntry)
+{
+    uint64_t sourceMask = pQuery->anySource ? LOG_INDEX_ALL_SOURCES : LOG_INDEX_SOURCE_BIT(pQuery->sourceId);
+
+    return (pEntry->maxTime >= pQuery->minTime) && (pEntry->minTime <= pQuery->maxTime) &&
+           ((pEntry->msgMask & pQuery->msgMask) != 0) && ((pEntry->pidMask & pQuery->pidMask) != 0) &&
+           ((pEntry->sourceMask & sourceMask) != 0);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_index_query(LogReader_t *pReader, const LogIndexEntry_t *pEntries, uint32_t numEntries,
+                        const LogIndexQuery_t *pQuery, logQueryFunc_t func, void *pArg,
+                        LogIndexStats_t *pStats)
+{
+    LogIndexStats_t stats;
+    uint64_t cursor = 0;
+    uint32_t ind;
+
+    if((pReader == NULL) || (pQuery == NULL) || (func == NULL) || ((numEntries > 0) && (pEntries == NULL))) {
+        return LOG_STATUS_NOTOK;
+    }
+    memset(&stats, 0, sizeof(stats));
+
+    for(ind = 0; ind < numEntries; ++ind)
+    {
+        /* log written with no index entry */
+        if(pEntries[ind].start > cursor) {
+            stats.bytesUnindexed += pEntries[ind].start - cursor;
+            if(log_index_scan(pReader, cursor, pEntries[ind].start, pQuery, func, pArg, &stats) != LOG_STATUS_OK)
+                break;
+        }
+        cursor = pEntries[ind].end;
+
+        if(!log_index_match_entry(pQuery, &pEntries[ind])) {
+            ++stats.chunksSkipped;
+            continue;
+        }
+        ++stats.chunksRead;
+
+        /* chunk may follow its session header; indexed sessions are all
+         * CRC checksummed */
+        pReader->sessionCrc = 1;
+        if(log_index_scan(pReader, pEntries[ind].start, pEntries[ind].end, pQuery, func, pArg, &stats) != LOG_STATUS_OK)
+            break;
+    }
+
+    /* rest of file, everything when there is no index */
+    if((ind == numEntries) &&
+       (log_index_scan(pReader, cursor, 0, pQuery, func, pArg, &stats) == LOG_STATUS_OK)) {
+        stats.bytesUnindexed += log_reader_tell(pReader) - cursor;
+    }
+
+    if(pStats != NULL)
+        *pStats = stats;
+    return (ind == numEntries) ? LOG_STATUS_OK : LOG_STATUS_NOTOK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief read records from start up to end (0: end of file), passing
+ * matching ones to func
+ */
+static uint8_t log_index_scan(LogReader_t *pReader, uint64_t start, uint64_t end, const LogIndexQuery_t *pQuery,
+                              logQueryFunc_t func, void *pArg, LogIndexStats_t *pStats)
+{
+    logItem_t logItem;
+    uint8_t ret;
+
+    if(log_reader_seek(pReader, start) != LOG_STATUS_OK)
+        return LOG_STATUS_NOTOK;
+
+    while((end == 0) || (log_reader_tell(pReader) < end))
+    {
+        ret = log_reader_next(pReader, &logItem);
+        if(ret == LOG_STATUS_EOF)
+            break;
+        if(ret != LOG_STATUS_OK)
+            continue;
+        ++pStats->scanned;
+        if(log_index_match_item(pQuery, &logItem)) {
+            ++pStats->matched;
+            func(&logItem, pArg);
+        }
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief entry for the open chunk, through the last flushed byte
+ */
+static uint8_t log_index_write_entry(LogIndex_t *pIndex)
+{
+    uint8_t buf[LOG_INDEX_ENTRY_SIZE];
+    ssize_t ret;
+
+    pIndex->chunk.end = pIndex->flushedEnd;
+    log_index_encode(&pIndex->chunk, buf);
+    pIndex->chunk.records = 0;
+    pIndex->chunk.start = pIndex->flushedEnd;
+
+    do {
+        ret = write(pIndex->fd, buf, sizeof(buf));
+    } while((ret < 0) && (errno == EINTR));
+    if(ret != sizeof(buf)) {
+        ERRNO_PRINT("log index write failed");
+        return LOG_STATUS_NOTOK;
+    }
+    ++pIndex->entries;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void log_index_encode(const LogIndexEntry_t *pEntry, uint8_t *pBuf)
+{
+    log_put_le32(&pBuf[0], (uint32_t)pEntry->start);
+    log_put_le32(&pBuf[4], (uint32_t)(pEntry->start >> 32));
+    log_put_le32(&pBuf[8], (uint32_t)pEntry->end);
+    log_put_le32(&pBuf[12], (uint32_t)(pEntry->end >> 32));
+    log_put_le32(&pBuf[16], pEntry->records);
+    log_put_le32(&pBuf[20], pEntry->minTime);
+    log_put_le32(&pBuf[24], pEntry->maxTime);
+    log_put_le32(&pBuf[28], pEntry->msgMask);
+    log_put_le32(&pBuf[32], pEntry->pidMask);
+    log_put_le32(&pBuf[36], (uint32_t)pEntry->sourceMask);
+    log_put_le32(&pBuf[40], (uint32_t)(pEntry->sourceMask >> 32));
+    log_put_le32(&pBuf[LOG_INDEX_ENTRY_CRC_OFFSET], crc32c(pBuf, LOG_INDEX_ENTRY_CRC_OFFSET));
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t log_index_decode(const uint8_t *pBuf, LogIndexEntry_t *pEntry)
+{
+    if(crc32c(pBuf, LOG_INDEX_ENTRY_CRC_OFFSET) != log_get_le32(&pBuf[LOG_INDEX_ENTRY_CRC_OFFSET]))
+        return LOG_STATUS_NOTOK;
+
+    pEntry->start = log_get_le32(&pBuf[0]) | ((uint64_t)log_get_le32(&pBuf[4]) << 32);
+    pEntry->end = log_get_le32(&pBuf[8]) | ((uint64_t)log_get_le32(&pBuf[12]) << 32);
+    pEntry->records = log_get_le32(&pBuf[16]);
+    pEntry->minTime = log_get_le32(&pBuf[20]);
+    pEntry->maxTime = log_get_le32(&pBuf[24]);
+    pEntry->msgMask = log_get_le32(&pBuf[28]);
+    pEntry->pidMask = log_get_le32(&pBuf[32]);
+    pEntry->sourceMask = log_get_le32(&pBuf[36]) | ((uint64_t)log_get_le32(&pBuf[40]) << 32);
+    return (pEntry->end >= pEntry->start) ? LOG_STATUS_OK : LOG_STATUS_NOTOK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief process owning the record's source file; records read back only
+ * have the name, matched on its cached crc before comparing strings
+ */
+static ProcessId_e log_index_item_pid(logItem_t *pLogItem)
+{
+    const char *pName;
+    uint32_t crc;
+    uint16_t fileId;
+
+    if(pLogItem->pFilename == NULL)
+        return (pLogItem->fileId < LOG_FILE_END) ? logIndexPids[pLogItem->fileId] : PID_END;
+
+    pName = (const char *)pLogItem->pFilename;
+    crc = crc32c_update(CRC32C_INIT, pLogItem->pFilename, strlen(pName));
+    for(fileId = 0; fileId < LOG_FILE_END; ++fileId)
+    {
+        if((log_file_name_crc(fileId) == crc) && (strcmp(log_file_name(fileId), pName) == 0))
+            return logIndexPids[fileId];
+    }
+    return PID_END;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief <logfile>.idx
+ */
+static uint8_t log_index_path(char *pPath, const char *pLogPath)
+{
+    int len = snprintf(pPath, LOG_INDEX_PATH_SIZE, "%s%s", pLogPath, LOG_INDEX_SUFFIX);
+
+    if((len < 0) || (len >= LOG_INDEX_PATH_SIZE)) {
+        ERROR_PRINT("log index path too long for %s\n", pLogPath);
+        return LOG_STATUS_NOTOK;
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
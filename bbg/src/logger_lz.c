@@ -0,0 +1,220 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 3, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_lz.c
+ * @brief LZ77 compressor (greedy, single entry hash table) and decompressor
+ *
+ ************************************************************************************
+ */
+
+#include <string.h>
+
+#include "logger_format.h"
+#include "logger_lz.h"
+
+#define LZ_HASH_BITS            (12)
+#define LZ_HASH_SIZE            (1 << LZ_HASH_BITS)
+#define LZ_NIBBLE_MAX           (15)
+#define LZ_LAST_LITERALS        (5)     /* matches stop short of the end of input */
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static uint8_t *lz_put_length(uint8_t *pOut, uint8_t *pOutEnd, uint32_t len);
+static uint8_t *lz_put_sequence(uint8_t *pOut, uint8_t *pOutEnd, const uint8_t *pLiterals,
+                                uint32_t litLen, uint32_t offset, uint32_t matchLen);
+
+static inline uint32_t lz_read32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t lz_hash(uint32_t value)
+{
+    return (value * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_lz_compress(const uint8_t *pSrc, uint32_t srcLen, uint8_t *pDst, uint32_t dstMax)
+{
+    uint16_t table[LZ_HASH_SIZE];       /* last input position seen per hash */
+    const uint8_t *pIn = pSrc, *pAnchor = pSrc;
+    const uint8_t *pMatchLimit = pSrc + srcLen - LZ_LAST_LITERALS;
+    const uint8_t *pRef;
+    uint8_t *pOut = pDst;
+    uint32_t hash, len;
+
+    if((pSrc == NULL) || (pDst == NULL) || (srcLen == 0) || (srcLen > LOG_LZ_MAX_INPUT)) {
+        return 0;
+    }
+    memset(table, 0, sizeof(table));
+
+    if(srcLen > (LZ_LAST_LITERALS + LOG_LZ_MIN_MATCH))
+    {
+        while((pIn + LOG_LZ_MIN_MATCH) <= pMatchLimit)
+        {
+            hash = lz_hash(lz_read32(pIn));
+            pRef = pSrc + table[hash];
+            table[hash] = (uint16_t)(pIn - pSrc);
+
+            /* the table only holds earlier positions, a stale one just misses */
+            if((pRef >= pIn) || (lz_read32(pRef) != lz_read32(pIn))) {
+                ++pIn;
+                continue;
+            }
+
+            len = LOG_LZ_MIN_MATCH;
+            while(((pIn + len) < pMatchLimit) && (pRef[len] == pIn[len]))
+                ++len;
+
+            pOut = lz_put_sequence(pOut, pDst + dstMax, pAnchor, (uint32_t)(pIn - pAnchor),
+                                   (uint32_t)(pIn - pRef), len);
+            if(pOut == NULL)
+                return 0;
+            pIn += len;
+            pAnchor = pIn;
+        }
+    }
+
+    /* whatever is left goes out as literals */
+    if(pAnchor < (pSrc + srcLen)) {
+        pOut = lz_put_sequence(pOut, pDst + dstMax, pAnchor, (uint32_t)((pSrc + srcLen) - pAnchor), 0, 0);
+        if(pOut == NULL)
+            return 0;
+    }
+    return (uint32_t)(pOut - pDst);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_lz_decompress(const uint8_t *pSrc, uint32_t srcLen, uint8_t *pDst, uint32_t dstMax)
+{
+    const uint8_t *pIn = pSrc, *pInEnd = pSrc + srcLen;
+    uint8_t *pOut = pDst, *pOutEnd = pDst + dstMax;
+    const uint8_t *pRef;
+    uint32_t len, offset;
+    uint8_t token, extra;
+
+    if((pSrc == NULL) || (pDst == NULL)) {
+        return 0;
+    }
+
+    while(pIn < pInEnd)
+    {
+        token = *pIn++;
+
+        len = token >> 4;
+        if(len == LZ_NIBBLE_MAX) {
+            do {
+                if(pIn >= pInEnd)
+                    return 0;
+                extra = *pIn++;
+                len += extra;
+            } while(extra == 255);
+        }
+        if((len > (uint32_t)(pInEnd - pIn)) || (len > (uint32_t)(pOutEnd - pOut)))
+            return 0;
+        memcpy(pOut, pIn, len);
+        pOut += len;
+        pIn += len;
+
+        /* last sequence has no match */
+        if(pIn == pInEnd)
+            break;
+
+        if((pInEnd - pIn) < 2)
+            return 0;
+        offset = log_get_le16(pIn);
+        pIn += 2;
+        if((offset == 0) || (offset > (uint32_t)(pOut - pDst)))
+            return 0;
+
+        len = token & LZ_NIBBLE_MAX;
+        if(len == LZ_NIBBLE_MAX) {
+            do {
+                if(pIn >= pInEnd)
+                    return 0;
+                extra = *pIn++;
+                len += extra;
+            } while(extra == 255);
+        }
+        len += LOG_LZ_MIN_MATCH;
+        if(len > (uint32_t)(pOutEnd - pOut))
+            return 0;
+
+        /* a match closer than its length repeats bytes it is producing */
+        pRef = pOut - offset;
+        if(offset >= len) {
+            memcpy(pOut, pRef, len);
+            pOut += len;
+        }
+        else {
+            while(len--)
+                *pOut++ = *pRef++;
+        }
+    }
+    return (uint32_t)(pOut - pDst);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief extra length bytes for a nibble that overflowed; len is the
+ * amount beyond LZ_NIBBLE_MAX
+ */
+static uint8_t *lz_put_length(uint8_t *pOut, uint8_t *pOutEnd, uint32_t len)
+{
+    while(len >= 255) {
+        if(pOut >= pOutEnd)
+            return NULL;
+        *pOut++ = 255;
+        len -= 255;
+    }
+    if(pOut >= pOutEnd)
+        return NULL;
+    *pOut++ = (uint8_t)len;
+    return pOut;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief token, literals and (if matchLen != 0) offset and match length
+ */
+static uint8_t *lz_put_sequence(uint8_t *pOut, uint8_t *pOutEnd, const uint8_t *pLiterals,
+                                uint32_t litLen, uint32_t offset, uint32_t matchLen)
+{
+    uint32_t matchCode = (matchLen != 0) ? (matchLen - LOG_LZ_MIN_MATCH) : 0;
+    uint8_t *pToken = pOut;
+
+    if(pOut >= pOutEnd)
+        return NULL;
+    *pToken = (uint8_t)((((litLen < LZ_NIBBLE_MAX) ? litLen : LZ_NIBBLE_MAX) << 4) |
+                        ((matchCode < LZ_NIBBLE_MAX) ? matchCode : LZ_NIBBLE_MAX));
+    ++pOut;
+
+    if((litLen >= LZ_NIBBLE_MAX) && ((pOut = lz_put_length(pOut, pOutEnd, litLen - LZ_NIBBLE_MAX)) == NULL))
+        return NULL;
+    if(litLen > (uint32_t)(pOutEnd - pOut))
+        return NULL;
+    memcpy(pOut, pLiterals, litLen);
+    pOut += litLen;
+
+    if(matchLen == 0)
+        return pOut;
+
+    if((pOutEnd - pOut) < 2)
+        return NULL;
+    log_put_le16(pOut, (uint16_t)offset);
+    pOut += 2;
+    if((matchCode >= LZ_NIBBLE_MAX) && ((pOut = lz_put_length(pOut, pOutEnd, matchCode - LZ_NIBBLE_MAX)) == NULL))
+        return NULL;
+    return pOut;
+}
+
+/*---------------------------------------------------------------------------------*/
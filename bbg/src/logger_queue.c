@@ -32,6 +32,7 @@
 #include "my_debug.h"
 #include "logger_types.h"
 #include "logger_queue.h"
+#include "logger_helper.h"
 #include "packet.h"
 #include "conversion.h"
 #include "healthMonitor.h"
@@ -79,6 +80,7 @@ uint8_t log_queue_item(logItem_t *pLogItem)
 
 	LogMsgPacket newItem;
 	#ifdef __linux__
+	    log_note_item(pLogItem);
 	    if(logQueue < 0)
 	#else
 	    if(logFd <= 0)
@@ -87,34 +89,8 @@ uint8_t log_queue_item(logItem_t *pLogItem)
         ERROR_PRINT("log msg queue not initialized\n");
         return LOG_STATUS_NOTOK;
     }
-	newItem.logMsgId = pLogItem->logMsgId;
-	newItem.lineNum = pLogItem->lineNum;
-	newItem.timestamp = pLogItem->time;
-	newItem.payloadLength = pLogItem->payloadLength;
-	newItem.sourceId = pLogItem->sourceId;
-	newItem.checksum = pLogItem->checksum;
-	
-	/* copy filename string */
-    if(pLogItem->pFilename == NULL) {
-            ERROR_PRINT("Null ptr in log_queue_item, pFilename from %s\n", getPidString(pLogItem->sourceId));
-            return LOG_STATUS_NOTOK;
-    }
-    else {
-        if(strcpy((char *)newItem.filename, (char *)pLogItem->pFilename) == NULL)
-            return LOG_STATUS_NOTOK;
-    }
-
-
-	/* copy payload */
-    if(pLogItem->payloadLength > 0) {
-        if(pLogItem->pPayload == NULL) {
-                ERROR_PRINT("Null ptr in log_queue_item, pPayload from %s\n", getPidString(pLogItem->sourceId));
-                return LOG_STATUS_NOTOK;
-        }
-        else {
-            if(memcpy(newItem.payload, pLogItem->pPayload, pLogItem->payloadLength) == NULL)
-                return LOG_STATUS_NOTOK;
-        }
+    if(log_pack_item(pLogItem, &newItem) != LOG_STATUS_OK) {
+        return LOG_STATUS_NOTOK;
     }
 
 	/* send, use 7 as priority */
@@ -205,40 +181,102 @@ uint8_t log_dequeue_item(logItem_t *pLogItem)
 #endif
 	if(bytesRead == sizeof(LogMsgPacket))
 	{
-		pLogItem->logMsgId = newItem.logMsgId;
-		pLogItem->lineNum = newItem.lineNum;
-		pLogItem->time = newItem.timestamp;
-		pLogItem->payloadLength = newItem.payloadLength;
-		pLogItem->sourceId = newItem.sourceId;
-		pLogItem->checksum = newItem.checksum;
-		
-		/* copy filename string */
-        if(pLogItem->pFilename == NULL) {
-		    ERROR_PRINT("Null ptr in log_dequeue_item, pFilename from %s\n", getPidString(pLogItem->sourceId));
-            return LOG_STATUS_NOTOK;
+		return log_unpack_item(&newItem, pLogItem);
+	}
+	return LOG_STATUS_NOTOK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_pack_item(logItem_t *pLogItem, LogMsgPacket *pPacket)
+{
+	uint32_t len;
+
+	pPacket->logMsgId = pLogItem->logMsgId;
+	pPacket->payloadFormat = pLogItem->payloadFormat;
+	pPacket->fileId = pLogItem->fileId;
+	pPacket->lineNum = pLogItem->lineNum;
+	pPacket->timestamp = pLogItem->time;
+	pPacket->payloadLength = pLogItem->payloadLength;
+	pPacket->sourceId = pLogItem->sourceId;
+	pPacket->checksum = 0;		/* computed by log_render_item */
+
+	/* copy string while measuring it, once, bounded by the packet;
+	 * length includes the null like log_strlen */
+	if(pLogItem->payloadFormat == LOG_PAYLOAD_STRING) {
+		len = 0;
+		if(pLogItem->pPayload != NULL) {
+			while((len < (LOG_MSG_PAYLOAD_SIZE - 1)) && (pLogItem->pPayload[len] != '\0')) {
+				pPacket->payload[len] = pLogItem->pPayload[len];
+				++len;
+			}
+			pPacket->payload[len++] = '\0';
+		}
+		pPacket->payloadFormat = LOG_PAYLOAD_TEXT;
+		pPacket->payloadLength = len;
+		return LOG_STATUS_OK;
+	}
+
+	/* copy payload */
+    if(pLogItem->payloadLength > 0) {
+        if(pLogItem->pPayload == NULL) {
+                ERROR_PRINT("Null ptr in log_pack_item, pPayload from %s\n", getPidString(pLogItem->sourceId));
+                return LOG_STATUS_NOTOK;
+        }
+        else if(pLogItem->payloadLength > LOG_MSG_PAYLOAD_SIZE) {
+                ERROR_PRINT("log_pack_item payload too long (%u) from %s\n", pLogItem->payloadLength,
+                            getPidString(pLogItem->sourceId));
+                return LOG_STATUS_NOTOK;
         }
         else {
-            if(strcpy((char *)pLogItem->pFilename, (char *)newItem.filename) == NULL) {
+            if(memcpy(pPacket->payload, pLogItem->pPayload, pLogItem->payloadLength) == NULL)
                 return LOG_STATUS_NOTOK;
-            }	    
         }
+    }
+	return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_unpack_item(LogMsgPacket *pPacket, logItem_t *pLogItem)
+{
+	pLogItem->logMsgId = pPacket->logMsgId;
+	pLogItem->payloadFormat = pPacket->payloadFormat;
+	pLogItem->fileId = pPacket->fileId;
+	pLogItem->pFilename = NULL;		/* name resolved from fileId when written */
+	pLogItem->lineNum = pPacket->lineNum;
+	pLogItem->time = pPacket->timestamp;
+	pLogItem->payloadLength = pPacket->payloadLength;
+	pLogItem->sourceId = pPacket->sourceId;
+	pLogItem->checksum = pPacket->checksum;
 
-		/* copy payload */
-        if(pLogItem->payloadLength > 0) {
-            if(pLogItem->pPayload == NULL) {
-                ERROR_PRINT("Null ptr in log_dequeue_item, pPayload from %s\n", getPidString(pLogItem->sourceId));
+	/* copy payload */
+    if(pLogItem->payloadLength > 0) {
+        if(pLogItem->pPayload == NULL) {
+            ERROR_PRINT("Null ptr in log_unpack_item, pPayload from %s\n", getPidString(pLogItem->sourceId));
+            return LOG_STATUS_NOTOK;
+        }
+        else {
+            if(memcpy(pLogItem->pPayload, pPacket->payload, pLogItem->payloadLength) == NULL) {
                 return LOG_STATUS_NOTOK;
             }
-            else {
-                if(memcpy(pLogItem->pPayload, newItem.payload, pLogItem->payloadLength) == NULL) {
-                    return LOG_STATUS_NOTOK;
-                }
-            }	
         }
-    
-		return LOG_STATUS_OK;
-	}
-	return LOG_STATUS_NOTOK;
+    }
+	return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_packet_checksum(LogMsgPacket *pPacket)
+{
+	logItem_t item;
+
+	item.logMsgId = pPacket->logMsgId;
+	item.fileId = pPacket->fileId;
+	item.pFilename = NULL;
+	item.lineNum = pPacket->lineNum;
+	item.time = pPacket->timestamp;
+	item.sourceId = pPacket->sourceId;
+	item.payloadLength = (pPacket->payloadLength <= LOG_MSG_PAYLOAD_SIZE) ? pPacket->payloadLength : LOG_MSG_PAYLOAD_SIZE;
+	item.pPayload = pPacket->payload;
+	return log_calc_checksum(&item);
 }
 
 /*---------------------------------------------------------------------------------*/
@@ -247,7 +285,7 @@ uint8_t log_write_item(logItem_t *pLogItem, int fileFd)
     #ifdef __linux__
         if(log_byte(FRAME_START_BYTE, fileFd) == LOG_STATUS_OK){
             if(log_integer(pLogItem->logMsgId, fileFd) == LOG_STATUS_OK){
-                if(log_string(pLogItem->pFilename, fileFd) == LOG_STATUS_OK){
+                if(log_string(log_item_filename(pLogItem), fileFd) == LOG_STATUS_OK){
                     if(log_integer(pLogItem->lineNum, fileFd) == LOG_STATUS_OK){
                         if(log_integer(pLogItem->time, fileFd) == LOG_STATUS_OK){
                             if(log_integer(pLogItem->payloadLength, fileFd) == LOG_STATUS_OK){
@@ -0,0 +1,622 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 30, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_reader.c
+ * @brief log file reader library
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_format.h"
+#include "logger_files.h"
+#include "logger_segment.h"
+#include "logger_reader.h"
+#include "logger_lz.h"
+#include "logger_helper.h"
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static uint8_t reader_fill(LogReader_t *pReader, uint32_t needed);
+static uint8_t reader_next_legacy(LogReader_t *pReader, logItem_t *pLogItem);
+static uint8_t reader_next_compact(LogReader_t *pReader, logItem_t *pLogItem);
+static uint8_t reader_skip_entry(LogReader_t *pReader, uint8_t ret);
+static uint8_t reader_get_hex(LogReader_t *pReader, uint32_t *pValue);
+static uint8_t reader_segment_hdr(LogReader_t *pReader);
+static ssize_t reader_read(LogReader_t *pReader, uint8_t *pDst, uint32_t maxLen);
+static ssize_t reader_pread(LogReader_t *pReader, uint8_t *pDst, uint32_t len, uint64_t offset);
+static int reader_load_block(LogReader_t *pReader);
+static int reader_resync_block(LogReader_t *pReader);
+static uint8_t reader_seek_blocks(LogReader_t *pReader, uint64_t offset);
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_reader_open(LogReader_t *pReader, const char *pPath)
+{
+    if((pReader == NULL) || (pPath == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    memset(pReader, 0, offsetof(LogReader_t, buf));
+    pReader->fd = open(pPath, O_RDONLY);
+    if(pReader->fd < 0) {
+        ERRNO_PRINT("log_reader_open failed");
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* segment file, records follow its header; drop what was buffered,
+     * it runs past the commit point */
+    if((reader_fill(pReader, LOG_SEGMENT_MAGIC_SIZE) == LOG_STATUS_OK) &&
+       (memcmp(pReader->buf, LOG_SEGMENT_MAGIC, LOG_SEGMENT_MAGIC_SIZE) == 0)) {
+        pReader->len = 0;
+        pReader->pos = 0;
+        if((reader_segment_hdr(pReader) != LOG_STATUS_OK) ||
+           (log_reader_seek(pReader, LOG_SEGMENT_HDR_SIZE) != LOG_STATUS_OK)) {
+            close(pReader->fd);
+            pReader->fd = -1;
+            return LOG_STATUS_NOTOK;
+        }
+    }
+
+    /* compressed file; from here on buf is filled with decompressed data */
+    if((reader_fill(pReader, LOG_BLOCK_MAGIC_SIZE) == LOG_STATUS_OK) &&
+       (memcmp(pReader->buf, LOG_BLOCK_MAGIC, LOG_BLOCK_MAGIC_SIZE) == 0)) {
+        pReader->blocks = 1;
+        pReader->blockFileOffset = 0;
+        pReader->bufOffset = 0;
+        pReader->len = 0;
+        pReader->pos = 0;
+    }
+
+    pReader->format = LOG_FORMAT_LEGACY;
+    pReader->verify = 1;
+    if((reader_fill(pReader, LOG_COMPACT_MAGIC_SIZE) == LOG_STATUS_OK) &&
+       (memcmp(pReader->buf, LOG_COMPACT_MAGIC, LOG_COMPACT_MAGIC_SIZE) == 0)) {
+        pReader->format = LOG_FORMAT_COMPACT;
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_reader_next(LogReader_t *pReader, logItem_t *pLogItem)
+{
+    uint8_t ret;
+
+    if((pReader == NULL) || (pLogItem == NULL) || (pReader->fd < 0)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    if(pReader->format == LOG_FORMAT_COMPACT)
+        ret = reader_next_compact(pReader, pLogItem);
+    else
+        ret = reader_next_legacy(pReader, pLogItem);
+
+    /* compact sessions say whether they're checksummed, legacy files can't;
+     * those written before CRC-32C carry the byte sum, so either is taken */
+    if((ret == LOG_STATUS_OK) && pReader->verify &&
+       ((pReader->format == LOG_FORMAT_LEGACY) || pReader->sessionCrc) &&
+       (log_calc_checksum(pLogItem) != pLogItem->checksum) &&
+       ((pReader->format != LOG_FORMAT_LEGACY) || (log_calc_byte_sum(pLogItem) != pLogItem->checksum))) {
+        ++pReader->badChecksums;
+        ret = LOG_STATUS_NOTOK;
+    }
+
+    if(ret == LOG_STATUS_OK)
+        ++pReader->records;
+    else if(ret == LOG_STATUS_NOTOK)
+        ++pReader->badRecords;
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint64_t log_reader_tell(LogReader_t *pReader)
+{
+    return pReader->bufOffset + pReader->pos;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_reader_seek(LogReader_t *pReader, uint64_t offset)
+{
+    if(pReader == NULL) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* keep buffered data if target is inside it */
+    if((offset >= pReader->bufOffset) && (offset <= (pReader->bufOffset + pReader->len))) {
+        pReader->pos = (uint32_t)(offset - pReader->bufOffset);
+        return LOG_STATUS_OK;
+    }
+    if(pReader->blocks) {
+        return reader_seek_blocks(pReader, offset);
+    }
+
+    if(lseek(pReader->fd, (off_t)offset, SEEK_SET) < 0) {
+        ERRNO_PRINT("log_reader_seek failed");
+        return LOG_STATUS_NOTOK;
+    }
+    pReader->bufOffset = offset;
+    pReader->pos = 0;
+    pReader->len = 0;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_reader_refresh(LogReader_t *pReader)
+{
+    if((pReader == NULL) || (pReader->fd < 0)) {
+        return LOG_STATUS_NOTOK;
+    }
+    if(pReader->dataEnd == 0) {
+        return LOG_STATUS_OK;
+    }
+    return reader_segment_hdr(pReader);
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_reader_print_item(logItem_t *pLogItem)
+{
+    const char *pName = strrchr((char *)pLogItem->pFilename, '/');
+
+    pName = (pName != NULL) ? (pName + 1) : (char *)pLogItem->pFilename;
+    printf("[ %s : %u, tid: %u ][ %u us][ %u ]", pName, pLogItem->lineNum, pLogItem->sourceId,
+           pLogItem->time, pLogItem->logMsgId);
+    if(pLogItem->payloadLength > 0)
+        printf(": %.*s", (int)pLogItem->payloadLength, (char *)pLogItem->pPayload);
+    printf("\n");
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_reader_close(LogReader_t *pReader)
+{
+    if((pReader != NULL) && (pReader->fd >= 0)) {
+        close(pReader->fd);
+        pReader->fd = -1;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief make sure at least needed bytes are buffered after pos
+ */
+static uint8_t reader_fill(LogReader_t *pReader, uint32_t needed)
+{
+    uint32_t remaining = pReader->len - pReader->pos;
+    uint64_t readEnd;
+    uint32_t maxRead;
+    ssize_t ret;
+
+    if(remaining >= needed)
+        return LOG_STATUS_OK;
+    if(needed > LOG_READER_BUF_SIZE)
+        return LOG_STATUS_NOTOK;
+
+    /* slide unread bytes to front then top up */
+    memmove(pReader->buf, &pReader->buf[pReader->pos], remaining);
+    pReader->bufOffset += pReader->pos;
+    pReader->pos = 0;
+    pReader->len = remaining;
+
+    while(pReader->len < needed)
+    {
+        /* a segment's bytes past the commit point aren't records yet */
+        maxRead = LOG_READER_BUF_SIZE - pReader->len;
+        if(pReader->dataEnd != 0) {
+            readEnd = pReader->bufOffset + pReader->len;
+            if(readEnd >= pReader->dataEnd)
+                return LOG_STATUS_EOF;
+            if((pReader->dataEnd - readEnd) < maxRead)
+                maxRead = (uint32_t)(pReader->dataEnd - readEnd);
+        }
+
+        ret = reader_read(pReader, &pReader->buf[pReader->len], maxRead);
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            ERRNO_PRINT("log reader read failed");
+            return LOG_STATUS_NOTOK;
+        }
+        if(ret == 0)
+            return LOG_STATUS_EOF;
+        pReader->len += ret;
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief NUL terminated hex ascii integer (my_itoa output)
+ */
+static uint8_t reader_get_hex(LogReader_t *pReader, uint32_t *pValue)
+{
+    uint32_t value = 0;
+    uint8_t digits = 0;
+    uint8_t ch, ret;
+
+    while(1)
+    {
+        if((ret = reader_fill(pReader, 1)) != LOG_STATUS_OK)
+            return ret;
+        ch = pReader->buf[pReader->pos++];
+
+        if(ch == '\0')
+            break;
+        if(++digits > MAX_INT_STRING_SIZE)
+            return LOG_STATUS_NOTOK;
+
+        if((ch >= '0') && (ch <= '9'))
+            value = (value << 4) | (ch - '0');
+        else if((ch >= 'A') && (ch <= 'F'))
+            value = (value << 4) | (ch - 'A' + 10);
+        else if((ch >= 'a') && (ch <= 'f'))
+            value = (value << 4) | (ch - 'a' + 10);
+        else
+            return LOG_STATUS_NOTOK;
+    }
+    *pValue = value;
+    return (digits > 0) ? LOG_STATUS_OK : LOG_STATUS_NOTOK;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t reader_next_legacy(LogReader_t *pReader, logItem_t *pLogItem)
+{
+    uint32_t value, nameLen = 0;
+    uint8_t ch, ret;
+
+    /* find start of frame */
+    do {
+        if((ret = reader_fill(pReader, 1)) != LOG_STATUS_OK)
+            return ret;
+        ch = pReader->buf[pReader->pos++];
+    } while(ch != FRAME_START_BYTE);
+
+    if((ret = reader_get_hex(pReader, &value)) != LOG_STATUS_OK)
+        return (ret == LOG_STATUS_EOF) ? ret : LOG_STATUS_NOTOK;
+    pLogItem->logMsgId = (logMsg_e)value;
+
+    do {
+        if((ret = reader_fill(pReader, 1)) != LOG_STATUS_OK)
+            return ret;
+        ch = pReader->buf[pReader->pos++];
+        if(nameLen >= LOG_READER_MAX_NAME)
+            return LOG_STATUS_NOTOK;
+        pReader->filename[nameLen++] = ch;
+    } while(ch != '\0');
+    pLogItem->fileId = LOG_FILE_UNKNOWN;
+    pLogItem->pFilename = pReader->filename;
+    pLogItem->payloadFormat = LOG_PAYLOAD_TEXT;
+
+    if((ret = reader_get_hex(pReader, &value)) != LOG_STATUS_OK)
+        return ret;
+    pLogItem->lineNum = (uint16_t)value;
+    if((ret = reader_get_hex(pReader, &value)) != LOG_STATUS_OK)
+        return ret;
+    pLogItem->time = value;
+    if((ret = reader_get_hex(pReader, &value)) != LOG_STATUS_OK)
+        return ret;
+    if(value > LOG_READER_MAX_PAYLOAD)
+        return LOG_STATUS_NOTOK;
+    pLogItem->payloadLength = value;
+
+    if((ret = reader_fill(pReader, pLogItem->payloadLength)) != LOG_STATUS_OK)
+        return ret;
+    memcpy(pReader->payload, &pReader->buf[pReader->pos], pLogItem->payloadLength);
+    pReader->pos += pLogItem->payloadLength;
+    pLogItem->pPayload = pReader->payload;
+
+    if((ret = reader_get_hex(pReader, &value)) != LOG_STATUS_OK)
+        return ret;
+    pLogItem->sourceId = (uint16_t)value;
+    if((ret = reader_get_hex(pReader, &value)) != LOG_STATUS_OK)
+        return ret;
+    pLogItem->checksum = value;
+
+    if((ret = reader_fill(pReader, 1)) != LOG_STATUS_OK)
+        return ret;
+    if(pReader->buf[pReader->pos] != FRAME_STOP_BYTE)
+        return LOG_STATUS_NOTOK;
+    ++pReader->pos;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t reader_next_compact(LogReader_t *pReader, logItem_t *pLogItem)
+{
+    uint8_t *pEntry;
+    uint16_t id, len;
+    uint8_t ret;
+
+    while(1)
+    {
+        if((ret = reader_fill(pReader, 1)) != LOG_STATUS_OK)
+            return ret;
+        pEntry = &pReader->buf[pReader->pos];
+
+        switch(pEntry[0])
+        {
+            case LOG_COMPACT_TAG_HEADER:
+                /* start of a new session, string IDs start over */
+                if((ret = reader_fill(pReader, LOG_COMPACT_FILE_HDR_SIZE)) != LOG_STATUS_OK)
+                    return reader_skip_entry(pReader, ret);
+                pEntry = &pReader->buf[pReader->pos];
+                len = log_get_le16(&pEntry[6]);
+                if((memcmp(pEntry, LOG_COMPACT_MAGIC, LOG_COMPACT_MAGIC_SIZE) != 0) ||
+                   (log_get_le16(&pEntry[4]) > LOG_COMPACT_VERSION) || (len < LOG_COMPACT_FILE_HDR_SIZE)) {
+                    return reader_skip_entry(pReader, LOG_STATUS_NOTOK);
+                }
+                pReader->sessionCrc = (log_get_le16(&pEntry[4]) >= LOG_COMPACT_VERSION_CRC);
+                if((ret = reader_fill(pReader, len)) != LOG_STATUS_OK)
+                    return reader_skip_entry(pReader, ret);
+                pReader->pos += len;
+                memset(pReader->strings, 0, sizeof(pReader->strings));
+                break;
+
+            case LOG_COMPACT_TAG_STRING:
+                if((ret = reader_fill(pReader, LOG_COMPACT_STR_HDR_SIZE)) != LOG_STATUS_OK)
+                    return reader_skip_entry(pReader, ret);
+                pEntry = &pReader->buf[pReader->pos];
+                id = log_get_le16(&pEntry[2]);
+                len = log_get_le16(&pEntry[4]);
+                if(len >= LOG_READER_MAX_NAME)
+                    return reader_skip_entry(pReader, LOG_STATUS_NOTOK);
+                if((ret = reader_fill(pReader, LOG_COMPACT_STR_HDR_SIZE + len)) != LOG_STATUS_OK)
+                    return reader_skip_entry(pReader, ret);
+                pEntry = &pReader->buf[pReader->pos];
+                if(id < LOG_READER_MAX_STRINGS) {
+                    memcpy(pReader->strings[id], &pEntry[LOG_COMPACT_STR_HDR_SIZE], len);
+                    pReader->strings[id][len] = '\0';
+                }
+                pReader->pos += LOG_COMPACT_STR_HDR_SIZE + len;
+                break;
+
+            case LOG_COMPACT_TAG_RECORD:
+                if((ret = reader_fill(pReader, LOG_COMPACT_REC_HDR_SIZE)) != LOG_STATUS_OK)
+                    return reader_skip_entry(pReader, ret);
+                pEntry = &pReader->buf[pReader->pos];
+                len = log_get_le16(&pEntry[16]);
+                if(len > LOG_MSG_PAYLOAD_SIZE)
+                    return reader_skip_entry(pReader, LOG_STATUS_NOTOK);
+                if((ret = reader_fill(pReader, LOG_COMPACT_REC_HDR_SIZE + len)) != LOG_STATUS_OK)
+                    return reader_skip_entry(pReader, ret);
+                pEntry = &pReader->buf[pReader->pos];
+
+                pLogItem->logMsgId = (logMsg_e)pEntry[1];
+                id = log_get_le16(&pEntry[2]);
+                pLogItem->lineNum = log_get_le16(&pEntry[4]);
+                pLogItem->sourceId = log_get_le16(&pEntry[6]);
+                pLogItem->time = log_get_le32(&pEntry[8]);
+                pLogItem->checksum = log_get_le32(&pEntry[12]);
+                pLogItem->payloadLength = len;
+                memcpy(pReader->payload, &pEntry[LOG_COMPACT_REC_HDR_SIZE], len);
+                pLogItem->pPayload = pReader->payload;
+                pLogItem->payloadFormat = LOG_PAYLOAD_TEXT;
+                pLogItem->fileId = LOG_FILE_UNKNOWN;
+                pLogItem->pFilename = (id < LOG_READER_MAX_STRINGS) ? pReader->strings[id] : pReader->filename;
+                pReader->filename[0] = '\0';
+
+                pReader->pos += LOG_COMPACT_REC_HDR_SIZE + len;
+                return LOG_STATUS_OK;
+
+            default:
+                /* not at an entry boundary, skip byte and resync */
+                return reader_skip_entry(pReader, LOG_STATUS_NOTOK);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief on a framing error skip the entry's tag byte, so the next call
+ * resyncs on whatever follows it; at end of file the rest of the entry may
+ * not be written yet, so it's left to be read again
+ */
+static uint8_t reader_skip_entry(LogReader_t *pReader, uint8_t ret)
+{
+    if(ret == LOG_STATUS_NOTOK)
+        ++pReader->pos;
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief (re)load commit point and state from a segment file's header
+ */
+static uint8_t reader_segment_hdr(LogReader_t *pReader)
+{
+    LogSegmentHdr_t hdr;
+
+    if(pread(pReader->fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+        ERRNO_PRINT("log reader segment header read failed");
+        return LOG_STATUS_NOTOK;
+    }
+    if((memcmp(hdr.magic, LOG_SEGMENT_MAGIC, LOG_SEGMENT_MAGIC_SIZE) != 0) ||
+       (hdr.version > LOG_SEGMENT_VERSION) || (hdr.hdrSize != LOG_SEGMENT_HDR_SIZE) ||
+       (hdr.used < LOG_SEGMENT_HDR_SIZE) || (hdr.used > hdr.size) || (hdr.used < pReader->dataEnd)) {
+        ERROR_PRINT("bad log segment header\n");
+        return LOG_STATUS_NOTOK;
+    }
+    pReader->dataEnd = hdr.used;
+    pReader->segmentSeq = hdr.seq;
+    pReader->segmentClosed = hdr.closed;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief next bytes of the file, or of its decompressed contents
+ */
+static ssize_t reader_read(LogReader_t *pReader, uint8_t *pDst, uint32_t maxLen)
+{
+    uint32_t len;
+    int ret;
+
+    if(pReader->blocks == 0)
+        return read(pReader->fd, pDst, maxLen);
+
+    while(pReader->blockPos >= pReader->blockLen)
+    {
+        if((ret = reader_load_block(pReader)) <= 0)
+            return ret;
+    }
+    len = pReader->blockLen - pReader->blockPos;
+    if(len > maxLen)
+        len = maxLen;
+    memcpy(pDst, &pReader->block[pReader->blockPos], len);
+    pReader->blockPos += len;
+    return len;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief pread() until len bytes or end of file
+ *
+ * @return ssize_t bytes read, -1 on error
+ */
+static ssize_t reader_pread(LogReader_t *pReader, uint8_t *pDst, uint32_t len, uint64_t offset)
+{
+    uint32_t got = 0;
+    ssize_t ret;
+
+    while(got < len)
+    {
+        ret = pread(pReader->fd, &pDst[got], len - got, (off_t)(offset + got));
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            ERRNO_PRINT("log reader read failed");
+            return -1;
+        }
+        if(ret == 0)
+            break;
+        got += ret;
+    }
+    return got;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief decompress the block at blockFileOffset; a block cut short by
+ * the end of the file is left to be read once the writer finishes it
+ *
+ * @return int 1 if a block (possibly empty, after a corrupt one) was
+ *  loaded, 0 at end of file, -1 on error
+ */
+static int reader_load_block(LogReader_t *pReader)
+{
+    uint8_t hdr[LOG_BLOCK_HDR_SIZE];
+    uint32_t rawLen, compLen, storedLen;
+    ssize_t ret;
+
+    ret = reader_pread(pReader, hdr, sizeof(hdr), pReader->blockFileOffset);
+    if(ret < (ssize_t)sizeof(hdr))
+        return (ret < 0) ? -1 : 0;
+
+    rawLen = log_get_le32(&hdr[4]);
+    compLen = log_get_le32(&hdr[8]);
+    storedLen = (compLen != 0) ? compLen : rawLen;
+    if((memcmp(hdr, LOG_BLOCK_MAGIC, LOG_BLOCK_MAGIC_SIZE) != 0) || (rawLen == 0) ||
+       (rawLen > LOG_BLOCK_MAX_RAW) || (storedLen > sizeof(pReader->zblock))) {
+        return reader_resync_block(pReader);
+    }
+
+    /* stored blocks go straight to the block buffer */
+    ret = reader_pread(pReader, (compLen != 0) ? pReader->zblock : pReader->block,
+                       storedLen, pReader->blockFileOffset + LOG_BLOCK_HDR_SIZE);
+    if(ret < (ssize_t)storedLen)
+        return (ret < 0) ? -1 : 0;
+    if((compLen != 0) &&
+       (log_lz_decompress(pReader->zblock, compLen, pReader->block, rawLen) != rawLen)) {
+        return reader_resync_block(pReader);
+    }
+
+    pReader->blockFileOffset += LOG_BLOCK_HDR_SIZE + storedLen;
+    pReader->blockPos = 0;
+    pReader->blockLen = rawLen;
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief skip a corrupt block, scanning forward for the next block magic
+ *
+ * @return int 1 if one was found, 0 at end of file, -1 on error
+ */
+static int reader_resync_block(LogReader_t *pReader)
+{
+    uint64_t offset = pReader->blockFileOffset + 1;
+    ssize_t ret, ind;
+
+    ++pReader->badBlocks;
+    pReader->blockPos = 0;
+    pReader->blockLen = 0;
+
+    while(1)
+    {
+        ret = reader_pread(pReader, pReader->zblock, sizeof(pReader->zblock), offset);
+        if(ret < 0)
+            return -1;
+        for(ind = 0; (ind + LOG_BLOCK_MAGIC_SIZE) <= ret; ++ind)
+        {
+            if(memcmp(&pReader->zblock[ind], LOG_BLOCK_MAGIC, LOG_BLOCK_MAGIC_SIZE) == 0) {
+                pReader->blockFileOffset = offset + ind;
+                return 1;
+            }
+        }
+
+        /* a magic may straddle the end of what was read */
+        pReader->blockFileOffset = offset + ind;
+        if(ret < (ssize_t)sizeof(pReader->zblock))
+            return 0;
+        offset += ind;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief decompress forward to a decompressed stream offset, from the
+ * first block if it is behind what has been read
+ */
+static uint8_t reader_seek_blocks(LogReader_t *pReader, uint64_t offset)
+{
+    uint64_t streamPos = pReader->bufOffset + pReader->len;
+    uint32_t maxRead;
+    ssize_t ret;
+
+    if(offset < streamPos) {
+        pReader->blockFileOffset = 0;
+        pReader->blockPos = 0;
+        pReader->blockLen = 0;
+        streamPos = 0;
+    }
+
+    while(streamPos < offset)
+    {
+        maxRead = ((offset - streamPos) < LOG_READER_BUF_SIZE) ? (uint32_t)(offset - streamPos) : LOG_READER_BUF_SIZE;
+        ret = reader_read(pReader, pReader->buf, maxRead);
+        if(ret <= 0) {
+            ERROR_PRINT("log_reader_seek past end of compressed data\n");
+            return LOG_STATUS_NOTOK;
+        }
+        streamPos += ret;
+    }
+
+    pReader->bufOffset = offset;
+    pReader->pos = 0;
+    pReader->len = 0;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,124 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 17, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_ref.c
+ * @brief remote nodes' log packets to the logging thread by reference
+ *
+ ************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "logger_types.h"
+#include "logger_ring.h"
+#include "logger_ref.h"
+#include "packet.h"
+#include "bufPool.h"
+
+/*---------------------------------------------------------------------------------*/
+typedef struct {
+    LogMsgPacket *pPacket;
+    PoolBuf_t *pBuf;
+} LogRef_t;
+
+/* head only written by producer, tail only written by consumer */
+typedef struct {
+    uint32_t head __attribute__((aligned(LOG_RING_CACHE_LINE)));
+    uint32_t tail __attribute__((aligned(LOG_RING_CACHE_LINE)));
+    LogRef_t slots[LOG_REF_DEPTH] __attribute__((aligned(LOG_RING_CACHE_LINE)));
+} LogRefRing_t;
+
+#define REF_MASK        (LOG_REF_DEPTH - 1)
+#if (LOG_REF_DEPTH & REF_MASK) != 0
+    #error "LOG_REF_DEPTH must be a power of 2"
+#endif
+
+/*---------------------------------------------------------------------------------*/
+/* globals */
+static LogRefRing_t ring;
+static uint8_t ringOpen = 0;
+static PoolBuf_t *pHeld = NULL;     /* buffer of the packet last dequeued */
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_ref_open(void)
+{
+    __atomic_store_n(&ringOpen, 1, __ATOMIC_RELEASE);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_ref_close(void)
+{
+    __atomic_store_n(&ringOpen, 0, __ATOMIC_RELEASE);
+    if(pHeld != NULL) {
+        buf_pool_release(pHeld);
+        pHeld = NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_ref_item(LogMsgPacket *pPacket, PoolBuf_t *pBuf)
+{
+    uint32_t head, tail;
+
+    /* a string isn't known to end inside the packet until log_pack_item() bounds it */
+    if(!__atomic_load_n(&ringOpen, __ATOMIC_ACQUIRE) || (pPacket->payloadFormat == LOG_PAYLOAD_STRING))
+        return LOG_STATUS_NOTOK;
+
+    head = __atomic_load_n(&ring.head, __ATOMIC_RELAXED);
+    tail = __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+    if((head - tail) >= LOG_REF_DEPTH)
+        return LOG_STATUS_BUF_FULL;
+
+    buf_pool_ref(pBuf);
+    ring.slots[head & REF_MASK].pPacket = pPacket;
+    ring.slots[head & REF_MASK].pBuf = pBuf;
+
+    /* publish slot, and the packet it points to, to consumer */
+    __atomic_store_n(&ring.head, head + 1, __ATOMIC_RELEASE);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_ref_dequeue_item(logItem_t *pLogItem)
+{
+    LogMsgPacket *pPacket;
+    uint32_t tail;
+
+    if(pHeld != NULL) {
+        buf_pool_release(pHeld);
+        pHeld = NULL;
+    }
+
+    tail = ring.tail;
+    if(__atomic_load_n(&ring.head, __ATOMIC_ACQUIRE) == tail)
+        return LOG_STATUS_TIMEOUT;
+
+    pPacket = ring.slots[tail & REF_MASK].pPacket;
+    pHeld = ring.slots[tail & REF_MASK].pBuf;
+
+    /* release slot back to producer; the packet stays ours until the next call */
+    __atomic_store_n(&ring.tail, tail + 1, __ATOMIC_RELEASE);
+
+    pLogItem->logMsgId = pPacket->logMsgId;
+    pLogItem->payloadFormat = pPacket->payloadFormat;
+    pLogItem->fileId = pPacket->fileId;
+    pLogItem->pFilename = NULL;     /* name resolved from fileId when written */
+    pLogItem->lineNum = pPacket->lineNum;
+    pLogItem->time = pPacket->timestamp;
+    pLogItem->payloadLength = pPacket->payloadLength;
+    pLogItem->sourceId = pPacket->sourceId;
+    pLogItem->checksum = pPacket->checksum;
+    pLogItem->pPayload = pPacket->payload;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
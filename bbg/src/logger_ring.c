@@ -0,0 +1,231 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 28, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_ring.c
+ * @brief lock-free per-thread SPSC rings for the logger
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_queue.h"
+#include "logger_helper.h"
+#include "logger_ring.h"
+#include "packet.h"
+
+/*---------------------------------------------------------------------------------*/
+/* head only written by producer, tail only written by consumer; kept on
+ * separate cache lines so the two sides don't bounce the same line */
+typedef struct {
+    uint32_t head __attribute__((aligned(LOG_RING_CACHE_LINE)));
+    uint32_t drops;
+    uint8_t owned;                  /* a live thread produces into it */
+    uint32_t tail __attribute__((aligned(LOG_RING_CACHE_LINE)));
+    LogMsgPacket slots[LOG_RING_DEPTH] __attribute__((aligned(LOG_RING_CACHE_LINE)));
+} LogRing_t;
+
+#define RING_MASK       (LOG_RING_DEPTH - 1)
+#if (LOG_RING_DEPTH & RING_MASK) != 0
+    #error "LOG_RING_DEPTH must be a power of 2"
+#endif
+
+/* signed difference handles 32-bit usec timestamp wrap */
+#define TIME_BEFORE(a, b)   ((int32_t)((a) - (b)) < 0)
+
+/*---------------------------------------------------------------------------------*/
+/* globals */
+static LogRing_t rings[LOG_RING_MAX_PRODUCERS];
+static uint32_t ringCount = 0;                  /* rings ever claimed; the consumer scans these */
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t ringKey;                   /* releases a thread's ring as it exits */
+static __thread LogRing_t *pThreadRing = NULL;  /* calling thread's ring */
+static __thread uint8_t ringClaimFailed = 0;    /* no free ring last time; reported once */
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static LogRing_t *log_ring_claim(void);
+static void log_ring_make_key(void);
+static void log_ring_release(void *pArg);
+
+/*---------------------------------------------------------------------------------*/
+uint8_t init_ring_logger(void *pArg)
+{
+    (void)pArg;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_ring_item(logItem_t *pLogItem)
+{
+    uint32_t head, tail;
+    uint8_t retries = 0;
+
+    if(pLogItem == NULL) {
+        return LOG_STATUS_NOTOK;
+    }
+    log_note_item(pLogItem);
+
+    /* a ring may free up as other threads exit, so keep trying */
+    if((pThreadRing == NULL) && ((pThreadRing = log_ring_claim()) == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* only this thread writes head, so relaxed load is fine */
+    head = __atomic_load_n(&pThreadRing->head, __ATOMIC_RELAXED);
+    tail = __atomic_load_n(&pThreadRing->tail, __ATOMIC_ACQUIRE);
+    while(((head - tail) >= LOG_RING_DEPTH) && (retries++ < LOG_RING_FULL_RETRIES)) {
+        /* give logging thread a chance to drain before dropping */
+        sched_yield();
+        tail = __atomic_load_n(&pThreadRing->tail, __ATOMIC_ACQUIRE);
+    }
+    if((head - tail) >= LOG_RING_DEPTH) {
+        __atomic_store_n(&pThreadRing->drops, pThreadRing->drops + 1, __ATOMIC_RELAXED);
+        return LOG_STATUS_BUF_FULL;
+    }
+
+    if(log_pack_item(pLogItem, &pThreadRing->slots[head & RING_MASK]) != LOG_STATUS_OK) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* publish slot to consumer */
+    __atomic_store_n(&pThreadRing->head, head + 1, __ATOMIC_RELEASE);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_ring_dequeue_item(logItem_t *pLogItem)
+{
+    LogRing_t *pOldest = NULL;
+    LogMsgPacket *pPacket;
+    uint32_t oldestTime = 0;
+    uint32_t count, ind, tail;
+    uint8_t ret;
+
+    if(pLogItem == NULL) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    count = __atomic_load_n(&ringCount, __ATOMIC_ACQUIRE);
+    if(count > LOG_RING_MAX_PRODUCERS)
+        count = LOG_RING_MAX_PRODUCERS;
+
+    /* find ring whose next item is oldest; each ring is already in time order */
+    for(ind = 0; ind < count; ++ind)
+    {
+        tail = rings[ind].tail;
+        if(__atomic_load_n(&rings[ind].head, __ATOMIC_ACQUIRE) == tail)
+            continue;
+
+        pPacket = &rings[ind].slots[tail & RING_MASK];
+        if((pOldest == NULL) || TIME_BEFORE(pPacket->timestamp, oldestTime)) {
+            pOldest = &rings[ind];
+            oldestTime = pPacket->timestamp;
+        }
+    }
+
+    if(pOldest == NULL) {
+        return LOG_STATUS_TIMEOUT;
+    }
+
+    tail = pOldest->tail;
+    ret = log_unpack_item(&pOldest->slots[tail & RING_MASK], pLogItem);
+
+    /* release slot back to producer */
+    __atomic_store_n(&pOldest->tail, tail + 1, __ATOMIC_RELEASE);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_ring_flush(void)
+{
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_ring_get_drops(void)
+{
+    uint32_t count, ind, drops = 0;
+
+    count = __atomic_load_n(&ringCount, __ATOMIC_ACQUIRE);
+    if(count > LOG_RING_MAX_PRODUCERS)
+        count = LOG_RING_MAX_PRODUCERS;
+
+    for(ind = 0; ind < count; ++ind)
+        drops += __atomic_load_n(&rings[ind].drops, __ATOMIC_RELAXED);
+
+    return drops;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief first ring not owned and drained; a ring released by an exiting
+ * thread is only reused once the consumer has taken everything in it, so
+ * its items keep their place in the merge
+ */
+static LogRing_t *log_ring_claim(void)
+{
+    uint32_t ind, count;
+    uint8_t owned;
+
+    pthread_once(&ringKeyOnce, log_ring_make_key);
+    for(ind = 0; ind < LOG_RING_MAX_PRODUCERS; ++ind)
+    {
+        owned = 0;
+        if(__atomic_load_n(&rings[ind].owned, __ATOMIC_RELAXED) ||
+           !__atomic_compare_exchange_n(&rings[ind].owned, &owned, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            continue;
+
+        /* head as its last owner left it, now the flag's been taken */
+        if(__atomic_load_n(&rings[ind].tail, __ATOMIC_ACQUIRE) != __atomic_load_n(&rings[ind].head, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&rings[ind].owned, 0, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        /* consumer scans up to the highest ring claimed */
+        count = __atomic_load_n(&ringCount, __ATOMIC_RELAXED);
+        while((count <= ind) &&
+              !__atomic_compare_exchange_n(&ringCount, &count, ind + 1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+        pthread_setspecific(ringKey, &rings[ind]);
+        ringClaimFailed = 0;
+        return &rings[ind];
+    }
+
+    if(!ringClaimFailed) {
+        ERROR_PRINT("log_ring_claim: no free rings (max %d producers)\n", LOG_RING_MAX_PRODUCERS);
+        ringClaimFailed = 1;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void log_ring_make_key(void)
+{
+    pthread_key_create(&ringKey, log_ring_release);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief key destructor, run as the owning thread exits; whatever it
+ * left in the ring is still drained
+ */
+static void log_ring_release(void *pArg)
+{
+    __atomic_store_n(&((LogRing_t *)pArg)->owned, 0, __ATOMIC_RELEASE);
+}
+
+/*---------------------------------------------------------------------------------*/
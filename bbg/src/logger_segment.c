@@ -0,0 +1,320 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 2, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_segment.c
+ * @brief memory mapped, rotating log segment writer
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_helper.h"
+#include "logger_sink.h"
+#include "logger_segment.h"
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static uint8_t segment_create(LogSegment_t *pSegment);
+static void segment_unmap(LogSegment_t *pSegment);
+static void segment_retain(LogSegment_t *pSegment);
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_segment_open(LogSegment_t *pSegment, const char *pBasePath, uint32_t size,
+                         uint8_t segmentsKept, LogFormat_e format)
+{
+    uint32_t oldest, newest;
+
+    if((pSegment == NULL) || (pBasePath == NULL) || (size < LOG_SEGMENT_MIN_SIZE) || (size > LOG_SEGMENT_MAX_SIZE) ||
+       (segmentsKept == 0) || (format >= LOG_FORMAT_END) ||
+       (strlen(pBasePath) >= sizeof(pSegment->basePath))) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    memset(pSegment, 0, sizeof(LogSegment_t));
+    strcpy(pSegment->basePath, pBasePath);
+    pSegment->fd = -1;
+    pSegment->format = format;
+    pSegment->size = size & ~(LOG_SEGMENT_MIN_SIZE - 1);
+    pSegment->segmentsKept = segmentsKept;
+
+    /* never reopen an old segment, its string table and sync state
+     * belong to the run that wrote it */
+    if(log_segment_find(pBasePath, &oldest, &newest) == LOG_STATUS_OK) {
+        pSegment->oldestSeq = oldest;
+        pSegment->seq = newest + 1;
+    }
+    else {
+        pSegment->seq = 1;
+        pSegment->oldestSeq = 1;
+    }
+
+    if(segment_create(pSegment) != LOG_STATUS_OK)
+        return LOG_STATUS_NOTOK;
+    segment_retain(pSegment);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_segment_write_item(LogSegment_t *pSegment, logItem_t *pLogItem)
+{
+    LogSegmentHdr_t *pHdr;
+    uint32_t len;
+
+    if((pSegment == NULL) || (pLogItem == NULL) || (pSegment->pMap == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* rotate when a worst case record won't fit */
+    if((pSegment->size - pSegment->used) < LOG_SINK_MAX_RECORD_SIZE)
+    {
+        segment_unmap(pSegment);
+        ++pSegment->rotations;
+        ++pSegment->seq;
+        if(segment_create(pSegment) != LOG_STATUS_OK)
+            return LOG_STATUS_NOTOK;
+        segment_retain(pSegment);
+    }
+
+    if(pSegment->format == LOG_FORMAT_COMPACT)
+        len = log_serialize_compact(&pSegment->strings, pLogItem, &pSegment->pMap[pSegment->used],
+                                    pSegment->size - pSegment->used);
+    else
+        len = log_serialize_item(pLogItem, &pSegment->pMap[pSegment->used], pSegment->size - pSegment->used);
+    if(len == 0) {
+        ERROR_PRINT("log_segment_write_item failed to serialize msgId %d\n", pLogItem->logMsgId);
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* record bytes land before the commit point moves past them */
+    pSegment->used += len;
+    pHdr = (LogSegmentHdr_t *)pSegment->pMap;
+    __atomic_store_n(&pHdr->used, pSegment->used, __ATOMIC_RELEASE);
+    ++pSegment->records;
+
+    if(pLogItem->logMsgId == LOG_MSG_ERROR)
+        return log_segment_sync(pSegment);
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_segment_poll(LogSegment_t *pSegment)
+{
+    if((pSegment == NULL) || (pSegment->pMap == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    if((pSegment->used != pSegment->syncedLen) &&
+       ((log_get_time() - pSegment->lastSyncTime) >= LOG_SEGMENT_SYNC_USEC)) {
+        return log_segment_sync(pSegment);
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_segment_sync(LogSegment_t *pSegment)
+{
+    if((pSegment == NULL) || (pSegment->pMap == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* only dirty pages are written, so the whole used range is fine */
+    if(msync(pSegment->pMap, pSegment->used, MS_SYNC) != 0) {
+        ERRNO_PRINT("log_segment_sync msync failed");
+        return LOG_STATUS_NOTOK;
+    }
+    ++pSegment->syncs;
+    pSegment->syncedLen = pSegment->used;
+    pSegment->lastSyncTime = log_get_time();
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+void log_segment_close(LogSegment_t *pSegment)
+{
+    if((pSegment != NULL) && (pSegment->pMap != NULL)) {
+        segment_unmap(pSegment);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_segment_path(char *pPath, const char *pBasePath, uint32_t seq)
+{
+    int len = snprintf(pPath, LOG_SEGMENT_PATH_SIZE, "%s.%0*u", pBasePath, LOG_SEGMENT_SEQ_DIGITS, seq);
+
+    if((len < 0) || (len >= LOG_SEGMENT_PATH_SIZE))
+        return LOG_STATUS_NOTOK;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_segment_find(const char *pBasePath, uint32_t *pOldest, uint32_t *pNewest)
+{
+    char dirName[LOG_SEGMENT_PATH_SIZE];
+    const char *pName;
+    struct dirent *pEntry;
+    DIR *pDir;
+    const char *pSeq;
+    size_t nameLen, seqLen;
+    unsigned long seq;
+    uint8_t found = 0;
+
+    if((pBasePath == NULL) || (pOldest == NULL) || (pNewest == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* split into directory and file name */
+    pName = strrchr(pBasePath, '/');
+    if(pName == NULL) {
+        strcpy(dirName, ".");
+        pName = pBasePath;
+    }
+    else {
+        nameLen = (pName == pBasePath) ? 1 : (size_t)(pName - pBasePath);
+        if(nameLen >= sizeof(dirName))
+            return LOG_STATUS_NOTOK;
+        memcpy(dirName, pBasePath, nameLen);
+        dirName[nameLen] = '\0';
+        ++pName;
+    }
+    nameLen = strlen(pName);
+
+    pDir = opendir(dirName);
+    if(pDir == NULL)
+        return LOG_STATUS_NOTOK;
+
+    while((pEntry = readdir(pDir)) != NULL)
+    {
+        if((strncmp(pEntry->d_name, pName, nameLen) != 0) || (pEntry->d_name[nameLen] != '.'))
+            continue;
+
+        /* zero padded to LOG_SEGMENT_SEQ_DIGITS, longer past 999999 */
+        pSeq = &pEntry->d_name[nameLen + 1];
+        seqLen = strlen(pSeq);
+        if((seqLen < LOG_SEGMENT_SEQ_DIGITS) || (strspn(pSeq, "0123456789") != seqLen))
+            continue;
+        errno = 0;
+        seq = strtoul(pSeq, NULL, 10);
+        if((errno != 0) || (seq == 0) || (seq > UINT32_MAX))
+            continue;
+
+        if((found == 0) || (seq < *pOldest))
+            *pOldest = seq;
+        if((found == 0) || (seq > *pNewest))
+            *pNewest = seq;
+        found = 1;
+    }
+    closedir(pDir);
+    return found ? LOG_STATUS_OK : LOG_STATUS_NOTOK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief allocate, map and stamp the header of segment pSegment->seq
+ */
+static uint8_t segment_create(LogSegment_t *pSegment)
+{
+    LogSegmentHdr_t *pHdr;
+    int ret;
+
+    if(log_segment_path(pSegment->path, pSegment->basePath, pSegment->seq) != LOG_STATUS_OK) {
+        ERROR_PRINT("log segment name too long for %s\n", pSegment->basePath);
+        return LOG_STATUS_NOTOK;
+    }
+
+    pSegment->fd = open(pSegment->path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if(pSegment->fd < 0) {
+        ERRNO_PRINT("log segment open failed");
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* reserve blocks now; a store to a hole with the disk full is SIGBUS */
+    ret = posix_fallocate(pSegment->fd, 0, pSegment->size);
+    if(ret != 0) {
+        ERROR_PRINT("log segment fallocate failed, err#%d (%s)\n", ret, strerror(ret));
+        close(pSegment->fd);
+        pSegment->fd = -1;
+        return LOG_STATUS_NOTOK;
+    }
+
+    pSegment->pMap = mmap(NULL, pSegment->size, PROT_READ | PROT_WRITE, MAP_SHARED, pSegment->fd, 0);
+    if(pSegment->pMap == MAP_FAILED) {
+        ERRNO_PRINT("log segment mmap failed");
+        pSegment->pMap = NULL;
+        close(pSegment->fd);
+        pSegment->fd = -1;
+        return LOG_STATUS_NOTOK;
+    }
+
+    pHdr = (LogSegmentHdr_t *)pSegment->pMap;
+    memcpy(pHdr->magic, LOG_SEGMENT_MAGIC, LOG_SEGMENT_MAGIC_SIZE);
+    pHdr->version = LOG_SEGMENT_VERSION;
+    pHdr->hdrSize = LOG_SEGMENT_HDR_SIZE;
+    pHdr->seq = pSegment->seq;
+    pHdr->size = pSegment->size;
+    pHdr->format = (uint8_t)pSegment->format;
+    pHdr->closed = 0;
+    pSegment->used = LOG_SEGMENT_HDR_SIZE;
+
+    /* every compact segment stands alone, retention may delete the one
+     * that defined a string ID */
+    if(pSegment->format == LOG_FORMAT_COMPACT)
+        pSegment->used += log_compact_header(&pSegment->strings, &pSegment->pMap[pSegment->used]);
+    __atomic_store_n(&pHdr->used, pSegment->used, __ATOMIC_RELEASE);
+
+    pSegment->syncedLen = 0;
+    pSegment->lastSyncTime = log_get_time();
+    return log_segment_sync(pSegment);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief mark current segment closed, sync and unmap it
+ */
+static void segment_unmap(LogSegment_t *pSegment)
+{
+    LogSegmentHdr_t *pHdr = (LogSegmentHdr_t *)pSegment->pMap;
+
+    __atomic_store_n(&pHdr->closed, 1, __ATOMIC_RELEASE);
+    log_segment_sync(pSegment);
+    munmap(pSegment->pMap, pSegment->size);
+    close(pSegment->fd);
+    pSegment->pMap = NULL;
+    pSegment->fd = -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief delete segments older than the newest segmentsKept
+ */
+static void segment_retain(LogSegment_t *pSegment)
+{
+    char path[LOG_SEGMENT_PATH_SIZE];
+
+    while((pSegment->seq - pSegment->oldestSeq) >= pSegment->segmentsKept)
+    {
+        if((log_segment_path(path, pSegment->basePath, pSegment->oldestSeq) == LOG_STATUS_OK) &&
+           (unlink(path) != 0) && (errno != ENOENT)) {
+            ERRNO_PRINT("log segment unlink failed");
+        }
+        ++pSegment->oldestSeq;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,435 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 29, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file logger_sink.c
+ * @brief buffered log file writer
+ *
+ ************************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_helper.h"
+#include "logger_sink.h"
+#include "logger_lz.h"
+#include "conversion.h"
+
+_Static_assert(LOG_SINK_BLOCK_SIZE <= LOG_BLOCK_MAX_RAW, "a sink batch must fit one compressed block");
+
+static const char *const sinkFormatNames[LOG_FORMAT_END] = {"legacy", "compact"};
+
+/*---------------------------------------------------------------------------------*/
+/* private functions */
+static uint32_t put_integer(int32_t num, uint8_t *pBuf, uint32_t maxLen);
+static uint8_t log_sink_check_existing(LogSink_t *pSink);
+static uint32_t log_sink_first_block(LogSink_t *pSink, const uint8_t *pHdr);
+static uint8_t log_sink_write_all(LogSink_t *pSink, const uint8_t *pData, uint32_t len);
+static uint32_t log_sink_block(LogSink_t *pSink);
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_sink_init(LogSink_t *pSink, int fd, LogFormat_e format, uint8_t compress)
+{
+    if((pSink == NULL) || (fd < 0) || (format >= LOG_FORMAT_END)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    memset(pSink, 0, offsetof(LogSink_t, buf));
+    pSink->fd = fd;
+    pSink->format = format;
+    pSink->compress = (compress != 0);
+    pSink->bufLimit = (compress) ? LOG_SINK_BLOCK_SIZE : LOG_SINK_BUF_SIZE;
+    pSink->flushUsec = (compress) ? LOG_SINK_BLOCK_FLUSH_USEC : LOG_SINK_FLUSH_USEC;
+    pSink->lastFlushTime = log_get_time();
+
+    if(log_sink_check_existing(pSink) != LOG_STATUS_OK) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    if(format == LOG_FORMAT_COMPACT)
+    {
+        /* each session starts with a header */
+        pSink->len = log_compact_header(&pSink->strings, &pSink->buf[0]);
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_sink_set_index(LogSink_t *pSink, LogIndex_t *pIndex, const char *pLogPath)
+{
+    struct stat fileStat;
+
+    if((pSink == NULL) || (pIndex == NULL) || (pLogPath == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* offsets in a compressed file are into the decompressed stream, which
+     * can't be seeked into without decompressing everything before it */
+    if(pSink->compress) {
+        ERROR_PRINT("compressed log files can't be indexed\n");
+        return LOG_STATUS_NOTOK;
+    }
+    if(fstat(pSink->fd, &fileStat) != 0) {
+        ERRNO_PRINT("log_sink_set_index fstat failed");
+        return LOG_STATUS_NOTOK;
+    }
+    pSink->indexBase = (uint64_t)fileStat.st_size - pSink->storedBytes;
+    if(log_index_open(pIndex, pLogPath, pSink->indexBase + pSink->storedBytes) != LOG_STATUS_OK) {
+        return LOG_STATUS_NOTOK;
+    }
+    pSink->pIndex = pIndex;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_sink_write_item(LogSink_t *pSink, logItem_t *pLogItem)
+{
+    uint32_t len;
+
+    if((pSink == NULL) || (pLogItem == NULL)) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* size-triggered flush; make room for a worst case record */
+    if((pSink->bufLimit - pSink->len) < LOG_SINK_MAX_RECORD_SIZE) {
+        if(log_sink_flush(pSink) != LOG_STATUS_OK)
+            return LOG_STATUS_NOTOK;
+    }
+
+    /* a compact chunk redefines the strings it uses so it reads on its own */
+    if((pSink->pIndex != NULL) && log_index_add(pSink->pIndex, pLogItem)) {
+        pSink->strings.num = 0;
+    }
+
+    if(pSink->format == LOG_FORMAT_COMPACT)
+        len = log_serialize_compact(&pSink->strings, pLogItem, &pSink->buf[pSink->len], pSink->bufLimit - pSink->len);
+    else
+        len = log_serialize_item(pLogItem, &pSink->buf[pSink->len], pSink->bufLimit - pSink->len);
+    if(len == 0) {
+        ERROR_PRINT("log_sink_write_item failed to serialize msgId %d\n", pLogItem->logMsgId);
+        return LOG_STATUS_NOTOK;
+    }
+    pSink->len += len;
+    ++pSink->records;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_sink_poll(LogSink_t *pSink)
+{
+    if(pSink == NULL) {
+        return LOG_STATUS_NOTOK;
+    }
+
+    /* time-triggered flush */
+    if((pSink->len > 0) && ((log_get_time() - pSink->lastFlushTime) >= pSink->flushUsec)) {
+        return log_sink_flush(pSink);
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t log_sink_flush(LogSink_t *pSink)
+{
+    uint8_t ret;
+
+    if(pSink == NULL) {
+        return LOG_STATUS_NOTOK;
+    }
+    if(pSink->len == 0) {
+        return LOG_STATUS_OK;
+    }
+
+    pSink->rawBytes += pSink->len;
+    if(pSink->compress)
+        ret = log_sink_write_all(pSink, pSink->zbuf, log_sink_block(pSink));
+    else
+        ret = log_sink_write_all(pSink, pSink->buf, pSink->len);
+
+    /* on error the buffer is discarded too; keeping it would wedge every later write */
+    pSink->len = 0;
+    pSink->lastFlushTime = log_get_time();
+
+    if((pSink->pIndex != NULL) &&
+       (log_index_flushed(pSink->pIndex, pSink->indexBase + pSink->storedBytes) != LOG_STATUS_OK)) {
+        ret = LOG_STATUS_NOTOK;
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_serialize_item(logItem_t *pLogItem, uint8_t *pBuf, uint32_t maxLen)
+{
+    uint32_t len = 0, ret;
+    uint8_t *pChar;
+
+    if((pLogItem == NULL) || (pBuf == NULL) ||
+       ((pLogItem->payloadLength > 0) && (pLogItem->pPayload == NULL))) {
+        return 0;
+    }
+
+    /* field order and encoding must match log_write_item() */
+    if(maxLen < 1)
+        return 0;
+    pBuf[len++] = FRAME_START_BYTE;
+
+    if((ret = put_integer(pLogItem->logMsgId, &pBuf[len], maxLen - len)) == 0)
+        return 0;
+    len += ret;
+
+    pChar = log_item_filename(pLogItem);
+    do {
+        if(len >= maxLen)
+            return 0;
+        pBuf[len++] = *pChar;
+    } while(*pChar++ != '\0');
+
+    if((ret = put_integer(pLogItem->lineNum, &pBuf[len], maxLen - len)) == 0)
+        return 0;
+    len += ret;
+    if((ret = put_integer(pLogItem->time, &pBuf[len], maxLen - len)) == 0)
+        return 0;
+    len += ret;
+    if((ret = put_integer(pLogItem->payloadLength, &pBuf[len], maxLen - len)) == 0)
+        return 0;
+    len += ret;
+
+    if(pLogItem->payloadLength > (maxLen - len))
+        return 0;
+    memcpy(&pBuf[len], pLogItem->pPayload, pLogItem->payloadLength);
+    len += pLogItem->payloadLength;
+
+    if((ret = put_integer(pLogItem->sourceId, &pBuf[len], maxLen - len)) == 0)
+        return 0;
+    len += ret;
+    if((ret = put_integer(pLogItem->checksum, &pBuf[len], maxLen - len)) == 0)
+        return 0;
+    len += ret;
+
+    if(len >= maxLen)
+        return 0;
+    pBuf[len++] = FRAME_STOP_BYTE;
+
+    return len;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_compact_header(LogStrings_t *pStrings, uint8_t *pBuf)
+{
+    memset(pBuf, 0, LOG_COMPACT_FILE_HDR_SIZE);
+    memcpy(&pBuf[0], LOG_COMPACT_MAGIC, LOG_COMPACT_MAGIC_SIZE);
+    log_put_le16(&pBuf[4], LOG_COMPACT_VERSION);
+    log_put_le16(&pBuf[6], LOG_COMPACT_FILE_HDR_SIZE);
+    log_put_le16(&pBuf[8], LOG_COMPACT_REC_HDR_SIZE);
+    pStrings->num = 0;
+    return LOG_COMPACT_FILE_HDR_SIZE;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t log_serialize_compact(LogStrings_t *pStrings, logItem_t *pLogItem, uint8_t *pBuf, uint32_t maxLen)
+{
+    uint32_t len = 0;
+    uint16_t fileId, nameLen;
+    uint8_t *pName;
+
+    if((pStrings == NULL) || (pLogItem == NULL) || (pBuf == NULL) ||
+       (pLogItem->payloadLength > LOG_MSG_PAYLOAD_SIZE) ||
+       ((pLogItem->payloadLength > 0) && (pLogItem->pPayload == NULL))) {
+        return 0;
+    }
+    pName = log_item_filename(pLogItem);
+
+    /* intern filename */
+    for(fileId = 0; fileId < pStrings->num; ++fileId)
+    {
+        if(strncmp((char *)pStrings->names[fileId], (char *)pName, LOG_MSG_FILENAME_SIZE) == 0)
+            break;
+    }
+    if(fileId == pStrings->num)
+    {
+        /* table full, start over; reader lets later entries redefine an ID */
+        if(pStrings->num == LOG_SINK_MAX_STRINGS) {
+            pStrings->num = 0;
+            fileId = 0;
+        }
+        strncpy((char *)pStrings->names[fileId], (char *)pName, LOG_MSG_FILENAME_SIZE - 1);
+        pStrings->names[fileId][LOG_MSG_FILENAME_SIZE - 1] = '\0';
+        ++pStrings->num;
+
+        nameLen = strlen((char *)pStrings->names[fileId]);
+        if((LOG_COMPACT_STR_HDR_SIZE + nameLen) > maxLen)
+            return 0;
+        pBuf[0] = LOG_COMPACT_TAG_STRING;
+        pBuf[1] = 0;
+        log_put_le16(&pBuf[2], fileId);
+        log_put_le16(&pBuf[4], nameLen);
+        memcpy(&pBuf[LOG_COMPACT_STR_HDR_SIZE], pStrings->names[fileId], nameLen);
+        len = LOG_COMPACT_STR_HDR_SIZE + nameLen;
+    }
+
+    if((len + LOG_COMPACT_REC_HDR_SIZE + pLogItem->payloadLength) > maxLen)
+        return 0;
+    pBuf += len;
+    pBuf[0] = LOG_COMPACT_TAG_RECORD;
+    pBuf[1] = (uint8_t)pLogItem->logMsgId;
+    log_put_le16(&pBuf[2], fileId);
+    log_put_le16(&pBuf[4], pLogItem->lineNum);
+    log_put_le16(&pBuf[6], pLogItem->sourceId);
+    log_put_le32(&pBuf[8], pLogItem->time);
+    log_put_le32(&pBuf[12], pLogItem->checksum);
+    log_put_le16(&pBuf[16], (uint16_t)pLogItem->payloadLength);
+    log_put_le16(&pBuf[18], 0);
+    memcpy(&pBuf[LOG_COMPACT_REC_HDR_SIZE], pLogItem->pPayload, pLogItem->payloadLength);
+
+    return len + LOG_COMPACT_REC_HDR_SIZE + pLogItem->payloadLength;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief refuse to append to a non-empty file written in another format, or
+ * compressed when the sink isn't (or the other way round); a compressed
+ * file's format is that of its first block's contents, and a file that
+ * starts with neither magic is taken to be legacy
+ */
+static uint8_t log_sink_check_existing(LogSink_t *pSink)
+{
+    uint8_t hdr[LOG_BLOCK_HDR_SIZE];
+    const uint8_t *pStart = hdr;
+    LogFormat_e found = LOG_FORMAT_LEGACY;
+    uint8_t compressed = 0;
+    struct stat fileStat;
+    ssize_t len;
+
+    if(fstat(pSink->fd, &fileStat) != 0) {
+        ERRNO_PRINT("log_sink_check_existing fstat failed");
+        return LOG_STATUS_NOTOK;
+    }
+    if(fileStat.st_size == 0)
+        return LOG_STATUS_OK;
+
+    len = pread(pSink->fd, hdr, sizeof(hdr), 0);
+    if((len >= LOG_BLOCK_MAGIC_SIZE) && (memcmp(hdr, LOG_BLOCK_MAGIC, LOG_BLOCK_MAGIC_SIZE) == 0)) {
+        compressed = 1;
+        len = (len == sizeof(hdr)) ? log_sink_first_block(pSink, hdr) : 0;
+        if(len == 0) {
+            ERROR_PRINT("existing log file is compressed, its first block can't be read; won't append\n");
+            return LOG_STATUS_NOTOK;
+        }
+        pStart = pSink->buf;
+    }
+    if((len >= LOG_COMPACT_MAGIC_SIZE) && (memcmp(pStart, LOG_COMPACT_MAGIC, LOG_COMPACT_MAGIC_SIZE) == 0))
+        found = LOG_FORMAT_COMPACT;
+
+    if((found != pSink->format) || (compressed != pSink->compress)) {
+        ERROR_PRINT("existing log file is %s%s format, won't append %s%s records\n",
+                    (compressed) ? "compressed " : "", sinkFormatNames[found],
+                    (pSink->compress) ? "compressed " : "", sinkFormatNames[pSink->format]);
+        return LOG_STATUS_NOTOK;
+    }
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief decompress a compressed file's first block into buf, which is
+ * still empty when the sink is set up
+ *
+ * @return uint32_t bytes in buf, 0 if the block is corrupt or bigger than
+ * the sink writes
+ */
+static uint32_t log_sink_first_block(LogSink_t *pSink, const uint8_t *pHdr)
+{
+    uint32_t rawLen = log_get_le32(&pHdr[4]);
+    uint32_t compLen = log_get_le32(&pHdr[8]);
+    uint32_t storedLen = (compLen != 0) ? compLen : rawLen;
+    uint8_t *pStored = (compLen != 0) ? pSink->zbuf : pSink->buf;
+
+    if((rawLen > sizeof(pSink->buf)) || (storedLen > sizeof(pSink->zbuf)))
+        return 0;
+    if(pread(pSink->fd, pStored, storedLen, LOG_BLOCK_HDR_SIZE) != (ssize_t)storedLen)
+        return 0;
+    if(compLen == 0)
+        return rawLen;
+    return (log_lz_decompress(pSink->zbuf, compLen, pSink->buf, sizeof(pSink->buf)) == rawLen) ? rawLen : 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief write() until all of pData is written
+ */
+static uint8_t log_sink_write_all(LogSink_t *pSink, const uint8_t *pData, uint32_t len)
+{
+    uint32_t written = 0;
+    ssize_t ret;
+
+    while(written < len)
+    {
+        ret = write(pSink->fd, &pData[written], len - written);
+        ++pSink->writeCalls;
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            ERRNO_PRINT("log_sink_flush write failed");
+            return LOG_STATUS_NOTOK;
+        }
+        written += ret;
+    }
+    pSink->storedBytes += len;
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief build a block from buf in zbuf; stored as is when compression
+ * doesn't shrink it
+ *
+ * @return uint32_t bytes of block in zbuf
+ */
+static uint32_t log_sink_block(LogSink_t *pSink)
+{
+    uint32_t compLen;
+
+    compLen = log_lz_compress(pSink->buf, pSink->len, &pSink->zbuf[LOG_BLOCK_HDR_SIZE],
+                              sizeof(pSink->zbuf) - LOG_BLOCK_HDR_SIZE);
+    if((compLen == 0) || (compLen >= pSink->len)) {
+        compLen = 0;
+        memcpy(&pSink->zbuf[LOG_BLOCK_HDR_SIZE], pSink->buf, pSink->len);
+    }
+
+    memcpy(&pSink->zbuf[0], LOG_BLOCK_MAGIC, LOG_BLOCK_MAGIC_SIZE);
+    log_put_le32(&pSink->zbuf[4], pSink->len);
+    log_put_le32(&pSink->zbuf[8], compLen);
+    log_put_le32(&pSink->zbuf[12], 0);
+    return LOG_BLOCK_HDR_SIZE + ((compLen != 0) ? compLen : pSink->len);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief hex ascii integer, null terminated, same as log_integer() writes
+ */
+static uint32_t put_integer(int32_t num, uint8_t *pBuf, uint32_t maxLen)
+{
+    uint8_t numStr[MAX_INT_STRING_SIZE];
+    uint8_t len = my_itoa(num, numStr, HEX_BASE);
+
+    if((len == 0) || (len > maxLen))
+        return 0;
+
+    memcpy(pBuf, numStr, len);
+    return len;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -33,13 +33,21 @@
 #include "platform.h"
 #include "healthMonitor.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_LOGGING_THREAD);
+
 static uint8_t aliveFlag = 1;
 
 /*---------------------------------------------------------------------------------*/
 void* logThreadHandler(void* threadInfo)
 {
     SensorThreadInfo sensorInfo = *(SensorThreadInfo *)threadInfo;
-    int logFd;                                          /* log file descriptor */
+    LogThreadInfo *pLogInfo = (LogThreadInfo *)threadInfo;
+    int logFd = -1;                                     /* log file descriptor */
+    LogSink_t logSink;                                  /* batches writes to logFd */
+    static LogIndex_t logIndex;                         /* <logfile>.idx, for logQuery */
+    LogIndex_t *pIndex = NULL;
+    static LogSegment_t logSegment;                     /* mmap'd segments, if configured */
+    LogSegment_t *pSegment = NULL;
     mqd_t hbMsgQueue = -1;                              /* main status MessageQueue */
     struct timespec currentTime, lastStatusMsgTime;     /* to calc delta time */
     float deltaTime;                                    /* delta time since last sent status msg */
@@ -52,16 +60,15 @@ void* logThreadHandler(void* threadInfo)
     sigset_t set;
     int signum = SIGALRM;
     struct timespec timer_interval;
-    uint8_t ind, statusMsgCount, logMsgCount;
+    uint8_t ind, statusMsgCount;
+    uint16_t logMsgCount, refMsgCount;
 	sigset_t mask;
 
     /* instantiate temp msg variable for dequeuing */
     logItem_t logItem, prevLogItem;
-    uint8_t filename[64];
     uint8_t payload[128];
 
     memset(&logItem, 0, sizeof(logItem_t));
-    logItem.pFilename = filename;
     logItem.pPayload = payload;
     logItem.logMsgId = LOG_MSG_INFO;
     prevLogItem = logItem;
@@ -70,6 +77,9 @@ void* logThreadHandler(void* threadInfo)
     uint8_t exitFlag = 1;
     uint8_t noMsgRecvd;
     uint8_t ret;
+#ifdef LOG_RING_BUFFER
+    uint32_t ringDrops, prevRingDrops = 0;
+#endif
 
     /* add start msg to log msg queue */
     LOG_LOG_EVENT(LOG_EVENT_STARTED);
@@ -92,9 +102,22 @@ void* logThreadHandler(void* threadInfo)
     }
     pthread_sigmask(SIG_BLOCK, &mask, NULL);
 
+    /* segmented storage replaces the single log file */
+    if(pLogInfo->segmentSize != 0)
+    {
+        if(log_segment_open(&logSegment, pLogInfo->logFileName, pLogInfo->segmentSize,
+                            pLogInfo->segmentsKept, pLogInfo->logFormat) == LOG_STATUS_OK) {
+            pSegment = &logSegment;
+        }
+        else {
+            WARN_PRINT("loggingThread can't create log segments, using single log file\n");
+        }
+    }
+
     /* try to open logfile */
-    logFd = open(((LogThreadInfo *)threadInfo)->logFileName, O_CREAT | O_WRONLY | O_NONBLOCK | O_SYNC | O_APPEND, 0644);
-    if(logFd < 0)
+    if(pSegment == NULL)
+        logFd = open(pLogInfo->logFileName, O_CREAT | O_RDWR | O_NONBLOCK | O_SYNC | O_APPEND, 0644);
+    if((pSegment == NULL) && (logFd < 0))
     {
         ERRNO_PRINT("loggingThread failed to open log file");
         SEND_STATUS_MSG(hbMsgQueue, PID_LOGGING, STATUS_ERROR, ERROR_CODE_USER_TERMALL0);
@@ -105,6 +128,32 @@ void* logThreadHandler(void* threadInfo)
         LOG_LOG_EVENT(LOG_EVENT_OPEN_LOGFILE_ERROR);
         return NULL;
     }
+    /* refused if the file is already in another format (printed by the sink);
+     * writing any other format into it would leave it unreadable */
+    if((pSegment == NULL) &&
+       (log_sink_init(&logSink, logFd, pLogInfo->logFormat, pLogInfo->compress) != LOG_STATUS_OK))
+    {
+        ERROR_PRINT("loggingThread won't write %s%s records to %s, not logging; "
+                    "start with its format or another log file\n",
+                    (pLogInfo->logFormat == LOG_FORMAT_COMPACT) ? "compact" : "legacy",
+                    (pLogInfo->compress) ? " compressed" : "", pLogInfo->logFileName);
+        close(logFd);
+        SEND_STATUS_MSG(hbMsgQueue, PID_LOGGING, STATUS_ERROR, ERROR_CODE_USER_TERMALL0);
+        LOG_LOG_EVENT(LOG_EVENT_OPEN_LOGFILE_ERROR);
+        return NULL;
+    }
+
+    /* logging carries on unindexed if the index can't be kept */
+    if((pSegment == NULL) && !logSink.compress) {
+        if(log_sink_set_index(&logSink, &logIndex, pLogInfo->logFileName) == LOG_STATUS_OK)
+            pIndex = &logIndex;
+        else
+            WARN_PRINT("loggingThread can't write log index, queries will scan the log\n");
+    }
+
+    /* remote server hands over nodes' records by reference from now on */
+    log_ref_open();
+
     /* add log event msg to queue */
     LOG_LOG_EVENT(LOG_EVENT_FILE_OPEN);
     LOG_LOG_EVENT(LOG_EVENT_BIST_COMPLETE);
@@ -127,6 +176,7 @@ void* logThreadHandler(void* threadInfo)
         /* read all messages until none */
         noMsgRecvd = 0;
         logMsgCount = 0;
+        refMsgCount = 0;
         do {
             statusMsgCount = 0;
 
@@ -139,8 +189,18 @@ void* logThreadHandler(void* threadInfo)
                 exitFlag = 0;
             }
 
-            /* dequeue a msg */
-            ret = LOG_DEQUEUE_ITEM(&logItem);
+            /* dequeue a msg; remote nodes' first, payload still in the
+             * receive buffer until the next dequeue, but at most a ring's
+             * worth a loop so the msg queue gets its turn */
+            logItem.pPayload = payload;
+            ret = LOG_STATUS_TIMEOUT;
+            if(refMsgCount < LOG_REF_DEPTH) {
+                ret = log_ref_dequeue_item(&logItem);
+                if(ret == LOG_STATUS_OK)
+                    ++refMsgCount;
+            }
+            if(ret == LOG_STATUS_TIMEOUT)
+                ret = LOG_DEQUEUE_ITEM(&logItem);
 
             /* check if queue is empty */
             if(ret == LOG_STATUS_TIMEOUT) {
@@ -159,6 +219,11 @@ void* logThreadHandler(void* threadInfo)
             {
                 MUTED_PRINT("Logger successfully dequeued msg, count: %d\n", logMsgCount);
 
+                /* producers enqueue raw args, format them here */
+                if(log_render_item(&logItem) != LOG_STATUS_OK) {
+                    ERROR_PRINT("log_render_item failed for msgId %d\n", logItem.logMsgId);
+                }
+
                 /* verify msg is unique */
                 if ((prevLogItem.logMsgId != logItem.logMsgId) || (prevLogItem.time != logItem.time) || 
                     (prevLogItem.checksum != logItem.checksum))
@@ -170,7 +235,11 @@ void* logThreadHandler(void* threadInfo)
                 
                     /* if read from queue successful, right to file */
                     MUTED_PRINT("writing log msg to file\n");
-                    if(LOG_WRITE_ITEM(&logItem, logFd) != LOG_STATUS_OK)
+                    if(pSegment != NULL)
+                        ret = log_segment_write_item(pSegment, &logItem);
+                    else
+                        ret = LOG_WRITE_ITEM(&logItem, &logSink);
+                    if(ret != LOG_STATUS_OK)
                     {
                         ERROR_PRINT("log_dequeue_item error\n");
                         SEND_STATUS_MSG(hbMsgQueue, PID_LOGGING, STATUS_ERROR, ERROR_CODE_USER_NOTIFY0);
@@ -197,20 +266,44 @@ void* logThreadHandler(void* threadInfo)
             }
 
             /* if processed too many, exit*/
-            if(logMsgCount > (NUM_THREADS + NUM_REMOTE_REPORTING_THREADS) * 20) {
+            if(logMsgCount > LOG_LOOP_MAX_MSGS) {
                 INFO_PRINT("max log processing limit reached\n");
                 noMsgRecvd = 1;
             }
         } while((noMsgRecvd == 0) && (exitFlag));
 
+        /* write batch to file (or msync segment) if it has waited long enough */
+        ret = (pSegment != NULL) ? log_segment_poll(pSegment) : log_sink_poll(&logSink);
+        if(ret != LOG_STATUS_OK) {
+            LOG_LOG_EVENT(LOG_EVENT_WRITE_LOGFILE_ERROR);
+        }
+
+#ifdef LOG_RING_BUFFER
+        /* producers drop rather than block when their ring is full */
+        ringDrops = log_ring_get_drops();
+        if(ringDrops != prevRingDrops) {
+            WARN_PRINT("log rings dropped %u items\n", ringDrops - prevRingDrops);
+            prevRingDrops = ringDrops;
+        }
+#endif
+
         /* wait on signal timer */
         sigwait(&set, &signum);
     }
 
-    /* clean up */
+    /* clean up; anything still buffered is written before file is closed */
     timer_delete(timerid);
-    close(logFd);
+    if(pSegment != NULL) {
+        log_segment_close(pSegment);
+    }
+    else {
+        log_sink_flush(&logSink);
+        if(pIndex != NULL)
+            log_index_close(pIndex);
+        close(logFd);
+    }
     mq_close(hbMsgQueue);
+    log_ref_close();
     ERROR_PRINT("logger thread exiting\n");
     return NULL;
 }
@@ -32,6 +32,7 @@
 #include <errno.h>
 
 #include "remoteThread.h"
+#include "remoteServer.h"
 #include "loggingThread.h"
 #include "packet.h"
 #include "bbgLeds.h"
@@ -40,6 +41,12 @@
 #include "cmn_timer.h"
 #include "platform.h"
 #include "healthMonitor.h"
+#include "supervisor.h"
+#include "healthSnapshot.h"
+#include "watchdog.h"
+#include "nodeTable.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_MAIN);
 
 #define FOUND_GPIO_LIB
 #define MAIN_LOG_EXIT_DELAY (100 * 1000)
@@ -50,6 +57,7 @@
 #define HOUR_TO_SEC (1) // For demo/testing, set to seconds
 #define SOIL_MAX_WATER_CHECK_COUNT (15) // For demo/testing, num seconds
 #define LUX_MAX_THRESHOLD (200) // Peak "sunlight" threshold to avoid watering plant
+#define LOG_FILTER_CODE_BASE (100) // log filter cmd value is action * 100 + msg/process/level
 
 /* private functions */
 void set_sig_handlers(void);
@@ -57,10 +65,16 @@ void sigintHandler(int sig);
 void displayCommandMenu();
 int8_t handleConsoleCmd(uint32_t cmd);
 int readInputNonBlock();
-void setPeriodicWaterSched(uint32_t hours);
-void setOneshotWaterSched(uint32_t hours);
-void cancelWaterSched();
-static void waterDeviceTx();
+void setPeriodicWaterSched(NodeControl_t *pControl, uint32_t hours);
+void setOneshotWaterSched(NodeControl_t *pControl, uint32_t hours);
+void cancelWaterSched(NodeControl_t *pControl);
+static void waterDeviceTx(RemoteNode_t *pNode);
+static void controlNode(RemoteNode_t *pNode);
+static int8_t selectNode(RemoteNode_t *pNode);
+static void printNodes(void);
+static uint64_t secNow(void);
+static void setLogFilter(uint32_t code);
+static void publishSnapshot(mqd_t *pQueues);
 
 /* Define static and global variables */
 pthread_t gThreads[NUM_THREADS];
@@ -68,47 +82,126 @@ static uint8_t gExit = 1;
 
 static RemoteCmd_e gCurrentCmd = 0; /* Tracks current user cmd if waiting for additional data */
 static mqd_t cmdMsgQueue;
-static timer_t waterTimerid;
-uint32_t waterCyclePeriodHours = 0;
-float soilMoistureHigh = SOIL_SATURATION_HIGH_THRES;
-float soilMoistureLow = SOIL_SATURATION_LOW_THRES;
-float luxData, moistureData = 0;
-uint32_t soilWateringCount = 0;
-bool checkingSoilMoisture = false;
-
-/* Variables to track system operating state */
-ControlLoopState_e controlLoopState = IDLE;
+static uint16_t gSelectedNode = NODE_ID_NONE; /* node console cmds act on */
+
+/* Variables to track system operating state; each node's control loop
+ * state is in the node table, the system is in FAULT if any node is */
 SystemState_e systemState = NOMINAL;
 
 int main(int argc, char *argv[]){
   char *heartbeatMsgQueueName = "/heartbeat_mq";
   char *logMsgQueueName = "/logging_mq";
-  char *dataMsgQueueName = "/data_mq";
   char *cmdMsgQueueName = "/cmd_mq";
   char *logFile = "/usr/bin/log.bin";
+  char *policyFile = NULL;
+  char *watchdogDevice = NULL;
+  LogFormat_e logFormat = LOG_FORMAT_LEGACY;
+  uint32_t segmentSize = 0;
+  uint8_t segmentsKept = LOG_SEGMENT_DEFAULT_KEEP;
+  uint8_t compress = 0;
   SensorThreadInfo sensorThreadInfo;
   LogThreadInfo logThreadInfo;
   LogMsgPacket logPacket;
   struct mq_attr mqAttr;
   mqd_t logMsgQueue;
   mqd_t heartbeatMsgQueue;
-  mqd_t dataMsgQueue;
-  char ind;
+  HealthMonitor_t healthMonitor;
+  pthread_t healthMonitorThread;
+  uint8_t healthMonitorRunning = 0;
+  HealthSnapshotServer_t snapshotServer;
+  pthread_t snapshotThread;
+  uint8_t snapshotRunning = 0;
+  mqd_t snapshotQueues[SNAPSHOT_QUEUE_END];
+  Watchdog_t watchdog;
+  pthread_t watchdogThread;
+  uint8_t watchdogRunning = 0;
   uint8_t newError;
+  unsigned long optValue;
+  char *pOptEnd;
+  int opt;
 
   /* Variables for handling user input cmds */
   char userInputBuffer[BUFFER_SIZE];
   uint32_t userInput = 0;
 
-  /* Variables for tx/rx of data with remoteNode */
-  RemoteDataPacket dataPacket = {0};
-  size_t dataPacketSize = sizeof(struct RemoteDataPacket);
+  /* Variables for running each remote node's control loop */
+  uint16_t nodeIds[NODE_TABLE_MAX_NODES];
+  uint16_t numNodes, nodeInd;
+  RemoteNode_t node;
+  SystemState_e nodesState;
+
+  /* parse cmdline args: main [-f legacy|compact] [-s segmentKB] [-k segmentsKept] [-z] [-p policyFile] [-w watchdogDev] [logfile] */
+  while((opt = getopt(argc, argv, "f:s:k:zp:w:")) != -1) {
+    switch(opt) {
+      case 'f':
+        if(strcmp(optarg, "compact") == 0) {
+          logFormat = LOG_FORMAT_COMPACT;
+        } else if(strcmp(optarg, "legacy") == 0) {
+          logFormat = LOG_FORMAT_LEGACY;
+        } else {
+          ERROR_PRINT("unknown log format %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 's':
+        /* range checked in KB, before the multiply can overflow */
+        errno = 0;
+        optValue = strtoul(optarg, &pOptEnd, 0);
+        if((errno != 0) || (pOptEnd == optarg) || (*pOptEnd != '\0') || (optarg[0] == '-') ||
+           (optValue < (LOG_SEGMENT_MIN_SIZE / 1024)) || (optValue > (LOG_SEGMENT_MAX_SIZE / 1024))) {
+          ERROR_PRINT("log segments must be %d to %d KB\n", LOG_SEGMENT_MIN_SIZE / 1024, LOG_SEGMENT_MAX_SIZE / 1024);
+          ERROR_PRINT("usage: %s [-f legacy|compact] [-s segmentKB] [-k segmentsKept] [-z] [-p policyFile] [-w watchdogDev] [logfile]\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+        segmentSize = (uint32_t)optValue * 1024;
+        break;
+      case 'k':
+        errno = 0;
+        optValue = strtoul(optarg, &pOptEnd, 0);
+        if((errno != 0) || (pOptEnd == optarg) || (*pOptEnd != '\0') || (optarg[0] == '-') ||
+           (optValue == 0) || (optValue > LOG_SEGMENT_MAX_KEEP)) {
+          ERROR_PRINT("must keep 1 to %d log segments\n", LOG_SEGMENT_MAX_KEEP);
+          ERROR_PRINT("usage: %s [-f legacy|compact] [-s segmentKB] [-k segmentsKept] [-z] [-p policyFile] [-w watchdogDev] [logfile]\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+        segmentsKept = (uint8_t)optValue;
+        break;
+      case 'z':
+        compress = 1;
+        break;
+      case 'p':
+        policyFile = optarg;
+        break;
+      case 'w':
+        watchdogDevice = optarg;
+        break;
+      default:
+        ERROR_PRINT("usage: %s [-f legacy|compact] [-s segmentKB] [-k segmentsKept] [-z] [-p policyFile] [-w watchdogDev] [logfile]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if(optind < argc) {
+    logFile = argv[optind];
+  }
+  if(compress && (segmentSize != 0)) {
+    ERROR_PRINT("compressed logging (-z) only supports a single log file, not segments\n");
+    return EXIT_FAILURE;
+  }
+  printf("logfile: %s (%s format%s)\n", logFile, (logFormat == LOG_FORMAT_COMPACT) ? "compact" : "legacy",
+         compress ? ", compressed" : "");
+  if(segmentSize != 0) {
+    printf("log segments: %u KB, keeping %u\n", segmentSize / 1024, segmentsKept);
+  }
 
-  /* parse cmdline args */
-  if(argc >= 2) {
-    logFile = argv[1];
+  /* error policy overrides; the default file is optional, one named on the cmdline isn't */
+  if(policyFile != NULL) {
+    if(error_policy_load(policyFile) != EXIT_SUCCESS) {
+      ERROR_PRINT("bad error policy file %s\n", policyFile);
+      return EXIT_FAILURE;
+    }
+  } else if(access(ERROR_POLICY_DEFAULT_FILE, R_OK) == 0) {
+    error_policy_load(ERROR_POLICY_DEFAULT_FILE);
   }
-  printf("logfile: %s\n", logFile);
 
   /* Thread timer variables */
   static timer_t timerid;
@@ -116,9 +209,6 @@ int main(int argc, char *argv[]){
   int signum = SIGALRM;
   struct timespec timer_interval;
 
-  /* Watering timer variables */
-  struct sigevent waterSigEvent;
-
   /* set signal handlers and actions */
 	set_sig_handlers();
   struct sigaction sigAction;
@@ -126,6 +216,12 @@ int main(int argc, char *argv[]){
   sigAction.sa_flags = 0;
   sigaction(SIGINT, &sigAction, NULL);
 
+  /* the remote server, not the per-port thread, owns the remote data kill signal */
+  sigemptyset(&sigAction.sa_mask);
+  sigAction.sa_sigaction = remoteServerSigHandler;
+  sigAction.sa_flags = SA_SIGINFO;
+  sigaction(SIGRTMIN + (uint8_t)REMOTE_SERVER_PID, &sigAction, NULL);
+
   /* Initialize created structs and packets to be 0-filled */
   memset(&sensorThreadInfo, 0, sizeof(struct SensorThreadInfo));
   memset(&logThreadInfo,    0, sizeof(struct LogThreadInfo));
@@ -141,10 +237,6 @@ int main(int argc, char *argv[]){
   if(remove(heartbeatMsgQueueName) == -1 && errno != ENOENT)
   { ERRNO_PRINT("main() couldn't delete heartbeat msg queue path"); return EXIT_FAILURE; }
 
-  mq_unlink(dataMsgQueueName);
-  if(remove(dataMsgQueueName) == -1 && errno != ENOENT)
-	  ERRNO_PRINT("main() couldn't delete data msg queue path");
-
   mq_unlink(cmdMsgQueueName);
   if(remove(cmdMsgQueueName) == -1 && errno != ENOENT)
 	  ERRNO_PRINT("main() couldn't delete cmd msg queue path");
@@ -168,6 +260,10 @@ int main(int argc, char *argv[]){
   strcpy(logThreadInfo.heartbeatMsgQueueName, heartbeatMsgQueueName);
   strcpy(logThreadInfo.logMsgQueueName, logMsgQueueName);
   strcpy(logThreadInfo.logFileName, logFile);
+  logThreadInfo.logFormat = logFormat;
+  logThreadInfo.segmentSize = segmentSize;
+  logThreadInfo.segmentsKept = segmentsKept;
+  logThreadInfo.compress = compress;
 
   /* initialize the logger (i.e. queue & writeability) 
     * main should probably do this before creating
@@ -190,14 +286,8 @@ int main(int argc, char *argv[]){
   }
 
   /*** initialize rest of IPC resources ***/
-  /* Initialize Data MQ to receive sensor data from RemoteNode */
-  mqAttr.mq_msgsize = DATA_MSG_QUEUE_MSG_SIZE;
-  dataMsgQueue = mq_open(dataMsgQueueName, O_CREAT | O_RDWR | O_NONBLOCK, 0666, &mqAttr);
-  if(dataMsgQueue == -1)
-  {
-    ERROR_PRINT("ERROR: main() failed to create MessageQueue for Main Remote Data reception - exiting.\n");
-    return EXIT_FAILURE;
-  }
+  /* Remote nodes' sensor data and control state, filled in as they connect */
+  node_table_init();
 
   /* Initialize Cmd MQ to send commands to RemoteNode */
   mqAttr.mq_msgsize = CMD_MSG_QUEUE_MSG_SIZE;
@@ -218,38 +308,82 @@ int main(int argc, char *argv[]){
     return EXIT_FAILURE;
   }
 
+  /* Heartbeats are published to shared memory, the queue above carries errors */
+  if(heartbeat_init(HEARTBEAT_SHM_NAME) != EXIT_SUCCESS)
+  {
+    WARN_PRINT("main() couldn't create heartbeat table, all status through queue\n");
+  }
+
   /* Populate ThreadInfo objects to pass names for created IPC pieces to threads */
   strcpy(sensorThreadInfo.heartbeatMsgQueueName, heartbeatMsgQueueName);
   strcpy(sensorThreadInfo.logMsgQueueName, logMsgQueueName);
   strcpy(sensorThreadInfo.cmdMsgQueueName, cmdMsgQueueName);
-  strcpy(sensorThreadInfo.dataMsgQueueName, dataMsgQueueName);
+
+  /* Remote threads are supervised, re-created if they exit or are told to
+   * restart; the logger isn't, its exit ends the application's log */
+  if(supervisor_init(&gExit) != EXIT_SUCCESS)
+  {
+    WARN_PRINT("main() couldn't start thread supervisor, failed threads stay down\n");
+  }
 
   /* Create other threads */
-  if(pthread_create(&gThreads[1], NULL, remoteLogThreadHandler, (void*)&sensorThreadInfo))
+  /* One thread serves all four remote ports; it is supervised as
+   * REMOTE_SERVER_PID, restarting any of the remote Ids restarts it */
+  if(supervisor_start(REMOTE_SERVER_PID, remoteServerThreadHandler, (void*)&sensorThreadInfo, &gThreads[1]))
   {
-    ERROR_PRINT("ERROR: Failed to create Remote Log Thread - exiting main().\n");
+    ERROR_PRINT("ERROR: Failed to create Remote Server Thread - exiting main().\n");
     return EXIT_FAILURE;
   }
+  supervisor_alias(PID_REMOTE_LOG, REMOTE_SERVER_PID);
+  supervisor_alias(PID_REMOTE_STATUS, REMOTE_SERVER_PID);
+  supervisor_alias(PID_REMOTE_CMD, REMOTE_SERVER_PID);
  
-  if(pthread_create(&gThreads[2], NULL, remoteStatusThreadHandler, (void*)&sensorThreadInfo))
+  LOG_MAIN_EVENT(MAIN_EVENT_STARTED_THREADS);
+
+  /* Health monitor runs on its own, woken by heartbeat deadlines and status
+   * msgs; without the heartbeat table main polls it each loop instead */
+  if(healthMonitorInit(&healthMonitor, heartbeatMsgQueue, &gExit, HEALTH_DEADLINE_USEC) == EXIT_SUCCESS)
   {
-    ERROR_PRINT("ERROR: Failed to create Remote Status Thread - exiting main().\n");
-    return EXIT_FAILURE;
+    if(pthread_create(&healthMonitorThread, NULL, healthMonitorThreadHandler, (void*)&healthMonitor) == 0) {
+      healthMonitorRunning = 1;
+    } else {
+      ERROR_PRINT("ERROR: Failed to create Health Monitor Thread - polling from main loop.\n");
+    }
   }
- 
-  if(pthread_create(&gThreads[3], NULL, remoteDataThreadHandler, (void*)&sensorThreadInfo))
+
+  /* Read only health snapshots for local tools, published each main loop */
+  snapshotQueues[SNAPSHOT_QUEUE_LOG] = logMsgQueue;
+  snapshotQueues[SNAPSHOT_QUEUE_HEARTBEAT] = heartbeatMsgQueue;
+  snapshotQueues[SNAPSHOT_QUEUE_DATA] = (mqd_t)-1; /* data goes to the node table */
+  snapshotQueues[SNAPSHOT_QUEUE_CMD] = cmdMsgQueue;
+  publishSnapshot(snapshotQueues);
+  if(health_snapshot_server_init(&snapshotServer, HEALTH_SNAPSHOT_SOCKET) == EXIT_SUCCESS)
   {
-    ERROR_PRINT("ERROR: Failed to create Remote Data Thread - exiting main().\n");
-    return EXIT_FAILURE;
+    if(pthread_create(&snapshotThread, NULL, healthSnapshotThreadHandler, (void*)&snapshotServer) == 0) {
+      snapshotRunning = 1;
+    } else {
+      ERROR_PRINT("ERROR: Failed to create Health Snapshot Thread - no snapshot socket.\n");
+    }
   }
 
-  if(pthread_create(&gThreads[4], NULL, remoteCmdThreadHandler, (void*)&sensorThreadInfo))
+  /* Stalls of main or a thread it can't do without are written to the
+   * forensics file; with -w the watchdog device is only fed while there are none */
+  if(watchdog_init(&watchdog, watchdogDevice, WATCHDOG_FORENSICS_FILE,
+                   (1UL << PID_LOGGING) | (1UL << PID_REMOTE_LOG) | (1UL << PID_REMOTE_STATUS) |
+                   (1UL << PID_REMOTE_DATA) | (1UL << PID_REMOTE_CMD),
+                   HEALTH_DEADLINE_USEC, snapshotQueues) == EXIT_SUCCESS)
   {
-    ERROR_PRINT("ERROR: Failed to create Remote Cmd Thread - exiting main().\n");
+    if(pthread_create(&watchdogThread, NULL, watchdogThreadHandler, (void*)&watchdog) == 0) {
+      watchdogRunning = 1;
+    } else {
+      ERROR_PRINT("ERROR: Failed to create Watchdog Thread - stalls go unnoticed.\n");
+    }
+  }
+  else if(watchdogDevice != NULL)
+  {
+    ERROR_PRINT("ERROR: couldn't open watchdog %s - exiting.\n", watchdogDevice);
     return EXIT_FAILURE;
   }
- 
-  LOG_MAIN_EVENT(MAIN_EVENT_STARTED_THREADS);
 
   /* Clear memory objects */
   memset(&set, 0, sizeof(sigset_t));
@@ -260,13 +394,6 @@ int main(int argc, char *argv[]){
   timer_interval.tv_sec = MAIN_LOOP_TIME_SEC;
   setupTimer(&set, &timerid, signum, &timer_interval);
 
-  /* Create watering timer */
-  waterSigEvent.sigev_notify = SIGEV_THREAD;
-  waterSigEvent.sigev_value.sival_ptr = NULL;
-  waterSigEvent.sigev_notify_function = waterDeviceTx;
-  waterSigEvent.sigev_notify_attributes = NULL;
-  timer_create(CLOCK_REALTIME, &waterSigEvent, &waterTimerid);
-
   /* initialize status LED */
   initLed();
   setStatusLed(NOMINAL);
@@ -295,83 +422,52 @@ int main(int argc, char *argv[]){
       displayCommandMenu();
     }
 
-    /* If data received from TIVA, write to local data */
-    if(mq_receive(dataMsgQueue, (char *)&dataPacket, dataPacketSize, NULL) == dataPacketSize)
+    /** Control Loop, for each remote node **/
+    /* Based on each node's latest data and its control loop state, water
+     * on schedule and check watering finishes; only main writes control state */
+    nodesState = NOMINAL;
+    numNodes = node_table_list(nodeIds, NODE_TABLE_MAX_NODES);
+    for(nodeInd = 0; nodeInd < numNodes; ++nodeInd)
     {
-      luxData = dataPacket.luxData;
-      moistureData = dataPacket.moistureData;
+      if(node_table_get(nodeIds[nodeInd], &node) != EXIT_SUCCESS)
+        continue;
+      controlNode(&node);
+      node_table_set_control(node.nodeId, &node.control);
+      if(node.control.systemState == FAULT)
+        nodesState = FAULT;
     }
-
-    /** Control Loop **/
-    /* Based on current operating state, handle data returned from TIVA */
-    /* If soil moisture exceed saturation level, reset timer of next water cycle */
-    switch(controlLoopState) {
-      case WATER_PERIODIC_SCHED:
-        /* Waiting until next periodic watering cycle */
-        break;
-      case WATER_ONESHOT_SCHED:
-        /* Waiting until next one-shot watering cycle */
-        break;
-      case WATERING_PLANT:
-        /* Plant should be getting watered - remain in watering state until soil moisture exceeds threshold */
-        if(moistureData < soilMoistureHigh)
-        {
-          /* Continue watering plant */
-          /* Track number of times we've check soil moisture levels. If Count exceeds threshold, enter FAULT state */
-          soilWateringCount++;
-          if(checkingSoilMoisture && (soilWateringCount > SOIL_MAX_WATER_CHECK_COUNT)) {
-            ERROR_PRINT("Soil watering exceeded max count - entering FAULT state | Control Loop set to IDLE state\n");
-            controlLoopState = IDLE;
-            systemState = FAULT;
-            setStatusLed(systemState);
-            LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_IDLE_STATE);
-            LOG_MAIN_EVENT(MAIN_EVENT_SYSTEM_FAULT_STATE);
-          }
-        } 
-        else {
-          INFO_PRINT("Soil moisture level reported above threshold - Soil watering complete!\n");
-          /* Watering complete, update current state */
-          struct itimerspec waterTimeSpec;
-          timer_gettime(waterTimerid, &waterTimeSpec);
-          /* Check if timer scheduled; if zero, timer is disabled and set state to IDLE */
-          if(((int)waterTimeSpec.it_value.tv_sec == 0) && 
-             ((int)waterTimeSpec.it_value.tv_nsec == 0))
-          {
-            controlLoopState = IDLE;
-            LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_IDLE_STATE);
-          }
-          else {
-            controlLoopState = WATER_PERIODIC_SCHED;
-            LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_SCHEDPERIODIC_STATE);
-          }
-
-          /* If successfully watered and in FAULT state, reenter NOMINAL state */
-          if(systemState == FAULT) {
-            INFO_PRINT("Soil watering successful! - System state back to NOMINAL\n");
-            systemState = NOMINAL;
-            setStatusLed(systemState);
-            LOG_MAIN_EVENT(MAIN_EVENT_SYSTEM_NOMINAL_STATE);
-          }
-          checkingSoilMoisture = false;
-          soilWateringCount = 0;
-        }
-        break;
-      case IDLE:
-      default:
-        /* Awaiting control loop state change */
-        break;
+    if(nodesState != systemState) {
+      systemState = nodesState;
+      setStatusLed(systemState);
     }
 
     /* If wish to log each heartbeat event monitored by main, uncomment below */
     //LOG_HEARTBEAT();
 
-    newError = 0;
-    monitorHealth(&heartbeatMsgQueue, &gExit, &newError);
+    if(!healthMonitorRunning) {
+      newError = 0;
+      monitorHealth(&heartbeatMsgQueue, &gExit, &newError);
+    }
+    publishSnapshot(snapshotQueues);
+    watchdog_checkin();
 
     /* wait on signal timer */
     sigwait(&set, &signum);
   }
   INFO_PRINT("Main loop exited\n");
+  if(watchdogRunning) {
+    watchdog_stop(&watchdog);
+    pthread_join(watchdogThread, NULL);
+  }
+  if(healthMonitorRunning) {
+    healthMonitorStop(&healthMonitor);
+    pthread_join(healthMonitorThread, NULL);
+  }
+  if(snapshotRunning) {
+    health_snapshot_server_stop(&snapshotServer);
+    pthread_join(snapshotThread, NULL);
+  }
+  supervisor_stop();
   LOG_SYSTEM_HALTED();
 
   /* wait to kill log so exit msgs get logged */
@@ -386,22 +482,19 @@ int main(int argc, char *argv[]){
   sleep(1);
 
   /* join to clean up children */
-  for(ind = 0; ind < NUM_THREADS; ++ind) {
-    pthread_join(gThreads[(uint8_t)ind], NULL);
-  }
+  pthread_join(gThreads[0], NULL);
+  supervisor_join(REMOTE_SERVER_PID);
   
   
   /* Cleanup */
   printf("main() Cleanup.\n");
   timer_delete(timerid);
-  timer_delete(waterTimerid);
+  heartbeat_destroy(HEARTBEAT_SHM_NAME);
   mq_unlink(heartbeatMsgQueueName);
   mq_unlink(logMsgQueueName);
-  mq_unlink(dataMsgQueueName);
   mq_unlink(cmdMsgQueueName);
   mq_close(heartbeatMsgQueue);
   mq_close(logMsgQueue);
-  mq_close(dataMsgQueue);
   mq_close(cmdMsgQueue);
 }
 
@@ -418,10 +511,7 @@ int main(int argc, char *argv[]){
  */
 void sigintHandler(int sig){
   /* Send signal to all children threads to terminate */
-  pthread_kill(gThreads[1], SIGRTMIN + (uint8_t)PID_REMOTE_LOG);
-  pthread_kill(gThreads[2], SIGRTMIN + (uint8_t)PID_REMOTE_STATUS);
-  pthread_kill(gThreads[3], SIGRTMIN + (uint8_t)PID_REMOTE_DATA);
-  pthread_kill(gThreads[4], SIGRTMIN + (uint8_t)PID_REMOTE_CMD);
+  pthread_kill(gThreads[1], SIGRTMIN + (uint8_t)REMOTE_SERVER_PID);
   gExit = 0;
   
   /* Trigger while-loop in main to exit; cleanup allocated resources */
@@ -451,6 +541,21 @@ void displayCommandMenu()
     case CMD_SETMOISTURE_HIGHTHRES:
       INFO_PRINT("\nEnter a value to set for the Moisture Sensor High Threshold.\n");
       break;
+    case CMD_SELECT_NODE:
+      INFO_PRINT("\nEnter the ID of the remote node to send commands to.\n");
+      break;
+    case CMD_SET_TELEMETRY_HZ:
+      INFO_PRINT("\nEnter the telemetry rate in Hz (1 to %d).\n", REMOTE_TELEMETRY_MAX_HZ);
+      break;
+    case CMD_LOG_FILTER:
+      INFO_PRINT("\nEnter a log filter change:\n"
+             "\t1LL = Log level LL and above (100 info, 101 warning, 102 error)\n"
+             "\t2MM = Disable log msg MM (logMsg_e)\n"
+             "\t3MM = Enable log msg MM\n"
+             "\t4PP = Disable logs from process PP (ProcessId_e, %d = main/shared)\n"
+             "\t5PP = Enable logs from process PP\n"
+             "\t900 = Log everything\n", PID_END);
+      break;
     default:
       INFO_PRINT("\nEnter a value to specify a command to send to the Sensor Application:\n"
              "\t1 = Water Plant\n"
@@ -463,6 +568,10 @@ void displayCommandMenu()
              "\t8 = Set Moisture Low Threshold\n"
              "\t9 = Set Moisture High Threshold\n"
              "\t10 = Cancel Scheduled Watering Event\n"
+             "\t11 = Show/Change Log Filter\n"
+             "\t12 = Show Thread Heartbeat Statistics\n"
+             "\t13 = List/Select Remote Node (now node %u)\n"
+             "\t14 = Set Telemetry Rate\n", gSelectedNode
             );
       break;
   }
@@ -477,6 +586,8 @@ void displayCommandMenu()
 int8_t handleConsoleCmd(uint32_t userInput) {
   RemoteCmd_e txCmd = REMOTE_CMD_END;
   uint32_t data = 0;
+  RemoteNode_t node;
+  NodeControl_t *pControl = &node.control;
 
   if(gCurrentCmd != 0) {
     data = userInput;
@@ -489,143 +600,204 @@ int8_t handleConsoleCmd(uint32_t userInput) {
     INFO_PRINT("Invalid command received of {%d} - ignoring cmd\n", userInput);
     return EXIT_FAILURE;
   } 
-  else {
-    switch((ConsoleCmd_e)userInput)
-    {
-      case CMD_WATER_PLANT :
-        /* Populate packet and push onto cmdQueue to tx to Remote Node */
-        INFO_PRINT("CMD_WATER_PLANT\n");
-        waterDeviceTx();
-        break;
-      case CMD_SCHED_PERIODIC :
-        INFO_PRINT("CMD_SCHED_PERIODIC\n");
-        gCurrentCmd = CMD_SCHED_PERIODIC;
-        if(data != 0) {
-          setPeriodicWaterSched(data);
+
+  /* Cmds other than these act on the selected remote node */
+  if((userInput != CMD_LOG_FILTER) && (userInput != CMD_HEALTH_STATS) && (userInput != CMD_SELECT_NODE) &&
+     (selectNode(&node) != EXIT_SUCCESS)) {
+    gCurrentCmd = 0;
+    INFO_PRINT("No remote node has connected - ignoring cmd\n");
+    return EXIT_FAILURE;
+  }
+
+  switch((ConsoleCmd_e)userInput)
+  {
+    case CMD_WATER_PLANT :
+      /* Populate packet and push onto cmdQueue to tx to Remote Node */
+      INFO_PRINT("CMD_WATER_PLANT\n");
+      waterDeviceTx(&node);
+      break;
+    case CMD_SCHED_PERIODIC :
+      INFO_PRINT("CMD_SCHED_PERIODIC\n");
+      gCurrentCmd = CMD_SCHED_PERIODIC;
+      if(data != 0) {
+        setPeriodicWaterSched(pControl, data);
+        gCurrentCmd = 0;
+      }
+      break;
+    case CMD_SCHED_ONESHOT :
+      INFO_PRINT("CMD_SCHED_ONESHOT\n");
+      gCurrentCmd = CMD_SCHED_ONESHOT;
+      if(data != 0) {
+        setOneshotWaterSched(pControl, data);
+        gCurrentCmd = 0;
+      }
+      break;
+    case CMD_GET_SENSOR_DATA :
+      INFO_PRINT("CMD_GET_SENSOR_DATA\n");
+      INFO_PRINT("Node %u LuxData: {%f} | MoistureData: {%f}\n", node.nodeId, node.data.luxData, node.data.moistureData);
+      if(node.telemetry.received != 0) {
+        INFO_PRINT("Telemetry at %u Hz: %u received, %u lost, %u late, %u duplicate, %u restarts\n",
+                   node.telemetryHz, node.telemetry.received, node.telemetry.lost, node.telemetry.late,
+                   node.telemetry.duplicates, node.telemetry.restarts);
+      }
+      break;
+    case CMD_GET_APP_STATE :
+      INFO_PRINT("CMD_GET_APP_STATE\n");
+      INFO_PRINT("Node %u: %s\n", node.nodeId, (node.ports != 0) ? "connected" : "disconnected");
+
+      /* Print Control Loop State */
+      switch(pControl->state) {
+        case IDLE :
+          INFO_PRINT("ControlLoopState: IDLE\n");
+          break;
+        case WATER_PERIODIC_SCHED :
+          INFO_PRINT("ControlLoopState: WATER_PERIODIC_SCHED\n");
+          break;
+        case WATER_ONESHOT_SCHED:
+          INFO_PRINT("ControlLoopState: WATER_ONESHOT_SCHED\n");
+          break;
+        case WATERING_PLANT:
+          INFO_PRINT("ControlLoopState: WATERING_PLANT\n");
+          break;
+      }
+
+      /* Print System State */
+      switch(pControl->systemState) {
+        case DEGRADED :
+          INFO_PRINT("SystemState: DEGRADED\n");
+          break;
+        case FAULT :
+          INFO_PRINT("SystemState: FAULT\n");
+          break;
+        case NOMINAL :
+          INFO_PRINT("SystemState: NOMINAL\n");
+          break;
+      }
+
+      /* Print Threshold and limit values */
+      INFO_PRINT("Soil Moisture Low Threshold: %f\n", pControl->moistureLow);
+      INFO_PRINT("Soil Moisture High Threshold: %f\n", pControl->moistureHigh);
+      INFO_PRINT("Lux Sensor Sunlight High Threshold: %d\n", LUX_MAX_THRESHOLD);
+      break;
+    case CMD_EN_DEV2 :
+      /* Populate packet and push onto cmdQueue to tx to Remote Node */
+      INFO_PRINT("Cmd to Enable additional device on Remote Node2\n");
+      txCmd = REMOTE_ENDEV2;
+      break;
+    case CMD_DS_DEV2 :
+      INFO_PRINT("Cmd to Disable additional device on Remote Node\n");
+      txCmd = REMOTE_DSDEV2;
+      break;
+    case CMD_SETMOISTURE_LOWTHRES:
+      INFO_PRINT("CMD_SETMOISTURE_LOWTHRES\n");
+      gCurrentCmd = CMD_SETMOISTURE_LOWTHRES;
+      if(data != 0) {
+        /* Validate data received from user */
+        if(data > SOIL_MOISTURE_MAX) {
           gCurrentCmd = 0;
+          ERROR_PRINT("Invalid Low Threshold value for Soil Moisture received - exceeds max.\n"
+                      "Max value: {%d} | Received value: {%d}\n", SOIL_MOISTURE_MAX, data);
         }
-        break;
-      case CMD_SCHED_ONESHOT :
-        INFO_PRINT("CMD_SCHED_ONESHOT\n");
-        gCurrentCmd = CMD_SCHED_ONESHOT;
-        if(data != 0) {
-          setOneshotWaterSched(data);
+        else if(data >= pControl->moistureHigh) {
           gCurrentCmd = 0;
+          ERROR_PRINT("Invalid Low Threshold value for Soil Moisture received - Greater than or equal to high Threshold.\n"
+                      "High value: {%f} | Received value: {%d}\n", pControl->moistureHigh, data);
         }
-        break;
-      case CMD_GET_SENSOR_DATA :
-        INFO_PRINT("CMD_GET_SENSOR_DATA\n");
-        INFO_PRINT("LuxData: {%f} | MoistureData: {%f}\n", luxData, moistureData);
-        break;
-      case CMD_GET_APP_STATE :
-        INFO_PRINT("CMD_GET_APP_STATE\n");
-
-        /* Print Control Loop State */
-        switch(controlLoopState) {
-          case IDLE :
-            INFO_PRINT("ControlLoopState: IDLE\n");
-            break;
-          case WATER_PERIODIC_SCHED :
-            INFO_PRINT("ControlLoopState: WATER_PERIODIC_SCHED\n");
-            break;
-          case WATER_ONESHOT_SCHED:
-            INFO_PRINT("ControlLoopState: WATER_ONESHOT_SCHED\n");
-            break;
-          case WATERING_PLANT:
-            INFO_PRINT("ControlLoopState: WATERING_PLANT\n");
-            break;
+        else {
+          pControl->moistureLow = data;
+          txCmd = REMOTE_SETMOISTURE_LOWTHRES;
         }
+      }
+      break;
+    case CMD_SETMOISTURE_HIGHTHRES:
+      INFO_PRINT("CMD_SETMOISTURE_HIGHTHRES\n");
+      gCurrentCmd = CMD_SETMOISTURE_HIGHTHRES;
 
-        /* Print System State */
-        switch(systemState) {
-          case DEGRADED :
-            INFO_PRINT("SystemState: DEGRADED\n");
-            break;
-          case FAULT :
-            INFO_PRINT("SystemState: FAULT\n");
-            break;
-          case NOMINAL :
-            INFO_PRINT("SystemState: NOMINAL\n");
-            break;
+      if (data != 0) {
+        /* Validate data received from user */
+        if(data > SOIL_MOISTURE_MAX) {
+          gCurrentCmd = 0;
+          ERROR_PRINT("Invalid Low Threshold value for Soil Moisture received.\n"
+                      "Max value: {%d} | Received value: {%d}\n", SOIL_MOISTURE_MAX, data);
+        }
+        else if(data <= pControl->moistureLow) {
+          gCurrentCmd = 0;
+          ERROR_PRINT("Invalid High Threshold value for Soil Moisture received - Less than or equal to low Threshold.\n"
+                      "Low value: {%f} | Received value: {%d}\n", pControl->moistureLow, data);
         }
+        else {
+          pControl->moistureHigh = data;
+          txCmd = REMOTE_SETMOISTURE_HIGHTHRES;
 
-        /* Print Threshold and limit values */
-        INFO_PRINT("Soil Moisture Low Threshold: %f\n", soilMoistureLow);
-        INFO_PRINT("Soil Moisture High Threshold: %f\n", soilMoistureHigh);
-        INFO_PRINT("Lux Sensor Sunlight High Threshold: %d\n", LUX_MAX_THRESHOLD);
-        break;
-      case CMD_EN_DEV2 :
-        /* Populate packet and push onto cmdQueue to tx to Remote Node */
-        INFO_PRINT("Cmd to Enable additional device on Remote Node2\n");
-        txCmd = REMOTE_ENDEV2;
-        break;
-      case CMD_DS_DEV2 :
-        INFO_PRINT("Cmd to Disable additional device on Remote Node\n");
-        txCmd = REMOTE_DSDEV2;
-        break;
-      case CMD_SETMOISTURE_LOWTHRES:
-        INFO_PRINT("CMD_SETMOISTURE_LOWTHRES\n");
-        gCurrentCmd = CMD_SETMOISTURE_LOWTHRES;
-        if(data != 0) {
-          /* Validate data received from user */
-          if(data > SOIL_MOISTURE_MAX) {
-            gCurrentCmd = 0;
-            ERROR_PRINT("Invalid Low Threshold value for Soil Moisture received - exceeds max.\n"
-                        "Max value: {%d} | Received value: {%d}\n", SOIL_MOISTURE_MAX, data);
-          }
-          else if(data >= soilMoistureHigh) {
-            gCurrentCmd = 0;
-            ERROR_PRINT("Invalid Low Threshold value for Soil Moisture received - Greater than or equal to high Threshold.\n"
-                        "High value: {%f} | Received value: {%d}\n", soilMoistureHigh, data);
-          }
-          else {
-            soilMoistureLow = data;
-            txCmd = REMOTE_SETMOISTURE_LOWTHRES;
+          /* main loop turns the LED back when no node is in FAULT */
+          if((pControl->systemState == FAULT) && (pControl->moistureHigh < node.data.moistureData)) {
+            pControl->systemState = NOMINAL;
+            INFO_PRINT("Soil moisture level exceeded set high threshold value - Node %u back to NOMINAL\n", node.nodeId);
+            LOG_MAIN_EVENT(MAIN_EVENT_SYSTEM_NOMINAL_STATE);
           }
         }
-        break;
-      case CMD_SETMOISTURE_HIGHTHRES:
-        INFO_PRINT("CMD_SETMOISTURE_HIGHTHRES\n");
-        gCurrentCmd = CMD_SETMOISTURE_HIGHTHRES;
-
-        if (data != 0) {
-          /* Validate data received from user */
-          if(data > SOIL_MOISTURE_MAX) {
-            gCurrentCmd = 0;
-            ERROR_PRINT("Invalid Low Threshold value for Soil Moisture received.\n"
-                        "Max value: {%d} | Received value: {%d}\n", SOIL_MOISTURE_MAX, data);
-          }
-          else if(data <= soilMoistureLow) {
-            gCurrentCmd = 0;
-            ERROR_PRINT("Invalid High Threshold value for Soil Moisture received - Less than or equal to low Threshold.\n"
-                        "Low value: {%f} | Received value: {%d}\n", soilMoistureLow, data);
-          }
-          else {
-            soilMoistureHigh = data;
-            txCmd = REMOTE_SETMOISTURE_HIGHTHRES;
-            
-            if((systemState == FAULT) && (soilMoistureHigh < moistureData)) {
-              systemState = NOMINAL;
-              setStatusLed(systemState);
-              INFO_PRINT("Soil moisture level exceeded set high threshold value - System state back to NOMINAL\n");
-              LOG_MAIN_EVENT(MAIN_EVENT_SYSTEM_NOMINAL_STATE);
-            }
-          }
+      }
+      break;
+    case CMD_SET_TELEMETRY_HZ :
+      INFO_PRINT("CMD_SET_TELEMETRY_HZ\n");
+      gCurrentCmd = CMD_SET_TELEMETRY_HZ;
+      if(data != 0) {
+        if(data > REMOTE_TELEMETRY_MAX_HZ) {
+          gCurrentCmd = 0;
+          ERROR_PRINT("Invalid telemetry rate received - exceeds max.\n"
+                      "Max value: {%d} | Received value: {%d}\n", REMOTE_TELEMETRY_MAX_HZ, data);
         }
-        break;
-      case CMD_SCHED_CANCEL :
-        INFO_PRINT("CMD_SCHED_CANCEL\n");
-        cancelWaterSched();
-        break;
-      default:
-        ERROR_PRINT("Unrecognized command received. Request ignored.\n");
-      return EXIT_FAILURE;
-    }
+        else {
+          txCmd = REMOTE_SET_TELEMETRY_HZ;
+        }
+      }
+      break;
+    case CMD_SCHED_CANCEL :
+      INFO_PRINT("CMD_SCHED_CANCEL\n");
+      cancelWaterSched(pControl);
+      break;
+    case CMD_LOG_FILTER :
+      INFO_PRINT("CMD_LOG_FILTER\n");
+      gCurrentCmd = CMD_LOG_FILTER;
+      if(data != 0) {
+        setLogFilter(data);
+        gCurrentCmd = 0;
+      }
+      log_filter_print();
+      return EXIT_SUCCESS;
+    case CMD_HEALTH_STATS :
+      INFO_PRINT("CMD_HEALTH_STATS\n");
+      healthMonitorPrintStats();
+      return EXIT_SUCCESS;
+    case CMD_SELECT_NODE :
+      INFO_PRINT("CMD_SELECT_NODE\n");
+      gCurrentCmd = CMD_SELECT_NODE;
+      if(data == 0) {
+        printNodes();
+      }
+      else {
+        gCurrentCmd = 0;
+        if(node_table_get((uint16_t)data, &node) == EXIT_SUCCESS) {
+          gSelectedNode = (uint16_t)data;
+          INFO_PRINT("Commands now go to node %u\n", gSelectedNode);
+        }
+        else {
+          ERROR_PRINT("Remote node {%d} has never connected - selection unchanged\n", data);
+        }
+      }
+      return EXIT_SUCCESS;
+    default:
+      ERROR_PRINT("Unrecognized command received. Request ignored.\n");
+    return EXIT_FAILURE;
   }
 
+  /* Schedule and threshold changes; main is the only writer of control state */
+  node_table_set_control(node.nodeId, pControl);
+
   /* If cmd received needs to be transmitted to the TIVA, populate packet and send */
   if(txCmd != REMOTE_CMD_END) {
     RemoteCmdPacket cmdPacket = {0};
+    cmdPacket.header = node.nodeId;
     cmdPacket.cmd = txCmd;
     cmdPacket.data = data;
 
@@ -653,7 +825,7 @@ int readInputNonBlock()
 }
 
 /*---------------------------------------------------------------------------------*/
-void setPeriodicWaterSched(uint32_t hours) {
+void setPeriodicWaterSched(NodeControl_t *pControl, uint32_t hours) {
   /* Validate input watering schedule */
   if(hours < 8) {
     ERROR_PRINT("Periodic watering cycle must have a minimum interval of 8 hours - "
@@ -661,83 +833,68 @@ void setPeriodicWaterSched(uint32_t hours) {
     return;
   }
 
-  struct itimerspec timeSpec;
-  timeSpec.it_value.tv_sec = hours*HOUR_TO_SEC;
-  timeSpec.it_value.tv_nsec = 0;
-  timeSpec.it_interval.tv_sec = hours*HOUR_TO_SEC;
-  timeSpec.it_interval.tv_nsec = 0;
-
-  timer_settime(waterTimerid, 0, &timeSpec, NULL);
-  waterCyclePeriodHours = hours;
+  pControl->waterPeriodSec = hours*HOUR_TO_SEC;
+  pControl->nextWaterSec = secNow() + pControl->waterPeriodSec;
   
   /* Update controlLoopState if not currently watering plant */
-  if(controlLoopState != WATERING_PLANT)
+  if(pControl->state != WATERING_PLANT)
   {
-    controlLoopState = WATER_PERIODIC_SCHED;
+    pControl->state = WATER_PERIODIC_SCHED;
     LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_SCHEDPERIODIC_STATE);
   }
 }
 
 /*---------------------------------------------------------------------------------*/
-void setOneshotWaterSched(uint32_t hours) {
-  struct itimerspec timeSpec;
-  timeSpec.it_value.tv_sec = hours*HOUR_TO_SEC;
-  timeSpec.it_value.tv_nsec = 0;
-  timeSpec.it_interval.tv_sec = 0;
-  timeSpec.it_interval.tv_nsec = 0;
-
-  timer_settime(waterTimerid, 0, &timeSpec, NULL);
+void setOneshotWaterSched(NodeControl_t *pControl, uint32_t hours) {
+  pControl->waterPeriodSec = 0;
+  pControl->nextWaterSec = secNow() + (hours*HOUR_TO_SEC);
 
   /* Update controlLoopState if not currently watering plant */
-  if(controlLoopState != WATERING_PLANT)
+  if(pControl->state != WATERING_PLANT)
   {
-    controlLoopState = WATER_ONESHOT_SCHED;
+    pControl->state = WATER_ONESHOT_SCHED;
     LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_SCHEDONESHOT_STATE);
   }
 }
 
 /*---------------------------------------------------------------------------------*/
-void cancelWaterSched() {
-  struct itimerspec timeSpec;
-  timeSpec.it_value.tv_sec = 0;
-  timeSpec.it_value.tv_nsec = 0;
-  timeSpec.it_interval.tv_sec = 0;
-  timeSpec.it_interval.tv_nsec = 0;
-
-  timer_settime(waterTimerid, 0, &timeSpec, NULL);
+void cancelWaterSched(NodeControl_t *pControl) {
+  pControl->waterPeriodSec = 0;
+  pControl->nextWaterSec = 0;
 
   /* Update controlLoopState if not currently watering plant */
-  if(controlLoopState != WATERING_PLANT)
+  if(pControl->state != WATERING_PLANT)
   {
-    controlLoopState = IDLE;
+    pControl->state = IDLE;
     LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_IDLE_STATE);
   }
 }
 
 /*---------------------------------------------------------------------------------*/
-static void waterDeviceTx() {
+static void waterDeviceTx(RemoteNode_t *pNode) {
+  NodeControl_t *pControl = &pNode->control;
   bool waterPlant = true;
 
   /* If soil moisture exceeds threshold, ignore request */
-  if(moistureData > soilMoistureHigh)
+  if(pNode->data.moistureData > pControl->moistureHigh)
   {
-    INFO_PRINT("Current Soil Moisture exceeds high threshold - Water plant cmd ignored\n");
+    INFO_PRINT("Node %u Soil Moisture exceeds high threshold - Water plant cmd ignored\n", pNode->nodeId);
     waterPlant = false;
   }
 
   /* If soil Moisture between Low & High threshold with peaking sunlight exposure, ignore request */ 
-  if((moistureData > soilMoistureLow) && (luxData > LUX_MAX_THRESHOLD))
+  if((pNode->data.moistureData > pControl->moistureLow) && (pNode->data.luxData > LUX_MAX_THRESHOLD))
   {
-    INFO_PRINT("Avoiding watering during high sunlight exposure with soil moisture nominal - Water plant cmd ignored\n");
+    INFO_PRINT("Node %u avoiding watering during high sunlight exposure with soil moisture nominal - Water plant cmd ignored\n", pNode->nodeId);
     waterPlant = false;
   }
 
   if(waterPlant == false) {
     /* Didn't successfully water plant - return to nominal state */
-    if(controlLoopState == WATER_ONESHOT_SCHED)
+    if(pControl->state == WATER_ONESHOT_SCHED)
     {
       INFO_PRINT("WATER_ONESHOT_SCHED failed to send water plant cmd - Control loop reset to IDLE\n");
-      controlLoopState = IDLE;
+      pControl->state = IDLE;
       LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_IDLE_STATE);
     }
 
@@ -745,12 +902,194 @@ static void waterDeviceTx() {
   }
 
   RemoteCmdPacket cmdPacket = {0};
+  cmdPacket.header = pNode->nodeId;
   cmdPacket.cmd = REMOTE_WATERPLANT;
   mq_send(cmdMsgQueue, (char *)&cmdPacket, sizeof(struct RemoteCmdPacket), 1);
-  controlLoopState = WATERING_PLANT;
-  checkingSoilMoisture = true;
-  soilWateringCount = 0;
+  pControl->state = WATERING_PLANT;
+  pControl->checkingMoisture = true;
+  pControl->wateringCount = 0;
 
   LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_WATERINGPLANT_STATE);
-  INFO_PRINT("Watering Plant Enabled!\n");
+  INFO_PRINT("Watering Plant Enabled on node %u!\n", pNode->nodeId);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief one main loop of a node's control loop: water when its schedule is
+ * due, and while watering, check soil moisture until it reaches the high
+ * threshold or too many loops have passed
+ *
+ * @param pNode copy of the node's entry; control state is updated in it
+ */
+static void controlNode(RemoteNode_t *pNode) {
+  NodeControl_t *pControl = &pNode->control;
+  uint64_t now = secNow();
+
+  /* Scheduled watering due */
+  if((pControl->nextWaterSec != 0) && (now >= pControl->nextWaterSec)) {
+    pControl->nextWaterSec = (pControl->waterPeriodSec != 0) ? (now + pControl->waterPeriodSec) : 0;
+    waterDeviceTx(pNode);
+  }
+
+  /* Based on current operating state, handle data returned from TIVA */
+  /* If soil moisture exceed saturation level, reset timer of next water cycle */
+  switch(pControl->state) {
+    case WATER_PERIODIC_SCHED:
+      /* Waiting until next periodic watering cycle */
+      break;
+    case WATER_ONESHOT_SCHED:
+      /* Waiting until next one-shot watering cycle */
+      break;
+    case WATERING_PLANT:
+      /* Plant should be getting watered - remain in watering state until soil moisture exceeds threshold */
+      if(pNode->data.moistureData < pControl->moistureHigh)
+      {
+        /* Continue watering plant */
+        /* Track number of times we've check soil moisture levels. If Count exceeds threshold, enter FAULT state */
+        pControl->wateringCount++;
+        if(pControl->checkingMoisture && (pControl->wateringCount > SOIL_MAX_WATER_CHECK_COUNT)) {
+          ERROR_PRINT("Node %u soil watering exceeded max count - entering FAULT state | Control Loop set to IDLE state\n", pNode->nodeId);
+          pControl->state = IDLE;
+          pControl->systemState = FAULT;
+          LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_IDLE_STATE);
+          LOG_MAIN_EVENT(MAIN_EVENT_SYSTEM_FAULT_STATE);
+        }
+      } 
+      else {
+        INFO_PRINT("Node %u soil moisture level reported above threshold - Soil watering complete!\n", pNode->nodeId);
+        /* Watering complete, update current state; if nothing scheduled, IDLE */
+        if(pControl->nextWaterSec == 0)
+        {
+          pControl->state = IDLE;
+          LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_IDLE_STATE);
+        }
+        else {
+          pControl->state = WATER_PERIODIC_SCHED;
+          LOG_MAIN_EVENT(MAIN_EVENT_CONTROLLOOP_SCHEDPERIODIC_STATE);
+        }
+
+        /* If successfully watered and in FAULT state, reenter NOMINAL state */
+        if(pControl->systemState == FAULT) {
+          INFO_PRINT("Soil watering successful! - Node %u back to NOMINAL\n", pNode->nodeId);
+          pControl->systemState = NOMINAL;
+          LOG_MAIN_EVENT(MAIN_EVENT_SYSTEM_NOMINAL_STATE);
+        }
+        pControl->checkingMoisture = false;
+        pControl->wateringCount = 0;
+      }
+      break;
+    case IDLE:
+    default:
+      /* Awaiting control loop state change */
+      break;
+  }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief entry of the node console cmds go to; the lowest ID if none has
+ * been selected yet (or only one node has ever connected)
+ *
+ * @param pNode copy of the node's entry
+ * @return int8_t EXIT_FAILURE if no node has connected
+ */
+static int8_t selectNode(RemoteNode_t *pNode) {
+  uint16_t nodeId;
+
+  if(node_table_get(gSelectedNode, pNode) == EXIT_SUCCESS)
+    return EXIT_SUCCESS;
+  if(node_table_list(&nodeId, 1) == 0)
+    return EXIT_FAILURE;
+  gSelectedNode = nodeId;
+  return node_table_get(gSelectedNode, pNode);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printNodes(void) {
+  uint16_t nodeIds[NODE_TABLE_MAX_NODES];
+  uint16_t numNodes, ind;
+  RemoteNode_t node;
+
+  numNodes = node_table_list(nodeIds, NODE_TABLE_MAX_NODES);
+  INFO_PRINT("%u remote nodes:\n", numNodes);
+  for(ind = 0; ind < numNodes; ++ind)
+  {
+    if(node_table_get(nodeIds[ind], &node) != EXIT_SUCCESS)
+      continue;
+    INFO_PRINT("%c node %5u  %-12s  lux %8.2f  moisture %6.2f  state %d%s\n",
+               (node.nodeId == gSelectedNode) ? '*' : ' ', node.nodeId,
+               (node.ports != 0) ? "connected" : "disconnected", node.data.luxData, node.data.moistureData,
+               node.control.state, (node.control.systemState == FAULT) ? " FAULT" : "");
+  }
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t secNow(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief apply a log filter change entered on the console
+ *
+ * @param code action * LOG_FILTER_CODE_BASE + msg, process or level
+ */
+static void setLogFilter(uint32_t code) {
+  uint32_t arg = code % LOG_FILTER_CODE_BASE;
+  uint8_t ret;
+
+  switch(code / LOG_FILTER_CODE_BASE) {
+    case 1:
+      ret = log_filter_set_level((LogLevel_e)arg);
+      break;
+    case 2:
+    case 3:
+      ret = log_filter_set_msg((logMsg_e)arg, (code / LOG_FILTER_CODE_BASE) == 3);
+      break;
+    case 4:
+    case 5:
+      ret = log_filter_set_process((ProcessId_e)arg, (code / LOG_FILTER_CODE_BASE) == 5);
+      break;
+    case 9:
+      log_filter_reset();
+      ret = LOG_STATUS_OK;
+      break;
+    default:
+      ret = LOG_STATUS_NOTOK;
+      break;
+  }
+
+  if(ret != LOG_STATUS_OK) {
+    ERROR_PRINT("Invalid log filter value received {%d} - ignoring\n", code);
+  }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief publish control loop state, sensor values and queue depths for the
+ * health snapshot socket; never blocks on its readers
+ *
+ * @param pQueues queues to report, indexed by SnapshotQueue_e
+ */
+static void publishSnapshot(mqd_t *pQueues) {
+  HealthSnapshot_t snap;
+  RemoteNode_t node;
+  struct mq_attr attr;
+  uint8_t ind;
+
+  /* selected node's control loop and data, the system's state */
+  memset(&snap, 0, sizeof(HealthSnapshot_t));
+  memset(&node, 0, sizeof(RemoteNode_t));
+  selectNode(&node);
+  snap.controlLoopState = (uint8_t)node.control.state;
+  snap.systemState = (uint8_t)systemState;
+  snap.luxData = node.data.luxData;
+  snap.moistureData = node.data.moistureData;
+  for(ind = 0; ind < SNAPSHOT_QUEUE_END; ++ind) {
+    snap.queueDepth[ind] = (mq_getattr(pQueues[ind], &attr) == 0) ? (int32_t)attr.mq_curmsgs : -1;
+  }
+  health_snapshot_publish(&snap);
 }
@@ -0,0 +1,190 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 13, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file nodeTable.c
+ * @brief remote nodes known to the control node, keyed by node ID
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "nodeTable.h"
+
+#define NODE_HASH_MULT          (40503U)    /* Fibonacci hashing for 16 bit keys */
+
+/* open addressing, linear probing; nodes are never removed */
+static RemoteNode_t nodes[NODE_TABLE_MAX_NODES];
+static pthread_mutex_t tableLock = PTHREAD_MUTEX_INITIALIZER;
+
+static RemoteNode_t *findNode(uint16_t nodeId, uint8_t add);
+
+/*---------------------------------------------------------------------------------*/
+void node_table_init(void)
+{
+    pthread_mutex_lock(&tableLock);
+    memset(nodes, 0, sizeof(nodes));
+    pthread_mutex_unlock(&tableLock);
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t node_table_connect(uint16_t nodeId, uint8_t portMask)
+{
+    RemoteNode_t *pNode;
+
+    if((nodeId == NODE_ID_NONE) || (nodeId == REMOTE_NODE_ALL))
+        return EXIT_FAILURE;
+
+    pthread_mutex_lock(&tableLock);
+    pNode = findNode(nodeId, 1);
+    if(pNode != NULL)
+        pNode->ports |= portMask;
+    pthread_mutex_unlock(&tableLock);
+    return (pNode != NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+void node_table_disconnect(uint16_t nodeId, uint8_t portMask)
+{
+    RemoteNode_t *pNode;
+
+    pthread_mutex_lock(&tableLock);
+    pNode = findNode(nodeId, 0);
+    if(pNode != NULL)
+        pNode->ports &= (uint8_t)~portMask;
+    pthread_mutex_unlock(&tableLock);
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t node_table_data(uint16_t nodeId, const RemoteDataPacket *pData)
+{
+    RemoteNode_t *pNode;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    pthread_mutex_lock(&tableLock);
+    pNode = findNode(nodeId, 0);
+    if(pNode != NULL) {
+        pNode->data = *pData;
+        pNode->dataUsec = ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+        ++pNode->dataCount;
+    }
+    pthread_mutex_unlock(&tableLock);
+    return (pNode != NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t node_table_telemetry(const RemoteTelemetryPacket *pPacket, TelemetrySeq_e *pResult)
+{
+    RemoteNode_t *pNode;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    pthread_mutex_lock(&tableLock);
+    pNode = findNode(pPacket->nodeId, 0);
+    if(pNode != NULL) {
+        *pResult = telemetry_seq_update(&pNode->telemetry, pPacket->seq);
+        if(*pResult == TELEMETRY_SEQ_NEW) {
+            pNode->data = pPacket->data;
+            pNode->dataUsec = ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+            pNode->telemetryHz = pPacket->rateHz;
+            ++pNode->dataCount;
+        }
+    }
+    pthread_mutex_unlock(&tableLock);
+    return (pNode != NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t node_table_get(uint16_t nodeId, RemoteNode_t *pNode)
+{
+    RemoteNode_t *pFound;
+
+    pthread_mutex_lock(&tableLock);
+    pFound = findNode(nodeId, 0);
+    if(pFound != NULL)
+        *pNode = *pFound;
+    pthread_mutex_unlock(&tableLock);
+    return (pFound != NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t node_table_set_control(uint16_t nodeId, const NodeControl_t *pControl)
+{
+    RemoteNode_t *pNode;
+
+    pthread_mutex_lock(&tableLock);
+    pNode = findNode(nodeId, 0);
+    if(pNode != NULL)
+        pNode->control = *pControl;
+    pthread_mutex_unlock(&tableLock);
+    return (pNode != NULL) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint16_t node_table_list(uint16_t *pIds, uint16_t max)
+{
+    uint16_t ind, pos, count = 0;
+
+    pthread_mutex_lock(&tableLock);
+    for(ind = 0; ind < NODE_TABLE_MAX_NODES; ++ind)
+    {
+        if(nodes[ind].nodeId == NODE_ID_NONE)
+            continue;
+
+        /* insertion sort, keeping the lowest max IDs */
+        pos = (count < max) ? count++ : max;
+        while((pos > 0) && (pIds[pos - 1] > nodes[ind].nodeId))
+        {
+            if(pos < max)
+                pIds[pos] = pIds[pos - 1];
+            --pos;
+        }
+        if(pos < max)
+            pIds[pos] = nodes[ind].nodeId;
+    }
+    pthread_mutex_unlock(&tableLock);
+    return count;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief slot of a node, claiming an empty one if add and it isn't there;
+ * call with tableLock held
+ */
+static RemoteNode_t *findNode(uint16_t nodeId, uint8_t add)
+{
+    uint32_t ind, slot;
+
+    slot = ((uint32_t)nodeId * NODE_HASH_MULT) & (NODE_TABLE_MAX_NODES - 1);
+    for(ind = 0; ind < NODE_TABLE_MAX_NODES; ++ind)
+    {
+        if(nodes[slot].nodeId == nodeId)
+            return &nodes[slot];
+        if(nodes[slot].nodeId == NODE_ID_NONE) {
+            if(!add)
+                return NULL;
+            memset(&nodes[slot], 0, sizeof(RemoteNode_t));
+            nodes[slot].nodeId = nodeId;
+            nodes[slot].control.state = IDLE;
+            nodes[slot].control.systemState = NOMINAL;
+            nodes[slot].control.moistureLow = SOIL_SATURATION_LOW_THRES;
+            nodes[slot].control.moistureHigh = SOIL_SATURATION_HIGH_THRES;
+            return &nodes[slot];
+        }
+        slot = (slot + 1) & (NODE_TABLE_MAX_NODES - 1);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
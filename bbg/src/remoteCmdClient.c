@@ -26,8 +26,10 @@
 
 #include "remoteThread.h"
 #include "packet.h"
+#include "remoteFrame.h"
 
 #define DEFAULT_SERV_ADDR "192.168.1.27"
+#define DEFAULT_NODE_ID (1)
 #define BUFFER_SIZE (3)
 
 /* Prototypes for private/helper functions */
@@ -35,11 +37,18 @@ void appUsage();
 static void getCmdResponse(RemoteCmdPacket *packet);
 
 /* Define static and global variables */
+static FrameReader_t reader;
+static uint32_t readerBuf[FRAME_READER_SIZE / sizeof(uint32_t)];
 
 /*---------------------------------------------------------------------------------*/
 int main(int argc, char *argv[])
 {
   RemoteCmdPacket cmdPacket = {0};
+  RemoteHelloPacket hello = {REMOTE_HELLO_HEADER, DEFAULT_NODE_ID};
+  FrameHeader_t hdr;
+  uint8_t *pRx, *pPayload;
+  uint32_t space;
+  ssize_t len;
   int sockfd;
   struct sockaddr_in servAddr;
   char *ipAddress = DEFAULT_SERV_ADDR;
@@ -48,6 +57,10 @@ int main(int argc, char *argv[])
   if(argc >= 2) {
     ipAddress = argv[1];
   }
+  /* node ID to connect as, cmds for it are sent here */
+  if(argc >= 3) {
+    hello.nodeId = (uint16_t)atoi(argv[2]);
+  }
 
   /** Establish connection on remote socket **/
   /* Open Socket - verify ID is valid */
@@ -70,16 +83,35 @@ int main(int argc, char *argv[])
     return -1;
   }
 
+  /* name this node before anything else */
+  frame_header(&hdr, FRAME_TYPE_HELLO, &hello, sizeof(hello));
+  if((send(sockfd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) || (send(sockfd, &hello, sizeof(hello), 0) != sizeof(hello))) {
+    printf("ERROR: remoteClient Application failed to send hello - exiting.\n");
+    return -1;
+  }
+
   /* Log SensorThread successfully created */
-  printf("Successfully connected remoteDataClient on port %d.\n", CMD_PORT);
+  printf("Successfully connected remoteDataClient on port %d as node %u.\n", CMD_PORT, hello.nodeId);
 
   /* Display usage info and wait for user input */
   appUsage();
 
+  frame_reader_init(&reader, (uint8_t *)readerBuf);
   while(1) {
     /* Receive response from server app and print data */
-    recv(sockfd, &cmdPacket, sizeof(struct RemoteCmdPacket), 0);
-    getCmdResponse(&cmdPacket);
+    pRx = frame_reader_space(&reader, &space);
+    len = recv(sockfd, pRx, space, 0);
+    if(len <= 0) {
+      printf("Connection closed by server - exiting.\n");
+      break;
+    }
+    frame_reader_commit(&reader, (uint32_t)len);
+    while(frame_reader_next(&reader, &hdr, &pPayload)) {
+      if((hdr.type == FRAME_TYPE_CMD) && (hdr.length == sizeof(struct RemoteCmdPacket))) {
+        memcpy(&cmdPacket, pPayload, sizeof(struct RemoteCmdPacket));
+        getCmdResponse(&cmdPacket);
+      }
+    }
   }
 
   /* Cleanup */
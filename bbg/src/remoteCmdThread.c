@@ -36,6 +36,8 @@
 #include "platform.h"
 #include "healthMonitor.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_REMOTE_CMD_THREAD);
+
 #define MAX_CLIENTS (5)
 
 /* Prototypes for private/helper functions */
@@ -55,12 +57,14 @@ void* remoteCmdThreadHandler(void* threadInfo)
   }
 
   sensorInfo = *(SensorThreadInfo *)threadInfo;
+  aliveFlag = 1; /* cleared by a previous kill if the supervisor restarted this thread */
   RemoteCmdPacket cmdPacket = {0};
   mqd_t logMsgQueue; /* logger MessageQueue */
   mqd_t hbMsgQueue;  /* main heartbeat MessageQueue */
   mqd_t cmdMsgQueue;  /* Cmd MessageQueue */
   struct mq_attr mqAttr;
-  int sockfdCmdServer, sockfdCmdClient, socketCmdFlags;
+  int sockfdCmdServer, sockfdCmdClient = -1, socketCmdFlags;
+  int reuseAddr = 1;
   struct sockaddr_in servAddr, cliAddr;
   unsigned int cliLen = sizeof(cliAddr);
   size_t cmdPacketSize = sizeof(struct RemoteCmdPacket);
@@ -130,6 +134,9 @@ void* remoteCmdThreadHandler(void* threadInfo)
   timeout.tv_usec = REMOTE_CLIENT_TIMEOUT_USEC;
   timeout.tv_sec = 0;
 
+  /* Allow a restarted thread to bind while the old connection is in TIME_WAIT */
+  setsockopt(sockfdCmdServer, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
   /* Set properties and bind socket */
   servAddr.sin_family = AF_INET;
   servAddr.sin_addr.s_addr = INADDR_ANY;
@@ -233,15 +240,12 @@ void* remoteCmdThreadHandler(void* threadInfo)
   mq_close(logMsgQueue);
   mq_close(hbMsgQueue);
   mq_close(cmdMsgQueue);
-  shutdown(sockfdCmdClient, SHUT_RDWR);
-  shutdown(sockfdCmdServer, SHUT_RDWR);
-  sleep(1);
-  uint8_t closeCnt = 0;
-  while(closeCnt++ < 8) {
+  if(sockfdCmdClient >= 0) {
+    shutdown(sockfdCmdClient, SHUT_RDWR);
     close(sockfdCmdClient);
-    close(sockfdCmdServer);
-    usleep(100000);
   }
+  shutdown(sockfdCmdServer, SHUT_RDWR);
+  close(sockfdCmdServer);
 
   return NULL;
 }
@@ -26,8 +26,10 @@
 
 #include "remoteThread.h"
 #include "packet.h"
+#include "remoteFrame.h"
 
 #define DEFAULT_SERV_ADDR "192.168.1.27"
+#define DEFAULT_NODE_ID (1)
 #define BUFFER_SIZE (3)
 
 /* Prototypes for private/helper functions */
@@ -40,6 +42,8 @@ static void getCmdResponse(RemoteDataPacket *packet);
 int main(int argc, char *argv[])
 {
   RemoteDataPacket dataPacket = {0};
+  RemoteHelloPacket hello = {REMOTE_HELLO_HEADER, DEFAULT_NODE_ID};
+  FrameHeader_t hdr;
   int sockfd;
   struct sockaddr_in servAddr;
   int inputCmd = 0;
@@ -50,6 +54,10 @@ int main(int argc, char *argv[])
   if(argc >= 2) {
     ipAddress = argv[1];
   }
+  /* node ID to connect as, so several clients can run */
+  if(argc >= 3) {
+    hello.nodeId = (uint16_t)atoi(argv[2]);
+  }
 
   /** Establish connection on remote socket **/
   /* Open Socket - verify ID is valid */
@@ -72,8 +80,15 @@ int main(int argc, char *argv[])
     return -1;
   }
 
+  /* name this node before anything else */
+  frame_header(&hdr, FRAME_TYPE_HELLO, &hello, sizeof(hello));
+  if((send(sockfd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) || (send(sockfd, &hello, sizeof(hello), 0) != sizeof(hello))) {
+    printf("ERROR: remoteClient Application failed to send hello - exiting.\n");
+    return -1;
+  }
+
   /* Log SensorThread successfully created */
-  printf("Successfully connected remoteDataClient on port %d.\n", DATA_PORT);
+  printf("Successfully connected remoteDataClient on port %d as node %u.\n", DATA_PORT, hello.nodeId);
 
   while(1) {
     /* Display usage info and wait for user input */
@@ -101,6 +116,8 @@ int main(int argc, char *argv[])
       }
 
       /* Transmit received cmd to server app */
+      frame_header(&hdr, FRAME_TYPE_DATA, &dataPacket, sizeof(struct RemoteDataPacket));
+      send(sockfd, &hdr, sizeof(hdr), 0);
       send(sockfd, &dataPacket, sizeof(struct RemoteDataPacket), 0);
       printf("Data Packet Tx.\n");
 
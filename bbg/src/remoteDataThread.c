@@ -36,6 +36,8 @@
 #include "platform.h"
 #include "healthMonitor.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_REMOTE_DATA_THREAD);
+
 #define MAX_CLIENTS (5)
 
 /* Prototypes for private/helper functions */
@@ -55,12 +57,14 @@ void* remoteDataThreadHandler(void* threadInfo)
   }
 
   sensorInfo = *(SensorThreadInfo *)threadInfo;
+  aliveFlag = 1; /* cleared by a previous kill if the supervisor restarted this thread */
   RemoteDataPacket dataPacket = {0};
   mqd_t logMsgQueue; /* logger MessageQueue */
   mqd_t hbMsgQueue;  /* main heartbeat MessageQueue */
   mqd_t dataMsgQueue;  /* Data MessageQueue */
   struct mq_attr mqAttr;
-  int sockfdDataServer, sockfdDataClient, socketDataFlags;
+  int sockfdDataServer, sockfdDataClient = -1, socketDataFlags;
+  int reuseAddr = 1;
   struct sockaddr_in servAddr, cliAddr;
   unsigned int cliLen = sizeof(cliAddr);
   size_t dataPacketSize = sizeof(struct RemoteDataPacket);
@@ -130,6 +134,9 @@ void* remoteDataThreadHandler(void* threadInfo)
   timeout.tv_usec = REMOTE_CLIENT_TIMEOUT_USEC;
   timeout.tv_sec = 0;
 
+  /* Allow a restarted thread to bind while the old connection is in TIME_WAIT */
+  setsockopt(sockfdDataServer, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
   /* Set properties and bind socket */
   servAddr.sin_family = AF_INET;
   servAddr.sin_addr.s_addr = INADDR_ANY;
@@ -230,15 +237,12 @@ void* remoteDataThreadHandler(void* threadInfo)
   mq_close(logMsgQueue);
   mq_close(hbMsgQueue);
   mq_close(dataMsgQueue);
-  shutdown(sockfdDataClient, SHUT_RDWR);
-  shutdown(sockfdDataServer, SHUT_RDWR);
-  sleep(1);
-  uint8_t closeCnt = 0;
-  while(closeCnt++ < 8) {
+  if(sockfdDataClient >= 0) {
+    shutdown(sockfdDataClient, SHUT_RDWR);
     close(sockfdDataClient);
-    close(sockfdDataServer);
-    usleep(100000);
   }
+  shutdown(sockfdDataServer, SHUT_RDWR);
+  close(sockfdDataServer);
 
   return NULL;
 }
@@ -0,0 +1,221 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 14, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file remoteFrame.c
+ * @brief frames for the TCP links between the remote and control nodes
+ *
+ ************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "remoteFrame.h"
+#include "crc.h"
+
+/* the payload follows the header 4 byte aligned, as do a batch's records;
+ * not _Static_assert, the TIVA builds this too */
+typedef char frame_header_aligned[((sizeof(FrameHeader_t) % 4) == 0) ? 1 : -1];
+typedef char frame_record_aligned[((sizeof(FrameRecord_t) % 4) == 0) ? 1 : -1];
+typedef char frame_batch_contiguous[(offsetof(FrameBatch_t, payload) == sizeof(FrameHeader_t)) ? 1 : -1];
+typedef char frame_reader_words[((FRAME_READER_SIZE % 4) == 0) ? 1 : -1];    /* uint32_t buffers will do */
+
+static uint32_t frameCrc(const FrameHeader_t *pHdr, const void *pPayload);
+
+/*---------------------------------------------------------------------------------*/
+void frame_header(FrameHeader_t *pHdr, FrameType_e type, const void *pPayload, uint32_t len)
+{
+    pHdr->magic = FRAME_MAGIC;
+    pHdr->version = FRAME_VERSION;
+    pHdr->type = (uint8_t)type;
+    pHdr->length = len;
+    pHdr->crc = frameCrc(pHdr, pPayload);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t frame_check(const uint8_t *pFrame, uint32_t len, FrameHeader_t *pHdr)
+{
+    if(len < sizeof(FrameHeader_t))
+        return 0;
+    memcpy(pHdr, pFrame, sizeof(FrameHeader_t));
+    return (pHdr->magic == FRAME_MAGIC) && (pHdr->version == FRAME_VERSION) &&
+           (pHdr->type != 0) && (pHdr->type < FRAME_TYPE_END) &&
+           (pHdr->length == (len - sizeof(FrameHeader_t))) && (pHdr->length <= FRAME_MAX_PAYLOAD) &&
+           (frameCrc(pHdr, &pFrame[sizeof(FrameHeader_t)]) == pHdr->crc);
+}
+
+/*---------------------------------------------------------------------------------*/
+void frame_reader_init(FrameReader_t *pRd, uint8_t *pBuf)
+{
+    pRd->pBuf = pBuf;
+    pRd->start = 0;
+    pRd->end = 0;
+    pRd->skipped = 0;
+    pRd->crcErrors = 0;
+    pRd->moved = 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t frame_reader_compacts(const FrameReader_t *pRd)
+{
+    return (pRd->start != 0) && ((FRAME_READER_SIZE - pRd->end) < FRAME_MAX_SIZE);
+}
+
+/*---------------------------------------------------------------------------------*/
+void frame_reader_move(FrameReader_t *pRd, uint8_t *pBuf)
+{
+    memcpy(pBuf, &pRd->pBuf[pRd->start], pRd->end - pRd->start);
+    pRd->moved += pRd->end - pRd->start;
+    pRd->end -= pRd->start;
+    pRd->start = 0;
+    pRd->pBuf = pBuf;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t *frame_reader_space(FrameReader_t *pRd, uint32_t *pFree)
+{
+    /* only a partial frame is left once frame_reader_next() returns 0, and
+     * the buffer holds two whole ones; move it down to make room */
+    if(frame_reader_compacts(pRd)) {
+        memmove(pRd->pBuf, &pRd->pBuf[pRd->start], pRd->end - pRd->start);
+        pRd->moved += pRd->end - pRd->start;
+        pRd->end -= pRd->start;
+        pRd->start = 0;
+    }
+    *pFree = FRAME_READER_SIZE - pRd->end;
+    return &pRd->pBuf[pRd->end];
+}
+
+/*---------------------------------------------------------------------------------*/
+void frame_reader_commit(FrameReader_t *pRd, uint32_t len)
+{
+    pRd->end += len;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t frame_reader_next(FrameReader_t *pRd, FrameHeader_t *pHdr, uint8_t **ppPayload)
+{
+    uint8_t *pStart;
+
+    while((pRd->end - pRd->start) >= sizeof(FrameHeader_t))
+    {
+        pStart = &pRd->pBuf[pRd->start];
+        memcpy(pHdr, pStart, sizeof(FrameHeader_t));
+
+        /* not the start of a frame, or one we can't take; try the next byte */
+        if((pHdr->magic != FRAME_MAGIC) || (pHdr->version != FRAME_VERSION) ||
+           (pHdr->type == 0) || (pHdr->type >= FRAME_TYPE_END) || (pHdr->length > FRAME_MAX_PAYLOAD)) {
+            ++pRd->start;
+            ++pRd->skipped;
+            continue;
+        }
+        if((pRd->end - pRd->start) < (sizeof(FrameHeader_t) + pHdr->length))
+            return 0;
+        if(frameCrc(pHdr, &pStart[sizeof(FrameHeader_t)]) != pHdr->crc) {
+            ++pRd->start;
+            ++pRd->skipped;
+            ++pRd->crcErrors;
+            continue;
+        }
+
+        /* frames follow each other aligned unless bytes were skipped; move
+         * down over those, frames returned before them stay put */
+        if((pRd->start % 4) != 0) {
+            memmove(&pRd->pBuf[pRd->start & ~3u], pStart, pRd->end - pRd->start);
+            pRd->moved += pRd->end - pRd->start;
+            pRd->end -= pRd->start % 4;
+            pRd->start &= ~3u;
+        }
+        *ppPayload = &pRd->pBuf[pRd->start + sizeof(FrameHeader_t)];
+        pRd->start += sizeof(FrameHeader_t) + pHdr->length;
+        return 1;
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+void frame_batch_init(FrameBatch_t *pBatch)
+{
+    pBatch->hdr.length = 0;
+    pBatch->records = 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t frame_batch_free(const FrameBatch_t *pBatch)
+{
+    return FRAME_MAX_PAYLOAD - pBatch->hdr.length;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t frame_batch_add(FrameBatch_t *pBatch, FrameType_e type, const void *pPacket, uint32_t len)
+{
+    FrameRecord_t rec;
+    uint8_t *pRec = &pBatch->payload[pBatch->hdr.length];
+
+    if(FRAME_RECORD_SIZE(len) > frame_batch_free(pBatch))
+        return 0;
+
+    rec.type = (uint8_t)type;
+    rec.reserved = 0;
+    rec.length = (uint16_t)len;
+    memcpy(pRec, &rec, sizeof(FrameRecord_t));
+    memcpy(&pRec[sizeof(FrameRecord_t)], pPacket, len);
+    memset(&pRec[sizeof(FrameRecord_t) + len], 0, FRAME_RECORD_SIZE(len) - sizeof(FrameRecord_t) - len);
+    pBatch->hdr.length += FRAME_RECORD_SIZE(len);
+    ++pBatch->records;
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t frame_batch_finish(FrameBatch_t *pBatch)
+{
+    if(pBatch->records == 0)
+        return 0;
+    frame_header(&pBatch->hdr, FRAME_TYPE_BATCH, pBatch->payload, pBatch->hdr.length);
+    return sizeof(FrameHeader_t) + pBatch->hdr.length;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t frame_batch_next(uint8_t *pPayload, uint32_t len, uint32_t *pOffset,
+                         FrameType_e *pType, uint8_t **ppPacket, uint32_t *pPacketLen)
+{
+    FrameRecord_t rec;
+
+    if((*pOffset + sizeof(FrameRecord_t)) > len)
+        return 0;
+    memcpy(&rec, &pPayload[*pOffset], sizeof(FrameRecord_t));
+
+    /* the CRC passed, so this is the sender's mistake; stop here */
+    if((rec.type <= FRAME_TYPE_HELLO) || (rec.type >= FRAME_TYPE_BATCH) ||
+       ((*pOffset + FRAME_RECORD_SIZE(rec.length)) > len))
+        return 0;
+
+    *pType = (FrameType_e)rec.type;
+    *ppPacket = &pPayload[*pOffset + sizeof(FrameRecord_t)];
+    *pPacketLen = rec.length;
+    *pOffset += FRAME_RECORD_SIZE(rec.length);
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief CRC of the header fields before crc, then the payload
+ */
+static uint32_t frameCrc(const FrameHeader_t *pHdr, const void *pPayload)
+{
+    uint32_t crc;
+
+    crc = crc32c_update(CRC32C_INIT, (const uint8_t *)pHdr, offsetof(FrameHeader_t, crc));
+    crc = crc32c_update(crc, (const uint8_t *)pPayload, pHdr->length);
+    return crc32c_finish(crc);
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -36,6 +36,8 @@
 #include "platform.h"
 #include "healthMonitor.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_REMOTE_LOG_THREAD);
+
 #define MAX_CLIENTS (5)
 
 /* Prototypes for private/helper functions */
@@ -55,11 +57,13 @@ void* remoteLogThreadHandler(void* threadInfo)
   }
 
   sensorInfo = *(SensorThreadInfo *)threadInfo;
+  aliveFlag = 1; /* cleared by a previous kill if the supervisor restarted this thread */
   LogMsgPacket logPacket = {0};
   mqd_t logMsgQueue; /* logger MessageQueue */
   mqd_t hbMsgQueue;  /* main heartbeat MessageQueue */
   struct mq_attr mqAttr;
-  int sockfdLogServer, sockfdLogClient, socketLogFlags;
+  int sockfdLogServer, sockfdLogClient = -1, socketLogFlags;
+  int reuseAddr = 1;
   struct sockaddr_in servAddr, cliAddr;
   unsigned int cliLen = sizeof(cliAddr);
   size_t logPacketSize = sizeof(LogMsgPacket);
@@ -125,6 +129,9 @@ void* remoteLogThreadHandler(void* threadInfo)
   timeout.tv_usec = REMOTE_CLIENT_TIMEOUT_USEC;
   timeout.tv_sec = 0;
 
+  /* Allow a restarted thread to bind while the old connection is in TIME_WAIT */
+  setsockopt(sockfdLogServer, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
   /* Set properties and bind socket */
   servAddr.sin_family = AF_INET;
   servAddr.sin_addr.s_addr = INADDR_ANY;
@@ -209,14 +216,29 @@ void* remoteLogThreadHandler(void* threadInfo)
       LOG_REMOTE_LOG_EVENT(REMOTE_EVENT_INVALID_RECV);
       continue;
     }
+
+    /* sender checksums each packet, drop any damaged on the way */
+    if((logPacket.payloadLength > LOG_MSG_PAYLOAD_SIZE) ||
+       (log_packet_checksum(&logPacket) != logPacket.checksum)) {
+      ERROR_PRINT("remoteLogThread dropped log packet with bad length or checksum from remote client.\n");
+      LOG_REMOTE_LOG_EVENT(REMOTE_EVENT_INVALID_RECV);
+      continue;
+    }
+
+    /* remote node logs everything, apply this node's filter */
+    if(log_filter_pass(logPacket.fileId, logPacket.logMsgId) == 0)
+      continue;
+
     tmpItem.logMsgId = logPacket.logMsgId;
+    tmpItem.payloadFormat = logPacket.payloadFormat;
+    tmpItem.fileId = logPacket.fileId;
     tmpItem.lineNum = logPacket.lineNum;
     tmpItem.checksum = logPacket.checksum;
     tmpItem.payloadLength = logPacket.payloadLength;
     tmpItem.time = logPacket.timestamp;
     tmpItem.sourceId = logPacket.sourceId;
     tmpItem.pPayload = (uint8_t *)&logPacket.payload;
-    tmpItem.pFilename = (uint8_t *)&logPacket.filename;
+    tmpItem.pFilename = NULL;
 
     /* Write received log packet from RemoteNode to logger */
     if(LOG_ITEM(&tmpItem) != LOG_STATUS_OK) {
@@ -230,15 +252,12 @@ void* remoteLogThreadHandler(void* threadInfo)
   timer_delete(timerid);
   mq_close(logMsgQueue);
   mq_close(hbMsgQueue);
-  shutdown(sockfdLogClient, SHUT_RDWR);
-  shutdown(sockfdLogServer, SHUT_RDWR);
-  sleep(1);
-  uint8_t closeCnt = 0;
-  while(closeCnt++ < 8) {
+  if(sockfdLogClient >= 0) {
+    shutdown(sockfdLogClient, SHUT_RDWR);
     close(sockfdLogClient);
-    close(sockfdLogServer);
-    usleep(100000);
   }
+  shutdown(sockfdLogServer, SHUT_RDWR);
+  close(sockfdLogServer);
 
   return NULL;
 }
@@ -0,0 +1,937 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 12, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file remoteServer.c
+ * @brief epoll server for the remote node's log, status, cmd and data ports,
+ * and UDP telemetry
+ *
+ ************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+#include "remoteServer.h"
+#include "packet.h"
+#include "logger.h"
+#include "my_debug.h"
+#include "cmn_timer.h"
+#include "platform.h"
+#include "healthMonitor.h"
+#include "statusSummary.h"
+#include "nodeTable.h"
+#include "remoteFrame.h"
+#include "telemetrySeq.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_REMOTE_SERVER);
+
+#define SERVER_LISTEN_BACKLOG       (NODE_TABLE_MAX_NODES)  /* every node reconnecting at once */
+#define SERVER_MAX_EVENTS           (16)
+#define SERVER_EPOLL_CMD_QUEUE      (SERVER_PORT_END)       /* epoll data of non listening fds */
+#define SERVER_EPOLL_TIMER          (SERVER_PORT_END + 1)
+#define SERVER_EPOLL_TELEMETRY      (SERVER_PORT_END + 2)
+#define SERVER_EPOLL_CONN           (SERVER_PORT_END + 3)   /* + connection slot */
+#define SERVER_TELEMETRY_SIZE       (sizeof(FrameHeader_t) + sizeof(RemoteTelemetryPacket))
+
+typedef enum {
+    SERVER_PORT_LOG = 0,
+    SERVER_PORT_STATUS,
+    SERVER_PORT_CMD,
+    SERVER_PORT_DATA,
+    SERVER_PORT_MUX,
+    SERVER_PORT_END
+} ServerPort_e;
+
+typedef struct {
+    int fd;                                 /* -1 if slot free */
+    ServerPort_e port;
+    uint16_t nodeId;                        /* NODE_ID_NONE until its hello */
+    uint8_t readPending;                    /* read budget ran out before EAGAIN */
+    FrameReader_t reader;
+    PoolBuf_t *pRxBuf;                      /* reader's buffer, NULL if slot free */
+} ServerConn_t;
+
+typedef struct {
+    int epollFd;
+    int timerFd;
+    int listenFds[SERVER_PORT_END];
+    mqd_t logMsgQueue;
+    mqd_t hbMsgQueue;
+    mqd_t cmdMsgQueue;
+    ServerConn_t conns[REMOTE_SERVER_MAX_CONNS];
+    int telemetryFd;                        /* -1 if telemetry can't be received */
+    uint8_t telemetryPending;               /* telemetry budget ran out before EAGAIN */
+    uint32_t telemetryBuf[(SERVER_TELEMETRY_SIZE / sizeof(uint32_t)) + 1];  /* room to see one too long */
+    uint32_t readsPending;                  /* conns, and telemetry, with bytes left to read */
+    struct timespec linkStatsTime;          /* start of status link stats period */
+    uint32_t linkPackets;                   /* frames received on status link this period */
+    uint32_t linkRecords;                   /* status packets in them, batched or not */
+    uint32_t linkBytes;
+    uint32_t linkTelemetry;                 /* telemetry datagrams this period */
+    uint32_t linkTelemetryDropped;          /* of them, damaged or from nodes not in the table */
+    RemoteRxStats_t rxStats;                /* atomics, read by remoteServerRxStats() */
+} RemoteServer_t;
+
+/* handlers return EXIT_FAILURE for a frame that doesn't belong on the port */
+typedef struct {
+    uint16_t port;
+    int8_t (*handler)(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len);
+} ServerPortOps_t;
+
+/* private functions */
+static int8_t openPort(RemoteServer_t *pSrv, ServerPort_e port);
+static int8_t openTelemetry(RemoteServer_t *pSrv);
+static void readTelemetry(RemoteServer_t *pSrv);
+static void acceptClients(RemoteServer_t *pSrv, ServerPort_e port);
+static void readClient(RemoteServer_t *pSrv, uint32_t slot);
+static void readPending(RemoteServer_t *pSrv);
+static int8_t helloClient(RemoteServer_t *pSrv, uint32_t slot, FrameType_e type, uint8_t *pPayload, uint32_t len);
+static void handleFrame(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len);
+static void closeClient(RemoteServer_t *pSrv, uint32_t slot);
+static void sendCmds(RemoteServer_t *pSrv);
+static void tick(RemoteServer_t *pSrv);
+static void closeServer(RemoteServer_t *pSrv);
+static void logPortEvent(ServerPort_e port, RemoteEvent_e event);
+static int8_t handleLog(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len);
+static int8_t handleStatus(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len);
+static int8_t handleCmd(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len);
+static int8_t handleData(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len);
+static int8_t handleMux(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len);
+
+static const ServerPortOps_t portOps[SERVER_PORT_END] = {
+    [SERVER_PORT_LOG]    = {LOG_PORT,    handleLog},
+    [SERVER_PORT_STATUS] = {STATUS_PORT, handleStatus},
+    [SERVER_PORT_CMD]    = {CMD_PORT,    handleCmd},
+    [SERVER_PORT_DATA]   = {DATA_PORT,   handleData},
+    [SERVER_PORT_MUX]    = {MUX_PORT,    handleMux},
+};
+
+/* Define static and global variables */
+static SensorThreadInfo sensorInfo;
+static RemoteServer_t server;
+static PoolBuf_t rxBufs[REMOTE_SERVER_RX_BUFS];
+static BufPool_t rxPool;                    /* outlives a restart, the logger may hold buffers */
+static volatile uint8_t aliveFlag = 1;
+
+/*---------------------------------------------------------------------------------*/
+void* remoteServerThreadHandler(void* threadInfo)
+{
+    RemoteServer_t *pSrv = &server;
+    struct epoll_event event, events[SERVER_MAX_EVENTS];
+    struct itimerspec period;
+    struct mq_attr mqAttr;
+    sigset_t mask;
+    uint32_t slot;
+    uint8_t ind;
+    int num;
+
+    if(threadInfo == NULL) {
+        ERROR_PRINT("remoteServerThread Failed to initialize; NULL pointer for provided threadInfo parameter - exiting.\n");
+        return NULL;
+    }
+    sensorInfo = *(SensorThreadInfo *)threadInfo;
+    aliveFlag = 1; /* cleared by a previous kill if the supervisor restarted this thread */
+
+    /* only our kill signal gets through; main's loop timer is its own */
+    sigemptyset(&mask);
+    for(ind = 0; ind < NUM_THREADS; ++ind)
+    {
+        if(ind != (uint8_t)REMOTE_SERVER_PID)
+            sigaddset(&mask, SIGRTMIN + ind);
+    }
+    sigaddset(&mask, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    memset(pSrv, 0, sizeof(RemoteServer_t));
+    if((rxPool.count == 0) && (buf_pool_init(&rxPool, rxBufs, REMOTE_SERVER_RX_BUFS) != EXIT_SUCCESS)) {
+        ERROR_PRINT("remoteServerThread couldn't create receive buffers - exiting.\n");
+        return NULL;
+    }
+    pSrv->epollFd = -1;
+    pSrv->timerFd = -1;
+    pSrv->telemetryFd = -1;
+    for(ind = 0; ind < SERVER_PORT_END; ++ind)
+        pSrv->listenFds[ind] = -1;
+    for(slot = 0; slot < REMOTE_SERVER_MAX_CONNS; ++slot)
+        pSrv->conns[slot].fd = -1;
+    for(ind = 0; ind < SERVER_PORT_END; ++ind)
+        logPortEvent((ServerPort_e)ind, REMOTE_EVENT_STARTED);
+
+    /* Open FDs for Main and Logging Message queues */
+    memset(&mqAttr, 0, sizeof(struct mq_attr));
+    pSrv->logMsgQueue = mq_open(sensorInfo.logMsgQueueName, O_RDWR, 0666, &mqAttr);
+    pSrv->hbMsgQueue = mq_open(sensorInfo.heartbeatMsgQueueName, O_RDWR | O_NONBLOCK, 0666, &mqAttr);
+    pSrv->cmdMsgQueue = mq_open(sensorInfo.cmdMsgQueueName, O_RDWR | O_NONBLOCK, 0666, &mqAttr);
+    if((pSrv->logMsgQueue == -1) || (pSrv->hbMsgQueue == -1)) {
+        ERROR_PRINT("remoteServerThread Failed to Open MessageQueues - exiting.\n");
+        LOG_REMOTE_DATA_EVENT(REMOTE_STATUS_QUEUE_ERROR);
+        closeServer(pSrv);
+        return NULL;
+    }
+
+    pSrv->epollFd = epoll_create1(0);
+    pSrv->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if((pSrv->epollFd < 0) || (pSrv->timerFd < 0)) {
+        ERRNO_PRINT("remoteServerThread couldn't create epoll/timer fds");
+        closeServer(pSrv);
+        return NULL;
+    }
+    for(ind = 0; ind < SERVER_PORT_END; ++ind)
+    {
+        if(openPort(pSrv, (ServerPort_e)ind) != EXIT_SUCCESS) {
+            closeServer(pSrv);
+            return NULL;
+        }
+    }
+
+    /* not fatal either, nodes sending data over TCP are still heard */
+    openTelemetry(pSrv);
+
+    /* cmds are sent as main queues them; not fatal, data still flows without */
+    event.events = EPOLLIN;
+    event.data.u32 = SERVER_EPOLL_CMD_QUEUE;
+    if((pSrv->cmdMsgQueue == -1) || (epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, (int)pSrv->cmdMsgQueue, &event) < 0)) {
+        ERROR_PRINT("remoteServerThread can't watch Command MessageQueue, no cmds to remote node.\n");
+        LOG_REMOTE_CMD_EVENT(REMOTE_STATUS_QUEUE_ERROR);
+    }
+
+    /* heartbeats and link stats */
+    memset(&period, 0, sizeof(struct itimerspec));
+    period.it_interval.tv_sec = REMOTE_LOOP_TIME_SEC;
+    period.it_interval.tv_nsec = REMOTE_LOOP_TIME_NSEC;
+    period.it_value = period.it_interval;
+    event.data.u32 = SERVER_EPOLL_TIMER;
+    if((timerfd_settime(pSrv->timerFd, 0, &period, NULL) < 0) ||
+       (epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, pSrv->timerFd, &event) < 0)) {
+        ERRNO_PRINT("remoteServerThread couldn't start timer");
+        closeServer(pSrv);
+        return NULL;
+    }
+
+    INFO_PRINT("Created remoteServerThread to listen on ports {%d-%d}, telemetry on %d\n", LOG_PORT, MUX_PORT, TELEMETRY_PORT);
+    MUTED_PRINT("remoteServerThread started successfully, pid: %d, SIGRTMIN+PID_e: %d\n",(pid_t)syscall(SYS_gettid), SIGRTMIN + REMOTE_SERVER_PID);
+    for(ind = 0; ind < SERVER_PORT_END; ++ind)
+        logPortEvent((ServerPort_e)ind, REMOTE_INIT_SUCCESS);
+
+    clock_gettime(CLOCK_REALTIME, &pSrv->linkStatsTime);
+    tick(pSrv);
+    while(aliveFlag)
+    {
+        /* don't sleep while a connection has bytes left unread */
+        num = epoll_wait(pSrv->epollFd, events, SERVER_MAX_EVENTS, (pSrv->readsPending != 0) ? 0 : -1);
+        if(num < 0) {
+            if(errno == EINTR)
+                continue;
+            ERRNO_PRINT("remoteServerThread epoll_wait");
+            break;
+        }
+
+        /* cmds go before anything nodes sent, however much that is */
+        for(ind = 0; ind < num; ++ind)
+        {
+            if(events[ind].data.u32 == SERVER_EPOLL_CMD_QUEUE)
+                sendCmds(pSrv);
+        }
+        readPending(pSrv);
+        for(ind = 0; ind < num; ++ind)
+        {
+            if(events[ind].data.u32 < SERVER_PORT_END)
+                acceptClients(pSrv, (ServerPort_e)events[ind].data.u32);
+            else if(events[ind].data.u32 == SERVER_EPOLL_CMD_QUEUE)
+                continue;
+            else if(events[ind].data.u32 == SERVER_EPOLL_TIMER)
+                tick(pSrv);
+            else if(events[ind].data.u32 == SERVER_EPOLL_TELEMETRY)
+                readTelemetry(pSrv);
+            else
+                readClient(pSrv, events[ind].data.u32 - SERVER_EPOLL_CONN);
+        }
+    }
+
+    for(ind = 0; ind < SERVER_PORT_END; ++ind)
+        logPortEvent((ServerPort_e)ind, REMOTE_EVENT_EXITING);
+    ERROR_PRINT("Remote Server Thread exiting\n");
+    closeServer(pSrv);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+void remoteServerSigHandler(int signo, siginfo_t *info, void *extra)
+{
+    if((info != NULL) && (extra != NULL))
+    {
+        INFO_PRINT("remoteServerSigHandler, signum: %d\n",info->si_signo);
+        aliveFlag = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+void remoteServerRxStats(RemoteRxStats_t *pStats)
+{
+    RemoteRxStats_t *pRx = &server.rxStats;
+
+    pStats->rxBytes = __atomic_load_n(&pRx->rxBytes, __ATOMIC_RELAXED);
+    pStats->movedBytes = __atomic_load_n(&pRx->movedBytes, __ATOMIC_RELAXED);
+    pStats->logRecords = __atomic_load_n(&pRx->logRecords, __ATOMIC_RELAXED);
+    pStats->logRefs = __atomic_load_n(&pRx->logRefs, __ATOMIC_RELAXED);
+    pStats->telemetry = __atomic_load_n(&pRx->telemetry, __ATOMIC_RELAXED);
+    pStats->telemetryDropped = __atomic_load_n(&pRx->telemetryDropped, __ATOMIC_RELAXED);
+}
+
+/*---------------------------------------------------------------------------------*/
+/* HELPER METHODS */
+/*---------------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief non-blocking, edge triggered listening socket for a port
+ */
+static int8_t openPort(RemoteServer_t *pSrv, ServerPort_e port)
+{
+    struct sockaddr_in servAddr;
+    struct epoll_event event;
+    int reuseAddr = 1;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd == -1) {
+        ERRNO_PRINT("remoteServerThread failed to create socket");
+        logPortEvent(port, REMOTE_SERVER_SOCKET_ERROR);
+        return EXIT_FAILURE;
+    }
+    pSrv->listenFds[port] = fd;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    /* Allow a restarted thread to bind while the old connection is in TIME_WAIT */
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
+    memset(&servAddr, 0, sizeof(struct sockaddr_in));
+    servAddr.sin_family = AF_INET;
+    servAddr.sin_addr.s_addr = INADDR_ANY;
+    servAddr.sin_port = htons(portOps[port].port);
+    if((bind(fd, (struct sockaddr*)&servAddr, sizeof(servAddr)) == -1) ||
+       (listen(fd, SERVER_LISTEN_BACKLOG) == -1)) {
+        ERROR_PRINT("remoteServerThread failed to bind/listen on port %d - exiting.\n", portOps[port].port);
+        logPortEvent(port, REMOTE_SERVER_SOCKET_ERROR);
+        return EXIT_FAILURE;
+    }
+
+    event.events = EPOLLIN | EPOLLET;
+    event.data.u32 = (uint32_t)port;
+    if(epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        ERRNO_PRINT("remoteServerThread couldn't watch listening socket");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief UDP socket for telemetry datagrams from any node
+ */
+static int8_t openTelemetry(RemoteServer_t *pSrv)
+{
+    struct sockaddr_in servAddr;
+    struct epoll_event event;
+    int reuseAddr = 1;
+
+    pSrv->telemetryFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(pSrv->telemetryFd == -1) {
+        ERRNO_PRINT("remoteServerThread failed to create telemetry socket");
+        logPortEvent(SERVER_PORT_DATA, REMOTE_SERVER_SOCKET_ERROR);
+        return EXIT_FAILURE;
+    }
+    fcntl(pSrv->telemetryFd, F_SETFL, fcntl(pSrv->telemetryFd, F_GETFL) | O_NONBLOCK);
+    setsockopt(pSrv->telemetryFd, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
+    memset(&servAddr, 0, sizeof(struct sockaddr_in));
+    servAddr.sin_family = AF_INET;
+    servAddr.sin_addr.s_addr = INADDR_ANY;
+    servAddr.sin_port = htons(TELEMETRY_PORT);
+    event.events = EPOLLIN | EPOLLET;
+    event.data.u32 = SERVER_EPOLL_TELEMETRY;
+    if((bind(pSrv->telemetryFd, (struct sockaddr*)&servAddr, sizeof(servAddr)) == -1) ||
+       (epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, pSrv->telemetryFd, &event) < 0)) {
+        ERROR_PRINT("remoteServerThread can't receive telemetry on port %d, nodes sending it go unheard.\n", TELEMETRY_PORT);
+        logPortEvent(SERVER_PORT_DATA, REMOTE_SERVER_SOCKET_ERROR);
+        close(pSrv->telemetryFd);
+        pSrv->telemetryFd = -1;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief telemetry datagrams until EAGAIN or the budget runs out; each is
+ * one frame, checked whole, and its node's accounting in the node table
+ */
+static void readTelemetry(RemoteServer_t *pSrv)
+{
+    uint8_t *pFrame = (uint8_t *)pSrv->telemetryBuf;
+    FrameHeader_t hdr;
+    TelemetrySeq_e result;
+    uint32_t budget = REMOTE_SERVER_READ_BUDGET / SERVER_TELEMETRY_SIZE;
+    ssize_t len;
+
+    if(pSrv->telemetryPending) {
+        pSrv->telemetryPending = 0;
+        --pSrv->readsPending;
+    }
+    if(pSrv->telemetryFd < 0)
+        return;
+
+    while(1)
+    {
+        if(budget-- == 0) {
+            pSrv->telemetryPending = 1;
+            ++pSrv->readsPending;
+            return;
+        }
+
+        /* MSG_TRUNC: length of the datagram, even if longer than the buffer */
+        len = recv(pSrv->telemetryFd, pFrame, sizeof(pSrv->telemetryBuf), MSG_TRUNC);
+        if(len < 0) {
+            if(errno == EINTR)
+                continue;
+            if((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                ERRNO_PRINT("remoteServerThread telemetry recv fail");
+                logPortEvent(SERVER_PORT_DATA, REMOTE_CLIENT_SOCKET_ERROR);
+            }
+            return;
+        }
+
+        ++pSrv->linkTelemetry;
+        __atomic_add_fetch(&pSrv->rxStats.telemetry, 1, __ATOMIC_RELAXED);
+        if((len != SERVER_TELEMETRY_SIZE) || !frame_check(pFrame, (uint32_t)len, &hdr) ||
+           (hdr.type != FRAME_TYPE_TELEMETRY) ||
+           (node_table_telemetry((RemoteTelemetryPacket *)&pFrame[sizeof(FrameHeader_t)], &result) != EXIT_SUCCESS)) {
+            ++pSrv->linkTelemetryDropped;
+            __atomic_add_fetch(&pSrv->rxStats.telemetryDropped, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief accept until the backlog is empty; edge triggered, so all of it
+ */
+static void acceptClients(RemoteServer_t *pSrv, ServerPort_e port)
+{
+    struct epoll_event event;
+    PoolBuf_t *pRxBuf;
+    uint32_t slot;
+    int fd;
+
+    while((fd = accept(pSrv->listenFds[port], NULL, NULL)) >= 0)
+    {
+        for(slot = 0; (slot < REMOTE_SERVER_MAX_CONNS) && (pSrv->conns[slot].fd >= 0); ++slot);
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        event.data.u32 = SERVER_EPOLL_CONN + slot;
+        pRxBuf = (slot < REMOTE_SERVER_MAX_CONNS) ? buf_pool_alloc(&rxPool) : NULL;
+        if((pRxBuf == NULL) || (epoll_ctl(pSrv->epollFd, EPOLL_CTL_ADD, fd, &event) < 0)) {
+            ERROR_PRINT("remoteServerThread out of connections, refused one on port %d.\n", portOps[port].port);
+            logPortEvent(port, REMOTE_CLIENT_SOCKET_ERROR);
+            if(pRxBuf != NULL)
+                buf_pool_release(pRxBuf);
+            close(fd);
+            continue;
+        }
+        pSrv->conns[slot].fd = fd;
+        pSrv->conns[slot].port = port;
+        pSrv->conns[slot].nodeId = NODE_ID_NONE;
+        pSrv->conns[slot].readPending = 0;
+        pSrv->conns[slot].pRxBuf = pRxBuf;
+        frame_reader_init(&pSrv->conns[slot].reader, (uint8_t *)pRxBuf->data);
+
+        MUTED_PRINT("Connected remoteServerThread to external Client on port %d.\n", portOps[port].port);
+        logPortEvent(port, REMOTE_EVENT_CNCT_ACCEPTED);
+    }
+    if((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+        ERRNO_PRINT("remoteServerThread accept");
+        logPortEvent(port, REMOTE_CLIENT_SOCKET_ERROR);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief read until EAGAIN, handing each whole frame to the port's handler;
+ * after REMOTE_SERVER_READ_BUDGET bytes the rest waits for readPending(),
+ * so a node flooding one connection can't hold up cmds and other nodes
+ */
+static void readClient(RemoteServer_t *pSrv, uint32_t slot)
+{
+    ServerConn_t *pConn;
+    const ServerPortOps_t *pOps;
+    FrameHeader_t hdr;
+    PoolBuf_t *pRxBuf;
+    uint8_t *pRx, *pPayload;
+    uint32_t space, skipped, moved, budget = REMOTE_SERVER_READ_BUDGET;
+    ssize_t len;
+
+    if((slot >= REMOTE_SERVER_MAX_CONNS) || (pSrv->conns[slot].fd < 0))
+        return;
+    pConn = &pSrv->conns[slot];
+    pOps = &portOps[pConn->port];
+    if(pConn->readPending) {
+        pConn->readPending = 0;
+        --pSrv->readsPending;
+    }
+
+    while(1)
+    {
+        /* epoll won't say there's more until more arrives, remember it */
+        if(budget == 0) {
+            pConn->readPending = 1;
+            ++pSrv->readsPending;
+            return;
+        }
+
+        /* log packets handed on by pointer are still in this buffer;
+         * carry on in another rather than move bytes down over them */
+        moved = pConn->reader.moved;
+        if(frame_reader_compacts(&pConn->reader) && buf_pool_shared(pConn->pRxBuf)) {
+            pRxBuf = buf_pool_alloc(&rxPool);
+            if(pRxBuf == NULL) {
+                ERROR_PRINT("remoteServerThread out of receive buffers, dropped node %u on port %d.\n", pConn->nodeId, pOps->port);
+                logPortEvent(pConn->port, REMOTE_CLIENT_SOCKET_ERROR);
+                closeClient(pSrv, slot);
+                return;
+            }
+            frame_reader_move(&pConn->reader, (uint8_t *)pRxBuf->data);
+            buf_pool_release(pConn->pRxBuf);
+            pConn->pRxBuf = pRxBuf;
+        }
+        pRx = frame_reader_space(&pConn->reader, &space);
+        __atomic_add_fetch(&pSrv->rxStats.movedBytes, pConn->reader.moved - moved, __ATOMIC_RELAXED);
+        len = recv(pConn->fd, pRx, space, 0);
+        if(len == 0) {
+            MUTED_PRINT("remoteServerThread connection lost with node %u on port %d.\n", pConn->nodeId, pOps->port);
+            logPortEvent(pConn->port, REMOTE_EVENT_CNCT_LOST);
+            closeClient(pSrv, slot);
+            return;
+        }
+        if(len < 0) {
+            if(errno == EINTR)
+                continue;
+            if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                return;
+            ERRNO_PRINT("remoteServerThread recv fail");
+            logPortEvent(pConn->port, REMOTE_CLIENT_SOCKET_ERROR);
+            closeClient(pSrv, slot);
+            return;
+        }
+        frame_reader_commit(&pConn->reader, (uint32_t)len);
+        budget = ((uint32_t)len < budget) ? (budget - (uint32_t)len) : 0;
+        __atomic_add_fetch(&pSrv->rxStats.rxBytes, (uint64_t)len, __ATOMIC_RELAXED);
+
+        moved = pConn->reader.moved;
+        skipped = pConn->reader.skipped;
+        while(frame_reader_next(&pConn->reader, &hdr, &pPayload))
+        {
+            /* nothing but the node's hello until it has said who it is */
+            if(pConn->nodeId == NODE_ID_NONE) {
+                if(helloClient(pSrv, slot, (FrameType_e)hdr.type, pPayload, hdr.length) != EXIT_SUCCESS)
+                    return;
+            }
+            else {
+                if(pConn->port == SERVER_PORT_STATUS) {
+                    ++pSrv->linkPackets;
+                    pSrv->linkBytes += sizeof(FrameHeader_t) + hdr.length;
+                }
+                handleFrame(pSrv, pConn, (FrameType_e)hdr.type, pPayload, hdr.length);
+            }
+        }
+        __atomic_add_fetch(&pSrv->rxStats.movedBytes, pConn->reader.moved - moved, __ATOMIC_RELAXED);
+        if(pConn->reader.skipped != skipped) {
+            ERROR_PRINT("remoteServerThread skipped %u damaged bytes from node %u on port %d.\n",
+                        pConn->reader.skipped - skipped, pConn->nodeId, pOps->port);
+            logPortEvent(pConn->port, REMOTE_EVENT_INVALID_RECV);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief read on from connections whose read budget ran out
+ */
+static void readPending(RemoteServer_t *pSrv)
+{
+    uint32_t slot;
+
+    if(pSrv->telemetryPending)
+        readTelemetry(pSrv);
+    for(slot = 0; (slot < REMOTE_SERVER_MAX_CONNS) && (pSrv->readsPending != 0); ++slot)
+    {
+        if(pSrv->conns[slot].readPending)
+            readClient(pSrv, slot);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a frame to its port's handler; a batch's packets one by one, as
+ * if each had come in its own frame
+ */
+static void handleFrame(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len)
+{
+    const ServerPortOps_t *pOps = &portOps[pConn->port];
+    FrameType_e packetType;
+    uint8_t *pPacket;
+    uint32_t offset = 0, packetLen;
+
+    if(type == FRAME_TYPE_BATCH) {
+        while(frame_batch_next(pPayload, len, &offset, &packetType, &pPacket, &packetLen))
+            handleFrame(pSrv, pConn, packetType, pPacket, packetLen);
+        if(offset == len)
+            return;
+        ERROR_PRINT("remoteServerThread dropped the rest of a batch, %u of %u bytes from node %u on port %d.\n",
+                    len - offset, len, pConn->nodeId, pOps->port);
+    }
+    else if(pOps->handler(pSrv, pConn, type, pPayload, len) == EXIT_SUCCESS) {
+        return;
+    }
+    else {
+        ERROR_PRINT("remoteServerThread dropped frame type %u, %u bytes from node %u on port %d.\n",
+                    type, len, pConn->nodeId, pOps->port);
+    }
+    logPortEvent(pConn->port, REMOTE_EVENT_INVALID_RECV);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief name the connection after the node in its hello; an earlier
+ * connection of that node to the same port is stale (the node reconnected
+ * before the old one timed out) and is closed
+ */
+static int8_t helloClient(RemoteServer_t *pSrv, uint32_t slot, FrameType_e type, uint8_t *pPayload, uint32_t len)
+{
+    ServerConn_t *pConn = &pSrv->conns[slot];
+    RemoteHelloPacket hello;
+    uint32_t ind;
+
+    memset(&hello, 0, sizeof(RemoteHelloPacket));
+    if((type == FRAME_TYPE_HELLO) && (len == sizeof(RemoteHelloPacket)))
+        memcpy(&hello, pPayload, sizeof(RemoteHelloPacket));
+    if((hello.header != REMOTE_HELLO_HEADER) || (node_table_connect(hello.nodeId, 1 << pConn->port) != EXIT_SUCCESS)) {
+        ERROR_PRINT("remoteServerThread refused client on port %d: bad hello or node table full.\n", portOps[pConn->port].port);
+        logPortEvent(pConn->port, REMOTE_EVENT_INVALID_RECV);
+        closeClient(pSrv, slot);
+        return EXIT_FAILURE;
+    }
+
+    for(ind = 0; ind < REMOTE_SERVER_MAX_CONNS; ++ind)
+    {
+        if((ind != slot) && (pSrv->conns[ind].fd >= 0) && (pSrv->conns[ind].nodeId == hello.nodeId) &&
+           (pSrv->conns[ind].port == pConn->port)) {
+            logPortEvent(pConn->port, REMOTE_EVENT_CNCT_LOST);
+            pSrv->conns[ind].nodeId = NODE_ID_NONE; /* still connected on slot */
+            closeClient(pSrv, ind);
+        }
+    }
+    pConn->nodeId = hello.nodeId;
+    MUTED_PRINT("remoteServerThread node %u connected on port %d\n", hello.nodeId, portOps[pConn->port].port);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void closeClient(RemoteServer_t *pSrv, uint32_t slot)
+{
+    if(pSrv->conns[slot].readPending) {
+        pSrv->conns[slot].readPending = 0;
+        --pSrv->readsPending;
+    }
+    if(pSrv->conns[slot].nodeId != NODE_ID_NONE)
+        node_table_disconnect(pSrv->conns[slot].nodeId, 1 << pSrv->conns[slot].port);
+    epoll_ctl(pSrv->epollFd, EPOLL_CTL_DEL, pSrv->conns[slot].fd, NULL);
+    shutdown(pSrv->conns[slot].fd, SHUT_RDWR);
+    close(pSrv->conns[slot].fd);
+    pSrv->conns[slot].fd = -1;
+    pSrv->conns[slot].nodeId = NODE_ID_NONE;
+
+    /* returns to the pool once the logging thread has written its packets */
+    buf_pool_release(pSrv->conns[slot].pRxBuf);
+    pSrv->conns[slot].pRxBuf = NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief send everything main has queued to the cmd connection of the node
+ * in its header, or of every node for REMOTE_NODE_ALL
+ */
+static void sendCmds(RemoteServer_t *pSrv)
+{
+    RemoteCmdPacket cmdPacket;
+    FrameHeader_t hdr;
+    struct iovec iov[2];
+    struct msghdr msg;
+    uint16_t nodeId;
+    uint32_t ind, sent;
+
+    while(mq_receive(pSrv->cmdMsgQueue, (char *)&cmdPacket, sizeof(RemoteCmdPacket), NULL) == sizeof(RemoteCmdPacket))
+    {
+        nodeId = cmdPacket.header;
+        cmdPacket.header = 0;
+        frame_header(&hdr, FRAME_TYPE_CMD, &cmdPacket, sizeof(RemoteCmdPacket));
+        iov[0].iov_base = &hdr;
+        iov[0].iov_len = sizeof(FrameHeader_t);
+        iov[1].iov_base = &cmdPacket;
+        iov[1].iov_len = sizeof(RemoteCmdPacket);
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 2;
+        sent = 0;
+        for(ind = 0; ind < REMOTE_SERVER_MAX_CONNS; ++ind)
+        {
+            if((pSrv->conns[ind].fd < 0) ||
+               ((pSrv->conns[ind].port != SERVER_PORT_CMD) && (pSrv->conns[ind].port != SERVER_PORT_MUX)) ||
+               (pSrv->conns[ind].nodeId == NODE_ID_NONE) ||
+               ((nodeId != REMOTE_NODE_ALL) && (pSrv->conns[ind].nodeId != nodeId)))
+                continue;
+            if(sendmsg(pSrv->conns[ind].fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT) != (sizeof(FrameHeader_t) + sizeof(RemoteCmdPacket)))
+                continue;
+            MUTED_PRINT("remoteCmd sent to node %u. Cmd Packet: cmd: %d | Data: %d\n",
+                        pSrv->conns[ind].nodeId, cmdPacket.cmd, cmdPacket.data);
+            ++sent;
+        }
+        if(sent == 0) {
+            ERROR_PRINT("Failed to send CmdPacket to Remote Node %u - client socket connection unavailable\n", nodeId);
+            LOG_REMOTE_CMD_EVENT(REMOTE_CLIENT_SOCKET_ERROR);
+        }
+        LOG_REMOTE_CMD_EVENT(REMOTE_EVENT_CMD_RECV);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief every REMOTE_LOOP_TIME: a heartbeat for each port's thread Id,
+ * status link stats when due
+ */
+static void tick(RemoteServer_t *pSrv)
+{
+    struct timespec now;
+    uint64_t expirations;
+    float deltaTime;
+    char linkStats[LOG_MSG_PAYLOAD_SIZE];
+
+    if(read(pSrv->timerFd, &expirations, sizeof(expirations)) < 0) {
+        /* first call is before the timer has expired */
+    }
+    SEND_STATUS_MSG(pSrv->hbMsgQueue, PID_REMOTE_LOG, STATUS_OK, ERROR_CODE_USER_NONE0);
+    SEND_STATUS_MSG(pSrv->hbMsgQueue, PID_REMOTE_STATUS, STATUS_OK, ERROR_CODE_USER_NONE0);
+    SEND_STATUS_MSG(pSrv->hbMsgQueue, PID_REMOTE_DATA, STATUS_OK, ERROR_CODE_USER_NONE0);
+    SEND_STATUS_MSG(pSrv->hbMsgQueue, PID_REMOTE_CMD, STATUS_OK, ERROR_CODE_USER_NONE0);
+
+    /* status link load, packets are TIVA sends, records the status in them */
+    clock_gettime(CLOCK_REALTIME, &now);
+    if((now.tv_sec - pSrv->linkStatsTime.tv_sec) >= REMOTE_SERVER_LINK_STATS_SEC) {
+        deltaTime = (now.tv_sec - pSrv->linkStatsTime.tv_sec) + ((now.tv_nsec - pSrv->linkStatsTime.tv_nsec) * 1e-9);
+        snprintf(linkStats, sizeof(linkStats), "status link %.2f pkt/s %.2f rec/s %.1f B/s",
+                 pSrv->linkPackets / deltaTime, pSrv->linkRecords / deltaTime, pSrv->linkBytes / deltaTime);
+        LOG_INFO(linkStats);
+        if(pSrv->linkTelemetry != 0) {
+            snprintf(linkStats, sizeof(linkStats), "telemetry %.2f datagram/s, %u dropped",
+                     pSrv->linkTelemetry / deltaTime, pSrv->linkTelemetryDropped);
+            LOG_INFO(linkStats);
+        }
+        pSrv->linkTelemetry = 0;
+        pSrv->linkTelemetryDropped = 0;
+        pSrv->linkPackets = 0;
+        pSrv->linkRecords = 0;
+        pSrv->linkBytes = 0;
+        pSrv->linkStatsTime = now;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static void closeServer(RemoteServer_t *pSrv)
+{
+    uint32_t ind;
+
+    for(ind = 0; ind < REMOTE_SERVER_MAX_CONNS; ++ind)
+    {
+        if(pSrv->conns[ind].fd >= 0)
+            closeClient(pSrv, ind);
+    }
+    for(ind = 0; ind < SERVER_PORT_END; ++ind)
+    {
+        if(pSrv->listenFds[ind] >= 0) {
+            shutdown(pSrv->listenFds[ind], SHUT_RDWR);
+            close(pSrv->listenFds[ind]);
+        }
+    }
+    if(pSrv->telemetryFd >= 0)
+        close(pSrv->telemetryFd);
+    if(pSrv->timerFd >= 0)
+        close(pSrv->timerFd);
+    if(pSrv->epollFd >= 0)
+        close(pSrv->epollFd);
+    if(pSrv->logMsgQueue != -1)
+        mq_close(pSrv->logMsgQueue);
+    if(pSrv->hbMsgQueue != -1)
+        mq_close(pSrv->hbMsgQueue);
+    if(pSrv->cmdMsgQueue != -1)
+        mq_close(pSrv->cmdMsgQueue);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief log an event as the per-port thread it replaces did
+ */
+static void logPortEvent(ServerPort_e port, RemoteEvent_e event)
+{
+    switch(port) {
+        case SERVER_PORT_LOG:
+            LOG_REMOTE_LOG_EVENT(event);
+            break;
+        case SERVER_PORT_STATUS:
+            LOG_REMOTE_STATUS_EVENT(event);
+            break;
+        case SERVER_PORT_CMD:
+            LOG_REMOTE_CMD_EVENT(event);
+            break;
+        default:
+            LOG_REMOTE_DATA_EVENT(event);
+            break;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static int8_t handleLog(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len)
+{
+    LogMsgPacket *pLog = (LogMsgPacket *)pPayload;
+    logItem_t item;
+
+    /* the record's own checksum still covers it from the TIVA's logger to ours */
+    if((type != FRAME_TYPE_LOG) || (len != sizeof(LogMsgPacket)) ||
+       (pLog->payloadLength > LOG_MSG_PAYLOAD_SIZE) || (log_packet_checksum(pLog) != pLog->checksum))
+        return EXIT_FAILURE;
+
+    /* remote node logs everything, apply this node's filter */
+    if(log_filter_pass(pLog->fileId, pLog->logMsgId) == 0)
+        return EXIT_SUCCESS;
+    __atomic_add_fetch(&pSrv->rxStats.logRecords, 1, __ATOMIC_RELAXED);
+
+    /* written from where it was received if the logging thread can take it */
+    if(log_ref_item(pLog, pConn->pRxBuf) == LOG_STATUS_OK) {
+        __atomic_add_fetch(&pSrv->rxStats.logRefs, 1, __ATOMIC_RELAXED);
+        return EXIT_SUCCESS;
+    }
+
+    memset(&item, 0, sizeof(logItem_t));
+    item.logMsgId = pLog->logMsgId;
+    item.payloadFormat = pLog->payloadFormat;
+    item.fileId = pLog->fileId;
+    item.lineNum = pLog->lineNum;
+    item.checksum = pLog->checksum;
+    item.payloadLength = pLog->payloadLength;
+    item.time = pLog->timestamp;
+    item.sourceId = pLog->sourceId;
+    item.pPayload = (uint8_t *)&pLog->payload;
+    item.pFilename = NULL;
+
+    /* Write received log packet from RemoteNode to logger */
+    if(LOG_ITEM(&item) != LOG_STATUS_OK) {
+        INFO_PRINT("LOG_ITEM write error\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief TIVA task status, or a summary of their heartbeats, onto the
+ * heartbeat queue
+ */
+static int8_t handleStatus(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len)
+{
+    StatusSummaryPacket *pSummary = (StatusSummaryPacket *)pPayload;
+    TaskStatusPacket *pStatus = (TaskStatusPacket *)pPayload;
+    uint8_t ind;
+
+    if(type == FRAME_TYPE_STATUS_SUMMARY) {
+        if(!status_summary_valid(pSummary, len))
+            return EXIT_FAILURE;
+        for(ind = 0; ind < pSummary->numTasks; ++ind)
+        {
+            MUTED_PRINT("summary %s: %d OK from %u to %u\n", getPidString(pSummary->tasks[ind].processId),
+                        pSummary->tasks[ind].count, pSummary->tasks[ind].firstTimestamp, pSummary->tasks[ind].lastTimestamp);
+            SEND_STATUS_MSG(pSrv->hbMsgQueue, (ProcessId_e)pSummary->tasks[ind].processId, STATUS_OK, pSummary->tasks[ind].errorCode);
+        }
+    }
+    else if((type == FRAME_TYPE_STATUS) && (len == sizeof(TaskStatusPacket))) {
+        SEND_STATUS_MSG(pSrv->hbMsgQueue, pStatus->processId, pStatus->taskStatus, pStatus->errorCode);
+    }
+    else {
+        return EXIT_FAILURE;
+    }
+    ++pSrv->linkRecords;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief nothing is expected from the remote node on the cmd port, what it
+ * sends is only read to notice it disconnecting
+ */
+static int8_t handleCmd(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len)
+{
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief one connection carrying every port's packets; the frame type says
+ * which port's handler takes it
+ */
+static int8_t handleMux(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len)
+{
+    switch(type) {
+        case FRAME_TYPE_LOG:
+            return handleLog(pSrv, pConn, type, pPayload, len);
+        case FRAME_TYPE_STATUS:
+        case FRAME_TYPE_STATUS_SUMMARY:
+            return handleStatus(pSrv, pConn, type, pPayload, len);
+        case FRAME_TYPE_DATA:
+            return handleData(pSrv, pConn, type, pPayload, len);
+        default:
+            return EXIT_FAILURE;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static int8_t handleData(RemoteServer_t *pSrv, ServerConn_t *pConn, FrameType_e type, uint8_t *pPayload, uint32_t len)
+{
+    RemoteDataPacket *pData = (RemoteDataPacket *)pPayload;
+
+    if((type != FRAME_TYPE_DATA) || (len != sizeof(RemoteDataPacket)))
+        return EXIT_FAILURE;
+    MUTED_PRINT("Data packet received from node %u: Lux: %f | Moist: %f\n", pConn->nodeId, pData->luxData, pData->moistureData);
+
+    /* latest per node, for main's control loop */
+    node_table_data(pConn->nodeId, pData);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -35,11 +35,16 @@
 #include "cmn_timer.h"
 #include "platform.h"
 #include "healthMonitor.h"
+#include "statusSummary.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_REMOTE_STATUS_THREAD);
 
 #define MAX_CLIENTS (5)
+#define STATUS_LINK_STATS_SEC (60)
 
 /* Prototypes for private/helper functions */
 void remoteStatusGetAliveFlag(uint8_t *pAlive);
+static ssize_t forwardSummary(int sockfd, StatusSummaryPacket *pPacket, mqd_t hbMsgQueue);
 
 /* Define static and global variables */
 static SensorThreadInfo sensorInfo;
@@ -55,11 +60,14 @@ void* remoteStatusThreadHandler(void* threadInfo)
   }
 
   sensorInfo = *(SensorThreadInfo *)threadInfo;
+  aliveFlag = 1; /* cleared by a previous kill if the supervisor restarted this thread */
   TaskStatusPacket statusPacket = {0};
+  StatusSummaryPacket rxPacket;  /* a TaskStatusPacket, or the start of a summary */
   mqd_t logMsgQueue; /* logger MessageQueue */
   mqd_t hbMsgQueue;  /* main heartbeat MessageQueue */
   struct mq_attr mqAttr;
-  int sockfdStatusServer, sockfdStatusClient, socketStatusFlags;
+  int sockfdStatusServer, sockfdStatusClient = -1, socketStatusFlags;
+  int reuseAddr = 1;
   struct sockaddr_in servAddr, cliAddr;
   unsigned int cliLen = sizeof(cliAddr);
   size_t statusPacketSize = sizeof(struct TaskStatusPacket);
@@ -68,6 +76,9 @@ void* remoteStatusThreadHandler(void* threadInfo)
 	sigset_t mask;
   struct timespec currentTime, lastStatusMsgTime;     /* to calc delta time */
   float deltaTime;                                    /* delta time since last sent status msg */
+  struct timespec linkStatsTime;                      /* start of link stats period */
+  uint32_t linkPackets = 0, linkBytes = 0;            /* received from TIVA this period */
+  char linkStats[LOG_MSG_PAYLOAD_SIZE];
 
   /* how often healthMonitor expects status msgs */
   const float otherThreadTime = TEMP_LOOP_TIME_SEC + (TEMP_LOOP_TIME_NSEC * 1e-9);
@@ -129,6 +140,9 @@ void* remoteStatusThreadHandler(void* threadInfo)
   timeout.tv_usec = REMOTE_CLIENT_TIMEOUT_USEC;
   timeout.tv_sec = 0;
 
+  /* Allow a restarted thread to bind while the old connection is in TIME_WAIT */
+  setsockopt(sockfdStatusServer, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr));
+
   /* Set properties and bind socket */
   servAddr.sin_family = AF_INET;
   servAddr.sin_addr.s_addr = INADDR_ANY;
@@ -157,6 +171,7 @@ void* remoteStatusThreadHandler(void* threadInfo)
   LOG_REMOTE_CMD_EVENT(REMOTE_BIST_COMPLETE);
   LOG_REMOTE_CMD_EVENT(REMOTE_INIT_SUCCESS);
 
+  clock_gettime(CLOCK_REALTIME, &linkStatsTime);
   while(aliveFlag) {
     statusMsgCount = 0;
 
@@ -185,7 +200,7 @@ void* remoteStatusThreadHandler(void* threadInfo)
     }
 
     /* Check for incoming status packets from remote clients on socket port */
-    clientResponse = recv(sockfdStatusClient, &statusPacket, statusPacketSize, 0);
+    clientResponse = recv(sockfdStatusClient, &rxPacket, statusPacketSize, 0);
     if (clientResponse == -1)
     {
       /* Non-blocking logic to allow remoteStatusThread to report status while waiting for client cmd */
@@ -208,9 +223,20 @@ void* remoteStatusThreadHandler(void* threadInfo)
       LOG_REMOTE_STATUS_EVENT(REMOTE_EVENT_INVALID_RECV);
     }
     /* Received Msg is the expected size for a statusPacket */
+    /* TIVA heartbeats merged over a summary period, one per task */
+    else if(rxPacket.header == STATUS_SUMMARY_HEADER) {
+      clientResponse = forwardSummary(sockfdStatusClient, &rxPacket, hbMsgQueue);
+      if(clientResponse > 0) {
+        ++linkPackets;
+        linkBytes += clientResponse;
+      }
+    }
     else {
       /* Receive status packets from TIVA tasks, push onto heartbeat queue */
+      memcpy(&statusPacket, &rxPacket, statusPacketSize);
       SEND_STATUS_MSG(hbMsgQueue, statusPacket.processId, statusPacket.taskStatus, statusPacket.errorCode);
+      ++linkPackets;
+      linkBytes += statusPacketSize;
     }
 
     /* calculate delta time (since last status msg TX) */
@@ -225,6 +251,16 @@ void* remoteStatusThreadHandler(void* threadInfo)
         clock_gettime(CLOCK_REALTIME, &lastStatusMsgTime);
     }
 
+    /* status link load, packets are TIVA sends */
+    if((currentTime.tv_sec - linkStatsTime.tv_sec) >= STATUS_LINK_STATS_SEC) {
+      deltaTime = (currentTime.tv_sec - linkStatsTime.tv_sec) + ((currentTime.tv_nsec - linkStatsTime.tv_nsec) * 1e-9);
+      snprintf(linkStats, sizeof(linkStats), "status link %.2f pkt/s %.1f B/s", linkPackets / deltaTime, linkBytes / deltaTime);
+      LOG_INFO(linkStats);
+      linkPackets = 0;
+      linkBytes = 0;
+      linkStatsTime = currentTime;
+    }
+
     sigwait(&set, &signum);
   }
 
@@ -234,15 +270,12 @@ void* remoteStatusThreadHandler(void* threadInfo)
   timer_delete(timerid);
   mq_close(logMsgQueue);
   mq_close(hbMsgQueue);
-  shutdown(sockfdStatusClient, SHUT_RDWR);
-  shutdown(sockfdStatusServer, SHUT_RDWR);
-  sleep(1);
-  uint8_t closeCnt = 0;
-  while(closeCnt++ < 8) {
+  if(sockfdStatusClient >= 0) {
+    shutdown(sockfdStatusClient, SHUT_RDWR);
     close(sockfdStatusClient);
-    close(sockfdStatusServer);
-    usleep(100000);
   }
+  shutdown(sockfdStatusServer, SHUT_RDWR);
+  close(sockfdStatusServer);
   return NULL;
 }
 
@@ -268,3 +301,44 @@ void remoteStatusGetAliveFlag(uint8_t *pAlive)
 /*---------------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------------*/
+/**
+ * @brief receive the rest of a summary packet whose first
+ * sizeof(TaskStatusPacket) bytes are in pPacket, and send a heartbeat for
+ * each task in it
+ *
+ * @param sockfd client socket
+ * @param pPacket start of summary, the rest is received into it
+ * @param hbMsgQueue heartbeat queue
+ * @return ssize_t summary size, -1 if it was malformed
+ */
+static ssize_t forwardSummary(int sockfd, StatusSummaryPacket *pPacket, mqd_t hbMsgQueue)
+{
+  size_t len = sizeof(TaskStatusPacket);
+  ssize_t rest;
+  uint8_t ind;
+
+  if((pPacket->numTasks == 0) || (pPacket->numTasks > STATUS_SUMMARY_MAX_TASKS)) {
+    ERROR_PRINT("remoteStatusThread received summary of %d tasks.\n", pPacket->numTasks);
+    LOG_REMOTE_STATUS_EVENT(REMOTE_EVENT_INVALID_RECV);
+    return -1;
+  }
+  if(STATUS_SUMMARY_SIZE(pPacket->numTasks) > len) {
+    rest = recv(sockfd, (uint8_t *)pPacket + len, STATUS_SUMMARY_SIZE(pPacket->numTasks) - len, MSG_WAITALL);
+    if(rest > 0)
+      len += rest;
+  }
+  if(!status_summary_valid(pPacket, len)) {
+    ERROR_PRINT("remoteStatusThread received malformed status summary.\n");
+    LOG_REMOTE_STATUS_EVENT(REMOTE_EVENT_INVALID_RECV);
+    return -1;
+  }
+
+  for(ind = 0; ind < pPacket->numTasks; ++ind) {
+    MUTED_PRINT("summary %s: %d OK from %u to %u\n", getPidString(pPacket->tasks[ind].processId),
+                pPacket->tasks[ind].count, pPacket->tasks[ind].firstTimestamp, pPacket->tasks[ind].lastTimestamp);
+    SEND_STATUS_MSG(hbMsgQueue, (ProcessId_e)pPacket->tasks[ind].processId, STATUS_OK, pPacket->tasks[ind].errorCode);
+  }
+  return (ssize_t)len;
+}
+
+/*---------------------------------------------------------------------------------*/
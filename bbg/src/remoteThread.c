@@ -36,6 +36,8 @@
 #include "platform.h"
 #include "healthMonitor.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_REMOTE_THREAD);
+
 #define MAX_CLIENTS (5)
 
 /* Prototypes for private/helper functions */
@@ -0,0 +1,93 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 9, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file statusSummary.c
+ * @brief coalesce STATUS_OK task status msgs on the status link
+ *
+ ************************************************************************************
+ */
+
+#include <string.h>
+
+#include "statusSummary.h"
+
+/*---------------------------------------------------------------------------------*/
+void status_summary_init(StatusCoalescer_t *pCo)
+{
+    memset(pCo, 0, sizeof(StatusCoalescer_t));
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t status_summary_add(StatusCoalescer_t *pCo, const TaskStatusPacket *pStatus)
+{
+    TaskStatusSummary *pSum;
+
+    if((pStatus->taskStatus != STATUS_OK) || (pStatus->processId >= PID_END))
+        return 1;
+
+    pSum = &pCo->tasks[pStatus->processId];
+    if(pSum->count == 0) {
+        pSum->processId = (uint8_t)pStatus->processId;
+        pSum->firstTimestamp = pStatus->timestamp;
+    }
+    /* saturate rather than wrap; the count is informational */
+    if(pSum->count != UINT16_MAX)
+        ++pSum->count;
+    pSum->lastTimestamp = pStatus->timestamp;
+    pSum->errorCode = pStatus->errorCode;
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t status_summary_flush(StatusCoalescer_t *pCo, StatusSummaryPacket *pPacket)
+{
+    uint32_t used;
+    uint8_t ind, num = 0;
+
+    for(ind = 0; (ind < PID_END) && (num < STATUS_SUMMARY_MAX_TASKS); ++ind)
+    {
+        if(pCo->tasks[ind].count == 0)
+            continue;
+        pPacket->tasks[num++] = pCo->tasks[ind];
+        pCo->tasks[ind].count = 0;
+    }
+    if(num == 0)
+        return 0;
+
+    pPacket->header = STATUS_SUMMARY_HEADER;
+    pPacket->numTasks = num;
+    pPacket->reserved = 0;
+
+    /* short packets are padded out to a TaskStatusPacket */
+    used = offsetof(StatusSummaryPacket, tasks) + (num * sizeof(TaskStatusSummary));
+    if(STATUS_SUMMARY_SIZE(num) > used)
+        memset((uint8_t *)pPacket + used, 0, STATUS_SUMMARY_SIZE(num) - used);
+    return STATUS_SUMMARY_SIZE(num);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint8_t status_summary_valid(const StatusSummaryPacket *pPacket, uint32_t len)
+{
+    uint8_t ind;
+
+    if((len < sizeof(TaskStatusPacket)) || (pPacket->header != STATUS_SUMMARY_HEADER) ||
+       (pPacket->numTasks == 0) || (pPacket->numTasks > STATUS_SUMMARY_MAX_TASKS) ||
+       (len != STATUS_SUMMARY_SIZE(pPacket->numTasks)))
+        return 0;
+
+    for(ind = 0; ind < pPacket->numTasks; ++ind)
+    {
+        if((pPacket->tasks[ind].processId >= PID_END) || (pPacket->tasks[ind].count == 0))
+            return 0;
+    }
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,390 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 8, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file supervisor.c
+ * @brief re-create failed threads with restart rate limiting and backoff
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <syscall.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "healthMonitor.h"
+#include "supervisor.h"
+#include "logger.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_SUPERVISOR);
+
+#define SUPERVISOR_IDLE_USEC    (1000000)   /* longest wait with nothing pending */
+
+typedef struct {
+    ProcessId_e Id;
+    supervisedFunc_t handler;
+    void *pInfo;
+    pthread_t *pThread;
+    SupervisorState_e state;
+    uint8_t alive;              /* created and not joined */
+    uint8_t exited;             /* handler returned, not joined yet */
+    uint32_t restarts;
+    uint32_t windowRestarts;    /* restarts since windowStart */
+    uint64_t windowStart;
+    uint64_t startTime;         /* last created */
+    uint64_t exitTime;          /* handler last returned */
+    uint64_t restartAt;
+    uint32_t backoffUsec;
+    uint32_t lastRecoveryUsec;
+} Supervised_t;
+
+static Supervised_t supervised[PID_END];
+static uint8_t aliasOf[PID_END];            /* Id + 1 of the thread doing an alias's work, 0 if none */
+static pthread_mutex_t supervisorLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t supervisorWake;
+static pthread_t supervisorThread;
+static uint8_t *pAppExit = NULL;
+static uint8_t supervisorRunning = 0;
+
+static void *supervisorThreadHandler(void *pArg);
+static void *supervisedEntry(void *pArg);
+static int8_t createThread(Supervised_t *pSup, uint64_t now);
+static void scheduleRestart(Supervised_t *pSup, uint64_t now);
+static uint64_t usecNow(void);
+static ProcessId_e resolveAlias(ProcessId_e Id);
+
+/*---------------------------------------------------------------------------------*/
+int8_t supervisor_init(uint8_t *pExit)
+{
+    pthread_condattr_t condAttr;
+
+    if(pExit == NULL)
+        return EXIT_FAILURE;
+    pAppExit = pExit;
+
+    /* backoff deadlines are CLOCK_MONOTONIC so a clock change can't stall them */
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&supervisorWake, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+
+    supervisorRunning = 1;
+    if(pthread_create(&supervisorThread, NULL, supervisorThreadHandler, NULL) != 0) {
+        ERRNO_PRINT("supervisor_init couldn't create supervisor thread");
+        supervisorRunning = 0;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t supervisor_start(ProcessId_e Id, supervisedFunc_t handler, void *pInfo, pthread_t *pThread)
+{
+    Supervised_t *pSup;
+    uint64_t now = usecNow();
+    int8_t ret;
+
+    if((Id >= PID_END) || (handler == NULL) || (pThread == NULL))
+        return EXIT_FAILURE;
+
+    pthread_mutex_lock(&supervisorLock);
+    pSup = &supervised[Id];
+    if(pSup->alive) {
+        pthread_mutex_unlock(&supervisorLock);
+        ERROR_PRINT("supervisor_start %s already running\n", getPidString(Id));
+        return EXIT_FAILURE;
+    }
+    memset(pSup, 0, sizeof(Supervised_t));
+    pSup->Id = Id;
+    pSup->handler = handler;
+    pSup->pInfo = pInfo;
+    pSup->pThread = pThread;
+    pSup->backoffUsec = SUPERVISOR_BACKOFF_MIN_USEC;
+    pSup->windowStart = now;
+    ret = createThread(pSup, now);
+    if(ret != EXIT_SUCCESS)
+        pSup->state = SUPERVISOR_NONE;
+    pthread_mutex_unlock(&supervisorLock);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t supervisor_restart(ProcessId_e Id)
+{
+    Supervised_t *pSup;
+    int8_t ret = EXIT_SUCCESS;
+
+    if(Id >= PID_END)
+        return EXIT_FAILURE;
+
+    pthread_mutex_lock(&supervisorLock);
+    Id = resolveAlias(Id);
+    pSup = &supervised[Id];
+    switch(pSup->state) {
+        case SUPERVISOR_RUNNING:
+        pSup->state = SUPERVISOR_STOPPING;
+        pthread_kill(*pSup->pThread, SIGRTMIN + (uint8_t)Id);
+        break;
+        case SUPERVISOR_STOPPING:
+        case SUPERVISOR_BACKOFF:
+        /* already on its way */
+        break;
+        default:
+        ret = EXIT_FAILURE;
+        break;
+    }
+    pthread_mutex_unlock(&supervisorLock);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t supervisor_terminate(ProcessId_e Id)
+{
+    Supervised_t *pSup;
+    int8_t ret = EXIT_SUCCESS;
+
+    if(Id >= PID_END)
+        return EXIT_FAILURE;
+
+    pthread_mutex_lock(&supervisorLock);
+    Id = resolveAlias(Id);
+    pSup = &supervised[Id];
+    if(pSup->state == SUPERVISOR_NONE) {
+        ret = EXIT_FAILURE;
+    }
+    else {
+        pSup->state = SUPERVISOR_TERMINATED;
+        if(pSup->alive && !pSup->exited)
+            pthread_kill(*pSup->pThread, SIGRTMIN + (uint8_t)Id);
+    }
+    pthread_mutex_unlock(&supervisorLock);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+void supervisor_info(ProcessId_e Id, SupervisorInfo_t *pInfo)
+{
+    memset(pInfo, 0, sizeof(SupervisorInfo_t));
+    if(Id >= PID_END)
+        return;
+
+    pthread_mutex_lock(&supervisorLock);
+    Id = resolveAlias(Id);
+    pInfo->state = supervised[Id].state;
+    pInfo->restarts = supervised[Id].restarts;
+    pInfo->backoffUsec = supervised[Id].backoffUsec;
+    pInfo->lastRecoveryUsec = supervised[Id].lastRecoveryUsec;
+    pthread_mutex_unlock(&supervisorLock);
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t supervisor_alias(ProcessId_e alias, ProcessId_e Id)
+{
+    if((alias >= PID_END) || (Id >= PID_END) || (alias == Id))
+        return EXIT_FAILURE;
+
+    pthread_mutex_lock(&supervisorLock);
+    aliasOf[alias] = (uint8_t)Id + 1;
+    pthread_mutex_unlock(&supervisorLock);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+void supervisor_stop(void)
+{
+    uint8_t wasRunning;
+
+    pthread_mutex_lock(&supervisorLock);
+    wasRunning = supervisorRunning;
+    supervisorRunning = 0;
+    pthread_cond_signal(&supervisorWake);
+    pthread_mutex_unlock(&supervisorLock);
+
+    if(wasRunning)
+        pthread_join(supervisorThread, NULL);
+}
+
+/*---------------------------------------------------------------------------------*/
+void supervisor_join(ProcessId_e Id)
+{
+    uint8_t alive;
+
+    if(Id >= PID_END)
+        return;
+
+    /* supervisor thread is stopped, nothing else joins; don't hold the
+     * lock, the thread takes it on the way out */
+    pthread_mutex_lock(&supervisorLock);
+    alive = supervised[Id].alive;
+    pthread_mutex_unlock(&supervisorLock);
+    if(alive) {
+        pthread_join(*supervised[Id].pThread, NULL);
+        pthread_mutex_lock(&supervisorLock);
+        supervised[Id].alive = 0;
+        pthread_mutex_unlock(&supervisorLock);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief join threads whose handler returned and re-create them once their
+ * backoff has passed; sleeps until the next restart is due or a thread exits
+ */
+static void *supervisorThreadHandler(void *pArg)
+{
+    Supervised_t *pSup;
+    struct timespec wakeAt;
+    uint64_t now, next;
+    uint8_t ind;
+
+    pthread_mutex_lock(&supervisorLock);
+    while(supervisorRunning)
+    {
+        now = usecNow();
+        next = now + SUPERVISOR_IDLE_USEC;
+        for(ind = 0; ind < PID_END; ++ind)
+        {
+            pSup = &supervised[ind];
+
+            /* the handler has returned, so this join doesn't wait on the lock */
+            if(pSup->exited) {
+                pthread_join(*pSup->pThread, NULL);
+                pSup->exited = 0;
+                pSup->alive = 0;
+                if((*pAppExit == 0) || (pSup->state == SUPERVISOR_TERMINATED)) {
+                    pSup->state = SUPERVISOR_TERMINATED;
+                }
+                else {
+                    if(pSup->state == SUPERVISOR_RUNNING) {
+                        WARN_PRINT("supervisor: %s exited on its own\n", getPidString(pSup->Id));
+                    }
+                    scheduleRestart(pSup, now);
+                }
+            }
+
+            if(pSup->state == SUPERVISOR_BACKOFF) {
+                if(*pAppExit == 0)
+                    pSup->state = SUPERVISOR_TERMINATED;
+                else if(now >= pSup->restartAt)
+                    createThread(pSup, now);
+                else if(pSup->restartAt < next)
+                    next = pSup->restartAt;
+            }
+        }
+
+        wakeAt.tv_sec = (time_t)(next / 1000000);
+        wakeAt.tv_nsec = (long)((next % 1000000) * 1000);
+        pthread_cond_timedwait(&supervisorWake, &supervisorLock, &wakeAt);
+    }
+    pthread_mutex_unlock(&supervisorLock);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief run a supervised thread's handler, then tell the supervisor
+ */
+static void *supervisedEntry(void *pArg)
+{
+    Supervised_t *pSup = (Supervised_t *)pArg;
+
+    pSup->handler(pSup->pInfo);
+
+    pthread_mutex_lock(&supervisorLock);
+    pSup->exited = 1;
+    pSup->exitTime = usecNow();
+    pthread_cond_signal(&supervisorWake);
+    pthread_mutex_unlock(&supervisorLock);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief create (or re-create) a thread; supervisor lock held. New threads
+ * get the creator's signal mask, main's before its timer was set up.
+ */
+static int8_t createThread(Supervised_t *pSup, uint64_t now)
+{
+    uint8_t restart = (pSup->exitTime != 0);
+
+    if(pthread_create(pSup->pThread, NULL, supervisedEntry, pSup) != 0) {
+        ERRNO_PRINT("supervisor couldn't create thread");
+        if(restart)
+            scheduleRestart(pSup, now);
+        return EXIT_FAILURE;
+    }
+    pSup->alive = 1;
+    pSup->state = SUPERVISOR_RUNNING;
+    pSup->startTime = now;
+
+    if(restart) {
+        ++pSup->restarts;
+        pSup->lastRecoveryUsec = (uint32_t)(now - pSup->exitTime);
+        INFO_PRINT("supervisor restarted %s (%u), down %u usec\n",
+                   getPidString(pSup->Id), pSup->restarts, pSup->lastRecoveryUsec);
+        LOG_MAIN_EVENT(MAIN_EVENT_RESTART_THREAD);
+
+        /* next restart waits twice as long, unless this one runs stable */
+        pSup->backoffUsec = (pSup->backoffUsec >= (SUPERVISOR_BACKOFF_MAX_USEC / 2)) ?
+                            SUPERVISOR_BACKOFF_MAX_USEC : (pSup->backoffUsec * 2);
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief queue a restart after the thread's backoff, or give up on it if it
+ * has used its restarts for this window; supervisor lock held
+ */
+static void scheduleRestart(Supervised_t *pSup, uint64_t now)
+{
+    if((now - pSup->startTime) >= SUPERVISOR_STABLE_USEC)
+        pSup->backoffUsec = SUPERVISOR_BACKOFF_MIN_USEC;
+    if((now - pSup->windowStart) >= SUPERVISOR_WINDOW_USEC) {
+        pSup->windowStart = now;
+        pSup->windowRestarts = 0;
+    }
+
+    if(pSup->windowRestarts >= SUPERVISOR_MAX_RESTARTS) {
+        ERROR_PRINT("supervisor: %s restarted %u times in %u sec, leaving it down\n",
+                    getPidString(pSup->Id), pSup->windowRestarts, SUPERVISOR_WINDOW_USEC / 1000000);
+        pSup->state = SUPERVISOR_GAVE_UP;
+        return;
+    }
+    ++pSup->windowRestarts;
+    pSup->restartAt = now + pSup->backoffUsec;
+    pSup->state = SUPERVISOR_BACKOFF;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + (now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief thread an Id's requests go to; supervisor lock held
+ */
+static ProcessId_e resolveAlias(ProcessId_e Id)
+{
+    return (aliasOf[Id] != 0) ? (ProcessId_e)(aliasOf[Id] - 1) : Id;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,65 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 18, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file telemetrySeq.c
+ * @brief loss, reorder and duplicate accounting of a node's UDP telemetry
+ *
+ ************************************************************************************
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "telemetrySeq.h"
+
+/*---------------------------------------------------------------------------------*/
+void telemetry_seq_init(TelemetrySeq_t *pSeq)
+{
+    memset(pSeq, 0, sizeof(TelemetrySeq_t));
+}
+
+/*---------------------------------------------------------------------------------*/
+TelemetrySeq_e telemetry_seq_update(TelemetrySeq_t *pSeq, uint32_t seq)
+{
+    int32_t ahead = (int32_t)(seq - pSeq->newest);   /* wraps with seq */
+    uint64_t bit;
+
+    ++pSeq->received;
+
+    /* first from this node, or it has started over */
+    if((pSeq->window == 0) || (ahead <= -TELEMETRY_SEQ_WINDOW)) {
+        if(pSeq->window != 0)
+            ++pSeq->restarts;
+        pSeq->newest = seq;
+        pSeq->window = 1;
+        return TELEMETRY_SEQ_NEW;
+    }
+
+    /* newest yet; any skipped over are lost until they turn up */
+    if(ahead > 0) {
+        pSeq->lost += (uint32_t)ahead - 1;
+        pSeq->window = (ahead < TELEMETRY_SEQ_WINDOW) ? ((pSeq->window << ahead) | 1) : 1;
+        pSeq->newest = seq;
+        return TELEMETRY_SEQ_NEW;
+    }
+
+    bit = 1ULL << (uint32_t)(-ahead);
+    if(pSeq->window & bit) {
+        ++pSeq->duplicates;
+        return TELEMETRY_SEQ_DUPLICATE;
+    }
+    pSeq->window |= bit;
+    ++pSeq->late;
+    if(pSeq->lost != 0)
+        --pSeq->lost;
+    return TELEMETRY_SEQ_LATE;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -35,6 +35,8 @@
 #include "platform.h"
 #include "healthMonitor.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_TEMP_THREAD);
+
 #define TEMP_ERR_COUNT_LIMIT  (1)
 #define INIT_TEMP_AVG_COUNT   (8)
 #define INIT_THRESHOLD_PAD    (2)
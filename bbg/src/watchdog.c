@@ -0,0 +1,471 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 11, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file watchdog.c
+ * @brief watchdog feeder gated on main and required threads, stall reports
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <syscall.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <linux/watchdog.h>
+
+#if defined(__GLIBC__) && !defined(__UCLIBC__)
+    #include <execinfo.h>
+    #define WATCHDOG_HAVE_BACKTRACE
+#elif defined(__arm__)
+    #include <ucontext.h>
+#endif
+
+#include "my_debug.h"
+#include "watchdog.h"
+#include "heartbeat.h"
+#include "healthMonitor.h"
+#include "supervisor.h"
+#include "logger_helper.h"
+
+#define WATCHDOG_EPOLL_TIMER        (0)
+#define WATCHDOG_EPOLL_STOP         (1)
+#define WATCHDOG_TRACE_MAIN         (PID_END)       /* traces[] slot of main */
+#define WATCHDOG_TRACE_POLL_USEC    (1000)
+#define WATCHDOG_FEED_CHAR          ('k')       /* drivers take any byte as a feed */
+#define WATCHDOG_MAGIC_CLOSE        ('V')       /* and this one before close as disarm */
+
+typedef struct {
+    uint32_t tid;
+    int32_t depth;                          /* frames recorded, -1 until the handler ran */
+    void *frames[WATCHDOG_TRACE_DEPTH];
+} WatchdogTrace_t;
+
+/* private functions */
+static void traceHandler(int sig, siginfo_t *pInfo, void *pContext);
+static void takeTrace(WatchdogTrace_t *pTrace, uint32_t tid);
+static uint32_t requiredStale(Watchdog_t *pDog);
+static void feed(Watchdog_t *pDog);
+static void writeReport(Watchdog_t *pDog, uint32_t stalled);
+static void reportf(const char *pFmt, ...) __attribute__((format(printf, 1, 2)));
+static void reportTrace(const char *pName, WatchdogTrace_t *pTrace);
+static void closeWatchdog(Watchdog_t *pDog);
+
+extern char __executable_start;             /* linker defined, start of the exe's mapping */
+extern char etext;
+
+static uint32_t mainCheckin;                /* heartbeat_now() of main's last checkin */
+static uint32_t mainTid;
+static __thread uint32_t checkinTid = 0;
+
+/* everything a report needs is allocated up front */
+static WatchdogTrace_t traces[PID_END + 1];
+static WatchdogTrace_t *pPendingTrace = NULL;
+static logLastItem_t lastItems[LOG_LAST_SLOTS];
+static char report[WATCHDOG_FORENSICS_SIZE];
+static uint32_t reportLen;
+
+/*---------------------------------------------------------------------------------*/
+int8_t watchdog_init(Watchdog_t *pDog, const char *pDevice, const char *pForensics,
+                     uint32_t requiredMask, uint32_t stallUsec, mqd_t *pQueues)
+{
+    struct epoll_event event;
+    struct sigaction action;
+    int timeout = WATCHDOG_TIMEOUT_SEC;
+
+    memset(pDog, 0, sizeof(Watchdog_t));
+    pDog->deviceFd = -1;
+    pDog->forensicsFd = -1;
+    pDog->requiredMask = requiredMask;
+    pDog->stallUsec = stallUsec;
+    pDog->feedUsec = WATCHDOG_FEED_USEC;
+    if(pQueues != NULL) {
+        pDog->numQueues = SNAPSHOT_QUEUE_END;
+        memcpy(pDog->queues, pQueues, sizeof(pDog->queues));
+    }
+    __atomic_store_n(&mainCheckin, heartbeat_now(), __ATOMIC_RELEASE);
+    __atomic_store_n(&mainTid, (uint32_t)syscall(SYS_gettid), __ATOMIC_RELEASE);
+
+    /* backtrace() loads its unwinder the first time, do that now rather
+     * than in a signal handler during a stall */
+#ifdef WATCHDOG_HAVE_BACKTRACE
+    backtrace(traces[0].frames, WATCHDOG_TRACE_DEPTH);
+#endif
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_sigaction = traceHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if(sigaction(WATCHDOG_SIGNAL, &action, NULL) < 0) {
+        ERRNO_PRINT("watchdog_init couldn't install trace handler");
+        return EXIT_FAILURE;
+    }
+
+    pDog->epollFd = epoll_create1(0);
+    pDog->timerFd = timerfd_create(CLOCK_MONOTONIC, 0);
+    pDog->stopFd = eventfd(0, 0);
+    if((pDog->epollFd < 0) || (pDog->timerFd < 0) || (pDog->stopFd < 0)) {
+        ERRNO_PRINT("watchdog_init couldn't create fds");
+        closeWatchdog(pDog);
+        return EXIT_FAILURE;
+    }
+    event.events = EPOLLIN;
+    event.data.u32 = WATCHDOG_EPOLL_TIMER;
+    epoll_ctl(pDog->epollFd, EPOLL_CTL_ADD, pDog->timerFd, &event);
+    event.data.u32 = WATCHDOG_EPOLL_STOP;
+    epoll_ctl(pDog->epollFd, EPOLL_CTL_ADD, pDog->stopFd, &event);
+
+    if(pForensics != NULL) {
+        pDog->forensicsFd = open(pForensics, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if(pDog->forensicsFd < 0)
+            ERRNO_PRINT("watchdog_init couldn't open forensics file, stalls only printed");
+    }
+
+    /* opening the device arms it, from here it has to be fed */
+    if(pDevice != NULL) {
+        pDog->deviceFd = open(pDevice, O_WRONLY | O_CLOEXEC);
+        if(pDog->deviceFd < 0) {
+            ERRNO_PRINT("watchdog_init couldn't open watchdog device");
+            closeWatchdog(pDog);
+            return EXIT_FAILURE;
+        }
+        if(ioctl(pDog->deviceFd, WDIOC_SETTIMEOUT, &timeout) < 0)
+            WARN_PRINT("watchdog_init couldn't set timeout of %s, not a watchdog?\n", pDevice);
+        else if((uint64_t)timeout * 1000000ULL <= (uint64_t)stallUsec + pDog->feedUsec)
+            WARN_PRINT("watchdog timeout %d s fires before a stall is reported\n", timeout);
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+void watchdog_checkin(void)
+{
+    if(checkinTid == 0) {
+        checkinTid = (uint32_t)syscall(SYS_gettid);
+        __atomic_store_n(&mainTid, checkinTid, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&mainCheckin, heartbeat_now(), __ATOMIC_RELEASE);
+}
+
+/*---------------------------------------------------------------------------------*/
+uint32_t watchdog_check(Watchdog_t *pDog)
+{
+    uint32_t stalled = requiredStale(pDog);
+
+    if((heartbeat_now() - __atomic_load_n(&mainCheckin, __ATOMIC_ACQUIRE)) > pDog->stallUsec)
+        stalled |= WATCHDOG_MAIN_STALLED;
+    return stalled;
+}
+
+/*---------------------------------------------------------------------------------*/
+void *watchdogThreadHandler(void *pArg)
+{
+    Watchdog_t *pDog = (Watchdog_t *)pArg;
+    struct epoll_event events[2];
+    struct itimerspec period;
+    uint64_t expirations;
+    uint32_t stalled;
+    uint8_t running = 1;
+    char magic = WATCHDOG_MAGIC_CLOSE;
+    int num, ind;
+
+    memset(&period, 0, sizeof(struct itimerspec));
+    period.it_interval.tv_sec = pDog->feedUsec / 1000000;
+    period.it_interval.tv_nsec = (pDog->feedUsec % 1000000) * 1000;
+    period.it_value = period.it_interval;
+    if(timerfd_settime(pDog->timerFd, 0, &period, NULL) < 0) {
+        ERRNO_PRINT("watchdog couldn't start feed timer");
+        closeWatchdog(pDog);
+        return NULL;
+    }
+
+    feed(pDog);
+    while(running)
+    {
+        num = epoll_wait(pDog->epollFd, events, 2, -1);
+        if(num < 0) {
+            if(errno == EINTR)
+                continue;
+            ERRNO_PRINT("watchdog epoll_wait");
+            break;
+        }
+
+        for(ind = 0; ind < num; ++ind)
+        {
+            if(events[ind].data.u32 == WATCHDOG_EPOLL_STOP) {
+                running = 0;
+                continue;
+            }
+            if(read(pDog->timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+                continue;
+
+            stalled = watchdog_check(pDog);
+            if(stalled == 0) {
+                if(pDog->stalled != 0)
+                    INFO_PRINT("watchdog: stall cleared, feeding again\n");
+                pDog->stalled = 0;
+                feed(pDog);
+            }
+            else if(pDog->stalled == 0) {
+                /* report once per stall; not feeding lets the device reset */
+                pDog->stalled = stalled;
+                ++pDog->stalls;
+                writeReport(pDog, stalled);
+            }
+        }
+    }
+
+    /* clean exit, disarm */
+    if((pDog->deviceFd >= 0) && (write(pDog->deviceFd, &magic, 1) != 1))
+        ERRNO_PRINT("watchdog couldn't disarm device");
+    closeWatchdog(pDog);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+void watchdog_stop(Watchdog_t *pDog)
+{
+    uint64_t one = 1;
+
+    if(write(pDog->stopFd, &one, sizeof(one)) != sizeof(one))
+        ERRNO_PRINT("watchdog_stop couldn't signal watchdog thread");
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief record the interrupted thread's stack, if it is the one asked for
+ */
+static void traceHandler(int sig, siginfo_t *pInfo, void *pContext)
+{
+    WatchdogTrace_t *pTrace = __atomic_load_n(&pPendingTrace, __ATOMIC_ACQUIRE);
+    int savedErrno = errno;
+    int32_t depth = 0;
+
+    /* claim the request so a late signal can't write to a trace being reported */
+    if((pTrace == NULL) || (pTrace->tid != (uint32_t)syscall(SYS_gettid)) ||
+       !__atomic_compare_exchange_n(&pPendingTrace, &pTrace, NULL, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        errno = savedErrno;
+        return;
+    }
+
+#ifdef WATCHDOG_HAVE_BACKTRACE
+    depth = backtrace(pTrace->frames, WATCHDOG_TRACE_DEPTH);
+#elif defined(__arm__)
+    /* no unwinder in uClibc, where it was and where it would return to */
+    pTrace->frames[0] = (void *)((ucontext_t *)pContext)->uc_mcontext.arm_pc;
+    pTrace->frames[1] = (void *)((ucontext_t *)pContext)->uc_mcontext.arm_lr;
+    depth = 2;
+#endif
+    __atomic_store_n(&pTrace->depth, depth, __ATOMIC_RELEASE);
+    errno = savedErrno;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief signal a thread and wait up to WATCHDOG_TRACE_WAIT_USEC for its
+ * trace; a thread stuck in the kernel leaves depth at -1
+ */
+static void takeTrace(WatchdogTrace_t *pTrace, uint32_t tid)
+{
+    WatchdogTrace_t *pExpect = pTrace;
+    uint32_t waited = 0;
+
+    pTrace->tid = tid;
+    pTrace->depth = -1;
+    __atomic_store_n(&pPendingTrace, pTrace, __ATOMIC_RELEASE);
+    if(syscall(SYS_tgkill, getpid(), tid, WATCHDOG_SIGNAL) == 0) {
+        while((__atomic_load_n(&pTrace->depth, __ATOMIC_ACQUIRE) < 0) && (waited < WATCHDOG_TRACE_WAIT_USEC)) {
+            usleep(WATCHDOG_TRACE_POLL_USEC);
+            waited += WATCHDOG_TRACE_POLL_USEC;
+        }
+    }
+
+    /* withdraw the request; if the handler got it first it is about to finish */
+    if(!__atomic_compare_exchange_n(&pPendingTrace, &pExpect, NULL, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        while(__atomic_load_n(&pTrace->depth, __ATOMIC_ACQUIRE) < 0)
+            sched_yield();
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief required threads past the deadline, leaving out ones the supervisor
+ * is restarting or was told to stop
+ */
+static uint32_t requiredStale(Watchdog_t *pDog)
+{
+    SupervisorInfo_t info;
+    uint32_t stale = heartbeat_stale(pDog->requiredMask, pDog->stallUsec);
+    uint8_t ind;
+
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(!(stale & (1UL << ind)))
+            continue;
+        supervisor_info((ProcessId_e)ind, &info);
+        if((info.state == SUPERVISOR_STOPPING) || (info.state == SUPERVISOR_BACKOFF) ||
+           (info.state == SUPERVISOR_TERMINATED))
+            stale &= ~(1UL << ind);
+    }
+    return stale;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void feed(Watchdog_t *pDog)
+{
+    char keepalive = WATCHDOG_FEED_CHAR;
+
+    ++pDog->feeds;
+    if((pDog->deviceFd >= 0) && (write(pDog->deviceFd, &keepalive, 1) != 1))
+        ERRNO_PRINT("watchdog feed");
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief build the stall report in the static buffer, then print and write it
+ */
+static void writeReport(Watchdog_t *pDog, uint32_t stalled)
+{
+    HeartbeatSlot_t slot;
+    struct mq_attr attr;
+    uint32_t now = heartbeat_now(), logNow = log_get_time();
+    uint32_t tid = __atomic_load_n(&mainTid, __ATOMIC_ACQUIRE);
+    uint8_t ind, numItems, pid;
+
+    reportLen = 0;
+    reportf("stall %u: main last checked in %u usec ago%s\n", pDog->stalls,
+            now - __atomic_load_n(&mainCheckin, __ATOMIC_ACQUIRE),
+            (stalled & WATCHDOG_MAIN_STALLED) ? ", STALLED" : "");
+    reportf("stalled threads:");
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(stalled & (1UL << ind))
+            reportf(" %s", getPidString((ProcessId_e)ind));
+    }
+    reportf("\n\nheartbeats:\n");
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if((heartbeat_read((ProcessId_e)ind, &slot) != EXIT_SUCCESS) || (slot.seq == 0))
+            continue;
+        reportf("  %-26s tid %5u  %10u usec ago  status %u  error %u%s\n", getPidString((ProcessId_e)ind),
+                slot.tid, now - slot.timestamp, slot.taskStatus, slot.errorCode,
+                (pDog->requiredMask & (1UL << ind)) ? "  required" : "");
+    }
+
+    if(pDog->numQueues != 0) {
+        reportf("\nqueue depths:");
+        for(ind = 0; ind < pDog->numQueues; ++ind)
+            reportf(" %d", (mq_getattr(pDog->queues[ind], &attr) == 0) ? (int32_t)attr.mq_curmsgs : -1);
+        reportf("  (log heartbeat data cmd)\n");
+    }
+
+    reportf("\nlast logged:\n");
+    numItems = log_last_items(lastItems, LOG_LAST_SLOTS);
+    for(ind = 0; ind < numItems; ++ind)
+    {
+        reportf("  source %5u  %s:%u  msg %u  %u usec ago", lastItems[ind].sourceId,
+                log_file_name(lastItems[ind].fileId), lastItems[ind].lineNum, lastItems[ind].logMsgId,
+                logNow - lastItems[ind].time);
+        if(lastItems[ind].sourceId == (uint16_t)tid)
+            reportf("  (main)");
+        for(pid = 0; pid < PID_END; ++pid)
+        {
+            if((heartbeat_read((ProcessId_e)pid, &slot) == EXIT_SUCCESS) && (slot.seq != 0) &&
+               (lastItems[ind].sourceId == (uint16_t)slot.tid))
+                reportf("  (%s)", getPidString((ProcessId_e)pid));
+        }
+        reportf("\n");
+    }
+
+    reportf("\nbacktraces, exe offsets for addr2line:\n");
+    if(stalled & WATCHDOG_MAIN_STALLED) {
+        takeTrace(&traces[WATCHDOG_TRACE_MAIN], tid);
+        reportTrace("main", &traces[WATCHDOG_TRACE_MAIN]);
+    }
+    for(ind = 0; ind < PID_END; ++ind)
+    {
+        if(!(stalled & (1UL << ind)) || (heartbeat_read((ProcessId_e)ind, &slot) != EXIT_SUCCESS) ||
+           (slot.seq == 0))
+            continue;
+        takeTrace(&traces[ind], slot.tid);
+        reportTrace(getPidString((ProcessId_e)ind), &traces[ind]);
+    }
+
+    ERROR_PRINT("watchdog: stall detected, not feeding\n%s", report);
+    if(pDog->forensicsFd >= 0) {
+        if((pwrite(pDog->forensicsFd, report, reportLen, 0) != (ssize_t)reportLen) ||
+           (ftruncate(pDog->forensicsFd, reportLen) < 0))
+            ERRNO_PRINT("watchdog couldn't write forensics file");
+        fsync(pDog->forensicsFd);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static void reportf(const char *pFmt, ...)
+{
+    va_list args;
+    int len;
+
+    if(reportLen >= sizeof(report) - 1)
+        return;
+    va_start(args, pFmt);
+    len = vsnprintf(&report[reportLen], sizeof(report) - reportLen, pFmt, args);
+    va_end(args);
+    if(len > 0)
+        reportLen += ((uint32_t)len < sizeof(report) - reportLen) ? (uint32_t)len : (sizeof(report) - reportLen - 1);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void reportTrace(const char *pName, WatchdogTrace_t *pTrace)
+{
+    uintptr_t addr;
+    int32_t ind;
+
+    reportf("  %s (tid %u):%s\n", pName, pTrace->tid, (pTrace->depth < 0) ? " no reply" : "");
+    for(ind = 0; ind < pTrace->depth; ++ind)
+    {
+        addr = (uintptr_t)pTrace->frames[ind];
+        if((addr >= (uintptr_t)&__executable_start) && (addr < (uintptr_t)&etext))
+            reportf("    #%-2d %p  exe+0x%lx\n", (int)ind, pTrace->frames[ind],
+                    (unsigned long)(addr - (uintptr_t)&__executable_start));
+        else
+            reportf("    #%-2d %p\n", (int)ind, pTrace->frames[ind]);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static void closeWatchdog(Watchdog_t *pDog)
+{
+    if(pDog->deviceFd >= 0)
+        close(pDog->deviceFd);
+    if(pDog->forensicsFd >= 0)
+        close(pDog->forensicsFd);
+    if(pDog->epollFd >= 0)
+        close(pDog->epollFd);
+    if(pDog->timerFd >= 0)
+        close(pDog->timerFd);
+    if(pDog->stopFd >= 0)
+        close(pDog->stopFd);
+    pDog->deviceFd = -1;
+    pDog->forensicsFd = -1;
+    pDog->epollFd = -1;
+    pDog->timerFd = -1;
+    pDog->stopFd = -1;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,398 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 15, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_batch.c
+ * @brief TIVA log and status uplinks, a frame per packet vs batched
+ *
+ * usage: bench_batch [records] [rate] [seconds]
+ *
+ * This thread stands in for the TIVA's remoteLogTask or remoteStatusTask,
+ * connected to the remote server over loopback. Single sends each packet
+ * as sendSocketData() does, header then packet in two send()s; batched
+ * fills a FrameBatch_t as the tasks now do and sends it when another packet
+ * won't fit, or REMOTE_BATCH_DEADLINE_MS after its first. TCP_NODELAY, so
+ * each send() is its own segment, as FreeRTOS+TCP sends them.
+ *
+ * flat out - records sent as fast as the link takes them, timed until the
+ *            last is through the server: log packets off the log msg
+ *            queue, as the logging thread would take them, status packets
+ *            (STATUS_OK, so nothing is queued) in the heartbeat table.
+ *            On the TIVA the IP task's work is per send and per segment;
+ *            here that is the kernel's send path, in this thread's CPU.
+ *            Wire bytes add 54 of Ethernet, IPv4 and TCP headers per
+ *            segment, and the 100 Mbit/s limit follows from them.
+ * paced    - rate records/s for seconds, this thread's and the server's
+ *            CPU as a share of one core.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <mqueue.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "logger.h"
+#include "remoteServer.h"
+#include "heartbeat.h"
+#include "remoteFrame.h"
+#include "bench_server.h"
+
+#define DEFAULT_RECORDS         (100000)
+#define DEFAULT_RATE            (2000)
+#define DEFAULT_SECONDS         (3)
+#define BENCH_NODE_ID           (202)
+#define BENCH_LOG_FILE          (LOG_FILE_TIVA_LIGHT_THREAD)    /* counted off the queue, the server's own aren't */
+#define BENCH_STATUS_PID        (PID_MOISTURE)
+#define WIRE_HEADER_BYTES       (14 + 20 + 20)                  /* Ethernet, IPv4, TCP per segment */
+#define LINK_BYTES_PER_SEC      (100000000 / 8)
+#define DRAIN_TIMEOUT_USEC      (30000000)
+
+typedef enum {
+    LINK_LOG = 0,
+    LINK_STATUS,
+    LINK_END
+} Link_e;
+
+typedef struct {
+    Link_e link;
+    uint8_t batched;
+    /* flat out */
+    double recPerSec;
+    double sendUsecPerRec;              /* this thread, kernel send path included */
+    double serverUsecPerRec;
+    double sendsPerRec;
+    double wirePerRec;
+    uint8_t complete;                   /* every record came through */
+    /* paced */
+    double sendCpuPct;
+    double serverCpuPct;
+} Run_t;
+
+typedef struct {
+    uint32_t sends;
+    uint64_t bytes;
+} SendStats_t;
+
+static void makeRecord(Link_e link, uint32_t seq, void *pRecord);
+static int8_t sendSingle(int fd, Link_e link, const void *pRecord, SendStats_t *pStats);
+static int8_t sendBatch(int fd, FrameBatch_t *pBatch, SendStats_t *pStats);
+static int8_t runFlatOut(Run_t *pRun, uint32_t records);
+static int8_t runPaced(Run_t *pRun, uint32_t rate, uint32_t seconds);
+static void *drainThread(void *arg);
+static uint32_t delivered(Link_e link);
+static uint64_t usecNow(void);
+static uint64_t cpuUsec(clockid_t clock);
+
+static const uint16_t linkPorts[LINK_END] = {LOG_PORT, STATUS_PORT};
+static const FrameType_e linkTypes[LINK_END] = {FRAME_TYPE_LOG, FRAME_TYPE_STATUS};
+static const uint32_t linkRecordSizes[LINK_END] = {sizeof(LogMsgPacket), sizeof(TaskStatusPacket)};
+static const char *linkNames[LINK_END] = {"log", "status"};
+
+static FrameBatch_t batch;
+static BenchServer_t server;
+static clockid_t serverClock;
+static volatile uint32_t logsDrained;
+static volatile uint8_t draining;
+
+int main(int argc, char *argv[])
+{
+    uint32_t records = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_RECORDS;
+    uint32_t rate = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : DEFAULT_RATE;
+    uint32_t seconds = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : DEFAULT_SECONDS;
+    Run_t runs[] = {{LINK_LOG, 0}, {LINK_LOG, 1}, {LINK_STATUS, 0}, {LINK_STATUS, 1}};
+    pthread_t drainer;
+    uint32_t ind;
+    int ret = EXIT_SUCCESS;
+
+    if((records == 0) || (rate == 0) || (rate > 1000000) || (seconds == 0)) {
+        ERROR_PRINT("usage: bench_batch [records] [rate 1-1000000] [seconds]\n");
+        return EXIT_FAILURE;
+    }
+
+    if(bench_server_open(&server, "bench_batch", BENCH_SERVER_LOG_QUEUE) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+    draining = 1;
+    if((bench_server_start(&server, remoteServerThreadHandler, remoteServerSigHandler) != EXIT_SUCCESS) ||
+       (pthread_create(&drainer, NULL, drainThread, &server.logQueue) != 0))
+        return EXIT_FAILURE;
+    pthread_getcpuclockid(server.thread, &serverClock);
+
+    printf("%u records flat out, then %u records/s for %u s; batch deadline %u ms, frame at most %u bytes\n",
+           records, rate, seconds, REMOTE_BATCH_DEADLINE_MS, (uint32_t)FRAME_LINK_MSS);
+    printf("  %-6s %-6s | %-60s | %s\n", "", "", "flat out", "paced, cpu");
+    printf("  %-6s %-6s | %9s %8s %8s %6s %7s %10s | %6s %6s\n", "link", "frames", "rec/s", "send us",
+           "srv us", "sends", "wire B", "100Mb rec/s", "send", "server");
+    for(ind = 0; ind < (sizeof(runs) / sizeof(runs[0])); ++ind)
+    {
+        if((runFlatOut(&runs[ind], records) != EXIT_SUCCESS) ||
+           (runPaced(&runs[ind], rate, seconds) != EXIT_SUCCESS))
+            ret = EXIT_FAILURE;
+        printf("  %-6s %-6s | %9.0f %8.2f %8.2f %6.3f %7.1f %10.0f | %5.1f%% %5.1f%%%s\n",
+               linkNames[runs[ind].link], runs[ind].batched ? "batch" : "single", runs[ind].recPerSec,
+               runs[ind].sendUsecPerRec, runs[ind].serverUsecPerRec, runs[ind].sendsPerRec,
+               runs[ind].wirePerRec, LINK_BYTES_PER_SEC / runs[ind].wirePerRec,
+               runs[ind].sendCpuPct, runs[ind].serverCpuPct, runs[ind].complete ? "" : "  (records lost)");
+        if(!runs[ind].complete)
+            ret = EXIT_FAILURE;
+    }
+
+    draining = 0;
+    pthread_join(drainer, NULL);
+    bench_server_close(&server);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief records as fast as they go, timed until the last is through
+ */
+static int8_t runFlatOut(Run_t *pRun, uint32_t records)
+{
+    uint8_t record[sizeof(LogMsgPacket)];
+    SendStats_t stats = {0, 0};
+    uint64_t start, end, cpuStart, serverStart;
+    uint32_t seq, base;
+    int8_t ret = EXIT_SUCCESS;
+    int fd;
+
+    fd = bench_connect(linkPorts[pRun->link], BENCH_NODE_ID);
+    if(fd < 0)
+        return EXIT_FAILURE;
+    /* the server names the connection from its hello before anything is counted */
+    usleep(100000);
+    base = delivered(pRun->link);
+
+    frame_batch_init(&batch);
+    start = usecNow();
+    cpuStart = cpuUsec(CLOCK_THREAD_CPUTIME_ID);
+    serverStart = cpuUsec(serverClock);
+    for(seq = 0; (seq < records) && (ret == EXIT_SUCCESS); ++seq)
+    {
+        makeRecord(pRun->link, seq, record);
+        if(!pRun->batched) {
+            ret = sendSingle(fd, pRun->link, record, &stats);
+        }
+        else {
+            frame_batch_add(&batch, linkTypes[pRun->link], record, linkRecordSizes[pRun->link]);
+            if(frame_batch_free(&batch) < FRAME_RECORD_SIZE(linkRecordSizes[pRun->link]))
+                ret = sendBatch(fd, &batch, &stats);
+        }
+    }
+    if((ret == EXIT_SUCCESS) && pRun->batched && (batch.records != 0))
+        ret = sendBatch(fd, &batch, &stats);
+    pRun->sendUsecPerRec = (double)(cpuUsec(CLOCK_THREAD_CPUTIME_ID) - cpuStart) / records;
+
+    while(((delivered(pRun->link) - base) < records) && ((usecNow() - start) < DRAIN_TIMEOUT_USEC))
+        usleep(100);
+    end = usecNow();
+    pRun->complete = ((delivered(pRun->link) - base) == records);
+    pRun->recPerSec = (records * 1e6) / (end - start);
+    pRun->serverUsecPerRec = (double)(cpuUsec(serverClock) - serverStart) / records;
+    pRun->sendsPerRec = (double)stats.sends / records;
+    pRun->wirePerRec = (double)(stats.bytes + ((uint64_t)stats.sends * WIRE_HEADER_BYTES)) / records;
+    close(fd);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief records at rate, as a TIVA task would queue them; CPU of this
+ * thread and the server's as a share of the time taken
+ */
+static int8_t runPaced(Run_t *pRun, uint32_t rate, uint32_t seconds)
+{
+    uint8_t record[sizeof(LogMsgPacket)];
+    SendStats_t stats = {0, 0};
+    struct timespec next;
+    uint64_t start, cpuStart, serverStart, batchStart = 0, wall;
+    uint64_t periodNsec = 1000000000ULL / rate;
+    uint32_t seq, records = rate * seconds;
+    int8_t ret = EXIT_SUCCESS;
+    int fd;
+
+    fd = bench_connect(linkPorts[pRun->link], BENCH_NODE_ID);
+    if(fd < 0)
+        return EXIT_FAILURE;
+    usleep(100000);
+
+    frame_batch_init(&batch);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    start = usecNow();
+    cpuStart = cpuUsec(CLOCK_THREAD_CPUTIME_ID);
+    serverStart = cpuUsec(serverClock);
+    for(seq = 0; (seq < records) && (ret == EXIT_SUCCESS); ++seq)
+    {
+        next.tv_nsec += periodNsec;
+        while(next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            ++next.tv_sec;
+        }
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+        makeRecord(pRun->link, seq, record);
+        if(!pRun->batched) {
+            ret = sendSingle(fd, pRun->link, record, &stats);
+        }
+        else {
+            frame_batch_add(&batch, linkTypes[pRun->link], record, linkRecordSizes[pRun->link]);
+            if(batch.records == 1)
+                batchStart = usecNow();
+            if((frame_batch_free(&batch) < FRAME_RECORD_SIZE(linkRecordSizes[pRun->link])) ||
+               ((usecNow() - batchStart) >= (REMOTE_BATCH_DEADLINE_MS * 1000)))
+                ret = sendBatch(fd, &batch, &stats);
+        }
+    }
+    if((ret == EXIT_SUCCESS) && pRun->batched && (batch.records != 0))
+        ret = sendBatch(fd, &batch, &stats);
+    wall = usecNow() - start;
+    pRun->sendCpuPct = (100.0 * (cpuUsec(CLOCK_THREAD_CPUTIME_ID) - cpuStart)) / wall;
+    pRun->serverCpuPct = (100.0 * (cpuUsec(serverClock) - serverStart)) / wall;
+
+    /* let the server catch up before the next run */
+    usleep(200000);
+    close(fd);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a log msg as the TIVA's tasks log them, checksum set by its
+ * remoteLogTask; or a STATUS_OK status msg
+ */
+static void makeRecord(Link_e link, uint32_t seq, void *pRecord)
+{
+    LogMsgPacket *pLog = (LogMsgPacket *)pRecord;
+    TaskStatusPacket *pStatus = (TaskStatusPacket *)pRecord;
+
+    if(link == LINK_LOG) {
+        memset(pLog, 0, sizeof(LogMsgPacket));
+        pLog->logMsgId = LOG_MSG_INFO;
+        pLog->payloadFormat = LOG_PAYLOAD_TEXT;
+        pLog->fileId = BENCH_LOG_FILE;
+        pLog->lineNum = 100;
+        pLog->timestamp = seq;
+        pLog->sourceId = PID_LIGHT;
+        pLog->payloadLength = (uint32_t)snprintf((char *)pLog->payload, LOG_MSG_PAYLOAD_SIZE, "lux reading %u", seq);
+        pLog->checksum = log_packet_checksum(pLog);
+    }
+    else {
+        memset(pStatus, 0, sizeof(TaskStatusPacket));
+        pStatus->header = BENCH_STATUS_PID;
+        pStatus->timestamp = seq;
+        pStatus->processId = BENCH_STATUS_PID;
+        pStatus->taskState = STATE_RUNNING;
+        pStatus->taskStatus = STATUS_OK;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a packet in its own frame, header then packet as sendSocketData()
+ * sends them
+ */
+static int8_t sendSingle(int fd, Link_e link, const void *pRecord, SendStats_t *pStats)
+{
+    uint32_t len = linkRecordSizes[link];
+    FrameHeader_t hdr;
+
+    frame_header(&hdr, linkTypes[link], pRecord, len);
+    if((send(fd, &hdr, sizeof(FrameHeader_t), MSG_NOSIGNAL) != sizeof(FrameHeader_t)) ||
+       (send(fd, pRecord, len, MSG_NOSIGNAL) != (ssize_t)len))
+        return EXIT_FAILURE;
+    pStats->sends += 2;
+    pStats->bytes += sizeof(FrameHeader_t) + len;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a batch sent, and counted
+ */
+static int8_t sendBatch(int fd, FrameBatch_t *pBatch, SendStats_t *pStats)
+{
+    uint32_t len = sizeof(FrameHeader_t) + pBatch->hdr.length;
+
+    if(bench_send_batch(fd, pBatch) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+    ++pStats->sends;
+    pStats->bytes += len;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief take log msgs off the queue as the logging thread would, counting
+ * the simulated TIVA's
+ */
+static void *drainThread(void *arg)
+{
+    mqd_t queue = *(mqd_t *)arg;
+    LogMsgPacket msg;
+    struct timespec timeout;
+
+    while(draining)
+    {
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_nsec += 10000000;
+        if(timeout.tv_nsec >= 1000000000L) {
+            timeout.tv_nsec -= 1000000000L;
+            ++timeout.tv_sec;
+        }
+        if((mq_timedreceive(queue, (char *)&msg, sizeof(LogMsgPacket), NULL, &timeout) == sizeof(LogMsgPacket)) &&
+           (msg.fileId == BENCH_LOG_FILE))
+            __atomic_add_fetch(&logsDrained, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief records through the server so far: log msgs off the queue, or
+ * status msgs published to the heartbeat table (seq is 2 per publish)
+ */
+static uint32_t delivered(Link_e link)
+{
+    HeartbeatSlot_t slot;
+
+    if(link == LINK_LOG)
+        return __atomic_load_n(&logsDrained, __ATOMIC_RELAXED);
+    if(heartbeat_read(BENCH_STATUS_PID, &slot) != EXIT_SUCCESS)
+        return 0;
+    return slot.seq / 2;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t cpuUsec(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
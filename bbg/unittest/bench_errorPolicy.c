@@ -0,0 +1,221 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 9, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_errorPolicy.c
+ * @brief error arbitration cost under an error storm, the per thread
+ * arbitor switch chains and range tests the health monitor used to run vs
+ * the error policy table
+ *
+ * usage: bench_errorPolicy [seconds]
+ *
+ * One second of storm is STORM_RATE status msgs from the arbitrated threads
+ * with random error codes; each is decided (action) and described (the
+ * course of action PRINT_STATUS_MSG_HEADER prints) both ways, the storm
+ * repeated for the given seconds. First checks the default table gives the
+ * same action as the old arbitors for every thread and code.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "healthMonitor.h"
+#include "errorPolicy.h"
+
+#define STORM_RATE          (10000)     /* status msgs per second */
+#define DEFAULT_SECONDS     (1000)
+#define NSEC_PER_SEC        (1000000000ULL)
+
+static MainAction_e legacyArbitor(TaskStatusPacket *pStatus);
+static MainAction_e legacyThreadArbitor(TaskStatusPacket *pStatus);
+static const char *legacyDesc(TaskStatusPacket *pStatus);
+static uint64_t nsecNow(void);
+
+static const ProcessId_e stormPids[] = {PID_LOGGING, PID_REMOTE_CMD, PID_REMOTE_LOG, PID_REMOTE_STATUS,
+                                        PID_REMOTE_DATA, PID_LIGHT, PID_MOISTURE, PID_OBSERVER, PID_SOLENOID};
+static TaskStatusPacket storm[STORM_RATE];
+
+int main(int argc, char *argv[])
+{
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_SECONDS;
+    TaskStatusPacket status;
+    uint64_t start, legacyNs, tableNs, check = 0;
+    uint32_t pid, code, sec, ind, mismatches = 0;
+
+    if(seconds == 0)
+        return EXIT_FAILURE;
+
+    memset(&status, 0, sizeof(TaskStatusPacket));
+    for(pid = 0; pid < PID_END; ++pid)
+    {
+        for(code = 0; code < ERROR_POLICY_CODES; ++code)
+        {
+            status.processId = (ProcessId_e)pid;
+            status.errorCode = (uint8_t)code;
+            if(legacyArbitor(&status) != error_policy_action((ProcessId_e)pid, (uint8_t)code)) {
+                if(mismatches++ < 5)
+                    ERROR_PRINT("%s code %u: arbitor %d table %d\n", getPidString((ProcessId_e)pid), code,
+                                legacyArbitor(&status), error_policy_action((ProcessId_e)pid, (uint8_t)code));
+            }
+        }
+    }
+    printf("default policy table vs arbitors: %u of %u entries differ\n", mismatches, PID_END * ERROR_POLICY_CODES);
+
+    srand(5013);
+    memset(storm, 0, sizeof(storm));
+    for(ind = 0; ind < STORM_RATE; ++ind)
+    {
+        storm[ind].processId = stormPids[rand() % (sizeof(stormPids) / sizeof(stormPids[0]))];
+        storm[ind].taskStatus = STATUS_ERROR;
+        storm[ind].errorCode = (uint8_t)(ERROR_CODE_USER_NONE0 + (rand() % (ERROR_CODE_USER_RESTARTTHREAD7 - ERROR_CODE_USER_NONE0 + 1)));
+        if((rand() % 16) == 0)
+            storm[ind].errorCode = ERROR_CODE_TIMEOUT;
+    }
+
+    start = nsecNow();
+    for(sec = 0; sec < seconds; ++sec)
+    {
+        for(ind = 0; ind < STORM_RATE; ++ind)
+            check += legacyArbitor(&storm[ind]) + legacyDesc(&storm[ind])[0];
+    }
+    legacyNs = nsecNow() - start;
+
+    start = nsecNow();
+    for(sec = 0; sec < seconds; ++sec)
+    {
+        for(ind = 0; ind < STORM_RATE; ++ind)
+            check -= error_policy_action(storm[ind].processId, storm[ind].errorCode) +
+                     error_policy_desc(storm[ind].processId, storm[ind].errorCode)[0];
+    }
+    tableNs = nsecNow() - start;
+
+    printf("error storm: %u msgs/s for %u s\n", STORM_RATE, seconds);
+    printf("  %-8s %10s %14s\n", "design", "ns/msg", "core @ storm");
+    printf("  %-8s %10.1f %13.4f%%\n", "arbitor", (double)legacyNs / ((uint64_t)seconds * STORM_RATE),
+           100.0 * (double)legacyNs / ((uint64_t)seconds * NSEC_PER_SEC));
+    printf("  %-8s %10.1f %13.4f%%\n", "table", (double)tableNs / ((uint64_t)seconds * STORM_RATE),
+           100.0 * (double)tableNs / ((uint64_t)seconds * NSEC_PER_SEC));
+
+    /* descriptions are compared by first letter only, which is enough to
+     * catch a wrong row; TIMEOUT was printed on its own and matches too */
+    if((mismatches != 0) || (check != 0)) {
+        ERROR_PRINT("table and arbitors disagree\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief callArbitor as it was, less the print
+ */
+static MainAction_e legacyArbitor(TaskStatusPacket *pStatus)
+{
+    switch(pStatus->processId){
+        case PID_LIGHT:
+        case PID_TEMP:
+        case PID_MOISTURE:
+        case PID_OBSERVER:
+        case PID_SOLENOID:
+        case PID_REMOTE_LOG:
+        case PID_REMOTE_STATUS:
+        case PID_REMOTE_DATA:
+        case PID_REMOTE_CMD:
+        case PID_LOGGING:
+            return legacyThreadArbitor(pStatus);
+        default:
+            return MAIN_ACTION_NONE;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief sensor, remote and logging arbitors were identical
+ */
+static MainAction_e legacyThreadArbitor(TaskStatusPacket *pStatus)
+{
+    switch(pStatus->errorCode){
+        case ERROR_CODE_USER_NONE0:
+        case ERROR_CODE_USER_NONE1:
+        case ERROR_CODE_USER_NONE2:
+        case ERROR_CODE_USER_NONE3:
+        case ERROR_CODE_USER_NONE4:
+        case ERROR_CODE_USER_NONE5:
+        case ERROR_CODE_USER_NONE6:
+        case ERROR_CODE_USER_NONE7:
+            return MAIN_ACTION_NONE;
+        case ERROR_CODE_TIMEOUT:
+        case ERROR_CODE_USER_NOTIFY0:
+        case ERROR_CODE_USER_NOTIFY1:
+        case ERROR_CODE_USER_NOTIFY2:
+        case ERROR_CODE_USER_NOTIFY3:
+        case ERROR_CODE_USER_NOTIFY4:
+        case ERROR_CODE_USER_NOTIFY5:
+        case ERROR_CODE_USER_NOTIFY6:
+        case ERROR_CODE_USER_NOTIFY7:
+            return MAIN_ACTION_NOTIFY_USER_ONLY;
+        case ERROR_CODE_USER_TERMTHREAD0:
+        case ERROR_CODE_USER_TERMTHREAD1:
+        case ERROR_CODE_USER_TERMTHREAD2:
+        case ERROR_CODE_USER_TERMTHREAD3:
+        case ERROR_CODE_USER_TERMTHREAD4:
+        case ERROR_CODE_USER_TERMTHREAD5:
+        case ERROR_CODE_USER_TERMTHREAD6:
+        case ERROR_CODE_USER_TERMTHREAD7:
+            return MAIN_ACTION_TERMINATE_THREAD;
+        case ERROR_CODE_USER_RESTARTTHREAD0:
+        case ERROR_CODE_USER_RESTARTTHREAD1:
+        case ERROR_CODE_USER_RESTARTTHREAD2:
+        case ERROR_CODE_USER_RESTARTTHREAD3:
+        case ERROR_CODE_USER_RESTARTTHREAD4:
+        case ERROR_CODE_USER_RESTARTTHREAD5:
+        case ERROR_CODE_USER_RESTARTTHREAD6:
+        case ERROR_CODE_USER_RESTARTTHREAD7:
+            return MAIN_ACTION_RESTART_THREAD;
+        default:
+            return MAIN_ACTION_TERMINATE_ALL;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief PRINT_STATUS_MSG_HEADER's range tests, returning what it printed
+ */
+static const char *legacyDesc(TaskStatusPacket *pStatus)
+{
+    if((pStatus->errorCode >= ERROR_CODE_USER_NOTIFY0) && (pStatus->errorCode <= ERROR_CODE_USER_NOTIFY7))
+        return "NOTIFY";
+    else if((pStatus->errorCode >= ERROR_CODE_USER_TERMTHREAD0) && (pStatus->errorCode <= ERROR_CODE_USER_TERMTHREAD7))
+        return "TERMTHREAD";
+    else if((pStatus->errorCode >= ERROR_CODE_USER_TERMALL0) && (pStatus->errorCode <= ERROR_CODE_USER_TERMALL7))
+        return "TERMALL";
+    else if((pStatus->errorCode >= ERROR_CODE_USER_RESTARTTHREAD0) && (pStatus->errorCode <= ERROR_CODE_USER_RESTARTTHREAD7))
+        return "RESTARTTHREAD";
+    else if((pStatus->errorCode >= ERROR_CODE_USER_NONE0) && (pStatus->errorCode <= ERROR_CODE_USER_NONE7))
+        return "NONE";
+    else if(pStatus->errorCode == ERROR_CODE_TIMEOUT)
+        return "TIMEOUT";
+    return "OTHER";
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t nsecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * NSEC_PER_SEC) + now.tv_nsec;
+}
@@ -0,0 +1,423 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 6, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_health.c
+ * @brief health monitor benchmarks
+ *  heartbeat - cost of SEND_STATUS_MSG and monitor CPU time per main loop
+ *           with heartbeats sent over the status msg queue vs published to the
+ *           shared memory heartbeat table; each cycle every monitored thread
+ *           beats twice (threads run twice as fast as main) then monitorHealth
+ *           runs once, as in main
+ *  detect - stall one thread (default PID_REMOTE_DATA) and measure how long
+ *           after its last heartbeat it is reported unresponsive, for the
+ *           polling monitor called each main loop vs the event driven
+ *           monitor thread; both tolerate THREAD_MISSING_COUNT main loops.
+ *           Loop times are scaled down DETECT_SCALE times so trials are quick.
+ *
+ * usage: bench_health [heartbeat [cycles] | detect [trials] [processId]]
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <mqueue.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "my_debug.h"
+#include "healthMonitor.h"
+#include "heartbeat.h"
+#include "packet.h"
+
+#define DEFAULT_CYCLES          (100000)
+#define BEATS_PER_CYCLE         (2)
+#define BENCH_STATUS_QUEUE_NAME "/bench_heartbeat_mq"
+#define BENCH_HEARTBEAT_NAME    "/bench_heartbeat_shm"
+#define DEFAULT_TRIALS          (100)
+#define DEFAULT_STALL_PID       (PID_REMOTE_DATA)
+#define DETECT_SCALE            (50)
+#define DETECT_BEAT_NS          ((uint64_t)(REMOTE_LOOP_TIME_NSEC / DETECT_SCALE))
+#define DETECT_MAIN_NS          ((uint64_t)(MAIN_LOOP_TIME_NSEC / DETECT_SCALE))
+#define DETECT_DEADLINE_USEC    (HEALTH_DEADLINE_USEC / DETECT_SCALE)
+#define DETECT_TIMEOUT_NS       (DETECT_MAIN_NS * (THREAD_MISSING_COUNT + 3))
+#define NSEC_PER_SEC            (1000000000ULL)
+
+typedef struct {
+    ProcessId_e Id;
+    mqd_t queue;
+} BeaterArgs_t;
+
+static int benchHeartbeat(uint32_t numCycles);
+static int runHeartbeat(const char *pName, mqd_t queue, uint32_t numCycles);
+static int benchDetect(uint32_t numTrials, ProcessId_e stallId);
+static int runDetect(const char *pName, mqd_t queue, uint8_t polling, uint32_t numTrials, ProcessId_e stallId);
+static void *beaterThread(void *pArg);
+static void onMissed(ProcessId_e Id, void *pArg);
+static void printLatency(const char *pName, uint64_t *pLatency, uint32_t num, uint32_t falseAlarms);
+static int cmpU64(const void *a, const void *b);
+static void sleepUntil(uint64_t wakeNs);
+static uint64_t nsec_now(void);
+static uint64_t cpu_nsec_now(void);
+
+/* shared by beater threads, detect loop and onMissed() */
+static volatile uint8_t beatersRun;
+static volatile uint8_t stalled[PID_END];
+static volatile uint64_t lastBeatNs[PID_END];
+static volatile uint64_t missedNs;
+static volatile uint32_t falseMissed;
+static ProcessId_e stallPid;
+
+/* healthMonitor.c signals the threads it kills; no threads here */
+void remoteLogSigHandler(int signo, siginfo_t *info, void *extra) {}
+void remoteStatusSigHandler(int signo, siginfo_t *info, void *extra) {}
+void remoteDataSigHandler(int signo, siginfo_t *info, void *extra) {}
+void remoteCmdSigHandler(int signo, siginfo_t *info, void *extra) {}
+void loggingSigHandler(int signo, siginfo_t *info, void *extra) {}
+
+/* threads monitorHealth() expects to hear from */
+static const ProcessId_e monitoredPids[] = {
+    PID_LOGGING, PID_REMOTE_CMD, PID_REMOTE_LOG, PID_REMOTE_STATUS, PID_REMOTE_DATA,
+    PID_LIGHT, PID_MOISTURE, PID_OBSERVER, PID_SOLENOID
+};
+#define NUM_MONITORED           (sizeof(monitoredPids) / sizeof(monitoredPids[0]))
+
+/*---------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *pSuite = (argc > 1) ? argv[1] : "all";
+    uint32_t count = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 0;
+    int ret = EXIT_SUCCESS;
+
+    if((strcmp(pSuite, "heartbeat") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchHeartbeat((count != 0) ? count : DEFAULT_CYCLES);
+    }
+    if((strcmp(pSuite, "detect") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchDetect((count != 0) ? count : DEFAULT_TRIALS,
+                           (argc > 3) ? (ProcessId_e)strtoul(argv[3], NULL, 0) : DEFAULT_STALL_PID);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchHeartbeat(uint32_t numCycles)
+{
+    struct mq_attr mqAttr;
+    mqd_t queue;
+    int ret = EXIT_SUCCESS;
+
+    memset(&mqAttr, 0, sizeof(struct mq_attr));
+    mqAttr.mq_maxmsg  = STATUS_MSG_QUEUE_DEPTH;
+    mqAttr.mq_msgsize = STATUS_MSG_QUEUE_MSG_SIZE;
+    mq_unlink(BENCH_STATUS_QUEUE_NAME);
+    queue = mq_open(BENCH_STATUS_QUEUE_NAME, O_CREAT | O_RDWR | O_NONBLOCK, 0666, &mqAttr);
+    if(queue == -1) {
+        ERRNO_PRINT("bench_health couldn't create status queue");
+        return EXIT_FAILURE;
+    }
+
+    printf("heartbeat: %u cycles, %u threads x %u beats per monitor call\n",
+           numCycles, (uint32_t)NUM_MONITORED, BEATS_PER_CYCLE);
+    printf("  %-10s %12s %14s %14s\n", "design", "publish ns", "monitor ns", "monitor cpu ns");
+
+    /* no table mapped, every status goes through the queue */
+    ret |= runHeartbeat("mq", queue, numCycles);
+
+    if(heartbeat_init(BENCH_HEARTBEAT_NAME) != EXIT_SUCCESS) {
+        mq_close(queue);
+        mq_unlink(BENCH_STATUS_QUEUE_NAME);
+        return EXIT_FAILURE;
+    }
+    ret |= runHeartbeat("shm table", queue, numCycles);
+    heartbeat_destroy(BENCH_HEARTBEAT_NAME);
+
+    mq_close(queue);
+    mq_unlink(BENCH_STATUS_QUEUE_NAME);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief beat and monitor numCycles times, print per publish and per monitor
+ * call cost; fails if the monitor reported anything (every thread beat)
+ */
+static int runHeartbeat(const char *pName, mqd_t queue, uint32_t numCycles)
+{
+    uint64_t start, publishNs = 0, monitorNs = 0, monitorCpuNs = 0, cpuStart;
+    uint32_t cycle, beat, ind;
+    uint8_t exitFlag = 1, newError = 0, anyError = 0;
+
+    for(cycle = 0; cycle < numCycles; ++cycle)
+    {
+        start = nsec_now();
+        for(beat = 0; beat < BEATS_PER_CYCLE; ++beat)
+        {
+            for(ind = 0; ind < NUM_MONITORED; ++ind)
+                SEND_STATUS_MSG(queue, monitoredPids[ind], STATUS_OK, ERROR_CODE_USER_NONE0);
+        }
+        publishNs += nsec_now() - start;
+
+        start = nsec_now();
+        cpuStart = cpu_nsec_now();
+        newError = 0;
+        monitorHealth(&queue, &exitFlag, &newError);
+        monitorCpuNs += cpu_nsec_now() - cpuStart;
+        monitorNs += nsec_now() - start;
+        anyError |= newError;
+    }
+
+    printf("  %-10s %12.1f %14.1f %14.1f\n", pName,
+           (double)publishNs / ((double)numCycles * BEATS_PER_CYCLE * NUM_MONITORED),
+           (double)monitorNs / numCycles, (double)monitorCpuNs / numCycles);
+    if(anyError || (exitFlag == 0)) {
+        ERROR_PRINT("%s: monitor reported a missing thread\n", pName);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchDetect(uint32_t numTrials, ProcessId_e stallId)
+{
+    struct mq_attr mqAttr;
+    pthread_t beaters[NUM_MONITORED];
+    BeaterArgs_t args[NUM_MONITORED];
+    mqd_t queue;
+    uint32_t ind;
+    int ret = EXIT_SUCCESS;
+
+    for(ind = 0; (ind < NUM_MONITORED) && (monitoredPids[ind] != stallId); ++ind);
+    if(ind == NUM_MONITORED) {
+        ERROR_PRINT("%s isn't a monitored thread\n", getPidString(stallId));
+        return EXIT_FAILURE;
+    }
+
+    memset(&mqAttr, 0, sizeof(struct mq_attr));
+    mqAttr.mq_maxmsg  = STATUS_MSG_QUEUE_DEPTH;
+    mqAttr.mq_msgsize = STATUS_MSG_QUEUE_MSG_SIZE;
+    mq_unlink(BENCH_STATUS_QUEUE_NAME);
+    queue = mq_open(BENCH_STATUS_QUEUE_NAME, O_CREAT | O_RDWR | O_NONBLOCK, 0666, &mqAttr);
+    if(queue == -1) {
+        ERRNO_PRINT("bench_health couldn't create status queue");
+        return EXIT_FAILURE;
+    }
+    if(heartbeat_init(BENCH_HEARTBEAT_NAME) != EXIT_SUCCESS) {
+        mq_close(queue);
+        mq_unlink(BENCH_STATUS_QUEUE_NAME);
+        return EXIT_FAILURE;
+    }
+
+    /* every monitored thread beats each (scaled) thread loop */
+    beatersRun = 1;
+    for(ind = 0; ind < NUM_MONITORED; ++ind) {
+        args[ind].Id = monitoredPids[ind];
+        args[ind].queue = queue;
+        pthread_create(&beaters[ind], NULL, beaterThread, &args[ind]);
+    }
+
+    printf("detect: stall %s %u times, beat every %.1f ms, main loop %.1f ms, deadline %.1f ms\n",
+           getPidString(stallId), numTrials, DETECT_BEAT_NS / 1e6, DETECT_MAIN_NS / 1e6,
+           DETECT_DEADLINE_USEC / 1e3);
+    printf("  latency from last heartbeat to report, ms\n");
+    printf("  %-10s %8s %8s %8s %8s %8s %8s\n", "monitor", "min", "p50", "p90", "p99", "max", "false");
+    ret |= runDetect("polling", queue, 1, numTrials, stallId);
+    ret |= runDetect("epoll", queue, 0, numTrials, stallId);
+
+    beatersRun = 0;
+    for(ind = 0; ind < NUM_MONITORED; ++ind) {
+        pthread_join(beaters[ind], NULL);
+    }
+
+    /* loop jitter of the beaters, from the table's interval histograms */
+    printf("  heartbeat interval, usec\n");
+    for(ind = 0; ind < NUM_MONITORED; ++ind) {
+        Histogram_t interval, delivery;
+        char line[HIST_FORMAT_SIZE];
+
+        healthMonitorStats(monitoredPids[ind], &interval, &delivery);
+        hist_format(&interval, line, sizeof(line));
+        printf("  %-24s %s\n", getPidString(monitoredPids[ind]), line);
+    }
+    heartbeat_destroy(BENCH_HEARTBEAT_NAME);
+    mq_close(queue);
+    mq_unlink(BENCH_STATUS_QUEUE_NAME);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief stall stallId numTrials times and time each report, either calling
+ * monitorHealth() every main loop like main does, or with the event driven
+ * monitor thread running
+ */
+static int runDetect(const char *pName, mqd_t queue, uint8_t polling, uint32_t numTrials, ProcessId_e stallId)
+{
+    HealthMonitor_t monitor;
+    pthread_t monitorThread;
+    uint64_t *pLatency, nextLoop, stallStart, detectNs;
+    uint32_t trial, done = 0;
+    uint8_t exitFlag = 1, newError;
+
+    pLatency = malloc(numTrials * sizeof(uint64_t));
+    if(pLatency == NULL)
+        return EXIT_FAILURE;
+    stallPid = stallId;
+    falseMissed = 0;
+
+    if(!polling) {
+        if(healthMonitorInit(&monitor, queue, &exitFlag, DETECT_DEADLINE_USEC) != EXIT_SUCCESS) {
+            free(pLatency);
+            return EXIT_FAILURE;
+        }
+        monitor.missedFunc = onMissed;
+        pthread_create(&monitorThread, NULL, healthMonitorThreadHandler, &monitor);
+    }
+
+    /* let every thread beat, and the polling monitor clear old misses */
+    nextLoop = nsec_now();
+    for(trial = 0; trial < THREAD_MISSING_COUNT + 1; ++trial) {
+        nextLoop += DETECT_MAIN_NS;
+        sleepUntil(nextLoop);
+        if(polling)
+            monitorHealth(&queue, &exitFlag, &newError);
+    }
+
+    for(trial = 0; trial < numTrials; ++trial)
+    {
+        /* stall at a random point of the main loop */
+        sleepUntil(nsec_now() + (rand() % DETECT_MAIN_NS));
+        missedNs = 0;
+        stalled[stallId] = 1;
+        stallStart = nsec_now();
+
+        detectNs = 0;
+        while((detectNs == 0) && ((nsec_now() - stallStart) < DETECT_TIMEOUT_NS))
+        {
+            if(polling) {
+                nextLoop += DETECT_MAIN_NS;
+                sleepUntil(nextLoop);
+                newError = 0;
+                monitorHealth(&queue, &exitFlag, &newError);
+                if(newError)
+                    detectNs = nsec_now();
+            } else {
+                sleepUntil(nsec_now() + (DETECT_BEAT_NS / 10));
+                detectNs = missedNs;
+            }
+        }
+        stalled[stallId] = 0;
+        if(detectNs != 0)
+            pLatency[done++] = detectNs - lastBeatNs[stallId];
+
+        /* recover before the next stall */
+        nextLoop = nsec_now();
+        for(newError = 0; newError < 2; ++newError) {
+            nextLoop += DETECT_MAIN_NS;
+            sleepUntil(nextLoop);
+            if(polling) {
+                uint8_t ignored = 0;
+                monitorHealth(&queue, &exitFlag, &ignored);
+            }
+        }
+        nextLoop = nsec_now();
+    }
+
+    if(!polling) {
+        healthMonitorStop(&monitor);
+        pthread_join(monitorThread, NULL);
+    }
+    printLatency(pName, pLatency, done, falseMissed);
+    free(pLatency);
+    if(done != numTrials) {
+        ERROR_PRINT("%s: %u of %u stalls never reported\n", pName, numTrials - done, numTrials);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void *beaterThread(void *pArg)
+{
+    BeaterArgs_t *pArgs = (BeaterArgs_t *)pArg;
+    uint64_t nextBeat = nsec_now();
+
+    while(beatersRun)
+    {
+        if(!stalled[pArgs->Id]) {
+            SEND_STATUS_MSG(pArgs->queue, pArgs->Id, STATUS_OK, ERROR_CODE_USER_NONE0);
+            lastBeatNs[pArgs->Id] = nsec_now();
+        }
+        nextBeat += DETECT_BEAT_NS;
+        sleepUntil(nextBeat);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void onMissed(ProcessId_e Id, void *pArg)
+{
+    if((Id == stallPid) && stalled[Id] && (missedNs == 0))
+        missedNs = nsec_now();
+    else if(!stalled[Id])
+        ++falseMissed;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printLatency(const char *pName, uint64_t *pLatency, uint32_t num, uint32_t falseAlarms)
+{
+    if(num == 0) {
+        printf("  %-10s no reports\n", pName);
+        return;
+    }
+    qsort(pLatency, num, sizeof(uint64_t), cmpU64);
+    printf("  %-10s %8.2f %8.2f %8.2f %8.2f %8.2f %8u\n", pName,
+           pLatency[0] / 1e6, pLatency[num / 2] / 1e6, pLatency[(num * 9) / 10] / 1e6,
+           pLatency[(num * 99) / 100] / 1e6, pLatency[num - 1] / 1e6, falseAlarms);
+}
+
+/*---------------------------------------------------------------------------------*/
+static int cmpU64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void sleepUntil(uint64_t wakeNs)
+{
+    struct timespec wake;
+
+    wake.tv_sec = wakeNs / NSEC_PER_SEC;
+    wake.tv_nsec = wakeNs % NSEC_PER_SEC;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) != 0);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t nsec_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t cpu_nsec_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,1033 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date April 28, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_logger.c
+ * @brief logger benchmarks
+ *  queue  - posix msg queue vs per-thread ring backends with several producer
+ *           threads (one per remote thread) logging as fast as they can while
+ *           a consumer drains like the logging thread does
+ *  writer - per-field write() log_write_item vs buffered log sink, records/sec
+ *           and write syscalls/record (from /proc/self/io)
+ *  format - legacy vs compact file format: file size, write and C reader
+ *           parse rates for a synthetic log
+ *  producer - cycles (rdtsc on x86, else ns) spent in the calling thread per
+ *           LOG_* macro call, through the backend selected by LOG_BACKEND
+ *  filter - ns per LOG_* call filtered out at runtime by msg, level and process
+ *  compress - compressed log blocks: ratio and CPU ns/record spent
+ *           compressing a heartbeat, sensor event and INFO mix, both formats
+ *  checksum - old byte sum vs CRC-32C (bytewise, slicing-by-8, hardware)
+ *           throughput on payload sized and large buffers
+ *  query  - query latency using the sidecar log index vs a full scan, and
+ *           the cost of keeping the index; the default 10M record log is
+ *           ~340 MB so it only runs when asked for by name
+ *
+ * usage: bench_logger [queue [eventsPerProducer] [numProducers] | writer [records] |
+ *                      format [records] | producer [calls] |
+ *                      filter [calls] | compress [records] | checksum [MB] |
+ *                      query [records]]
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <mqueue.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "my_debug.h"
+#include "logger.h"
+#include "logger_queue.h"
+#include "logger_ring.h"
+#include "logger_sink.h"
+#include "crc.h"
+#include "logger_reader.h"
+#include "logger_segment.h"
+#include "logger_index.h"
+#include "packet.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_BENCH_LOGGER);
+
+#define DEFAULT_EVENTS          (50000)
+#define DEFAULT_PRODUCERS       (NUM_REMOTE_REPORTING_THREADS)
+#define MAX_PRODUCERS           (LOG_RING_MAX_PRODUCERS - 1)
+#define BENCH_LOG_QUEUE_NAME    "/bench_logging_mq"
+#define DEFAULT_RECORDS         (20000)
+#define BENCH_LOG_FILE_LEGACY   "/tmp/bench_log_legacy.bin"
+#define BENCH_LOG_FILE_SINK     "/tmp/bench_log_sink.bin"
+#define DEFAULT_FORMAT_RECORDS  (1000000)
+#define BENCH_LOG_FILE_COMPACT  "/tmp/bench_log_compact.bin"
+#define BENCH_LOG_FILE_SEGMENT  "/tmp/bench_log_segment.bin"
+#define BENCH_SEGMENTS_KEPT     (4)
+#define DEFAULT_PRODUCER_CALLS  (100000)
+#define PRODUCER_BATCH          (32)        /* calls between drains, below queue depth */
+#define DEFAULT_FILTER_CALLS    (10000000)
+#define DEFAULT_COMPRESS_RECORDS (1000000)
+#define BENCH_LOG_FILE_LEGACY_Z "/tmp/bench_log_legacy_z.bin"
+#define BENCH_LOG_FILE_COMPACT_Z "/tmp/bench_log_compact_z.bin"
+#define DEFAULT_CHECKSUM_MB     (256)
+#define CHECKSUM_LARGE_SIZE     (4096)
+#define DEFAULT_QUERY_RECORDS   (10000000)
+#define BENCH_LOG_FILE_QUERY    "/tmp/bench_log_query.bin"
+#define QUERY_WINDOW_USEC       (1000000)
+#define QUERY_ERROR_EVERY       (10007)     /* rare msg type for the query log */
+#ifdef LOG_RING_BUFFER
+    #define LOG_BACKEND_NAME    "ring"
+#else
+    #define LOG_BACKEND_NAME    "mq"
+#endif
+#define LOG_FILE_FLAGS          (O_CREAT | O_WRONLY | O_NONBLOCK | O_SYNC | O_APPEND | O_TRUNC)
+
+typedef uint8_t (*enqueueFunc_t)(logItem_t *pLogItem);
+typedef uint8_t (*dequeueFunc_t)(logItem_t *pLogItem);
+
+typedef uint8_t (*logCallFunc_t)(uint32_t ind);
+typedef void (*makeItemFunc_t)(logItem_t *pLogItem, uint32_t ind);
+typedef uint32_t (*checksumFunc_t)(uint32_t crc, const uint8_t *pData, uint32_t len);
+
+typedef struct {
+    enqueueFunc_t enqueue;
+    uint32_t numEvents;
+    uint32_t *pLatency;         /* ns per enqueue call */
+    uint32_t dropped;
+} ProducerArgs_t;
+
+typedef struct {
+    dequeueFunc_t dequeue;
+    volatile uint8_t *pDone;
+    uint32_t received;
+} ConsumerArgs_t;
+
+static void *producerThread(void *pArg);
+static void *consumerThread(void *pArg);
+static int cmpU32(const void *a, const void *b);
+static uint64_t nsec_now(void);
+static void runBackend(const char *name, enqueueFunc_t enq, dequeueFunc_t deq,
+                       uint32_t numEvents, uint32_t numProducers);
+static int initBackends(mqd_t *pLogQueue);
+static int benchQueue(uint32_t numEvents, uint32_t numProducers);
+static int benchWriter(uint32_t numRecords);
+static int benchFormat(uint32_t numRecords);
+static int writeLog(const char *pPath, LogFormat_e format, uint8_t compress, makeItemFunc_t makeFunc,
+                    uint32_t numRecords, uint64_t *pSize, uint64_t *pElapsed);
+static int parseLog(const char *pPath, makeItemFunc_t makeFunc, uint32_t numRecords);
+static int benchCompress(uint32_t numRecords);
+static int benchChecksum(uint32_t numMB);
+static double timeChecksum(checksumFunc_t checksum, const uint8_t *pData, uint32_t len, uint32_t numMB);
+static uint32_t byteSum(uint32_t sum, const uint8_t *pData, uint32_t len);
+static int benchQuery(uint32_t numRecords);
+static int timeQuery(const char *pName, const LogIndexQuery_t *pQuery, const LogIndexEntry_t *pEntries,
+                     uint32_t numEntries);
+static void countQueryMatch(logItem_t *pLogItem, void *pArg);
+static void makeQueryItem(logItem_t *pLogItem, uint32_t ind);
+static int benchProducer(uint32_t numCalls);
+static void runProducerCase(const char *name, logCallFunc_t logCall, uint32_t numCalls);
+static uint8_t callInfo(uint32_t ind);
+static uint8_t callEvent(uint32_t ind);
+static uint8_t callHeartbeat(uint32_t ind);
+static uint64_t cycles_now(void);
+static int benchFilter(uint32_t numCalls);
+static double timeFiltered(logCallFunc_t logCall, uint32_t numCalls);
+static uint8_t callNothing(uint32_t ind);
+static void makeItem(logItem_t *pLogItem, uint32_t ind);
+static void makeMixItem(logItem_t *pLogItem, uint32_t ind);
+static uint64_t readSyscw(void);
+static int filesMatch(const char *pPathA, const char *pPathB);
+
+/*---------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *pSuite = (argc > 1) ? argv[1] : "all";
+    uint32_t count = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 0;
+    int ret = EXIT_SUCCESS;
+
+    if((strcmp(pSuite, "queue") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchQueue((count != 0) ? count : DEFAULT_EVENTS,
+                          (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : DEFAULT_PRODUCERS);
+    }
+    if((strcmp(pSuite, "writer") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchWriter((count != 0) ? count : DEFAULT_RECORDS);
+    }
+    if((strcmp(pSuite, "format") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchFormat((count != 0) ? count : DEFAULT_FORMAT_RECORDS);
+    }
+    if((strcmp(pSuite, "producer") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchProducer((count != 0) ? count : DEFAULT_PRODUCER_CALLS);
+    }
+    if((strcmp(pSuite, "filter") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchFilter((count != 0) ? count : DEFAULT_FILTER_CALLS);
+    }
+    if((strcmp(pSuite, "compress") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchCompress((count != 0) ? count : DEFAULT_COMPRESS_RECORDS);
+    }
+    if((strcmp(pSuite, "checksum") == 0) || (strcmp(pSuite, "all") == 0)) {
+        ret |= benchChecksum((count != 0) ? count : DEFAULT_CHECKSUM_MB);
+    }
+    if(strcmp(pSuite, "query") == 0) {
+        ret |= benchQuery((count != 0) ? count : DEFAULT_QUERY_RECORDS);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchQueue(uint32_t numEvents, uint32_t numProducers)
+{
+    mqd_t logQueue;
+
+    if((numProducers == 0) || (numProducers > MAX_PRODUCERS)) {
+        ERROR_PRINT("queue bench supports 1 to %d producers\n", MAX_PRODUCERS);
+        return EXIT_FAILURE;
+    }
+    if(initBackends(&logQueue) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    printf("logger backend benchmark: %u producers x %u events, %zu byte packets\n",
+           numProducers, numEvents, sizeof(LogMsgPacket));
+    runBackend("mq", log_queue_item, log_dequeue_item, numEvents, numProducers);
+    runBackend("ring", log_ring_item, log_ring_dequeue_item, numEvents, numProducers);
+
+    mq_close(logQueue);
+    mq_unlink(BENCH_LOG_QUEUE_NAME);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief create the bench msg queue, sized the same way main creates
+ * it, and init both backends on it
+ */
+static int initBackends(mqd_t *pLogQueue)
+{
+    LogThreadInfo logThreadInfo;
+    struct mq_attr mqAttr;
+
+    memset(&mqAttr, 0, sizeof(struct mq_attr));
+    mqAttr.mq_maxmsg  = LOG_MSG_QUEUE_DEPTH;
+    mqAttr.mq_msgsize = LOG_MSG_QUEUE_MSG_SIZE;
+    mq_unlink(BENCH_LOG_QUEUE_NAME);
+    *pLogQueue = mq_open(BENCH_LOG_QUEUE_NAME, O_CREAT | O_RDWR, 0666, &mqAttr);
+    if(*pLogQueue < 0) {
+        ERRNO_PRINT("failed to create log msg queue (check /proc/sys/fs/mqueue/msg_max)");
+        return EXIT_FAILURE;
+    }
+
+    memset(&logThreadInfo, 0, sizeof(LogThreadInfo));
+    strcpy(logThreadInfo.logMsgQueueName, BENCH_LOG_QUEUE_NAME);
+    if((init_queue_logger(&logThreadInfo) != LOG_STATUS_OK) ||
+       (init_ring_logger(&logThreadInfo) != LOG_STATUS_OK)) {
+        ERROR_PRINT("failed to init logger backends\n");
+        mq_close(*pLogQueue);
+        mq_unlink(BENCH_LOG_QUEUE_NAME);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchWriter(uint32_t numRecords)
+{
+    static LogSegment_t logSegment;
+    char path[LOG_SEGMENT_PATH_SIZE];
+    uint32_t oldest, newest;
+    logItem_t logItem;
+    LogSink_t logSink;
+    uint64_t start, elapsed, syscw;
+    uint32_t ind;
+    int fd;
+
+    printf("log writer benchmark: %u records, O_SYNC file\n", numRecords);
+
+    /* before: one write() per field byte/string */
+    fd = open(BENCH_LOG_FILE_LEGACY, LOG_FILE_FLAGS, 0644);
+    if(fd < 0) {
+        ERRNO_PRINT("failed to open bench log file");
+        return EXIT_FAILURE;
+    }
+    syscw = readSyscw();
+    start = nsec_now();
+    for(ind = 0; ind < numRecords; ++ind)
+    {
+        makeItem(&logItem, ind);
+        if(log_write_item(&logItem, fd) != LOG_STATUS_OK)
+            break;
+    }
+    elapsed = nsec_now() - start;
+    syscw = readSyscw() - syscw;
+    close(fd);
+    printf("legacy : %10.0f records/sec, %6.2f write syscalls/record\n",
+           numRecords / (elapsed * 1e-9), (double)syscw / numRecords);
+
+    /* after: buffered sink, one write() per batch */
+    fd = open(BENCH_LOG_FILE_SINK, LOG_FILE_FLAGS, 0644);
+    if(fd < 0) {
+        ERRNO_PRINT("failed to open bench log file");
+        return EXIT_FAILURE;
+    }
+    log_sink_init(&logSink, fd, LOG_FORMAT_LEGACY, 0);
+    syscw = readSyscw();
+    start = nsec_now();
+    for(ind = 0; ind < numRecords; ++ind)
+    {
+        makeItem(&logItem, ind);
+        if(log_sink_write_item(&logSink, &logItem) != LOG_STATUS_OK)
+            break;
+        log_sink_poll(&logSink);
+    }
+    log_sink_flush(&logSink);
+    elapsed = nsec_now() - start;
+    syscw = readSyscw() - syscw;
+    close(fd);
+    printf("sink   : %10.0f records/sec, %6.3f write syscalls/record (%u sink writes)\n",
+           numRecords / (elapsed * 1e-9), (double)syscw / numRecords, logSink.writeCalls);
+
+    printf("output byte-identical: %s\n", filesMatch(BENCH_LOG_FILE_LEGACY, BENCH_LOG_FILE_SINK) ? "yes" : "NO");
+
+    /* mmap'd segments, msync on a timer instead of O_SYNC */
+    if(log_segment_open(&logSegment, BENCH_LOG_FILE_SEGMENT, LOG_SEGMENT_DEFAULT_SIZE,
+                        BENCH_SEGMENTS_KEPT, LOG_FORMAT_LEGACY) != LOG_STATUS_OK) {
+        return EXIT_FAILURE;
+    }
+    syscw = readSyscw();
+    start = nsec_now();
+    for(ind = 0; ind < numRecords; ++ind)
+    {
+        makeItem(&logItem, ind);
+        if(log_segment_write_item(&logSegment, &logItem) != LOG_STATUS_OK)
+            break;
+        log_segment_poll(&logSegment);
+    }
+    log_segment_close(&logSegment);
+    elapsed = nsec_now() - start;
+    syscw = readSyscw() - syscw;
+    printf("segment: %10.0f records/sec, %6.3f write syscalls/record (%u msyncs, %u rotations)\n",
+           numRecords / (elapsed * 1e-9), (double)syscw / numRecords, logSegment.syncs, logSegment.rotations);
+
+    if(log_segment_find(BENCH_LOG_FILE_SEGMENT, &oldest, &newest) == LOG_STATUS_OK) {
+        for(; oldest <= newest; ++oldest) {
+            log_segment_path(path, BENCH_LOG_FILE_SEGMENT, oldest);
+            unlink(path);
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchFormat(uint32_t numRecords)
+{
+    uint64_t legacySize, compactSize, elapsed;
+
+    printf("log format benchmark: %u records\n", numRecords);
+    if((writeLog(BENCH_LOG_FILE_LEGACY, LOG_FORMAT_LEGACY, 0, makeItem, numRecords, &legacySize, &elapsed) != 0) ||
+       (writeLog(BENCH_LOG_FILE_COMPACT, LOG_FORMAT_COMPACT, 0, makeItem, numRecords, &compactSize, &elapsed) != 0)) {
+        return EXIT_FAILURE;
+    }
+    printf("size: legacy %llu bytes (%.1f B/record), compact %llu bytes (%.1f B/record), %.1f%% smaller\n",
+           (unsigned long long)legacySize, (double)legacySize / numRecords,
+           (unsigned long long)compactSize, (double)compactSize / numRecords,
+           100.0 * (1.0 - ((double)compactSize / legacySize)));
+
+    printf("legacy  ");
+    if(parseLog(BENCH_LOG_FILE_LEGACY, makeItem, numRecords) != 0)
+        return EXIT_FAILURE;
+    printf("compact ");
+    if(parseLog(BENCH_LOG_FILE_COMPACT, makeItem, numRecords) != 0)
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchCompress(uint32_t numRecords)
+{
+    static const LogFormat_e formats[] = { LOG_FORMAT_LEGACY, LOG_FORMAT_COMPACT };
+    static const char *pPaths[][2] = {
+        { BENCH_LOG_FILE_LEGACY,  BENCH_LOG_FILE_LEGACY_Z },
+        { BENCH_LOG_FILE_COMPACT, BENCH_LOG_FILE_COMPACT_Z }
+    };
+    uint64_t plainSize, zSize, plainNs, zNs;
+    uint32_t ind;
+
+    printf("log compression benchmark: %u records, %u KB blocks\n", numRecords, LOG_SINK_BLOCK_SIZE / 1024);
+    for(ind = 0; ind < (sizeof(formats) / sizeof(formats[0])); ++ind)
+    {
+        if((writeLog(pPaths[ind][0], formats[ind], 0, makeMixItem, numRecords, &plainSize, &plainNs) != 0) ||
+           (writeLog(pPaths[ind][1], formats[ind], 1, makeMixItem, numRecords, &zSize, &zNs) != 0)) {
+            return EXIT_FAILURE;
+        }
+        printf("%-7s: %llu -> %llu bytes (%.1f -> %.1f B/record), ratio %.2f:1, %+.1f ns/record to compress\n",
+               (formats[ind] == LOG_FORMAT_COMPACT) ? "compact" : "legacy",
+               (unsigned long long)plainSize, (unsigned long long)zSize,
+               (double)plainSize / numRecords, (double)zSize / numRecords,
+               (double)plainSize / zSize, ((double)zNs - (double)plainNs) / numRecords);
+
+        printf("compressed %-7s ", (formats[ind] == LOG_FORMAT_COMPACT) ? "compact" : "legacy");
+        if(parseLog(pPaths[ind][1], makeMixItem, numRecords) != 0)
+            return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int writeLog(const char *pPath, LogFormat_e format, uint8_t compress, makeItemFunc_t makeFunc,
+                    uint32_t numRecords, uint64_t *pSize, uint64_t *pElapsed)
+{
+    static LogSink_t logSink;
+    logItem_t logItem;
+    uint64_t start, elapsed;
+    uint32_t ind;
+    off_t size;
+    int fd;
+
+    /* no O_SYNC, this measures serialization not the disk */
+    fd = open(pPath, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if((fd < 0) || (log_sink_init(&logSink, fd, format, compress) != LOG_STATUS_OK)) {
+        ERRNO_PRINT("failed to open bench log file");
+        return -1;
+    }
+    start = nsec_now();
+    for(ind = 0; ind < numRecords; ++ind)
+    {
+        makeFunc(&logItem, ind);
+        if(log_sink_write_item(&logSink, &logItem) != LOG_STATUS_OK)
+            break;
+    }
+    log_sink_flush(&logSink);
+    elapsed = nsec_now() - start;
+    size = lseek(fd, 0, SEEK_END);
+    close(fd);
+
+    printf("write %-7s%s: %10.0f records/sec, %6.1f ns/record\n",
+           (format == LOG_FORMAT_COMPACT) ? "compact" : "legacy", compress ? " (lz)" : "     ",
+           numRecords / (elapsed * 1e-9), (double)elapsed / numRecords);
+    *pSize = (uint64_t)size;
+    *pElapsed = elapsed;
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int parseLog(const char *pPath, makeItemFunc_t makeFunc, uint32_t numRecords)
+{
+    static LogReader_t reader;
+    logItem_t logItem, expected;
+    uint64_t start, elapsed;
+    uint32_t count = 0, mismatch = 0;
+    uint8_t ret;
+
+    if(log_reader_open(&reader, pPath) != LOG_STATUS_OK)
+        return -1;
+
+    start = nsec_now();
+    while((ret = log_reader_next(&reader, &logItem)) != LOG_STATUS_EOF)
+    {
+        if(ret != LOG_STATUS_OK)
+            continue;
+
+        /* spot check fields against what was written */
+        makeFunc(&expected, count);
+        if((logItem.logMsgId != expected.logMsgId) || (logItem.time != expected.time) ||
+           (logItem.lineNum != expected.lineNum) || (logItem.checksum != expected.checksum) ||
+           (logItem.payloadLength != expected.payloadLength) ||
+           (strcmp((char *)logItem.pFilename, (char *)log_item_filename(&expected)) != 0))
+            ++mismatch;
+        ++count;
+    }
+    elapsed = nsec_now() - start;
+    log_reader_close(&reader);
+
+    printf("parse: %10.0f records/sec (%.1f ms), %u records, %u bad, %u mismatched\n",
+           count / (elapsed * 1e-9), elapsed * 1e-6, count, reader.badRecords, mismatch);
+    return ((count == numRecords) && (mismatch == 0)) ? 0 : -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchProducer(uint32_t numCalls)
+{
+    mqd_t logQueue;
+
+    if(initBackends(&logQueue) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+#if defined(__x86_64__) || defined(__i386__)
+    printf("producer cost per LOG_* call (%s backend), TSC cycles:\n", LOG_BACKEND_NAME);
+#else
+    printf("producer cost per LOG_* call (%s backend), ns:\n", LOG_BACKEND_NAME);
+#endif
+    runProducerCase("LOG_INFO", callInfo, numCalls);
+    runProducerCase("LOG_*_EVENT", callEvent, numCalls);
+    runProducerCase("LOG_HEARTBEAT", callHeartbeat, numCalls);
+
+    mq_close(logQueue);
+    mq_unlink(BENCH_LOG_QUEUE_NAME);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief time each call on its own; the backend is drained between
+ * batches, outside the timed region, so no call blocks or drops
+ */
+static void runProducerCase(const char *name, logCallFunc_t logCall, uint32_t numCalls)
+{
+    uint8_t payload[LOG_MSG_PAYLOAD_SIZE];
+    uint32_t *pCycles;
+    uint32_t ind, dropped = 0;
+    uint64_t before, sum = 0;
+    logItem_t logItem;
+
+    pCycles = malloc(sizeof(uint32_t) * numCalls);
+    if(pCycles == NULL) {
+        ERROR_PRINT("malloc failed\n");
+        return;
+    }
+    logItem.pPayload = payload;
+
+    for(ind = 0; ind < numCalls; ++ind)
+    {
+        before = cycles_now();
+        if(logCall(ind) != LOG_STATUS_OK)
+            ++dropped;
+        pCycles[ind] = (uint32_t)(cycles_now() - before);
+        sum += pCycles[ind];
+
+        if((ind % PRODUCER_BATCH) == (PRODUCER_BATCH - 1)) {
+            while(LOG_DEQUEUE_ITEM(&logItem) == LOG_STATUS_OK)
+                ;
+        }
+    }
+    while(LOG_DEQUEUE_ITEM(&logItem) == LOG_STATUS_OK)
+        ;
+
+    qsort(pCycles, numCalls, sizeof(uint32_t), cmpU32);
+    printf("%-14s: mean %7.0f, p50 %7u, p99 %8u, dropped %u\n", name, (double)sum / numCalls,
+           pCycles[numCalls / 2], pCycles[(uint32_t)(numCalls * 0.99)], dropped);
+    free(pCycles);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t callInfo(uint32_t ind)
+{
+    return LOG_INFO("remoteDataThread received lux and moisture data");
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t callEvent(uint32_t ind)
+{
+    return LOG_REMOTE_DATA_EVENT(ind % 12);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t callHeartbeat(uint32_t ind)
+{
+    return LOG_HEARTBEAT();
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief nothing should reach the backend, so none is initialized; a
+ * call that gets through fails (mq) or fills its ring and is reported
+ */
+static int benchFilter(uint32_t numCalls)
+{
+    double loopNs, ns;
+
+    printf("filtered LOG_* call cost, %u calls each:\n", numCalls);
+    loopNs = timeFiltered(callNothing, numCalls);
+    printf("%-26s: %5.2f ns/call\n", "empty loop", loopNs);
+
+    log_filter_set_msg(LOG_MSG_INFO, 0);
+    ns = timeFiltered(callInfo, numCalls);
+    printf("%-26s: %5.2f ns/call (%5.2f over loop)\n", "LOG_INFO, msg disabled", ns, ns - loopNs);
+
+    log_filter_reset();
+    log_filter_set_level(LOGLVL_ERROR);
+    ns = timeFiltered(callEvent, numCalls);
+    printf("%-26s: %5.2f ns/call (%5.2f over loop)\n", "LOG_*_EVENT, below level", ns, ns - loopNs);
+
+    log_filter_reset();
+    log_filter_set_process(PID_END, 0);
+    ns = timeFiltered(callHeartbeat, numCalls);
+    printf("%-26s: %5.2f ns/call (%5.2f over loop)\n", "LOG_HEARTBEAT, process off", ns, ns - loopNs);
+
+    log_filter_reset();
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+static double timeFiltered(logCallFunc_t logCall, uint32_t numCalls)
+{
+    uint32_t ind, passed = 0;
+    uint64_t start;
+    double elapsed;
+
+    start = nsec_now();
+    for(ind = 0; ind < numCalls; ++ind)
+    {
+        if(logCall(ind) != LOG_STATUS_OK)
+            ++passed;
+    }
+    elapsed = (double)(nsec_now() - start);
+
+    if(passed != 0)
+        ERROR_PRINT("%u calls weren't filtered\n", passed);
+    return elapsed / numCalls;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t callNothing(uint32_t ind)
+{
+    __asm__ __volatile__("" ::: "memory");
+    return LOG_STATUS_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchChecksum(uint32_t numMB)
+{
+    static const struct {
+        const char *pName;
+        checksumFunc_t checksum;
+    } cases[] = {
+        { "byte sum (old)",     byteSum },
+        { "crc32c bytewise",    crc32c_update_bytewise },
+        { "crc32c slice-by-8",  crc32c_update_sw },
+        { "crc32c selected",    crc32c_update }
+    };
+    static const uint32_t sizes[] = { LOG_MSG_PAYLOAD_SIZE, CHECKSUM_LARGE_SIZE };
+    static uint8_t buf[CHECKSUM_LARGE_SIZE];
+    logItem_t logItem;
+    uint32_t ind, size, numCalls;
+    uint64_t start;
+
+    for(ind = 0; ind < sizeof(buf); ++ind)
+        buf[ind] = (uint8_t)(ind * 31);
+
+    printf("checksum benchmark: %u MB per case, selected crc32c is %s\n", numMB, crc32c_impl());
+    for(size = 0; size < (sizeof(sizes) / sizeof(sizes[0])); ++size)
+    {
+        for(ind = 0; ind < (sizeof(cases) / sizeof(cases[0])); ++ind)
+        {
+            double ns = timeChecksum(cases[ind].checksum, buf, sizes[size], numMB);
+            printf("%-18s %4u B: %8.1f MB/s, %7.1f ns/buffer\n", cases[ind].pName, sizes[size],
+                   sizes[size] / ns * 1e3, ns);
+        }
+    }
+
+    /* whole record as the logging thread checksums it */
+    numCalls = 1000000;
+    start = nsec_now();
+    for(ind = 0; ind < numCalls; ++ind)
+    {
+        makeMixItem(&logItem, ind);
+    }
+    printf("makeMixItem + log_set_checksum: %.1f ns/record\n", (double)(nsec_now() - start) / numCalls);
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @return double ns per checksum of len bytes
+ */
+static double timeChecksum(checksumFunc_t checksum, const uint8_t *pData, uint32_t len, uint32_t numMB)
+{
+    uint32_t ind, numCalls = (uint32_t)(((uint64_t)numMB << 20) / len);
+    volatile uint32_t result = 0;
+    uint64_t start;
+
+    start = nsec_now();
+    for(ind = 0; ind < numCalls; ++ind)
+        result = checksum(result, pData, len);
+    return (double)(nsec_now() - start) / numCalls;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief payload term of the checksum records used to carry
+ */
+static uint32_t byteSum(uint32_t sum, const uint8_t *pData, uint32_t len)
+{
+    while(len-- > 0)
+        sum += *pData++;
+    return sum;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int benchQuery(uint32_t numRecords)
+{
+    static LogSink_t logSink;
+    static LogIndex_t logIndex;
+    LogIndexEntry_t *pEntries;
+    LogIndexQuery_t query;
+    uint32_t numEntries, ind;
+    uint64_t plainSize, plainNs, start, elapsed;
+    struct stat fileStat;
+    logItem_t logItem;
+    int fd, ret = 0;
+
+    printf("log query benchmark: %u compact records, page cache warm\n", numRecords);
+
+    /* cost of the index: same log written without one first */
+    if(writeLog(BENCH_LOG_FILE_QUERY, LOG_FORMAT_COMPACT, 0, makeQueryItem, numRecords, &plainSize, &plainNs) != 0)
+        return EXIT_FAILURE;
+    unlink(BENCH_LOG_FILE_QUERY LOG_INDEX_SUFFIX);
+    fd = open(BENCH_LOG_FILE_QUERY, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if((fd < 0) || (log_sink_init(&logSink, fd, LOG_FORMAT_COMPACT, 0) != LOG_STATUS_OK) ||
+       (log_sink_set_index(&logSink, &logIndex, BENCH_LOG_FILE_QUERY) != LOG_STATUS_OK)) {
+        ERRNO_PRINT("failed to open bench log file");
+        return EXIT_FAILURE;
+    }
+    start = nsec_now();
+    for(ind = 0; ind < numRecords; ++ind)
+    {
+        makeQueryItem(&logItem, ind);
+        if(log_sink_write_item(&logSink, &logItem) != LOG_STATUS_OK)
+            break;
+    }
+    log_sink_flush(&logSink);
+    log_index_close(&logIndex);
+    elapsed = nsec_now() - start;
+    fstat(fd, &fileStat);
+    close(fd);
+    printf("write with index: %6.1f ns/record (%+.1f), log %llu bytes (%+lld)\n",
+           (double)elapsed / numRecords, ((double)elapsed - (double)plainNs) / numRecords,
+           (unsigned long long)fileStat.st_size, (long long)fileStat.st_size - (long long)plainSize);
+
+    if(log_index_load(BENCH_LOG_FILE_QUERY, &pEntries, &numEntries) != LOG_STATUS_OK) {
+        ERROR_PRINT("failed to load bench log index\n");
+        return EXIT_FAILURE;
+    }
+    printf("index: %u entries, %u bytes\n", numEntries, LOG_INDEX_HDR_SIZE + (numEntries * LOG_INDEX_ENTRY_SIZE));
+
+    /* a one second window from the middle of the run */
+    log_index_query_init(&query);
+    query.minTime = (numRecords / 2) * 250;
+    query.maxTime = query.minTime + QUERY_WINDOW_USEC;
+    ret |= timeQuery("1 s window", &query, pEntries, numEntries);
+
+    query.pidMask = (1UL << PID_REMOTE_DATA);
+    ret |= timeQuery("PID_REMOTE_DATA in 1 s window", &query, pEntries, numEntries);
+
+    log_index_query_init(&query);
+    query.msgMask = (1UL << LOG_MSG_ERROR);
+    ret |= timeQuery("LOG_MSG_ERROR, whole log", &query, pEntries, numEntries);
+
+    /* every chunk has every source, the index can't help */
+    log_index_query_init(&query);
+    query.anySource = 0;
+    query.sourceId = 1002;
+    ret |= timeQuery("sourceId 1002, whole log", &query, pEntries, numEntries);
+
+    free(pEntries);
+    return (ret == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief run a query with the index and as a full scan; both must find
+ * the same records
+ */
+static int timeQuery(const char *pName, const LogIndexQuery_t *pQuery, const LogIndexEntry_t *pEntries,
+                     uint32_t numEntries)
+{
+    static LogReader_t reader;
+    LogIndexStats_t indexed, scanned;
+    uint64_t start, indexNs, scanNs;
+    uint32_t indexSum = 0, scanSum = 0;
+
+    if(log_reader_open(&reader, BENCH_LOG_FILE_QUERY) != LOG_STATUS_OK)
+        return -1;
+    start = nsec_now();
+    log_index_query(&reader, pEntries, numEntries, pQuery, countQueryMatch, &indexSum, &indexed);
+    indexNs = nsec_now() - start;
+    log_reader_close(&reader);
+
+    if(log_reader_open(&reader, BENCH_LOG_FILE_QUERY) != LOG_STATUS_OK)
+        return -1;
+    start = nsec_now();
+    log_index_query(&reader, NULL, 0, pQuery, countQueryMatch, &scanSum, &scanned);
+    scanNs = nsec_now() - start;
+    log_reader_close(&reader);
+
+    printf("%-30s: %7u matches, index %9.3f ms (%u of %u chunks), scan %9.3f ms, %7.1fx%s\n",
+           pName, indexed.matched, indexNs * 1e-6, indexed.chunksRead, numEntries, scanNs * 1e-6,
+           (double)scanNs / indexNs,
+           ((indexed.matched != scanned.matched) || (indexSum != scanSum)) ? " MISMATCH" : "");
+    return ((indexed.matched == scanned.matched) && (indexSum == scanSum)) ? 0 : -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief sum of matched times, so both runs are checked for the same records
+ */
+static void countQueryMatch(logItem_t *pLogItem, void *pArg)
+{
+    *(uint32_t *)pArg += pLogItem->time;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void makeQueryItem(logItem_t *pLogItem, uint32_t ind)
+{
+    makeMixItem(pLogItem, ind);
+    if((ind % QUERY_ERROR_EVERY) == 0) {
+        pLogItem->logMsgId = LOG_MSG_ERROR;
+        log_set_checksum(pLogItem);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t cycles_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    /* no portable cycle counter, report ns */
+    return nsec_now();
+#endif
+}
+
+/*---------------------------------------------------------------------------------*/
+static void runBackend(const char *name, enqueueFunc_t enq, dequeueFunc_t deq,
+                       uint32_t numEvents, uint32_t numProducers)
+{
+    pthread_t producers[MAX_PRODUCERS], consumer;
+    ProducerArgs_t prodArgs[MAX_PRODUCERS];
+    ConsumerArgs_t consArgs;
+    volatile uint8_t done = 0;
+    uint32_t *pAllLatency;
+    uint32_t ind, total, dropped = 0;
+    uint64_t start, elapsed;
+
+    pAllLatency = malloc(sizeof(uint32_t) * numEvents * numProducers);
+    if(pAllLatency == NULL) {
+        ERROR_PRINT("malloc failed\n");
+        return;
+    }
+
+    consArgs.dequeue = deq;
+    consArgs.pDone = &done;
+    consArgs.received = 0;
+    pthread_create(&consumer, NULL, consumerThread, &consArgs);
+
+    start = nsec_now();
+    for(ind = 0; ind < numProducers; ++ind)
+    {
+        prodArgs[ind].enqueue = enq;
+        prodArgs[ind].numEvents = numEvents;
+        prodArgs[ind].pLatency = &pAllLatency[ind * numEvents];
+        prodArgs[ind].dropped = 0;
+        pthread_create(&producers[ind], NULL, producerThread, &prodArgs[ind]);
+    }
+    for(ind = 0; ind < numProducers; ++ind)
+    {
+        pthread_join(producers[ind], NULL);
+        dropped += prodArgs[ind].dropped;
+    }
+    done = 1;
+    pthread_join(consumer, NULL);
+    elapsed = nsec_now() - start;
+
+    total = numEvents * numProducers;
+    qsort(pAllLatency, total, sizeof(uint32_t), cmpU32);
+    printf("%-5s: %10.0f events/sec delivered, enqueue p50 %6u ns, p99 %8u ns, max %9u ns, dropped %u\n",
+           name, consArgs.received / (elapsed * 1e-9),
+           pAllLatency[total / 2], pAllLatency[(uint32_t)(total * 0.99)], pAllLatency[total - 1],
+           dropped);
+    free(pAllLatency);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void *producerThread(void *pArg)
+{
+    ProducerArgs_t *pArgs = (ProducerArgs_t *)pArg;
+    uint8_t payload[] = "remote thread storm payload";
+    logItem_t logItem;
+    uint64_t before;
+    uint32_t ind;
+    uint8_t ret;
+
+    for(ind = 0; ind < pArgs->numEvents; ++ind)
+    {
+        /* same item LOG_INFO builds */
+        logItem.logMsgId = LOG_MSG_INFO;
+        logItem.payloadFormat = LOG_PAYLOAD_STRING;
+        logItem.fileId = logFileId;
+        logItem.pFilename = NULL;
+        logItem.lineNum = __LINE__;
+        logItem.time = log_get_time();
+        logItem.payloadLength = 0;
+        logItem.pPayload = payload;
+        logItem.sourceId = (pid_t)syscall(SYS_gettid);
+
+        before = nsec_now();
+        ret = pArgs->enqueue(&logItem);
+        pArgs->pLatency[ind] = (uint32_t)(nsec_now() - before);
+        if(ret != LOG_STATUS_OK)
+            ++pArgs->dropped;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void *consumerThread(void *pArg)
+{
+    ConsumerArgs_t *pArgs = (ConsumerArgs_t *)pArg;
+    uint8_t payload[LOG_MSG_PAYLOAD_SIZE];
+    logItem_t logItem;
+    uint8_t ret;
+
+    logItem.pPayload = payload;
+
+    /* keep draining until producers are finished and backend is empty */
+    while(1)
+    {
+        ret = pArgs->dequeue(&logItem);
+        if(ret == LOG_STATUS_OK) {
+            ++pArgs->received;
+        }
+        else if(ret == LOG_STATUS_TIMEOUT) {
+            if(*pArgs->pDone)
+                break;
+            sched_yield();
+        }
+        else {
+            ERROR_PRINT("dequeue failed\n");
+            break;
+        }
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int cmpU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t nsec_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief typical mix of what the logging thread writes: events,
+ * info strings and heartbeats
+ */
+static void makeItem(logItem_t *pLogItem, uint32_t ind)
+{
+    static uint8_t infoStr[] = "remoteDataThread received lux and moisture data";
+    static uint8_t eventStr[MAX_INT_STRING_SIZE];
+
+    pLogItem->payloadFormat = LOG_PAYLOAD_TEXT;
+    pLogItem->fileId = logFileId;
+    pLogItem->pFilename = NULL;
+    pLogItem->lineNum = 100 + (ind % 50);
+    pLogItem->time = ind * 250;
+    pLogItem->sourceId = 1000 + (ind % 5);
+    switch(ind % 3)
+    {
+        case 0:
+            pLogItem->logMsgId = LOG_MSG_REMOTE_DATA_EVENT;
+            pLogItem->payloadLength = my_itoa(ind % 12, eventStr, HEX_BASE);
+            pLogItem->pPayload = eventStr;
+            break;
+        case 1:
+            pLogItem->logMsgId = LOG_MSG_INFO;
+            pLogItem->payloadLength = sizeof(infoStr);
+            pLogItem->pPayload = infoStr;
+            break;
+        default:
+            pLogItem->logMsgId = LOG_MSG_HEARTBEAT;
+            pLogItem->payloadLength = 0;
+            pLogItem->pPayload = eventStr;
+            break;
+    }
+    log_set_checksum(pLogItem);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief makeItem with the variety that keeps a real log from being
+ * trivially repetitive: several source files, jittered timestamps and
+ * sensor readings in the INFO text
+ */
+static void makeMixItem(logItem_t *pLogItem, uint32_t ind)
+{
+    static const uint16_t fileIds[] = {
+        LOG_FILE_BBG_REMOTE_DATA_THREAD, LOG_FILE_BBG_REMOTE_STATUS_THREAD,
+        LOG_FILE_BBG_LOGGING_THREAD, LOG_FILE_BBG_MAIN
+    };
+    static uint8_t infoStr[LOG_MSG_PAYLOAD_SIZE];
+    uint32_t hash = ind * 2654435761U;
+
+    makeItem(pLogItem, ind);
+    pLogItem->fileId = fileIds[(hash >> 8) % (sizeof(fileIds) / sizeof(fileIds[0]))];
+    pLogItem->time = (ind * 250) + ((hash >> 16) % 97);
+    if(pLogItem->logMsgId == LOG_MSG_INFO) {
+        pLogItem->payloadLength = 1 + snprintf((char *)infoStr, sizeof(infoStr),
+                                               "remote data: lux %u.%02u, moisture %u%%",
+                                               (hash >> 4) % 900, (hash >> 12) % 100, 20 + ((hash >> 20) % 60));
+        pLogItem->pPayload = infoStr;
+    }
+    log_set_checksum(pLogItem);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t readSyscw(void)
+{
+    char line[64];
+    unsigned long long syscw = 0;
+    FILE *pFile = fopen("/proc/self/io", "r");
+
+    if(pFile == NULL)
+        return 0;
+    while(fgets(line, sizeof(line), pFile) != NULL)
+    {
+        if(sscanf(line, "syscw: %llu", &syscw) == 1)
+            break;
+    }
+    fclose(pFile);
+    return syscw;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int filesMatch(const char *pPathA, const char *pPathB)
+{
+    FILE *pA = fopen(pPathA, "rb");
+    FILE *pB = fopen(pPathB, "rb");
+    int a, b, match = 0;
+
+    if((pA != NULL) && (pB != NULL))
+    {
+        do {
+            a = fgetc(pA);
+            b = fgetc(pB);
+        } while((a == b) && (a != EOF));
+        match = (a == b);
+    }
+    if(pA != NULL)
+        fclose(pA);
+    if(pB != NULL)
+        fclose(pB);
+    return match;
+}
@@ -0,0 +1,390 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 16, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_mux.c
+ * @brief cmd latency to a remote node flooding its log link, a connection
+ * per port vs one MUX_PORT connection
+ *
+ * usage: bench_mux [seconds] [cmds/s]
+ *
+ * Cmds are queued on the cmd msg queue as main queues them, each with its
+ * sequence number as data, and timed until the simulated TIVA has read it
+ * off its socket. Each run is done with the node's logs idle and flooded:
+ * full batches of log packets as fast as the server takes them.
+ *
+ * ports - the TIVA's four tasks, two of them here: remoteLogTask sending
+ *         on LOG_PORT, blocked in send() while the link is full, and
+ *         remoteCmdTask blocked in recv() on CMD_PORT.
+ * mux   - remoteMuxTask, one thread on one MUX_PORT connection. It waits
+ *         up to REMOTE_MUX_POLL_MS for cmds, not at all while it has logs
+ *         and the socket has room for them, then sends a batch of logs
+ *         only if it won't block.
+ *
+ * Log rec/s is what got through the server to the log msg queue.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <mqueue.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "logger.h"
+#include "remoteServer.h"
+#include "remoteFrame.h"
+#include "histogram.h"
+#include "bench_server.h"
+
+#define DEFAULT_SECONDS         (3)
+#define DEFAULT_CMD_RATE        (100)
+#define MAX_CMDS                (100000)
+#define BENCH_NODE_ID           (203)
+#define BENCH_LOG_FILE          (LOG_FILE_TIVA_LIGHT_THREAD)    /* counted off the queue, the server's own aren't */
+#define CMD_DRAIN_USEC          (500000)                        /* for the last cmds after the run */
+
+typedef struct {
+    uint8_t mux;
+    uint8_t flood;
+    uint32_t cmdsSent;
+    uint32_t cmdsRecvd;
+    Histogram_t latency;                /* usec, queued to read by the node */
+    double logRecPerSec;
+} Run_t;
+
+static int8_t runLink(Run_t *pRun, uint32_t seconds, uint32_t rate);
+static void *logTask(void *arg);
+static void *cmdTask(void *arg);
+static void *muxTask(void *arg);
+static void fillLogs(FrameBatch_t *pBatch);
+static int8_t readCmds(int fd, FrameReader_t *pReader, uint8_t wait);
+static void *drainThread(void *arg);
+static uint64_t usecNow(void);
+
+static BenchServer_t server;
+static volatile uint32_t logsDrained;
+static volatile uint8_t draining;
+static volatile uint8_t running;
+
+/* the run in progress, and when each of its cmds was queued */
+static Run_t *pCurrent;
+static uint64_t cmdSentUsec[MAX_CMDS];
+static int logFd, cmdFd;
+static uint32_t logSeq;
+
+int main(int argc, char *argv[])
+{
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_SECONDS;
+    uint32_t rate = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : DEFAULT_CMD_RATE;
+    Run_t runs[] = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+    pthread_t drainer;
+    uint32_t ind;
+    int ret = EXIT_SUCCESS;
+
+    if((seconds == 0) || (rate == 0) || (rate > 1000) || ((seconds * rate) > MAX_CMDS)) {
+        ERROR_PRINT("usage: bench_mux [seconds] [cmds/s 1-1000], at most %u cmds\n", MAX_CMDS);
+        return EXIT_FAILURE;
+    }
+
+    if(bench_server_open(&server, "bench_mux", BENCH_SERVER_LOG_QUEUE) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+    draining = 1;
+    if((bench_server_start(&server, remoteServerThreadHandler, remoteServerSigHandler) != EXIT_SUCCESS) ||
+       (pthread_create(&drainer, NULL, drainThread, &server.logQueue) != 0))
+        return EXIT_FAILURE;
+
+    printf("%u cmds/s for %u s per run; mux polls cmds every %u ms, server reads %u bytes a turn\n",
+           rate, seconds, REMOTE_MUX_POLL_MS, (uint32_t)REMOTE_SERVER_READ_BUDGET);
+    printf("  %-5s %-5s | %6s %8s %8s %8s %8s | %9s\n", "link", "logs", "cmds", "p50 us", "p99 us",
+           "p99.9 us", "max us", "log rec/s");
+    for(ind = 0; ind < (sizeof(runs) / sizeof(runs[0])); ++ind)
+    {
+        if(runLink(&runs[ind], seconds, rate) != EXIT_SUCCESS)
+            ret = EXIT_FAILURE;
+        printf("  %-5s %-5s | %6u %8u %8u %8u %8u | %9.0f%s\n", runs[ind].mux ? "mux" : "ports",
+               runs[ind].flood ? "flood" : "idle", runs[ind].cmdsRecvd,
+               hist_percentile(&runs[ind].latency, 50.0), hist_percentile(&runs[ind].latency, 99.0),
+               hist_percentile(&runs[ind].latency, 99.9), runs[ind].latency.max, runs[ind].logRecPerSec,
+               (runs[ind].cmdsRecvd == runs[ind].cmdsSent) ? "" : "  (cmds lost)");
+        if(runs[ind].cmdsRecvd != runs[ind].cmdsSent)
+            ret = EXIT_FAILURE;
+    }
+
+    draining = 0;
+    pthread_join(drainer, NULL);
+    bench_server_close(&server);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief connect the node's task(s), then queue cmds at rate for seconds
+ */
+static int8_t runLink(Run_t *pRun, uint32_t seconds, uint32_t rate)
+{
+    RemoteCmdPacket cmd;
+    struct timespec next;
+    pthread_t tasks[2];
+    uint32_t numTasks = 0, ind, logBase;
+    uint64_t periodNsec = 1000000000ULL / rate, start, end;
+    int8_t ret = EXIT_SUCCESS;
+
+    hist_reset(&pRun->latency);
+    pRun->cmdsSent = 0;
+    pRun->cmdsRecvd = 0;
+    pCurrent = pRun;
+    if(pRun->mux) {
+        logFd = bench_connect(MUX_PORT, BENCH_NODE_ID);
+        cmdFd = logFd;
+    }
+    else {
+        logFd = bench_connect(LOG_PORT, BENCH_NODE_ID);
+        cmdFd = bench_connect(CMD_PORT, BENCH_NODE_ID);
+    }
+    if((logFd < 0) || (cmdFd < 0))
+        return EXIT_FAILURE;
+    /* the server names the connections from their hellos */
+    usleep(100000);
+
+    running = 1;
+    if(pRun->mux) {
+        pthread_create(&tasks[numTasks++], NULL, muxTask, pRun);
+    }
+    else {
+        pthread_create(&tasks[numTasks++], NULL, cmdTask, pRun);
+        if(pRun->flood)
+            pthread_create(&tasks[numTasks++], NULL, logTask, pRun);
+    }
+    /* let a flood fill the link first */
+    usleep(200000);
+
+    logBase = __atomic_load_n(&logsDrained, __ATOMIC_RELAXED);
+    start = usecNow();
+    memset(&cmd, 0, sizeof(RemoteCmdPacket));
+    cmd.header = BENCH_NODE_ID;
+    cmd.cmd = REMOTE_SETMOISTURE_LOWTHRES;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for(ind = 0; ind < (seconds * rate); ++ind)
+    {
+        next.tv_nsec += periodNsec;
+        while(next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            ++next.tv_sec;
+        }
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+        cmd.data = ind;
+        cmdSentUsec[ind] = usecNow();
+        if(mq_send(server.cmdQueue, (char *)&cmd, sizeof(RemoteCmdPacket), 0) != 0) {
+            ERRNO_PRINT("bench_mux cmd queue full");
+            ret = EXIT_FAILURE;
+            break;
+        }
+        ++pRun->cmdsSent;
+    }
+    end = usecNow();
+    pRun->logRecPerSec = ((__atomic_load_n(&logsDrained, __ATOMIC_RELAXED) - logBase) * 1e6) / (end - start);
+    while((__atomic_load_n(&pRun->cmdsRecvd, __ATOMIC_RELAXED) < pRun->cmdsSent) && ((usecNow() - end) < CMD_DRAIN_USEC))
+        usleep(1000);
+
+    running = 0;
+    for(ind = 0; ind < numTasks; ++ind)
+        pthread_join(tasks[ind], NULL);
+    close(logFd);
+    if(cmdFd != logFd)
+        close(cmdFd);
+
+    /* let the server drop the connections and catch up before the next run */
+    usleep(300000);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief remoteLogTask flooded: batch after batch, blocked in send() while
+ * the link is full
+ */
+static void *logTask(void *arg)
+{
+    FrameBatch_t batch;
+
+    frame_batch_init(&batch);
+    while(running)
+    {
+        fillLogs(&batch);
+        if(bench_send_batch(logFd, &batch) != EXIT_SUCCESS)
+            break;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief remoteCmdTask: blocked in recv() until a cmd arrives
+ */
+static void *cmdTask(void *arg)
+{
+    FrameReader_t reader;
+    uint32_t readerBuf[FRAME_READER_SIZE / sizeof(uint32_t)];
+
+    frame_reader_init(&reader, (uint8_t *)readerBuf);
+    while(running)
+    {
+        if(readCmds(cmdFd, &reader, 1) != EXIT_SUCCESS)
+            break;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief remoteMuxTask: cmds first, waiting for them only while there are
+ * no logs to send or no room to send them; then a batch of logs if the
+ * socket takes it without blocking
+ */
+static void *muxTask(void *arg)
+{
+    Run_t *pRun = (Run_t *)arg;
+    FrameReader_t reader;
+    uint32_t readerBuf[FRAME_READER_SIZE / sizeof(uint32_t)];
+    FrameBatch_t batch;
+    struct pollfd pfd;
+    uint8_t room;
+
+    frame_reader_init(&reader, (uint8_t *)readerBuf);
+    frame_batch_init(&batch);
+    while(running)
+    {
+        /* POLLOUT stands in for FreeRTOS_tx_space() */
+        pfd.fd = cmdFd;
+        pfd.events = POLLOUT;
+        room = pRun->flood && (poll(&pfd, 1, 0) == 1) && (pfd.revents & POLLOUT);
+        if(readCmds(cmdFd, &reader, !room) != EXIT_SUCCESS)
+            break;
+
+        if(room) {
+            fillLogs(&batch);
+            if(bench_send_batch(logFd, &batch) != EXIT_SUCCESS)
+                break;
+        }
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a batch of log msgs as the TIVA's tasks log them, checksum set as
+ * the remote tasks set it
+ */
+static void fillLogs(FrameBatch_t *pBatch)
+{
+    LogMsgPacket log;
+
+    while(frame_batch_free(pBatch) >= FRAME_RECORD_SIZE(sizeof(LogMsgPacket)))
+    {
+        memset(&log, 0, sizeof(LogMsgPacket));
+        log.logMsgId = LOG_MSG_INFO;
+        log.payloadFormat = LOG_PAYLOAD_TEXT;
+        log.fileId = BENCH_LOG_FILE;
+        log.lineNum = 100;
+        log.timestamp = logSeq;
+        log.sourceId = PID_LIGHT;
+        log.payloadLength = (uint32_t)snprintf((char *)log.payload, LOG_MSG_PAYLOAD_SIZE, "lux reading %u", logSeq);
+        log.checksum = log_packet_checksum(&log);
+        frame_batch_add(pBatch, FRAME_TYPE_LOG, &log, sizeof(LogMsgPacket));
+        ++logSeq;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief read what has arrived, waiting up to REMOTE_MUX_POLL_MS for it if
+ * wait, and time each cmd from when it was queued
+ */
+static int8_t readCmds(int fd, FrameReader_t *pReader, uint8_t wait)
+{
+    RemoteCmdPacket cmd;
+    FrameHeader_t hdr;
+    struct pollfd pfd;
+    uint8_t *pRx, *pPayload;
+    uint32_t space;
+    ssize_t len;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if(poll(&pfd, 1, wait ? REMOTE_MUX_POLL_MS : 0) != 1)
+        return EXIT_SUCCESS;
+
+    pRx = frame_reader_space(pReader, &space);
+    len = recv(fd, pRx, space, MSG_DONTWAIT);
+    if(len == 0)
+        return EXIT_FAILURE;
+    if(len < 0)
+        return ((errno == EAGAIN) || (errno == EINTR)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    frame_reader_commit(pReader, (uint32_t)len);
+
+    while(frame_reader_next(pReader, &hdr, &pPayload))
+    {
+        if((hdr.type != FRAME_TYPE_CMD) || (hdr.length != sizeof(RemoteCmdPacket)))
+            continue;
+        memcpy(&cmd, pPayload, sizeof(RemoteCmdPacket));
+        if(cmd.data >= MAX_CMDS)
+            continue;
+        hist_record(&pCurrent->latency, (uint32_t)(usecNow() - cmdSentUsec[cmd.data]));
+        __atomic_add_fetch(&pCurrent->cmdsRecvd, 1, __ATOMIC_RELAXED);
+    }
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief take log msgs off the queue as the logging thread would, counting
+ * the simulated TIVA's
+ */
+static void *drainThread(void *arg)
+{
+    mqd_t queue = *(mqd_t *)arg;
+    LogMsgPacket msg;
+    struct timespec timeout;
+
+    while(draining)
+    {
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_nsec += 10000000;
+        if(timeout.tv_nsec >= 1000000000L) {
+            timeout.tv_nsec -= 1000000000L;
+            ++timeout.tv_sec;
+        }
+        if((mq_timedreceive(queue, (char *)&msg, sizeof(LogMsgPacket), NULL, &timeout) == sizeof(LogMsgPacket)) &&
+           (msg.fileId == BENCH_LOG_FILE))
+            __atomic_add_fetch(&logsDrained, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,416 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 13, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_nodes.c
+ * @brief remote server under many nodes: CPU, data and cmd latency
+ *
+ * usage: bench_nodes [nodes] [seconds]
+ *
+ * Simulated remote nodes each connect to DATA_PORT and CMD_PORT on loopback
+ * and say hello on both, sending frames as the TIVA does. A generator sends every node's RemoteDataPacket at
+ * 1 Hz and then 50 Hz, each node at its own random phase, the packet's lux
+ * the sequence number. Data latency is from send() to the server storing it
+ * in the node table, seen by polling the table. Meanwhile cmds go to random
+ * nodes through the cmd queue, as main sends them, timed from mq_send() to
+ * the node's recv(). CPU is the server thread's own CPU time over the run.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <mqueue.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "remoteServer.h"
+#include "histogram.h"
+#include "nodeTable.h"
+#include "remoteFrame.h"
+#include "bench_server.h"
+
+#define DEFAULT_NODES           (100)
+#define DEFAULT_SECONDS         (5)
+#define FIRST_NODE_ID           (1)
+#define SEQ_RING                (256)       /* send times kept per node; far more than are in flight */
+#define POLL_USEC               (100)       /* node table polling; delays noticing, not the time taken */
+#define CMD_PERIOD_USEC         (10000)     /* 100 cmds/s */
+#define CONNECT_TIMEOUT_USEC    (5000000)
+
+typedef struct {
+    uint32_t rateHz;
+    uint32_t seconds;
+    Histogram_t data;                   /* usec */
+    Histogram_t cmd;                    /* usec */
+    uint32_t sent;
+    uint32_t stored;
+    uint32_t cmdsSent;
+    uint32_t cmdsLost;                  /* never arrived, or at the wrong node */
+    double cpuPct;                      /* server thread */
+} Run_t;
+
+typedef struct {
+    int dataFd;
+    int cmdFd;
+    uint32_t seq;
+    uint64_t nextUsec;
+    uint32_t lastCount;                 /* node table dataCount last seen */
+    volatile uint32_t cmdsPending;      /* sent its way, not yet received */
+    uint64_t sendUsec[SEQ_RING];
+} SimNode_t;
+
+static int8_t connectNodes(uint32_t nodes);
+static int8_t sendFrame(int fd, FrameType_e type, const void *pPacket, uint32_t len);
+static int8_t run(Run_t *pRun, uint32_t nodes, uint32_t seconds);
+static void *generatorThread(void *arg);
+static void *cmdReaderThread(void *arg);
+static void collect(Run_t *pRun, uint32_t nodes);
+static uint64_t usecNow(void);
+static uint64_t cpuUsec(clockid_t clock);
+static void printRun(const Run_t *pRun);
+
+static SimNode_t simNodes[NODE_TABLE_MAX_NODES];
+static BenchServer_t server;
+static volatile uint8_t running;
+static uint32_t numNodes;
+static uint32_t ratePeriodUsec;
+
+int main(int argc, char *argv[])
+{
+    uint32_t nodes = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_NODES;
+    uint32_t seconds = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : DEFAULT_SECONDS;
+    Run_t runs[] = {{1}, {50}};
+    uint32_t ind;
+    int ret = EXIT_SUCCESS;
+
+    if((nodes == 0) || (nodes > NODE_TABLE_MAX_NODES) || (seconds == 0)) {
+        ERROR_PRINT("usage: bench_nodes [1-%d nodes] [seconds]\n", NODE_TABLE_MAX_NODES);
+        return EXIT_FAILURE;
+    }
+    numNodes = nodes;
+
+    srand((unsigned int)time(NULL));
+    for(ind = 0; ind < nodes; ++ind)
+        simNodes[ind].dataFd = simNodes[ind].cmdFd = -1;
+    if((bench_server_open(&server, "bench_nodes", 0) != EXIT_SUCCESS) ||
+       (bench_server_start(&server, remoteServerThreadHandler, remoteServerSigHandler) != EXIT_SUCCESS))
+        return EXIT_FAILURE;
+
+    if(connectNodes(nodes) != EXIT_SUCCESS) {
+        ret = EXIT_FAILURE;
+    }
+    else {
+        printf("%u nodes, data at each rate for %u s, cmds to random nodes at %u/s\n",
+               nodes, seconds, 1000000 / CMD_PERIOD_USEC);
+        printf("  %4s %7s %7s %6s | %-23s | %-23s | %s\n", "", "", "", "server",
+               "data latency us", "cmd latency us", "cmds");
+        printf("  %4s %7s %7s %6s | %7s %7s %7s | %7s %7s %7s | %s\n", "Hz", "sent/s", "stored",
+               "cpu %", "p50", "p99", "max", "p50", "p99", "max", "lost");
+        for(ind = 0; ind < (sizeof(runs) / sizeof(runs[0])); ++ind)
+        {
+            if(run(&runs[ind], nodes, seconds) != EXIT_SUCCESS)
+                ret = EXIT_FAILURE;
+            printRun(&runs[ind]);
+            if(runs[ind].cmdsLost != 0)
+                ret = EXIT_FAILURE;
+        }
+    }
+
+    for(ind = 0; ind < nodes; ++ind)
+    {
+        if(simNodes[ind].dataFd >= 0)
+            close(simNodes[ind].dataFd);
+        if(simNodes[ind].cmdFd >= 0)
+            close(simNodes[ind].cmdFd);
+    }
+    bench_server_close(&server);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief connect every node's data and cmd ports, wait for the server to
+ * have named both
+ */
+static int8_t connectNodes(uint32_t nodes)
+{
+    RemoteNode_t node;
+    uint64_t start;
+    uint32_t ind, named;
+
+    for(ind = 0; ind < nodes; ++ind)
+    {
+        simNodes[ind].dataFd = bench_connect(DATA_PORT, (uint16_t)(FIRST_NODE_ID + ind));
+        simNodes[ind].cmdFd = bench_connect(CMD_PORT, (uint16_t)(FIRST_NODE_ID + ind));
+        if((simNodes[ind].dataFd < 0) || (simNodes[ind].cmdFd < 0)) {
+            ERROR_PRINT("bench_nodes: node %u couldn't connect\n", FIRST_NODE_ID + ind);
+            for(++ind; ind < nodes; ++ind)
+                simNodes[ind].dataFd = simNodes[ind].cmdFd = -1;
+            return EXIT_FAILURE;
+        }
+    }
+
+    start = usecNow();
+    do {
+        for(ind = 0, named = 0; ind < nodes; ++ind)
+        {
+            if((node_table_get((uint16_t)(FIRST_NODE_ID + ind), &node) == EXIT_SUCCESS) &&
+               (__builtin_popcount(node.ports) == 2))
+                ++named;
+        }
+        if(named == nodes)
+            return EXIT_SUCCESS;
+        usleep(1000);
+    } while((usecNow() - start) < CONNECT_TIMEOUT_USEC);
+
+    ERROR_PRINT("bench_nodes: only %u of %u nodes in the node table\n", named, nodes);
+    return EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a packet framed, in one send()
+ */
+static int8_t sendFrame(int fd, FrameType_e type, const void *pPacket, uint32_t len)
+{
+    uint8_t buf[FRAME_MAX_SIZE];
+    FrameHeader_t hdr;
+
+    frame_header(&hdr, type, pPacket, len);
+    memcpy(buf, &hdr, sizeof(FrameHeader_t));
+    memcpy(&buf[sizeof(FrameHeader_t)], pPacket, len);
+    len += sizeof(FrameHeader_t);
+    return (send(fd, buf, len, MSG_NOSIGNAL) == (ssize_t)len) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief one rate; generator and cmd reader threads, cmds sent and the
+ * node table collected from this one
+ */
+static int8_t run(Run_t *pRun, uint32_t nodes, uint32_t seconds)
+{
+    RemoteCmdPacket cmdPacket;
+    pthread_t generator, cmdReader;
+    clockid_t serverClock;
+    uint64_t start, end, nextCmd, cpuStart;
+    uint32_t ind, node;
+    int8_t ret = EXIT_SUCCESS;
+
+    hist_reset(&pRun->data);
+    hist_reset(&pRun->cmd);
+    pRun->sent = pRun->stored = pRun->cmdsSent = pRun->cmdsLost = 0;
+    pRun->seconds = seconds;
+    ratePeriodUsec = 1000000 / pRun->rateHz;
+    start = usecNow();
+    for(ind = 0; ind < nodes; ++ind)
+    {
+        simNodes[ind].nextUsec = start + (uint64_t)(rand() % ratePeriodUsec);
+        simNodes[ind].cmdsPending = 0;
+    }
+    collect(NULL, nodes);   /* only what is sent from here on */
+
+    if(pthread_getcpuclockid(server.thread, &serverClock) != 0)
+        return EXIT_FAILURE;
+    cpuStart = cpuUsec(serverClock);
+    running = 1;
+    if(pthread_create(&generator, NULL, generatorThread, pRun) != 0)
+        return EXIT_FAILURE;
+    if(pthread_create(&cmdReader, NULL, cmdReaderThread, pRun) != 0) {
+        running = 0;
+        pthread_join(generator, NULL);
+        return EXIT_FAILURE;
+    }
+
+    memset(&cmdPacket, 0, sizeof(RemoteCmdPacket));
+    cmdPacket.cmd = REMOTE_WATERPLANT;
+    end = start + ((uint64_t)seconds * 1000000ULL);
+    nextCmd = start + CMD_PERIOD_USEC;
+    while(usecNow() < end)
+    {
+        if(usecNow() >= nextCmd) {
+            node = (uint32_t)rand() % nodes;
+            cmdPacket.header = (uint16_t)(FIRST_NODE_ID + node);
+            __sync_fetch_and_add(&simNodes[node].cmdsPending, 1);
+            cmdPacket.data = (uint32_t)usecNow();
+            if(mq_send(server.cmdQueue, (char *)&cmdPacket, sizeof(RemoteCmdPacket), 0) == 0)
+                ++pRun->cmdsSent;
+            else
+                __sync_fetch_and_sub(&simNodes[node].cmdsPending, 1);
+            nextCmd += CMD_PERIOD_USEC;
+        }
+        collect(pRun, nodes);
+        usleep(POLL_USEC);
+    }
+    running = 0;
+    pthread_join(generator, NULL);
+    pRun->cpuPct = (100.0 * (double)(cpuUsec(serverClock) - cpuStart)) / (double)(usecNow() - start);
+
+    /* stragglers */
+    usleep(100000);
+    collect(pRun, nodes);
+    pthread_join(cmdReader, NULL);
+    for(ind = 0; ind < nodes; ++ind)
+        pRun->cmdsLost += simNodes[ind].cmdsPending;
+    if(pRun->stored == 0)
+        ret = EXIT_FAILURE;
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief send each node's data when it is due
+ */
+static void *generatorThread(void *arg)
+{
+    Run_t *pRun = (Run_t *)arg;
+    RemoteDataPacket packet;
+    SimNode_t *pNode;
+    uint64_t now;
+    uint32_t ind, next;
+
+    memset(&packet, 0, sizeof(RemoteDataPacket));
+    while(running)
+    {
+        for(ind = 1, next = 0; ind < numNodes; ++ind)
+        {
+            if(simNodes[ind].nextUsec < simNodes[next].nextUsec)
+                next = ind;
+        }
+        pNode = &simNodes[next];
+        now = usecNow();
+        if(pNode->nextUsec > now) {
+            usleep((useconds_t)(pNode->nextUsec - now));
+            continue;
+        }
+
+        ++pNode->seq;
+        packet.luxData = (float)(pNode->seq % SEQ_RING);
+        pNode->sendUsec[pNode->seq % SEQ_RING] = usecNow();
+        if(sendFrame(pNode->dataFd, FRAME_TYPE_DATA, &packet, sizeof(RemoteDataPacket)) == EXIT_SUCCESS)
+            ++pRun->sent;
+        pNode->nextUsec += ratePeriodUsec;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief receive cmds at every node, time them and check they went to the
+ * node they were sent to
+ */
+static void *cmdReaderThread(void *arg)
+{
+    Run_t *pRun = (Run_t *)arg;
+    static FrameReader_t readers[NODE_TABLE_MAX_NODES];
+    static uint32_t readerBufs[NODE_TABLE_MAX_NODES][FRAME_READER_SIZE / sizeof(uint32_t)];
+    struct pollfd fds[NODE_TABLE_MAX_NODES];
+    RemoteCmdPacket cmdPacket;
+    FrameHeader_t hdr;
+    uint8_t *pRx, *pPayload;
+    uint32_t ind, space;
+    ssize_t len;
+    int num = 0;
+
+    for(ind = 0; ind < numNodes; ++ind)
+    {
+        fds[ind].fd = simNodes[ind].cmdFd;
+        fds[ind].events = POLLIN;
+        frame_reader_init(&readers[ind], (uint8_t *)readerBufs[ind]);
+    }
+    while(running || (num > 0))
+    {
+        num = poll(fds, numNodes, 100);
+        for(ind = 0; (num > 0) && (ind < numNodes); ++ind)
+        {
+            if(!(fds[ind].revents & POLLIN))
+                continue;
+            pRx = frame_reader_space(&readers[ind], &space);
+            if((len = recv(fds[ind].fd, pRx, space, 0)) <= 0)
+                continue;
+            frame_reader_commit(&readers[ind], (uint32_t)len);
+            while(frame_reader_next(&readers[ind], &hdr, &pPayload))
+            {
+                if((hdr.type != FRAME_TYPE_CMD) || (hdr.length != sizeof(RemoteCmdPacket)))
+                    continue;
+                memcpy(&cmdPacket, pPayload, sizeof(RemoteCmdPacket));
+                hist_record(&pRun->cmd, (uint32_t)usecNow() - cmdPacket.data);
+                if(simNodes[ind].cmdsPending == 0)
+                    ERROR_PRINT("bench_nodes: node %u got a cmd sent to another\n", FIRST_NODE_ID + ind);
+                else
+                    __sync_fetch_and_sub(&simNodes[ind].cmdsPending, 1);
+            }
+        }
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief data latency of whatever the server stored since last looked;
+ * NULL pRun only notes where each node is
+ */
+static void collect(Run_t *pRun, uint32_t nodes)
+{
+    RemoteNode_t node;
+    SimNode_t *pNode;
+    uint32_t ind, seq;
+
+    for(ind = 0; ind < nodes; ++ind)
+    {
+        pNode = &simNodes[ind];
+        if((node_table_get((uint16_t)(FIRST_NODE_ID + ind), &node) != EXIT_SUCCESS) ||
+           (node.dataCount == pNode->lastCount))
+            continue;
+        if(pRun != NULL) {
+            seq = (uint32_t)node.data.luxData;
+            pRun->stored += node.dataCount - pNode->lastCount;
+            hist_record(&pRun->data, (uint32_t)(node.dataUsec - pNode->sendUsec[seq % SEQ_RING]));
+        }
+        pNode->lastCount = node.dataCount;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t cpuUsec(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printRun(const Run_t *pRun)
+{
+    printf("  %4u %7u %6.1f%% %6.2f | %7u %7u %7u | %7u %7u %7u | %u of %u\n", pRun->rateHz,
+           pRun->sent / pRun->seconds, (pRun->sent != 0) ? (100.0 * pRun->stored) / pRun->sent : 0.0,
+           pRun->cpuPct, hist_percentile(&pRun->data, 50.0), hist_percentile(&pRun->data, 99.0),
+           pRun->data.max, hist_percentile(&pRun->cmd, 50.0), hist_percentile(&pRun->cmd, 99.0),
+           pRun->cmd.max, pRun->cmdsLost, pRun->cmdsSent);
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,270 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 12, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_remote.c
+ * @brief remote data latency, per-port thread vs the epoll server
+ *
+ * usage: bench_remote [packets]
+ *
+ * A stand-in remote node connects to DATA_PORT on loopback and sends a
+ * RemoteDataPacket at a random point in time, waiting for each to reach main
+ * before sending the next. Timed from send() to the packet being in the data
+ * msg queue (remoteDataThread) or stored in the node table (remoteServerThread,
+ * which the stand-in says hello to first and sends frames), same port.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <mqueue.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "remoteThread.h"
+#include "remoteServer.h"
+#include "healthMonitor.h"
+#include "histogram.h"
+#include "nodeTable.h"
+#include "remoteFrame.h"
+#include "bench_server.h"
+
+#define DEFAULT_PACKETS         (100)
+#define MAX_PHASE_USEC          ((uint32_t)(REMOTE_LOOP_TIME_NSEC / 1000))  /* spread sends over a whole tick */
+#define CONNECT_TIMEOUT_USEC    (5000000)
+#define RECV_TIMEOUT_SEC        (5)
+#define BENCH_NODE_ID           (1)
+#define POLL_USEC               (50)
+
+typedef struct {
+    const char *pName;
+    void *(*handler)(void *);
+    void (*sigHandler)(int, siginfo_t *, void *);
+    uint8_t nodeTable;                  /* framed, hello first, data to the node table */
+    Histogram_t latency;                /* usec */
+} Design_t;
+
+static int8_t run(Design_t *pDesign, uint32_t packets);
+static int8_t waitQueue(RemoteDataPacket *pPacket, uint64_t *pUsec);
+static int8_t waitNodeTable(RemoteDataPacket *pPacket, uint64_t *pUsec);
+static int connectData(void);
+static int8_t sendPacket(int fd, uint8_t framed, FrameType_e type, const void *pPacket, uint32_t len);
+static uint64_t usecNow(void);
+static void printLatency(const Design_t *pDesign);
+
+static BenchServer_t server;
+
+int main(int argc, char *argv[])
+{
+    uint32_t packets = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_PACKETS;
+    Design_t designs[] = {
+        {"per port", remoteDataThreadHandler, remoteDataSigHandler, 0},
+        {"epoll", remoteServerThreadHandler, remoteServerSigHandler, 1},
+    };
+    sigset_t mask;
+    uint8_t ind;
+    int ret = EXIT_SUCCESS;
+
+    if(packets == 0)
+        return EXIT_FAILURE;
+
+    /* main's read of the data queue blocks */
+    if(bench_server_open(&server, "bench_remote", BENCH_SERVER_DATA_QUEUE) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    /* remoteDataThread's timer is a process SIGALRM it sigwait()s for */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    srand((unsigned int)time(NULL));
+
+    printf("remote data latency, %u packets at random phase, send to data queue\n", packets);
+    printf("  %-10s %8s %8s %8s %8s %8s\n", "design", "min us", "p50 us", "p90 us", "p99 us", "max us");
+    for(ind = 0; ind < (sizeof(designs) / sizeof(designs[0])); ++ind)
+    {
+        hist_reset(&designs[ind].latency);
+        if(run(&designs[ind], packets) != EXIT_SUCCESS)
+            ret = EXIT_FAILURE;
+        printLatency(&designs[ind]);
+    }
+
+    bench_server_close(&server);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief start the design's thread, time packets through it, kill it
+ */
+static int8_t run(Design_t *pDesign, uint32_t packets)
+{
+    RemoteDataPacket packet, rxPacket;
+    RemoteHelloPacket hello = {REMOTE_HELLO_HEADER, BENCH_NODE_ID};
+    uint64_t start, end;
+    uint32_t ind;
+    int8_t ret = EXIT_SUCCESS;
+    int fd;
+
+    if(bench_server_start(&server, pDesign->handler, pDesign->sigHandler) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    fd = connectData();
+    if(fd < 0) {
+        ERROR_PRINT("%s: couldn't connect to data port\n", pDesign->pName);
+        ret = EXIT_FAILURE;
+    }
+    else if(pDesign->nodeTable && (sendPacket(fd, 1, FRAME_TYPE_HELLO, &hello, sizeof(hello)) != EXIT_SUCCESS)) {
+        ERRNO_PRINT("bench_remote hello");
+        ret = EXIT_FAILURE;
+    }
+
+    memset(&packet, 0, sizeof(RemoteDataPacket));
+    for(ind = 0; (ret == EXIT_SUCCESS) && (ind < packets); ++ind)
+    {
+        usleep((useconds_t)(rand() % MAX_PHASE_USEC));
+        packet.luxData = (float)ind;
+        start = usecNow();
+        if(sendPacket(fd, pDesign->nodeTable, FRAME_TYPE_DATA, &packet, sizeof(RemoteDataPacket)) != EXIT_SUCCESS) {
+            ERRNO_PRINT("bench_remote send");
+            ret = EXIT_FAILURE;
+            break;
+        }
+        if(((pDesign->nodeTable) ? waitNodeTable(&rxPacket, &end) : waitQueue(&rxPacket, &end)) != EXIT_SUCCESS) {
+            ERROR_PRINT("%s: packet %u never reached main\n", pDesign->pName, ind);
+            ret = EXIT_FAILURE;
+            break;
+        }
+        hist_record(&pDesign->latency, (uint32_t)(end - start));
+        if(rxPacket.luxData != packet.luxData) {
+            ERROR_PRINT("%s: packet %u out of order\n", pDesign->pName, ind);
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if(fd >= 0)
+        close(fd);
+    bench_server_stop(&server);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief next packet from the data queue and when it was read
+ */
+static int8_t waitQueue(RemoteDataPacket *pPacket, uint64_t *pUsec)
+{
+    struct timespec timeout;
+
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_sec += RECV_TIMEOUT_SEC;
+    if(mq_timedreceive(server.dataQueue, (char *)pPacket, DATA_MSG_QUEUE_MSG_SIZE, NULL, &timeout) < 0)
+        return EXIT_FAILURE;
+    *pUsec = usecNow();
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief next packet stored for the node and when the server stored it;
+ * polling only delays noticing, not the time taken
+ */
+static int8_t waitNodeTable(RemoteDataPacket *pPacket, uint64_t *pUsec)
+{
+    static uint32_t lastCount = 0;
+    RemoteNode_t node;
+    uint64_t start = usecNow();
+
+    while((usecNow() - start) < (RECV_TIMEOUT_SEC * 1000000ULL))
+    {
+        if((node_table_get(BENCH_NODE_ID, &node) == EXIT_SUCCESS) && (node.dataCount != lastCount)) {
+            lastCount = node.dataCount;
+            *pPacket = node.data;
+            *pUsec = node.dataUsec;
+            return EXIT_SUCCESS;
+        }
+        usleep(POLL_USEC);
+    }
+    return EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief connect to loopback DATA_PORT once the thread is listening
+ */
+static int connectData(void)
+{
+    struct sockaddr_in addr;
+    uint64_t start = usecNow();
+    int fd;
+
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(DATA_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    while((usecNow() - start) < CONNECT_TIMEOUT_USEC)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(fd < 0)
+            return -1;
+        if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+            return fd;
+        close(fd);
+        usleep(10000);
+    }
+    return -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a packet in one send(), in a frame or as it is
+ */
+static int8_t sendPacket(int fd, uint8_t framed, FrameType_e type, const void *pPacket, uint32_t len)
+{
+    uint8_t buf[FRAME_MAX_SIZE];
+    FrameHeader_t hdr;
+    uint32_t size = 0;
+
+    if(framed) {
+        frame_header(&hdr, type, pPacket, len);
+        memcpy(buf, &hdr, sizeof(FrameHeader_t));
+        size = sizeof(FrameHeader_t);
+    }
+    memcpy(&buf[size], pPacket, len);
+    size += len;
+    return (send(fd, buf, size, MSG_NOSIGNAL) == (ssize_t)size) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printLatency(const Design_t *pDesign)
+{
+    printf("  %-10s %8u %8u %8u %8u %8u\n", pDesign->pName, pDesign->latency.min,
+           hist_percentile(&pDesign->latency, 50.0), hist_percentile(&pDesign->latency, 90.0),
+           hist_percentile(&pDesign->latency, 99.0), pDesign->latency.max);
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,207 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 12, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_server.c
+ * @brief remote server fixture shared by the remote benches and tests
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "my_debug.h"
+#include "logger.h"
+#include "remoteServer.h"
+#include "heartbeat.h"
+#include "nodeTable.h"
+#include "bench_server.h"
+
+#define CONNECT_TIMEOUT_USEC    (5000000)
+#define CONNECT_RETRY_USEC      (10000)
+
+static mqd_t openQueue(char *pName, const char *pBench, const char *pSuffix, long depth, long msgSize, int flags);
+static uint64_t usecNow(void);
+
+/*---------------------------------------------------------------------------------*/
+int8_t bench_server_open(BenchServer_t *pServer, const char *pName, uint8_t flags)
+{
+    static LogThreadInfo logInfo;
+    SensorThreadInfo *pInfo = &pServer->sensorInfo;
+    int logFlags = (flags & BENCH_SERVER_LOG_QUEUE) ? 0 : O_NONBLOCK;
+
+    memset(pServer, 0, sizeof(BenchServer_t));
+    pServer->dataQueue = -1;
+
+    /* the thread opens these by name, as it does from main */
+    pServer->hbQueue = openQueue(pInfo->heartbeatMsgQueueName, pName, "hb_mq", STATUS_MSG_QUEUE_DEPTH,
+                                 STATUS_MSG_QUEUE_MSG_SIZE, O_NONBLOCK);
+    pServer->logQueue = openQueue(pInfo->logMsgQueueName, pName, "log_mq", LOG_MSG_QUEUE_DEPTH,
+                                  LOG_MSG_QUEUE_MSG_SIZE, logFlags);
+    pServer->cmdQueue = openQueue(pInfo->cmdMsgQueueName, pName, "cmd_mq", STATUS_MSG_QUEUE_DEPTH,
+                                  CMD_MSG_QUEUE_MSG_SIZE, O_NONBLOCK);
+    if(flags & BENCH_SERVER_DATA_QUEUE)
+        pServer->dataQueue = openQueue(pInfo->dataMsgQueueName, pName, "data_mq", STATUS_MSG_QUEUE_DEPTH,
+                                       DATA_MSG_QUEUE_MSG_SIZE, 0);
+    snprintf(pServer->heartbeatName, IPC_NAME_SIZE, "/%s_shm", pName);
+
+    if((pServer->hbQueue == -1) || (pServer->logQueue == -1) || (pServer->cmdQueue == -1) ||
+       ((flags & BENCH_SERVER_DATA_QUEUE) && (pServer->dataQueue == -1)) ||
+       (heartbeat_init(pServer->heartbeatName) != EXIT_SUCCESS)) {
+        ERRNO_PRINT("bench_server_open couldn't create queues");
+        return EXIT_FAILURE;
+    }
+
+    /* the server's own logs, to be read off the queue by the bench */
+    if(flags & BENCH_SERVER_LOG_QUEUE) {
+        memset(&logInfo, 0, sizeof(LogThreadInfo));
+        strcpy(logInfo.logMsgQueueName, pInfo->logMsgQueueName);
+        if(LOG_INIT(&logInfo) != LOG_STATUS_OK) {
+            ERROR_PRINT("bench_server_open couldn't init logger\n");
+            return EXIT_FAILURE;
+        }
+    }
+    node_table_init();
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t bench_server_start(BenchServer_t *pServer, void *(*handler)(void *),
+                          void (*sigHandler)(int, siginfo_t *, void *))
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = sigHandler;
+    sigaction(SIGRTMIN + (uint8_t)REMOTE_SERVER_PID, &action, NULL);
+    if(pthread_create(&pServer->thread, NULL, handler, &pServer->sensorInfo) != 0) {
+        ERROR_PRINT("bench_server_start couldn't create thread\n");
+        return EXIT_FAILURE;
+    }
+    pServer->running = 1;
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------*/
+void bench_server_stop(BenchServer_t *pServer)
+{
+    if(pServer->running) {
+        pthread_kill(pServer->thread, SIGRTMIN + (uint8_t)REMOTE_SERVER_PID);
+        pthread_join(pServer->thread, NULL);
+        pServer->running = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+void bench_server_close(BenchServer_t *pServer)
+{
+    SensorThreadInfo *pInfo = &pServer->sensorInfo;
+
+    bench_server_stop(pServer);
+    heartbeat_destroy(pServer->heartbeatName);
+    mq_close(pServer->hbQueue);
+    mq_close(pServer->logQueue);
+    mq_close(pServer->cmdQueue);
+    mq_unlink(pInfo->heartbeatMsgQueueName);
+    mq_unlink(pInfo->logMsgQueueName);
+    mq_unlink(pInfo->cmdMsgQueueName);
+    if(pServer->dataQueue != -1) {
+        mq_close(pServer->dataQueue);
+        mq_unlink(pInfo->dataMsgQueueName);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+int bench_connect(uint16_t port, uint16_t nodeId)
+{
+    RemoteHelloPacket hello = {REMOTE_HELLO_HEADER, nodeId};
+    uint8_t buf[sizeof(FrameHeader_t) + sizeof(RemoteHelloPacket)];
+    struct sockaddr_in addr;
+    uint64_t start = usecNow();
+    int noDelay = 1;
+    int fd;
+
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    frame_header((FrameHeader_t *)buf, FRAME_TYPE_HELLO, &hello, sizeof(hello));
+    memcpy(&buf[sizeof(FrameHeader_t)], &hello, sizeof(hello));
+
+    /* the thread may not be listening yet */
+    while((usecNow() - start) < CONNECT_TIMEOUT_USEC)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(fd < 0)
+            return -1;
+        if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            if(send(fd, buf, sizeof(buf), MSG_NOSIGNAL) == (ssize_t)sizeof(buf))
+                return fd;
+            close(fd);
+            return -1;
+        }
+        close(fd);
+        usleep(CONNECT_RETRY_USEC);
+    }
+    ERROR_PRINT("bench_connect couldn't connect to port %u\n", port);
+    return -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+int8_t bench_send_batch(int fd, FrameBatch_t *pBatch)
+{
+    uint32_t len = frame_batch_finish(pBatch);
+    ssize_t sent;
+
+    sent = send(fd, &pBatch->hdr, len, MSG_NOSIGNAL);
+    frame_batch_init(pBatch);
+    return (sent == (ssize_t)len) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief "/<bench>_<suffix>" into pName (IPC_NAME_SIZE), and the queue
+ * created with it
+ */
+static mqd_t openQueue(char *pName, const char *pBench, const char *pSuffix, long depth, long msgSize, int flags)
+{
+    struct mq_attr mqAttr;
+    int len;
+
+    len = snprintf(pName, IPC_NAME_SIZE, "/%s_%s", pBench, pSuffix);
+    if((len < 0) || (len >= IPC_NAME_SIZE))
+        return (mqd_t)-1;
+
+    memset(&mqAttr, 0, sizeof(struct mq_attr));
+    mqAttr.mq_maxmsg = depth;
+    mqAttr.mq_msgsize = msgSize;
+    return mq_open(pName, O_CREAT | O_RDWR | flags, 0666, &mqAttr);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
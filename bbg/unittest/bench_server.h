@@ -0,0 +1,104 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 12, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_server.h
+ * @brief remote server fixture shared by the remote benches and tests
+ *
+ * The queues and heartbeat table a remote thread opens by name, set up as
+ * main sets them up, and the thread started and killed as main and the
+ * supervisor do. Names are made from the bench's, so two benches can run
+ * at once. Also the stand-in remote node's side: a loopback connection that
+ * has said hello, and a batch sent as the TIVA sends it.
+ *
+ ************************************************************************************
+ */
+
+#ifndef BENCH_SERVER_H_
+#define BENCH_SERVER_H_
+
+#include <stdint.h>
+#include <signal.h>
+#include <pthread.h>
+#include <mqueue.h>
+
+#include "packet.h"
+#include "remoteFrame.h"
+
+/* bench_server_open() flags */
+#define BENCH_SERVER_LOG_QUEUE      (0x01)  /* log queue read blocking by the bench, LOG_INIT() on it */
+#define BENCH_SERVER_DATA_QUEUE     (0x02)  /* data queue, read blocking by the bench */
+
+typedef struct {
+    SensorThreadInfo sensorInfo;        /* queue names, passed to the thread */
+    mqd_t hbQueue;
+    mqd_t logQueue;
+    mqd_t dataQueue;                    /* -1 without BENCH_SERVER_DATA_QUEUE */
+    mqd_t cmdQueue;
+    pthread_t thread;
+    uint8_t running;
+    char heartbeatName[IPC_NAME_SIZE];
+} BenchServer_t;
+
+/**
+ * @brief create the queues and heartbeat table, clear the node table
+ *
+ * @param pServer fixture to set up
+ * @param pName bench name, queue and shared memory names start with it
+ * @param flags BENCH_SERVER_ flags
+ * @return int8_t EXIT_SUCCESS or EXIT_FAILURE
+ */
+int8_t bench_server_open(BenchServer_t *pServer, const char *pName, uint8_t flags);
+
+/**
+ * @brief start a remote thread, killed with SIGRTMIN + REMOTE_SERVER_PID
+ *
+ * @param pServer fixture from bench_server_open()
+ * @param handler thread function
+ * @param sigHandler its kill signal handler
+ * @return int8_t EXIT_SUCCESS or EXIT_FAILURE
+ */
+int8_t bench_server_start(BenchServer_t *pServer, void *(*handler)(void *),
+                          void (*sigHandler)(int, siginfo_t *, void *));
+
+/**
+ * @brief kill the thread and wait for it to exit
+ *
+ * @param pServer fixture
+ */
+void bench_server_stop(BenchServer_t *pServer);
+
+/**
+ * @brief stop the thread if running, remove the queues and heartbeat table
+ *
+ * @param pServer fixture
+ */
+void bench_server_close(BenchServer_t *pServer);
+
+/**
+ * @brief blocking loopback connection to a port with TCP_NODELAY, so each
+ * send() is its own segment as FreeRTOS+TCP sends them, hello sent
+ *
+ * @param port port to connect to
+ * @param nodeId node ID to say hello as
+ * @return int socket, -1 if the port didn't take a connection in time
+ */
+int bench_connect(uint16_t port, uint16_t nodeId);
+
+/**
+ * @brief a batch in one send(), as sendSocketBatch() sends it; the batch
+ * is started over either way
+ *
+ * @param fd connected socket
+ * @param pBatch batch of at least one record
+ * @return int8_t EXIT_SUCCESS if it was all sent
+ */
+int8_t bench_send_batch(int fd, FrameBatch_t *pBatch);
+
+#endif /* BENCH_SERVER_H_ */
@@ -0,0 +1,248 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 10, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_snapshot.c
+ * @brief load test of the health snapshot socket
+ *
+ * usage: bench_snapshot [readers] [hz] [seconds]     (default 100 100 10)
+ *
+ * A publisher thread stands in for main, publishing a snapshot every
+ * PUBLISH_PERIOD_USEC (faster than main does, so readers race it more) and
+ * timing each publish. Each reader thread holds a connection and asks for a
+ * binary snapshot every 1/hz s. Reports replies against the target rate,
+ * request to reply latency, and how long publishing took while loaded.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "my_debug.h"
+#include "healthSnapshot.h"
+#include "heartbeat.h"
+#include "histogram.h"
+
+#define BENCH_SOCKET            "/tmp/bench_snapshot.sock"
+#define BENCH_HEARTBEAT_NAME    "/bench_snapshot_shm"
+#define DEFAULT_READERS         (100)
+#define DEFAULT_HZ              (100)
+#define DEFAULT_SECONDS         (10)
+#define PUBLISH_PERIOD_USEC     (1000)
+#define MIN_REPLY_PCT           (95)
+#define NSEC_PER_SEC            (1000000000ULL)
+
+typedef struct {
+    pthread_t thread;
+    uint32_t replies;
+    uint32_t errors;
+    Histogram_t latency;        /* usec */
+} Reader_t;
+
+static void *readerThread(void *pArg);
+static void *publisherThread(void *pArg);
+static int connectServer(void);
+static uint64_t nsecNow(void);
+static void addNsec(struct timespec *pTime, uint64_t nsec);
+
+static volatile uint8_t running = 1;
+static uint32_t hz = DEFAULT_HZ;
+static Histogram_t publishHist;     /* nsec */
+
+int main(int argc, char *argv[])
+{
+    uint32_t numReaders = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_READERS;
+    uint32_t seconds = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : DEFAULT_SECONDS;
+    HealthSnapshotServer_t server;
+    pthread_t serverThread, publisher;
+    Reader_t *pReaders;
+    Histogram_t latency;
+    char line[HIST_FORMAT_SIZE], json[HEALTH_SNAPSHOT_JSON_SIZE];
+    uint64_t replies = 0, target;
+    uint32_t ind, errors = 0;
+    ssize_t len = 0;
+    int fd;
+
+    hz = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : DEFAULT_HZ;
+    if((numReaders == 0) || (numReaders > HEALTH_SNAPSHOT_MAX_CLIENTS) || (hz == 0) || (seconds == 0)) {
+        ERROR_PRINT("usage: %s [readers <= %d] [hz] [seconds]\n", argv[0], HEALTH_SNAPSHOT_MAX_CLIENTS);
+        return EXIT_FAILURE;
+    }
+    pReaders = calloc(numReaders, sizeof(Reader_t));
+    if((pReaders == NULL) || (heartbeat_init(BENCH_HEARTBEAT_NAME) != EXIT_SUCCESS) ||
+       (health_snapshot_server_init(&server, BENCH_SOCKET) != EXIT_SUCCESS)) {
+        ERROR_PRINT("bench_snapshot setup failed\n");
+        return EXIT_FAILURE;
+    }
+    hist_reset(&publishHist);
+    pthread_create(&serverThread, NULL, healthSnapshotThreadHandler, &server);
+    pthread_create(&publisher, NULL, publisherThread, NULL);
+    usleep(10000);
+
+    /* one JSON reply, to see it's whole */
+    fd = connectServer();
+    if((fd >= 0) && (send(fd, "j", 1, MSG_NOSIGNAL) == 1)) {
+        while((len < (ssize_t)sizeof(json) - 1) && (recv(fd, &json[len], 1, 0) == 1) && (json[len++] != '\n'));
+    }
+    json[len] = '\0';
+    if((fd < 0) || (len < 3) || (json[0] != '{') || (strcmp(&json[len - 3], "}}\n") != 0)) {
+        ERROR_PRINT("bad JSON reply: %s\n", json);
+        ++errors;
+    }
+    else {
+        printf("JSON reply, %d bytes: %s", (int)len, json);
+    }
+    if(fd >= 0)
+        close(fd);
+
+    printf("%u readers at %u Hz for %u s, snapshot published every %u usec\n", numReaders, hz, seconds, PUBLISH_PERIOD_USEC);
+    for(ind = 0; ind < numReaders; ++ind)
+        pthread_create(&pReaders[ind].thread, NULL, readerThread, &pReaders[ind]);
+    sleep(seconds);
+    running = 0;
+
+    hist_reset(&latency);
+    for(ind = 0; ind < numReaders; ++ind)
+    {
+        pthread_join(pReaders[ind].thread, NULL);
+        replies += pReaders[ind].replies;
+        errors += pReaders[ind].errors;
+        hist_add(&latency, &pReaders[ind].latency);
+    }
+    pthread_join(publisher, NULL);
+    health_snapshot_server_stop(&server);
+    pthread_join(serverThread, NULL);
+
+    target = (uint64_t)numReaders * hz * seconds;
+    printf("  replies:  %llu of %llu target (%.1f%%), %.0f/s, %u errors\n", (unsigned long long)replies,
+           (unsigned long long)target, 100.0 * replies / target, (double)replies / seconds, errors);
+    hist_format(&latency, line, sizeof(line));
+    printf("  latency usec:  %s\n", line);
+    hist_format(&publishHist, line, sizeof(line));
+    printf("  publish nsec:  %s\n", line);
+
+    heartbeat_destroy(BENCH_HEARTBEAT_NAME);
+    free(pReaders);
+    return ((errors == 0) && ((replies * 100) >= (target * MIN_REPLY_PCT))) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief poll at hz on an absolute schedule; a slow reply delays the next
+ * request rather than queueing more
+ */
+static void *readerThread(void *pArg)
+{
+    Reader_t *pReader = (Reader_t *)pArg;
+    HealthSnapshot_t snap;
+    struct timespec next;
+    uint32_t lastSeq = 0;
+    uint64_t start;
+    int fd;
+
+    hist_reset(&pReader->latency);
+    fd = connectServer();
+    if(fd < 0) {
+        ++pReader->errors;
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while(running)
+    {
+        start = nsecNow();
+        if((send(fd, "b", 1, MSG_NOSIGNAL) != 1) ||
+           (recv(fd, &snap, sizeof(HealthSnapshot_t), MSG_WAITALL) != sizeof(HealthSnapshot_t)) ||
+           (snap.magic != HEALTH_SNAPSHOT_MAGIC) || (snap.seq < lastSeq) ||
+           (snap.queueDepth[SNAPSHOT_QUEUE_LOG] != (int32_t)(snap.seq % 10))) {
+            ++pReader->errors;
+            break;
+        }
+        hist_record(&pReader->latency, (uint32_t)((nsecNow() - start) / 1000));
+        lastSeq = snap.seq;
+        ++pReader->replies;
+
+        addNsec(&next, NSEC_PER_SEC / hz);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    close(fd);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief stand in for main's loop; log queue depth tracks seq so readers can
+ * tell a torn copy
+ */
+static void *publisherThread(void *pArg)
+{
+    HealthSnapshot_t snap;
+    uint32_t loops = 0;
+    uint64_t start;
+
+    memset(&snap, 0, sizeof(HealthSnapshot_t));
+    while(running)
+    {
+        heartbeat_publish(PID_REMOTE_DATA, STATUS_OK, ERROR_CODE_USER_NONE0);
+        snap.controlLoopState = (uint8_t)(loops % 4);
+        snap.systemState = NOMINAL;
+        snap.luxData = (float)loops;
+        snap.queueDepth[SNAPSHOT_QUEUE_LOG] = (int32_t)((loops + 1) % 10);
+
+        start = nsecNow();
+        health_snapshot_publish(&snap);
+        hist_record(&publishHist, (uint32_t)(nsecNow() - start));
+        ++loops;
+        usleep(PUBLISH_PERIOD_USEC);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int connectServer(void)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    memset(&addr, 0, sizeof(struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, BENCH_SOCKET);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if((fd >= 0) && (connect(fd, (struct sockaddr *)&addr, sizeof(struct sockaddr_un)) < 0)) {
+        ERRNO_PRINT("bench_snapshot connect");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t nsecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * NSEC_PER_SEC) + now.tv_nsec;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void addNsec(struct timespec *pTime, uint64_t nsec)
+{
+    nsec += pTime->tv_nsec;
+    pTime->tv_sec += nsec / NSEC_PER_SEC;
+    pTime->tv_nsec = nsec % NSEC_PER_SEC;
+}
@@ -0,0 +1,203 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 9, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_status.c
+ * @brief status link load with and without heartbeat coalescing
+ *
+ * usage: bench_status [seconds] [errorEverySec]
+ *
+ * Replays the TIVA's status traffic in simulated time: each task that
+ * reports (light, moisture, observer, solenoid; the remote task doesn't)
+ * sends STATUS_OK every TASK_LOOP_MS, and moisture sends a STATUS_ERROR in
+ * place of one every errorEverySec. The msgs go through remoteStatusTask's
+ * send logic as it was (one packet per msg) and with the coalescer, and
+ * each packet is decoded as remoteStatusThread does. Reports packets and
+ * bytes per second (payload, and on the wire with Ethernet/IPv4/TCP
+ * headers), and the longest gap between one task's heartbeats at the BBG,
+ * which must stay under the health monitor deadline.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "packet.h"
+#include "healthMonitor.h"
+#include "statusSummary.h"
+
+#define DEFAULT_SECONDS         (600)
+#define DEFAULT_ERROR_SEC       (10)
+#define TASK_LOOP_MS            (500)       /* *_TASK_DELAY_SEC on the TIVA */
+#define FRAME_OVERHEAD_BYTES    (14 + 20 + 20)
+#define NUM_TASKS               (sizeof(tivaTasks) / sizeof(tivaTasks[0]))
+
+typedef struct {
+    const char *pName;
+    uint32_t packets;
+    uint64_t payloadBytes;
+    uint32_t okSent;                /* STATUS_OK msgs from tasks */
+    uint32_t okSeen;                /* STATUS_OK msgs accounted for at the BBG */
+    uint32_t errorsSeen;
+    uint32_t lastBeatMs[PID_END];   /* BBG time of task's last heartbeat */
+    uint32_t maxGapMs;
+} LinkStats_t;
+
+static const ProcessId_e tivaTasks[] = {PID_LIGHT, PID_MOISTURE, PID_OBSERVER, PID_SOLENOID};
+
+static void simulate(LinkStats_t *pStats, uint8_t coalesce, uint32_t seconds, uint32_t errorSec);
+static void receive(LinkStats_t *pStats, const uint8_t *pData, uint32_t len, uint32_t nowMs);
+static void beat(LinkStats_t *pStats, ProcessId_e Id, uint32_t nowMs);
+static void printStats(const LinkStats_t *pStats, uint32_t seconds);
+
+int main(int argc, char *argv[])
+{
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_SECONDS;
+    uint32_t errorSec = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : DEFAULT_ERROR_SEC;
+    LinkStats_t legacy, coalesced;
+    int ret = EXIT_SUCCESS;
+
+    if((seconds == 0) || (errorSec == 0))
+        return EXIT_FAILURE;
+
+    printf("status link: %u tasks every %u ms, moisture error every %u s, %u s simulated\n",
+           (uint32_t)NUM_TASKS, TASK_LOOP_MS, errorSec, seconds);
+    printf("  %-10s %10s %12s %12s %12s\n", "design", "pkt/s", "payload B/s", "wire B/s", "max gap ms");
+
+    memset(&legacy, 0, sizeof(LinkStats_t));
+    legacy.pName = "per msg";
+    simulate(&legacy, 0, seconds, errorSec);
+    printStats(&legacy, seconds);
+
+    memset(&coalesced, 0, sizeof(LinkStats_t));
+    coalesced.pName = "coalesced";
+    simulate(&coalesced, 1, seconds, errorSec);
+    printStats(&coalesced, seconds);
+
+    /* decode must account for every heartbeat and error, and keep every
+     * task inside the health monitor's deadline */
+    if((legacy.okSeen != legacy.okSent) || (coalesced.okSeen != coalesced.okSent) ||
+       (legacy.errorsSeen != coalesced.errorsSeen)) {
+        ERROR_PRINT("decode mismatch: OK %u/%u vs %u/%u, errors %u vs %u\n", legacy.okSeen, legacy.okSent,
+                    coalesced.okSeen, coalesced.okSent, legacy.errorsSeen, coalesced.errorsSeen);
+        ret = EXIT_FAILURE;
+    }
+    if((coalesced.maxGapMs * 1000) >= HEALTH_DEADLINE_USEC) {
+        ERROR_PRINT("coalesced heartbeat gap %u ms reaches the %u ms deadline\n",
+                    coalesced.maxGapMs, HEALTH_DEADLINE_USEC / 1000);
+        ret = EXIT_FAILURE;
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief run remoteStatusTask's send loop in 1 ms steps; tasks are started
+ * a little apart as they are on the TIVA
+ */
+static void simulate(LinkStats_t *pStats, uint8_t coalesce, uint32_t seconds, uint32_t errorSec)
+{
+    StatusCoalescer_t co;
+    StatusSummaryPacket summary;
+    TaskStatusPacket status;
+    uint32_t nowMs, lastSummary = 0, len, ind;
+
+    status_summary_init(&co);
+    for(nowMs = 0; nowMs < (seconds * 1000); ++nowMs)
+    {
+        for(ind = 0; ind < NUM_TASKS; ++ind)
+        {
+            if(((nowMs + (ind * 37)) % TASK_LOOP_MS) != 0)
+                continue;
+
+            memset(&status, 0, sizeof(TaskStatusPacket));
+            status.header = tivaTasks[ind];
+            status.timestamp = nowMs;
+            status.processId = tivaTasks[ind];
+            status.taskState = STATE_RUNNING;
+            status.taskStatus = STATUS_OK;
+            status.errorCode = ERROR_CODE_USER_NONE0;
+            if((tivaTasks[ind] == PID_MOISTURE) && (nowMs != 0) && ((nowMs % (errorSec * 1000)) < TASK_LOOP_MS)) {
+                status.taskStatus = STATUS_ERROR;
+                status.errorCode = ERROR_CODE_USER_NOTIFY0;
+            }
+            else {
+                ++pStats->okSent;
+            }
+
+            if(!coalesce || status_summary_add(&co, &status))
+                receive(pStats, (uint8_t *)&status, sizeof(TaskStatusPacket), nowMs);
+        }
+
+        if(coalesce && ((nowMs - lastSummary) >= STATUS_SUMMARY_PERIOD_MS)) {
+            lastSummary = nowMs;
+            len = status_summary_flush(&co, &summary);
+            if(len != 0)
+                receive(pStats, (uint8_t *)&summary, len, nowMs);
+        }
+    }
+
+    /* heartbeats still pending at the end go out with the next summary */
+    if(coalesce && ((len = status_summary_flush(&co, &summary)) != 0))
+        receive(pStats, (uint8_t *)&summary, len, nowMs);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief count a packet on the link and decode it as remoteStatusThread does
+ */
+static void receive(LinkStats_t *pStats, const uint8_t *pData, uint32_t len, uint32_t nowMs)
+{
+    StatusSummaryPacket rxPacket;
+    TaskStatusPacket status;
+    uint8_t ind;
+
+    ++pStats->packets;
+    pStats->payloadBytes += len;
+    memcpy(&rxPacket, pData, len);
+
+    if(rxPacket.header == STATUS_SUMMARY_HEADER) {
+        if(!status_summary_valid(&rxPacket, len))
+            return;
+        for(ind = 0; ind < rxPacket.numTasks; ++ind) {
+            pStats->okSeen += rxPacket.tasks[ind].count;
+            beat(pStats, (ProcessId_e)rxPacket.tasks[ind].processId, nowMs);
+        }
+    }
+    else {
+        memcpy(&status, pData, sizeof(TaskStatusPacket));
+        if(status.taskStatus == STATUS_OK)
+            ++pStats->okSeen;
+        else
+            ++pStats->errorsSeen;
+        beat(pStats, status.processId, nowMs);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static void beat(LinkStats_t *pStats, ProcessId_e Id, uint32_t nowMs)
+{
+    if(Id >= PID_END)
+        return;
+    if((pStats->lastBeatMs[Id] != 0) && ((nowMs - pStats->lastBeatMs[Id]) > pStats->maxGapMs))
+        pStats->maxGapMs = nowMs - pStats->lastBeatMs[Id];
+    pStats->lastBeatMs[Id] = nowMs;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printStats(const LinkStats_t *pStats, uint32_t seconds)
+{
+    printf("  %-10s %10.2f %12.1f %12.1f %12u\n", pStats->pName,
+           (double)pStats->packets / seconds, (double)pStats->payloadBytes / seconds,
+           (double)(pStats->payloadBytes + ((uint64_t)pStats->packets * FRAME_OVERHEAD_BYTES)) / seconds,
+           pStats->maxGapMs);
+}
@@ -0,0 +1,359 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 17, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file bench_zerocopy.c
+ * @brief remote log records to the logging thread, through the msg queue vs
+ * by reference from the receive buffer
+ *
+ * usage: bench_zerocopy [records] [rate] [seconds]
+ *
+ * This thread stands in for a TIVA's remoteLogTask, sending batched log
+ * frames to the remote server over loopback; half the records text, half
+ * events, which are rendered in place. Another stands in for the logging
+ * thread: every LOG_LOOP_TIME_NSEC it takes up to LOG_LOOP_MAX_MSGS
+ * records, remote ones off the ref ring first as loggingThread does, and
+ * renders them, but writes no file.
+ *
+ * queue - ring not opened, the server LOG_ITEM()s every record: packed,
+ *         mq_send(), mq_getattr() and mq_timedreceive()d, unpacked.
+ * ref   - ring opened, records handed over by pointer.
+ *
+ * bytes copied per record:
+ *   recv   - kernel into the receive buffer, frame headers included
+ *   moved  - within or between receive buffers (remoteServerRxStats())
+ *   handed - from the receive buffer to the logging thread's payload; for
+ *            the queue, log_pack_item() + mq_send() + mq_timedreceive() +
+ *            log_unpack_item() of the records that went that way
+ * mq     - msg queue syscalls per record, for those that went that way
+ *
+ * flat out - records as fast as the link takes them, timed until the last
+ *            is taken by the logging thread.
+ * paced    - rate records/s for seconds; delivered rate, and CPU of the
+ *            server and logging thread per record and as a share of one
+ *            core.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "logger.h"
+#include "logger_ref.h"
+#include "loggingThread.h"
+#include "remoteServer.h"
+#include "remoteThread.h"
+#include "remoteFrame.h"
+#include "cmn_timer.h"
+#include "bench_server.h"
+
+#define DEFAULT_RECORDS         (100000)
+#define DEFAULT_RATE            (10000)
+#define DEFAULT_SECONDS         (3)
+#define BENCH_NODE_ID           (203)
+#define BENCH_LOG_FILE          (LOG_FILE_TIVA_LIGHT_THREAD)    /* counted by the logging thread, the server's own aren't */
+#define LOG_PACKET_HEADER_SIZE  (sizeof(LogMsgPacket) - LOG_MSG_PAYLOAD_SIZE)
+#define QUEUE_MQ_CALLS          (3)                             /* mq_send, mq_getattr, mq_timedreceive */
+#define DRAIN_TIMEOUT_USEC      (30000000)
+
+typedef enum {
+    PATH_QUEUE = 0,
+    PATH_REF,
+    PATH_END
+} Path_e;
+
+typedef struct {
+    uint32_t records;
+    uint64_t payloadBytes;              /* of the records sent */
+    uint64_t usec;                      /* until the last was taken */
+    uint64_t serverUsec;                /* CPU */
+    uint64_t logUsec;
+    RemoteRxStats_t rx;                 /* deltas */
+    uint8_t complete;
+} Phase_t;
+
+typedef struct {
+    Path_e path;
+    Phase_t flat;
+    Phase_t paced;
+} Run_t;
+
+static int8_t runPath(Run_t *pRun, uint32_t records, uint32_t rate, uint32_t seconds);
+static int8_t runPhase(Phase_t *pPhase, uint32_t records, uint32_t rate);
+static uint32_t makeRecord(uint32_t seq, LogMsgPacket *pLog);
+static void *logThread(void *arg);
+static void printPhase(const char *pName, Path_e path, const Phase_t *pPhase, uint8_t paced);
+static uint64_t usecNow(void);
+static uint64_t cpuUsec(clockid_t clock);
+
+static const char *pathNames[PATH_END] = {"queue", "ref"};
+
+static FrameBatch_t batch;
+static BenchServer_t server;
+static clockid_t serverClock, logClock;
+static volatile uint32_t logsTaken;
+static volatile uint8_t logging;
+
+int main(int argc, char *argv[])
+{
+    uint32_t records = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_RECORDS;
+    uint32_t rate = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : DEFAULT_RATE;
+    uint32_t seconds = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : DEFAULT_SECONDS;
+    Run_t runs[PATH_END];
+    uint32_t ind;
+    int ret = EXIT_SUCCESS;
+
+    if((records == 0) || (rate == 0) || (rate > 1000000) || (seconds == 0)) {
+        ERROR_PRINT("usage: bench_zerocopy [records] [rate 1-1000000] [seconds]\n");
+        return EXIT_FAILURE;
+    }
+
+    if((bench_server_open(&server, "bench_zerocopy", BENCH_SERVER_LOG_QUEUE) != EXIT_SUCCESS) ||
+       (bench_server_start(&server, remoteServerThreadHandler, remoteServerSigHandler) != EXIT_SUCCESS))
+        return EXIT_FAILURE;
+    pthread_getcpuclockid(server.thread, &serverClock);
+
+    printf("%u records flat out, then %u records/s for %u s; logging loop %u ms, at most %u records\n",
+           records, rate, seconds, (uint32_t)(LOG_LOOP_TIME_NSEC / 1000000), (uint32_t)LOG_LOOP_MAX_MSGS);
+    printf("  %-6s %-5s | %9s | %-28s | %-6s | %6s %6s %6s %6s\n", "", "", "", "bytes copied per record", "",
+           "cpu us", "/rec", "cpu", "");
+    printf("  %-6s %-5s | %9s | %6s %6s %6s %6s | %6s | %6s %6s %6s %6s\n", "", "path", "rec/s",
+           "recv", "moved", "handed", "total", "mq", "server", "log", "server", "log");
+    for(ind = 0; ind < PATH_END; ++ind)
+    {
+        memset(&runs[ind], 0, sizeof(Run_t));
+        runs[ind].path = (Path_e)ind;
+        if(runPath(&runs[ind], records, rate, seconds) != EXIT_SUCCESS)
+            ret = EXIT_FAILURE;
+        printPhase("flat", runs[ind].path, &runs[ind].flat, 0);
+        printPhase("paced", runs[ind].path, &runs[ind].paced, 1);
+        if(!runs[ind].flat.complete || !runs[ind].paced.complete)
+            ret = EXIT_FAILURE;
+    }
+
+    bench_server_close(&server);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief both phases with a logging thread taking records one way
+ */
+static int8_t runPath(Run_t *pRun, uint32_t records, uint32_t rate, uint32_t seconds)
+{
+    pthread_t logger;
+    int8_t ret;
+
+    if(pRun->path == PATH_REF)
+        log_ref_open();
+    logging = 1;
+    if(pthread_create(&logger, NULL, logThread, NULL) != 0)
+        return EXIT_FAILURE;
+    pthread_getcpuclockid(logger, &logClock);
+
+    ret = runPhase(&pRun->flat, records, 0);
+    if(ret == EXIT_SUCCESS)
+        ret = runPhase(&pRun->paced, rate * seconds, rate);
+
+    logging = 0;
+    pthread_join(logger, NULL);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief records in batched frames, at rate or flat out if 0, timed until
+ * the logging thread has taken the last
+ */
+static int8_t runPhase(Phase_t *pPhase, uint32_t records, uint32_t rate)
+{
+    LogMsgPacket record;
+    RemoteRxStats_t rxStart, rxEnd;
+    struct timespec next;
+    uint64_t start, serverStart, logStart, batchStart = 0;
+    uint64_t periodNsec = (rate != 0) ? (1000000000ULL / rate) : 0;
+    uint32_t seq, base;
+    int8_t ret = EXIT_SUCCESS;
+    int fd;
+
+    fd = bench_connect(LOG_PORT, BENCH_NODE_ID);
+    if(fd < 0)
+        return EXIT_FAILURE;
+    /* the server names the connection from its hello before anything is counted */
+    usleep(100000);
+    base = __atomic_load_n(&logsTaken, __ATOMIC_RELAXED);
+
+    pPhase->records = records;
+    frame_batch_init(&batch);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    remoteServerRxStats(&rxStart);
+    start = usecNow();
+    serverStart = cpuUsec(serverClock);
+    logStart = cpuUsec(logClock);
+    for(seq = 0; (seq < records) && (ret == EXIT_SUCCESS); ++seq)
+    {
+        if(rate != 0) {
+            next.tv_nsec += periodNsec;
+            while(next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                ++next.tv_sec;
+            }
+            while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+        }
+
+        pPhase->payloadBytes += makeRecord(seq, &record);
+        frame_batch_add(&batch, FRAME_TYPE_LOG, &record, sizeof(LogMsgPacket));
+        if(batch.records == 1)
+            batchStart = usecNow();
+        if((frame_batch_free(&batch) < FRAME_RECORD_SIZE(sizeof(LogMsgPacket))) ||
+           ((rate != 0) && ((usecNow() - batchStart) >= (REMOTE_BATCH_DEADLINE_MS * 1000))))
+            ret = bench_send_batch(fd, &batch);
+    }
+    if((ret == EXIT_SUCCESS) && (batch.records != 0))
+        ret = bench_send_batch(fd, &batch);
+
+    while(((__atomic_load_n(&logsTaken, __ATOMIC_RELAXED) - base) < records) &&
+          ((usecNow() - start) < DRAIN_TIMEOUT_USEC))
+        usleep(100);
+    pPhase->usec = usecNow() - start;
+    pPhase->serverUsec = cpuUsec(serverClock) - serverStart;
+    pPhase->logUsec = cpuUsec(logClock) - logStart;
+    pPhase->complete = ((__atomic_load_n(&logsTaken, __ATOMIC_RELAXED) - base) == records);
+    remoteServerRxStats(&rxEnd);
+    pPhase->rx.rxBytes = rxEnd.rxBytes - rxStart.rxBytes;
+    pPhase->rx.movedBytes = rxEnd.movedBytes - rxStart.movedBytes;
+    pPhase->rx.logRecords = rxEnd.logRecords - rxStart.logRecords;
+    pPhase->rx.logRefs = rxEnd.logRefs - rxStart.logRefs;
+    close(fd);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a log msg as the TIVA's tasks log them, text or an event by turns,
+ * checksum set by its remoteLogTask
+ *
+ * @return uint32_t payload length
+ */
+static uint32_t makeRecord(uint32_t seq, LogMsgPacket *pLog)
+{
+    memset(pLog, 0, sizeof(LogMsgPacket));
+    pLog->logMsgId = LOG_MSG_INFO;
+    pLog->fileId = BENCH_LOG_FILE;
+    pLog->lineNum = 100;
+    pLog->timestamp = seq;
+    pLog->sourceId = PID_LIGHT;
+    if(seq & 1) {
+        pLog->payloadFormat = LOG_PAYLOAD_EVENT;
+        pLog->payloadLength = sizeof(seq);
+        memcpy(pLog->payload, &seq, sizeof(seq));
+    }
+    else {
+        pLog->payloadFormat = LOG_PAYLOAD_TEXT;
+        pLog->payloadLength = (uint32_t)snprintf((char *)pLog->payload, LOG_MSG_PAYLOAD_SIZE, "lux reading %u", seq);
+    }
+    pLog->checksum = log_packet_checksum(pLog);
+    return pLog->payloadLength;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief logging thread's loop, without the file: remote records off the
+ * ref ring first, then the msg queue, rendered and counted
+ */
+static void *logThread(void *arg)
+{
+    logItem_t item;
+    uint8_t payload[LOG_MSG_PAYLOAD_SIZE];
+    struct timespec next;
+    uint16_t logMsgCount, refMsgCount;
+    uint8_t ret;
+
+    memset(&item, 0, sizeof(logItem_t));
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while(logging)
+    {
+        next.tv_nsec += (long)LOG_LOOP_TIME_NSEC;
+        while(next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            ++next.tv_sec;
+        }
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+        logMsgCount = 0;
+        refMsgCount = 0;
+        do {
+            item.pPayload = payload;
+            ret = LOG_STATUS_TIMEOUT;
+            if(refMsgCount < LOG_REF_DEPTH) {
+                ret = log_ref_dequeue_item(&item);
+                if(ret == LOG_STATUS_OK)
+                    ++refMsgCount;
+            }
+            if(ret == LOG_STATUS_TIMEOUT)
+                ret = LOG_DEQUEUE_ITEM(&item);
+            if(ret != LOG_STATUS_OK)
+                break;
+
+            log_render_item(&item);
+            if(item.fileId == BENCH_LOG_FILE)
+                __atomic_add_fetch(&logsTaken, 1, __ATOMIC_RELAXED);
+        } while(++logMsgCount <= LOG_LOOP_MAX_MSGS);
+    }
+    log_ref_close();
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printPhase(const char *pName, Path_e path, const Phase_t *pPhase, uint8_t paced)
+{
+    double records = (pPhase->records != 0) ? pPhase->records : 1;
+    uint32_t queued = pPhase->rx.logRecords - pPhase->rx.logRefs;
+    double avgPayload = pPhase->payloadBytes / records;
+    double recv = pPhase->rx.rxBytes / records;
+    double moved = pPhase->rx.movedBytes / records;
+    double handed = (queued * ((LOG_PACKET_HEADER_SIZE + avgPayload) + (2.0 * sizeof(LogMsgPacket)) + avgPayload)) / records;
+
+    printf("  %-6s %-5s | %9.0f | %6.1f %6.1f %6.1f %6.1f | %6.2f | %6.2f %6.2f",
+           pName, pathNames[path], (pPhase->records * 1e6) / pPhase->usec, recv, moved, handed,
+           recv + moved + handed, (QUEUE_MQ_CALLS * (double)queued) / records,
+           pPhase->serverUsec / records, pPhase->logUsec / records);
+    if(paced)
+        printf(" %5.1f%% %5.1f%%", (100.0 * pPhase->serverUsec) / pPhase->usec, (100.0 * pPhase->logUsec) / pPhase->usec);
+    printf("%s\n", pPhase->complete ? "" : "  (records lost)");
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t cpuUsec(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,276 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 4, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_crc.c
+ * @brief verify CRC-32C implementations agree with the reference value, and
+ * that the log reader rejects serialized records with any single bit flipped
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+
+#include "my_debug.h"
+#include "crc.h"
+#include "logger_helper.h"
+#include "logger_sink.h"
+#include "logger_reader.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_TEST_CRC);
+
+#define TEST_MAX_LEN            (300)
+#define TEST_MAX_OFFSET         (8)
+#define TEST_FILE_SIZE          (512)
+#define PRE_CRC_LOG_PATH        "scripts/log.bin"   /* checked in, legacy from before CRC-32C */
+#define PRE_CRC_LOG_RECORDS     (81)
+
+static char testPath[] = "/tmp/test_crc.XXXXXX";
+static LogReader_t reader;
+static LogStrings_t strings;
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_knownValue(void);
+int8_t test_implsAgree(void);
+int8_t test_bitFlips(LogFormat_e format, uint8_t byteSum);
+int8_t test_preCrcLog(void);
+
+static void makeRecord(logItem_t *pLogItem, uint8_t *pPayload);
+static uint32_t readFlipped(const uint8_t *pFile, uint32_t len, logItem_t *pOrig, uint32_t *pUndetected);
+
+/*---------------------------------------------------------------------------------*/
+int main(void)
+{
+    uint8_t testFails = 0;
+    int fd;
+
+    if((fd = mkstemp(testPath)) < 0) {
+        ERRNO_PRINT("couldn't create test file");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+    printf("test cases for CRC-32C (%s) and log record checksums\n", crc32c_impl());
+
+    testFails += test_knownValue();
+    testFails += test_implsAgree();
+    testFails += test_bitFlips(LOG_FORMAT_LEGACY, 0);
+    testFails += test_bitFlips(LOG_FORMAT_LEGACY, 1);
+    testFails += test_bitFlips(LOG_FORMAT_COMPACT, 0);
+    testFails += test_preCrcLog();
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    unlink(testPath);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief standard CRC-32C check value, whole and in pieces
+ *
+ * @return int8_t test results
+ */
+int8_t test_knownValue(void)
+{
+    const uint8_t check[] = "123456789";
+    uint32_t crc;
+
+    testCount++;
+    if(crc32c(check, 9) != 0xE3069283UL) {
+        printf("FAIL: crc32c(\"123456789\") = 0x%08X\n", crc32c(check, 9));
+        return 1;
+    }
+    crc = crc32c_update(CRC32C_INIT, check, 4);
+    crc = crc32c_update(crc, &check[4], 5);
+    if(crc32c_finish(crc) != 0xE3069283UL) {
+        printf("FAIL: crc32c in pieces = 0x%08X\n", crc32c_finish(crc));
+        return 1;
+    }
+    if(crc32c(check, 0) != 0) {
+        printf("FAIL: crc32c of nothing = 0x%08X\n", crc32c(check, 0));
+        return 1;
+    }
+    printf("PASS: known value\n");
+    return 0;
+}
+
+/**
+ * @brief slicing-by-8, bytewise and selected versions agree for every
+ * length and alignment the slicing loop distinguishes
+ *
+ * @return int8_t test results
+ */
+int8_t test_implsAgree(void)
+{
+    static uint8_t buf[TEST_MAX_LEN + TEST_MAX_OFFSET];
+    uint32_t len, offset, ref, ind;
+
+    testCount++;
+    srand(5013);
+    for(ind = 0; ind < sizeof(buf); ++ind)
+        buf[ind] = (uint8_t)rand();
+
+    for(offset = 0; offset < TEST_MAX_OFFSET; ++offset)
+    {
+        for(len = 0; len <= TEST_MAX_LEN; ++len)
+        {
+            ref = crc32c_update_bytewise(CRC32C_INIT, &buf[offset], len);
+            if((crc32c_update_sw(CRC32C_INIT, &buf[offset], len) != ref) ||
+               (crc32c_update(CRC32C_INIT, &buf[offset], len) != ref)) {
+                printf("FAIL: implementations differ, offset %u length %u\n", offset, len);
+                return 1;
+            }
+        }
+    }
+    printf("PASS: implementations agree\n");
+    return 0;
+}
+
+/**
+ * @brief flip every bit of a serialized record (and its string table entry)
+ * in turn; the reader must never return a record that differs from the
+ * one written. Legacy records are also tried with the byte sum written
+ * before CRC-32C, which the reader still takes.
+ *
+ * @return int8_t test results
+ */
+int8_t test_bitFlips(LogFormat_e format, uint8_t byteSum)
+{
+    uint8_t file[TEST_FILE_SIZE], flipped[TEST_FILE_SIZE];
+    uint8_t payload[LOG_MSG_PAYLOAD_SIZE];
+    uint32_t len = 0, start, bit, undetected = 0, rejected = 0;
+    const char *pName = (format == LOG_FORMAT_COMPACT) ? "compact" : (byteSum) ? "legacy byte sum" : "legacy";
+    logItem_t logItem;
+
+    testCount++;
+    makeRecord(&logItem, payload);
+    if(byteSum) {
+        logItem.pFilename = log_item_filename(&logItem);
+        logItem.checksum = log_calc_byte_sum(&logItem);
+    }
+    if(format == LOG_FORMAT_COMPACT)
+        len = log_compact_header(&strings, file);
+    start = len;
+    if(format == LOG_FORMAT_COMPACT)
+        len += log_serialize_compact(&strings, &logItem, &file[len], sizeof(file) - len);
+    else
+        len += log_serialize_item(&logItem, &file[len], sizeof(file) - len);
+
+    /* unmodified record must read back */
+    if(readFlipped(file, len, &logItem, &undetected) != 1) {
+        printf("FAIL: %s record didn't read back\n", pName);
+        return 1;
+    }
+
+    for(bit = start * 8; bit < (len * 8); ++bit)
+    {
+        memcpy(flipped, file, len);
+        flipped[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        if(readFlipped(flipped, len, &logItem, &undetected) == 0)
+            ++rejected;
+    }
+
+    if(undetected != 0) {
+        printf("FAIL: %s, %u of %u bit flips read back as a different record\n",
+               pName, undetected, (len - start) * 8);
+        return 1;
+    }
+    printf("PASS: %s, %u bit flips, %u records rejected (rest only touched unchecked bytes)\n",
+           pName, (len - start) * 8, rejected);
+    return 0;
+}
+
+/**
+ * @brief a legacy log written before CRC-32C reads back whole, every
+ * record passing its byte sum
+ *
+ * @return int8_t test results
+ */
+int8_t test_preCrcLog(void)
+{
+    logItem_t logItem;
+
+    testCount++;
+    if(log_reader_open(&reader, PRE_CRC_LOG_PATH) != LOG_STATUS_OK) {
+        printf("FAIL: couldn't open %s, run from bbg/\n", PRE_CRC_LOG_PATH);
+        return 1;
+    }
+    while(log_reader_next(&reader, &logItem) != LOG_STATUS_EOF)
+        ;
+    log_reader_close(&reader);
+
+    if((reader.records != PRE_CRC_LOG_RECORDS) || (reader.badRecords != 0)) {
+        printf("FAIL: %s, %u of %u records read, %u failed their checksum\n", PRE_CRC_LOG_PATH,
+               reader.records, PRE_CRC_LOG_RECORDS, reader.badChecksums);
+        return 1;
+    }
+    printf("PASS: %u records of a log from before CRC-32C\n", reader.records);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void makeRecord(logItem_t *pLogItem, uint8_t *pPayload)
+{
+    strcpy((char *)pPayload, "remote data: lux 412.07, moisture 38%");
+
+    pLogItem->payloadFormat = LOG_PAYLOAD_TEXT;
+    pLogItem->logMsgId = LOG_MSG_INFO;
+    pLogItem->fileId = logFileId;
+    pLogItem->pFilename = NULL;
+    pLogItem->lineNum = __LINE__;
+    pLogItem->time = 123456789;
+    pLogItem->payloadLength = log_strlen(pPayload);
+    pLogItem->pPayload = pPayload;
+    pLogItem->sourceId = 1234;
+    log_set_checksum(pLogItem);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief write file contents and read every record back
+ *
+ * @return uint32_t records read; one that differs from pOrig bumps pUndetected
+ */
+static uint32_t readFlipped(const uint8_t *pFile, uint32_t len, logItem_t *pOrig, uint32_t *pUndetected)
+{
+    logItem_t logItem;
+    uint32_t count = 0;
+    uint8_t ret;
+    int fd;
+
+    fd = open(testPath, O_WRONLY | O_TRUNC);
+    if((fd < 0) || (write(fd, pFile, len) != (ssize_t)len)) {
+        ERRNO_PRINT("test file write failed");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    if(log_reader_open(&reader, testPath) != LOG_STATUS_OK)
+        return 0;
+    while((ret = log_reader_next(&reader, &logItem)) != LOG_STATUS_EOF)
+    {
+        if(ret != LOG_STATUS_OK)
+            continue;
+        ++count;
+        if((logItem.logMsgId != pOrig->logMsgId) || (logItem.lineNum != pOrig->lineNum) ||
+           (logItem.time != pOrig->time) || (logItem.sourceId != pOrig->sourceId) ||
+           (logItem.checksum != pOrig->checksum) || (logItem.payloadLength != pOrig->payloadLength) ||
+           (memcmp(logItem.pPayload, pOrig->pPayload, pOrig->payloadLength) != 0) ||
+           (strcmp((char *)logItem.pFilename, (char *)log_item_filename(pOrig)) != 0))
+            ++(*pUndetected);
+    }
+    log_reader_close(&reader);
+    return count;
+}
+
+/*---------------------------------------------------------------------------------*/
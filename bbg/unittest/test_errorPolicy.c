@@ -0,0 +1,166 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 9, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_errorPolicy.c
+ * @brief error policy config files override the default table
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "healthMonitor.h"
+#include "errorPolicy.h"
+
+static char testPath[] = "/tmp/test_errorPolicy.XXXXXX";
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_override(void);
+int8_t test_badLines(void);
+int8_t test_reset(void);
+
+static int8_t writeConfig(const char *pText);
+
+/*---------------------------------------------------------------------------------*/
+int main(void)
+{
+    uint8_t testFails = 0;
+    int fd;
+
+    if((fd = mkstemp(testPath)) < 0) {
+        ERRNO_PRINT("couldn't create test file");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+    printf("test cases for error policy config\n");
+
+    testFails += test_override();
+    testFails += test_badLines();
+    testFails += test_reset();
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    unlink(testPath);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief single code, range and wildcard lines, later lines winning
+ *
+ * @return int8_t test results
+ */
+int8_t test_override(void)
+{
+    testCount++;
+    error_policy_reset();
+    writeConfig("# escalate moisture sensor notifications\n"
+                "PID_MOISTURE   136     RESTARTTHREAD\n"
+                "\n"
+                "*              152-159 NOTIFY\n"
+                "PID_LOGGING    *       TERMTHREAD\n");
+    if(error_policy_load(testPath) != EXIT_SUCCESS) {
+        printf("FAIL: good config rejected\n");
+        return 1;
+    }
+
+    if((error_policy_action(PID_MOISTURE, ERROR_CODE_USER_NOTIFY0) != MAIN_ACTION_RESTART_THREAD) ||
+       (strcmp(error_policy_desc(PID_MOISTURE, ERROR_CODE_USER_NOTIFY0), "RESTARTTHREAD") != 0) ||
+       (error_policy_action(PID_MOISTURE, ERROR_CODE_USER_NOTIFY1) != MAIN_ACTION_NOTIFY_USER_ONLY) ||
+       (error_policy_action(PID_LIGHT, ERROR_CODE_USER_NOTIFY0) != MAIN_ACTION_NOTIFY_USER_ONLY)) {
+        printf("FAIL: single code override\n");
+        return 1;
+    }
+    if((error_policy_action(PID_LIGHT, ERROR_CODE_USER_TERMALL0) != MAIN_ACTION_NOTIFY_USER_ONLY) ||
+       (error_policy_action(PID_REMOTE_CLIENT, ERROR_CODE_USER_TERMALL7) != MAIN_ACTION_NOTIFY_USER_ONLY) ||
+       (error_policy_action(PID_LIGHT, ERROR_CODE_USER_RESTARTTHREAD0) != MAIN_ACTION_RESTART_THREAD)) {
+        printf("FAIL: wildcard thread range override\n");
+        return 1;
+    }
+    if((error_policy_action(PID_LOGGING, ERROR_CODE_USER_TERMALL0) != MAIN_ACTION_TERMINATE_THREAD) ||
+       (error_policy_action(PID_LOGGING, ERROR_CODE_TIMEOUT) != MAIN_ACTION_TERMINATE_THREAD)) {
+        printf("FAIL: wildcard code override\n");
+        return 1;
+    }
+    printf("PASS: config overrides applied in order\n");
+    return 0;
+}
+
+/**
+ * @brief bad lines are reported and skipped, good ones still applied
+ *
+ * @return int8_t test results
+ */
+int8_t test_badLines(void)
+{
+    testCount++;
+    error_policy_reset();
+    writeConfig("PID_NOSUCH     136     NOTIFY\n"
+                "PID_LIGHT      300     NOTIFY\n"
+                "PID_LIGHT      140-136 NOTIFY\n"
+                "PID_LIGHT      136     REBOOT\n"
+                "PID_LIGHT      136\n"
+                "PID_SOLENOID   128     TERMALL\n");
+    if(error_policy_load(testPath) == EXIT_SUCCESS) {
+        printf("FAIL: bad config accepted\n");
+        return 1;
+    }
+    if((error_policy_action(PID_LIGHT, ERROR_CODE_USER_NOTIFY0) != MAIN_ACTION_NOTIFY_USER_ONLY) ||
+       (error_policy_action(PID_SOLENOID, ERROR_CODE_USER_NONE0) != MAIN_ACTION_TERMINATE_ALL)) {
+        printf("FAIL: bad lines changed the table or good line skipped\n");
+        return 1;
+    }
+    if(error_policy_load("/tmp/test_errorPolicy.missing") == EXIT_SUCCESS) {
+        printf("FAIL: missing config accepted\n");
+        return 1;
+    }
+    printf("PASS: bad config lines skipped\n");
+    return 0;
+}
+
+/**
+ * @brief reset puts back the compiled in defaults
+ *
+ * @return int8_t test results
+ */
+int8_t test_reset(void)
+{
+    testCount++;
+    writeConfig("* * NONE\n");
+    error_policy_load(testPath);
+    error_policy_reset();
+    if((error_policy_action(PID_LIGHT, ERROR_CODE_TIMEOUT) != MAIN_ACTION_NOTIFY_USER_ONLY) ||
+       (strcmp(error_policy_desc(PID_LIGHT, ERROR_CODE_TIMEOUT), "TIMEOUT") != 0) ||
+       (error_policy_action(PID_REMOTE_DATA, ERROR_CODE_NONE) != MAIN_ACTION_TERMINATE_ALL) ||
+       (error_policy_action(PID_REMOTE_CLIENT_CMD, ERROR_CODE_USER_TERMALL0) != MAIN_ACTION_NONE) ||
+       (error_policy_action(PID_END, ERROR_CODE_USER_TERMALL0) != MAIN_ACTION_NONE)) {
+        printf("FAIL: defaults not restored\n");
+        return 1;
+    }
+    printf("PASS: defaults restored\n");
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int8_t writeConfig(const char *pText)
+{
+    FILE *pConf = fopen(testPath, "w");
+
+    if(pConf == NULL)
+        return EXIT_FAILURE;
+    fputs(pText, pConf);
+    fclose(pConf);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 18, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_logRing.c
+ * @brief ring logger rings handed back as producer threads exit: many more
+ * threads than rings come and go, as the supervisor restarts them, and
+ * every item each one logs must reach the consumer
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_helper.h"
+#include "logger_ring.h"
+#include "packet.h"
+
+#define TEST_THREADS            (4 * LOG_RING_MAX_PRODUCERS)
+#define TEST_ITEMS              (LOG_RING_DEPTH / 2)    /* per thread; never fills a ring */
+#define DRAIN_TIMEOUT_USEC      (2000000)
+#define DRAIN_POLL_USEC         (1000)
+
+typedef struct {
+    uint32_t thread;
+    uint32_t refused;                   /* items log_ring_item didn't take */
+    volatile uint8_t hold;              /* exit only once cleared */
+} Producer_t;
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_moreThreadsThanRings(void);
+int8_t test_allRingsInUse(void);
+
+static void *producerThread(void *arg);
+static void *consumerThread(void *arg);
+static uint8_t logOne(uint32_t thread, uint32_t ind);
+static uint8_t waitDrained(uint32_t expected);
+
+static Producer_t producers[TEST_THREADS + 1];
+static uint32_t received[TEST_THREADS + 1];
+static volatile uint32_t receivedTotal;
+static volatile uint8_t consuming;
+
+/*---------------------------------------------------------------------------------*/
+int main(void)
+{
+    pthread_t consumer;
+    uint8_t testFails = 0;
+
+    printf("test cases for ring logger\n");
+    init_ring_logger(NULL);
+
+    /* as the logging thread does */
+    consuming = 1;
+    if(pthread_create(&consumer, NULL, consumerThread, NULL) != 0) {
+        ERROR_PRINT("test_logRing couldn't start consumer\n");
+        return EXIT_FAILURE;
+    }
+
+    testFails += test_moreThreadsThanRings();
+    testFails += test_allRingsInUse();
+
+    consuming = 0;
+    pthread_join(consumer, NULL);
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief threads started and joined one after another, four times as many
+ * as there are rings
+ *
+ * @return int8_t test results
+ */
+int8_t test_moreThreadsThanRings(void)
+{
+    pthread_t thread;
+    uint32_t ind, expected;
+
+    testCount++;
+    for(ind = 0; ind < TEST_THREADS; ++ind)
+    {
+        producers[ind].thread = ind;
+        producers[ind].hold = 0;
+        if(pthread_create(&thread, NULL, producerThread, &producers[ind]) != 0) {
+            printf("FAIL: couldn't start producer %u\n", ind);
+            return 1;
+        }
+        pthread_join(thread, NULL);
+    }
+
+    expected = TEST_THREADS * TEST_ITEMS;
+    if(!waitDrained(expected)) {
+        printf("FAIL: %u of %u items arrived\n", receivedTotal, expected);
+        return 1;
+    }
+    for(ind = 0; ind < TEST_THREADS; ++ind)
+    {
+        if((producers[ind].refused != 0) || (received[ind] != TEST_ITEMS)) {
+            printf("FAIL: thread %u had %u items refused, %u of %u arrived\n", ind,
+                   producers[ind].refused, received[ind], TEST_ITEMS);
+            return 1;
+        }
+    }
+    printf("PASS: %u threads through %u rings\n", TEST_THREADS, LOG_RING_MAX_PRODUCERS);
+    return 0;
+}
+
+/**
+ * @brief with every ring held by a live thread one more is refused, and
+ * gets a ring once one of them exits
+ *
+ * @return int8_t test results
+ */
+int8_t test_allRingsInUse(void)
+{
+    pthread_t threads[LOG_RING_MAX_PRODUCERS];
+    pthread_t extra;
+    Producer_t *pExtra = &producers[TEST_THREADS];
+    uint32_t ind, expected = receivedTotal;
+    int8_t ret = 0;
+
+    testCount++;
+    memset(received, 0, sizeof(received));
+    for(ind = 0; ind < LOG_RING_MAX_PRODUCERS; ++ind)
+    {
+        producers[ind].thread = ind;
+        producers[ind].refused = 0;
+        producers[ind].hold = 1;
+        pthread_create(&threads[ind], NULL, producerThread, &producers[ind]);
+    }
+    expected += LOG_RING_MAX_PRODUCERS * TEST_ITEMS;
+    waitDrained(expected);
+
+    /* nothing free */
+    pExtra->thread = TEST_THREADS;
+    pExtra->hold = 0;
+    pthread_create(&extra, NULL, producerThread, pExtra);
+    pthread_join(extra, NULL);
+    if(pExtra->refused != TEST_ITEMS) {
+        printf("FAIL: %u of %u items taken with every ring in use\n", TEST_ITEMS - pExtra->refused, TEST_ITEMS);
+        ret = 1;
+    }
+
+    /* one exits, its ring is drained, the next thread gets it */
+    producers[0].hold = 0;
+    pthread_join(threads[0], NULL);
+    pExtra->refused = 0;
+    pthread_create(&extra, NULL, producerThread, pExtra);
+    pthread_join(extra, NULL);
+    expected += TEST_ITEMS;
+    if((pExtra->refused != 0) || !waitDrained(expected) || (received[TEST_THREADS] != TEST_ITEMS)) {
+        printf("FAIL: after a ring was released %u items refused, %u of %u arrived\n", pExtra->refused,
+               received[TEST_THREADS], TEST_ITEMS);
+        ret = 1;
+    }
+
+    for(ind = 1; ind < LOG_RING_MAX_PRODUCERS; ++ind)
+    {
+        producers[ind].hold = 0;
+        pthread_join(threads[ind], NULL);
+    }
+    if(ret == 0)
+        printf("PASS: all rings in use, then one released\n");
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief log TEST_ITEMS, then wait to be let go if held
+ */
+static void *producerThread(void *arg)
+{
+    Producer_t *pProducer = (Producer_t *)arg;
+    uint32_t ind;
+
+    for(ind = 0; ind < TEST_ITEMS; ++ind)
+    {
+        if(logOne(pProducer->thread, ind) != LOG_STATUS_OK)
+            ++pProducer->refused;
+    }
+    while(pProducer->hold)
+        usleep(DRAIN_POLL_USEC);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void *consumerThread(void *arg)
+{
+    uint8_t payload[LOG_MSG_PAYLOAD_SIZE];
+    logItem_t logItem;
+    uint32_t thread;
+
+    (void)arg;
+    logItem.pPayload = payload;
+    while(consuming)
+    {
+        if(log_ring_dequeue_item(&logItem) != LOG_STATUS_OK) {
+            usleep(100);
+            continue;
+        }
+        memcpy(&thread, payload, sizeof(thread));
+        if(thread <= TEST_THREADS)
+            ++received[thread];
+        __atomic_add_fetch(&receivedTotal, 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief an item naming the thread that logged it
+ */
+static uint8_t logOne(uint32_t thread, uint32_t ind)
+{
+    logItem_t logItem;
+
+    logItem.logMsgId = LOG_MSG_INFO;
+    logItem.payloadFormat = LOG_PAYLOAD_TEXT;
+    logItem.fileId = 0;
+    logItem.pFilename = NULL;
+    logItem.lineNum = (uint16_t)ind;
+    logItem.time = log_get_time();
+    logItem.payloadLength = sizeof(thread);
+    logItem.pPayload = (uint8_t *)&thread;
+    logItem.sourceId = (uint16_t)thread;
+    return log_ring_item(&logItem);
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint8_t waitDrained(uint32_t expected)
+{
+    uint32_t waited;
+
+    for(waited = 0; waited < DRAIN_TIMEOUT_USEC; waited += DRAIN_POLL_USEC)
+    {
+        if(__atomic_load_n(&receivedTotal, __ATOMIC_ACQUIRE) >= expected)
+            return (receivedTotal == expected);
+        usleep(DRAIN_POLL_USEC);
+    }
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,335 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 2, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_logSegment.c
+ * @brief verify mmap'd log segments survive the writer being killed mid-write,
+ * rotate and retain the configured number of segments, and are found past
+ * sequence number 999999
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "my_debug.h"
+#include "logger.h"
+#include "logger_segment.h"
+#include "logger_reader.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_TEST_LOG_SEGMENT);
+
+#define TEST_SEGMENT_SIZE       (LOG_SEGMENT_MIN_SIZE)
+#define TEST_SEGMENTS_KEPT      (3)
+#define TEST_SYNCED_TARGET      (6000)      /* records synced before kill */
+#define TEST_ERROR_INTERVAL     (100)       /* every Nth record is an ERROR */
+#define TEST_PAYLOAD_SIZE       (20)
+
+/* written by the child writer, read by the test after the kill */
+typedef struct {
+    volatile uint32_t written;      /* records handed to the writer */
+    volatile uint32_t synced;       /* records covered by an msync */
+} WriterProgress_t;
+
+static char testDir[] = "/tmp/test_logSegment.XXXXXX";
+static LogReader_t reader;
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_killMidWrite(LogFormat_e format);
+int8_t test_restart(void);
+int8_t test_longSequence(void);
+
+static void runWriter(const char *pBasePath, LogFormat_e format, WriterProgress_t *pProgress);
+static void makeRecord(logItem_t *pLogItem, uint8_t *pPayload, uint32_t ind);
+static void removeSegments(const char *pBasePath);
+
+/*---------------------------------------------------------------------------------*/
+int main(void)
+{
+    uint8_t testFails = 0;
+
+    if(mkdtemp(testDir) == NULL) {
+        ERRNO_PRINT("couldn't create test directory");
+        return EXIT_FAILURE;
+    }
+    printf("test cases for log segments in %s\n", testDir);
+
+    testFails += test_killMidWrite(LOG_FORMAT_LEGACY);
+    testFails += test_killMidWrite(LOG_FORMAT_COMPACT);
+    testFails += test_restart();
+    testFails += test_longSequence();
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    rmdir(testDir);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief SIGKILL a writer mid-stream; every record it msync'd must read
+ * back, in order, from the retained segments with nothing corrupt
+ *
+ * @return int8_t test results
+ */
+int8_t test_killMidWrite(LogFormat_e format)
+{
+    char basePath[64], path[LOG_SEGMENT_PATH_SIZE];
+    WriterProgress_t *pProgress;
+    uint8_t expectedPayload[TEST_PAYLOAD_SIZE];
+    uint32_t oldest, newest, seq, first = 0, next = 0, count = 0, bad = 0, synced, written;
+    logItem_t logItem, expected;
+    int8_t fail = 0;
+    uint8_t ret;
+    pid_t pid;
+
+    testCount++;
+    snprintf(basePath, sizeof(basePath), "%s/log%d.bin", testDir, format);
+
+    pProgress = mmap(NULL, sizeof(WriterProgress_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(pProgress == MAP_FAILED) {
+        ERRNO_PRINT("mmap failed");
+        return 1;
+    }
+    memset(pProgress, 0, sizeof(WriterProgress_t));
+
+    pid = fork();
+    if(pid == 0) {
+        runWriter(basePath, format, pProgress);
+        _exit(EXIT_FAILURE);
+    }
+    while((pProgress->synced < TEST_SYNCED_TARGET) && (waitpid(pid, NULL, WNOHANG) == 0))
+        usleep(1000);
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    synced = pProgress->synced;
+    written = pProgress->written;
+
+    if(log_segment_find(basePath, &oldest, &newest) != LOG_STATUS_OK) {
+        printf("FAIL: no segments written\n");
+        return 1;
+    }
+    if((newest - oldest + 1) > TEST_SEGMENTS_KEPT) {
+        printf("FAIL: %u segments retained, expected at most %d\n", newest - oldest + 1, TEST_SEGMENTS_KEPT);
+        fail = 1;
+    }
+
+    /* records must be contiguous from the oldest retained one on */
+    for(seq = oldest; seq <= newest; ++seq)
+    {
+        log_segment_path(path, basePath, seq);
+        if(log_reader_open(&reader, path) != LOG_STATUS_OK) {
+            printf("FAIL: couldn't open %s\n", path);
+            fail = 1;
+            continue;
+        }
+        while((ret = log_reader_next(&reader, &logItem)) != LOG_STATUS_EOF)
+        {
+            if(ret != LOG_STATUS_OK) {
+                ++bad;
+                continue;
+            }
+            if(count == 0)
+                first = next = logItem.time;
+            makeRecord(&expected, expectedPayload, next);
+            if((logItem.time != next) || (logItem.payloadLength != expected.payloadLength) ||
+               (memcmp(logItem.pPayload, expectedPayload, logItem.payloadLength) != 0)) {
+                ++bad;
+                next = logItem.time;
+            }
+            ++next;
+            ++count;
+        }
+        log_reader_close(&reader);
+    }
+
+    printf("%s: killed after %u written, %u synced; read %u records [%u..%u) from segments %u..%u\n",
+           (format == LOG_FORMAT_COMPACT) ? "compact" : "legacy", written, synced, count, first, next,
+           oldest, newest);
+    if(bad != 0) {
+        printf("FAIL: %u corrupt or out of order records\n", bad);
+        fail = 1;
+    }
+    /* the kill can land between a record's commit and the written count */
+    if((next < synced) || (next > (written + 1)) || (first == 0)) {
+        printf("FAIL: synced records missing or retention didn't delete old segments\n");
+        fail = 1;
+    }
+
+    removeSegments(basePath);
+    munmap(pProgress, sizeof(WriterProgress_t));
+    return fail;
+}
+
+/**
+ * @brief a new writer never appends to an old segment, it starts the next
+ * sequence number and a reader sees the records from both runs
+ *
+ * @return int8_t test results
+ */
+int8_t test_restart(void)
+{
+    static LogSegment_t segment;
+    char basePath[64], path[LOG_SEGMENT_PATH_SIZE];
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    uint32_t oldest, newest, run, count = 0;
+    logItem_t logItem;
+    int8_t fail = 0;
+
+    testCount++;
+    snprintf(basePath, sizeof(basePath), "%s/restart.bin", testDir);
+
+    for(run = 0; run < 2; ++run)
+    {
+        if(log_segment_open(&segment, basePath, TEST_SEGMENT_SIZE, TEST_SEGMENTS_KEPT, LOG_FORMAT_COMPACT) != LOG_STATUS_OK) {
+            printf("FAIL: log_segment_open\n");
+            return 1;
+        }
+        makeRecord(&logItem, payload, run);
+        log_segment_write_item(&segment, &logItem);
+        log_segment_close(&segment);
+    }
+
+    if((log_segment_find(basePath, &oldest, &newest) != LOG_STATUS_OK) || (oldest != 1) || (newest != 2)) {
+        printf("FAIL: expected segments 1..2\n");
+        fail = 1;
+    }
+    else {
+        for(run = oldest; run <= newest; ++run)
+        {
+            log_segment_path(path, basePath, run);
+            if(log_reader_open(&reader, path) != LOG_STATUS_OK)
+                continue;
+            if((log_reader_next(&reader, &logItem) == LOG_STATUS_OK) && (logItem.time == (run - 1)) &&
+               (reader.segmentClosed == 1) && (log_reader_next(&reader, &logItem) == LOG_STATUS_EOF))
+                ++count;
+            log_reader_close(&reader);
+        }
+        if(count != 2) {
+            printf("FAIL: expected one record in each closed segment\n");
+            fail = 1;
+        }
+    }
+
+    removeSegments(basePath);
+    return fail;
+}
+
+/**
+ * @brief segment 1000000 is named with one more digit than 999999 and both
+ * are found; names with too few digits or a sign aren't segments
+ *
+ * @return int8_t test results
+ */
+int8_t test_longSequence(void)
+{
+    const char *notSegments[] = {"12345", "+00001", "00001x"};
+    char basePath[64], path[LOG_SEGMENT_PATH_SIZE];
+    uint32_t oldest, newest, seq, ind;
+    int8_t fail = 0;
+    int fd;
+
+    testCount++;
+    snprintf(basePath, sizeof(basePath), "%s/long.bin", testDir);
+    for(seq = 999999; seq <= 1000000; ++seq)
+    {
+        log_segment_path(path, basePath, seq);
+        if((fd = open(path, O_CREAT | O_WRONLY, 0644)) >= 0)
+            close(fd);
+    }
+    for(ind = 0; ind < (sizeof(notSegments) / sizeof(notSegments[0])); ++ind)
+    {
+        snprintf(path, sizeof(path), "%s.%s", basePath, notSegments[ind]);
+        if((fd = open(path, O_CREAT | O_WRONLY, 0644)) >= 0)
+            close(fd);
+    }
+
+    if((log_segment_find(basePath, &oldest, &newest) != LOG_STATUS_OK) || (oldest != 999999) || (newest != 1000000)) {
+        printf("FAIL: expected segments 999999..1000000\n");
+        fail = 1;
+    }
+
+    removeSegments(basePath);
+    for(ind = 0; ind < (sizeof(notSegments) / sizeof(notSegments[0])); ++ind)
+    {
+        snprintf(path, sizeof(path), "%s.%s", basePath, notSegments[ind]);
+        unlink(path);
+    }
+    return fail;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief child process, logs until killed
+ */
+static void runWriter(const char *pBasePath, LogFormat_e format, WriterProgress_t *pProgress)
+{
+    static LogSegment_t segment;
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    logItem_t logItem;
+    uint32_t ind;
+
+    if(log_segment_open(&segment, pBasePath, TEST_SEGMENT_SIZE, TEST_SEGMENTS_KEPT, format) != LOG_STATUS_OK)
+        return;
+
+    for(ind = 0; ; ++ind)
+    {
+        makeRecord(&logItem, payload, ind);
+        if(log_segment_write_item(&segment, &logItem) != LOG_STATUS_OK)
+            return;
+        pProgress->written = ind + 1;
+
+        /* ERROR records are msync'd before write returns */
+        if(logItem.logMsgId == LOG_MSG_ERROR)
+            pProgress->synced = ind + 1;
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
+static void makeRecord(logItem_t *pLogItem, uint8_t *pPayload, uint32_t ind)
+{
+    memset(pPayload, 0, TEST_PAYLOAD_SIZE);
+    snprintf((char *)pPayload, TEST_PAYLOAD_SIZE, "record %08u", ind);
+
+    pLogItem->payloadFormat = LOG_PAYLOAD_TEXT;
+    pLogItem->logMsgId = ((ind % TEST_ERROR_INTERVAL) == (TEST_ERROR_INTERVAL - 1)) ? LOG_MSG_ERROR : LOG_MSG_INFO;
+    pLogItem->fileId = logFileId;
+    pLogItem->pFilename = NULL;
+    pLogItem->lineNum = __LINE__;
+    pLogItem->time = ind;
+    pLogItem->payloadLength = log_strlen(pPayload);
+    pLogItem->pPayload = pPayload;
+    pLogItem->sourceId = (uint16_t)getpid();
+    log_set_checksum(pLogItem);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void removeSegments(const char *pBasePath)
+{
+    char path[LOG_SEGMENT_PATH_SIZE];
+    uint32_t oldest, newest;
+
+    if(log_segment_find(pBasePath, &oldest, &newest) != LOG_STATUS_OK)
+        return;
+    for(; oldest <= newest; ++oldest)
+    {
+        log_segment_path(path, pBasePath, oldest);
+        unlink(path);
+    }
+}
+
+/*---------------------------------------------------------------------------------*/
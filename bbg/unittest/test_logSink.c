@@ -0,0 +1,259 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 18, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_logSink.c
+ * @brief log sink appends only to a file already in the format it writes:
+ * write a file in each of legacy and compact, compressed or not, then open
+ * a sink on it in each, and check the file is left alone on a mismatch.
+ * Also that the reader gets past entries with a corrupt length.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "my_debug.h"
+#include "logger_types.h"
+#include "logger_helper.h"
+#include "logger_sink.h"
+#include "logger_reader.h"
+
+LOG_REGISTER_FILE(LOG_FILE_BBG_TEST_LOG_SINK);
+
+#define TEST_RECORDS            (10)
+#define MAX_READ_CALLS          (1000)  /* far more than a test file's entries */
+
+typedef struct {
+    const char *pName;
+    LogFormat_e format;
+    uint8_t compress;
+} SinkMode_t;
+
+static const SinkMode_t modes[] = {
+    {"legacy", LOG_FORMAT_LEGACY, 0},
+    {"compact", LOG_FORMAT_COMPACT, 0},
+    {"compressed legacy", LOG_FORMAT_LEGACY, 1},
+    {"compressed compact", LOG_FORMAT_COMPACT, 1},
+};
+#define NUM_MODES               (sizeof(modes) / sizeof(modes[0]))
+
+static char testPath[] = "/tmp/test_logSink.XXXXXX";
+static LogSink_t sink;
+static LogReader_t reader;
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_emptyFile(void);
+int8_t test_appendMatrix(void);
+int8_t test_corruptLength(void);
+
+static int8_t writeFile(const SinkMode_t *pMode, uint8_t truncate);
+static off_t fileSize(void);
+static void makeRecord(logItem_t *pLogItem, uint8_t *pPayload, uint32_t ind);
+
+/*---------------------------------------------------------------------------------*/
+int main(void)
+{
+    uint8_t testFails = 0;
+    int fd;
+
+    if((fd = mkstemp(testPath)) < 0) {
+        ERRNO_PRINT("couldn't create test file");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+    printf("test cases for log sink appends\n");
+
+    testFails += test_emptyFile();
+    testFails += test_appendMatrix();
+    testFails += test_corruptLength();
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    unlink(testPath);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief any format starts an empty file
+ *
+ * @return int8_t test results
+ */
+int8_t test_emptyFile(void)
+{
+    uint32_t mode;
+
+    testCount++;
+    for(mode = 0; mode < NUM_MODES; ++mode)
+    {
+        if(writeFile(&modes[mode], 1) != EXIT_SUCCESS) {
+            printf("FAIL: couldn't start an empty file %s\n", modes[mode].pName);
+            return 1;
+        }
+    }
+    printf("PASS: empty file in every format\n");
+    return 0;
+}
+
+/**
+ * @brief a file in each format appended to in each; only the same format
+ * may append, and a refused append leaves the file as it was
+ *
+ * @return int8_t test results
+ */
+int8_t test_appendMatrix(void)
+{
+    uint32_t existing, mode;
+    off_t before;
+    int8_t ret;
+
+    testCount++;
+    for(existing = 0; existing < NUM_MODES; ++existing)
+    {
+        for(mode = 0; mode < NUM_MODES; ++mode)
+        {
+            if(writeFile(&modes[existing], 1) != EXIT_SUCCESS) {
+                printf("FAIL: couldn't write a %s file\n", modes[existing].pName);
+                return 1;
+            }
+            before = fileSize();
+            ret = writeFile(&modes[mode], 0);
+            if((existing == mode) && ((ret != EXIT_SUCCESS) || (fileSize() <= before))) {
+                printf("FAIL: %s file not appended to\n", modes[existing].pName);
+                return 1;
+            }
+            if((existing != mode) && ((ret == EXIT_SUCCESS) || (fileSize() != before))) {
+                printf("FAIL: %s records appended to a %s file\n", modes[mode].pName, modes[existing].pName);
+                return 1;
+            }
+        }
+    }
+    printf("PASS: appends only in the file's own format\n");
+    return 0;
+}
+
+/**
+ * @brief string and record entries whose length is more than the reader
+ * buffers, between two sessions; reading skips them and gets every record
+ *
+ * @return int8_t test results
+ */
+int8_t test_corruptLength(void)
+{
+    /* 'S' ID 0, then 'R' with the rest zero, both of length 0xFFFF */
+    const uint8_t corrupt[LOG_COMPACT_STR_HDR_SIZE + LOG_COMPACT_REC_HDR_SIZE] = {
+        LOG_COMPACT_TAG_STRING, 0, 0, 0, 0xFF, 0xFF,
+        LOG_COMPACT_TAG_RECORD, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0, 0,
+    };
+    logItem_t logItem;
+    uint32_t calls = 0;
+    uint8_t ret;
+    int fd;
+
+    testCount++;
+    if(writeFile(&modes[1], 1) != EXIT_SUCCESS) {
+        printf("FAIL: couldn't write a compact file\n");
+        return 1;
+    }
+    fd = open(testPath, O_WRONLY | O_APPEND);
+    if((fd < 0) || (write(fd, corrupt, sizeof(corrupt)) != sizeof(corrupt))) {
+        printf("FAIL: couldn't append corrupt entries\n");
+        if(fd >= 0)
+            close(fd);
+        return 1;
+    }
+    close(fd);
+    if(writeFile(&modes[1], 0) != EXIT_SUCCESS) {
+        printf("FAIL: couldn't append a compact session\n");
+        return 1;
+    }
+
+    if(log_reader_open(&reader, testPath) != LOG_STATUS_OK) {
+        printf("FAIL: couldn't open test file to read\n");
+        return 1;
+    }
+    do {
+        ret = log_reader_next(&reader, &logItem);
+    } while((ret != LOG_STATUS_EOF) && (++calls < MAX_READ_CALLS));
+    log_reader_close(&reader);
+
+    if((ret != LOG_STATUS_EOF) || (reader.records != (2 * TEST_RECORDS)) || (reader.badRecords == 0)) {
+        printf("FAIL: %s after %u reads, %u of %u records, %u corrupt entries\n",
+               (ret == LOG_STATUS_EOF) ? "end of file" : "no end of file", calls,
+               reader.records, 2 * TEST_RECORDS, reader.badRecords);
+        return 1;
+    }
+    printf("PASS: corrupt lengths skipped, %u entries\n", reader.badRecords);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief open the test file as the logging thread does, and write a few
+ * records through a sink if it takes the file
+ */
+static int8_t writeFile(const SinkMode_t *pMode, uint8_t truncate)
+{
+    uint8_t payload[LOG_MSG_PAYLOAD_SIZE];
+    logItem_t logItem;
+    uint32_t ind;
+    int8_t ret = EXIT_SUCCESS;
+    int fd;
+
+    fd = open(testPath, O_CREAT | O_RDWR | O_APPEND | ((truncate) ? O_TRUNC : 0), 0644);
+    if(fd < 0)
+        return EXIT_FAILURE;
+    if(log_sink_init(&sink, fd, pMode->format, pMode->compress) != LOG_STATUS_OK) {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    for(ind = 0; ind < TEST_RECORDS; ++ind)
+    {
+        makeRecord(&logItem, payload, ind);
+        if(log_sink_write_item(&sink, &logItem) != LOG_STATUS_OK)
+            ret = EXIT_FAILURE;
+    }
+    if(log_sink_flush(&sink) != LOG_STATUS_OK)
+        ret = EXIT_FAILURE;
+    close(fd);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+static off_t fileSize(void)
+{
+    struct stat fileStat;
+
+    return (stat(testPath, &fileStat) == 0) ? fileStat.st_size : -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void makeRecord(logItem_t *pLogItem, uint8_t *pPayload, uint32_t ind)
+{
+    snprintf((char *)pPayload, LOG_MSG_PAYLOAD_SIZE, "sink record %u", ind);
+
+    pLogItem->payloadFormat = LOG_PAYLOAD_TEXT;
+    pLogItem->logMsgId = LOG_MSG_INFO;
+    pLogItem->fileId = logFileId;
+    pLogItem->pFilename = NULL;
+    pLogItem->lineNum = __LINE__;
+    pLogItem->time = 123456789 + ind;
+    pLogItem->payloadLength = log_strlen(pPayload);
+    pLogItem->pPayload = pPayload;
+    pLogItem->sourceId = 1234;
+    log_set_checksum(pLogItem);
+}
+
+/*---------------------------------------------------------------------------------*/
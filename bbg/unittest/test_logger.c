@@ -31,6 +31,8 @@
 #include "loggingThread.h"
 #include "remoteThread.h"
 
+LOG_REGISTER_FILE(LOG_FILE_BBG_TEST_LOGGER);
+
 #define NUM_THREADS (4)
 
 /* global for causing threads to exit */
@@ -0,0 +1,338 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 14, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_remoteFrame.c
+ * @brief feed a recorded stream of frames to a FrameReader_t split up every
+ * way TCP might, clean and with damage, and check what comes out; fill
+ * batches and take them apart again
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "my_debug.h"
+#include "remoteFrame.h"
+
+#define TEST_FRAMES             (200)
+#define TEST_RUNS               (1000)
+#define TEST_STREAM_SIZE        (TEST_FRAMES * (FRAME_MAX_SIZE + TEST_MAX_GARBAGE))
+#define TEST_MAX_GARBAGE        (64)        /* bytes between frames when damaging */
+#define TEST_DAMAGE_PCT         (10)        /* of frames damaged, and of gaps with garbage */
+
+typedef struct {
+    FrameHeader_t hdr;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint8_t damaged;
+} TestFrame_t;
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_eachType(void);
+int8_t test_segmentations(void);
+int8_t test_damage(void);
+int8_t test_batch(void);
+
+static uint32_t record(uint8_t damage);
+static uint8_t feed(uint32_t len, uint32_t maxChunk, uint32_t *pFound, uint32_t *pSkipped);
+static uint32_t nextUndamaged(uint32_t ind);
+
+static TestFrame_t frames[TEST_FRAMES];
+static uint8_t stream[TEST_STREAM_SIZE];
+static FrameReader_t reader;
+static uint32_t readerBuf[FRAME_READER_SIZE / sizeof(uint32_t)];
+
+/*---------------------------------------------------------------------------------*/
+int main(void)
+{
+    uint8_t testFails = 0;
+
+    printf("test cases for remote link frames\n");
+    srand(5013);
+
+    testFails += test_eachType();
+    testFails += test_segmentations();
+    testFails += test_damage();
+    testFails += test_batch();
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief one frame of every packet the links send, whole
+ *
+ * @return int8_t test results
+ */
+int8_t test_eachType(void)
+{
+    const uint32_t lens[FRAME_TYPE_END] = {
+        [FRAME_TYPE_HELLO] = sizeof(RemoteHelloPacket),
+        [FRAME_TYPE_LOG] = sizeof(LogMsgPacket),
+        [FRAME_TYPE_STATUS] = sizeof(TaskStatusPacket),
+        [FRAME_TYPE_STATUS_SUMMARY] = sizeof(StatusSummaryPacket),
+        [FRAME_TYPE_CMD] = sizeof(RemoteCmdPacket),
+        [FRAME_TYPE_DATA] = sizeof(RemoteDataPacket),
+        [FRAME_TYPE_TELEMETRY] = sizeof(RemoteTelemetryPacket),
+    };
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    FrameHeader_t hdr, rxHdr;
+    uint8_t *pRx, *pPayload;
+    uint32_t type, space, ind;
+
+    testCount++;
+    for(type = FRAME_TYPE_HELLO; type < FRAME_TYPE_END; ++type)
+    {
+        if(lens[type] > FRAME_MAX_PAYLOAD) {
+            printf("FAIL: type %u packet is %u bytes, more than FRAME_MAX_PAYLOAD\n", type, lens[type]);
+            return 1;
+        }
+        for(ind = 0; ind < lens[type]; ++ind)
+            payload[ind] = (uint8_t)rand();
+        frame_header(&hdr, (FrameType_e)type, payload, lens[type]);
+
+        frame_reader_init(&reader, (uint8_t *)readerBuf);
+        pRx = frame_reader_space(&reader, &space);
+        memcpy(pRx, &hdr, sizeof(FrameHeader_t));
+        memcpy(&pRx[sizeof(FrameHeader_t)], payload, lens[type]);
+        frame_reader_commit(&reader, sizeof(FrameHeader_t) + lens[type]);
+        if((frame_reader_next(&reader, &rxHdr, &pPayload) != 1) || (rxHdr.type != type) ||
+           (rxHdr.length != lens[type]) || (memcmp(pPayload, payload, lens[type]) != 0) ||
+           (frame_reader_next(&reader, &rxHdr, &pPayload) != 0)) {
+            printf("FAIL: type %u frame didn't read back\n", type);
+            return 1;
+        }
+    }
+    printf("PASS: every packet type\n");
+    return 0;
+}
+
+/**
+ * @brief the same stream split into random pieces, from single bytes to
+ * more than the reader holds; every frame must come out, in order
+ *
+ * @return int8_t test results
+ */
+int8_t test_segmentations(void)
+{
+    uint32_t len, run, found, skipped;
+
+    testCount++;
+    len = record(0);
+    for(run = 0; run < TEST_RUNS; ++run)
+    {
+        /* every fourth run in pieces of a few bytes */
+        if(!feed(len, ((run % 4) == 0) ? 4 : FRAME_READER_SIZE, &found, &skipped))
+            return 1;
+        if((found != TEST_FRAMES) || (skipped != 0)) {
+            printf("FAIL: run %u, %u of %u frames, %u bytes skipped\n", run, found, TEST_FRAMES, skipped);
+            return 1;
+        }
+    }
+    printf("PASS: %u random segmentations of %u frames, %u bytes\n", TEST_RUNS, TEST_FRAMES, len);
+    return 0;
+}
+
+/**
+ * @brief streams with damaged frames and garbage between frames; every
+ * undamaged frame must come out, in order, and nothing else
+ *
+ * @return int8_t test results
+ */
+int8_t test_damage(void)
+{
+    uint32_t len, run, found, skipped, expected, ind, totalSkipped = 0;
+
+    testCount++;
+    for(run = 0; run < TEST_RUNS; ++run)
+    {
+        len = record(1);
+        for(ind = 0, expected = 0; ind < TEST_FRAMES; ++ind)
+            expected += !frames[ind].damaged;
+        if(!feed(len, FRAME_READER_SIZE, &found, &skipped))
+            return 1;
+        if(found != expected) {
+            printf("FAIL: run %u, %u of %u undamaged frames\n", run, found, expected);
+            return 1;
+        }
+        totalSkipped += skipped;
+    }
+    printf("PASS: %u damaged streams, %u bytes skipped resyncing\n", TEST_RUNS, totalSkipped);
+    return 0;
+}
+
+/**
+ * @brief batches of random packets, each filled until the next won't fit,
+ * sent through the reader; every packet must come back out of its batch
+ * as it went in
+ *
+ * @return int8_t test results
+ */
+int8_t test_batch(void)
+{
+    const uint32_t lens[] = {sizeof(LogMsgPacket), sizeof(TaskStatusPacket), sizeof(RemoteDataPacket), 1, 2, 3};
+    static FrameBatch_t batch;
+    static uint8_t packets[FRAME_MAX_PAYLOAD / sizeof(FrameRecord_t)][sizeof(LogMsgPacket)];
+    FrameType_e types[FRAME_MAX_PAYLOAD / sizeof(FrameRecord_t)];
+    uint32_t packetLens[FRAME_MAX_PAYLOAD / sizeof(FrameRecord_t)];
+    FrameHeader_t hdr;
+    FrameType_e type;
+    uint8_t *pRx, *pPayload, *pPacket;
+    uint32_t run, num, ind, len, space, offset, packetLen, totalPackets = 0;
+
+    testCount++;
+    for(run = 0; run < TEST_RUNS; ++run)
+    {
+        frame_batch_init(&batch);
+        if(frame_batch_finish(&batch) != 0) {
+            printf("FAIL: empty batch has something to send\n");
+            return 1;
+        }
+        for(num = 0; ; ++num)
+        {
+            len = lens[rand() % (sizeof(lens) / sizeof(lens[0]))];
+            type = (FrameType_e)(FRAME_TYPE_LOG + (rand() % (FRAME_TYPE_BATCH - FRAME_TYPE_LOG)));
+            for(ind = 0; ind < len; ++ind)
+                packets[num][ind] = (uint8_t)rand();
+            if(!frame_batch_add(&batch, type, packets[num], len))
+                break;
+            types[num] = type;
+            packetLens[num] = len;
+        }
+        if((num != batch.records) || (frame_batch_free(&batch) >= FRAME_RECORD_SIZE(len))) {
+            printf("FAIL: run %u, batch of %u took %u, %u bytes free\n", run, num, batch.records, frame_batch_free(&batch));
+            return 1;
+        }
+
+        len = frame_batch_finish(&batch);
+        frame_reader_init(&reader, (uint8_t *)readerBuf);
+        pRx = frame_reader_space(&reader, &space);
+        memcpy(pRx, &batch.hdr, len);
+        frame_reader_commit(&reader, len);
+        if((len > FRAME_LINK_MSS) || !frame_reader_next(&reader, &hdr, &pPayload) || (hdr.type != FRAME_TYPE_BATCH)) {
+            printf("FAIL: run %u, batch of %u bytes didn't read back\n", run, len);
+            return 1;
+        }
+
+        for(ind = 0, offset = 0; frame_batch_next(pPayload, hdr.length, &offset, &type, &pPacket, &packetLen); ++ind)
+        {
+            if((ind >= num) || (type != types[ind]) || (packetLen != packetLens[ind]) ||
+               (((uintptr_t)pPacket % 4) != 0) || (memcmp(pPacket, packets[ind], packetLen) != 0)) {
+                printf("FAIL: run %u, packet %u of %u wrong\n", run, ind, num);
+                return 1;
+            }
+        }
+        if((ind != num) || (offset != hdr.length)) {
+            printf("FAIL: run %u, %u of %u packets out of the batch\n", run, ind, num);
+            return 1;
+        }
+        totalPackets += num;
+    }
+    printf("PASS: %u batches, %u packets\n", TEST_RUNS, totalPackets);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief random frames into frames[], their bytes into stream; damage
+ * some frames and put garbage between some
+ *
+ * @return uint32_t bytes in stream
+ */
+static uint32_t record(uint8_t damage)
+{
+    TestFrame_t *pFrame;
+    uint32_t ind, byte, len = 0, garbage, payloadLen;
+
+    for(ind = 0; ind < TEST_FRAMES; ++ind)
+    {
+        pFrame = &frames[ind];
+        if(damage && ((uint32_t)(rand() % 100) < TEST_DAMAGE_PCT)) {
+            for(garbage = 1 + (uint32_t)(rand() % TEST_MAX_GARBAGE); garbage > 0; --garbage)
+                stream[len++] = (uint8_t)rand();
+        }
+
+        payloadLen = (uint32_t)(rand() % (FRAME_MAX_PAYLOAD + 1));
+        for(byte = 0; byte < payloadLen; ++byte)
+            pFrame->payload[byte] = (uint8_t)rand();
+        frame_header(&pFrame->hdr, (FrameType_e)(FRAME_TYPE_HELLO + (rand() % (FRAME_TYPE_END - 1))),
+                     pFrame->payload, payloadLen);
+        memcpy(&stream[len], &pFrame->hdr, sizeof(FrameHeader_t));
+        memcpy(&stream[len + sizeof(FrameHeader_t)], pFrame->payload, pFrame->hdr.length);
+
+        /* one flipped bit anywhere in the frame */
+        pFrame->damaged = damage && ((uint32_t)(rand() % 100) < TEST_DAMAGE_PCT);
+        if(pFrame->damaged) {
+            byte = (uint32_t)(rand() % (sizeof(FrameHeader_t) + pFrame->hdr.length));
+            stream[len + byte] ^= (uint8_t)(1 << (rand() % 8));
+        }
+        len += sizeof(FrameHeader_t) + pFrame->hdr.length;
+    }
+    return len;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief feed stream to the reader in chunks of 1 to maxChunk bytes, no
+ * more than it has space for, checking each frame it returns is the next
+ * undamaged one
+ *
+ * @return uint8_t 0 if a frame was wrong
+ */
+static uint8_t feed(uint32_t len, uint32_t maxChunk, uint32_t *pFound, uint32_t *pSkipped)
+{
+    FrameHeader_t hdr;
+    uint8_t *pRx, *pPayload;
+    uint32_t pos = 0, chunk, space, expect = nextUndamaged(0);
+
+    *pFound = 0;
+    frame_reader_init(&reader, (uint8_t *)readerBuf);
+    while(pos < len)
+    {
+        chunk = 1 + (uint32_t)(rand() % maxChunk);
+        chunk = (chunk > (len - pos)) ? (len - pos) : chunk;
+        pRx = frame_reader_space(&reader, &space);
+        chunk = (chunk > space) ? space : chunk;
+        memcpy(pRx, &stream[pos], chunk);
+        frame_reader_commit(&reader, chunk);
+        pos += chunk;
+
+        while(frame_reader_next(&reader, &hdr, &pPayload))
+        {
+            if(expect >= TEST_FRAMES) {
+                printf("FAIL: frame returned after the last one\n");
+                return 0;
+            }
+            if((((uintptr_t)pPayload % 4) != 0) || (memcmp(&hdr, &frames[expect].hdr, sizeof(FrameHeader_t)) != 0) ||
+               (memcmp(pPayload, frames[expect].payload, hdr.length) != 0)) {
+                printf("FAIL: frame %u wrong or out of order (payload %saligned)\n", expect,
+                       (((uintptr_t)pPayload % 4) != 0) ? "un" : "");
+                return 0;
+            }
+            ++*pFound;
+            expect = nextUndamaged(expect + 1);
+        }
+    }
+    *pSkipped = reader.skipped;
+    return 1;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint32_t nextUndamaged(uint32_t ind)
+{
+    while((ind < TEST_FRAMES) && frames[ind].damaged)
+        ++ind;
+    return ind;
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,284 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 8, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_supervisor.c
+ * @brief fault injection for the thread supervisor: kill remoteDataThread
+ * repeatedly and time how long until it beats again, then check a crash
+ * looping thread is backed off and given up on
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <mqueue.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "remoteThread.h"
+#include "healthMonitor.h"
+#include "heartbeat.h"
+#include "supervisor.h"
+
+#define TEST_HB_QUEUE_NAME      "/test_supervisor_hb_mq"
+#define TEST_LOG_QUEUE_NAME     "/test_supervisor_log_mq"
+#define TEST_DATA_QUEUE_NAME    "/test_supervisor_data_mq"
+#define TEST_HEARTBEAT_NAME     "/test_supervisor_shm"
+#define TEST_KILLS              (SUPERVISOR_MAX_RESTARTS)
+#define TEST_BEAT_TIMEOUT_USEC  (10000000)
+#define USEC_PER_SEC            (1000000ULL)
+
+int8_t test_killRemoteData(void);
+int8_t test_giveUp(void);
+int8_t test_crashLoop(void);
+static void *quickExitThread(void *pArg);
+static int8_t waitForNewBeat(ProcessId_e Id, uint32_t oldTid, uint32_t *pTid);
+static int8_t waitForState(ProcessId_e Id, SupervisorState_e state, uint32_t timeoutUsec);
+static uint64_t usecNow(void);
+
+static uint8_t exitFlag = 1;
+static uint8_t testCount = 0;
+static SensorThreadInfo sensorInfo;
+static pthread_t dataThread, crashThread;
+static volatile uint32_t crashRuns = 0;
+
+int main(void)
+{
+    struct mq_attr mqAttr;
+    struct sigaction action;
+    mqd_t hbQueue, logQueue, dataQueue;
+    uint8_t testFails = 0;
+
+    /* remoteDataThread opens these by name, as it does from main */
+    memset(&mqAttr, 0, sizeof(struct mq_attr));
+    mqAttr.mq_maxmsg = STATUS_MSG_QUEUE_DEPTH;
+    mqAttr.mq_msgsize = STATUS_MSG_QUEUE_MSG_SIZE;
+    hbQueue = mq_open(TEST_HB_QUEUE_NAME, O_CREAT | O_RDWR | O_NONBLOCK, 0666, &mqAttr);
+    mqAttr.mq_maxmsg = LOG_MSG_QUEUE_DEPTH;
+    mqAttr.mq_msgsize = LOG_MSG_QUEUE_MSG_SIZE;
+    logQueue = mq_open(TEST_LOG_QUEUE_NAME, O_CREAT | O_RDWR | O_NONBLOCK, 0666, &mqAttr);
+    mqAttr.mq_maxmsg = STATUS_MSG_QUEUE_DEPTH;
+    mqAttr.mq_msgsize = DATA_MSG_QUEUE_MSG_SIZE;
+    dataQueue = mq_open(TEST_DATA_QUEUE_NAME, O_CREAT | O_RDWR | O_NONBLOCK, 0666, &mqAttr);
+    if((hbQueue == -1) || (logQueue == -1) || (dataQueue == -1)) {
+        ERRNO_PRINT("test_supervisor couldn't create queues");
+        return EXIT_FAILURE;
+    }
+    memset(&sensorInfo, 0, sizeof(SensorThreadInfo));
+    strcpy(sensorInfo.heartbeatMsgQueueName, TEST_HB_QUEUE_NAME);
+    strcpy(sensorInfo.logMsgQueueName, TEST_LOG_QUEUE_NAME);
+    strcpy(sensorInfo.dataMsgQueueName, TEST_DATA_QUEUE_NAME);
+
+    /* recovery is timed by the new thread's first heartbeat */
+    if(heartbeat_init(TEST_HEARTBEAT_NAME) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_flags = SA_SIGINFO;
+    action.sa_sigaction = remoteDataSigHandler;
+    sigaction(SIGRTMIN + (uint8_t)PID_REMOTE_DATA, &action, NULL);
+
+    if(supervisor_init(&exitFlag) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    printf("test cases for thread supervisor\n");
+    testFails += test_killRemoteData();
+    testFails += test_giveUp();
+    testFails += test_crashLoop();
+
+    exitFlag = 0;
+    supervisor_stop();
+    supervisor_join(PID_REMOTE_DATA);
+    supervisor_join(PID_REMOTE_CMD);
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    heartbeat_destroy(TEST_HEARTBEAT_NAME);
+    mq_close(hbQueue);
+    mq_close(logQueue);
+    mq_close(dataQueue);
+    mq_unlink(TEST_HB_QUEUE_NAME);
+    mq_unlink(TEST_LOG_QUEUE_NAME);
+    mq_unlink(TEST_DATA_QUEUE_NAME);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief restart remoteDataThread TEST_KILLS times through the same call
+ * the health monitor makes; each time a new thread must beat, the old
+ * socket must be rebound, and the backoff must double
+ *
+ * @return int8_t test results
+ */
+int8_t test_killRemoteData(void)
+{
+    SupervisorInfo_t info;
+    uint64_t start, recovery, minRecovery = UINT64_MAX, maxRecovery = 0, sumRecovery = 0;
+    uint32_t tid, newTid, kill;
+
+    testCount++;
+    if(supervisor_start(PID_REMOTE_DATA, remoteDataThreadHandler, &sensorInfo, &dataThread) != EXIT_SUCCESS) {
+        printf("FAIL: couldn't start remoteDataThread\n");
+        return 1;
+    }
+    if(waitForNewBeat(PID_REMOTE_DATA, 0, &tid) != EXIT_SUCCESS) {
+        printf("FAIL: remoteDataThread never beat\n");
+        return 1;
+    }
+
+    for(kill = 1; kill <= TEST_KILLS; ++kill)
+    {
+        start = usecNow();
+        if(supervisor_restart(PID_REMOTE_DATA) != EXIT_SUCCESS) {
+            printf("FAIL: restart %u refused\n", kill);
+            return 1;
+        }
+        if(waitForNewBeat(PID_REMOTE_DATA, tid, &newTid) != EXIT_SUCCESS) {
+            printf("FAIL: remoteDataThread didn't come back after kill %u\n", kill);
+            return 1;
+        }
+        recovery = usecNow() - start;
+        tid = newTid;
+
+        supervisor_info(PID_REMOTE_DATA, &info);
+        printf("  kill %u: beating again after %llu ms (down %u ms, next backoff %u ms)\n",
+               kill, (unsigned long long)(recovery / 1000), info.lastRecoveryUsec / 1000,
+               info.backoffUsec / 1000);
+        if((info.restarts != kill) || (info.backoffUsec != (SUPERVISOR_BACKOFF_MIN_USEC << kill))) {
+            printf("FAIL: after kill %u restarts %u backoff %u usec\n", kill, info.restarts, info.backoffUsec);
+            return 1;
+        }
+        minRecovery = (recovery < minRecovery) ? recovery : minRecovery;
+        maxRecovery = (recovery > maxRecovery) ? recovery : maxRecovery;
+        sumRecovery += recovery;
+    }
+
+    printf("PASS: remoteDataThread recovered from %u kills, min %llu avg %llu max %llu ms\n",
+           TEST_KILLS, (unsigned long long)(minRecovery / 1000),
+           (unsigned long long)(sumRecovery / TEST_KILLS / 1000), (unsigned long long)(maxRecovery / 1000));
+    return 0;
+}
+
+/**
+ * @brief one kill more than the window allows leaves remoteDataThread down
+ *
+ * @return int8_t test results
+ */
+int8_t test_giveUp(void)
+{
+    testCount++;
+    if(supervisor_restart(PID_REMOTE_DATA) != EXIT_SUCCESS) {
+        printf("FAIL: restart refused before limit\n");
+        return 1;
+    }
+    if(waitForState(PID_REMOTE_DATA, SUPERVISOR_GAVE_UP, TEST_BEAT_TIMEOUT_USEC) != EXIT_SUCCESS) {
+        printf("FAIL: supervisor didn't give up after %u restarts\n", SUPERVISOR_MAX_RESTARTS);
+        return 1;
+    }
+    if(supervisor_restart(PID_REMOTE_DATA) == EXIT_SUCCESS) {
+        printf("FAIL: restart accepted after giving up\n");
+        return 1;
+    }
+    printf("PASS: gave up on remoteDataThread after %u restarts\n", SUPERVISOR_MAX_RESTARTS);
+    return 0;
+}
+
+/**
+ * @brief a thread that exits as soon as it starts is re-run with growing
+ * gaps, then left down; total time is the sum of the backoffs
+ *
+ * @return int8_t test results
+ */
+int8_t test_crashLoop(void)
+{
+    uint64_t start, elapsed, expected = 0;
+    uint32_t ind;
+
+    testCount++;
+    for(ind = 0; ind < SUPERVISOR_MAX_RESTARTS; ++ind)
+        expected += (uint64_t)SUPERVISOR_BACKOFF_MIN_USEC << ind;
+
+    start = usecNow();
+    if(supervisor_start(PID_REMOTE_CMD, quickExitThread, NULL, &crashThread) != EXIT_SUCCESS) {
+        printf("FAIL: couldn't start crash looping thread\n");
+        return 1;
+    }
+    if(waitForState(PID_REMOTE_CMD, SUPERVISOR_GAVE_UP, (uint32_t)(expected * 2)) != EXIT_SUCCESS) {
+        printf("FAIL: crash looping thread still restarting after %llu ms\n",
+               (unsigned long long)(expected * 2 / 1000));
+        return 1;
+    }
+    elapsed = usecNow() - start;
+    if((crashRuns != (SUPERVISOR_MAX_RESTARTS + 1)) || (elapsed < expected)) {
+        printf("FAIL: crash looping thread ran %u times in %llu ms\n",
+               crashRuns, (unsigned long long)(elapsed / 1000));
+        return 1;
+    }
+    printf("PASS: crash looping thread ran %u times over %llu ms (backoffs total %llu ms)\n",
+           crashRuns, (unsigned long long)(elapsed / 1000), (unsigned long long)(expected / 1000));
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void *quickExitThread(void *pArg)
+{
+    __atomic_add_fetch(&crashRuns, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief wait for a heartbeat from a thread other than oldTid
+ */
+static int8_t waitForNewBeat(ProcessId_e Id, uint32_t oldTid, uint32_t *pTid)
+{
+    HeartbeatSlot_t slot;
+    uint64_t start = usecNow();
+
+    while((usecNow() - start) < TEST_BEAT_TIMEOUT_USEC)
+    {
+        if((heartbeat_read(Id, &slot) == EXIT_SUCCESS) && (slot.seq != 0) && (slot.tid != oldTid)) {
+            *pTid = slot.tid;
+            return EXIT_SUCCESS;
+        }
+        usleep(1000);
+    }
+    return EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+static int8_t waitForState(ProcessId_e Id, SupervisorState_e state, uint32_t timeoutUsec)
+{
+    SupervisorInfo_t info;
+    uint64_t start = usecNow();
+
+    do {
+        supervisor_info(Id, &info);
+        if(info.state == state)
+            return EXIT_SUCCESS;
+        usleep(1000);
+    } while((usecNow() - start) < timeoutUsec);
+    return EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * USEC_PER_SEC) + (now.tv_nsec / 1000);
+}
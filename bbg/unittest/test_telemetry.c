@@ -0,0 +1,617 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 18, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_telemetry.c
+ * @brief UDP telemetry sequence accounting, and the remote server taking
+ * telemetry through a lossy link on loopback
+ *
+ * usage: test_telemetry [seconds]
+ *
+ * The loopback test says hello on CMD_PORT as a node would, then sends its
+ * telemetry datagrams at 10 Hz and then 100 Hz to a shim that forwards
+ * them to TELEMETRY_PORT, dropping, holding back one past the next, or
+ * sending twice at random and counting what it did. Each run ends with
+ * one datagram the shim forwards untouched, so every gap is closed, and
+ * the server's lost, late and duplicate counts must match the shim's.
+ * Latency is from the sender's sendto() to the server storing the data in
+ * the node table, seen by polling the table; the shim's hop is included.
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "my_debug.h"
+#include "packet.h"
+#include "remoteThread.h"
+#include "remoteServer.h"
+#include "histogram.h"
+#include "nodeTable.h"
+#include "remoteFrame.h"
+#include "telemetrySeq.h"
+#include "bench_server.h"
+
+#define TEST_NODE_ID            (7)
+#define TEST_UNKNOWN_NODE_ID    (8)
+#define DEFAULT_SECONDS         (5)
+#define FIRST_SEQ               (0xFFFFFF00)    /* wraps during the first run */
+#define SEQ_RING                (256)           /* send times kept; far more than are in flight */
+#define POLL_USEC               (100)           /* node table polling; delays noticing, not the time taken */
+#define SETTLE_USEC             (100000)        /* for the last datagram to get through */
+#define CONNECT_TIMEOUT_USEC    (5000000)
+#define SHIM_DROP_PCT           (5)
+#define SHIM_HOLD_PCT           (5)             /* sent after the next */
+#define SHIM_DUP_PCT            (2)
+
+typedef struct {
+    FrameHeader_t hdr;
+    RemoteTelemetryPacket packet;
+} Datagram_t;
+
+typedef struct {
+    uint32_t forwarded;                 /* datagrams sent on, duplicates included */
+    uint32_t dropped;
+    uint32_t late;                      /* sent on after a newer one */
+    uint32_t duplicated;
+} ShimCounts_t;
+
+typedef struct {
+    uint16_t rateHz;
+    uint32_t seconds;
+    uint32_t sent;
+    uint32_t stored;                    /* node table dataCount */
+    uint8_t backwards;                  /* newest seq went back, or data isn't the newest's */
+    ShimCounts_t shim;
+    TelemetrySeq_t server;              /* change over the run */
+    Histogram_t latency;                /* usec */
+} Run_t;
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_inOrder(void);
+int8_t test_lossAndReorder(void);
+int8_t test_restart(void);
+int8_t test_rejected(void);
+int8_t test_loopback(Run_t *pRun);
+
+static int8_t startServer(void);
+static void stopServer(void);
+static int connectHello(void);
+static int openShim(uint16_t *pPort);
+static void sendTelemetry(int fd, uint16_t rateHz, uint32_t seq);
+static void *senderThread(void *arg);
+static void *shimThread(void *arg);
+static void forward(const Datagram_t *pDgram);
+static uint64_t usecNow(void);
+static void printRun(const Run_t *pRun);
+
+static BenchServer_t server;
+static struct sockaddr_in telemetryAddr;
+static int senderFd = -1;
+static int shimFd = -1;
+static volatile uint8_t running;
+static volatile uint8_t shimRunning;
+static volatile uint8_t lossy;
+static volatile uint32_t nextSeq = FIRST_SEQ;
+static uint64_t sendUsec[SEQ_RING];
+static ShimCounts_t shimCounts;
+
+/*---------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_SECONDS;
+    Run_t runs[] = {{10}, {REMOTE_TELEMETRY_MAX_HZ}};
+    uint8_t testFails = 0;
+    uint32_t ind;
+    int cmdFd;
+
+    if(seconds == 0) {
+        ERROR_PRINT("usage: test_telemetry [seconds]\n");
+        return EXIT_FAILURE;
+    }
+    printf("test cases for UDP telemetry\n");
+    srand(5013);
+
+    testFails += test_inOrder();
+    testFails += test_lossAndReorder();
+    testFails += test_restart();
+
+    if(startServer() != EXIT_SUCCESS) {
+        ++testCount;
+        ++testFails;
+        printf("FAIL: couldn't start the remote server\n");
+    }
+    else {
+        cmdFd = connectHello();
+        if(cmdFd < 0) {
+            ++testCount;
+            ++testFails;
+            printf("FAIL: node never made it into the node table\n");
+        }
+        else {
+            testFails += test_rejected();
+            printf("  %4s %8s %8s | %5s %5s %5s | %-23s\n", "", "", "", "lost", "late", "dup",
+                   "latency us");
+            printf("  %4s %8s %8s | %5s %5s %5s | %7s %7s %7s\n", "Hz", "sent/s", "stored/s",
+                   "", "", "", "p50", "p99", "max");
+            for(ind = 0; ind < (sizeof(runs) / sizeof(runs[0])); ++ind)
+            {
+                runs[ind].seconds = seconds;
+                testFails += test_loopback(&runs[ind]);
+                printRun(&runs[ind]);
+            }
+            close(cmdFd);
+        }
+        stopServer();
+    }
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief every datagram in order, across the wrap
+ *
+ * @return int8_t test results
+ */
+int8_t test_inOrder(void)
+{
+    TelemetrySeq_t seq;
+    uint32_t ind;
+
+    testCount++;
+    telemetry_seq_init(&seq);
+    for(ind = 0; ind < 200; ++ind)
+    {
+        if(telemetry_seq_update(&seq, 0xFFFFFFA0 + ind) != TELEMETRY_SEQ_NEW) {
+            printf("FAIL: in order datagram %u wasn't the newest\n", ind);
+            return 1;
+        }
+    }
+    if((seq.received != 200) || (seq.lost != 0) || (seq.late != 0) || (seq.duplicates != 0) ||
+       (seq.restarts != 0) || (seq.newest != (uint32_t)(0xFFFFFFA0 + 199))) {
+        printf("FAIL: in order counted %u lost, %u late, %u dup, %u restarts\n", seq.lost,
+               seq.late, seq.duplicates, seq.restarts);
+        return 1;
+    }
+    printf("PASS: in order\n");
+    return 0;
+}
+
+/**
+ * @brief gaps, one filled late, repeats, none of which moves the newest
+ * back; then one too far behind, taken as the node starting over
+ *
+ * @return int8_t test results
+ */
+int8_t test_lossAndReorder(void)
+{
+    const struct {
+        uint32_t seq;
+        TelemetrySeq_e result;
+        uint32_t lost;
+    } steps[] = {
+        {10, TELEMETRY_SEQ_NEW, 0},
+        {11, TELEMETRY_SEQ_NEW, 0},
+        {15, TELEMETRY_SEQ_NEW, 3},         /* 12 - 14 */
+        {13, TELEMETRY_SEQ_LATE, 2},
+        {13, TELEMETRY_SEQ_DUPLICATE, 2},
+        {15, TELEMETRY_SEQ_DUPLICATE, 2},
+        {10, TELEMETRY_SEQ_DUPLICATE, 2},
+        {100, TELEMETRY_SEQ_NEW, 86},       /* 16 - 99 */
+        {37, TELEMETRY_SEQ_LATE, 85},       /* furthest back the window reaches */
+        {36, TELEMETRY_SEQ_NEW, 85},        /* too far back; started over */
+    };
+    TelemetrySeq_t seq;
+    TelemetrySeq_e result;
+    uint32_t ind;
+
+    testCount++;
+    telemetry_seq_init(&seq);
+    for(ind = 0; ind < (sizeof(steps) / sizeof(steps[0])); ++ind)
+    {
+        result = telemetry_seq_update(&seq, steps[ind].seq);
+        if((result != steps[ind].result) || (seq.lost != steps[ind].lost)) {
+            printf("FAIL: step %u seq %u was %d with %u lost, expected %d with %u\n", ind,
+                   steps[ind].seq, result, seq.lost, steps[ind].result, steps[ind].lost);
+            return 1;
+        }
+    }
+    if((seq.late != 2) || (seq.duplicates != 3) || (seq.restarts != 1) || (seq.newest != 36)) {
+        printf("FAIL: %u late, %u dup, %u restarts, newest %u\n", seq.late, seq.duplicates,
+               seq.restarts, seq.newest);
+        return 1;
+    }
+    printf("PASS: loss and reorder\n");
+    return 0;
+}
+
+/**
+ * @brief a node counting from 0 again after a long run
+ *
+ * @return int8_t test results
+ */
+int8_t test_restart(void)
+{
+    TelemetrySeq_t seq;
+    uint32_t ind;
+
+    testCount++;
+    telemetry_seq_init(&seq);
+    for(ind = 0; ind < 1000; ++ind)
+        telemetry_seq_update(&seq, ind);
+    if((telemetry_seq_update(&seq, 0) != TELEMETRY_SEQ_NEW) ||
+       (telemetry_seq_update(&seq, 1) != TELEMETRY_SEQ_NEW) ||
+       (telemetry_seq_update(&seq, 1) != TELEMETRY_SEQ_DUPLICATE) ||
+       (seq.restarts != 1) || (seq.lost != 0) || (seq.newest != 1)) {
+        printf("FAIL: restart, %u restarts, %u lost, newest %u\n", seq.restarts, seq.lost, seq.newest);
+        return 1;
+    }
+    printf("PASS: node restart\n");
+    return 0;
+}
+
+/**
+ * @brief datagrams the server must drop: damaged, the wrong size, and
+ * from a node that never said hello; none may touch the node table
+ *
+ * @return int8_t test results
+ */
+int8_t test_rejected(void)
+{
+    uint8_t buf[sizeof(Datagram_t) + 4] = {0};
+    Datagram_t dgram;
+    RemoteRxStats_t before, after;
+    RemoteNode_t nodeBefore, nodeAfter;
+
+    testCount++;
+    remoteServerRxStats(&before);
+    node_table_get(TEST_NODE_ID, &nodeBefore);
+
+    memset(&dgram, 0, sizeof(Datagram_t));
+    dgram.packet.nodeId = TEST_NODE_ID;
+    dgram.packet.rateHz = 1;
+    dgram.packet.seq = 12345;
+    frame_header(&dgram.hdr, FRAME_TYPE_TELEMETRY, &dgram.packet, sizeof(RemoteTelemetryPacket));
+    memcpy(buf, &dgram, sizeof(Datagram_t));
+
+    buf[sizeof(FrameHeader_t) + 8] ^= 0x01;
+    sendto(shimFd, buf, sizeof(Datagram_t), 0, (struct sockaddr *)&telemetryAddr, sizeof(telemetryAddr));
+    buf[sizeof(FrameHeader_t) + 8] ^= 0x01;
+    sendto(shimFd, buf, sizeof(buf), 0, (struct sockaddr *)&telemetryAddr, sizeof(telemetryAddr));
+    dgram.packet.nodeId = TEST_UNKNOWN_NODE_ID;
+    frame_header(&dgram.hdr, FRAME_TYPE_TELEMETRY, &dgram.packet, sizeof(RemoteTelemetryPacket));
+    sendto(shimFd, &dgram, sizeof(Datagram_t), 0, (struct sockaddr *)&telemetryAddr, sizeof(telemetryAddr));
+    usleep(SETTLE_USEC);
+
+    remoteServerRxStats(&after);
+    node_table_get(TEST_NODE_ID, &nodeAfter);
+    if(((after.telemetry - before.telemetry) != 3) || ((after.telemetryDropped - before.telemetryDropped) != 3) ||
+       (nodeAfter.telemetry.received != nodeBefore.telemetry.received) ||
+       (node_table_get(TEST_UNKNOWN_NODE_ID, &nodeAfter) == EXIT_SUCCESS)) {
+        printf("FAIL: %u received, %u dropped of 3 bad datagrams\n", after.telemetry - before.telemetry,
+               after.telemetryDropped - before.telemetryDropped);
+        return 1;
+    }
+    printf("PASS: bad datagrams dropped\n");
+    return 0;
+}
+
+/**
+ * @brief one rate through the shim; the server's accounting must be the
+ * shim's, its data never older than it had
+ *
+ * @param pRun rate and seconds in, results out
+ * @return int8_t test results
+ */
+int8_t test_loopback(Run_t *pRun)
+{
+    RemoteNode_t start, node;
+    pthread_t sender, shim;
+    uint64_t end;
+    uint32_t lastCount, newest;
+    uint8_t haveNewest;
+
+    testCount++;
+    hist_reset(&pRun->latency);
+    memset(&shimCounts, 0, sizeof(ShimCounts_t));
+    node_table_get(TEST_NODE_ID, &start);
+    lastCount = start.dataCount;
+    newest = start.telemetry.newest;
+    haveNewest = (start.dataCount != 0);
+
+    lossy = 1;
+    running = 1;
+    shimRunning = 1;
+    if((pthread_create(&shim, NULL, shimThread, NULL) != 0) ||
+       (pthread_create(&sender, NULL, senderThread, pRun) != 0)) {
+        printf("FAIL: %u Hz, couldn't start threads\n", pRun->rateHz);
+        return 1;
+    }
+
+    end = usecNow() + ((uint64_t)pRun->seconds * 1000000ULL);
+    while(usecNow() < end)
+    {
+        node_table_get(TEST_NODE_ID, &node);
+        if(node.dataCount != lastCount) {
+            if((haveNewest && ((int32_t)(node.telemetry.newest - newest) <= 0)) ||
+               ((uint32_t)node.data.luxData != (node.telemetry.newest % SEQ_RING)))
+                pRun->backwards = 1;
+            hist_record(&pRun->latency, (uint32_t)(node.dataUsec - sendUsec[node.telemetry.newest % SEQ_RING]));
+            lastCount = node.dataCount;
+            newest = node.telemetry.newest;
+            haveNewest = 1;
+        }
+        usleep(POLL_USEC);
+    }
+
+    /* stop sending; the last datagram through untouched closes any gap */
+    running = 0;
+    pthread_join(sender, NULL);
+    lossy = 0;
+    sendTelemetry(senderFd, pRun->rateHz, nextSeq++);
+    ++pRun->sent;
+    usleep(SETTLE_USEC);
+    shimRunning = 0;
+    pthread_join(shim, NULL);
+
+    node_table_get(TEST_NODE_ID, &node);
+    pRun->shim = shimCounts;
+    pRun->stored = node.dataCount - start.dataCount;
+    pRun->server.received = node.telemetry.received - start.telemetry.received;
+    pRun->server.lost = node.telemetry.lost - start.telemetry.lost;
+    pRun->server.late = node.telemetry.late - start.telemetry.late;
+    pRun->server.duplicates = node.telemetry.duplicates - start.telemetry.duplicates;
+    pRun->server.restarts = node.telemetry.restarts - start.telemetry.restarts;
+    pRun->server.newest = node.telemetry.newest;
+
+    if((pRun->server.received != pRun->shim.forwarded) || (pRun->server.lost != pRun->shim.dropped) ||
+       (pRun->server.late != pRun->shim.late) || (pRun->server.duplicates != pRun->shim.duplicated) ||
+       (pRun->server.restarts != 0) || (pRun->server.newest != (nextSeq - 1)) ||
+       (pRun->stored != (pRun->sent - pRun->shim.dropped - pRun->shim.late)) ||
+       (node.telemetryHz != pRun->rateHz) || pRun->backwards) {
+        printf("FAIL: %u Hz, server %u rx %u lost %u late %u dup %u restarts, shim %u fwd %u dropped "
+               "%u late %u dup, %u of %u stored%s\n", pRun->rateHz, pRun->server.received,
+               pRun->server.lost, pRun->server.late, pRun->server.duplicates, pRun->server.restarts,
+               pRun->shim.forwarded, pRun->shim.dropped, pRun->shim.late, pRun->shim.duplicated,
+               pRun->stored, pRun->sent, pRun->backwards ? ", data went backwards" : "");
+        return 1;
+    }
+    printf("PASS: %u Hz through a lossy link\n", pRun->rateHz);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief remote server thread and the queues it opens by name, as main
+ * starts it; sender and shim sockets
+ */
+static int8_t startServer(void)
+{
+    uint16_t shimPort;
+
+    if((bench_server_open(&server, "test_telemetry", 0) != EXIT_SUCCESS) ||
+       (bench_server_start(&server, remoteServerThreadHandler, remoteServerSigHandler) != EXIT_SUCCESS))
+        return EXIT_FAILURE;
+
+    memset(&telemetryAddr, 0, sizeof(struct sockaddr_in));
+    telemetryAddr.sin_family = AF_INET;
+    telemetryAddr.sin_port = htons(TELEMETRY_PORT);
+    telemetryAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    /* the sender's datagrams go to the shim */
+    shimFd = openShim(&shimPort);
+    return (shimFd >= 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void stopServer(void)
+{
+    if(senderFd >= 0)
+        close(senderFd);
+    if(shimFd >= 0)
+        close(shimFd);
+    bench_server_close(&server);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief hello on CMD_PORT, as the node's TCP link does; telemetry is only
+ * taken from nodes in the table
+ */
+static int connectHello(void)
+{
+    RemoteNode_t node;
+    uint64_t start;
+    int fd;
+
+    fd = bench_connect(CMD_PORT, TEST_NODE_ID);
+    if(fd < 0)
+        return -1;
+    start = usecNow();
+    while((usecNow() - start) < CONNECT_TIMEOUT_USEC)
+    {
+        if(node_table_get(TEST_NODE_ID, &node) == EXIT_SUCCESS)
+            return fd;
+        usleep(10000);
+    }
+    close(fd);
+    return -1;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief shim's socket on an ephemeral loopback port, and the sender's
+ * socket connected to it
+ */
+static int openShim(uint16_t *pPort)
+{
+    struct timeval timeout = {0, 100000};
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd;
+
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0)
+        return -1;
+    if((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) ||
+       (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) ||
+       (getsockname(fd, (struct sockaddr *)&addr, &len) != 0)) {
+        close(fd);
+        return -1;
+    }
+    *pPort = ntohs(addr.sin_port);
+    senderFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if((senderFd < 0) || (connect(senderFd, (struct sockaddr *)&addr, sizeof(addr)) != 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief a datagram as the TIVA sends it; the lux is where its send time
+ * is kept
+ */
+static void sendTelemetry(int fd, uint16_t rateHz, uint32_t seq)
+{
+    Datagram_t dgram;
+
+    memset(&dgram, 0, sizeof(Datagram_t));
+    dgram.packet.nodeId = TEST_NODE_ID;
+    dgram.packet.rateHz = rateHz;
+    dgram.packet.seq = seq;
+    dgram.packet.timestamp = (uint32_t)(usecNow() / 1000);
+    dgram.packet.data.luxData = (float)(seq % SEQ_RING);
+    dgram.packet.data.moistureData = 50.0f;
+    frame_header(&dgram.hdr, FRAME_TYPE_TELEMETRY, &dgram.packet, sizeof(RemoteTelemetryPacket));
+    sendUsec[seq % SEQ_RING] = usecNow();
+    send(fd, &dgram, sizeof(Datagram_t), 0);
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief datagrams at the run's rate on an absolute schedule, as the
+ * TIVA's vTaskDelayUntil() does
+ */
+static void *senderThread(void *arg)
+{
+    Run_t *pRun = (Run_t *)arg;
+    uint64_t periodNsec = 1000000000ULL / pRun->rateHz;
+    struct timespec next;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while(running)
+    {
+        next.tv_nsec += (long)periodNsec;
+        while(next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            ++next.tv_sec;
+        }
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+        sendTelemetry(senderFd, pRun->rateHz, nextSeq++);
+        ++pRun->sent;
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief forward to TELEMETRY_PORT, damaging the link while lossy; until
+ * shut down
+ */
+static void *shimThread(void *arg)
+{
+    Datagram_t dgram, held;
+    uint8_t holding = 0;
+    int pct;
+
+    (void)arg;
+    while(shimRunning)
+    {
+        /* times out to see shimRunning */
+        if(recv(shimFd, &dgram, sizeof(Datagram_t), 0) != (ssize_t)sizeof(Datagram_t))
+            continue;
+
+        if(!lossy) {
+            /* anything held goes first, so isn't late */
+            if(holding)
+                forward(&held);
+            holding = 0;
+            forward(&dgram);
+            continue;
+        }
+
+        pct = rand() % 100;
+        if(pct < SHIM_DROP_PCT) {
+            ++shimCounts.dropped;
+            continue;
+        }
+        if(!holding && (pct < (SHIM_DROP_PCT + SHIM_HOLD_PCT))) {
+            held = dgram;
+            holding = 1;
+            continue;
+        }
+        forward(&dgram);
+        if(pct >= (100 - SHIM_DUP_PCT)) {
+            forward(&dgram);
+            ++shimCounts.duplicated;
+        }
+        if(holding) {
+            forward(&held);
+            ++shimCounts.late;
+            holding = 0;
+        }
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void forward(const Datagram_t *pDgram)
+{
+    sendto(shimFd, pDgram, sizeof(Datagram_t), 0, (struct sockaddr *)&telemetryAddr, sizeof(telemetryAddr));
+    ++shimCounts.forwarded;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint64_t usecNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000ULL) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void printRun(const Run_t *pRun)
+{
+    printf("  %4u %8.1f %8.1f | %5u %5u %5u | %7u %7u %7u\n", pRun->rateHz,
+           (double)pRun->sent / pRun->seconds, (double)pRun->stored / pRun->seconds,
+           pRun->server.lost, pRun->server.late, pRun->server.duplicates,
+           hist_percentile(&pRun->latency, 50.0), hist_percentile(&pRun->latency, 99.0),
+           pRun->latency.max);
+}
+
+/*---------------------------------------------------------------------------------*/
@@ -0,0 +1,356 @@
+/***********************************************************************************
+ * @author Josh Malburg
+ * joshua.malburg@colorado.edu
+ * Advanced Embedded Software Development
+ * ECEN5013 - Rick Heidebrecht
+ * @date May 11, 2019
+ * arm-linux-gnueabi (Buildroot)
+ * gcc (Ubuntu)
+ ************************************************************************************
+ *
+ * @file test_watchdog.c
+ * @brief watchdog feeding and stall reports against a simulated device
+ *
+ * The device is a plain file, each feed appends a 'k' to it. A fake main
+ * thread checks in and a beater thread publishes PID_REMOTE_DATA heartbeats;
+ * either can be made to hang in a known function to see feeding stop and the
+ * report name it. On a dev box the same runs against softdog:
+ *   modprobe softdog soft_noboot=1 && ./test_watchdog /dev/watchdog
+ *
+ ************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "my_debug.h"
+#include "watchdog.h"
+#include "heartbeat.h"
+#include "logger_helper.h"
+
+#define TEST_HEARTBEAT_NAME     "/test_watchdog_shm"
+#define TEST_FEED_USEC          (50000)
+#define TEST_STALL_USEC         (200000)
+#define TEST_BEAT_USEC          (20000)
+#define TEST_SETTLE_USEC        (2 * (TEST_STALL_USEC + TEST_FEED_USEC))
+#define TEST_FUNC_SIZE          (0x100)     /* hang functions are smaller than this */
+
+static char devicePath[] = "/tmp/test_watchdog_dev.XXXXXX";
+static char reportPath[] = "/tmp/test_watchdog_report.XXXXXX";
+static const char *pDevice = devicePath;
+static uint8_t simulated = 1;
+
+static Watchdog_t dog;
+static volatile uint8_t running = 1;
+static volatile uint8_t mainHang = 0;
+static volatile uint8_t beatHang = 0;
+
+extern char __executable_start;
+
+/* test cases */
+uint8_t testCount = 0;
+int8_t test_feeding(void);
+int8_t test_mainStall(void);
+int8_t test_threadStall(void);
+int8_t test_stop(pthread_t dogThread);
+
+static void *fakeMainThread(void *pArg);
+static void *beaterThread(void *pArg);
+static void mainHangHere(void);
+static void beatHangHere(void);
+static off_t deviceSize(void);
+static uint32_t readReport(char *pBuf, uint32_t size);
+static uint8_t traceHits(const char *pReport, const char *pName, void (*pFunc)(void));
+
+/*---------------------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    pthread_t dogThread, mainThread, beater;
+    uint8_t testFails = 0;
+    int fd;
+
+    if(argc > 1) {
+        pDevice = argv[1];
+        simulated = 0;
+    }
+    else if((fd = mkstemp(devicePath)) >= 0) {
+        close(fd);
+    }
+    if(((fd = mkstemp(reportPath)) < 0) || (heartbeat_init(TEST_HEARTBEAT_NAME) != EXIT_SUCCESS)) {
+        ERRNO_PRINT("couldn't create test files");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    heartbeat_publish(PID_REMOTE_DATA, STATUS_OK, ERROR_CODE_USER_NONE0);
+    if(watchdog_init(&dog, pDevice, reportPath, (1UL << PID_REMOTE_DATA), TEST_STALL_USEC, NULL) != EXIT_SUCCESS) {
+        ERROR_PRINT("watchdog_init failed\n");
+        return EXIT_FAILURE;
+    }
+    dog.feedUsec = TEST_FEED_USEC;
+    printf("test cases for watchdog, device %s\n", pDevice);
+
+    pthread_create(&mainThread, NULL, fakeMainThread, NULL);
+    pthread_create(&beater, NULL, beaterThread, NULL);
+    usleep(TEST_BEAT_USEC);
+    pthread_create(&dogThread, NULL, watchdogThreadHandler, &dog);
+
+    testFails += test_feeding();
+    testFails += test_mainStall();
+    testFails += test_threadStall();
+    testFails += test_stop(dogThread);
+
+    running = 0;
+    mainHang = 0;
+    beatHang = 0;
+    pthread_join(mainThread, NULL);
+    pthread_join(beater, NULL);
+
+    printf("\n\nTEST RESULTS, %d of %d failed tests\n", testFails, testCount);
+    heartbeat_destroy(TEST_HEARTBEAT_NAME);
+    if(simulated)
+        unlink(devicePath);
+    unlink(reportPath);
+    return (testFails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief fed every period while main and the required thread are fresh
+ *
+ * @return int8_t test results
+ */
+int8_t test_feeding(void)
+{
+    uint32_t feeds = dog.feeds;
+    off_t size = deviceSize();
+
+    testCount++;
+    usleep(TEST_SETTLE_USEC);
+    if((dog.stalls != 0) || (watchdog_check(&dog) != 0)) {
+        printf("FAIL: healthy system reported stalled\n");
+        return 1;
+    }
+    if((dog.feeds - feeds) < (TEST_SETTLE_USEC / TEST_FEED_USEC) / 2) {
+        printf("FAIL: only %u feeds in %u usec\n", dog.feeds - feeds, TEST_SETTLE_USEC);
+        return 1;
+    }
+    if(simulated && (deviceSize() <= size)) {
+        printf("FAIL: feeds not written to device\n");
+        return 1;
+    }
+    printf("PASS: %u feeds while healthy\n", dog.feeds - feeds);
+    return 0;
+}
+
+/**
+ * @brief main hanging stops feeding, the report backtraces main to where it
+ * hung, and feeding resumes once main checks in again
+ *
+ * @return int8_t test results
+ */
+int8_t test_mainStall(void)
+{
+    char text[WATCHDOG_FORENSICS_SIZE];
+    uint32_t feeds;
+
+    testCount++;
+    mainHang = 1;
+    usleep(TEST_SETTLE_USEC);
+    feeds = dog.feeds;
+    usleep(TEST_SETTLE_USEC);
+    if((dog.feeds != feeds) || (dog.stalls != 1) || !(dog.stalled & WATCHDOG_MAIN_STALLED)) {
+        printf("FAIL: main stall, %u feeds since stall, %u reports\n", dog.feeds - feeds, dog.stalls);
+        mainHang = 0;
+        return 1;
+    }
+    readReport(text, sizeof(text));
+    if((strstr(text, "STALLED") == NULL) || !traceHits(text, "main", mainHangHere)) {
+        printf("FAIL: main stall report:\n%s\n", text);
+        mainHang = 0;
+        return 1;
+    }
+
+    mainHang = 0;
+    usleep(TEST_SETTLE_USEC);
+    if((dog.stalled != 0) || (dog.feeds == feeds)) {
+        printf("FAIL: feeding didn't resume after main recovered\n");
+        return 1;
+    }
+    printf("PASS: main stall reported with backtrace, feeding resumed\n");
+    return 0;
+}
+
+/**
+ * @brief a required thread going quiet stops feeding; its backtrace and
+ * last logged line are in the report
+ *
+ * @return int8_t test results
+ */
+int8_t test_threadStall(void)
+{
+    char text[WATCHDOG_FORENSICS_SIZE];
+    uint32_t feeds;
+
+    testCount++;
+    beatHang = 1;
+    usleep(TEST_SETTLE_USEC);
+    feeds = dog.feeds;
+    usleep(TEST_SETTLE_USEC);
+    if((dog.feeds != feeds) || (dog.stalls != 2) || (dog.stalled != (1UL << PID_REMOTE_DATA))) {
+        printf("FAIL: thread stall, %u feeds since stall, %u reports, stalled 0x%x\n",
+               dog.feeds - feeds, dog.stalls, dog.stalled);
+        beatHang = 0;
+        return 1;
+    }
+    readReport(text, sizeof(text));
+    beatHang = 0;
+    if((strstr(text, "stalled threads: PID_REMOTE_DATA\n") == NULL) ||
+       (strstr(text, "(PID_REMOTE_DATA)") == NULL) || !traceHits(text, "PID_REMOTE_DATA", beatHangHere)) {
+        printf("FAIL: thread stall report:\n%s\n", text);
+        return 1;
+    }
+    usleep(TEST_SETTLE_USEC);
+    printf("PASS: thread stall reported with backtrace and last log line\n");
+    return 0;
+}
+
+/**
+ * @brief a clean stop disarms the device with the magic close
+ *
+ * @return int8_t test results
+ */
+int8_t test_stop(pthread_t dogThread)
+{
+    char last = 0;
+    int fd;
+
+    testCount++;
+    watchdog_stop(&dog);
+    pthread_join(dogThread, NULL);
+    if(!simulated) {
+        printf("PASS: stopped, device disarmed\n");
+        return 0;
+    }
+    fd = open(devicePath, O_RDONLY);
+    if((fd < 0) || (pread(fd, &last, 1, deviceSize() - 1) != 1) || (last != 'V')) {
+        printf("FAIL: device not disarmed, last byte %c\n", last);
+        if(fd >= 0)
+            close(fd);
+        return 1;
+    }
+    close(fd);
+    printf("PASS: stop wrote magic close\n");
+    return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void *fakeMainThread(void *pArg)
+{
+    while(running)
+    {
+        if(mainHang)
+            mainHangHere();
+        watchdog_checkin();
+        usleep(TEST_BEAT_USEC);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void *beaterThread(void *pArg)
+{
+    logItem_t item;
+
+    memset(&item, 0, sizeof(logItem_t));
+    item.sourceId = (uint16_t)syscall(SYS_gettid);
+    item.fileId = LOG_FILE_BBG_MAIN;
+    while(running)
+    {
+        if(beatHang) {
+            item.lineNum = __LINE__;
+            item.time = log_get_time();
+            log_note_item(&item);
+            beatHangHere();
+        }
+        heartbeat_publish(PID_REMOTE_DATA, STATUS_OK, ERROR_CODE_USER_NONE0);
+        usleep(TEST_BEAT_USEC);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void __attribute__((noinline)) mainHangHere(void)
+{
+    while(mainHang)
+        usleep(TEST_BEAT_USEC);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void __attribute__((noinline)) beatHangHere(void)
+{
+    while(beatHang)
+        usleep(TEST_BEAT_USEC);
+}
+
+/*---------------------------------------------------------------------------------*/
+static off_t deviceSize(void)
+{
+    struct stat info;
+
+    return (stat(devicePath, &info) == 0) ? info.st_size : 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+static uint32_t readReport(char *pBuf, uint32_t size)
+{
+    ssize_t len = 0;
+    int fd = open(reportPath, O_RDONLY);
+
+    if(fd >= 0) {
+        len = read(fd, pBuf, size - 1);
+        close(fd);
+    }
+    pBuf[(len > 0) ? len : 0] = '\0';
+    return (len > 0) ? (uint32_t)len : 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+/**
+ * @brief nonzero if pName's backtrace in the report has a frame inside pFunc;
+ * without backtrace() (uClibc) having any frames is enough
+ */
+static uint8_t traceHits(const char *pReport, const char *pName, void (*pFunc)(void))
+{
+    char header[64];
+    const char *pLine, *pNext;
+    unsigned long offset, start = (unsigned long)((uintptr_t)pFunc - (uintptr_t)&__executable_start);
+    uint8_t frames = 0;
+
+    snprintf(header, sizeof(header), "\n  %s (tid", pName);
+    pLine = strstr(pReport, header);
+    if(pLine == NULL)
+        return 0;
+    pLine = strchr(pLine + 1, '\n');
+    while((pLine != NULL) && (strncmp(pLine, "\n    #", 6) == 0))
+    {
+        ++frames;
+        pNext = strchr(pLine + 1, '\n');
+        pLine = strstr(pLine, "exe+0x");
+        if((pLine != NULL) && ((pNext == NULL) || (pLine < pNext)) &&
+           (sscanf(pLine, "exe+0x%lx", &offset) == 1) && (offset >= start) && (offset < start + TEST_FUNC_SIZE))
+            return 1;
+        pLine = pNext;
+    }
+#if defined(__GLIBC__) && !defined(__UCLIBC__)
+    return 0;
+#else
+    return (frames != 0);
+#endif
+}
@@ -35,6 +35,8 @@
 #include "task.h"
 #include "semphr.h"
 
+LOG_REGISTER_FILE(LOG_FILE_TIVA_LIGHT_THREAD);
+
 
 
 /*---------------------------------------------------------------------------------*/
@@ -57,6 +57,8 @@
 #include "queue.h"
 #include "semphr.h"
 
+LOG_REGISTER_FILE(LOG_FILE_TIVA_MAIN);
+
 /*---------------------------------------------------------------------------------*/
 #define STATUS_QUEUE_LENGTH         (8)
 #define LOG_QUEUE_LENGTH            (8)
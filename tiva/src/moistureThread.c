@@ -42,6 +42,8 @@
 #include "task.h"
 #include "semphr.h"
 
+LOG_REGISTER_FILE(LOG_FILE_TIVA_MOISTURE_THREAD);
+
 /*---------------------------------------------------------------------------------*/
 #define SOIL_SAMPLE_COUNT   (10)
 #define SOIL_ADC_SCALE      (100.0f / 4096.0f)
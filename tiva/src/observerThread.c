@@ -46,6 +46,8 @@
 #include "task.h"
 #include "semphr.h"
 
+LOG_REGISTER_FILE(LOG_FILE_TIVA_OBSERVER_THREAD);
+
 /*---------------------------------------------------------------------------------*/
 #define ALARM_GPIO_PIN                  (GPIO_PIN_0)
 
@@ -29,6 +29,8 @@
 #include "packet.h"
 #include "my_debug.h"
 #include "healthMonitor.h"
+#include "statusSummary.h"
+#include "remoteFrame.h"
 #include "logger.h"
 #include "main.h"
 
@@ -47,7 +49,10 @@
 #include "task.h"
 #include "semphr.h"
 
+LOG_REGISTER_FILE(LOG_FILE_TIVA_REMOTE_THREAD);
+
 #define DIAGNOISTIC_PRINTS  (0)
+#define REMOTE_NODE_ID      (202)   /* names this node to the Control Node; last octet of ucIPAddress */
 
 /*---------------------------------------------------------------------------------*/
 static uint8_t keepAlive;
@@ -55,22 +60,49 @@ static TaskHandle_t remoteStatusTaskHandle = NULL;
 static TaskHandle_t remoteLogTaskHandle = NULL;
 static TaskHandle_t remoteCmdTaskHandle = NULL;
 static TaskHandle_t remoteDataTaskHandle = NULL;
+static TaskHandle_t remoteMuxTaskHandle = NULL;
+static TaskHandle_t remoteTelemetryTaskHandle = NULL;
+
+/* set by REMOTE_SET_TELEMETRY_HZ, read by remoteTelemetryTask */
+static volatile uint16_t telemetryHz = REMOTE_TELEMETRY_HZ;
 
 uint8_t g_dataSocketLost = 1;
 uint8_t g_logSocketLost = 1;
 uint8_t g_statusSocketLost = 1;
 uint8_t g_cmdSocketLost = 1;
 
+/* remoteStatusTask only; too big for its stack */
+static StatusCoalescer_t statusCoalescer;
+static StatusSummaryPacket summaryPacket;
+static FrameBatch_t statusBatch;
+
+/* remoteLogTask only; too big for its stack */
+static FrameBatch_t logBatch;
+
+/* remoteCmdTask, or remoteMuxTask; too big for its stack */
+static FrameReader_t cmdReader;
+static uint32_t cmdReaderBuf[FRAME_READER_SIZE / sizeof(uint32_t)];
+
+/* remoteMuxTask only; too big for its stack */
+static FrameBatch_t muxBatch;
+
 /*---------------------------------------------------------------------------------*/
 BaseType_t InitIPStack(void);
-BaseType_t sendSocketData(Socket_t *pSocket, uint8_t *pData, size_t length);
-BaseType_t readSocketData(Socket_t *pSocket, uint8_t *pData, size_t length);
+BaseType_t sendSocketData(Socket_t *pSocket, FrameType_e type, void *pData, size_t length);
+BaseType_t batchSocketData(Socket_t *pSocket, FrameBatch_t *pBatch, FrameType_e type, void *pData, size_t length);
+BaseType_t sendSocketBatch(Socket_t *pSocket, FrameBatch_t *pBatch);
+static BaseType_t sendResult(BaseType_t ret, size_t length);
+BaseType_t readSocketData(Socket_t *pSocket, FrameReader_t *pReader, BaseType_t xFlags);
+BaseType_t sendHello(Socket_t *pSocket);
 void printConnectionStatus(BaseType_t ret);
+static void processCmd(SensorThreadInfo *pInfo, RemoteCmdPacket *pCmd);
 
 void remoteStatusTask(void *pvParameters);
 void remoteLogTask(void *pvParameters);
 void remoteCmdTask(void *pvParameters);
 void remoteDataTask(void *pvParameters);
+void remoteMuxTask(void *pvParameters);
+void remoteTelemetryTask(void *pvParameters);
 
 /*---------------------------------------------------------------------------------*/
 void remoteTask(void *pvParameters)
@@ -89,14 +121,28 @@ void remoteTask(void *pvParameters)
         /* create child threads */
         /*------------------------------------------------------------------------------------*/
 
+#if (REMOTE_TELEMETRY_UDP)
+        /* in place of sending data over TCP; above the others, a reading is
+         * worth most when it's sent on time */
+        xTaskCreate(remoteTelemetryTask, (const portCHAR *)"RemoteTelemetry", configMINIMAL_STACK_SIZE, pvParameters, 2, &remoteTelemetryTaskHandle);
+        setTaskNum(remoteTelemetryTaskHandle, PID_REMOTE_CLIENT_DATA);
+#endif
+#if (REMOTE_LINK_MUX)
+        /* has every other task's locals on its stack */
+        xTaskCreate(remoteMuxTask, (const portCHAR *)"RemoteMux", (configMINIMAL_STACK_SIZE * 3) / 2, pvParameters, 1, &remoteMuxTaskHandle);
+        setTaskNum(remoteMuxTaskHandle, PID_REMOTE_CLIENT_DATA);
+#else
         xTaskCreate(remoteStatusTask, (const portCHAR *)"RemoteStatus", configMINIMAL_STACK_SIZE, pvParameters, 1, &remoteStatusTaskHandle);
         setTaskNum(remoteStatusTaskHandle, PID_REMOTE_CLIENT_STATUS);
         xTaskCreate(remoteLogTask, (const portCHAR *)"RemoteLog", configMINIMAL_STACK_SIZE, pvParameters, 1, &remoteLogTaskHandle);
         setTaskNum(remoteLogTaskHandle, PID_REMOTE_CLIENT_LOG);
         xTaskCreate(remoteCmdTask, (const portCHAR *)"RemoteCmd", configMINIMAL_STACK_SIZE, pvParameters, 1, &remoteCmdTaskHandle);
         setTaskNum(remoteCmdTaskHandle, PID_REMOTE_CLIENT_CMD);
+#if !(REMOTE_TELEMETRY_UDP)
         xTaskCreate(remoteDataTask, (const portCHAR *)"RemoteData", configMINIMAL_STACK_SIZE, pvParameters, 1, &remoteDataTaskHandle);
         setTaskNum(remoteDataTaskHandle, PID_REMOTE_CLIENT_DATA);
+#endif
+#endif
     }
     LOG_REMOTE_CLIENT_EVENT(REMOTE_EVENT_EXITING);
     INFO_PRINT("remoteTask Exiting\n");
@@ -119,12 +165,19 @@ void remoteStatusTask(void *pvParameters)
     BaseType_t ret;
     SensorThreadInfo info = *((SensorThreadInfo *)pvParameters);
     Socket_t xClientSocket;
+    const TickType_t xSummaryPeriod = pdMS_TO_TICKS(STATUS_SUMMARY_PERIOD_MS);
+    TickType_t lastSummary, lastRecv, now, wait;
+    uint32_t summaryLen;
 
     LOG_REMOTE_CLIENT_EVENT(REMOTE_EVENT_STARTED);
     INFO_PRINT("THREAD CREATED, remoteStatusTask #: %d\n\r", getTaskNum());
 
     /*clear struct */
     memset(&statusMsg, 0,sizeof(TaskStatusPacket));
+    status_summary_init(&statusCoalescer);
+    frame_batch_init(&statusBatch);
+    lastSummary = xTaskGetTickCount();
+    lastRecv = lastSummary;
 
     /* Set destination */
     xServerAddress.sin_addr = FreeRTOS_inet_addr(SERVER_IP_ADDRESS_STR);
@@ -172,25 +225,51 @@ void remoteStatusTask(void *pvParameters)
                         INFO_PRINT("remoteStatusTask ");
                         printConnectionStatus(ret);
                     } while(ret != 0);
-                    g_statusSocketLost = 0;
+                    g_statusSocketLost = (sendHello(&xClientSocket) == pdFREERTOS_ERRNO_ENOTCONN);
                 }
                 /*--------------------------------------------------------------------------*/
                 /* Connected State */
                 /*--------------------------------------------------------------------------*/
                 else {
-                    /* get thread status msgs */
-                    if(xQueueReceive(info.statusFd, (void *)&statusMsg, xDelay) != pdFALSE) {
-                        /* send status msgs to Control Node */
-                        if(sendSocketData(&xClientSocket, (uint8_t *)&statusMsg, sizeof(TaskStatusPacket)) == pdFREERTOS_ERRNO_ENOTCONN) {
+                    /* wait no longer than the next summary is due */
+                    now = xTaskGetTickCount();
+                    wait = ((now - lastSummary) < xSummaryPeriod) ? (xSummaryPeriod - (now - lastSummary)) : 0;
+
+                    /* get thread status msgs; STATUS_OK is merged into the
+                     * task's summary, anything else is sent right away,
+                     * batched with whatever else is already queued */
+                    if(xQueueReceive(info.statusFd, (void *)&statusMsg, wait) != pdFALSE) {
+                        lastRecv = xTaskGetTickCount();
+                        do {
+                            if(status_summary_add(&statusCoalescer, &statusMsg)) {
+                                if(batchSocketData(&xClientSocket, &statusBatch, FRAME_TYPE_STATUS, &statusMsg, sizeof(TaskStatusPacket)) == pdFREERTOS_ERRNO_ENOTCONN) {
+                                    g_statusSocketLost = 1;
+                                }
+                                /* for diagnostics */
+                                if(DIAGNOISTIC_PRINTS) {PRINT_STATUS_MSG_HEADER(&statusMsg);}
+                            }
+                        } while(xQueueReceive(info.statusFd, (void *)&statusMsg, 0) != pdFALSE);
+                    }
+                    else if((xTaskGetTickCount() - lastRecv) >= xDelay) {
+                        LOG_REMOTE_CLIENT_EVENT(REMOTE_STATUS_QUEUE_ERROR);
+                        lastRecv = xTaskGetTickCount();
+                    }
+
+                    /* send every task's heartbeats for the period as one packet */
+                    now = xTaskGetTickCount();
+                    if(((now - lastSummary) >= xSummaryPeriod) && !g_statusSocketLost) {
+                        lastSummary = now;
+                        summaryLen = status_summary_flush(&statusCoalescer, &summaryPacket);
+                        if((summaryLen != 0) &&
+                           (batchSocketData(&xClientSocket, &statusBatch, FRAME_TYPE_STATUS_SUMMARY, &summaryPacket, summaryLen) == pdFREERTOS_ERRNO_ENOTCONN)) {
                             g_statusSocketLost = 1;
                         }
-                        else {
-                            /* for diagnostics */
-                            if(DIAGNOISTIC_PRINTS) {PRINT_STATUS_MSG_HEADER(&statusMsg);}
-                        }
                     }
-                    else {
-                        LOG_REMOTE_CLIENT_EVENT(REMOTE_STATUS_QUEUE_ERROR);
+
+                    /* nothing waits for a deadline here, send what was batched */
+                    if((statusBatch.records != 0) && !g_statusSocketLost &&
+                       (sendSocketBatch(&xClientSocket, &statusBatch) == pdFREERTOS_ERRNO_ENOTCONN)) {
+                        g_statusSocketLost = 1;
                     }
                 }
             }
@@ -223,12 +302,15 @@ void remoteLogTask(void *pvParameters)
     BaseType_t ret;
     SensorThreadInfo info = *((SensorThreadInfo *)pvParameters);
     Socket_t xClientSocket;
+    const TickType_t xBatchDeadline = pdMS_TO_TICKS(REMOTE_BATCH_DEADLINE_MS);
+    TickType_t batchStart = 0, now, wait;
 
     LOG_REMOTE_CLIENT_EVENT(REMOTE_EVENT_STARTED);
     INFO_PRINT("THREAD CREATED, remoteLogTask #: %d\n\r", getTaskNum());
 
     /* clear structure */
     memset(&logMsg, 0,sizeof(LogMsgPacket));
+    frame_batch_init(&logBatch);
 
     /* Set destination */
     xServerAddress.sin_addr = FreeRTOS_inet_addr(SERVER_IP_ADDRESS_STR);
@@ -276,27 +358,50 @@ void remoteLogTask(void *pvParameters)
                         INFO_PRINT("remoteLogTask ");
                         printConnectionStatus(ret);
                     } while(ret != 0);
-                    g_logSocketLost = 0;
+                    g_logSocketLost = (sendHello(&xClientSocket) == pdFREERTOS_ERRNO_ENOTCONN);
                 }
                 /*--------------------------------------------------------------------------*/
                 /* Connected State */
                 /*--------------------------------------------------------------------------*/
                 else {
-                    /* get log msgs */
-                    if(xQueueReceive(info.logFd, (void *)&logMsg, xDelay) != pdFALSE)
+                    /* get log msgs; the first of a batch waits as long as
+                     * ever, the rest no longer than its deadline */
+                    now = xTaskGetTickCount();
+                    if(logBatch.records == 0) {
+                        wait = xDelay;
+                    }
+                    else {
+                        wait = ((now - batchStart) < xBatchDeadline) ? (xBatchDeadline - (now - batchStart)) : 0;
+                    }
+                    if(xQueueReceive(info.logFd, (void *)&logMsg, wait) != pdFALSE)
                     {
+                        /* checked by the Control Node when received */
+                        logMsg.checksum = log_packet_checksum(&logMsg);
+
                         /* Transmit data to Control Node */
-                        if(sendSocketData(&xClientSocket, (uint8_t *)&logMsg, sizeof(LogMsgPacket)) == pdFREERTOS_ERRNO_ENOTCONN) {
+                        if(batchSocketData(&xClientSocket, &logBatch, FRAME_TYPE_LOG, &logMsg, sizeof(LogMsgPacket)) == pdFREERTOS_ERRNO_ENOTCONN) {
                             g_logSocketLost = 1;
                         }
+                        if(logBatch.records == 1) {
+                            batchStart = xTaskGetTickCount();
+                        }
                         /* for diagnostics */
                         if(DIAGNOISTIC_PRINTS) {
                             PRINT_LOG_MSG_HEADER(&logMsg);
                         }
                     }
-                    else {
+                    else if(logBatch.records == 0) {
                         LOG_REMOTE_CLIENT_EVENT(REMOTE_LOG_QUEUE_ERROR);
                     }
+
+                    /* send once no other msg fits, or the first has waited long enough */
+                    if((logBatch.records != 0) && !g_logSocketLost &&
+                       ((frame_batch_free(&logBatch) < FRAME_RECORD_SIZE(sizeof(LogMsgPacket))) ||
+                        ((xTaskGetTickCount() - batchStart) >= xBatchDeadline))) {
+                        if(sendSocketBatch(&xClientSocket, &logBatch) == pdFREERTOS_ERRNO_ENOTCONN) {
+                            g_logSocketLost = 1;
+                        }
+                    }
                 }
             }
         }
@@ -380,7 +485,7 @@ void remoteDataTask(void *pvParameters)
                         INFO_PRINT("remoteDataTask ");
                         printConnectionStatus(ret);
                     } while(ret != 0);
-                    g_dataSocketLost = 0;
+                    g_dataSocketLost = (sendHello(&xClientSocket) == pdFREERTOS_ERRNO_ENOTCONN);
                 }
                 /*--------------------------------------------------------------------------*/
                 /* Connected State */
@@ -399,7 +504,7 @@ void remoteDataTask(void *pvParameters)
                         xSemaphoreGive(info.shmemMutex);
 
                         /* Transmit data to Control Node */
-                        if(sendSocketData(&xClientSocket, (uint8_t *)&sensorData, sizeof(sensorData)) == pdFREERTOS_ERRNO_ENOTCONN) {
+                        if(sendSocketData(&xClientSocket, FRAME_TYPE_DATA, &sensorData, sizeof(sensorData)) == pdFREERTOS_ERRNO_ENOTCONN) {
                             g_dataSocketLost = 1;
                         }
                         /* for diagnostics */
@@ -432,6 +537,8 @@ void remoteCmdTask(void *pvParameters)
     uint8_t count = 0;
     RemoteDataPacket sensorData;
     RemoteCmdPacket cmdMsg;
+    FrameHeader_t frameHdr;
+    uint8_t *pPayload;
     keepAlive = 1;
     static const TickType_t xTimeOut = pdMS_TO_TICKS(5000);
     struct freertos_sockaddr xServerAddress;
@@ -492,57 +599,25 @@ void remoteCmdTask(void *pvParameters)
                         INFO_PRINT("remoteCmdTask ");
                         printConnectionStatus(ret);
                     } while(ret != 0);
-                    g_cmdSocketLost = 0;
+                    g_cmdSocketLost = (sendHello(&xClientSocket) == pdFREERTOS_ERRNO_ENOTCONN);
+                    frame_reader_init(&cmdReader, (uint8_t *)cmdReaderBuf);
                 }
                 /*--------------------------------------------------------------------------*/
                 /* Connected State */
                 /*--------------------------------------------------------------------------*/
                 else {
-                    ret = readSocketData(&xClientSocket, (uint8_t *)&cmdMsg, sizeof(RemoteCmdPacket));
+                    ret = readSocketData(&xClientSocket, &cmdReader, 0);
                     if(ret == pdFREERTOS_ERRNO_ENOTCONN) {
                         g_cmdSocketLost = 1;
                     }
-                    else if(ret == sizeof(RemoteCmdPacket))
-                    {
-                        /* process cmdMsg */
-                        if((cmdMsg.cmd ==  REMOTE_WATERPLANT) ||
-                                (cmdMsg.cmd == REMOTE_SETMOISTURE_LOWTHRES) ||
-                                (cmdMsg.cmd == REMOTE_SETMOISTURE_HIGHTHRES))
+                    else {
+                        /* every whole cmd received so far, wherever TCP split them */
+                        while(frame_reader_next(&cmdReader, &frameHdr, &pPayload))
                         {
-                            /* try to read sensor data from shmem */
-                            if(xSemaphoreTake(info.shmemMutex, THREAD_MUTEX_DELAY) == pdTRUE)
-                            {
-                                /* write data to shmem */
-                                if(info.pShmem != NULL) {
-                                    switch (cmdMsg.cmd)
-                                    {
-                                    case REMOTE_WATERPLANT:
-                                        info.pShmem->solenoidData.cmd = (cmdMsg.cmd == REMOTE_WATERPLANT);
-                                        break;
-                                    case REMOTE_SETMOISTURE_LOWTHRES:
-                                        info.pShmem->moistData.lowThreshold = cmdMsg.data;
-                                        break;
-                                    case REMOTE_SETMOISTURE_HIGHTHRES:
-                                        info.pShmem->moistData.highThreshold = cmdMsg.data;
-                                        break;
-                                    default:
-                                        break;
-                                    }
-                                }
-
-                                /* release mutex ASAP so others can use */
-                                xSemaphoreGive(info.shmemMutex);
-                            }
-                            else {
-                                LOG_REMOTE_CLIENT_EVENT(REMOTE_SHMEM_ERROR);
-                                ERROR_PRINT("remoteCmdTask, failed to write cmd to shmem\n");
-                                while(1){};
-                            }
-                        }
-
-                        /* for diagnostics */
-                        if(DIAGNOISTIC_PRINTS) {
-                            INFO_PRINT("Received cmd: %d from Control Node\n", cmdMsg.cmd);
+                            if((frameHdr.type != FRAME_TYPE_CMD) || (frameHdr.length != sizeof(RemoteCmdPacket)))
+                                continue;
+                            memcpy(&cmdMsg, pPayload, sizeof(RemoteCmdPacket));
+                            processCmd(&info, &cmdMsg);
                         }
                     }
                 }
@@ -600,18 +675,19 @@ BaseType_t InitIPStack(void)
 /*
  *
  */
-BaseType_t readSocketData(Socket_t *pSocket, uint8_t *pData, size_t length)
+BaseType_t readSocketData(Socket_t *pSocket, FrameReader_t *pReader, BaseType_t xFlags)
 {
     BaseType_t ret;
+    uint8_t *pRx;
+    uint32_t space;
     configASSERT(pSocket);
 
-    /* try to read data */
-    ret = FreeRTOS_recv(*pSocket, pData, length, 0);
+    /* read whatever has arrived, frame_reader_next() finds the frames */
+    pRx = frame_reader_space(pReader, &space);
+    ret = FreeRTOS_recv(*pSocket, pRx, space, xFlags);
 
-    if(ret == 0) {
-        return ret;
-    }
-    if(ret == length) {
+    if(ret >= 0) {
+        frame_reader_commit(pReader, (uint32_t)ret);
         return ret;
     }
 
@@ -636,18 +712,405 @@ BaseType_t readSocketData(Socket_t *pSocket, uint8_t *pData, size_t length)
     return ret;
 }
 
+/*---------------------------------------------------------------------------------*/
+/*
+ * In place of remoteDataTask, or the mux task's data, when
+ * REMOTE_TELEMETRY_UDP: sensor data in a UDP datagram to TELEMETRY_PORT
+ * every 1 / telemetryHz s, numbered so the Control Node can count what's
+ * lost or late. Nothing is resent; the next reading replaces a lost one.
+ * The Control Node only takes them once this node has said hello over TCP.
+ */
+void remoteTelemetryTask(void *pvParameters)
+{
+    struct {
+        FrameHeader_t hdr;
+        RemoteTelemetryPacket packet;
+    } dgram;
+    struct freertos_sockaddr xServerAddress;
+    socklen_t xSize = sizeof(struct freertos_sockaddr);
+    SensorThreadInfo info = *((SensorThreadInfo *)pvParameters);
+    Socket_t xClientSocket;
+    TickType_t lastWake;
+    uint16_t rateHz;
+    keepAlive = 1;
+
+    LOG_REMOTE_CLIENT_EVENT(REMOTE_EVENT_STARTED);
+    INFO_PRINT("THREAD CREATED, remoteTelemetryTask #: %d\n\r", getTaskNum());
+
+    /* clear structure */
+    memset(&dgram, 0, sizeof(dgram));
+    dgram.packet.nodeId = REMOTE_NODE_ID;
+
+    /* Set destination */
+    xServerAddress.sin_addr = FreeRTOS_inet_addr(SERVER_IP_ADDRESS_STR);
+    xServerAddress.sin_port = FreeRTOS_htons(TELEMETRY_PORT);
+
+    /* create UDP socket; bound to any port by the first send */
+    xClientSocket = FreeRTOS_socket(FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP);
+    if(xClientSocket == FREERTOS_INVALID_SOCKET) {
+        LOG_REMOTE_CLIENT_EVENT(REMOTE_BIST_COMPLETE);
+        LOG_REMOTE_CLIENT_EVENT(REMOTE_INIT_ERROR);
+        ERROR_PRINT("ERROR remoteTelemetryTask: Failed to create socket\n");
+        vTaskDelay(2000);
+    }
+    else {
+        LOG_REMOTE_CLIENT_EVENT(REMOTE_BIST_COMPLETE);
+        LOG_REMOTE_CLIENT_EVENT(REMOTE_INIT_SUCCESS);
+
+        lastWake = xTaskGetTickCount();
+        while(keepAlive)
+        {
+            /* on the period, not after the send; a rate change from the next */
+            rateHz = telemetryHz;
+            vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / rateHz));
+
+            /* try to read sensor data from shmem */
+            if(xSemaphoreTake(info.shmemMutex, THREAD_MUTEX_DELAY) == pdTRUE)
+            {
+                if(info.pShmem != NULL) {
+                    dgram.packet.data.luxData = info.pShmem->lightData.apds9301_luxData;
+                    dgram.packet.data.moistureData = info.pShmem->moistData.moistureLevel;
+                }
+
+                /* release mutex ASAP so others can use */
+                xSemaphoreGive(info.shmemMutex);
+            }
+            dgram.packet.rateHz = rateHz;
+            dgram.packet.timestamp = xTaskGetTickCount() * portTICK_PERIOD_MS;
+            frame_header(&dgram.hdr, FRAME_TYPE_TELEMETRY, &dgram.packet, sizeof(RemoteTelemetryPacket));
+
+            /* 0 if the IP task couldn't take it, e.g. server's MAC not known yet;
+             * numbered either way, so the Control Node counts it lost */
+            g_dataSocketLost = (FreeRTOS_sendto(xClientSocket, &dgram, sizeof(dgram), 0, &xServerAddress, xSize) == 0);
+
+            /* for diagnostics */
+            if(DIAGNOISTIC_PRINTS) {
+                INFO_PRINT("Telemetry %u, luxData: %d, moistureData: %d\n", dgram.packet.seq,
+                           (int16_t)dgram.packet.data.luxData, (int16_t)dgram.packet.data.moistureData);
+            }
+            ++dgram.packet.seq;
+        }
+
+        /* The socket is safe to close */
+        FreeRTOS_closesocket(xClientSocket);
+    }
+    LOG_REMOTE_CLIENT_EVENT(REMOTE_EVENT_EXITING);
+    INFO_PRINT("remoteTelemetryTask Exiting\n");
+    vTaskDelete(NULL);
+}
+
+/*---------------------------------------------------------------------------------*/
+/*
+ * In place of the other four tasks when REMOTE_LINK_MUX: one connection to
+ * MUX_PORT carrying log, status and data frames up and cmds down. Channels
+ * are served by priority: cmds first, the task waiting on them between
+ * turns; then status, sent right away; then data, once a second; logs
+ * last, batched, and only while the socket has room for them and an urgent
+ * frame besides, so a log flood never holds the task in FreeRTOS_send().
+ */
+void remoteMuxTask(void *pvParameters)
+{
+    uint8_t count = 0;
+    const TickType_t xDelay = LOG_QUEUE_RECV_WAIT_DELAY / portTICK_PERIOD_MS;
+    LogMsgPacket logMsg;
+    TaskStatusPacket statusMsg;
+    RemoteDataPacket sensorData;
+    RemoteCmdPacket cmdMsg;
+    FrameHeader_t frameHdr;
+    uint8_t *pPayload;
+    keepAlive = 1;
+    static const TickType_t xTimeOut = pdMS_TO_TICKS(5000);
+    static const TickType_t xPoll = pdMS_TO_TICKS(REMOTE_MUX_POLL_MS);
+    struct freertos_sockaddr xServerAddress;
+    socklen_t xSize = sizeof(struct freertos_sockaddr);
+    BaseType_t ret;
+    SensorThreadInfo info = *((SensorThreadInfo *)pvParameters);
+    Socket_t xClientSocket;
+    const TickType_t xSummaryPeriod = pdMS_TO_TICKS(STATUS_SUMMARY_PERIOD_MS);
+    const TickType_t xDataPeriod = pdMS_TO_TICKS(1000);
+    const TickType_t xBatchDeadline = pdMS_TO_TICKS(REMOTE_BATCH_DEADLINE_MS);
+    TickType_t lastSummary, lastData, lastLog, batchStart = 0, now;
+    uint32_t summaryLen;
+    uint8_t urgent;
+    BaseType_t recvFlags;
+
+    LOG_REMOTE_CLIENT_EVENT(REMOTE_EVENT_STARTED);
+    INFO_PRINT("THREAD CREATED, remoteMuxTask #: %d\n\r", getTaskNum());
+
+    /* clear structures */
+    memset(&logMsg, 0, sizeof(LogMsgPacket));
+    memset(&statusMsg, 0, sizeof(TaskStatusPacket));
+    memset(&sensorData, 0, sizeof(RemoteDataPacket));
+    status_summary_init(&statusCoalescer);
+    frame_batch_init(&muxBatch);
+    lastSummary = xTaskGetTickCount();
+    lastData = lastSummary;
+    lastLog = lastSummary;
+
+    /* Set destination */
+    xServerAddress.sin_addr = FreeRTOS_inet_addr(SERVER_IP_ADDRESS_STR);
+    xServerAddress.sin_port = FreeRTOS_htons(MUX_PORT);
+
+    /* create TCP socket */
+    xClientSocket = FreeRTOS_socket(FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP);
+    if(xClientSocket == FREERTOS_INVALID_SOCKET) {
+        LOG_REMOTE_CLIENT_EVENT(REMOTE_BIST_COMPLETE);
+        LOG_REMOTE_CLIENT_EVENT(REMOTE_INIT_ERROR);
+        ERROR_PRINT("ERROR remoteMuxTask: Failed to create socket\n");
+        vTaskDelay(2000);
+    }
+    else {
+        /* set timeouts; receive only waits as long as the queues can */
+        FreeRTOS_setsockopt(xClientSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof(xTimeOut));
+        FreeRTOS_setsockopt(xClientSocket, 0, FREERTOS_SO_RCVTIMEO, &xPoll, sizeof(xPoll));
+
+        /* Bind the socket */
+        if(FreeRTOS_bind(xClientSocket, &xServerAddress, xSize) != 0) {
+            LOG_REMOTE_CLIENT_EVENT(REMOTE_BIST_COMPLETE);
+            LOG_REMOTE_CLIENT_EVENT(REMOTE_INIT_ERROR);
+            ERROR_PRINT("ERROR remoteMuxTask: Failed to create socket\n");
+            vTaskDelay(2000);
+        }
+        /*--------------------------------------------------------------------------*/
+        /* Socket Created Successfully! */
+        /*--------------------------------------------------------------------------*/
+        else {
+            LOG_REMOTE_CLIENT_EVENT(REMOTE_BIST_COMPLETE);
+            LOG_REMOTE_CLIENT_EVENT(REMOTE_INIT_SUCCESS);
+
+            while(keepAlive)
+            {
+                ++count;
+
+                /*--------------------------------------------------------------------------*/
+                /* Connect Lost State */
+                /*--------------------------------------------------------------------------*/
+                if(g_cmdSocketLost) {
+                    ret = 0;
+                    do {
+                        ret = FreeRTOS_connect(xClientSocket, &xServerAddress, xSize);
+                        INFO_PRINT("remoteMuxTask ");
+                        printConnectionStatus(ret);
+                    } while(ret != 0);
+                    g_cmdSocketLost = (sendHello(&xClientSocket) == pdFREERTOS_ERRNO_ENOTCONN);
+                    frame_reader_init(&cmdReader, (uint8_t *)cmdReaderBuf);
+                }
+                /*--------------------------------------------------------------------------*/
+                /* Connected State */
+                /*--------------------------------------------------------------------------*/
+                else {
+                    urgent = 0;
+
+                    /* cmds; returns as soon as one arrives, after xPoll, or
+                     * right away if there are logs to send and room for them */
+                    recvFlags = ((uxQueueMessagesWaiting(info.logFd) != 0) &&
+                                 (FreeRTOS_tx_space(xClientSocket) >= (BaseType_t)(2 * FRAME_LINK_MSS))) ? FREERTOS_MSG_DONTWAIT : 0;
+                    ret = readSocketData(&xClientSocket, &cmdReader, recvFlags);
+                    if(ret == pdFREERTOS_ERRNO_ENOTCONN) {
+                        g_cmdSocketLost = 1;
+                    }
+                    while(frame_reader_next(&cmdReader, &frameHdr, &pPayload))
+                    {
+                        if((frameHdr.type != FRAME_TYPE_CMD) || (frameHdr.length != sizeof(RemoteCmdPacket)))
+                            continue;
+                        memcpy(&cmdMsg, pPayload, sizeof(RemoteCmdPacket));
+                        processCmd(&info, &cmdMsg);
+                    }
+
+                    /* status; STATUS_OK is merged into the task's summary,
+                     * anything else goes in the next frame */
+                    while(xQueueReceive(info.statusFd, (void *)&statusMsg, 0) != pdFALSE) {
+                        if(status_summary_add(&statusCoalescer, &statusMsg)) {
+                            if(batchSocketData(&xClientSocket, &muxBatch, FRAME_TYPE_STATUS, &statusMsg, sizeof(TaskStatusPacket)) == pdFREERTOS_ERRNO_ENOTCONN) {
+                                g_cmdSocketLost = 1;
+                            }
+                            urgent = 1;
+                        }
+                    }
+                    now = xTaskGetTickCount();
+                    if((now - lastSummary) >= xSummaryPeriod) {
+                        lastSummary = now;
+                        summaryLen = status_summary_flush(&statusCoalescer, &summaryPacket);
+                        if((summaryLen != 0) &&
+                           (batchSocketData(&xClientSocket, &muxBatch, FRAME_TYPE_STATUS_SUMMARY, &summaryPacket, summaryLen) == pdFREERTOS_ERRNO_ENOTCONN)) {
+                            g_cmdSocketLost = 1;
+                        }
+                        urgent = 1;
+                    }
+
+                    /* data, unless remoteTelemetryTask sends it */
+                    if(!REMOTE_TELEMETRY_UDP && ((now - lastData) >= xDataPeriod) &&
+                       (xSemaphoreTake(info.shmemMutex, THREAD_MUTEX_DELAY) == pdTRUE)) {
+                        lastData = now;
+                        if(info.pShmem != NULL) {
+                            sensorData.luxData = info.pShmem->lightData.apds9301_luxData;
+                            sensorData.moistureData = info.pShmem->moistData.moistureLevel;
+                        }
+                        xSemaphoreGive(info.shmemMutex);
+                        if(batchSocketData(&xClientSocket, &muxBatch, FRAME_TYPE_DATA, &sensorData, sizeof(sensorData)) == pdFREERTOS_ERRNO_ENOTCONN) {
+                            g_cmdSocketLost = 1;
+                        }
+                        urgent = 1;
+                    }
+
+                    /* logs, no more than fill the frame */
+                    while((frame_batch_free(&muxBatch) >= FRAME_RECORD_SIZE(sizeof(LogMsgPacket))) &&
+                          (xQueueReceive(info.logFd, (void *)&logMsg, 0) != pdFALSE)) {
+                        /* checked by the Control Node when received */
+                        logMsg.checksum = log_packet_checksum(&logMsg);
+                        frame_batch_add(&muxBatch, FRAME_TYPE_LOG, &logMsg, sizeof(LogMsgPacket));
+                        lastLog = now;
+                    }
+                    if((now - lastLog) >= xDelay) {
+                        LOG_REMOTE_CLIENT_EVENT(REMOTE_LOG_QUEUE_ERROR);
+                        lastLog = now;
+                    }
+
+                    /* send status and data now; logs once the frame is full or
+                     * the first has waited long enough, if the socket has room */
+                    if(muxBatch.records == 0) {
+                        batchStart = now;
+                    }
+                    else if(!g_cmdSocketLost &&
+                            (urgent ||
+                             (((frame_batch_free(&muxBatch) < FRAME_RECORD_SIZE(sizeof(LogMsgPacket))) ||
+                               ((now - batchStart) >= xBatchDeadline)) &&
+                              (FreeRTOS_tx_space(xClientSocket) >= (BaseType_t)(2 * FRAME_LINK_MSS))))) {
+                        if(sendSocketBatch(&xClientSocket, &muxBatch) == pdFREERTOS_ERRNO_ENOTCONN) {
+                            g_cmdSocketLost = 1;
+                        }
+                    }
+                }
+
+                /* one connection; the observer watches all four */
+                g_logSocketLost = g_cmdSocketLost;
+                g_statusSocketLost = g_cmdSocketLost;
+                if(!REMOTE_TELEMETRY_UDP)
+                    g_dataSocketLost = g_cmdSocketLost;
+            }
+        }
+
+        /* gracefully shutdown socket */
+        FreeRTOS_shutdown( xClientSocket, FREERTOS_SHUT_RDWR );
+
+        /* The socket has shut down and is safe to close */
+        FreeRTOS_closesocket( xClientSocket );
+    }
+    LOG_REMOTE_CLIENT_EVENT(REMOTE_EVENT_EXITING);
+    INFO_PRINT("remoteMuxTask Exiting\n");
+    vTaskDelete(NULL);
+}
+
+/*---------------------------------------------------------------------------------*/
+/*
+ * Control Node cmd to the shared memory the other tasks act on
+ */
+static void processCmd(SensorThreadInfo *pInfo, RemoteCmdPacket *pCmd)
+{
+    if((pCmd->cmd ==  REMOTE_WATERPLANT) ||
+            (pCmd->cmd == REMOTE_SETMOISTURE_LOWTHRES) ||
+            (pCmd->cmd == REMOTE_SETMOISTURE_HIGHTHRES))
+    {
+        /* try to read sensor data from shmem */
+        if(xSemaphoreTake(pInfo->shmemMutex, THREAD_MUTEX_DELAY) == pdTRUE)
+        {
+            /* write data to shmem */
+            if(pInfo->pShmem != NULL) {
+                switch (pCmd->cmd)
+                {
+                case REMOTE_WATERPLANT:
+                    pInfo->pShmem->solenoidData.cmd = (pCmd->cmd == REMOTE_WATERPLANT);
+                    break;
+                case REMOTE_SETMOISTURE_LOWTHRES:
+                    pInfo->pShmem->moistData.lowThreshold = pCmd->data;
+                    break;
+                case REMOTE_SETMOISTURE_HIGHTHRES:
+                    pInfo->pShmem->moistData.highThreshold = pCmd->data;
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            /* release mutex ASAP so others can use */
+            xSemaphoreGive(pInfo->shmemMutex);
+        }
+        else {
+            LOG_REMOTE_CLIENT_EVENT(REMOTE_SHMEM_ERROR);
+            ERROR_PRINT("remoteCmdTask, failed to write cmd to shmem\n");
+            while(1){};
+        }
+    }
+
+    /* takes effect from the next datagram */
+    if((pCmd->cmd == REMOTE_SET_TELEMETRY_HZ) && (pCmd->data != 0) && (pCmd->data <= REMOTE_TELEMETRY_MAX_HZ)) {
+        telemetryHz = (uint16_t)pCmd->data;
+    }
+
+    /* for diagnostics */
+    if(DIAGNOISTIC_PRINTS) {
+        INFO_PRINT("Received cmd: %d from Control Node\n", pCmd->cmd);
+    }
+}
+
 /*---------------------------------------------------------------------------------*/
 /*
  *
  */
-BaseType_t sendSocketData(Socket_t *pSocket, uint8_t *pData, size_t length)
+BaseType_t sendSocketData(Socket_t *pSocket, FrameType_e type, void *pData, size_t length)
+{
+    BaseType_t ret;
+    FrameHeader_t hdr;
+    configASSERT(pSocket);
+
+    /* send frame header, then the packet; no copy to put them together */
+    frame_header(&hdr, type, pData, length);
+    ret = FreeRTOS_send(*pSocket, &hdr, sizeof(FrameHeader_t), 0);
+    if(ret == sizeof(FrameHeader_t)) {
+        ret = FreeRTOS_send(*pSocket, pData, length, 0);
+    }
+    return sendResult(ret, length);
+}
+
+/*---------------------------------------------------------------------------------*/
+/*
+ * Add a packet to a batch; if the batch is full it is sent first to make room.
+ * Returns 0 if nothing was sent, else as sendSocketBatch().
+ */
+BaseType_t batchSocketData(Socket_t *pSocket, FrameBatch_t *pBatch, FrameType_e type, void *pData, size_t length)
+{
+    BaseType_t ret = 0;
+
+    if(!frame_batch_add(pBatch, type, pData, length)) {
+        ret = sendSocketBatch(pSocket, pBatch);
+        frame_batch_add(pBatch, type, pData, length);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------------*/
+/*
+ * Send a batch as one frame, one FreeRTOS_send(), and empty it; its packets
+ * are dropped if the connection is lost, as a single packet would be.
+ */
+BaseType_t sendSocketBatch(Socket_t *pSocket, FrameBatch_t *pBatch)
 {
     BaseType_t ret;
+    size_t length;
     configASSERT(pSocket);
 
-    /* send data */
-    ret = FreeRTOS_send(*pSocket, pData, length, 0);
+    length = frame_batch_finish(pBatch);
+    ret = FreeRTOS_send(*pSocket, &pBatch->hdr, length, 0);
+    frame_batch_init(pBatch);
+    return sendResult(ret, length);
+}
 
+/*---------------------------------------------------------------------------------*/
+/*
+ * FreeRTOS_send() result of sending length bytes to what the tasks check
+ */
+static BaseType_t sendResult(BaseType_t ret, size_t length)
+{
     /* if all bytes sent, success! */
     if(ret == length) {
         return ret;
@@ -674,6 +1137,19 @@ BaseType_t sendSocketData(Socket_t *pSocket, uint8_t *pData, size_t length)
     return ret;
 }
 
+/*---------------------------------------------------------------------------------*/
+/*
+ * Control Node expects this first on every connection
+ */
+BaseType_t sendHello(Socket_t *pSocket)
+{
+    RemoteHelloPacket hello;
+
+    hello.header = REMOTE_HELLO_HEADER;
+    hello.nodeId = REMOTE_NODE_ID;
+    return sendSocketData(pSocket, FRAME_TYPE_HELLO, &hello, sizeof(RemoteHelloPacket));
+}
+
 /*---------------------------------------------------------------------------------*/
 /*
  *
@@ -41,6 +41,8 @@
 #include "task.h"
 #include "semphr.h"
 
+LOG_REGISTER_FILE(LOG_FILE_TIVA_SOLENOID_THREAD);
+
 /*---------------------------------------------------------------------------------*/
 #define SOLENOID_STATE_OFF          (0)
 #define SOLENOID_STATE_ON           (1)